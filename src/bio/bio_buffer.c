@@ -26,6 +26,13 @@
 #include <spdk/blob.h>
 #include "bio_internal.h"
 
+/* Preallocated commands of the per-xstream submission queue */
+#define BIO_DMA_CMD_MAX		2048
+/* Completion ring size, must be larger than BIO_DMA_CMD_MAX */
+#define BIO_DMA_CQ_SZ		4096
+/* Maximum pages of a merged command, 1MB */
+#define BIO_DMA_CMD_PG_MAX	256
+
 static void
 dma_free_chunk(struct bio_dma_chunk *chunk)
 {
@@ -159,6 +166,57 @@ dma_buffer_create(unsigned int init_cnt)
 	return buf;
 }
 
+void
+dma_sq_destroy(struct bio_dma_sq *sq)
+{
+	D_ASSERT(sq->bsq_cnt == 0);
+	D_ASSERT(sq->bsq_inflights == 0);
+
+	if (sq->bsq_cq != NULL)
+		spdk_ring_free(sq->bsq_cq);
+	D_FREE(sq->bsq_cmd_arr);
+	D_FREE(sq->bsq_cmds);
+	D_FREE(sq);
+}
+
+struct bio_dma_sq *
+dma_sq_create(unsigned int depth)
+{
+	struct bio_dma_sq *sq;
+	int i;
+
+	D_ALLOC_PTR(sq);
+	if (sq == NULL)
+		return NULL;
+
+	D_INIT_LIST_HEAD(&sq->bsq_free_list);
+	depth = min(max(depth, 1U), BIO_DMA_CMD_MAX);
+	sq->bsq_depth = depth;
+
+	D_ALLOC_ARRAY(sq->bsq_cmds, depth);
+	if (sq->bsq_cmds == NULL)
+		goto failed;
+
+	D_ALLOC_ARRAY(sq->bsq_cmd_arr, BIO_DMA_CMD_MAX);
+	if (sq->bsq_cmd_arr == NULL)
+		goto failed;
+
+	for (i = 0; i < BIO_DMA_CMD_MAX; i++)
+		d_list_add_tail(&sq->bsq_cmd_arr[i].bcm_link,
+				&sq->bsq_free_list);
+
+	/* Each command is completed at most once, the ring never overflows */
+	sq->bsq_cq = spdk_ring_create(SPDK_RING_TYPE_MP_SC, BIO_DMA_CQ_SZ,
+				      SPDK_ENV_SOCKET_ID_ANY);
+	if (sq->bsq_cq == NULL)
+		goto failed;
+
+	return sq;
+failed:
+	dma_sq_destroy(sq);
+	return NULL;
+}
+
 struct bio_sglist *
 bio_iod_sgl(struct bio_desc *biod, unsigned int idx)
 {
@@ -570,8 +628,13 @@ dma_map_one(struct bio_desc *biod, struct bio_iov *biov,
 		cur_pg = off >> BIO_DMA_PAGE_SHIFT;
 		D_ASSERT(prev_pg_start <= prev_pg_end);
 
-		/* Consecutive in page */
-		if (cur_pg == prev_pg_end) {
+		/*
+		 * Consecutive in page. For update, the region must be byte
+		 * contiguous, otherwise the gap in the page would be written
+		 * without being read by the RMW in dma_rw().
+		 */
+		if (cur_pg == prev_pg_end &&
+		    (!biod->bd_update || off == last_rg->brr_end)) {
 			chk_pg_idx += (prev_pg_end - prev_pg_start);
 			biov->bi_buf = chunk_reserve(chk, chk_pg_idx, pg_cnt,
 						     pg_off);
@@ -643,28 +706,212 @@ add_region:
 	return iod_add_region(biod, chk, chk_pg_idx, off, end);
 }
 
+static void
+dma_sq_complete(struct bio_dma_cmd *head)
+{
+	struct bio_dma_sq	*sq = head->bcm_sq;
+	struct bio_dma_cmd	*cmd, *tmp;
+	struct bio_desc		*biod;
+
+	D_ASSERT(sq->bsq_inflights > 0);
+	sq->bsq_inflights--;
+
+	/* Complete the merged commands first, then the head command */
+	d_list_add_tail(&head->bcm_link, &head->bcm_merged);
+	d_list_for_each_entry_safe(cmd, tmp, &head->bcm_merged, bcm_link) {
+		biod = cmd->bcm_biod;
+
+		D_ASSERT(biod->bd_inflights > 0);
+		biod->bd_inflights--;
+		if (biod->bd_result == 0 && head->bcm_err != 0)
+			biod->bd_result = daos_errno2der(-head->bcm_err);
+
+		if (biod->bd_inflights == 0 && biod->bd_dma_issued) {
+			ABT_mutex_lock(biod->bd_mutex);
+			ABT_cond_broadcast(biod->bd_dma_done);
+			ABT_mutex_unlock(biod->bd_mutex);
+		}
+
+		d_list_move_tail(&cmd->bcm_link, &sq->bsq_free_list);
+	}
+}
+
+/*
+ * SPDK blob io completion could run on different xstream when the NVMe
+ * device is shared by multiple xstreams, so it only puts the command on
+ * the completion ring, the owner xstream completes it in dma_sq_poll().
+ */
 static void
 rw_completion(void *cb_arg, int err)
 {
-	struct bio_desc *biod = cb_arg;
+	struct bio_dma_cmd	*head = cb_arg;
+	size_t			 count;
+
+	head->bcm_err = err;
+	count = spdk_ring_enqueue(head->bcm_sq->bsq_cq, (void **)&head, 1);
+	D_ASSERT(count == 1);
+}
+
+/*
+ * Complete the commands on the completion ring.
+ *
+ * \param[IN] ctxt	Per-xstream NVMe context
+ *
+ * \returns		Completed command count
+ */
+size_t
+dma_sq_poll(struct bio_xs_context *ctxt)
+{
+	struct bio_dma_cmd	*cmds[32];
+	size_t			 count, i, total = 0;
+
+	if (ctxt->bxc_dma_sq == NULL)
+		return 0;
+
+	do {
+		count = spdk_ring_dequeue(ctxt->bxc_dma_sq->bsq_cq,
+					  (void **)cmds, ARRAY_SIZE(cmds));
+		for (i = 0; i < count; i++)
+			dma_sq_complete(cmds[i]);
+		total += count;
+	} while (count == ARRAY_SIZE(cmds));
+
+	return total;
+}
+
+static int
+dma_cmd_cmp(const void *a, const void *b)
+{
+	const struct bio_dma_cmd *cmd_a = *(struct bio_dma_cmd **)a;
+	const struct bio_dma_cmd *cmd_b = *(struct bio_dma_cmd **)b;
+
+	if (cmd_a->bcm_blob != cmd_b->bcm_blob)
+		return (uintptr_t)cmd_a->bcm_blob <
+			(uintptr_t)cmd_b->bcm_blob ? -1 : 1;
+	if (cmd_a->bcm_update != cmd_b->bcm_update)
+		return cmd_a->bcm_update < cmd_b->bcm_update ? -1 : 1;
+	if (cmd_a->bcm_pg_idx != cmd_b->bcm_pg_idx)
+		return cmd_a->bcm_pg_idx < cmd_b->bcm_pg_idx ? -1 : 1;
+	return 0;
+}
+
+/* Can @cmd be appended to @head as one blob I/O? */
+static inline bool
+dma_cmd_mergeable(struct bio_dma_cmd *head, struct bio_dma_cmd *cmd)
+{
+	return head->bcm_blob == cmd->bcm_blob &&
+	       head->bcm_update == cmd->bcm_update &&
+	       head->bcm_pg_idx + head->bcm_pg_cnt == cmd->bcm_pg_idx &&
+	       head->bcm_payload + (head->bcm_pg_cnt << BIO_DMA_PAGE_SHIFT) ==
+			cmd->bcm_payload &&
+	       head->bcm_pg_cnt + cmd->bcm_pg_cnt <= BIO_DMA_CMD_PG_MAX;
+}
+
+static void
+dma_cmd_submit(struct bio_xs_context *ctxt, struct bio_dma_cmd *head)
+{
+	struct spdk_io_channel	*channel = ctxt->bxc_io_channel;
+
+	D_DEBUG(DB_IO, "%s blob:%p payload:%p, pg_idx:"DF_U64", "
+		"pg_cnt:"DF_U64"\n", head->bcm_update ? "Write" : "Read",
+		head->bcm_blob, head->bcm_payload, head->bcm_pg_idx,
+		head->bcm_pg_cnt);
+
+	ctxt->bxc_dma_sq->bsq_inflights++;
+	ctxt->bxc_dma_sq->bsq_stat_ios++;
+
+	if (head->bcm_update)
+		spdk_blob_io_write(head->bcm_blob, channel, head->bcm_payload,
+				   head->bcm_pg_idx, head->bcm_pg_cnt,
+				   rw_completion, head);
+	else
+		spdk_blob_io_read(head->bcm_blob, channel, head->bcm_payload,
+				  head->bcm_pg_idx, head->bcm_pg_cnt,
+				  rw_completion, head);
+}
+
+/*
+ * Submit all the queued commands, commands being adjacent both on blob
+ * and in DMA buffer are merged into one blob I/O.
+ *
+ * \param[IN] ctxt	Per-xstream NVMe context
+ */
+void
+dma_sq_flush(struct bio_xs_context *ctxt)
+{
+	struct bio_dma_sq	*sq = ctxt->bxc_dma_sq;
+	struct bio_dma_cmd	*head = NULL, *cmd;
+	unsigned int		 i;
+
+	if (sq == NULL || sq->bsq_cnt == 0)
+		return;
+
+	if (sq->bsq_cnt > 1)
+		qsort(sq->bsq_cmds, sq->bsq_cnt, sizeof(*sq->bsq_cmds),
+		      dma_cmd_cmp);
+
+	for (i = 0; i < sq->bsq_cnt; i++) {
+		cmd = sq->bsq_cmds[i];
+		sq->bsq_cmds[i] = NULL;
+
+		if (head != NULL && dma_cmd_mergeable(head, cmd)) {
+			head->bcm_pg_cnt += cmd->bcm_pg_cnt;
+			d_list_add_tail(&cmd->bcm_link, &head->bcm_merged);
+			continue;
+		}
 
-	ABT_mutex_lock(biod->bd_mutex);
+		if (head != NULL)
+			dma_cmd_submit(ctxt, head);
+		head = cmd;
+	}
+	sq->bsq_cnt = 0;
 
-	D_ASSERT(biod->bd_inflights > 0);
-	biod->bd_inflights--;
-	if (biod->bd_result == 0 && err != 0)
-		biod->bd_result = daos_errno2der(-err);
+	D_ASSERT(head != NULL);
+	dma_cmd_submit(ctxt, head);
+}
 
-	if (biod->bd_inflights == 0 && biod->bd_dma_issued)
-		ABT_cond_broadcast(biod->bd_dma_done);
+/* Queue a blob I/O on the per-xstream submission queue */
+static void
+dma_sq_add(struct bio_desc *biod, void *payload, uint64_t pg_idx,
+	   uint64_t pg_cnt, bool update)
+{
+	struct bio_xs_context	*ctxt = biod->bd_ctxt->bic_xs_ctxt;
+	struct bio_dma_sq	*sq = ctxt->bxc_dma_sq;
+	struct bio_dma_cmd	*cmd;
+
+	/* All commands are inflight, wait for some completed */
+	while (d_list_empty(&sq->bsq_free_list)) {
+		dma_sq_flush(ctxt);
+		if (ctxt->bxc_xs_id == -1)
+			bio_nvme_poll(ctxt);
+		else
+			ABT_thread_yield();
+	}
 
-	ABT_mutex_unlock(biod->bd_mutex);
+	cmd = d_list_entry(sq->bsq_free_list.next, struct bio_dma_cmd,
+			   bcm_link);
+	d_list_del_init(&cmd->bcm_link);
+	D_INIT_LIST_HEAD(&cmd->bcm_merged);
+	cmd->bcm_biod = biod;
+	cmd->bcm_blob = biod->bd_ctxt->bic_blob;
+	cmd->bcm_payload = payload;
+	cmd->bcm_pg_idx = pg_idx;
+	cmd->bcm_pg_cnt = pg_cnt;
+	cmd->bcm_sq = sq;
+	cmd->bcm_err = 0;
+	cmd->bcm_update = update;
+
+	biod->bd_inflights++;
+	sq->bsq_cmds[sq->bsq_cnt++] = cmd;
+	sq->bsq_stat_cmds++;
+
+	if (sq->bsq_cnt == sq->bsq_depth)
+		dma_sq_flush(ctxt);
 }
 
 static void
 dma_rw(struct bio_desc *biod, bool prep)
 {
-	struct spdk_io_channel	*channel;
 	struct spdk_blob	*blob;
 	struct bio_rsrvd_dma	*rsrvd_dma = &biod->bd_rsrvd;
 	struct bio_rsrvd_region	*rg;
@@ -678,8 +925,8 @@ dma_rw(struct bio_desc *biod, bool prep)
 	D_ASSERT(biod->bd_ctxt->bic_xs_ctxt);
 	xs_ctxt = biod->bd_ctxt->bic_xs_ctxt;
 	blob = biod->bd_ctxt->bic_blob;
-	channel = xs_ctxt->bxc_io_channel;
-	D_ASSERT(blob != NULL && channel != NULL);
+	D_ASSERT(blob != NULL && xs_ctxt->bxc_io_channel != NULL);
+	D_ASSERT(xs_ctxt->bxc_dma_sq != NULL);
 
 	D_DEBUG(DB_IO, "DMA start, blob:%p, update:%d, rmw:%d\n",
 		blob, biod->bd_update, rmw_read);
@@ -702,29 +949,19 @@ dma_rw(struct bio_desc *biod, bool prep)
 			D_ASSERT(pg_cnt > pg_idx);
 			pg_cnt -= pg_idx;
 
-			ABT_mutex_lock(biod->bd_mutex);
-			biod->bd_inflights++;
-			ABT_mutex_unlock(biod->bd_mutex);
-
-			D_DEBUG(DB_IO, "%s blob:%p payload:%p, "
-				"pg_idx:"DF_U64", pg_cnt:"DF_U64"\n",
-				biod->bd_update ? "Write" : "Read",
-				blob, payload, pg_idx, pg_cnt);
-
-			if (biod->bd_update)
-				spdk_blob_io_write(blob, channel, payload,
-						   pg_idx, pg_cnt,
-						   rw_completion, biod);
-			else
-				spdk_blob_io_read(blob, channel, payload,
-						  pg_idx, pg_cnt,
-						  rw_completion, biod);
+			dma_sq_add(biod, payload, pg_idx, pg_cnt,
+				   biod->bd_update);
 			continue;
 		}
 
 		/*
-		 * Since DAOS doesn't support partial overwrite yet, we don't
-		 * do RMW for partial update, only zeroing the page instead.
+		 * Extent being updated starts either from block boundary, or
+		 * it's packed behind other small extents in a shared block
+		 * (see vea_reserve_frag()), so the front partial page is read
+		 * from the blob before the data being copied in.
+		 *
+		 * Nothing is stored after the end of an extent in the rear
+		 * partial page, it's zeroed instead of being read.
 		 */
 		pg_off = rg->brr_off & ((uint64_t)BIO_DMA_PAGE_SZ - 1);
 
@@ -733,7 +970,7 @@ dma_rw(struct bio_desc *biod, bool prep)
 				"pg_idx:"DF_U64" pg_off:%d\n",
 				blob, payload, pg_idx, pg_off);
 
-			memset(payload, 0, BIO_DMA_PAGE_SZ);
+			dma_sq_add(biod, payload, pg_idx, 1, false);
 			pg_rmw = payload;
 		}
 
@@ -56,6 +56,46 @@ struct bio_dma_buffer {
 	ABT_mutex		 bdb_mutex;
 };
 
+/* A blob I/O queued on the per-xstream submission queue */
+struct bio_dma_cmd {
+	/* Link to bsq_free_list, or to bcm_merged of the head command */
+	d_list_t		 bcm_link;
+	/* Commands merged into this one, only used by head command */
+	d_list_t		 bcm_merged;
+	struct bio_desc		*bcm_biod;
+	struct spdk_blob	*bcm_blob;
+	void			*bcm_payload;
+	uint64_t		 bcm_pg_idx;
+	uint64_t		 bcm_pg_cnt;
+	struct bio_dma_sq	*bcm_sq;
+	int			 bcm_err;
+	unsigned int		 bcm_update:1;
+};
+
+/*
+ * Per-xstream submission queue. Blob I/Os from all the I/O descriptors of
+ * the xstream are queued and submitted in batch, I/Os being adjacent both
+ * on blob and in DMA buffer are merged into one. Completed I/Os are put on
+ * a lock-free ring and completed to I/O descriptors in bio_nvme_poll().
+ */
+struct bio_dma_sq {
+	/* Commands waiting for submission */
+	struct bio_dma_cmd	**bsq_cmds;
+	unsigned int		  bsq_cnt;
+	/* Flush the queue once it has this many commands */
+	unsigned int		  bsq_depth;
+	/* Preallocated commands */
+	struct bio_dma_cmd	 *bsq_cmd_arr;
+	d_list_t		  bsq_free_list;
+	/* Commands submitted to SPDK and not completed yet */
+	unsigned int		  bsq_inflights;
+	/* Completion ring, SPDK completion callback is the producer */
+	struct spdk_ring	 *bsq_cq;
+	/* Statistics: submitted blob I/Os, and queued commands */
+	uint64_t		  bsq_stat_ios;
+	uint64_t		  bsq_stat_cmds;
+};
+
 /*
  * SPDK blobstore isn't thread safe and there can be only one SPDK
  * blobstore for certain NVMe device.
@@ -76,6 +116,7 @@ struct bio_xs_context {
 	struct spdk_io_channel	*bxc_io_channel;
 	d_list_t		 bxc_pollers;
 	struct bio_dma_buffer	*bxc_dma_buf;
+	struct bio_dma_sq	*bxc_dma_sq;
 	struct spdk_bdev_desc	*bxc_desc; /* for io stat only */
 	uint64_t		 bxc_stat_age;
 };
@@ -124,13 +165,13 @@ struct bio_desc {
 	struct bio_sglist	*bd_sgls;
 	/* DMA buffers reserved by this io descriptor */
 	struct bio_rsrvd_dma	 bd_rsrvd;
-	/*
-	 * SPDK blob io completion could run on different xstream
-	 * when the NVMe device is shared by multiple xstreams.
-	 */
+	/* For waiting on all DMA transfers done */
 	ABT_mutex		 bd_mutex;
 	ABT_cond		 bd_dma_done;
-	/* Inflight SPDK DMA transfers */
+	/*
+	 * Inflight SPDK DMA transfers, only changed on the owner xstream,
+	 * see dma_sq_complete().
+	 */
 	unsigned int		 bd_inflights;
 	int			 bd_result;
 	/* Flags */
@@ -143,11 +184,16 @@ struct bio_desc {
 /* bio_xstream.c */
 extern unsigned int	bio_chk_sz;
 extern unsigned int	bio_chk_cnt_max;
+extern unsigned int	bio_sq_depth;
 void xs_poll_completion(struct bio_xs_context *ctxt, unsigned int *inflights);
 
 /* bio_buffer.c */
 void dma_buffer_destroy(struct bio_dma_buffer *buf);
 struct bio_dma_buffer *dma_buffer_create(unsigned int init_cnt);
+void dma_sq_destroy(struct bio_dma_sq *sq);
+struct bio_dma_sq *dma_sq_create(unsigned int depth);
+void dma_sq_flush(struct bio_xs_context *ctxt);
+size_t dma_sq_poll(struct bio_xs_context *ctxt);
 void bio_memcpy(struct bio_desc *biod, uint16_t media, void *media_addr,
 		void *addr, ssize_t n);
 
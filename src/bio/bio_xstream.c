@@ -46,6 +46,8 @@
 #define DAOS_DMA_CHUNK_MB	32		/* 32MB DMA chunks */
 #define DAOS_DMA_CHUNK_CNT_INIT	2		/* Per-xstream init chunks */
 #define DAOS_DMA_CHUNK_CNT_MAX	32		/* Per-xstream max chunks */
+/* Submission queue parameters */
+#define DAOS_DMA_SQ_DEPTH	32		/* Per-xstream batch size */
 
 enum {
 	BDEV_CLASS_NVME = 0,
@@ -60,6 +62,8 @@ unsigned int bio_chk_sz;
 unsigned int bio_chk_cnt_max;
 /* Per-xstream initial DMA buffer size (in chunk count) */
 static unsigned int bio_chk_cnt_init;
+/* Per-xstream submission queue depth to trigger batch submission */
+unsigned int bio_sq_depth;
 
 struct bio_bdev {
 	d_list_t		 bb_link;
@@ -120,6 +124,11 @@ print_io_stat(struct bio_xs_context *ctxt, uint64_t now)
 			stat.write_latency_ticks);
 	}
 
+	if (ctxt->bxc_dma_sq != NULL)
+		D_PRINT("DMA SQ STAT: xs_id[%d] cmds["DF_U64"], ios["DF_U64"]\n",
+			ctxt->bxc_xs_id, ctxt->bxc_dma_sq->bsq_stat_cmds,
+			ctxt->bxc_dma_sq->bsq_stat_ios);
+
 	ctxt->bxc_stat_age = now;
 }
 
@@ -189,6 +198,9 @@ bio_nvme_init(const char *storage_path, const char *nvme_conf)
 
 	bio_chk_sz = (size_mb << 20) >> BIO_DMA_PAGE_SHIFT;
 
+	env = getenv("BIO_SQ_DEPTH");
+	bio_sq_depth = env ? atoi(env) : DAOS_DMA_SQ_DEPTH;
+
 	env = getenv("IO_STAT_PERIOD");
 	io_stat_period = env ? atoi(env) : 0;
 	io_stat_period *= (NSEC_PER_SEC / NSEC_PER_USEC);
@@ -302,11 +314,12 @@ stop_poller(struct spdk_poller *poller, void *ctxt)
 }
 
 /*
- * Execute the messages on msg ring, call all registered pollers.
+ * Submit the queued blob I/Os, execute the messages on msg ring, call all
+ * registered pollers, then complete the finished blob I/Os.
  *
  * \param[IN] ctxt	Per-xstream NVMe context
  *
- * \returns		Executed message count
+ * \returns		Executed message and completed blob I/O count
  */
 size_t
 bio_nvme_poll(struct bio_xs_context *ctxt)
@@ -320,6 +333,9 @@ bio_nvme_poll(struct bio_xs_context *ctxt)
 	if (ctxt == NULL)
 		return 0;
 
+	/* Submit the blob I/Os queued since last poll in batch */
+	dma_sq_flush(ctxt);
+
 	/* Process one msg on the msg ring */
 	count = spdk_ring_dequeue(ctxt->bxc_msg_ring, (void **)&msg, 1);
 	if (count > 0) {
@@ -338,6 +354,9 @@ bio_nvme_poll(struct bio_xs_context *ctxt)
 			poller->bnp_expire_us = now + poller->bnp_period_us;
 	}
 
+	/* Complete the blob I/Os finished by pollers */
+	count += dma_sq_poll(ctxt);
+
 	print_io_stat(ctxt, now);
 
 	return count;
@@ -816,6 +835,15 @@ bio_xsctxt_free(struct bio_xs_context *ctxt)
 	if (ctxt == NULL)
 		return;
 
+	/* Drain all the blob I/Os before freeing io channel */
+	if (ctxt->bxc_dma_sq != NULL) {
+		while (ctxt->bxc_dma_sq->bsq_inflights != 0 ||
+		       ctxt->bxc_dma_sq->bsq_cnt != 0)
+			bio_nvme_poll(ctxt);
+		dma_sq_destroy(ctxt->bxc_dma_sq);
+		ctxt->bxc_dma_sq = NULL;
+	}
+
 	if (ctxt->bxc_io_channel != NULL) {
 		spdk_bs_free_io_channel(ctxt->bxc_io_channel);
 		ctxt->bxc_io_channel = NULL;
@@ -1020,6 +1048,12 @@ bio_xsctxt_alloc(struct bio_xs_context **pctxt, int xs_id)
 		goto out;
 
 	ctxt->bxc_dma_buf = dma_buffer_create(bio_chk_cnt_init);
+
+	ctxt->bxc_dma_sq = dma_sq_create(bio_sq_depth);
+	if (ctxt->bxc_dma_sq == NULL) {
+		D_ERROR("failed to allocate DMA submission queue\n");
+		rc = -DER_NOMEM;
+	}
 out:
 	ABT_mutex_unlock(nvme_glb.bd_mutex);
 	spdk_conf_free(config);
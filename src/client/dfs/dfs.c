@@ -35,11 +35,15 @@
 #include <daos/common.h>
 #include <daos/debug.h>
 #include <daos/container.h>
+#include <daos/event.h>
+#include <daos/tse.h>
 
 #include "daos_types.h"
 #include "daos_api.h"
 #include "daos_addons.h"
+#include "daos_task.h"
 #include "daos_fs.h"
+#include "dfs_internal.h"
 
 /** D-key name of SB info in the SB object */
 #define SB_DKEY		"DFS_SB_DKEY"
@@ -72,6 +76,9 @@
 #define ENUM_DESC_NR    10
 #define ENUM_DESC_BUF   (ENUM_DESC_NR * DFS_MAX_PATH)
 
+/** Max number of entries in flight in the batched directory calls */
+#define DFS_BATCH_INFLIGHT	32
+
 /** OIDs for Superblock and Root objects */
 #define RESERVED_LO	0
 #define SB_HI		0
@@ -82,48 +89,6 @@ enum {
 	DFS_READ
 };
 
-/** object struct that is instantiated for a DFS open object */
-struct dfs_obj {
-	/** DAOS object ID */
-	daos_obj_id_t		oid;
-	/** DAOS object open handle */
-	daos_handle_t		oh;
-	/** mode_t containing permissions & type */
-	mode_t			mode;
-	/** DAOS object ID of the parent of the object */
-	daos_obj_id_t		parent_oid;
-	/** entry name of the object in the parent */
-	char			name[DFS_MAX_PATH];
-	/** Symlink value if object is a symbolic link */
-	char			*value;
-};
-
-/** dfs struct that is instantiated for a mounted DFS namespace */
-struct dfs {
-	/** flag to indicate whether the dfs is mounted */
-	bool			mounted;
-	/** lock for threadsafety */
-	pthread_mutex_t		lock;
-	/** uid - inherited from pool. TODO - make this from container. */
-	uid_t			uid;
-	/** gid - inherited from pool. TODO - make this from container. */
-	gid_t			gid;
-	/** Access mode (RDONLY, RDWR) */
-	int			amode;
-	/** Open pool handle of the DFS */
-	daos_handle_t		poh;
-	/** Open container handle of the DFS */
-	daos_handle_t		coh;
-	/** Object ID reserved for this DFS (see oid_gen below) */
-	daos_obj_id_t		oid;
-	/** OID of SB */
-	daos_obj_id_t		super_oid;
-	/** Open object handle of SB */
-	daos_handle_t		super_oh;
-	/** Root object info */
-	dfs_obj_t		root;
-};
-
 struct dfs_entry {
 	/** mode (permissions + entry type) */
 	mode_t		mode;
@@ -259,28 +224,18 @@ oid_gen(dfs_t *dfs, uint16_t oclass, bool file, daos_obj_id_t *oid)
 	return rc;
 }
 
-static int
-fetch_entry(daos_handle_t oh, daos_handle_t th, const char *name,
-	    bool fetch_sym, bool *exists, struct dfs_entry *entry)
+/**
+ * Set up the iods and sgls to fetch the inode akeys of entry @name into
+ * @entry, and @value for the symlink value. Returns the number of akeys.
+ */
+static unsigned int
+fetch_entry_prep(const char *name, bool fetch_sym, struct dfs_entry *entry,
+		 char *value, daos_key_t *dkey, daos_iod_t *iods,
+		 daos_sg_list_t *sgls, daos_iov_t *sg_iovs)
 {
-	daos_sg_list_t	sgls[INODE_AKEYS];
-	daos_iov_t	sg_iovs[INODE_AKEYS];
-	daos_iod_t	iods[INODE_AKEYS];
-	char		value[DFS_MAX_PATH];
-	daos_key_t	dkey;
 	unsigned int	akeys_nr, i;
-	int		rc;
-
-	if (name == NULL)
-		return -DER_INVAL;
-
-	D_DEBUG(DB_TRACE, "fetch entry %s\n", name);
-
-	/** TODO - not supported yet */
-	if (strcmp(name, ".") == 0)
-		D_ASSERT(0);
 
-	daos_iov_set(&dkey, (void *)name, strlen(name));
+	daos_iov_set(dkey, (void *)name, strlen(name));
 	i = 0;
 
 	/** Set Akey for MODE */
@@ -331,12 +286,14 @@ fetch_entry(daos_handle_t oh, daos_handle_t th, const char *name,
 		iods[i].iod_type	= DAOS_IOD_SINGLE;
 	}
 
-	rc = daos_obj_fetch(oh, th, &dkey, akeys_nr, iods, sgls, NULL, NULL);
-	if (rc) {
-		D_ERROR("Failed to fetch entry %s (%d)\n", name, rc);
-		return rc;
-	}
+	return akeys_nr;
+}
 
+/** Finish an entry fetch set up by fetch_entry_prep() */
+static int
+fetch_entry_done(const char *name, bool fetch_sym, daos_iod_t *iods,
+		 char *value, bool *exists, struct dfs_entry *entry)
+{
 	if (fetch_sym && S_ISLNK(entry->mode)) {
 		size_t sym_len = iods[INODE_AKEYS-1].iod_size;
 
@@ -353,7 +310,40 @@ fetch_entry(daos_handle_t oh, daos_handle_t th, const char *name,
 	} else
 		*exists = true;
 
-	return rc;
+	return 0;
+}
+
+static int
+fetch_entry(daos_handle_t oh, daos_handle_t th, const char *name,
+	    bool fetch_sym, bool *exists, struct dfs_entry *entry)
+{
+	daos_sg_list_t	sgls[INODE_AKEYS];
+	daos_iov_t	sg_iovs[INODE_AKEYS];
+	daos_iod_t	iods[INODE_AKEYS];
+	char		value[DFS_MAX_PATH];
+	daos_key_t	dkey;
+	unsigned int	akeys_nr;
+	int		rc;
+
+	if (name == NULL)
+		return -DER_INVAL;
+
+	D_DEBUG(DB_TRACE, "fetch entry %s\n", name);
+
+	/** TODO - not supported yet */
+	if (strcmp(name, ".") == 0)
+		D_ASSERT(0);
+
+	akeys_nr = fetch_entry_prep(name, fetch_sym, entry, value, &dkey,
+				    iods, sgls, sg_iovs);
+
+	rc = daos_obj_fetch(oh, th, &dkey, akeys_nr, iods, sgls, NULL, NULL);
+	if (rc) {
+		D_ERROR("Failed to fetch entry %s (%d)\n", name, rc);
+		return rc;
+	}
+
+	return fetch_entry_done(name, fetch_sym, iods, value, exists, entry);
 }
 
 static int
@@ -503,33 +493,46 @@ get_nlinks(daos_handle_t oh, daos_handle_t th, uint32_t *nlinks,
 	return rc;
 }
 
+/** Fill the stat buffer from an entry, its size and its link count */
+static void
+fill_stat(dfs_t *dfs, struct dfs_entry *entry, daos_size_t size,
+	  uint32_t nlinks, struct stat *stbuf)
+{
+	memset(stbuf, 0, sizeof(struct stat));
+
+	/*
+	 * TODO - this is not accurate since it does not account for
+	 * sparse files or file metadata or xattributes.
+	 */
+	if (S_ISREG(entry->mode))
+		stbuf->st_blocks = (size + (1 << 9) - 1) >> 9;
+
+	stbuf->st_nlink = (nlink_t)nlinks;
+	stbuf->st_size = size;
+	stbuf->st_mode = entry->mode;
+	stbuf->st_uid = dfs->uid;
+	stbuf->st_gid = dfs->gid;
+	stbuf->st_atim.tv_sec = entry->atime;
+	stbuf->st_mtim.tv_sec = entry->mtime;
+	stbuf->st_ctim.tv_sec = entry->ctime;
+}
+
+/** Fill the stat buffer from an entry already fetched from its parent */
 static int
-entry_stat(dfs_t *dfs, daos_handle_t th, daos_handle_t oh, const char *name,
+entry2stat(dfs_t *dfs, daos_handle_t th, struct dfs_entry *entry,
 	   struct stat *stbuf)
 {
-	struct dfs_entry	entry = {0};
-	bool			exists;
 	daos_size_t		size;
 	uint32_t		nlinks;
-	int			rc;
-
-	memset(stbuf, 0, sizeof(struct stat));
-
-	/* Check if parent has the entry */
-	rc = fetch_entry(oh, th, name, true, &exists, &entry);
-	if (rc)
-		return rc;
-
-	if (!exists)
-		return -DER_NONEXIST;
+	int			rc = 0;
 
-	switch (entry.mode & S_IFMT) {
+	switch (entry->mode & S_IFMT) {
 	case S_IFDIR:
 	{
 		daos_handle_t	dir_oh;
 
-		size = sizeof(entry);
-		rc = daos_obj_open(dfs->coh, entry.oid, DAOS_OO_RO,
+		size = sizeof(*entry);
+		rc = daos_obj_open(dfs->coh, entry->oid, DAOS_OO_RO,
 				   &dir_oh, NULL);
 		if (rc)
 			return rc;
@@ -554,7 +557,7 @@ entry_stat(dfs_t *dfs, daos_handle_t th, daos_handle_t oh, const char *name,
 		daos_handle_t	file_oh;
 		daos_size_t	elem_size, dkey_size;
 
-		rc = daos_array_open(dfs->coh, entry.oid, th, DAOS_OO_RO,
+		rc = daos_array_open(dfs->coh, entry->oid, th, DAOS_OO_RO,
 				     &elem_size, &dkey_size, &file_oh, NULL);
 		if (rc) {
 			D_ERROR("daos_array_open() failed (%d)\n", rc);
@@ -578,18 +581,10 @@ entry_stat(dfs_t *dfs, daos_handle_t th, daos_handle_t oh, const char *name,
 			return rc;
 
 		nlinks = 1;
-
-		/*
-		 * TODO - this is not accurate since it does not account for
-		 * sparse files or file metadata or xattributes.
-		 */
-		stbuf->st_blocks = (size + (1 << 9) - 1) >> 9;
 		break;
 	}
 	case S_IFLNK:
-		size = strlen(entry.value);
-		free(entry.value);
-		entry.value = NULL;
+		size = entry->value ? strlen(entry->value) : 0;
 		nlinks = 1;
 		break;
 	default:
@@ -597,15 +592,29 @@ entry_stat(dfs_t *dfs, daos_handle_t th, daos_handle_t oh, const char *name,
 		return -DER_INVAL;
 	}
 
-	stbuf->st_nlink = (nlink_t)nlinks;
-	stbuf->st_size = size;
-	stbuf->st_mode = entry.mode;
-	stbuf->st_uid = dfs->uid;
-	stbuf->st_gid = dfs->gid;
-	stbuf->st_atim.tv_sec = entry.atime;
-	stbuf->st_mtim.tv_sec = entry.mtime;
-	stbuf->st_ctim.tv_sec = entry.ctime;
+	fill_stat(dfs, entry, size, nlinks, stbuf);
+	return rc;
+}
+
+static int
+entry_stat(dfs_t *dfs, daos_handle_t th, daos_handle_t oh, const char *name,
+	   struct stat *stbuf)
+{
+	struct dfs_entry	entry = {0};
+	bool			exists;
+	int			rc;
+
+	/* Check if parent has the entry */
+	rc = fetch_entry(oh, th, name, true, &exists, &entry);
+	if (rc)
+		return rc;
+
+	if (!exists)
+		return -DER_NONEXIST;
 
+	rc = entry2stat(dfs, th, &entry, stbuf);
+	if (entry.value)
+		free(entry.value);
 	return rc;
 }
 
@@ -696,6 +705,7 @@ open_file(dfs_t *dfs, daos_handle_t th, dfs_obj_t *parent, int flags,
 			D_ERROR("daos_array_create() failed (%d)\n", rc);
 			return rc;
 		}
+		file->chunk_size = STRIPE_SIZE;
 
 		/** Create and insert entry in parent dir object. */
 		entry.mode = file->mode;
@@ -753,6 +763,7 @@ open_file:
 		return -DER_INVAL;
 	}
 	oid_cp(&file->oid, entry.oid);
+	file->chunk_size = dkey_size;
 
 	return rc;
 }
@@ -1148,6 +1159,12 @@ dfs_umount(dfs_t *dfs)
 	if (dfs == NULL || !dfs->mounted)
 		return -DER_INVAL;
 
+	if (dfs->cache) {
+		rc = dfs_cache_destroy(dfs);
+		if (rc)
+			return rc;
+	}
+
 	if (dfs->amode == O_RDWR) {
 		rc = daos_cont_sync(dfs->coh, NULL);
 		if (rc) {
@@ -1164,6 +1181,21 @@ dfs_umount(dfs_t *dfs)
 	return 0;
 }
 
+int
+dfs_set_cache(dfs_t *dfs, daos_size_t size)
+{
+	if (dfs == NULL || !dfs->mounted)
+		return -DER_INVAL;
+
+	if (dfs->cache == NULL)
+		return size == 0 ? 0 : dfs_cache_create(dfs, size);
+
+	if (size == 0)
+		return dfs_cache_destroy(dfs);
+
+	return dfs_cache_resize(dfs, size);
+}
+
 int
 dfs_get_file_oh(dfs_obj_t *obj, daos_handle_t *oh)
 {
@@ -1221,123 +1253,495 @@ out:
 	return rc;
 }
 
-static int
-remove_dir_contents(dfs_t *dfs, daos_handle_t th, struct dfs_entry entry)
-{
-	daos_handle_t	oh;
-	daos_key_desc_t	kds[ENUM_DESC_NR];
-	daos_anchor_t	anchor = {0};
-	daos_iov_t	iov;
-	char		enum_buf[ENUM_DESC_BUF] = {0};
-	daos_sg_list_t	sgl;
-	int		rc;
+/*
+ * Batched directory operations. dfs_readdirplus() and dfs_remove_tree() keep
+ * up to DFS_BATCH_INFLIGHT entries in flight, each one going through its own
+ * steps (fetch the entry, then open and size it, or punch it) on its own
+ * event, instead of walking the entries one round trip at a time.
+ */
+enum {
+	BATCH_IDLE,
+	BATCH_FETCH,
+	BATCH_OPEN,
+	BATCH_SIZE,
+	BATCH_PUNCH_OBJ,
+	BATCH_PUNCH_DKEY,
+};
 
-	D_ASSERT(S_ISDIR(entry.mode));
+struct dfs_batch_op {
+	/** event of the step in flight */
+	daos_event_t		bo_ev;
+	/** step in flight, BATCH_IDLE if none */
+	int			bo_state;
+	/** index of the entry in the output arrays */
+	uint32_t		bo_idx;
+	/** entry name, it's the dkey in the parent */
+	char			bo_name[DFS_MAX_PATH];
+	daos_key_t		bo_dkey;
+	struct dfs_entry	bo_entry;
+	daos_iod_t		bo_iods[INODE_AKEYS];
+	daos_sg_list_t		bo_sgls[INODE_AKEYS];
+	daos_iov_t		bo_iovs[INODE_AKEYS];
+	char			bo_value[DFS_MAX_PATH];
+	/** open handle of the entry object */
+	daos_handle_t		bo_oh;
+	daos_size_t		bo_elem_size;
+	daos_size_t		bo_chunk_size;
+	daos_size_t		bo_size;
+};
 
-	rc = daos_obj_open(dfs->coh, entry.oid, DAOS_OO_RW, &oh, NULL);
-	if (rc)
-		return rc;
+struct dfs_batch {
+	dfs_t			*bt_dfs;
+	daos_handle_t		 bt_th;
+	/** parent directory of the entries */
+	dfs_obj_t		*bt_parent;
+	daos_handle_t		 bt_oh;
+	/** remove the entries instead of looking them up */
+	bool			 bt_remove;
+	/** output arrays of dfs_readdirplus() */
+	struct dirent		*bt_dirs;
+	dfs_obj_t		**bt_objs;
+	struct stat		*bt_stbufs;
+	struct dfs_batch_op	*bt_ops;
+	uint32_t		 bt_next;
+	/** first error of the batch */
+	int			 bt_rc;
+};
 
-	sgl.sg_nr = 1;
-	sgl.sg_nr_out = 0;
-	daos_iov_set(&iov, enum_buf, ENUM_DESC_BUF);
-	sgl.sg_iovs = &iov;
+static int remove_tree(dfs_t *dfs, daos_handle_t th, daos_obj_id_t oid);
 
-	while (!daos_anchor_is_eof(&anchor)) {
-		uint32_t	number = ENUM_DESC_NR;
-		uint32_t	i;
-		char		*ptr;
+static int
+batch_init(struct dfs_batch *bt, dfs_t *dfs, daos_handle_t th,
+	   dfs_obj_t *parent, daos_handle_t oh, bool remove)
+{
+	int	rc;
+	int	i;
+
+	memset(bt, 0, sizeof(*bt));
+	bt->bt_dfs = dfs;
+	bt->bt_th = th;
+	bt->bt_parent = parent;
+	bt->bt_oh = oh;
+	bt->bt_remove = remove;
+
+	D_ALLOC_ARRAY(bt->bt_ops, DFS_BATCH_INFLIGHT);
+	if (bt->bt_ops == NULL)
+		return -DER_NOMEM;
 
-		rc = daos_obj_list_dkey(oh, th, &number, kds, &sgl, &anchor,
-					NULL);
-		if (rc)
-			D_GOTO(out, rc);
+	for (i = 0; i < DFS_BATCH_INFLIGHT; i++) {
+		rc = daos_event_init(&bt->bt_ops[i].bo_ev, DAOS_HDL_INVAL,
+				     NULL);
+		if (rc) {
+			D_ERROR("daos_event_init() failed (%d)\n", rc);
+			while (--i >= 0)
+				daos_event_fini(&bt->bt_ops[i].bo_ev);
+			D_FREE(bt->bt_ops);
+			return rc;
+		}
+	}
 
-		if (number == 0)
-			continue;
+	return 0;
+}
 
-		for (ptr = enum_buf, i = 0; i < number; i++) {
-			struct dfs_entry child_entry;
-			char entry_name[DFS_MAX_PATH];
-			bool exists;
+static void
+batch_fini(struct dfs_batch *bt)
+{
+	int	i;
 
-			snprintf(entry_name, kds[i].kd_key_len + 1, "%s", ptr);
-			D_DEBUG(DB_TRACE, "Removing Entry %s\n", entry_name);
-			ptr += kds[i].kd_key_len;
+	for (i = 0; i < DFS_BATCH_INFLIGHT; i++) {
+		D_ASSERT(bt->bt_ops[i].bo_state == BATCH_IDLE);
+		daos_event_fini(&bt->bt_ops[i].bo_ev);
+	}
+	D_FREE(bt->bt_ops);
+}
 
-			rc = fetch_entry(oh, th, entry_name, false,
-					 &exists, &child_entry);
-			if (rc)
-				D_GOTO(out, rc);
+/** Drop whatever the entry of @op still holds and record @rc */
+static void
+batch_op_done(struct dfs_batch *bt, struct dfs_batch_op *op, int rc)
+{
+	if (!daos_handle_is_inval(op->bo_oh)) {
+		if (S_ISREG(op->bo_entry.mode))
+			daos_array_close(op->bo_oh, NULL);
+		else
+			daos_obj_close(op->bo_oh, NULL);
+		op->bo_oh = DAOS_HDL_INVAL;
+	}
+	if (op->bo_entry.value) {
+		free(op->bo_entry.value);
+		op->bo_entry.value = NULL;
+	}
+	if (rc && bt->bt_rc == 0) {
+		D_ERROR("Failed on entry %s (%d)\n", op->bo_name, rc);
+		bt->bt_rc = rc;
+	}
+	op->bo_state = BATCH_IDLE;
+}
 
-			D_ASSERT(exists);
+/** Return the entry of a dfs_readdirplus() batch to the caller */
+static int
+plus_op_output(struct dfs_batch *bt, struct dfs_batch_op *op)
+{
+	struct dfs_entry	*entry = &op->bo_entry;
+	dfs_obj_t		*obj;
+	daos_size_t		 size = 0;
+
+	if (bt->bt_stbufs) {
+		if (S_ISDIR(entry->mode))
+			size = sizeof(*entry);
+		else if (S_ISREG(entry->mode))
+			size = op->bo_size;
+		else if (entry->value)
+			size = strlen(entry->value);
+		fill_stat(bt->bt_dfs, entry, size, 1,
+			  &bt->bt_stbufs[op->bo_idx]);
+	}
+
+	if (bt->bt_objs == NULL)
+		return 0;
 
-			if (S_ISDIR(child_entry.mode)) {
-				rc = remove_dir_contents(dfs, th, child_entry);
-				if (rc)
-					D_GOTO(out, rc);
-			}
+	D_ALLOC_PTR(obj);
+	if (obj == NULL)
+		return -DER_NOMEM;
 
-			rc = remove_entry(dfs, th, oh, entry_name, child_entry);
-			if (rc)
-				D_GOTO(out, rc);
-		}
+	strcpy(obj->name, op->bo_name);
+	obj->mode = entry->mode;
+	oid_cp(&obj->oid, entry->oid);
+	oid_cp(&obj->parent_oid, bt->bt_parent->oid);
+	if (S_ISLNK(entry->mode)) {
+		obj->value = entry->value;
+		entry->value = NULL;
+	} else {
+		obj->oh = op->bo_oh;
+		op->bo_oh = DAOS_HDL_INVAL;
+	}
+	if (S_ISREG(entry->mode)) {
+		obj->chunk_size = op->bo_chunk_size;
+		dfs_cache_obj_init(bt->bt_dfs, obj);
 	}
 
-out:
-	daos_obj_close(oh, NULL);
-	return rc;
+	bt->bt_objs[op->bo_idx] = obj;
+	return 0;
 }
 
-int
-dfs_remove(dfs_t *dfs, dfs_obj_t *parent, const char *name, bool force)
+/*
+ * Complete the step of a dfs_readdirplus() entry with result @rc, and launch
+ * the next one. Returns non-zero if the next step failed to launch.
+ */
+static int
+plus_op_next(struct dfs_batch *bt, struct dfs_batch_op *op, int rc)
 {
-	struct dfs_entry	entry = {0};
-	daos_handle_t           th = DAOS_TX_NONE;
-	bool			exists;
-	int			rc;
-
-	if (dfs == NULL || !dfs->mounted)
-		return -DER_INVAL;
-	if (dfs->amode != O_RDWR)
-		return -DER_NO_PERM;
-	if (name == NULL)
-		return -DER_INVAL;
-	if (parent == NULL)
-		parent = &dfs->root;
-	else if (!S_ISDIR(parent->mode))
-		return -DER_NOTDIR;
-
-	D_DEBUG(DB_TRACE, "Remove entry %s from %s\n", name, parent->name);
+	dfs_t		*dfs = bt->bt_dfs;
+	bool		 exists;
+	int		 daos_mode;
 
-	rc = check_access(dfs, geteuid(), getegid(), parent->mode, W_OK | X_OK);
-	if (rc) {
-		D_ERROR("Permission Denied.\n");
-		return rc;
-	}
-
-	rc = fetch_entry(parent->oh, th, name, false, &exists, &entry);
 	if (rc)
-		D_GOTO(out, rc);
+		goto out;
 
-	if (!exists)
-		D_GOTO(out, rc = -DER_NONEXIST);
+	daos_mode = get_daos_obj_mode(dfs->amode);
 
-	if (S_ISDIR(entry.mode)) {
-		uint32_t nlinks = 0;
-		daos_handle_t oh;
+	switch (op->bo_state) {
+	case BATCH_FETCH:
+		rc = fetch_entry_done(op->bo_name, true, op->bo_iods,
+				      op->bo_value, &exists, &op->bo_entry);
+		if (rc)
+			goto out;
 
-		/** check if dir is empty */
-		rc = daos_obj_open(dfs->coh, entry.oid, DAOS_OO_RW, &oh, NULL);
-		if (rc) {
-			D_ERROR("daos_obj_open() Failed (%d)\n", rc);
-			D_GOTO(out, rc);
+		if (!exists) {
+			/** removed since enumerated, drop it from the output */
+			bt->bt_dirs[op->bo_idx].d_name[0] = '\0';
+			goto out;
 		}
 
-		rc = get_nlinks(oh, th, &nlinks, true);
-		if (rc) {
-			daos_obj_close(oh, NULL);
-			D_GOTO(out, rc);
+		if (S_ISREG(op->bo_entry.mode)) {
+			if (bt->bt_objs == NULL && bt->bt_stbufs == NULL)
+				goto out;
+			op->bo_state = BATCH_OPEN;
+			return daos_array_open(dfs->coh, op->bo_entry.oid,
+					       bt->bt_th, daos_mode,
+					       &op->bo_elem_size,
+					       &op->bo_chunk_size, &op->bo_oh,
+					       &op->bo_ev);
+		}
+
+		if (S_ISDIR(op->bo_entry.mode)) {
+			if (bt->bt_objs)
+				rc = daos_obj_open(dfs->coh, op->bo_entry.oid,
+						   daos_mode, &op->bo_oh,
+						   NULL);
+		} else if (!S_ISLNK(op->bo_entry.mode)) {
+			D_ERROR("Invalid entry type (not a dir, file, "
+				"symlink).\n");
+			rc = -DER_INVAL;
+		}
+		break;
+	case BATCH_OPEN:
+		if (op->bo_elem_size != 1) {
+			D_ERROR("Invalid Byte array elem size (%zu)\n",
+				op->bo_elem_size);
+			rc = -DER_INVAL;
+			break;
+		}
+		if (bt->bt_stbufs == NULL)
+			break;
+		op->bo_state = BATCH_SIZE;
+		return daos_array_get_size(op->bo_oh, bt->bt_th, &op->bo_size,
+					   &op->bo_ev);
+	case BATCH_SIZE:
+		break;
+	default:
+		D_ASSERTF(0, "invalid state %d\n", op->bo_state);
+	}
+
+	if (rc == 0)
+		rc = plus_op_output(bt, op);
+out:
+	batch_op_done(bt, op, rc);
+	return 0;
+}
+
+/*
+ * Complete the step of a dfs_remove_tree() entry with result @rc, and launch
+ * the next one. Returns non-zero if the next step failed to launch.
+ */
+static int
+remove_op_next(struct dfs_batch *bt, struct dfs_batch_op *op, int rc)
+{
+	dfs_t		*dfs = bt->bt_dfs;
+	bool		 exists;
+
+	switch (op->bo_state) {
+	case BATCH_FETCH:
+		if (rc == 0)
+			rc = fetch_entry_done(op->bo_name, false, op->bo_iods,
+					      op->bo_value, &exists,
+					      &op->bo_entry);
+		if (rc || !exists)
+			break;
+
+		D_DEBUG(DB_TRACE, "Removing Entry %s\n", op->bo_name);
+
+		/** the other entries in flight progress meanwhile */
+		if (S_ISDIR(op->bo_entry.mode)) {
+			rc = remove_tree(dfs, bt->bt_th, op->bo_entry.oid);
+			if (rc)
+				break;
+		}
+
+		if (S_ISLNK(op->bo_entry.mode)) {
+			op->bo_state = BATCH_PUNCH_DKEY;
+			return daos_obj_punch_dkeys(bt->bt_oh, bt->bt_th, 1,
+						    &op->bo_dkey, &op->bo_ev);
+		}
+
+		rc = daos_obj_open(dfs->coh, op->bo_entry.oid, DAOS_OO_RW,
+				   &op->bo_oh, NULL);
+		if (rc)
+			break;
+
+		op->bo_state = BATCH_PUNCH_OBJ;
+		return daos_obj_punch(op->bo_oh, bt->bt_th, &op->bo_ev);
+	case BATCH_PUNCH_OBJ:
+		daos_obj_close(op->bo_oh, NULL);
+		op->bo_oh = DAOS_HDL_INVAL;
+		if (rc)
+			break;
+
+		/** drop the entry only once its object is gone */
+		op->bo_state = BATCH_PUNCH_DKEY;
+		return daos_obj_punch_dkeys(bt->bt_oh, bt->bt_th, 1,
+					    &op->bo_dkey, &op->bo_ev);
+	case BATCH_PUNCH_DKEY:
+		break;
+	default:
+		D_ASSERTF(0, "invalid state %d\n", op->bo_state);
+	}
+
+	batch_op_done(bt, op, rc);
+	return 0;
+}
+
+/** Complete the step of @op with result @rc, until one is in flight */
+static void
+batch_op_next(struct dfs_batch *bt, struct dfs_batch_op *op, int rc)
+{
+	do {
+		if (bt->bt_remove)
+			rc = remove_op_next(bt, op, rc);
+		else
+			rc = plus_op_next(bt, op, rc);
+	} while (rc != 0);
+}
+
+/** Wait for the entry of @op to go through all of its steps */
+static void
+batch_op_wait(struct dfs_batch *bt, struct dfs_batch_op *op)
+{
+	bool	done;
+	int	rc;
+
+	while (op->bo_state != BATCH_IDLE) {
+		rc = daos_event_test(&op->bo_ev, DAOS_EQ_WAIT, &done);
+		if (rc) {
+			/** the event is still in flight, can't give up on it */
+			D_ERROR("daos_event_test() failed (%d)\n", rc);
+			continue;
+		}
+		D_ASSERT(done);
+		batch_op_next(bt, op, op->bo_ev.ev_error);
+	}
+}
+
+/** Start fetching entry @name, waiting for a free slot first */
+static void
+batch_add(struct dfs_batch *bt, const char *name, size_t len, uint32_t idx)
+{
+	struct dfs_batch_op	*op;
+	unsigned int		 akeys_nr;
+	int			 rc;
+
+	op = &bt->bt_ops[bt->bt_next++ % DFS_BATCH_INFLIGHT];
+	batch_op_wait(bt, op);
+
+	snprintf(op->bo_name, sizeof(op->bo_name), "%.*s", (int)len, name);
+	memset(&op->bo_entry, 0, sizeof(op->bo_entry));
+	op->bo_idx = idx;
+	op->bo_oh = DAOS_HDL_INVAL;
+	op->bo_size = 0;
+	akeys_nr = fetch_entry_prep(op->bo_name, !bt->bt_remove,
+				    &op->bo_entry, op->bo_value, &op->bo_dkey,
+				    op->bo_iods, op->bo_sgls, op->bo_iovs);
+
+	op->bo_state = BATCH_FETCH;
+	rc = daos_obj_fetch(bt->bt_oh, bt->bt_th, &op->bo_dkey, akeys_nr,
+			    op->bo_iods, op->bo_sgls, NULL, &op->bo_ev);
+	if (rc)
+		batch_op_next(bt, op, rc);
+}
+
+/** Wait for all the entries in flight, returns the first error */
+static int
+batch_drain(struct dfs_batch *bt)
+{
+	int	i;
+
+	for (i = 0; i < DFS_BATCH_INFLIGHT; i++)
+		batch_op_wait(bt, &bt->bt_ops[i]);
+
+	return bt->bt_rc;
+}
+
+/** Remove all the entries of directory @oid in parallel, recursively */
+static int
+remove_tree(dfs_t *dfs, daos_handle_t th, daos_obj_id_t oid)
+{
+	struct dfs_batch	bt;
+	daos_handle_t		oh;
+	daos_key_desc_t		*kds;
+	daos_anchor_t		anchor = {0};
+	daos_iov_t		iov;
+	char			*enum_buf;
+	daos_sg_list_t		sgl;
+	int			rc;
+
+	rc = daos_obj_open(dfs->coh, oid, DAOS_OO_RW, &oh, NULL);
+	if (rc)
+		return rc;
+
+	D_ALLOC_ARRAY(kds, DFS_BATCH_INFLIGHT);
+	if (kds == NULL)
+		D_GOTO(out_obj, rc = -DER_NOMEM);
+
+	D_ALLOC_ARRAY(enum_buf, DFS_BATCH_INFLIGHT * DFS_MAX_PATH);
+	if (enum_buf == NULL)
+		D_GOTO(out_kds, rc = -DER_NOMEM);
+
+	rc = batch_init(&bt, dfs, th, NULL, oh, true);
+	if (rc)
+		D_GOTO(out_buf, rc);
+
+	sgl.sg_nr = 1;
+	sgl.sg_nr_out = 0;
+	daos_iov_set(&iov, enum_buf, DFS_BATCH_INFLIGHT * DFS_MAX_PATH);
+	sgl.sg_iovs = &iov;
+
+	/** the next batch is listed while the previous one is removed */
+	while (!daos_anchor_is_eof(&anchor) && bt.bt_rc == 0) {
+		uint32_t	number = DFS_BATCH_INFLIGHT;
+		uint32_t	i;
+		char		*ptr;
+
+		rc = daos_obj_list_dkey(oh, th, &number, kds, &sgl, &anchor,
+					NULL);
+		if (rc)
+			break;
+
+		for (ptr = enum_buf, i = 0; i < number; i++) {
+			batch_add(&bt, ptr, kds[i].kd_key_len, i);
+			ptr += kds[i].kd_key_len;
+		}
+	}
+
+	if (batch_drain(&bt) != 0 && rc == 0)
+		rc = bt.bt_rc;
+	batch_fini(&bt);
+out_buf:
+	D_FREE(enum_buf);
+out_kds:
+	D_FREE(kds);
+out_obj:
+	daos_obj_close(oh, NULL);
+	return rc;
+}
+
+int
+dfs_remove(dfs_t *dfs, dfs_obj_t *parent, const char *name, bool force)
+{
+	struct dfs_entry	entry = {0};
+	daos_handle_t           th = DAOS_TX_NONE;
+	bool			exists;
+	int			rc;
+
+	if (dfs == NULL || !dfs->mounted)
+		return -DER_INVAL;
+	if (dfs->amode != O_RDWR)
+		return -DER_NO_PERM;
+	if (name == NULL)
+		return -DER_INVAL;
+	if (parent == NULL)
+		parent = &dfs->root;
+	else if (!S_ISDIR(parent->mode))
+		return -DER_NOTDIR;
+
+	D_DEBUG(DB_TRACE, "Remove entry %s from %s\n", name, parent->name);
+
+	rc = check_access(dfs, geteuid(), getegid(), parent->mode, W_OK | X_OK);
+	if (rc) {
+		D_ERROR("Permission Denied.\n");
+		return rc;
+	}
+
+	rc = fetch_entry(parent->oh, th, name, false, &exists, &entry);
+	if (rc)
+		D_GOTO(out, rc);
+
+	if (!exists)
+		D_GOTO(out, rc = -DER_NONEXIST);
+
+	if (S_ISDIR(entry.mode)) {
+		uint32_t nlinks = 0;
+		daos_handle_t oh;
+
+		/** check if dir is empty */
+		rc = daos_obj_open(dfs->coh, entry.oid, DAOS_OO_RW, &oh, NULL);
+		if (rc) {
+			D_ERROR("daos_obj_open() Failed (%d)\n", rc);
+			D_GOTO(out, rc);
+		}
+
+		rc = get_nlinks(oh, th, &nlinks, true);
+		if (rc) {
+			daos_obj_close(oh, NULL);
+			D_GOTO(out, rc);
 		}
 
 		rc = daos_obj_close(oh, NULL);
@@ -1350,7 +1754,7 @@ dfs_remove(dfs_t *dfs, dfs_obj_t *parent, const char *name, bool force)
 		}
 
 		if (force && nlinks != 0) {
-			rc = remove_dir_contents(dfs, th, entry);
+			rc = remove_tree(dfs, th, entry.oid);
 			if (rc)
 				D_GOTO(out, rc);
 		}
@@ -1364,6 +1768,29 @@ out:
 	return rc;
 }
 
+int
+dfs_remove_tree(dfs_t *dfs, dfs_obj_t *obj)
+{
+	int	rc;
+
+	if (dfs == NULL || !dfs->mounted)
+		return -DER_INVAL;
+	if (dfs->amode != O_RDWR)
+		return -DER_NO_PERM;
+	if (obj == NULL || !S_ISDIR(obj->mode))
+		return -DER_NOTDIR;
+
+	D_DEBUG(DB_TRACE, "Remove the contents of %s\n", obj->name);
+
+	rc = check_access(dfs, geteuid(), getegid(), obj->mode, W_OK | X_OK);
+	if (rc) {
+		D_ERROR("Permission Denied.\n");
+		return rc;
+	}
+
+	return remove_tree(dfs, DAOS_TX_NONE, obj->oid);
+}
+
 int
 dfs_lookup(dfs_t *dfs, const char *path, int flags, dfs_obj_t **_obj,
 	   mode_t *mode)
@@ -1473,6 +1900,8 @@ dfs_lookup_loop:
 				daos_array_close(obj->oh, NULL);
 				D_GOTO(err_obj, rc);
 			}
+			obj->chunk_size = dkey_size;
+			dfs_cache_obj_init(dfs, obj);
 
 			break;
 		}
@@ -1539,6 +1968,120 @@ err_obj:
 	goto out;
 }
 
+int
+dfs_lookup_rel(dfs_t *dfs, dfs_obj_t *parent, const char *name, int flags,
+	       dfs_obj_t **_obj, mode_t *mode, struct stat *stbuf)
+{
+	dfs_obj_t		*obj;
+	struct dfs_entry	entry = {0};
+	bool			exists;
+	int			daos_mode;
+	int			rc;
+
+	if (dfs == NULL || !dfs->mounted)
+		return -DER_INVAL;
+	if (_obj == NULL || name == NULL)
+		return -DER_INVAL;
+	if (strlen(name) >= DFS_MAX_PATH)
+		return -DER_INVAL;
+	if (parent == NULL)
+		parent = &dfs->root;
+	else if (!S_ISDIR(parent->mode))
+		return -DER_NOTDIR;
+
+	daos_mode = get_daos_obj_mode(flags);
+	if (daos_mode == -1) {
+		D_ERROR("Invalid access mode.\n");
+		return -DER_INVAL;
+	}
+
+	rc = check_access(dfs, geteuid(), getegid(), parent->mode, X_OK);
+	if (rc) {
+		D_ERROR("Permission Denied.\n");
+		return rc;
+	}
+
+	rc = fetch_entry(parent->oh, DAOS_TX_NONE, name, true, &exists,
+			 &entry);
+	if (rc)
+		return rc;
+
+	if (!exists) {
+		D_DEBUG(DB_TRACE, "Entry %s does not exist\n", name);
+		D_GOTO(out, rc = -DER_NONEXIST);
+	}
+
+	D_ALLOC_PTR(obj);
+	if (obj == NULL)
+		D_GOTO(out, rc = -DER_NOMEM);
+
+	strcpy(obj->name, name);
+	obj->mode = entry.mode;
+	oid_cp(&obj->oid, entry.oid);
+	oid_cp(&obj->parent_oid, parent->oid);
+
+	switch (entry.mode & S_IFMT) {
+	case S_IFREG:
+	{
+		daos_size_t elem_size, dkey_size;
+
+		rc = daos_array_open(dfs->coh, entry.oid, DAOS_TX_NONE,
+				     daos_mode, &elem_size, &dkey_size,
+				     &obj->oh, NULL);
+		if (rc) {
+			D_ERROR("daos_array_open() failed (%d)\n", rc);
+			D_GOTO(err_obj, rc);
+		}
+		if (elem_size != 1) {
+			D_ERROR("Invalid Byte array elem size (%zu)\n",
+				elem_size);
+			daos_array_close(obj->oh, NULL);
+			D_GOTO(err_obj, rc = -DER_INVAL);
+		}
+		obj->chunk_size = dkey_size;
+		dfs_cache_obj_init(dfs, obj);
+		break;
+	}
+	case S_IFDIR:
+		rc = daos_obj_open(dfs->coh, entry.oid, daos_mode, &obj->oh,
+				   NULL);
+		if (rc) {
+			D_ERROR("daos_obj_open() Failed (%d)\n", rc);
+			D_GOTO(err_obj, rc);
+		}
+		break;
+	case S_IFLNK:
+		obj->value = entry.value;
+		entry.value = NULL;
+		break;
+	default:
+		D_ERROR("Invalid entry type (not a dir, file, symlink).\n");
+		D_GOTO(err_obj, rc = -DER_INVAL);
+	}
+
+	if (stbuf) {
+		if (S_ISLNK(obj->mode))
+			entry.value = obj->value;
+		rc = entry2stat(dfs, DAOS_TX_NONE, &entry, stbuf);
+		entry.value = NULL;
+		if (rc) {
+			dfs_release(obj);
+			D_GOTO(out, rc);
+		}
+	}
+
+	if (mode)
+		*mode = obj->mode;
+	*_obj = obj;
+out:
+	if (entry.value)
+		free(entry.value);
+	return rc;
+err_obj:
+	D_FREE(obj);
+	goto out;
+}
+
 int
 dfs_nlinks(dfs_t *dfs, dfs_obj_t *obj, uint32_t *nlinks)
 {
@@ -1626,6 +2169,67 @@ out:
 	return rc;
 }
 
+int
+dfs_readdirplus(dfs_t *dfs, dfs_obj_t *obj, daos_anchor_t *anchor,
+		uint32_t *nr, struct dirent *dirs, dfs_obj_t **objs,
+		struct stat *stbufs)
+{
+	struct dfs_batch	bt;
+	uint32_t		i, key_nr;
+	int			rc;
+
+	rc = dfs_readdir(dfs, obj, anchor, nr, dirs);
+	if (rc || *nr == 0)
+		return rc;
+
+	rc = check_access(dfs, geteuid(), getegid(), obj->mode, X_OK);
+	if (rc) {
+		D_ERROR("Permission Denied.\n");
+		return rc;
+	}
+
+	if (objs)
+		memset(objs, 0, *nr * sizeof(*objs));
+
+	rc = batch_init(&bt, dfs, DAOS_TX_NONE, obj, obj->oh, false);
+	if (rc)
+		return rc;
+	bt.bt_dirs = dirs;
+	bt.bt_objs = objs;
+	bt.bt_stbufs = stbufs;
+
+	for (i = 0; i < *nr; i++)
+		batch_add(&bt, dirs[i].d_name, strlen(dirs[i].d_name), i);
+
+	rc = batch_drain(&bt);
+	batch_fini(&bt);
+	if (rc) {
+		for (i = 0; objs != NULL && i < *nr; i++) {
+			if (objs[i])
+				dfs_release(objs[i]);
+			objs[i] = NULL;
+		}
+		return rc;
+	}
+
+	/** squeeze out the entries removed since they were enumerated */
+	for (key_nr = 0, i = 0; i < *nr; i++) {
+		if (dirs[i].d_name[0] == '\0')
+			continue;
+		if (key_nr != i) {
+			dirs[key_nr] = dirs[i];
+			if (objs)
+				objs[key_nr] = objs[i];
+			if (stbufs)
+				stbufs[key_nr] = stbufs[i];
+		}
+		key_nr++;
+	}
+	*nr = key_nr;
+
+	return 0;
+}
+
 int
 dfs_open(dfs_t *dfs, dfs_obj_t *parent, const char *name, mode_t mode,
 	 int flags, daos_oclass_id_t cid, const char *value, dfs_obj_t **_obj)
@@ -1672,6 +2276,7 @@ dfs_open(dfs_t *dfs, dfs_obj_t *parent, const char *name, mode_t mode,
 			D_FREE(obj);
 			D_GOTO(out, rc);
 		}
+		dfs_cache_obj_init(dfs, obj);
 		break;
 	case S_IFDIR:
 		rc = open_dir(dfs, th, parent->oh, flags, cid, obj);
@@ -1703,11 +2308,16 @@ out:
 int
 dfs_release(dfs_obj_t *obj)
 {
+	int flush_rc = 0;
 	int rc = 0;
 
 	if (obj == NULL)
 		return -DER_INVAL;
 
+	/** write the cached data back before the array is closed */
+	if (obj->cache)
+		flush_rc = dfs_cache_obj_fini(obj);
+
 	if (S_ISDIR(obj->mode))
 		rc = daos_obj_close(obj->oh, NULL);
 	else if (S_ISREG(obj->mode))
@@ -1723,12 +2333,11 @@ dfs_release(dfs_obj_t *obj)
 	}
 
 	D_FREE(obj);
-	return 0;
+	return flush_rc;
 }
 
 static int
-io_internal(dfs_t *dfs, dfs_obj_t *obj, daos_sg_list_t sgl, daos_off_t off,
-	    int flag)
+io_internal(dfs_obj_t *obj, daos_sg_list_t sgl, daos_off_t off, int flag)
 {
 	daos_array_iod_t	iod;
 	daos_range_t		rg;
@@ -1767,19 +2376,14 @@ io_internal(dfs_t *dfs, dfs_obj_t *obj, daos_sg_list_t sgl, daos_off_t off,
 }
 
 int
-dfs_read(dfs_t *dfs, dfs_obj_t *obj, daos_sg_list_t sgl, daos_off_t off,
-	 daos_size_t *read_size)
+dfs_obj_read(dfs_obj_t *obj, daos_sg_list_t sgl, daos_off_t off,
+	     daos_size_t *read_size)
 {
 	daos_size_t	array_size, max_read;
 	daos_size_t	bytes_to_read, rem;
 	int		i;
 	int		rc;
 
-	if (dfs == NULL || !dfs->mounted)
-		return -DER_INVAL;
-	if (obj == NULL || !S_ISREG(obj->mode))
-		return -DER_INVAL;
-
 	rc = daos_array_get_size(obj->oh, DAOS_TX_NONE, &array_size, NULL);
 	if (rc) {
 		D_ERROR("daos_array_get_size() failed (%d)\n", rc);
@@ -1809,7 +2413,7 @@ dfs_read(dfs_t *dfs, dfs_obj_t *obj, daos_sg_list_t sgl, daos_off_t off,
 	}
 	sgl.sg_nr = i;
 
-	rc = io_internal(dfs, obj, sgl, off, DFS_READ);
+	rc = io_internal(obj, sgl, off, DFS_READ);
 	if (rc) {
 		D_ERROR("daos_array_read() failed (%d)\n", rc);
 		return rc;
@@ -1819,6 +2423,21 @@ dfs_read(dfs_t *dfs, dfs_obj_t *obj, daos_sg_list_t sgl, daos_off_t off,
 	return 0;
 }
 
+int
+dfs_read(dfs_t *dfs, dfs_obj_t *obj, daos_sg_list_t sgl, daos_off_t off,
+	 daos_size_t *read_size)
+{
+	if (dfs == NULL || !dfs->mounted)
+		return -DER_INVAL;
+	if (obj == NULL || !S_ISREG(obj->mode))
+		return -DER_INVAL;
+
+	if (obj->cache)
+		return dfs_cache_read(dfs, obj, &sgl, off, read_size);
+
+	return dfs_obj_read(obj, sgl, off, read_size);
+}
+
 int
 dfs_write(dfs_t *dfs, dfs_obj_t *obj, daos_sg_list_t sgl, daos_off_t off)
 {
@@ -1829,7 +2448,197 @@ dfs_write(dfs_t *dfs, dfs_obj_t *obj, daos_sg_list_t sgl, daos_off_t off)
 	if (obj == NULL || !S_ISREG(obj->mode))
 		return -DER_INVAL;
 
-	return io_internal(dfs, obj, sgl, off, DFS_WRITE);
+	if (obj->cache)
+		return dfs_cache_write(dfs, obj, &sgl, off);
+
+	return io_internal(obj, sgl, off, DFS_WRITE);
+}
+
+/** Bytes of \a iod that fall below \a array_size (i.e. not past EOF) */
+static daos_size_t
+read_size_clip(daos_array_iod_t *iod, daos_size_t array_size)
+{
+	daos_size_t	size = 0;
+	daos_size_t	i;
+
+	for (i = 0; i < iod->arr_nr; i++) {
+		daos_range_t *rg = &iod->arr_rgs[i];
+
+		if (rg->rg_idx >= array_size)
+			continue;
+		size += min(rg->rg_len, array_size - rg->rg_idx);
+	}
+
+	return size;
+}
+
+struct dfs_read_props {
+	daos_handle_t		 oh;
+	daos_array_iod_t	*iod;
+	daos_sg_list_t		*sgl;
+	daos_size_t		*read_size;
+	daos_size_t		 array_size;
+};
+
+static int
+readx_comp_cb(tse_task_t *task, void *data)
+{
+	struct dfs_read_props	*props = *((struct dfs_read_props **)data);
+
+	if (task->dt_result == 0)
+		*props->read_size = read_size_clip(props->iod,
+						   props->array_size);
+	else
+		D_ERROR("Failed to read file (%d)\n", task->dt_result);
+
+	D_FREE(props);
+	return 0;
+}
+
+/*
+ * Body of the readx task: fetch the array size and the data in parallel, the
+ * task completes once both sub-tasks are done and readx_comp_cb() then clips
+ * the returned read size to EOF.
+ */
+static int
+readx_task(tse_task_t *task)
+{
+	struct dfs_read_props	*props = dc_task_get_priv(task);
+	tse_task_t		*tasks[2] = {NULL, NULL};
+	daos_array_get_size_t	*size_args;
+	daos_array_io_t		*io_args;
+	int			 rc;
+
+	rc = daos_task_create(DAOS_OPC_ARRAY_GET_SIZE, tse_task2sched(task),
+			      0, NULL, &tasks[0]);
+	if (rc) {
+		D_ERROR("Failed to create array_get_size task (%d)\n", rc);
+		D_GOTO(err_task, rc);
+	}
+	size_args = daos_task_get_args(tasks[0]);
+	size_args->oh	= props->oh;
+	size_args->th	= DAOS_TX_NONE;
+	size_args->size	= &props->array_size;
+
+	rc = daos_task_create(DAOS_OPC_ARRAY_READ, tse_task2sched(task),
+			      0, NULL, &tasks[1]);
+	if (rc) {
+		D_ERROR("Failed to create array_read task (%d)\n", rc);
+		D_GOTO(err_task, rc);
+	}
+	io_args = daos_task_get_args(tasks[1]);
+	io_args->oh	= props->oh;
+	io_args->th	= DAOS_TX_NONE;
+	io_args->iod	= props->iod;
+	io_args->sgl	= props->sgl;
+	io_args->csums	= NULL;
+
+	/** The readx task completes when both sub-tasks complete */
+	rc = tse_task_register_deps(task, 2, tasks);
+	if (rc) {
+		D_ERROR("Failed to register dependency (%d)\n", rc);
+		D_GOTO(err_task, rc);
+	}
+
+	tse_task_schedule(tasks[0], false);
+	tse_task_schedule(tasks[1], false);
+	return 0;
+
+err_task:
+	if (tasks[1])
+		tse_task_complete(tasks[1], rc);
+	if (tasks[0])
+		tse_task_complete(tasks[0], rc);
+	tse_task_complete(task, rc);
+	return rc;
+}
+
+int
+dfs_obj_readx(dfs_obj_t *obj, daos_array_iod_t *iod, daos_sg_list_t *sgl,
+	      daos_size_t *read_size, daos_event_t *ev)
+{
+	struct dfs_read_props	*props;
+	tse_task_t		*task;
+	int			 rc;
+
+	D_ALLOC_PTR(props);
+	if (props == NULL)
+		return -DER_NOMEM;
+
+	props->oh = obj->oh;
+	props->iod = iod;
+	props->sgl = sgl;
+	props->read_size = read_size;
+
+	rc = dc_task_create(readx_task, NULL, ev, &task);
+	if (rc) {
+		D_FREE(props);
+		return rc;
+	}
+
+	rc = tse_task_register_comp_cb(task, readx_comp_cb, &props,
+				       sizeof(props));
+	if (rc) {
+		D_FREE(props);
+		dc_task_decref(task);
+		return rc;
+	}
+	dc_task_set_priv(task, props);
+
+	/** props is freed by readx_comp_cb() from now on */
+	return dc_task_schedule(task, true);
+}
+
+int
+dfs_readx(dfs_t *dfs, dfs_obj_t *obj, daos_array_iod_t *iod,
+	  daos_sg_list_t *sgl, daos_size_t *read_size, daos_event_t *ev)
+{
+	int rc;
+
+	if (dfs == NULL || !dfs->mounted)
+		return -DER_INVAL;
+	if (obj == NULL || !S_ISREG(obj->mode))
+		return -DER_INVAL;
+	if (iod == NULL || sgl == NULL || read_size == NULL)
+		return -DER_INVAL;
+
+	/** the array must have the data written through the cache */
+	if (obj->cache) {
+		rc = dfs_cache_obj_flush(obj, false);
+		if (rc)
+			return rc;
+	}
+
+	return dfs_obj_readx(obj, iod, sgl, read_size, ev);
+}
+
+int
+dfs_writex(dfs_t *dfs, dfs_obj_t *obj, daos_array_iod_t *iod,
+	   daos_sg_list_t *sgl, daos_event_t *ev)
+{
+	int rc;
+
+	if (dfs == NULL || !dfs->mounted)
+		return -DER_INVAL;
+	if (dfs->amode != O_RDWR)
+		return -DER_NO_PERM;
+	if (obj == NULL || !S_ISREG(obj->mode))
+		return -DER_INVAL;
+	if (iod == NULL || sgl == NULL)
+		return -DER_INVAL;
+
+	/** drop the cached chunks this write would make stale */
+	if (obj->cache) {
+		rc = dfs_cache_obj_inval(obj, iod);
+		if (rc)
+			return rc;
+	}
+
+	rc = daos_array_write(obj->oh, DAOS_TX_NONE, iod, sgl, NULL, ev);
+	if (rc)
+		D_ERROR("daos_array_write() failed (%d)\n", rc);
+
+	return rc;
 }
 
 int
@@ -1877,6 +2686,13 @@ dfs_ostat(dfs_t *dfs, dfs_obj_t *obj, struct stat *stbuf)
 	if (obj == NULL)
 		return -DER_INVAL;
 
+	/** the size must account for the data written through the cache */
+	if (obj->cache) {
+		rc = dfs_cache_obj_flush(obj, false);
+		if (rc)
+			return rc;
+	}
+
 	/** Open parent object and fetch entry of obj from it */
 	rc = daos_obj_open(dfs->coh, obj->parent_oid, DAOS_OO_RO, &oh, NULL);
 	if (rc)
@@ -2062,6 +2878,89 @@ out:
 	return rc;
 }
 
+int
+dfs_utimes(dfs_t *dfs, dfs_obj_t *parent, const char *name,
+	   const time_t *atime, const time_t *mtime)
+{
+	const char		*names[3] = {ATIME_NAME, MTIME_NAME, CTIME_NAME};
+	const time_t		*times[3];
+	uid_t			euid;
+	daos_handle_t		oh;
+	bool			exists;
+	struct dfs_entry	entry;
+	daos_sg_list_t		sgls[3];
+	daos_iov_t		sg_iovs[3];
+	daos_iod_t		iods[3];
+	daos_key_t		dkey;
+	time_t			ctime;
+	unsigned int		i, nr;
+	int			rc;
+
+	if (dfs == NULL || !dfs->mounted)
+		return -DER_INVAL;
+	if (dfs->amode != O_RDWR)
+		return -DER_NO_PERM;
+	if (parent == NULL)
+		parent = &dfs->root;
+	else if (!S_ISDIR(parent->mode))
+		return -DER_NOTDIR;
+	if (name == NULL) {
+		if (strcmp(parent->name, "/") != 0) {
+			D_ERROR("Invalid path %s and entry name %s)\n",
+				parent->name, name);
+			return -DER_INVAL;
+		}
+		name = parent->name;
+		oh = dfs->super_oh;
+	} else {
+		oh = parent->oh;
+	}
+
+	euid = geteuid();
+	/** only root or owner can change the times */
+	if (euid != 0 && dfs->uid != euid)
+		return -DER_NO_PERM;
+
+	rc = fetch_entry(oh, DAOS_TX_NONE, name, false, &exists, &entry);
+	if (rc)
+		return rc;
+	if (!exists)
+		return -DER_NONEXIST;
+
+	/** the status change time is always updated */
+	ctime = time(NULL);
+	times[0] = atime;
+	times[1] = mtime;
+	times[2] = &ctime;
+
+	daos_iov_set(&dkey, (void *)name, strlen(name));
+	for (i = nr = 0; i < 3; i++) {
+		if (times[i] == NULL)
+			continue;
+
+		daos_iov_set(&iods[nr].iod_name, (void *)names[i],
+			     strlen(names[i]));
+		daos_csum_set(&iods[nr].iod_kcsum, NULL, 0);
+		iods[nr].iod_nr		= 1;
+		iods[nr].iod_recxs	= NULL;
+		iods[nr].iod_eprs	= NULL;
+		iods[nr].iod_csums	= NULL;
+		iods[nr].iod_type	= DAOS_IOD_SINGLE;
+		iods[nr].iod_size	= sizeof(time_t);
+
+		daos_iov_set(&sg_iovs[nr], (void *)times[i], sizeof(time_t));
+		sgls[nr].sg_nr		= 1;
+		sgls[nr].sg_nr_out	= 0;
+		sgls[nr].sg_iovs	= &sg_iovs[nr];
+		nr++;
+	}
+
+	rc = daos_obj_update(oh, DAOS_TX_NONE, &dkey, nr, iods, sgls, NULL);
+	if (rc)
+		D_ERROR("Failed to update times (rc = %d)\n", rc);
+	return rc;
+}
+
 int
 dfs_get_size(dfs_t *dfs, dfs_obj_t *obj, daos_size_t *size)
 {
@@ -2078,6 +2977,12 @@ dfs_get_size(dfs_t *dfs, dfs_obj_t *obj, daos_size_t *size)
 		return rc;
 	}
 
+	if (obj->cache) {
+		rc = dfs_cache_obj_flush(obj, false);
+		if (rc)
+			return rc;
+	}
+
 	return daos_array_get_size(obj->oh, DAOS_TX_NONE, size, NULL);
 }
 
@@ -2102,6 +3007,13 @@ dfs_punch(dfs_t *dfs, dfs_obj_t *obj, daos_off_t offset, daos_size_t len)
 		return rc;
 	}
 
+	/** the cached chunks would be stale after the punch */
+	if (obj->cache) {
+		rc = dfs_cache_obj_flush(obj, true);
+		if (rc)
+			return rc;
+	}
+
 	/** simple truncate */
 	if (len == DFS_MAX_FSIZE) {
 		rc = daos_array_set_size(obj->oh, DAOS_TX_NONE, offset, NULL);
@@ -2155,6 +3067,31 @@ dfs_get_mode(dfs_obj_t *obj, mode_t *mode)
 	return 0;
 }
 
+int
+dfs_obj2id(dfs_obj_t *obj, daos_obj_id_t *oid)
+{
+	if (obj == NULL || oid == NULL)
+		return -DER_INVAL;
+
+	oid_cp(oid, obj->oid);
+	return 0;
+}
+
+int
+dfs_update_parent(dfs_obj_t *obj, dfs_obj_t *parent, const char *name)
+{
+	if (obj == NULL || parent == NULL || name == NULL)
+		return -DER_INVAL;
+	if (!S_ISDIR(parent->mode))
+		return -DER_NOTDIR;
+	if (strlen(name) >= DFS_MAX_PATH)
+		return -DER_INVAL;
+
+	oid_cp(&obj->parent_oid, parent->oid);
+	strcpy(obj->name, name);
+	return 0;
+}
+
 int
 dfs_get_symlink_value(dfs_obj_t *obj, char *buf, daos_size_t *size)
 {
@@ -2446,6 +3383,14 @@ dfs_sync(dfs_t *dfs)
 	if (dfs->amode != O_RDWR)
 		return -DER_NO_PERM;
 
+	if (dfs->cache) {
+		rc = dfs_cache_flush(dfs);
+		if (rc) {
+			D_ERROR("Failed to flush the cache (rc = %d).\n", rc);
+			return rc;
+		}
+	}
+
 	rc = daos_cont_sync(dfs->coh, NULL);
 	if (rc) {
 		D_ERROR("Failed daos_cont_sync (rc = %d).\n", rc);
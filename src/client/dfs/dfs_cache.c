@@ -0,0 +1,1093 @@
+/**
+ * (C) Copyright 2018 Intel Corporation.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * GOVERNMENT LICENSE RIGHTS-OPEN SOURCE SOFTWARE
+ * The Government's rights to use, modify, reproduce, release, perform, display,
+ * or disclose this software are subject to the terms of the Apache License as
+ * provided in Contract No. B609815.
+ * Any reproduction of computer software, computer software documentation, or
+ * portions thereof marked with this legend must also reproduce the markings.
+ */
+/**
+ * DFS client data cache.
+ *
+ * File data is cached in units of one array chunk (dkey), so a cache fill or
+ * a flush is a single dkey I/O. The cache has a memory budget per mount and
+ * serves two purposes:
+ *
+ * - Readahead: a read continuing where the previous read of the file ended is
+ *   sequential. Sequential reads are served from cached chunks, and the chunks
+ *   after the one being read are prefetched asynchronously. The prefetch window
+ *   starts at one chunk and doubles on each sequential read up to DFS_RA_MAX,
+ *   a non-sequential read resets it and goes to the array directly unless the
+ *   data is already cached.
+ *
+ * - Write-behind: writes are copied into the chunk and coalesced into one dirty
+ *   extent per chunk. A chunk which becomes fully dirty is written behind
+ *   asynchronously, the other dirty extents are written on dfs_sync(),
+ *   dfs_release() or when the memory budget is exhausted. A write-behind error
+ *   is reported by the next flush of the file.
+ *
+ * The readahead and write-behind I/Os are launched on an EQ of the mount and
+ * reaped on the next cache operation, or waited for when a chunk in flight is
+ * needed. Clean chunks are kept on a LRU list and evicted when the budget is
+ * exhausted.
+ *
+ * The cache lock is not held while waiting for an I/O: one thread polls the
+ * EQ and the others wait on a condition until it has completed some I/Os. A
+ * chunk being waited for is pinned so it can't be freed, and everything known
+ * about the cache is checked again once the lock is taken back.
+ *
+ * Data written by other clients is only seen by chunks fetched after it's
+ * written, and the data written through the cache is only seen by other
+ * clients, or by opening the file again, after it's flushed.
+ */
+#define D_LOGFAC	DD_FAC(dfs)
+
+#include <daos/common.h>
+
+#include "daos_types.h"
+#include "daos_api.h"
+#include "daos_event.h"
+#include "daos_addons.h"
+#include "daos_fs.h"
+#include "dfs_internal.h"
+
+/** Max number of chunks prefetched ahead of a sequential reader */
+#define DFS_RA_MAX	8
+/** Max number of events reaped at once */
+#define DFS_REAP_MAX	16
+
+enum {
+	DFS_CHUNK_IDLE,
+	DFS_CHUNK_FETCHING,
+	DFS_CHUNK_FLUSHING,
+};
+
+/** A cached chunk of a file */
+struct dfs_chunk {
+	/** link in dfs_obj_cache::oc_chunks */
+	d_list_t		 ch_link;
+	/** link in dfs_cache::ca_lru, for idle & clean chunks only */
+	d_list_t		 ch_lru;
+	struct dfs_obj_cache	*ch_oc;
+	/** chunk index in the file */
+	daos_off_t		 ch_idx;
+	/** DFS_CHUNK_* */
+	int			 ch_state;
+	/** number of threads waiting for the chunk, it's not freed if > 0 */
+	unsigned int		 ch_pin;
+	/** chunk has been fetched, [0, ch_valid) holds the file data */
+	bool			 ch_fetched;
+	daos_size_t		 ch_valid;
+	/** dirty extent of the chunk, empty if lo == hi */
+	daos_size_t		 ch_dirty_lo;
+	daos_size_t		 ch_dirty_hi;
+	/** fetch or flush in flight */
+	daos_event_t		 ch_ev;
+	daos_array_iod_t	 ch_iod;
+	daos_range_t		 ch_rg;
+	daos_sg_list_t		 ch_sgl;
+	daos_iov_t		 ch_iov;
+	daos_size_t		 ch_read_size;
+	/** chunk data */
+	char			*ch_buf;
+};
+
+/** Cache of an open file */
+struct dfs_obj_cache {
+	/** link in dfs_cache::ca_objs */
+	d_list_t		 oc_link;
+	/** cached chunks of the file */
+	d_list_t		 oc_chunks;
+	struct dfs_cache	*oc_cache;
+	dfs_obj_t		*oc_obj;
+	/** offset a sequential read would start at */
+	daos_off_t		 oc_ra_next;
+	/** readahead window in chunks, 0 if the reader is not sequential */
+	unsigned int		 oc_ra_win;
+	/** end of the highest write, the file is at least that large */
+	daos_off_t		 oc_write_hi;
+	/** error of a failed write-behind, returned by the next flush */
+	int			 oc_err;
+};
+
+/** Cache of a mount */
+struct dfs_cache {
+	pthread_mutex_t		 ca_lock;
+	/** signaled when the polling thread has completed some I/Os */
+	pthread_cond_t		 ca_cond;
+	/** a thread is polling the EQ without the lock */
+	bool			 ca_polling;
+	/** EQ of the readahead and write-behind I/Os */
+	daos_handle_t		 ca_eqh;
+	/** memory budget and memory used by the chunks, in bytes */
+	daos_size_t		 ca_size;
+	daos_size_t		 ca_used;
+	/** files being cached */
+	d_list_t		 ca_objs;
+	/** idle & clean chunks, least recently used first */
+	d_list_t		 ca_lru;
+};
+
+static inline bool
+chunk_is_dirty(struct dfs_chunk *ch)
+{
+	return ch->ch_dirty_hi > ch->ch_dirty_lo;
+}
+
+/** Chunk holds no data, neither fetched nor dirty */
+static inline bool
+chunk_is_empty(struct dfs_chunk *ch)
+{
+	return ch->ch_state == DFS_CHUNK_IDLE && !ch->ch_fetched &&
+	       !chunk_is_dirty(ch);
+}
+
+static inline daos_size_t
+sgl_size(daos_sg_list_t *sgl)
+{
+	daos_size_t	size = 0;
+	int		i;
+
+	for (i = 0; i < sgl->sg_nr; i++)
+		size += sgl->sg_iovs[i].iov_len;
+	return size;
+}
+
+/** Copy @len bytes between @buf and @sgl, starting at byte @sgl_off of @sgl */
+static void
+sgl_copy(daos_sg_list_t *sgl, daos_size_t sgl_off, char *buf,
+	 daos_size_t len, bool to_sgl)
+{
+	daos_iov_t	*iov;
+	daos_size_t	 n;
+	int		 i;
+
+	for (i = 0; i < sgl->sg_nr && len > 0; i++) {
+		iov = &sgl->sg_iovs[i];
+		if (sgl_off >= iov->iov_len) {
+			sgl_off -= iov->iov_len;
+			continue;
+		}
+
+		n = min(len, iov->iov_len - sgl_off);
+		if (to_sgl)
+			memcpy((char *)iov->iov_buf + sgl_off, buf, n);
+		else
+			memcpy(buf, (char *)iov->iov_buf + sgl_off, n);
+		buf += n;
+		len -= n;
+		sgl_off = 0;
+	}
+}
+
+static struct dfs_chunk *
+chunk_lookup(struct dfs_obj_cache *oc, daos_off_t idx)
+{
+	struct dfs_chunk *ch;
+
+	d_list_for_each_entry(ch, &oc->oc_chunks, ch_link) {
+		if (ch->ch_idx == idx)
+			return ch;
+	}
+	return NULL;
+}
+
+/** Put an idle, clean & unpinned chunk at the LRU tail, or take it off */
+static void
+chunk_lru_update(struct dfs_chunk *ch)
+{
+	d_list_del_init(&ch->ch_lru);
+	if (ch->ch_state == DFS_CHUNK_IDLE && ch->ch_pin == 0 &&
+	    ch->ch_fetched && !chunk_is_dirty(ch))
+		d_list_add_tail(&ch->ch_lru, &ch->ch_oc->oc_cache->ca_lru);
+}
+
+static void
+chunk_free(struct dfs_chunk *ch)
+{
+	struct dfs_cache *cache = ch->ch_oc->oc_cache;
+
+	D_ASSERT(ch->ch_state == DFS_CHUNK_IDLE && ch->ch_pin == 0);
+	d_list_del(&ch->ch_link);
+	d_list_del(&ch->ch_lru);
+	D_ASSERT(cache->ca_used >= ch->ch_oc->oc_obj->chunk_size);
+	cache->ca_used -= ch->ch_oc->oc_obj->chunk_size;
+	daos_event_fini(&ch->ch_ev);
+	D_FREE(ch->ch_buf);
+	D_FREE(ch);
+}
+
+/**
+ * Free the chunk if it holds no data and nobody waits for it, otherwise update
+ * its LRU position.
+ */
+static void
+chunk_settle(struct dfs_chunk *ch)
+{
+	if (chunk_is_empty(ch) && ch->ch_pin == 0)
+		chunk_free(ch);
+	else
+		chunk_lru_update(ch);
+}
+
+/** Complete the fetch or the flush of a chunk */
+static void
+chunk_complete(struct dfs_chunk *ch, int rc)
+{
+	struct dfs_obj_cache *oc = ch->ch_oc;
+
+	if (ch->ch_state == DFS_CHUNK_FETCHING) {
+		if (rc == 0) {
+			ch->ch_fetched = true;
+			ch->ch_valid = ch->ch_read_size;
+		} else {
+			D_DEBUG(DB_IO, "chunk "DF_U64" fetch failed (%d)\n",
+				ch->ch_idx, rc);
+		}
+	} else {
+		D_ASSERT(ch->ch_state == DFS_CHUNK_FLUSHING);
+		/** the data is lost, report the error on the next flush */
+		if (rc != 0) {
+			D_ERROR("chunk "DF_U64" write-behind failed (%d)\n",
+				ch->ch_idx, rc);
+			if (oc->oc_err == 0)
+				oc->oc_err = rc;
+		}
+		ch->ch_dirty_lo = ch->ch_dirty_hi = 0;
+	}
+	ch->ch_state = DFS_CHUNK_IDLE;
+}
+
+static void
+cache_complete(daos_event_t **evs, int nr)
+{
+	struct dfs_chunk	*ch;
+	int			 i;
+
+	for (i = 0; i < nr; i++) {
+		ch = container_of(evs[i], struct dfs_chunk, ch_ev);
+		chunk_complete(ch, evs[i]->ev_error);
+		chunk_settle(ch);
+	}
+}
+
+/** Complete the cache I/Os which are done, without waiting */
+static int
+cache_reap(struct dfs_cache *cache)
+{
+	daos_event_t	*evs[DFS_REAP_MAX];
+	int		 rc;
+
+	rc = daos_eq_poll(cache->ca_eqh, 0, DAOS_EQ_NOWAIT, DFS_REAP_MAX, evs);
+	if (rc < 0) {
+		D_ERROR("daos_eq_poll() failed (%d)\n", rc);
+		return rc;
+	}
+
+	cache_complete(evs, rc);
+	return 0;
+}
+
+/**
+ * Wait until some cache I/Os have completed. The cache lock is dropped while
+ * waiting, so the caller must look up again whatever it hasn't pinned.
+ */
+static int
+cache_poll(struct dfs_cache *cache)
+{
+	daos_event_t	*evs[DFS_REAP_MAX];
+	int		 rc;
+
+	/** another thread is polling, it wakes us up once it's done */
+	if (cache->ca_polling) {
+		pthread_cond_wait(&cache->ca_cond, &cache->ca_lock);
+		return 0;
+	}
+
+	cache->ca_polling = true;
+	D_MUTEX_UNLOCK(&cache->ca_lock);
+	rc = daos_eq_poll(cache->ca_eqh, 1, DAOS_EQ_WAIT, DFS_REAP_MAX, evs);
+	D_MUTEX_LOCK(&cache->ca_lock);
+	cache->ca_polling = false;
+
+	if (rc < 0)
+		D_ERROR("daos_eq_poll() failed (%d)\n", rc);
+	else
+		cache_complete(evs, rc);
+
+	pthread_cond_broadcast(&cache->ca_cond);
+	return rc < 0 ? rc : 0;
+}
+
+/**
+ * Wait for the fetch or the flush of a chunk. The chunk stays allocated, but
+ * it may have been invalidated or dirtied again once this returns.
+ */
+static int
+chunk_wait(struct dfs_chunk *ch)
+{
+	struct dfs_cache	*cache = ch->ch_oc->oc_cache;
+	int			 rc = 0;
+
+	ch->ch_pin++;
+	while (ch->ch_state != DFS_CHUNK_IDLE && rc == 0)
+		rc = cache_poll(cache);
+	ch->ch_pin--;
+	return rc;
+}
+
+static int
+chunk_fetch(struct dfs_chunk *ch)
+{
+	dfs_obj_t	*obj = ch->ch_oc->oc_obj;
+	int		 rc;
+
+	D_ASSERT(ch->ch_state == DFS_CHUNK_IDLE && !chunk_is_dirty(ch));
+
+	ch->ch_rg.rg_idx = ch->ch_idx * obj->chunk_size;
+	ch->ch_rg.rg_len = obj->chunk_size;
+	ch->ch_iod.arr_nr = 1;
+	ch->ch_iod.arr_rgs = &ch->ch_rg;
+	daos_iov_set(&ch->ch_iov, ch->ch_buf, obj->chunk_size);
+	ch->ch_sgl.sg_nr = 1;
+	ch->ch_sgl.sg_nr_out = 0;
+	ch->ch_sgl.sg_iovs = &ch->ch_iov;
+
+	ch->ch_state = DFS_CHUNK_FETCHING;
+	d_list_del_init(&ch->ch_lru);
+
+	rc = dfs_obj_readx(obj, &ch->ch_iod, &ch->ch_sgl, &ch->ch_read_size,
+			   &ch->ch_ev);
+	if (rc) {
+		D_ERROR("Failed to fetch chunk "DF_U64" (%d)\n", ch->ch_idx,
+			rc);
+		ch->ch_state = DFS_CHUNK_IDLE;
+	}
+	return rc;
+}
+
+static int
+chunk_flush(struct dfs_chunk *ch)
+{
+	dfs_obj_t	*obj = ch->ch_oc->oc_obj;
+	daos_size_t	 len = ch->ch_dirty_hi - ch->ch_dirty_lo;
+	int		 rc;
+
+	D_ASSERT(ch->ch_state == DFS_CHUNK_IDLE && chunk_is_dirty(ch));
+
+	ch->ch_rg.rg_idx = ch->ch_idx * obj->chunk_size + ch->ch_dirty_lo;
+	ch->ch_rg.rg_len = len;
+	ch->ch_iod.arr_nr = 1;
+	ch->ch_iod.arr_rgs = &ch->ch_rg;
+	daos_iov_set(&ch->ch_iov, ch->ch_buf + ch->ch_dirty_lo, len);
+	ch->ch_sgl.sg_nr = 1;
+	ch->ch_sgl.sg_nr_out = 0;
+	ch->ch_sgl.sg_iovs = &ch->ch_iov;
+
+	ch->ch_state = DFS_CHUNK_FLUSHING;
+	d_list_del_init(&ch->ch_lru);
+
+	rc = daos_array_write(obj->oh, DAOS_TX_NONE, &ch->ch_iod, &ch->ch_sgl,
+			      NULL, &ch->ch_ev);
+	if (rc) {
+		D_ERROR("Failed to flush chunk "DF_U64" (%d)\n", ch->ch_idx,
+			rc);
+		ch->ch_state = DFS_CHUNK_IDLE;
+	}
+	return rc;
+}
+
+/**
+ * Write the dirty chunks of a file and wait for all its I/Os in flight. The
+ * chunks are all dropped if @invalidate is true.
+ */
+static int
+obj_flush(struct dfs_obj_cache *oc, bool invalidate)
+{
+	struct dfs_chunk	*ch, *tmp;
+	int			 rc;
+
+	/** launch all the flushes first so they run in parallel */
+	d_list_for_each_entry(ch, &oc->oc_chunks, ch_link) {
+		if (ch->ch_state != DFS_CHUNK_IDLE || !chunk_is_dirty(ch))
+			continue;
+		rc = chunk_flush(ch);
+		if (rc)
+			return rc;
+	}
+
+	/**
+	 * The list may change while waiting, start over after each wait. A
+	 * chunk dirtied meanwhile is flushed as well.
+	 */
+again:
+	d_list_for_each_entry_safe(ch, tmp, &oc->oc_chunks, ch_link) {
+		if (ch->ch_state == DFS_CHUNK_IDLE && chunk_is_dirty(ch)) {
+			rc = chunk_flush(ch);
+			if (rc)
+				return rc;
+		}
+
+		if (ch->ch_state != DFS_CHUNK_IDLE) {
+			rc = chunk_wait(ch);
+			if (rc)
+				return rc;
+			chunk_settle(ch);
+			goto again;
+		}
+
+		if (invalidate) {
+			/** a chunk failed to flush is dropped as well */
+			ch->ch_fetched = false;
+			ch->ch_dirty_lo = ch->ch_dirty_hi = 0;
+		}
+		chunk_settle(ch);
+	}
+
+	if (invalidate) {
+		oc->oc_ra_next = 0;
+		oc->oc_ra_win = 0;
+		oc->oc_write_hi = 0;
+	}
+	return 0;
+}
+
+static bool
+chunk_in_iod(struct dfs_chunk *ch, daos_array_iod_t *iod)
+{
+	daos_size_t	chunk_size = ch->ch_oc->oc_obj->chunk_size;
+	daos_off_t	lo = ch->ch_idx * chunk_size;
+	daos_range_t	*rg;
+	int		i;
+
+	for (i = 0; i < iod->arr_nr; i++) {
+		rg = &iod->arr_rgs[i];
+		if (rg->rg_len > 0 && rg->rg_idx < lo + chunk_size &&
+		    rg->rg_idx + rg->rg_len > lo)
+			return true;
+	}
+	return false;
+}
+
+/**
+ * Drop the chunks overlapping the ranges of @iod, which is going to be
+ * written to the array directly. Their dirty data is written first so the
+ * new data wins, the other chunks are kept.
+ */
+static int
+obj_inval(struct dfs_obj_cache *oc, daos_array_iod_t *iod)
+{
+	struct dfs_chunk	*ch, *tmp;
+	daos_range_t		*rg;
+	int			 rc;
+	int			 i;
+
+again:
+	d_list_for_each_entry_safe(ch, tmp, &oc->oc_chunks, ch_link) {
+		if (!chunk_in_iod(ch, iod))
+			continue;
+
+		if (ch->ch_state == DFS_CHUNK_IDLE && chunk_is_dirty(ch)) {
+			rc = chunk_flush(ch);
+			if (rc)
+				return rc;
+		}
+
+		/** a fetch in flight would bring the old data back */
+		if (ch->ch_state != DFS_CHUNK_IDLE) {
+			rc = chunk_wait(ch);
+			if (rc)
+				return rc;
+			chunk_settle(ch);
+			goto again;
+		}
+
+		ch->ch_fetched = false;
+		chunk_settle(ch);
+	}
+
+	/** the write may extend the file past a cached EOF */
+	for (i = 0; i < iod->arr_nr; i++) {
+		rg = &iod->arr_rgs[i];
+		oc->oc_write_hi = max(oc->oc_write_hi, rg->rg_idx + rg->rg_len);
+	}
+	return 0;
+}
+
+/**
+ * Launch the write of all the dirty chunks of the mount, @inflight returns
+ * the number of chunks in flight, which are evictable once completed.
+ */
+static int
+cache_drain(struct dfs_cache *cache, int *inflight)
+{
+	struct dfs_obj_cache	*oc;
+	struct dfs_chunk	*ch;
+	int			 rc = 0;
+	int			 rc2;
+
+	*inflight = 0;
+	d_list_for_each_entry(oc, &cache->ca_objs, oc_link) {
+		d_list_for_each_entry(ch, &oc->oc_chunks, ch_link) {
+			if (ch->ch_state == DFS_CHUNK_IDLE &&
+			    chunk_is_dirty(ch)) {
+				rc2 = chunk_flush(ch);
+				if (rc == 0)
+					rc = rc2;
+			}
+			if (ch->ch_state != DFS_CHUNK_IDLE)
+				(*inflight)++;
+		}
+	}
+	return rc;
+}
+
+/**
+ * Allocate a chunk, evicting the least recently used clean chunks if the
+ * budget is exhausted. If there is none and @reclaim is true, the dirty
+ * chunks of the mount are written to reclaim memory, otherwise NULL is
+ * returned. The lock is dropped while reclaiming, so the chunk @idx may have
+ * been added by another thread meanwhile, it's returned in that case.
+ */
+static struct dfs_chunk *
+chunk_alloc(struct dfs_obj_cache *oc, daos_off_t idx, bool reclaim)
+{
+	struct dfs_cache	*cache = oc->oc_cache;
+	daos_size_t		 size = oc->oc_obj->chunk_size;
+	struct dfs_chunk	*ch;
+	int			 inflight;
+	int			 rc;
+
+	while (cache->ca_used + size > cache->ca_size) {
+		if (d_list_empty(&cache->ca_lru)) {
+			if (!reclaim)
+				return NULL;
+			/** written chunks become evictable once clean */
+			rc = cache_drain(cache, &inflight);
+			if (rc || inflight == 0)
+				return NULL;
+			rc = cache_poll(cache);
+			if (rc)
+				return NULL;
+			continue;
+		}
+		ch = d_list_entry(cache->ca_lru.next, struct dfs_chunk,
+				  ch_lru);
+		chunk_free(ch);
+	}
+
+	if (reclaim) {
+		ch = chunk_lookup(oc, idx);
+		if (ch != NULL)
+			return ch;
+	}
+
+	D_ALLOC_PTR(ch);
+	if (ch == NULL)
+		return NULL;
+
+	D_ALLOC(ch->ch_buf, size);
+	if (ch->ch_buf == NULL)
+		D_GOTO(err_ch, rc = -DER_NOMEM);
+
+	rc = daos_event_init(&ch->ch_ev, cache->ca_eqh, NULL);
+	if (rc) {
+		D_ERROR("daos_event_init() failed (%d)\n", rc);
+		D_GOTO(err_buf, rc);
+	}
+
+	D_INIT_LIST_HEAD(&ch->ch_lru);
+	ch->ch_oc = oc;
+	ch->ch_idx = idx;
+	ch->ch_state = DFS_CHUNK_IDLE;
+	d_list_add_tail(&ch->ch_link, &oc->oc_chunks);
+	cache->ca_used += size;
+	return ch;
+
+err_buf:
+	D_FREE(ch->ch_buf);
+err_ch:
+	D_FREE(ch);
+	return NULL;
+}
+
+/** Prefetch the readahead window of chunks after chunk @idx */
+static void
+obj_readahead(struct dfs_obj_cache *oc, daos_off_t idx)
+{
+	struct dfs_chunk	*ch;
+	unsigned int		 win;
+	unsigned int		 i;
+
+	/** never let the readahead take more than half of the budget */
+	win = min(oc->oc_ra_win,
+		  oc->oc_cache->ca_size / oc->oc_obj->chunk_size / 2);
+
+	for (i = 1; i <= win; i++) {
+		if (chunk_lookup(oc, idx + i) != NULL)
+			continue;
+
+		ch = chunk_alloc(oc, idx + i, false);
+		if (ch == NULL)
+			break;
+
+		if (chunk_fetch(ch) != 0) {
+			chunk_free(ch);
+			break;
+		}
+	}
+}
+
+/**
+ * Serve a read from the cached chunks. Missing chunks are fetched if @fill is
+ * true. Returns 1 if the read hits EOF, -DER_AGAIN if it can't be served from
+ * the cache. @last_idx is set to the index of the last chunk read.
+ */
+static int
+obj_read_cached(struct dfs_obj_cache *oc, daos_sg_list_t *sgl, daos_off_t off,
+		daos_size_t len, bool fill, daos_size_t *read_size,
+		daos_off_t *last_idx)
+{
+	daos_size_t		 chunk_size = oc->oc_obj->chunk_size;
+	struct dfs_chunk	*ch;
+	daos_off_t		 idx;
+	daos_size_t		 coff, n;
+	daos_size_t		 done = 0;
+	int			 rc;
+
+	while (done < len) {
+		idx = (off + done) / chunk_size;
+		coff = (off + done) % chunk_size;
+		n = min(len - done, chunk_size - coff);
+
+		ch = chunk_lookup(oc, idx);
+		if (ch == NULL) {
+			if (!fill)
+				return -DER_AGAIN;
+
+			ch = chunk_alloc(oc, idx, false);
+			if (ch == NULL)
+				return -DER_AGAIN;
+		}
+
+		rc = chunk_wait(ch);
+		if (rc)
+			return rc;
+
+		/** not cached, or invalidated while waiting */
+		if (chunk_is_empty(ch)) {
+			if (!fill || chunk_fetch(ch) != 0) {
+				chunk_settle(ch);
+				return -DER_AGAIN;
+			}
+
+			rc = chunk_wait(ch);
+			if (rc)
+				return rc;
+			if (chunk_is_empty(ch)) {
+				chunk_settle(ch);
+				return -DER_AGAIN;
+			}
+		}
+
+		/** chunk only holds written data, read it from the array */
+		if (!ch->ch_fetched)
+			return -DER_AGAIN;
+
+		if (coff + n > ch->ch_valid) {
+			/**
+			 * The file ended in this chunk when it was fetched,
+			 * unless it has been extended by a write since.
+			 */
+			if (oc->oc_write_hi > idx * chunk_size + ch->ch_valid)
+				return -DER_AGAIN;
+
+			n = coff < ch->ch_valid ? ch->ch_valid - coff : 0;
+			sgl_copy(sgl, done, ch->ch_buf + coff, n, true);
+			chunk_lru_update(ch);
+			done += n;
+			*last_idx = idx;
+			*read_size = done;
+			/** EOF, nothing to read ahead */
+			return 1;
+		}
+
+		sgl_copy(sgl, done, ch->ch_buf + coff, n, true);
+		chunk_lru_update(ch);
+		done += n;
+		*last_idx = idx;
+	}
+
+	*read_size = done;
+	return 0;
+}
+
+/**
+ * Read from the array, after the dirty data it may cover are written. The
+ * lock is not held during the read.
+ */
+static int
+obj_read_uncached(struct dfs_obj_cache *oc, daos_sg_list_t *sgl,
+		  daos_off_t off, daos_size_t *read_size)
+{
+	struct dfs_cache	*cache = oc->oc_cache;
+	daos_size_t		 chunk_size = oc->oc_obj->chunk_size;
+	struct dfs_chunk	*ch;
+	int			 rc;
+
+	/**
+	 * Dirty data after the read offset is flushed too: it changes the
+	 * file size, hence where the read stops. The list may change while
+	 * waiting, start over after each wait.
+	 */
+again:
+	d_list_for_each_entry(ch, &oc->oc_chunks, ch_link) {
+		if ((ch->ch_idx + 1) * chunk_size <= off)
+			continue;
+
+		if (ch->ch_state == DFS_CHUNK_IDLE && chunk_is_dirty(ch)) {
+			rc = chunk_flush(ch);
+			if (rc)
+				return rc;
+		}
+
+		if (ch->ch_state == DFS_CHUNK_FLUSHING) {
+			rc = chunk_wait(ch);
+			if (rc)
+				return rc;
+			chunk_settle(ch);
+			goto again;
+		}
+	}
+
+	D_MUTEX_UNLOCK(&cache->ca_lock);
+	rc = dfs_obj_read(oc->oc_obj, *sgl, off, read_size);
+	D_MUTEX_LOCK(&cache->ca_lock);
+	return rc;
+}
+
+int
+dfs_cache_read(dfs_t *dfs, dfs_obj_t *obj, daos_sg_list_t *sgl,
+	       daos_off_t off, daos_size_t *read_size)
+{
+	struct dfs_obj_cache	*oc = obj->cache;
+	struct dfs_cache	*cache = oc->oc_cache;
+	daos_off_t		 last_idx = 0;
+	daos_size_t		 len;
+	bool			 seq;
+	int			 rc;
+
+	len = sgl_size(sgl);
+	if (len == 0) {
+		*read_size = 0;
+		return 0;
+	}
+
+	D_MUTEX_LOCK(&cache->ca_lock);
+	cache_reap(cache);
+
+	seq = (off == oc->oc_ra_next);
+	oc->oc_ra_next = off + len;
+	if (seq)
+		oc->oc_ra_win = oc->oc_ra_win == 0 ? 1 :
+				min(oc->oc_ra_win * 2, DFS_RA_MAX);
+	else
+		oc->oc_ra_win = 0;
+
+	rc = obj_read_cached(oc, sgl, off, len, seq, read_size, &last_idx);
+	if (rc == 0 && seq)
+		obj_readahead(oc, last_idx);
+	else if (rc == -DER_AGAIN)
+		rc = obj_read_uncached(oc, sgl, off, read_size);
+
+	D_MUTEX_UNLOCK(&cache->ca_lock);
+	return rc < 0 ? rc : 0;
+}
+
+int
+dfs_cache_write(dfs_t *dfs, dfs_obj_t *obj, daos_sg_list_t *sgl,
+		daos_off_t off)
+{
+	struct dfs_obj_cache	*oc = obj->cache;
+	struct dfs_cache	*cache = oc->oc_cache;
+	daos_size_t		 chunk_size = obj->chunk_size;
+	struct dfs_chunk	*ch;
+	daos_off_t		 idx;
+	daos_size_t		 len, lo, hi;
+	daos_size_t		 done = 0;
+	int			 rc = 0;
+
+	len = sgl_size(sgl);
+
+	D_MUTEX_LOCK(&cache->ca_lock);
+	cache_reap(cache);
+
+	while (done < len) {
+		idx = (off + done) / chunk_size;
+		lo = (off + done) % chunk_size;
+		hi = min(lo + len - done, chunk_size);
+
+		ch = chunk_lookup(oc, idx);
+		if (ch == NULL) {
+			ch = chunk_alloc(oc, idx, true);
+			if (ch == NULL)
+				D_GOTO(out, rc = -DER_NOMEM);
+		}
+
+		/**
+		 * The chunk buffer can't change under an I/O, and there is
+		 * one dirty extent per chunk, flush it if not contiguous. The
+		 * chunk may be dirtied again while waiting, check it again.
+		 */
+		while (1) {
+			rc = chunk_wait(ch);
+			if (rc)
+				D_GOTO(out, rc);
+			if (!chunk_is_dirty(ch) ||
+			    (lo <= ch->ch_dirty_hi && hi >= ch->ch_dirty_lo))
+				break;
+			rc = chunk_flush(ch);
+			if (rc)
+				D_GOTO(out, rc);
+		}
+
+		if (ch->ch_fetched) {
+			/** a hole between the cached data and the write */
+			if (lo > ch->ch_valid)
+				memset(ch->ch_buf + ch->ch_valid, 0,
+				       lo - ch->ch_valid);
+			ch->ch_valid = max(ch->ch_valid, hi);
+		}
+		sgl_copy(sgl, done, ch->ch_buf + lo, hi - lo, false);
+
+		if (chunk_is_dirty(ch)) {
+			ch->ch_dirty_lo = min(ch->ch_dirty_lo, lo);
+			ch->ch_dirty_hi = max(ch->ch_dirty_hi, hi);
+		} else {
+			ch->ch_dirty_lo = lo;
+			ch->ch_dirty_hi = hi;
+		}
+		chunk_lru_update(ch);
+
+		done += hi - lo;
+		oc->oc_write_hi = max(oc->oc_write_hi, off + done);
+
+		/** write a full chunk behind */
+		if (ch->ch_dirty_lo == 0 && ch->ch_dirty_hi == chunk_size) {
+			rc = chunk_flush(ch);
+			if (rc)
+				D_GOTO(out, rc);
+		}
+	}
+
+out:
+	D_MUTEX_UNLOCK(&cache->ca_lock);
+	return rc;
+}
+
+int
+dfs_cache_obj_flush(dfs_obj_t *obj, bool invalidate)
+{
+	struct dfs_obj_cache	*oc = obj->cache;
+	struct dfs_cache	*cache = oc->oc_cache;
+	int			 rc;
+
+	D_MUTEX_LOCK(&cache->ca_lock);
+	rc = obj_flush(oc, invalidate);
+	if (rc == 0)
+		rc = oc->oc_err;
+	oc->oc_err = 0;
+	D_MUTEX_UNLOCK(&cache->ca_lock);
+
+	return rc;
+}
+
+int
+dfs_cache_obj_inval(dfs_obj_t *obj, daos_array_iod_t *iod)
+{
+	struct dfs_obj_cache	*oc = obj->cache;
+	struct dfs_cache	*cache = oc->oc_cache;
+	int			 rc;
+
+	D_MUTEX_LOCK(&cache->ca_lock);
+	rc = obj_inval(oc, iod);
+	if (rc == 0)
+		rc = oc->oc_err;
+	oc->oc_err = 0;
+	D_MUTEX_UNLOCK(&cache->ca_lock);
+
+	return rc;
+}
+
+int
+dfs_cache_flush(dfs_t *dfs)
+{
+	struct dfs_cache	*cache = dfs->cache;
+	struct dfs_obj_cache	*oc;
+	int			 inflight;
+	int			 rc;
+
+	D_MUTEX_LOCK(&cache->ca_lock);
+	while (1) {
+		rc = cache_drain(cache, &inflight);
+		if (rc || inflight == 0)
+			break;
+		rc = cache_poll(cache);
+		if (rc)
+			break;
+	}
+	d_list_for_each_entry(oc, &cache->ca_objs, oc_link) {
+		if (rc == 0)
+			rc = oc->oc_err;
+		oc->oc_err = 0;
+	}
+	D_MUTEX_UNLOCK(&cache->ca_lock);
+
+	return rc;
+}
+
+void
+dfs_cache_obj_init(dfs_t *dfs, dfs_obj_t *obj)
+{
+	struct dfs_cache	*cache = dfs->cache;
+	struct dfs_obj_cache	*oc;
+
+	if (cache == NULL || !S_ISREG(obj->mode))
+		return;
+
+	/** the budget must hold a chunk being read and one read ahead */
+	if (obj->chunk_size == 0 || obj->chunk_size > cache->ca_size / 2) {
+		D_DEBUG(DB_TRACE, "chunk size %zu too large to cache\n",
+			obj->chunk_size);
+		return;
+	}
+
+	/** the file is just not cached if this fails */
+	D_ALLOC_PTR(oc);
+	if (oc == NULL)
+		return;
+
+	D_INIT_LIST_HEAD(&oc->oc_chunks);
+	oc->oc_cache = cache;
+	oc->oc_obj = obj;
+
+	D_MUTEX_LOCK(&cache->ca_lock);
+	d_list_add_tail(&oc->oc_link, &cache->ca_objs);
+	D_MUTEX_UNLOCK(&cache->ca_lock);
+
+	obj->cache = oc;
+}
+
+int
+dfs_cache_obj_fini(dfs_obj_t *obj)
+{
+	struct dfs_obj_cache	*oc = obj->cache;
+	struct dfs_cache	*cache = oc->oc_cache;
+	int			 rc;
+
+	D_MUTEX_LOCK(&cache->ca_lock);
+	rc = obj_flush(oc, true);
+	if (rc == 0)
+		rc = oc->oc_err;
+	d_list_del(&oc->oc_link);
+	D_MUTEX_UNLOCK(&cache->ca_lock);
+
+	D_ASSERT(d_list_empty(&oc->oc_chunks));
+	D_FREE(oc);
+	obj->cache = NULL;
+	return rc;
+}
+
+int
+dfs_cache_create(dfs_t *dfs, daos_size_t size)
+{
+	struct dfs_cache	*cache;
+	int			 rc;
+
+	D_ASSERT(dfs->cache == NULL);
+
+	D_ALLOC_PTR(cache);
+	if (cache == NULL)
+		return -DER_NOMEM;
+
+	rc = D_MUTEX_INIT(&cache->ca_lock, NULL);
+	if (rc)
+		D_GOTO(err_cache, rc);
+
+	rc = pthread_cond_init(&cache->ca_cond, NULL);
+	if (rc) {
+		D_ERROR("pthread_cond_init() failed (%d)\n", rc);
+		D_GOTO(err_lock, rc = daos_errno2der(rc));
+	}
+
+	rc = daos_eq_create(&cache->ca_eqh);
+	if (rc) {
+		D_ERROR("daos_eq_create() failed (%d)\n", rc);
+		D_GOTO(err_cond, rc);
+	}
+
+	D_INIT_LIST_HEAD(&cache->ca_objs);
+	D_INIT_LIST_HEAD(&cache->ca_lru);
+	cache->ca_size = size;
+	dfs->cache = cache;
+	return 0;
+
+err_cond:
+	pthread_cond_destroy(&cache->ca_cond);
+err_lock:
+	D_MUTEX_DESTROY(&cache->ca_lock);
+err_cache:
+	D_FREE(cache);
+	return rc;
+}
+
+int
+dfs_cache_resize(dfs_t *dfs, daos_size_t size)
+{
+	struct dfs_cache *cache = dfs->cache;
+
+	/** chunks above the new budget are evicted by the next allocations */
+	D_MUTEX_LOCK(&cache->ca_lock);
+	cache->ca_size = size;
+	D_MUTEX_UNLOCK(&cache->ca_lock);
+	return 0;
+}
+
+int
+dfs_cache_destroy(dfs_t *dfs)
+{
+	struct dfs_cache	*cache = dfs->cache;
+	int			 rc;
+
+	if (!d_list_empty(&cache->ca_objs)) {
+		D_ERROR("Cached files are still open\n");
+		return -DER_BUSY;
+	}
+	D_ASSERT(cache->ca_used == 0);
+
+	rc = daos_eq_destroy(cache->ca_eqh, 0);
+	if (rc) {
+		D_ERROR("daos_eq_destroy() failed (%d)\n", rc);
+		return rc;
+	}
+
+	pthread_cond_destroy(&cache->ca_cond);
+	D_MUTEX_DESTROY(&cache->ca_lock);
+	D_FREE(cache);
+	dfs->cache = NULL;
+	return 0;
+}
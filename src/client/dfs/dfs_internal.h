@@ -0,0 +1,106 @@
+/**
+ * (C) Copyright 2018 Intel Corporation.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * GOVERNMENT LICENSE RIGHTS-OPEN SOURCE SOFTWARE
+ * The Government's rights to use, modify, reproduce, release, perform, display,
+ * or disclose this software are subject to the terms of the Apache License as
+ * provided in Contract No. B609815.
+ * Any reproduction of computer software, computer software documentation, or
+ * portions thereof marked with this legend must also reproduce the markings.
+ */
+/**
+ * DFS internal data structures and routines.
+ */
+
+#ifndef __DFS_INTERNAL_H__
+#define __DFS_INTERNAL_H__
+
+#include <pthread.h>
+#include <sys/stat.h>
+#include <daos_types.h>
+#include <daos_fs.h>
+
+struct dfs_cache;
+struct dfs_obj_cache;
+
+/** object struct that is instantiated for a DFS open object */
+struct dfs_obj {
+	/** DAOS object ID */
+	daos_obj_id_t		oid;
+	/** DAOS object open handle */
+	daos_handle_t		oh;
+	/** mode_t containing permissions & type */
+	mode_t			mode;
+	/** DAOS object ID of the parent of the object */
+	daos_obj_id_t		parent_oid;
+	/** entry name of the object in the parent */
+	char			name[DFS_MAX_PATH];
+	/** Symlink value if object is a symbolic link */
+	char			*value;
+	/** Array chunk (dkey) size if object is a regular file */
+	daos_size_t		chunk_size;
+	/** Client cache of the file data, NULL if not cached */
+	struct dfs_obj_cache	*cache;
+};
+
+/** dfs struct that is instantiated for a mounted DFS namespace */
+struct dfs {
+	/** flag to indicate whether the dfs is mounted */
+	bool			mounted;
+	/** lock for threadsafety */
+	pthread_mutex_t		lock;
+	/** uid - inherited from pool. TODO - make this from container. */
+	uid_t			uid;
+	/** gid - inherited from pool. TODO - make this from container. */
+	gid_t			gid;
+	/** Access mode (RDONLY, RDWR) */
+	int			amode;
+	/** Open pool handle of the DFS */
+	daos_handle_t		poh;
+	/** Open container handle of the DFS */
+	daos_handle_t		coh;
+	/** Object ID reserved for this DFS (see oid_gen below) */
+	daos_obj_id_t		oid;
+	/** OID of SB */
+	daos_obj_id_t		super_oid;
+	/** Open object handle of SB */
+	daos_handle_t		super_oh;
+	/** Root object info */
+	dfs_obj_t		root;
+	/** Client data cache, NULL if disabled (see dfs_cache.c) */
+	struct dfs_cache	*cache;
+};
+
+/** dfs.c */
+int dfs_obj_read(dfs_obj_t *obj, daos_sg_list_t sgl, daos_off_t off,
+		 daos_size_t *read_size);
+int dfs_obj_readx(dfs_obj_t *obj, daos_array_iod_t *iod, daos_sg_list_t *sgl,
+		  daos_size_t *read_size, daos_event_t *ev);
+
+/** dfs_cache.c */
+int dfs_cache_create(dfs_t *dfs, daos_size_t size);
+int dfs_cache_resize(dfs_t *dfs, daos_size_t size);
+int dfs_cache_destroy(dfs_t *dfs);
+void dfs_cache_obj_init(dfs_t *dfs, dfs_obj_t *obj);
+int dfs_cache_obj_fini(dfs_obj_t *obj);
+int dfs_cache_obj_flush(dfs_obj_t *obj, bool invalidate);
+int dfs_cache_obj_inval(dfs_obj_t *obj, daos_array_iod_t *iod);
+int dfs_cache_flush(dfs_t *dfs);
+int dfs_cache_read(dfs_t *dfs, dfs_obj_t *obj, daos_sg_list_t *sgl,
+		   daos_off_t off, daos_size_t *read_size);
+int dfs_cache_write(dfs_t *dfs, dfs_obj_t *obj, daos_sg_list_t *sgl,
+		    daos_off_t off);
+
+#endif /* __DFS_INTERNAL_H__ */
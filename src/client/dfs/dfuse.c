@@ -23,7 +23,7 @@
 
 #define D_LOGFAC	DD_FAC(dfs)
 
-#include <fuse3/fuse.h>
+#include <fuse3/fuse_lowlevel.h>
 #include <string.h>
 #include <errno.h>
 #include <stdio.h>
@@ -32,11 +32,13 @@
 #include <sys/stat.h>
 #include <unistd.h>
 #include <fcntl.h>
-#include <libgen.h>
+#include <poll.h>
+#include <time.h>
 
 #include <daos/common.h>
 #include "daos_fs.h"
 #include "daos_api.h"
+#include "daos_event.h"
 
 struct dfuse_data {
 	int		show_help;
@@ -49,7 +51,17 @@ struct dfuse_data {
 	char		*pool;
 	char		*svcl;
 	char		*group;
-	struct fuse	*fuse;
+	/** kernel cache timeouts (in seconds) of dentry, attr & negative */
+	double		entry_timeout;
+	double		attr_timeout;
+	double		neg_timeout;
+	/** max in-flight I/Os, 0 for synchronous I/O */
+	unsigned int	async;
+	/** DFS data cache budget in MiB, 0 to disable */
+	unsigned int	cache_size;
+	unsigned int	io_inflight;
+	daos_handle_t	eqh;
+	struct fuse_session *se;
 };
 
 static struct dfuse_data dfuse_fs;
@@ -281,6 +293,8 @@ error_convert(int error)
 		return -ENOTDIR;
 	case -DER_STALE:
 		return -ESTALE;
+	case -DER_NOSYS:
+		return -ENOSYS;
 	case -DER_OOG:
 	case -DER_HG:
 	case -DER_UNREG:
@@ -288,468 +302,882 @@ error_convert(int error)
 	case -DER_MISC:
 	case -DER_NOTATTACH:
 	case -DER_NOREPLY:
-		return error;
 	default:
-		return error;
+		/** never hand a DER code to the kernel */
+		return -EIO;
 	}
 }
 
-static int
-parse_filename(const char *path, char **_obj_name, char **_cont_name)
+static inline void
+dfuse_reply_err(fuse_req_t req, int rc)
 {
-	char *f1 = NULL;
-	char *f2 = NULL;
-	char *fname = NULL;
-	char *cont_name = NULL;
-	int rc = 0;
+	fuse_reply_err(req, -error_convert(rc));
+}
 
-	if (path == NULL || _obj_name == NULL || _cont_name == NULL)
-		return -EINVAL;
+/*
+ * Inode table.
+ *
+ * Every inode the kernel knows about holds an open DFS object, so operations
+ * on it go straight to the object instead of walking the path from the root
+ * again. The FUSE node ID is the address of the inode (FUSE_ROOT_ID for the
+ * root). Files and directories are also hashed by object ID so one object is
+ * always represented by one inode; symlinks have no object ID and get a new
+ * inode on each lookup.
+ *
+ * An inode is referenced by the kernel lookups and by its child inodes, it's
+ * freed when the kernel forgets it and no child is left.
+ */
+struct dfuse_inode {
+	/** link in the object ID hash table */
+	d_list_t		 ie_htl;
+	/** link in the list of all inodes */
+	d_list_t		 ie_link;
+	/** open DFS object */
+	dfs_obj_t		*ie_obj;
+	/** DAOS object ID, zero for symlink */
+	daos_obj_id_t		 ie_oid;
+	/** parent inode, NULL for the root */
+	struct dfuse_inode	*ie_parent;
+	/** entry name in the parent */
+	char			 ie_name[DFS_MAX_PATH];
+	/** inode number reported in st_ino, never reused in a mount */
+	ino_t			 ie_stino;
+	/** kernel lookup count + number of child inodes + in-flight I/Os */
+	uint64_t		 ie_ref;
+	/** is the inode in the object ID hash table */
+	bool			 ie_hashed;
+};
 
-	if (strcmp(path, "/") == 0) {
-		*_cont_name = strdup("/");
-		if (*_cont_name == NULL)
-			return -ENOMEM;
-		*_obj_name = NULL;
-		return 0;
-	}
+/** st_ino of the directory entries which are not looked up */
+#define DFUSE_UNKNOWN_INO	0xffffffff
 
-	f1 = strdup(path);
-	if (f1 == NULL)
-		D_GOTO(out, rc = -ENOMEM);
+static struct d_hash_table	*dfuse_ie_hash;
+static d_list_t			 dfuse_ie_list;
+static struct dfuse_inode	*dfuse_root;
+static ino_t			 dfuse_next_stino = FUSE_ROOT_ID + 1;
 
-	f2 = strdup(path);
-	if (f2 == NULL)
-		D_GOTO(out, rc = -ENOMEM);
+static inline struct dfuse_inode *
+dfuse_ie_obj(d_list_t *rlink)
+{
+	return container_of(rlink, struct dfuse_inode, ie_htl);
+}
 
-	fname = basename(f1);
-	cont_name = dirname(f2);
+static bool
+dfuse_ie_key_cmp(struct d_hash_table *htable, d_list_t *rlink,
+		 const void *key, unsigned int ksize)
+{
+	struct dfuse_inode *ie = dfuse_ie_obj(rlink);
 
-	if (cont_name[0] == '.' || cont_name[0] != '/') {
-		char cwd[1024];
+	D_ASSERTF(ksize == sizeof(daos_obj_id_t), "%u\n", ksize);
+	return memcmp(&ie->ie_oid, key, ksize) == 0;
+}
 
-		if (getcwd(cwd, 1024) == NULL)
-			D_GOTO(out, rc = -ENOMEM);
+static d_hash_table_ops_t dfuse_ie_hash_ops = {
+	.hop_key_cmp	= dfuse_ie_key_cmp,
+};
 
-		if (strcmp(cont_name, ".") == 0) {
-			cont_name = strdup(cwd);
-			if (cont_name == NULL)
-				D_GOTO(out, rc = -ENOMEM);
-		} else {
-			char *new_dir = calloc(strlen(cwd) + strlen(cont_name)
-					       + 1, sizeof(char));
-			if (new_dir == NULL)
-				D_GOTO(out, rc = -ENOMEM);
-
-			strcpy(new_dir, cwd);
-			if (cont_name[0] == '.') {
-				strcat(new_dir, &cont_name[1]);
-			} else {
-				strcat(new_dir, "/");
-				strcat(new_dir, cont_name);
-			}
-			cont_name = new_dir;
-		}
-		*_cont_name = cont_name;
+static inline fuse_ino_t
+dfuse_ie2ino(struct dfuse_inode *ie)
+{
+	return ie == dfuse_root ? FUSE_ROOT_ID : (fuse_ino_t)(uintptr_t)ie;
+}
+
+static inline struct dfuse_inode *
+dfuse_ino2ie(fuse_ino_t ino)
+{
+	return ino == FUSE_ROOT_ID ? dfuse_root :
+	       (struct dfuse_inode *)(uintptr_t)ino;
+}
+
+/**
+ * Parent object and entry name of an inode, both NULL for the root.
+ * An unlinked inode has no entry anymore.
+ */
+static inline int
+dfuse_ie_entry(struct dfuse_inode *ie, dfs_obj_t **parent, const char **name)
+{
+	if (ie == dfuse_root) {
+		*parent = NULL;
+		*name = NULL;
 	} else {
-		*_cont_name = strdup(cont_name);
-		if (*_cont_name == NULL)
-			D_GOTO(out, rc = -ENOMEM);
+		if (ie->ie_parent == NULL)
+			return -DER_NONEXIST;
+		*parent = ie->ie_parent->ie_obj;
+		*name = ie->ie_name;
 	}
+	return 0;
+}
 
-	*_obj_name = strdup(fname);
-	if (*_obj_name == NULL) {
-		free(*_cont_name);
-		*_cont_name = NULL;
-		D_GOTO(out, rc = -ENOMEM);
+static void
+dfuse_ie_free(struct dfuse_inode *ie)
+{
+	if (ie->ie_hashed)
+		d_hash_rec_delete_at(dfuse_ie_hash, &ie->ie_htl);
+	d_list_del(&ie->ie_link);
+	dfs_release(ie->ie_obj);
+	D_FREE(ie);
+}
+
+/** Drop @nref references of an inode, release the parent on the last one */
+static void
+dfuse_ie_put(struct dfuse_inode *ie, uint64_t nref)
+{
+	struct dfuse_inode *parent;
+
+	while (ie != NULL && ie != dfuse_root) {
+		D_ASSERTF(ie->ie_ref >= nref, DF_U64" < "DF_U64"\n",
+			  ie->ie_ref, nref);
+		ie->ie_ref -= nref;
+		if (ie->ie_ref > 0)
+			return;
+
+		parent = ie->ie_parent;
+		dfuse_ie_free(ie);
+		ie = parent;
+		nref = 1;
 	}
+}
 
-out:
-	if (f1)
-		free(f1);
-	if (f2)
-		free(f2);
-	return rc;
+static void
+dfuse_ie_set_parent(struct dfuse_inode *ie, struct dfuse_inode *parent,
+		    const char *name)
+{
+	struct dfuse_inode *old = ie->ie_parent;
+
+	parent->ie_ref++;
+	ie->ie_parent = parent;
+	snprintf(ie->ie_name, sizeof(ie->ie_name), "%s", name);
+	if (old != NULL)
+		dfuse_ie_put(old, 1);
 }
 
+/*
+ * Find or create the inode of an object just looked up as @name in @parent
+ * and take a kernel lookup reference on it. @obj is consumed.
+ */
 static int
-dfuse_access(const char *path, int mask)
+dfuse_ie_get(struct dfuse_inode *parent, const char *name, dfs_obj_t *obj,
+	     struct dfuse_inode **iep)
 {
-	char		*name = NULL, *dir_name = NULL;
-	dfs_obj_t	*parent = NULL;
-	mode_t		pmode;
-	int		rc;
+	struct dfuse_inode	*ie;
+	d_list_t		*rlink;
+	daos_obj_id_t		 oid;
+	mode_t			 mode;
+	int			 rc;
 
-	FUNC_ENTER("path = %s\n", path);
+	dfs_obj2id(obj, &oid);
+	dfs_get_mode(obj, &mode);
 
-	if (path == NULL)
-		return -ENOENT;
+	if (!S_ISLNK(mode)) {
+		rlink = d_hash_rec_find(dfuse_ie_hash, &oid, sizeof(oid));
+		if (rlink != NULL) {
+			ie = dfuse_ie_obj(rlink);
+			dfs_release(obj);
+			ie->ie_ref++;
+
+			/* it has been moved by someone else */
+			if (ie->ie_parent != parent ||
+			    strcmp(ie->ie_name, name) != 0) {
+				dfs_update_parent(ie->ie_obj, parent->ie_obj,
+						  name);
+				dfuse_ie_set_parent(ie, parent, name);
+			}
+			*iep = ie;
+			return 0;
+		}
+	}
 
-	rc = parse_filename(path, &name, &dir_name);
-	if (rc)
-		return rc;
+	D_ALLOC_PTR(ie);
+	if (ie == NULL) {
+		dfs_release(obj);
+		return -DER_NOMEM;
+	}
 
-	if (strcmp(dir_name, "/") != 0) {
-		rc = dfs_lookup(dfs, dir_name, O_RDONLY, &parent, &pmode);
-		if (rc) {
-			fprintf(stderr, "Failed to lookup path %s (%d)\n",
-				dir_name, rc);
-			D_GOTO(out, rc);
-		}
-		if (!S_ISDIR(pmode)) {
-			fprintf(stderr, "%s does not resolve to a dir\n",
-				dir_name);
-			D_GOTO(out, rc = -DER_INVAL);
-		}
+	D_INIT_LIST_HEAD(&ie->ie_htl);
+	ie->ie_obj = obj;
+	ie->ie_oid = oid;
+	ie->ie_stino = dfuse_next_stino++;
+	ie->ie_ref = 1;
+	dfuse_ie_set_parent(ie, parent, name);
+	d_list_add(&ie->ie_link, &dfuse_ie_list);
+
+	if (!S_ISLNK(mode)) {
+		rc = d_hash_rec_insert(dfuse_ie_hash, &ie->ie_oid,
+				       sizeof(ie->ie_oid), &ie->ie_htl, true);
+		D_ASSERTF(rc == 0, "%d\n", rc);
+		ie->ie_hashed = true;
 	}
 
-	rc = dfs_access(dfs, parent, name, mask);
+	*iep = ie;
+	return 0;
+}
 
-out:
-	if (name)
-		free(name);
-	if (dir_name)
-		free(dir_name);
-	if (parent)
-		dfs_release(parent);
-	return error_convert(rc);
+/** Find the inode of an object which is going to be moved from @parent */
+static struct dfuse_inode *
+dfuse_ie_find(dfs_obj_t *obj, struct dfuse_inode *parent, const char *name)
+{
+	struct dfuse_inode	*ie;
+	d_list_t		*rlink;
+	daos_obj_id_t		 oid;
+	mode_t			 mode;
+
+	dfs_get_mode(obj, &mode);
+	if (!S_ISLNK(mode)) {
+		dfs_obj2id(obj, &oid);
+		rlink = d_hash_rec_find(dfuse_ie_hash, &oid, sizeof(oid));
+		return rlink == NULL ? NULL : dfuse_ie_obj(rlink);
+	}
+
+	/* symlinks are not hashed, moving them is rare enough to scan */
+	d_list_for_each_entry(ie, &dfuse_ie_list, ie_link) {
+		if (!ie->ie_hashed && ie->ie_parent == parent &&
+		    strcmp(ie->ie_name, name) == 0)
+			return ie;
+	}
+	return NULL;
 }
 
-static int
-dfuse_chmod(const char *path, mode_t mode, struct fuse_file_info *fi)
+static void
+dfuse_ie_move(struct dfuse_inode *ie, struct dfuse_inode *parent,
+	      const char *name)
 {
-	char		*name = NULL, *dir_name = NULL;
-	dfs_obj_t	*parent = NULL;
-	mode_t		pmode;
-	int		rc;
+	if (ie == NULL)
+		return;
+
+	dfs_update_parent(ie->ie_obj, parent->ie_obj, name);
+	dfuse_ie_set_parent(ie, parent, name);
+}
 
-	FUNC_ENTER("path = %s\n", path);
+/**
+ * Detach the inode of a removed or replaced entry from its parent, it stays
+ * valid for the open handles until the kernel forgets it.
+ */
+static void
+dfuse_ie_unlink(struct dfuse_inode *ie)
+{
+	struct dfuse_inode *old;
 
-#if 0
-	/** TODO - maybe add a dfs_fchmod() for this */
-	if (fi != NULL) {
-		rc = dfs_chmod(dfs, (dfs_obj_t *)fi->fh, mode);
-		return error_convert(rc);
+	if (ie == NULL || ie->ie_parent == NULL)
+		return;
+
+	/* a new object can't have the same ID, but don't find it by mistake */
+	if (ie->ie_hashed) {
+		d_hash_rec_delete_at(dfuse_ie_hash, &ie->ie_htl);
+		ie->ie_hashed = false;
 	}
-#endif
 
-	if (path == NULL)
-		return -ENOENT;
+	old = ie->ie_parent;
+	ie->ie_parent = NULL;
+	ie->ie_name[0] = '\0';
+	dfuse_ie_put(old, 1);
+}
 
-	rc = parse_filename(path, &name, &dir_name);
+static int
+dfuse_ie_table_init(void)
+{
+	dfs_obj_t	*root;
+	int		 rc;
+
+	D_INIT_LIST_HEAD(&dfuse_ie_list);
+	rc = d_hash_table_create(D_HASH_FT_NOLOCK, 16 /* bits */,
+				 NULL /* priv */, &dfuse_ie_hash_ops,
+				 &dfuse_ie_hash);
 	if (rc)
 		return rc;
 
-	if (strcmp(dir_name, "/") != 0) {
-		rc = dfs_lookup(dfs, dir_name, O_RDWR, &parent, &pmode);
-		if (rc) {
-			fprintf(stderr, "Failed to lookup path %s (%d)\n",
-				dir_name, rc);
-			D_GOTO(out, rc);
-		}
-		if (!S_ISDIR(pmode)) {
-			fprintf(stderr, "%s does not resolve to a dir\n",
-				dir_name);
-			D_GOTO(out, rc = -DER_INVAL);
-		}
+	rc = dfs_lookup(dfs, "/", O_RDWR, &root, NULL);
+	if (rc)
+		D_GOTO(err_hash, rc);
+
+	D_ALLOC_PTR(dfuse_root);
+	if (dfuse_root == NULL) {
+		dfs_release(root);
+		D_GOTO(err_hash, rc = -DER_NOMEM);
 	}
 
-	rc = dfs_chmod(dfs, parent, name, mode);
+	D_INIT_LIST_HEAD(&dfuse_root->ie_htl);
+	dfuse_root->ie_obj = root;
+	dfs_obj2id(root, &dfuse_root->ie_oid);
+	strcpy(dfuse_root->ie_name, "/");
+	dfuse_root->ie_stino = FUSE_ROOT_ID;
+	dfuse_root->ie_ref = 1;
+	d_list_add(&dfuse_root->ie_link, &dfuse_ie_list);
+
+	rc = d_hash_rec_insert(dfuse_ie_hash, &dfuse_root->ie_oid,
+			       sizeof(dfuse_root->ie_oid), &dfuse_root->ie_htl,
+			       true);
+	D_ASSERTF(rc == 0, "%d\n", rc);
+	dfuse_root->ie_hashed = true;
+	return 0;
 
-out:
-	if (name)
-		free(name);
-	if (dir_name)
-		free(dir_name);
-	if (parent)
-		dfs_release(parent);
-	return error_convert(rc);
+err_hash:
+	d_hash_table_destroy(dfuse_ie_hash, true);
+	dfuse_ie_hash = NULL;
+	return rc;
 }
 
-static int
-dfuse_getattr(const char *path, struct stat *stbuf, struct fuse_file_info *fi)
+static void
+dfuse_ie_table_fini(void)
 {
-	char *name = NULL, *dir_name = NULL;
-	dfs_obj_t *parent = NULL;
-	mode_t pmode;
-	int rc;
+	struct dfuse_inode *ie, *tmp;
 
-	FUNC_ENTER("path = %s\n", path);
+	d_list_for_each_entry_safe(ie, tmp, &dfuse_ie_list, ie_link)
+		dfuse_ie_free(ie);
+	dfuse_root = NULL;
 
-	if (fi != NULL) {
-		rc = dfs_ostat(dfs, (dfs_obj_t *)fi->fh, stbuf);
-		return error_convert(rc);
-	}
+	d_hash_table_destroy(dfuse_ie_hash, true);
+	dfuse_ie_hash = NULL;
+}
 
-	if (path == NULL)
-		return -ENOENT;
+/** Look up @name in @parent and reply the entry with its attributes */
+static void
+dfuse_reply_entry(fuse_req_t req, struct dfuse_inode *parent, const char *name)
+{
+	struct fuse_entry_param	entry = {0};
+	struct dfuse_inode	*ie;
+	dfs_obj_t		*obj;
+	int			 rc;
+
+	rc = dfs_lookup_rel(dfs, parent->ie_obj, name, O_RDWR, &obj, NULL,
+			    &entry.attr);
+	if (rc == -DER_NONEXIST && dfuse_fs.neg_timeout > 0) {
+		/* let the kernel cache the negative dentry */
+		entry.ino = 0;
+		entry.entry_timeout = dfuse_fs.neg_timeout;
+		fuse_reply_entry(req, &entry);
+		return;
+	}
+	if (rc)
+		D_GOTO(err, rc);
 
-	rc = parse_filename(path, &name, &dir_name);
+	rc = dfuse_ie_get(parent, name, obj, &ie);
 	if (rc)
-		return rc;
+		D_GOTO(err, rc);
+
+	entry.ino = dfuse_ie2ino(ie);
+	entry.attr.st_ino = ie->ie_stino;
+	entry.attr_timeout = dfuse_fs.attr_timeout;
+	entry.entry_timeout = dfuse_fs.entry_timeout;
+	fuse_reply_entry(req, &entry);
+	return;
+err:
+	dfuse_reply_err(req, rc);
+}
+
+static void
+dfuse_init(void *userdata, struct fuse_conn_info *conn)
+{
+	if (conn->capable & FUSE_CAP_READDIRPLUS)
+		conn->want |= FUSE_CAP_READDIRPLUS;
+}
+
+static void
+dfuse_lookup(fuse_req_t req, fuse_ino_t parent, const char *name)
+{
+	FUNC_ENTER("parent = %lu, name = %s\n", (unsigned long)parent, name);
+
+	/* the kernel resolves these itself, except for exported fs */
+	if (strcmp(name, ".") == 0 || strcmp(name, "..") == 0) {
+		fuse_reply_err(req, ENOTSUP);
+		return;
+	}
+
+	dfuse_reply_entry(req, dfuse_ino2ie(parent), name);
+}
+
+static void
+dfuse_forget(fuse_req_t req, fuse_ino_t ino, uint64_t nlookup)
+{
+	FUNC_ENTER("ino = %lu, nlookup = "DF_U64"\n", (unsigned long)ino,
+		   nlookup);
+
+	dfuse_ie_put(dfuse_ino2ie(ino), nlookup);
+	fuse_reply_none(req);
+}
+
+static void
+dfuse_forget_multi(fuse_req_t req, size_t count,
+		   struct fuse_forget_data *forgets)
+{
+	size_t i;
+
+	FUNC_ENTER("count = %zu\n", count);
 
-	rc = dfs_lookup(dfs, dir_name, O_RDONLY, &parent, &pmode);
+	for (i = 0; i < count; i++)
+		dfuse_ie_put(dfuse_ino2ie(forgets[i].ino), forgets[i].nlookup);
+	fuse_reply_none(req);
+}
+
+static void
+dfuse_access(fuse_req_t req, fuse_ino_t ino, int mask)
+{
+	dfs_obj_t	*parent;
+	const char	*name;
+	int		rc;
+
+	FUNC_ENTER("ino = %lu\n", (unsigned long)ino);
+
+	rc = dfuse_ie_entry(dfuse_ino2ie(ino), &parent, &name);
+	if (rc == 0)
+		rc = dfs_access(dfs, parent, name, mask);
+	dfuse_reply_err(req, rc);
+}
+
+static void
+dfuse_getattr(fuse_req_t req, fuse_ino_t ino, struct fuse_file_info *fi)
+{
+	struct dfuse_inode	*ie = dfuse_ino2ie(ino);
+	struct stat		stbuf;
+	int			rc;
+
+	FUNC_ENTER("ino = %lu\n", (unsigned long)ino);
+
+	rc = dfs_ostat(dfs, ie->ie_obj, &stbuf);
 	if (rc) {
-		fprintf(stderr, "Failed path lookup %s (%d)\n", dir_name, rc);
-		D_GOTO(out, rc);
+		dfuse_reply_err(req, rc);
+		return;
 	}
-	if (!S_ISDIR(pmode)) {
-		fprintf(stderr, "%s does not resolve to a dir\n", dir_name);
-		D_GOTO(out, rc = -DER_INVAL);
+
+	stbuf.st_ino = ie->ie_stino;
+	fuse_reply_attr(req, &stbuf, dfuse_fs.attr_timeout);
+}
+
+static void
+dfuse_setattr(fuse_req_t req, fuse_ino_t ino, struct stat *attr, int to_set,
+	      struct fuse_file_info *fi)
+{
+	struct dfuse_inode	*ie = dfuse_ino2ie(ino);
+	dfs_obj_t		*parent;
+	const char		*name;
+	time_t			 now = time(NULL);
+	time_t			 atime, mtime;
+	int			 rc;
+
+	FUNC_ENTER("ino = %lu, to_set = %x\n", (unsigned long)ino, to_set);
+
+	/* DFS has a single owner, check before changing anything */
+	if (to_set & (FUSE_SET_ATTR_UID | FUSE_SET_ATTR_GID)) {
+		fuse_reply_err(req, ENOTSUP);
+		return;
 	}
 
-	rc = dfs_stat(dfs, parent, name, stbuf);
-	if (rc)
-		D_GOTO(out, rc);
+	if (to_set & (FUSE_SET_ATTR_MODE | FUSE_SET_ATTR_ATIME |
+		      FUSE_SET_ATTR_MTIME)) {
+		rc = dfuse_ie_entry(ie, &parent, &name);
+		if (rc)
+			D_GOTO(err, rc);
+	}
 
-out:
-	if (name)
-		free(name);
-	if (dir_name)
-		free(dir_name);
-	if (parent)
-		dfs_release(parent);
-	return error_convert(rc);
+	if (to_set & FUSE_SET_ATTR_MODE) {
+		rc = dfs_chmod(dfs, parent, name, attr->st_mode);
+		if (rc)
+			D_GOTO(err, rc);
+	}
+
+	if (to_set & FUSE_SET_ATTR_SIZE) {
+		rc = dfs_punch(dfs, ie->ie_obj, attr->st_size, DFS_MAX_FSIZE);
+		if (rc)
+			D_GOTO(err, rc);
+	}
+
+	if (to_set & (FUSE_SET_ATTR_ATIME | FUSE_SET_ATTR_MTIME)) {
+		atime = (to_set & FUSE_SET_ATTR_ATIME_NOW) ?
+			now : attr->st_atime;
+		mtime = (to_set & FUSE_SET_ATTR_MTIME_NOW) ?
+			now : attr->st_mtime;
+		rc = dfs_utimes(dfs, parent, name,
+				(to_set & FUSE_SET_ATTR_ATIME) ? &atime : NULL,
+				(to_set & FUSE_SET_ATTR_MTIME) ? &mtime : NULL);
+		if (rc)
+			D_GOTO(err, rc);
+	}
+
+	dfuse_getattr(req, ino, fi);
+	return;
+err:
+	dfuse_reply_err(req, rc);
 }
 
-static int
-dfuse_truncate(const char *path, off_t size, struct fuse_file_info *fi)
+static void
+dfuse_readlink(fuse_req_t req, fuse_ino_t ino)
 {
-	dfs_obj_t *obj = NULL;
-	int rc;
+	char		buf[DFS_MAX_PATH];
+	daos_size_t	size = DFS_MAX_PATH;
+	int		rc;
 
-	FUNC_ENTER("path = %s\n", path);
+	FUNC_ENTER("ino = %lu\n", (unsigned long)ino);
 
-	if (fi != NULL) {
-		rc = dfs_punch(dfs, (dfs_obj_t *)fi->fh, size, DFS_MAX_FSIZE);
-		return error_convert(rc);
+	rc = dfs_get_symlink_value(dfuse_ino2ie(ino)->ie_obj, buf, &size);
+	if (rc) {
+		dfuse_reply_err(req, rc);
+		return;
 	}
 
-	if (path == NULL)
-		return -ENOENT;
+	fuse_reply_readlink(req, buf);
+}
 
-	rc = dfs_lookup(dfs, path, O_RDWR, &obj, NULL);
-	if (rc)
-		D_GOTO(out, rc);
+static void
+dfuse_mkdir(fuse_req_t req, fuse_ino_t parent, const char *name, mode_t mode)
+{
+	struct dfuse_inode	*pie = dfuse_ino2ie(parent);
+	int			rc;
+
+	FUNC_ENTER("parent = %lu, name = %s\n", (unsigned long)parent, name);
+
+	rc = dfs_mkdir(dfs, pie->ie_obj, name, mode);
+	if (rc) {
+		dfuse_reply_err(req, rc);
+		return;
+	}
+
+	dfuse_reply_entry(req, pie, name);
+}
+
+static void
+dfuse_symlink(fuse_req_t req, const char *value, fuse_ino_t parent,
+	      const char *name)
+{
+	struct dfuse_inode	*pie = dfuse_ino2ie(parent);
+	dfs_obj_t		*sym;
+	int			rc;
+
+	FUNC_ENTER("value = %s, parent = %lu, name = %s\n", value,
+		   (unsigned long)parent, name);
+
+	rc = dfs_open(dfs, pie->ie_obj, name, S_IFLNK, O_CREAT, 0, value,
+		      &sym);
+	if (rc) {
+		dfuse_reply_err(req, rc);
+		return;
+	}
+	dfs_release(sym);
+
+	dfuse_reply_entry(req, pie, name);
+}
 
-	rc = dfs_punch(dfs, obj, size, DFS_MAX_FSIZE);
+static void
+dfuse_unlink(fuse_req_t req, fuse_ino_t parent, const char *name)
+{
+	struct dfuse_inode	*pie = dfuse_ino2ie(parent);
+	dfs_obj_t		*obj;
+	int			rc;
+
+	FUNC_ENTER("parent = %lu, name = %s\n", (unsigned long)parent, name);
+
+	/* resolve the object to detach its inode once the entry is gone */
+	rc = dfs_lookup_rel(dfs, pie->ie_obj, name, O_RDONLY, &obj, NULL,
+			    NULL);
 	if (rc)
 		D_GOTO(out, rc);
 
+	rc = dfs_remove(dfs, pie->ie_obj, name, false);
+	if (rc)
+		fprintf(stderr, "Failed to remove %s (%d)\n", name, rc);
+	else
+		dfuse_ie_unlink(dfuse_ie_find(obj, pie, name));
+	dfs_release(obj);
 out:
-	if (obj)
-		dfs_release(obj);
-	return error_convert(rc);
+	dfuse_reply_err(req, rc);
 }
 
-#define NUM_DIRENTS 10
-
-static int
-dfuse_readdir(const char *path, void *buf, fuse_fill_dir_t filler,
-	      off_t offset, struct fuse_file_info *fi,
-	      enum fuse_readdir_flags flags)
+static void
+dfuse_rename(fuse_req_t req, fuse_ino_t parent, const char *name,
+	     fuse_ino_t newparent, const char *newname, unsigned int flags)
 {
-	dfs_obj_t	*obj = NULL;
-	bool		 release = false;
-	daos_anchor_t	 anchor = {0};
-	int rc;
+	struct dfuse_inode	*pie = dfuse_ino2ie(parent);
+	struct dfuse_inode	*npie = dfuse_ino2ie(newparent);
+	struct dfuse_inode	*ie, *new_ie = NULL;
+	dfs_obj_t		*obj = NULL, *new_obj = NULL;
+	int			rc;
 
-	(void) offset;
-	(void) fi;
+	FUNC_ENTER("old = %s, new = %s\n", name, newname);
 
-	FUNC_ENTER("path = %s\n", path);
+	/* resolve the objects being moved to fix up their inodes after */
+	rc = dfs_lookup_rel(dfs, pie->ie_obj, name, O_RDONLY, &obj, NULL,
+			    NULL);
+	if (rc)
+		D_GOTO(out, rc);
 
-	if (fi != NULL) {
-		obj = (dfs_obj_t *)fi->fh;
-	} else {
-		if (path == NULL)
-			return -ENOENT;
-		rc = dfs_lookup(dfs, path, O_RDONLY, &obj, NULL);
-		if (rc) {
-			fprintf(stderr, "Failed to lookup path %s (%d)\n",
-				path, rc);
-			return error_convert(rc);
-		}
-		release = true;
-	}
+	/* the target is either exchanged or replaced, if it exists */
+	rc = dfs_lookup_rel(dfs, npie->ie_obj, newname, O_RDONLY, &new_obj,
+			    NULL, NULL);
+	if (rc == -DER_NONEXIST)
+		new_obj = NULL;
+	else if (rc)
+		D_GOTO(out, rc);
 
-	filler(buf, ".", NULL, 0, 0);
-	filler(buf, "..", NULL, 0, 0);
+#ifdef RENAME_NOREPLACE
+	if (flags & RENAME_EXCHANGE) {
+		if (flags & RENAME_NOREPLACE)
+			D_GOTO(out, rc = -DER_INVAL);
+		if (new_obj == NULL)
+			D_GOTO(out, rc = -DER_NONEXIST);
 
-	while (!daos_anchor_is_eof(&anchor)) {
-		uint32_t i, nr = NUM_DIRENTS;
-		struct dirent dirs[NUM_DIRENTS];
+		rc = dfs_exchange(dfs, pie->ie_obj, (char *)name, npie->ie_obj,
+				  (char *)newname);
+		if (rc) {
+			fprintf(stderr, "Failed to exchange %s with %s (%d)\n",
+				name, newname, rc);
+			D_GOTO(out, rc);
+		}
+	} else {
+		if ((flags & RENAME_NOREPLACE) && new_obj != NULL)
+			D_GOTO(out, rc = -DER_EXIST);
 
-		rc = dfs_readdir(dfs, obj, &anchor, &nr, dirs);
+		rc = dfs_move(dfs, pie->ie_obj, (char *)name, npie->ie_obj,
+			      (char *)newname);
 		if (rc) {
-			fprintf(stderr, "Failed to iterate path %s (%d)\n",
-				path, rc);
+			fprintf(stderr, "Failed to move %s to %s (%d)\n",
+				name, newname, rc);
 			D_GOTO(out, rc);
 		}
-		for (i = 0; i < nr; i++)
-			filler(buf, dirs[i].d_name, NULL, 0, 0);
 	}
+#else
+	rc = dfs_move(dfs, pie->ie_obj, (char *)name, npie->ie_obj,
+		      (char *)newname);
+	if (rc) {
+		fprintf(stderr, "Failed to move %s to %s (%d)\n",
+			name, newname, rc);
+		D_GOTO(out, rc);
+	}
+#endif
+
+	ie = dfuse_ie_find(obj, pie, name);
+	if (new_obj != NULL)
+		new_ie = dfuse_ie_find(new_obj, npie, newname);
+	/* renamed onto itself */
+	if (new_ie == ie)
+		new_ie = NULL;
+
+#ifdef RENAME_NOREPLACE
+	if (flags & RENAME_EXCHANGE)
+		dfuse_ie_move(new_ie, pie, name);
+	else
+		dfuse_ie_unlink(new_ie);
+#else
+	dfuse_ie_unlink(new_ie);
+#endif
+	dfuse_ie_move(ie, npie, newname);
 
 out:
-	if (release && obj)
+	if (obj)
 		dfs_release(obj);
-	return error_convert(rc);
+	if (new_obj)
+		dfs_release(new_obj);
+	dfuse_reply_err(req, rc);
 }
 
-static int
-dfuse_create(const char *path, mode_t mode, struct fuse_file_info *fi)
+static void
+dfuse_create(fuse_req_t req, fuse_ino_t parent, const char *name,
+	     mode_t mode, struct fuse_file_info *fi)
 {
-	char *name = NULL, *dir_name = NULL;
-	dfs_obj_t *obj, *parent = NULL;
-	mode_t pmode;
-	int rc;
+	struct fuse_entry_param	entry = {0};
+	struct dfuse_inode	*pie = dfuse_ino2ie(parent);
+	struct dfuse_inode	*ie;
+	dfs_obj_t		*obj;
+	int			rc;
 
-	FUNC_ENTER("path = %s\n", path);
+	FUNC_ENTER("parent = %lu, name = %s\n", (unsigned long)parent, name);
 
-	rc = parse_filename(path, &name, &dir_name);
+	/* the object is shared by all opens of the inode */
+	rc = dfs_open(dfs, pie->ie_obj, name, S_IFREG | mode,
+		      (fi->flags & ~O_ACCMODE) | O_RDWR, DAOS_OC_LARGE_RW,
+		      NULL, &obj);
 	if (rc)
-		return rc;
-
-	D_ASSERT(dir_name);
-	if (name == NULL)
-		D_GOTO(out, rc = -EINVAL);
+		D_GOTO(err, rc);
 
-	rc = dfs_lookup(dfs, dir_name, O_RDWR, &parent, &pmode);
+	rc = dfs_ostat(dfs, obj, &entry.attr);
 	if (rc) {
-		fprintf(stderr, "Failed path lookup %s (%d)\n", dir_name, rc);
-		D_GOTO(out, rc);
-	}
-	if (!S_ISDIR(pmode)) {
-		fprintf(stderr, "%s does not resolve to a dir\n", dir_name);
-		D_GOTO(out, rc = -DER_INVAL);
+		dfs_release(obj);
+		D_GOTO(err, rc);
 	}
 
-	mode = S_IFREG | mode;
-	rc = dfs_open(dfs, parent, name, mode, fi->flags, DAOS_OC_LARGE_RW,
-		      NULL, &obj);
+	rc = dfuse_ie_get(pie, name, obj, &ie);
 	if (rc)
-		D_GOTO(out, rc);
+		D_GOTO(err, rc);
 
-	fi->direct_io = 1;
-	fi->fh = (uint64_t)obj;
+	entry.ino = dfuse_ie2ino(ie);
+	entry.attr.st_ino = ie->ie_stino;
+	entry.attr_timeout = dfuse_fs.attr_timeout;
+	entry.entry_timeout = dfuse_fs.entry_timeout;
 
-out:
-	if (name)
-		free(name);
-	if (dir_name)
-		free(dir_name);
-	if (parent)
-		dfs_release(parent);
-	return error_convert(rc);
+	fi->direct_io = 1;
+	fuse_reply_create(req, &entry, fi);
+	return;
+err:
+	dfuse_reply_err(req, rc);
 }
 
-static int
-dfuse_open(const char *path, struct fuse_file_info *fi)
+static void
+dfuse_open(fuse_req_t req, fuse_ino_t ino, struct fuse_file_info *fi)
 {
-	char *name = NULL, *dir_name = NULL;
-	dfs_obj_t *obj, *parent = NULL;
-	mode_t pmode;
-	int rc;
+	mode_t mode;
 
-	FUNC_ENTER("path = %s\n", path);
+	FUNC_ENTER("ino = %lu\n", (unsigned long)ino);
 
-	rc = parse_filename(path, &name, &dir_name);
-	if (rc)
-		return rc;
+	dfs_get_mode(dfuse_ino2ie(ino)->ie_obj, &mode);
+	if (!S_ISREG(mode)) {
+		fuse_reply_err(req, S_ISDIR(mode) ? EISDIR : EINVAL);
+		return;
+	}
+
+	fi->direct_io = 1;
+	fuse_reply_open(req, fi);
+}
+
+/*
+ * Asynchronous I/O.
+ *
+ * With --async=N, read and write requests are submitted to DFS with an event
+ * on the dfuse EQ and replied from dfuse_io_reap() once the event completes,
+ * so up to N I/Os are in flight while the session loop keeps receiving
+ * requests. Every in-flight I/O holds a reference on its inode so a forget
+ * does not release the object under it.
+ */
+struct dfuse_io {
+	daos_event_t		 io_ev;
+	fuse_req_t		 io_req;
+	struct dfuse_inode	*io_ie;
+	daos_array_iod_t	 io_iod;
+	daos_range_t		 io_rg;
+	daos_sg_list_t		 io_sgl;
+	daos_iov_t		 io_iov;
+	/** bytes read, or bytes to write */
+	daos_size_t		 io_size;
+	bool			 io_write;
+	/** data buffer, allocated along with the I/O */
+	char			 io_buf[0];
+};
 
-	D_ASSERT(dir_name);
-	if (name == NULL)
-		D_GOTO(out, rc = -EINVAL);
+/** max events reaped by one dfuse_io_reap() call */
+#define DFUSE_IO_REAP_MAX	16
 
-	rc = dfs_lookup(dfs, dir_name, O_RDWR, &parent, &pmode);
+static struct dfuse_io *
+dfuse_io_alloc(fuse_req_t req, fuse_ino_t ino, size_t size, off_t offset,
+	       bool write)
+{
+	struct dfuse_io	*io;
+	int		 rc;
+
+	D_ALLOC(io, sizeof(*io) + size);
+	if (io == NULL)
+		return NULL;
+
+	rc = daos_event_init(&io->io_ev, dfuse_fs.eqh, NULL);
 	if (rc) {
-		fprintf(stderr, "Failed path lookup %s (%d)\n", dir_name, rc);
-		D_GOTO(out, rc);
-	}
-	if (!S_ISDIR(pmode)) {
-		fprintf(stderr, "%s does not resolve to a dir\n", dir_name);
-		D_GOTO(out, rc = -DER_INVAL);
+		D_FREE(io);
+		return NULL;
 	}
 
-	rc = dfs_open(dfs, parent, name, S_IFREG, fi->flags, 0, NULL, &obj);
-	if (rc)
-		D_GOTO(out, rc);
-
-	fi->direct_io = 1;
-	fi->fh = (uint64_t)obj;
+	io->io_req = req;
+	io->io_ie = dfuse_ino2ie(ino);
+	io->io_write = write;
+	io->io_size = write ? size : 0;
+
+	io->io_rg.rg_idx = offset;
+	io->io_rg.rg_len = size;
+	io->io_iod.arr_nr = 1;
+	io->io_iod.arr_rgs = &io->io_rg;
+
+	daos_iov_set(&io->io_iov, io->io_buf, size);
+	io->io_sgl.sg_nr = 1;
+	io->io_sgl.sg_nr_out = 0;
+	io->io_sgl.sg_iovs = &io->io_iov;
+	return io;
+}
 
-out:
-	if (name)
-		free(name);
-	if (dir_name)
-		free(dir_name);
-	if (parent)
-		dfs_release(parent);
-	return error_convert(rc);
+static void
+dfuse_io_free(struct dfuse_io *io)
+{
+	daos_event_fini(&io->io_ev);
+	D_FREE(io);
 }
 
-static int
-dfuse_opendir(const char *path, struct fuse_file_info *fi)
+/** Submit an I/O, it's replied right away if it fails to launch */
+static void
+dfuse_io_submit(struct dfuse_io *io)
 {
-	char *name = NULL, *dir_name = NULL;
-	dfs_obj_t *obj, *parent = NULL;
-	mode_t pmode;
-	bool free_parent = true;
-	int rc;
+	struct dfuse_inode	*ie = io->io_ie;
+	int			 rc;
+
+	if (io->io_write)
+		rc = dfs_writex(dfs, ie->ie_obj, &io->io_iod, &io->io_sgl,
+				&io->io_ev);
+	else
+		rc = dfs_readx(dfs, ie->ie_obj, &io->io_iod, &io->io_sgl,
+			       &io->io_size, &io->io_ev);
+	if (rc) {
+		dfuse_reply_err(io->io_req, rc);
+		dfuse_io_free(io);
+		return;
+	}
 
-	FUNC_ENTER("path = %s\n", path);
+	if (ie != dfuse_root)
+		ie->ie_ref++;
+	dfuse_fs.io_inflight++;
+}
 
-	rc = parse_filename(path, &name, &dir_name);
-	if (rc)
-		return rc;
+/** Reply the completed I/Os, wait for at most @timeout us for the first one */
+static void
+dfuse_io_reap(int64_t timeout)
+{
+	daos_event_t	*evs[DFUSE_IO_REAP_MAX];
+	struct dfuse_io	*io;
+	int		 rc;
+	int		 i;
+
+	rc = daos_eq_poll(dfuse_fs.eqh, 1, timeout, DFUSE_IO_REAP_MAX, evs);
+	if (rc < 0) {
+		D_ERROR("daos_eq_poll() failed (%d)\n", rc);
+		return;
+	}
 
-	D_ASSERT(dir_name);
+	for (i = 0; i < rc; i++) {
+		io = container_of(evs[i], struct dfuse_io, io_ev);
 
-	rc = dfs_lookup(dfs, dir_name, O_RDONLY, &parent, &pmode);
-	if (rc) {
-		fprintf(stderr, "Failed path lookup %s (%d)\n", dir_name, rc);
-		D_GOTO(out, rc);
-	}
-	if (!S_ISDIR(pmode)) {
-		fprintf(stderr, "%s does not resolve to a dir\n", dir_name);
-		D_GOTO(out, rc = -DER_INVAL);
-	}
+		if (io->io_ev.ev_error)
+			dfuse_reply_err(io->io_req, io->io_ev.ev_error);
+		else if (io->io_write)
+			fuse_reply_write(io->io_req, io->io_size);
+		else
+			fuse_reply_buf(io->io_req, io->io_buf, io->io_size);
 
-	if (name == NULL) {
-		fi->fh = (uint64_t)parent;
-		free_parent = false;
-	} else {
-		rc = dfs_open(dfs, parent, name, S_IFDIR, O_RDONLY, 0, NULL,
-			      &obj);
-		if (rc)
-			D_GOTO(out, rc);
-		fi->fh = (uint64_t)obj;
+		D_ASSERT(dfuse_fs.io_inflight > 0);
+		dfuse_fs.io_inflight--;
+		dfuse_ie_put(io->io_ie, 1);
+		dfuse_io_free(io);
 	}
-
-out:
-	if (name)
-		free(name);
-	if (dir_name)
-		free(dir_name);
-	if (free_parent && parent)
-		dfs_release(parent);
-	return error_convert(rc);
 }
 
-static int
-dfuse_read(const char *path, char *buf, size_t size, off_t offset,
+static void
+dfuse_read(fuse_req_t req, fuse_ino_t ino, size_t size, off_t offset,
 	   struct fuse_file_info *fi)
 {
-	dfs_obj_t *obj;
-	daos_size_t actual;
-	daos_iov_t iov;
-	daos_sg_list_t sgl;
-	int rc;
+	daos_size_t	actual;
+	daos_iov_t	iov;
+	daos_sg_list_t	sgl;
+	char		*buf;
+	int		rc;
+
+	FUNC_ENTER("ino = %lu, size = %zu, offset = %ld\n",
+		   (unsigned long)ino, size, (long)offset);
+
+	if (dfuse_fs.async) {
+		struct dfuse_io *io;
 
-	FUNC_ENTER("path = %s\n", path);
+		io = dfuse_io_alloc(req, ino, size, offset, false);
+		if (io == NULL)
+			fuse_reply_err(req, ENOMEM);
+		else
+			dfuse_io_submit(io);
+		return;
+	}
 
-	D_ASSERT(fi != NULL);
-	obj = (dfs_obj_t *)fi->fh;
+	buf = malloc(size);
+	if (buf == NULL) {
+		fuse_reply_err(req, ENOMEM);
+		return;
+	}
 
 	/** set memory location */
 	sgl.sg_nr = 1;
@@ -757,26 +1185,38 @@ dfuse_read(const char *path, char *buf, size_t size, off_t offset,
 	daos_iov_set(&iov, buf, size);
 	sgl.sg_iovs = &iov;
 
-	rc = dfs_read(dfs, obj, sgl, offset, &actual);
+	rc = dfs_read(dfs, dfuse_ino2ie(ino)->ie_obj, sgl, offset, &actual);
 	if (rc)
-		return error_convert(rc);
-
-	return actual;
+		dfuse_reply_err(req, rc);
+	else
+		fuse_reply_buf(req, buf, actual);
+	free(buf);
 }
 
-static int
-dfuse_write(const char *path, const char *buf, size_t size, off_t offset,
-	    struct fuse_file_info *fi)
+static void
+dfuse_write(fuse_req_t req, fuse_ino_t ino, const char *buf, size_t size,
+	    off_t offset, struct fuse_file_info *fi)
 {
-	dfs_obj_t *obj;
-	daos_iov_t iov;
-	daos_sg_list_t sgl;
-	int rc;
+	daos_iov_t	iov;
+	daos_sg_list_t	sgl;
+	int		rc;
 
-	FUNC_ENTER("path = %s\n", path);
+	FUNC_ENTER("ino = %lu, size = %zu, offset = %ld\n",
+		   (unsigned long)ino, size, (long)offset);
 
-	D_ASSERT(fi != NULL);
-	obj = (dfs_obj_t *)fi->fh;
+	if (dfuse_fs.async) {
+		struct dfuse_io *io;
+
+		io = dfuse_io_alloc(req, ino, size, offset, true);
+		if (io == NULL) {
+			fuse_reply_err(req, ENOMEM);
+			return;
+		}
+		/** @buf is in the session receive buffer, reused on return */
+		memcpy(io->io_buf, buf, size);
+		dfuse_io_submit(io);
+		return;
+	}
 
 	/** set memory location */
 	sgl.sg_nr = 1;
@@ -784,456 +1224,405 @@ dfuse_write(const char *path, const char *buf, size_t size, off_t offset,
 	daos_iov_set(&iov, (void *)buf, size);
 	sgl.sg_iovs = &iov;
 
-	rc = dfs_write(dfs, obj, sgl, offset);
+	rc = dfs_write(dfs, dfuse_ino2ie(ino)->ie_obj, sgl, offset);
 	if (rc)
-		return error_convert(rc);
-
-	return size;
+		dfuse_reply_err(req, rc);
+	else
+		fuse_reply_write(req, size);
 }
 
-static int
-dfuse_mkdir(const char *path, mode_t mode)
+static void
+dfuse_release(fuse_req_t req, fuse_ino_t ino, struct fuse_file_info *fi)
 {
-	dfs_obj_t *parent = NULL;
-	mode_t pmode;
-	char *name = NULL, *dir_name = NULL;
-	int rc;
-
-	FUNC_ENTER("path = %s\n", path);
+	FUNC_ENTER("ino = %lu\n", (unsigned long)ino);
 
-	rc = parse_filename(path, &name, &dir_name);
-	if (rc)
-		return rc;
-
-	D_ASSERT(dir_name);
-	if (name == NULL)
-		D_GOTO(out, rc = -EINVAL);
-
-	rc = dfs_lookup(dfs, dir_name, O_RDWR, &parent, &pmode);
-	if (rc) {
-		fprintf(stderr, "Failed path lookup %s (%d)\n", dir_name, rc);
-		D_GOTO(out, rc);
-	}
-	if (!S_ISDIR(pmode)) {
-		fprintf(stderr, "%s does not resolve to a dir\n", dir_name);
-		D_GOTO(out, rc = -DER_INVAL);
-	}
-
-	rc = dfs_mkdir(dfs, parent, name, mode);
-	if (rc)
-		D_GOTO(out, rc);
-
-out:
-	if (name)
-		free(name);
-	if (dir_name)
-		free(dir_name);
-	if (parent)
-		dfs_release(parent);
-	return error_convert(rc);
+	/** the object is released when the inode is forgotten */
+	fuse_reply_err(req, 0);
 }
 
-static int
-dfuse_symlink(const char *from, const char *to)
+static void
+dfuse_sync(fuse_req_t req, fuse_ino_t ino, int datasync,
+	   struct fuse_file_info *fi)
 {
-	dfs_obj_t *parent = NULL;
-	mode_t pmode;
-	dfs_obj_t *sym;
-	char *name = NULL, *dir_name = NULL;
 	int rc;
 
-	FUNC_ENTER("from = %s, to = %s\n", from, to);
+	FUNC_ENTER("ino = %lu\n", (unsigned long)ino);
 
-	rc = parse_filename(to, &name, &dir_name);
-	if (rc)
-		return rc;
-
-	D_ASSERT(dir_name);
-	if (name == NULL)
-		D_GOTO(out, rc = -EINVAL);
-
-	rc = dfs_lookup(dfs, dir_name, O_RDWR, &parent, &pmode);
-	if (rc) {
-		fprintf(stderr, "Failed path lookup %s (%d)\n", dir_name, rc);
-		D_GOTO(out, rc);
-	}
-	if (!S_ISDIR(pmode)) {
-		fprintf(stderr, "%s does not resolve to a dir\n", dir_name);
-		D_GOTO(out, rc = -DER_INVAL);
-	}
-
-	rc = dfs_open(dfs, parent, name, S_IFLNK, O_CREAT, 0, from, &sym);
-	if (rc)
-		D_GOTO(out, rc);
-
-	dfs_release(sym);
-
-out:
-	if (name)
-		free(name);
-	if (dir_name)
-		free(dir_name);
-	if (parent)
-		dfs_release(parent);
-	return error_convert(rc);
+	rc = dfs_sync(dfs);
+	dfuse_reply_err(req, rc);
 }
 
-static int
-dfuse_readlink(const char *path, char *buf, size_t size)
+#define NUM_DIRENTS 32
+
+/** Per opendir() state of a directory stream */
+struct dfuse_dir_handle {
+	/** anchor of the dkey enumeration */
+	daos_anchor_t	dh_anchor;
+	/** entries enumerated but not returned yet */
+	struct dirent	dh_dirs[NUM_DIRENTS];
+	/** objects and attributes of the entries if read by readdirplus */
+	dfs_obj_t	*dh_objs[NUM_DIRENTS];
+	struct stat	dh_attrs[NUM_DIRENTS];
+	bool		dh_plus;
+	uint32_t	dh_nr;
+	uint32_t	dh_idx;
+	/** offset of the next entry, "." and ".." are at 0 and 1 */
+	off_t		dh_off;
+};
+
+static void
+dfuse_opendir(fuse_req_t req, fuse_ino_t ino, struct fuse_file_info *fi)
 {
-	dfs_obj_t *obj = NULL;
-	mode_t mode;
-	int rc;
+	struct dfuse_dir_handle	*dh;
+	mode_t			mode;
 
-	FUNC_ENTER("path = %s\n", path);
+	FUNC_ENTER("ino = %lu\n", (unsigned long)ino);
 
-	rc = dfs_lookup(dfs, path, O_RDONLY, &obj, &mode);
-	if (rc) {
-		fprintf(stderr, "Failed path lookup %s (%d)\n", path, rc);
-		D_GOTO(out, rc);
-	}
-	if (!S_ISLNK(mode)) {
-		fprintf(stderr, "%s does not resolve to a symlink\n", path);
-		D_GOTO(out, rc = -DER_INVAL);
+	dfs_get_mode(dfuse_ino2ie(ino)->ie_obj, &mode);
+	if (!S_ISDIR(mode)) {
+		fuse_reply_err(req, ENOTDIR);
+		return;
 	}
 
-	rc = dfs_get_symlink_value(obj, buf, &size);
-	if (rc)
-		D_GOTO(out, rc);
+	D_ALLOC_PTR(dh);
+	if (dh == NULL) {
+		fuse_reply_err(req, ENOMEM);
+		return;
+	}
 
-out:
-	if (obj)
-		dfs_release(obj);
-	return error_convert(rc);
+	fi->fh = (uint64_t)dh;
+	fuse_reply_open(req, fi);
 }
 
-static int
-dfuse_unlink(const char *path)
+/** Release the objects of the entries not returned yet */
+static void
+dfuse_dh_release(struct dfuse_dir_handle *dh)
 {
-	dfs_obj_t *parent = NULL;
-	mode_t pmode;
-	char *name = NULL, *dir_name = NULL;
-	int rc;
-
-	FUNC_ENTER("path = %s\n", path);
-
-	rc = parse_filename(path, &name, &dir_name);
-	if (rc)
-		return rc;
-
-	D_ASSERT(dir_name);
-	if (name == NULL)
-		D_GOTO(out, rc = -EINVAL);
+	uint32_t i;
 
-	rc = dfs_lookup(dfs, dir_name, O_RDWR, &parent, &pmode);
-	if (rc) {
-		fprintf(stderr, "Failed path lookup %s (%d)\n", dir_name, rc);
-		D_GOTO(out, rc);
-	}
-	if (!S_ISDIR(pmode)) {
-		fprintf(stderr, "%s does not resolve to a dir\n", dir_name);
-		D_GOTO(out, rc = -DER_INVAL);
+	for (i = dh->dh_idx; i < dh->dh_nr; i++) {
+		if (dh->dh_objs[i] != NULL)
+			dfs_release(dh->dh_objs[i]);
+		dh->dh_objs[i] = NULL;
 	}
+}
 
-	rc = dfs_remove(dfs, parent, name, false);
-	if (rc) {
-		fprintf(stderr, "Failed to remove file %s (%d)\n", name, rc);
-		D_GOTO(out, rc);
-	}
+static void
+dfuse_releasedir(fuse_req_t req, fuse_ino_t ino, struct fuse_file_info *fi)
+{
+	struct dfuse_dir_handle *dh = (struct dfuse_dir_handle *)fi->fh;
 
-out:
-	if (name)
-		free(name);
-	if (dir_name)
-		free(dir_name);
-	if (parent)
-		dfs_release(parent);
-	return error_convert(rc);
+	FUNC_ENTER("ino = %lu\n", (unsigned long)ino);
+
+	dfuse_dh_release(dh);
+	D_FREE(dh);
+	fuse_reply_err(req, 0);
 }
 
+/**
+ * Name of the entry at the current offset, NULL at the end of directory. The
+ * next batch is read with dfs_readdirplus() if @plus is set, which looks up
+ * all of its entries at once.
+ */
 static int
-dfuse_rmdir(const char *path)
+dfuse_dh_peek(struct dfuse_inode *ie, struct dfuse_dir_handle *dh, bool plus,
+	      const char **name)
 {
-	dfs_obj_t *parent = NULL;
-	mode_t pmode;
-	char *name = NULL, *dir_name = NULL;
 	int rc;
 
-	FUNC_ENTER("path = %s\n", path);
-
-	rc = parse_filename(path, &name, &dir_name);
-	if (rc)
-		return rc;
-
-	D_ASSERT(dir_name);
-	if (name == NULL)
-		D_GOTO(out, rc = -EINVAL);
-
-	rc = dfs_lookup(dfs, dir_name, O_RDWR, &parent, &pmode);
-	if (rc) {
-		fprintf(stderr, "Failed path lookup %s (%d)\n", dir_name, rc);
-		D_GOTO(out, rc);
-	}
-	if (!S_ISDIR(pmode)) {
-		fprintf(stderr, "%s does not resolve to a dir\n", dir_name);
-		D_GOTO(out, rc = -DER_INVAL);
+	if (dh->dh_off < 2) {
+		*name = dh->dh_off == 0 ? "." : "..";
+		return 0;
 	}
 
-	rc = dfs_remove(dfs, parent, name, false);
-	if (rc) {
-		fprintf(stderr, "Failed to remove dir %s (%d)\n", name, rc);
-		D_GOTO(out, rc);
+	while (dh->dh_idx == dh->dh_nr) {
+		if (daos_anchor_is_eof(&dh->dh_anchor)) {
+			*name = NULL;
+			return 0;
+		}
+
+		dh->dh_nr = NUM_DIRENTS;
+		dh->dh_idx = 0;
+		dh->dh_plus = plus;
+		if (plus)
+			rc = dfs_readdirplus(dfs, ie->ie_obj, &dh->dh_anchor,
+					     &dh->dh_nr, dh->dh_dirs,
+					     dh->dh_objs, dh->dh_attrs);
+		else
+			rc = dfs_readdir(dfs, ie->ie_obj, &dh->dh_anchor,
+					 &dh->dh_nr, dh->dh_dirs);
+		if (rc) {
+			dh->dh_nr = 0;
+			return rc;
+		}
 	}
 
-out:
-	if (name)
-		free(name);
-	if (dir_name)
-		free(dir_name);
-	if (parent)
-		dfs_release(parent);
-	return error_convert(rc);
+	*name = dh->dh_dirs[dh->dh_idx].d_name;
+	return 0;
 }
 
-static int
-dfuse_release(const char *path, struct fuse_file_info *fi)
+static inline void
+dfuse_dh_next(struct dfuse_dir_handle *dh)
 {
-	int rc;
-
-	FUNC_ENTER("path = %s\n", path);
-
-	if (fi != NULL) {
-		rc = dfs_release((dfs_obj_t *)fi->fh);
-		return error_convert(rc);
+	if (dh->dh_off >= 2) {
+		/* skipped, or returned by plain readdir */
+		if (dh->dh_objs[dh->dh_idx] != NULL) {
+			dfs_release(dh->dh_objs[dh->dh_idx]);
+			dh->dh_objs[dh->dh_idx] = NULL;
+		}
+		dh->dh_idx++;
 	}
-
-	return 0;
+	dh->dh_off++;
 }
 
+/*
+ * Add a readdirplus entry. The entry comes with its object and attributes if
+ * the batch was read by dfs_readdirplus(), otherwise it is looked up like
+ * dfuse_lookup() does, so the kernel gets both the dentry and the attributes
+ * in one upcall instead of a lookup and a getattr per entry.
+ */
 static int
-dfuse_rename(const char *old_path, const char *new_path, unsigned int flags)
+dfuse_add_direntry_plus(fuse_req_t req, struct dfuse_inode *ie,
+			struct dfuse_dir_handle *dh, char *buf, size_t size,
+			const char *name, size_t *len)
 {
-	char *name = NULL, *dir_name = NULL;
-	char *new_name = NULL, *new_dir_name = NULL;
-	dfs_obj_t *parent = NULL, *new_parent = NULL;
-	mode_t pmode;
-	int rc;
-
-	FUNC_ENTER("old path = %s,  new path = %s\n", old_path, new_path);
+	struct fuse_entry_param	entry = {0};
+	struct dfuse_inode	*cie;
+	dfs_obj_t		*obj;
+	int			rc;
 
-	rc = parse_filename(old_path, &name, &dir_name);
-	if (rc)
-		return rc;
+	if (dh->dh_off < 2) {
+		/* zero node ID, the kernel doesn't take a lookup on it */
+		entry.attr.st_ino = DFUSE_UNKNOWN_INO;
+		entry.attr.st_mode = S_IFDIR;
+	} else {
+		if (dh->dh_plus) {
+			obj = dh->dh_objs[dh->dh_idx];
+			dh->dh_objs[dh->dh_idx] = NULL;
+			entry.attr = dh->dh_attrs[dh->dh_idx];
+		} else {
+			rc = dfs_lookup_rel(dfs, ie->ie_obj, name, O_RDWR,
+					    &obj, NULL, &entry.attr);
+			if (rc)
+				return rc;
+		}
 
-	D_ASSERT(dir_name);
-	if (name == NULL)
-		D_GOTO(out, rc = -EINVAL);
+		rc = dfuse_ie_get(ie, name, obj, &cie);
+		if (rc)
+			return rc;
 
-	rc = dfs_lookup(dfs, dir_name, O_RDWR, &parent, &pmode);
-	if (rc) {
-		fprintf(stderr, "Failed path lookup %s (%d)\n", dir_name, rc);
-		D_GOTO(out, rc);
-	}
-	if (!S_ISDIR(pmode)) {
-		fprintf(stderr, "%s does not resolve to a dir\n", dir_name);
-		D_GOTO(out, rc = -DER_INVAL);
+		entry.ino = dfuse_ie2ino(cie);
+		entry.attr.st_ino = cie->ie_stino;
+		entry.attr_timeout = dfuse_fs.attr_timeout;
+		entry.entry_timeout = dfuse_fs.entry_timeout;
 	}
 
-	rc = parse_filename(new_path, &new_name, &new_dir_name);
-	if (rc)
-		D_GOTO(out, rc);
+	*len = fuse_add_direntry_plus(req, buf, size, name, &entry,
+				      dh->dh_off + 1);
+	D_ASSERT(*len <= size);
+	return 0;
+}
 
-	D_ASSERT(new_dir_name);
-	if (new_name == NULL)
-		D_GOTO(out, rc = -EINVAL);
+static void
+dfuse_do_readdir(fuse_req_t req, fuse_ino_t ino, size_t size, off_t offset,
+		 struct fuse_file_info *fi, bool plus)
+{
+	struct dfuse_inode	*ie = dfuse_ino2ie(ino);
+	struct dfuse_dir_handle	*dh = (struct dfuse_dir_handle *)fi->fh;
+	const char		*name;
+	size_t			used = 0, len;
+	char			*buf;
+	int			rc = 0;
+
+	FUNC_ENTER("ino = %lu, offset = %ld, plus = %d\n", (unsigned long)ino,
+		   (long)offset, plus);
+
+	buf = malloc(size);
+	if (buf == NULL) {
+		fuse_reply_err(req, ENOMEM);
+		return;
+	}
 
-	rc = dfs_lookup(dfs, new_dir_name, O_RDWR, &new_parent, &pmode);
-	if (rc) {
-		fprintf(stderr, "Failed path lookup %s (%d)\n", new_dir_name,
-			rc);
-		D_GOTO(out, rc);
+	/* seekdir() to an earlier offset restarts the enumeration */
+	if (offset < dh->dh_off) {
+		dfuse_dh_release(dh);
+		memset(dh, 0, sizeof(*dh));
 	}
-	if (!S_ISDIR(pmode)) {
-		fprintf(stderr, "%s does not resolve to a dir\n", new_dir_name);
-		D_GOTO(out, rc = -DER_INVAL);
+	while (dh->dh_off < offset) {
+		rc = dfuse_dh_peek(ie, dh, plus, &name);
+		if (rc || name == NULL)
+			D_GOTO(out, rc);
+		dfuse_dh_next(dh);
 	}
 
-#ifdef RENAME_NOREPLACE
-	if (flags & RENAME_EXCHANGE) {
-		if (flags & RENAME_NOREPLACE)
-			D_GOTO(out, rc = -EINVAL);
+	while (1) {
+		rc = dfuse_dh_peek(ie, dh, plus, &name);
+		if (rc || name == NULL)
+			break;
 
-		rc = dfs_exchange(dfs, parent, name, new_parent, new_name);
-		if (rc) {
-			fprintf(stderr, "Failed to exchange %s with %s (%d)\n",
-				old_path, new_path, rc);
-			D_GOTO(out, rc);
-		}
-	} else {
-		if (flags & RENAME_NOREPLACE) {
-			dfs_obj_t *obj = NULL;
-
-			rc = dfs_lookup(dfs, new_path, O_RDWR, &obj, &pmode);
-			if (rc != -DER_NONEXIST) {
-				if (rc == 0)
-					dfs_release(obj);
-				D_GOTO(out, rc);
+		/* check the room first, the entry is returned by next call */
+		if (plus)
+			len = fuse_add_direntry_plus(req, NULL, 0, name, NULL,
+						     0);
+		else
+			len = fuse_add_direntry(req, NULL, 0, name, NULL, 0);
+		if (len > size - used)
+			break;
+
+		if (plus) {
+			rc = dfuse_add_direntry_plus(req, ie, dh, buf + used,
+						     size - used, name, &len);
+			if (rc == -DER_NONEXIST) {
+				/* removed since enumerated */
+				dfuse_dh_next(dh);
+				rc = 0;
+				continue;
 			}
-		}
+			if (rc)
+				break;
+		} else {
+			struct stat stbuf = {0};
 
-		rc = dfs_move(dfs, parent, name, new_parent, new_name);
-		if (rc) {
-			fprintf(stderr, "Failed to move %s to %s (%d)\n",
-				old_path, new_path, rc);
-			D_GOTO(out, rc);
+			stbuf.st_ino = DFUSE_UNKNOWN_INO;
+			len = fuse_add_direntry(req, buf + used, size - used,
+						name, &stbuf, dh->dh_off + 1);
 		}
+
+		used += len;
+		dfuse_dh_next(dh);
 	}
-#else
-	rc = dfs_move(dfs, parent, name, new_parent, new_name);
-	if (rc) {
-		fprintf(stderr, "Failed to move %s to %s (%d)\n",
-			old_path, new_path, rc);
-		D_GOTO(out, rc);
-	}
-#endif
 
 out:
-	if (name)
-		free(name);
-	if (dir_name)
-		free(dir_name);
-	if (new_name)
-		free(new_name);
-	if (new_dir_name)
-		free(new_dir_name);
-	if (parent)
-		dfs_release(parent);
-	if (new_parent)
-		dfs_release(new_parent);
-	return error_convert(rc);
+	/* return what's filled so far, the error shows up on next call */
+	if (rc && used == 0) {
+		fprintf(stderr, "Failed to iterate dir %lu (%d)\n",
+			(unsigned long)ino, rc);
+		dfuse_reply_err(req, rc);
+	} else {
+		fuse_reply_buf(req, buf, used);
+	}
+	free(buf);
 }
 
-static int
-dfuse_sync(const char *path, int isdatasync, struct fuse_file_info *fi)
+static void
+dfuse_readdir(fuse_req_t req, fuse_ino_t ino, size_t size, off_t offset,
+	      struct fuse_file_info *fi)
 {
-	int rc;
-
-	FUNC_ENTER("path = %s\n", path);
-
-	rc = dfs_sync(dfs);
-	return error_convert(rc);
+	dfuse_do_readdir(req, ino, size, offset, fi, false);
 }
 
-static int
-dfuse_setxattr(const char *path, const char *name, const char *val,
-	       size_t size, int flags)
+static void
+dfuse_readdirplus(fuse_req_t req, fuse_ino_t ino, size_t size, off_t offset,
+		  struct fuse_file_info *fi)
 {
-	dfs_obj_t *obj = NULL;
-	int rc;
-
-	FUNC_ENTER("path = %s, xattr name = %s, val = %s\n", path, name, val);
-
-	rc = dfs_lookup(dfs, path, O_RDWR, &obj, NULL);
-	if (rc)
-		return error_convert(rc);
-
-	rc = dfs_setxattr(dfs, obj, name, val, size, flags);
-	dfs_release(obj);
-	return error_convert(rc);
+	dfuse_do_readdir(req, ino, size, offset, fi, true);
 }
 
-static int
-dfuse_getxattr(const char *path, const char *name, char *val, size_t size)
+static void
+dfuse_setxattr(fuse_req_t req, fuse_ino_t ino, const char *name,
+	       const char *value, size_t size, int flags)
 {
-	dfs_obj_t *obj = NULL;
 	int rc;
 
-	FUNC_ENTER("path = %s, xattr name = %s\n", path, name);
-
-	rc = dfs_lookup(dfs, path, O_RDONLY, &obj, NULL);
-	if (rc)
-		return error_convert(rc);
-
-	rc = dfs_getxattr(dfs, obj, name, val, &size);
-	if (rc)
-		D_GOTO(out, rc);
+	FUNC_ENTER("ino = %lu, xattr name = %s\n", (unsigned long)ino, name);
 
-	rc = (int)size;
-out:
-	dfs_release(obj);
-	return error_convert(rc);
+	rc = dfs_setxattr(dfs, dfuse_ino2ie(ino)->ie_obj, name, value, size,
+			  flags);
+	dfuse_reply_err(req, rc);
 }
 
-static int
-dfuse_listxattr(const char *path, char *list, size_t size)
+static void
+dfuse_getxattr(fuse_req_t req, fuse_ino_t ino, const char *name, size_t size)
 {
-	dfs_obj_t *obj = NULL;
-	int rc;
+	daos_size_t	len = size;
+	char		*buf = NULL;
+	int		rc;
 
-	FUNC_ENTER("path = %s\n", path);
+	FUNC_ENTER("ino = %lu, xattr name = %s\n", (unsigned long)ino, name);
 
-	rc = dfs_lookup(dfs, path, O_RDONLY, &obj, NULL);
-	if (rc)
-		return error_convert(rc);
+	if (size != 0) {
+		buf = malloc(size);
+		if (buf == NULL) {
+			fuse_reply_err(req, ENOMEM);
+			return;
+		}
+	}
 
-	rc = dfs_listxattr(dfs, obj, list, &size);
+	rc = dfs_getxattr(dfs, dfuse_ino2ie(ino)->ie_obj, name, buf, &len);
 	if (rc)
-		D_GOTO(out, rc);
-
-	rc = (int)size;
-out:
-	dfs_release(obj);
-	return error_convert(rc);
+		dfuse_reply_err(req, rc);
+	else if (size == 0)
+		fuse_reply_xattr(req, len);
+	else
+		fuse_reply_buf(req, buf, len);
+
+	if (buf)
+		free(buf);
 }
 
-static int
-dfuse_removexattr(const char *path, const char *name)
+static void
+dfuse_listxattr(fuse_req_t req, fuse_ino_t ino, size_t size)
 {
-	dfs_obj_t *obj = NULL;
-	int rc;
+	daos_size_t	len = size;
+	char		*buf = NULL;
+	int		rc;
 
-	FUNC_ENTER("path = %s, xattr name = %s\n", path, name);
+	FUNC_ENTER("ino = %lu\n", (unsigned long)ino);
 
-	rc = dfs_lookup(dfs, path, O_RDWR, &obj, NULL);
-	if (rc)
-		return error_convert(rc);
+	if (size != 0) {
+		buf = malloc(size);
+		if (buf == NULL) {
+			fuse_reply_err(req, ENOMEM);
+			return;
+		}
+	}
 
-	rc = dfs_removexattr(dfs, obj, name);
-	dfs_release(obj);
-	return error_convert(rc);
+	rc = dfs_listxattr(dfs, dfuse_ino2ie(ino)->ie_obj, buf, &len);
+	if (rc)
+		dfuse_reply_err(req, rc);
+	else if (size == 0)
+		fuse_reply_xattr(req, len);
+	else
+		fuse_reply_buf(req, buf, len);
+
+	if (buf)
+		free(buf);
 }
 
-static void *
-dfuse_init(struct fuse_conn_info *conn, struct fuse_config *cfg)
+static void
+dfuse_removexattr(fuse_req_t req, fuse_ino_t ino, const char *name)
 {
-	struct fuse_context *context = fuse_get_context();
-	void *handle = context->private_data;
+	int rc;
 
-	cfg->nullpath_ok = 1;
+	FUNC_ENTER("ino = %lu, xattr name = %s\n", (unsigned long)ino, name);
 
-	return handle;
+	rc = dfs_removexattr(dfs, dfuse_ino2ie(ino)->ie_obj, name);
+	dfuse_reply_err(req, rc);
 }
 
-static struct fuse_operations dfuse_ops = {
+static struct fuse_lowlevel_ops dfuse_ops = {
 	.access		= dfuse_access,
-	.chmod		= dfuse_chmod,
 	.create		= dfuse_create,
+	.forget		= dfuse_forget,
+	.forget_multi	= dfuse_forget_multi,
 	.fsync		= dfuse_sync,
 	.fsyncdir	= dfuse_sync,
 	.getattr	= dfuse_getattr,
 	.init		= dfuse_init,
+	.lookup		= dfuse_lookup,
 	.mkdir		= dfuse_mkdir,
 	.open		= dfuse_open,
 	.opendir	= dfuse_opendir,
 	.read		= dfuse_read,
 	.readdir	= dfuse_readdir,
+	.readdirplus	= dfuse_readdirplus,
 	.readlink	= dfuse_readlink,
 	.release	= dfuse_release,
-	.releasedir	= dfuse_release,
-	.rmdir		= dfuse_rmdir,
+	.releasedir	= dfuse_releasedir,
+	.rmdir		= dfuse_unlink,
 	.rename		= dfuse_rename,
+	.setattr	= dfuse_setattr,
 	.symlink	= dfuse_symlink,
-	.truncate	= dfuse_truncate,
 	.unlink		= dfuse_unlink,
 	.write		= dfuse_write,
 	.setxattr	= dfuse_setxattr,
@@ -1242,6 +1631,67 @@ static struct fuse_operations dfuse_ops = {
 	.removexattr	= dfuse_removexattr,
 };
 
+/** how long the session loop polls the EQ while I/Os are in flight (us) */
+#define DFUSE_EQ_POLL_US	100
+
+/*
+ * Session loop of the async mode: the kernel requests are received without
+ * blocking while there are I/Os in flight, so the EQ keeps being polled and
+ * completed I/Os are replied. Once the --async limit of I/Os is in flight, no
+ * new request is taken until one of them completes.
+ */
+static int
+dfuse_session_loop(struct fuse_session *se)
+{
+	struct fuse_buf	fbuf = { .mem = NULL };
+	struct pollfd	pfd;
+	int		rc = 0;
+
+	pfd.fd = fuse_session_fd(se);
+	pfd.events = POLLIN;
+
+	while (!fuse_session_exited(se)) {
+		if (dfuse_fs.io_inflight >= dfuse_fs.async) {
+			dfuse_io_reap(DAOS_EQ_WAIT);
+			continue;
+		}
+
+		if (dfuse_fs.io_inflight > 0) {
+			dfuse_io_reap(DFUSE_EQ_POLL_US);
+
+			pfd.revents = 0;
+			rc = poll(&pfd, 1, 0);
+			if (rc < 0 && errno != EINTR) {
+				rc = -errno;
+				break;
+			}
+			if (rc <= 0) {
+				rc = 0;
+				continue;
+			}
+		}
+
+		rc = fuse_session_receive_buf(se, &fbuf);
+		if (rc == -EINTR || rc == -EAGAIN) {
+			rc = 0;
+			continue;
+		}
+		if (rc <= 0)
+			break;
+
+		fuse_session_process_buf(se, &fbuf);
+		rc = 0;
+	}
+
+	/** reply all the in-flight I/Os before the session goes away */
+	while (dfuse_fs.io_inflight > 0)
+		dfuse_io_reap(DAOS_EQ_WAIT);
+
+	free(fbuf.mem);
+	fuse_session_reset(se);
+	return rc;
+}
+
 static void usage(const char *progname)
 {
 	printf(
@@ -1256,6 +1706,14 @@ static void usage(const char *progname)
 "	-l		DAOS pool service rank list\n"
 "	-g		DAOS server group name to connect to\n"
 "	-r		Remove/Destroy the DAOS container when unmounted\n"
+"	--entry-timeout=T	kernel dentry cache timeout in seconds (1.0)\n"
+"	--attr-timeout=T	kernel attribute cache timeout in seconds (1.0)\n"
+"	--negative-timeout=T	kernel negative dentry cache timeout in\n"
+"			seconds (0, disabled)\n"
+"	-a, --async=N	keep up to N read/write requests in flight\n"
+"			(0, synchronous I/O)\n"
+"	--cache-size=N	DFS readahead and write-behind cache budget in\n"
+"			MiB (0, disabled)\n"
 "\n"
 "FUSE Options:\n",
 progname);
@@ -1276,6 +1734,12 @@ static struct fuse_opt dfuse_opts[] = {
 	DFUSE_OPT("-l %s", svcl, 0),
 	DFUSE_OPT("-g %s", group, 0),
 	DFUSE_OPT("-r", destroy, 1),
+	DFUSE_OPT("--entry-timeout=%lf", entry_timeout, 0),
+	DFUSE_OPT("--attr-timeout=%lf", attr_timeout, 0),
+	DFUSE_OPT("--negative-timeout=%lf", neg_timeout, 0),
+	DFUSE_OPT("-a %u", async, 0),
+	DFUSE_OPT("--async=%u", async, 0),
+	DFUSE_OPT("--cache-size=%u", cache_size, 0),
 	FUSE_OPT_END
 };
 
@@ -1305,6 +1769,8 @@ int main(int argc, char *argv[])
 	int			rc;
 
 	memset(&dfuse_fs, 0, sizeof(dfuse_fs));
+	dfuse_fs.entry_timeout = 1.0;
+	dfuse_fs.attr_timeout = 1.0;
 	fuse_opt_parse(&args, &dfuse_fs, dfuse_opts, dfuse_opt_proc);
 
 	if (dfuse_fs.show_version) {
@@ -1313,7 +1779,7 @@ int main(int argc, char *argv[])
 	}
 	if (dfuse_fs.show_help) {
 		usage(args.argv[0]);
-		fuse_lib_help(&args);
+		fuse_lowlevel_help();
 		exit(0);
 	}
 	if (!dfuse_fs.singlethread) {
@@ -1419,17 +1885,47 @@ int main(int argc, char *argv[])
 		D_GOTO(out_cont, rc = 1);
 	}
 
-	dfuse_fs.fuse = fuse_new(&args, &dfuse_ops, sizeof(dfuse_ops), NULL);
-	if (dfuse_fs.fuse == NULL) {
-		fprintf(stderr, "Could not initialize dfuse fs");
+	if (dfuse_fs.cache_size) {
+		rc = dfs_set_cache(dfs, (daos_size_t)dfuse_fs.cache_size << 20);
+		if (rc) {
+			fprintf(stderr, "Failed to enable DFS cache (%d)\n",
+				rc);
+			D_GOTO(out_dmount, rc = 1);
+		}
+	}
+
+	rc = dfuse_ie_table_init();
+	if (rc) {
+		fprintf(stderr, "Failed to init inode table (%d)\n", rc);
 		D_GOTO(out_dmount, rc = 1);
 	}
 
-	rc = fuse_mount(dfuse_fs.fuse, dfuse_fs.mountpoint);
+	if (dfuse_fs.async) {
+		rc = daos_eq_create(&dfuse_fs.eqh);
+		if (rc) {
+			fprintf(stderr, "Failed to create EQ (%d)\n", rc);
+			D_GOTO(out_ie, rc = 1);
+		}
+	}
+
+	dfuse_fs.se = fuse_session_new(&args, &dfuse_ops, sizeof(dfuse_ops),
+				       NULL);
+	if (dfuse_fs.se == NULL) {
+		fprintf(stderr, "Could not initialize dfuse fs");
+		D_GOTO(out_eq, rc = 1);
+	}
+
+	rc = fuse_set_signal_handlers(dfuse_fs.se);
 	if (rc) {
-		fprintf(stderr, "Could not mount dfuse fs");
+		fprintf(stderr, "Could not set signal handlers");
 		D_GOTO(out_fdest, rc = 1);
 	}
+
+	rc = fuse_session_mount(dfuse_fs.se, dfuse_fs.mountpoint);
+	if (rc) {
+		fprintf(stderr, "Could not mount dfuse fs");
+		D_GOTO(out_sig, rc = 1);
+	}
 	fuse_opt_free_args(&args);
 
 	rc = fuse_daemonize(dfuse_fs.foreground);
@@ -1437,12 +1933,22 @@ int main(int argc, char *argv[])
 		D_GOTO(out_fmount, rc = 1);
 
 	D_ASSERT(dfuse_fs.singlethread);
-	rc = fuse_loop(dfuse_fs.fuse);
+	if (dfuse_fs.async)
+		rc = dfuse_session_loop(dfuse_fs.se);
+	else
+		rc = fuse_session_loop(dfuse_fs.se);
 
 out_fmount:
-	fuse_unmount(dfuse_fs.fuse);
+	fuse_session_unmount(dfuse_fs.se);
+out_sig:
+	fuse_remove_signal_handlers(dfuse_fs.se);
 out_fdest:
-	fuse_destroy(dfuse_fs.fuse);
+	fuse_session_destroy(dfuse_fs.se);
+out_eq:
+	if (dfuse_fs.async)
+		daos_eq_destroy(dfuse_fs.eqh, 0);
+out_ie:
+	dfuse_ie_table_fini();
 out_dmount:
 	dfs_umount(dfs);
 out_cont:
@@ -31,6 +31,10 @@
 
 #include <daos_errno.h>
 #include <daos/btree.h>
+#include <daos/slab.h>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
 
 /**
  * Tree node types.
@@ -183,6 +187,12 @@ btr_is_int_key(struct btr_context *tcx)
 	return (tcx->tc_feats & BTR_FEAT_UINT_KEY);
 }
 
+static bool
+btr_has_key_array(struct btr_context *tcx)
+{
+	return (tcx->tc_feats & BTR_FEAT_KEY_ARRAY);
+}
+
 static bool
 btr_has_collision(struct btr_context *tcx)
 {
@@ -231,7 +241,7 @@ btr_context_decref(struct btr_context *tcx)
 	D_ASSERT(tcx->tc_ref > 0);
 	tcx->tc_ref--;
 	if (tcx->tc_ref == 0)
-		D_FREE(tcx);
+		daos_slab_free(DAOS_SLAB_BTR_CTX, tcx);
 }
 
 static void
@@ -269,7 +279,7 @@ btr_context_create(TMMID(struct btr_root) root_mmid, struct btr_root *root,
 	unsigned int		 depth;
 	int			 rc;
 
-	D_ALLOC_PTR(tcx);
+	tcx = daos_slab_alloc(DAOS_SLAB_BTR_CTX, sizeof(*tcx));
 	if (tcx == NULL)
 		return -DER_NOMEM;
 
@@ -554,10 +564,21 @@ btr_rec_copy_hkey(struct btr_context *tcx, struct btr_record *dst_rec,
 	btr_hkey_copy(tcx, &dst_rec->rec_hkey[0], &src_rec->rec_hkey[0]);
 }
 
+/** size of the key array of a node, it is zero if the tree doesn't have it */
+static inline int
+btr_node_keys_size(struct btr_context *tcx)
+{
+	if (!btr_has_key_array(tcx))
+		return 0;
+
+	return tcx->tc_order * sizeof(uint64_t);
+}
+
 static inline int
 btr_node_size(struct btr_context *tcx)
 {
-	return sizeof(struct btr_node) + tcx->tc_order * btr_rec_size(tcx);
+	return sizeof(struct btr_node) + btr_node_keys_size(tcx) +
+	       tcx->tc_order * btr_rec_size(tcx);
 }
 
 static int
@@ -617,11 +638,184 @@ btr_node_rec_at(struct btr_context *tcx, TMMID(struct btr_node) nd_mmid,
 		unsigned int at)
 {
 	struct btr_node *nd = btr_mmid2ptr(tcx, nd_mmid);
-	char		*addr = (char *)&nd[1];
+	char		*addr = (char *)&nd[1] + btr_node_keys_size(tcx);
 
 	return (struct btr_record *)&addr[btr_rec_size(tcx) * at];
 }
 
+static inline uint64_t *
+btr_node_keys(struct btr_context *tcx, TMMID(struct btr_node) nd_mmid)
+{
+	D_ASSERT(btr_has_key_array(tcx));
+	return (uint64_t *)&btr_mmid2ptr(tcx, nd_mmid)[1];
+}
+
+/** the integer key, or the prefix of the hashed key \a hkey */
+static inline uint64_t
+btr_hkey_prefix(struct btr_context *tcx, char *hkey)
+{
+	if (btr_is_int_key(tcx))
+		return *(uint64_t *)hkey;
+
+	return btr_ops(tcx)->to_hkey_prefix(&tcx->tc_tins, hkey);
+}
+
+/**
+ * Set slot \a at of the key array of a node from the record at \a at, it
+ * should be called after copying a record or a hashed key to the node.
+ * The node should have been added to TX.
+ *
+ * A record of a non-leaf node of direct key tree points to the leaf which has
+ * the key as its first record.
+ */
+static void
+btr_node_keys_set(struct btr_context *tcx, TMMID(struct btr_node) nd_mmid,
+		  int at)
+{
+	struct btr_record	*rec;
+	uint64_t		*keys;
+
+	if (!btr_has_key_array(tcx))
+		return;
+
+	keys = btr_node_keys(tcx, nd_mmid);
+	rec = btr_node_rec_at(tcx, nd_mmid, at);
+	if (!btr_is_direct_key(tcx)) {
+		keys[at] = btr_hkey_prefix(tcx, &rec->rec_hkey[0]);
+		return;
+	}
+
+	if (!(btr_mmid2ptr(tcx, nd_mmid)->tn_flags & BTR_NODE_LEAF))
+		rec = btr_node_rec_at(tcx, rec->rec_node[0], 0);
+	keys[at] = btr_ops(tcx)->to_key_prefix(&tcx->tc_tins, rec, NULL);
+}
+
+/**
+ * Move \a nr slots of the key array from \a src_at of node \a src_mmid to
+ * \a dst_at of node \a dst_mmid, it mirrors btr_rec_copy/btr_rec_move of the
+ * same records. The destination node should have been added to TX.
+ */
+static void
+btr_node_keys_move(struct btr_context *tcx, TMMID(struct btr_node) dst_mmid,
+		   int dst_at, TMMID(struct btr_node) src_mmid, int src_at,
+		   int nr)
+{
+	if (!btr_has_key_array(tcx) || nr == 0)
+		return;
+
+	memmove(&btr_node_keys(tcx, dst_mmid)[dst_at],
+		&btr_node_keys(tcx, src_mmid)[src_at], nr * sizeof(uint64_t));
+}
+
+/** narrow the search down to this many keys before scanning them */
+#define BTR_KEY_SCAN_MAX	32
+
+/**
+ * Return the number of keys in the sorted array \a keys which are less than
+ * \a key, all of the keys are compared so the scan has no data dependent
+ * branch and can be vectorized.
+ */
+static inline int
+btr_keys_count_lt(const uint64_t *keys, int nr, uint64_t key)
+{
+	int	cnt = 0;
+	int	i = 0;
+
+#if defined(__AVX2__)
+	const __m256i	sign = _mm256_set1_epi64x((long long)(1ULL << 63));
+	const __m256i	kv = _mm256_xor_si256(_mm256_set1_epi64x(key), sign);
+
+	/* there is no unsigned 64-bit compare, flip the sign bits */
+	for (; i + 4 <= nr; i += 4) {
+		__m256i	v;
+
+		v = _mm256_loadu_si256((const __m256i *)&keys[i]);
+		v = _mm256_xor_si256(v, sign);
+		cnt += __builtin_popcount(_mm256_movemask_pd(
+					_mm256_castsi256_pd(
+					_mm256_cmpgt_epi64(kv, v))));
+	}
+#endif
+	for (; i < nr; i++)
+		cnt += (keys[i] < key);
+
+	return cnt;
+}
+
+/** index of the first key in the sorted array \a keys not less than \a key */
+static int
+btr_keys_lower_bound(const uint64_t *keys, int nr, uint64_t key)
+{
+	int	start = 0;
+
+	while (nr > BTR_KEY_SCAN_MAX) {
+		int	half = nr / 2;
+
+		if (keys[start + half] < key) {
+			start += half + 1;
+			nr -= half + 1;
+		} else {
+			nr = half;
+		}
+	}
+	return start + btr_keys_count_lt(&keys[start], nr, key);
+}
+
+/**
+ * Search the integer key or the prefix of \a hkey or \a key in the key array
+ * of a node.
+ *
+ * If there is no key with the same prefix, it returns the same position and
+ * comparison result as the binary search of btr_probe: the first key greater
+ * than \a hkey, or the last key if all keys are less than \a hkey.
+ *
+ * Otherwise [\a start, \a end] is the range of keys with the same prefix,
+ * it returns BTR_CMP_EQ for integer key, or BTR_CMP_UNKNOWN for hashed key
+ * which should be compared by the hkey callback within the range.
+ *
+ * Direct key always returns BTR_CMP_UNKNOWN. The first key of a leaf can
+ * grow by deletion without updating its parent, so the prefix of a non-leaf
+ * record is only a lower bound, the record at \a start is always compared
+ * by the key callback, which also validates \a key.
+ */
+static int
+btr_node_keys_search(struct btr_context *tcx, TMMID(struct btr_node) nd_mmid,
+		     char *hkey, daos_iov_t *key_iov, int *start, int *end)
+{
+	const uint64_t	*keys = btr_node_keys(tcx, nd_mmid);
+	uint64_t	 key;
+	int		 nr = btr_mmid2ptr(tcx, nd_mmid)->tn_keyn;
+	int		 lo;
+	int		 hi;
+
+	if (btr_is_direct_key(tcx))
+		key = btr_ops(tcx)->to_key_prefix(&tcx->tc_tins, NULL,
+						  key_iov);
+	else
+		key = btr_hkey_prefix(tcx, hkey);
+
+	D_ASSERT(nr > 0);
+	lo = btr_keys_lower_bound(keys, nr, key);
+	if (lo == nr) {
+		*start = *end = nr - 1;
+		return btr_is_direct_key(tcx) ? BTR_CMP_UNKNOWN : BTR_CMP_LT;
+	}
+
+	*start = *end = lo;
+	if (keys[lo] != key)
+		return btr_is_direct_key(tcx) ? BTR_CMP_UNKNOWN : BTR_CMP_GT;
+
+	if (btr_is_int_key(tcx))
+		return BTR_CMP_EQ;
+
+	hi = nr;
+	if (key != UINT64_MAX)
+		hi = lo + btr_keys_lower_bound(&keys[lo], nr - lo, key + 1);
+
+	*end = hi - 1;
+	return BTR_CMP_UNKNOWN;
+}
+
 static TMMID(struct btr_node)
 btr_node_child_at(struct btr_context *tcx, TMMID(struct btr_node) nd_mmid,
 		  unsigned int at)
@@ -823,6 +1017,7 @@ btr_root_start(struct btr_context *tcx, struct btr_record *rec)
 
 	rec_dst = btr_node_rec_at(tcx, nd_mmid, 0);
 	btr_rec_copy(tcx, rec_dst, rec, 1);
+	btr_node_keys_set(tcx, nd_mmid, 0);
 
 	if (btr_has_tx(tcx))
 		btr_root_tx_add(tcx); /* XXX check error */
@@ -876,6 +1071,7 @@ btr_root_grow(struct btr_context *tcx, TMMID(struct btr_node) mmid_left,
 	nd = btr_mmid2ptr(tcx, nd_mmid);
 	nd->tn_child	= mmid_left;
 	nd->tn_keyn	= 1;
+	btr_node_keys_set(tcx, nd_mmid, 0);
 
 	at = !btr_node_is_equal(tcx, mmid_left, tcx->tc_trace->tr_node);
 
@@ -913,10 +1109,15 @@ btr_node_insert_rec_only(struct btr_context *tcx, struct btr_trace *trace,
 	rec_b = btr_node_rec_at(tcx, trace->tr_node, trace->tr_at + 1);
 
 	nd = btr_mmid2ptr(tcx, trace->tr_node);
-	if (trace->tr_at != nd->tn_keyn)
+	if (trace->tr_at != nd->tn_keyn) {
 		btr_rec_move(tcx, rec_b, rec_a, nd->tn_keyn - trace->tr_at);
+		btr_node_keys_move(tcx, trace->tr_node, trace->tr_at + 1,
+				   trace->tr_node, trace->tr_at,
+				   nd->tn_keyn - trace->tr_at);
+	}
 
 	btr_rec_copy(tcx, rec_a, rec, 1);
+	btr_node_keys_set(tcx, trace->tr_node, trace->tr_at);
 	nd->tn_keyn++;
 }
 
@@ -996,6 +1197,8 @@ btr_node_split_and_insert(struct btr_context *tcx, struct btr_trace *trace,
 		D_DEBUG(DB_TRACE, "Splitting leaf node\n");
 
 		btr_rec_copy(tcx, rec_dst, rec_src, nd_right->tn_keyn);
+		btr_node_keys_move(tcx, mmid_right, 0, mmid_left, split_at,
+				   nd_right->tn_keyn);
 		btr_node_insert_rec_only(tcx, trace, rec);
 
 		/* insert the right node and the first key of the right
@@ -1016,6 +1219,8 @@ btr_node_split_and_insert(struct btr_context *tcx, struct btr_trace *trace,
 		nd_right->tn_child = umem_id_u2t(rec->rec_mmid,
 						 struct btr_node);
 		btr_rec_copy(tcx, rec_dst, rec_src, nd_right->tn_keyn);
+		btr_node_keys_move(tcx, mmid_right, 0, mmid_left, split_at,
+				   nd_right->tn_keyn);
 		goto bubble_up;
 	}
 
@@ -1038,6 +1243,8 @@ btr_node_split_and_insert(struct btr_context *tcx, struct btr_trace *trace,
 	 */
 	btr_rec_copy(tcx, rec_dst, btr_rec_at(tcx, rec_src, 1),
 		     nd_right->tn_keyn);
+	btr_node_keys_move(tcx, mmid_right, 0, mmid_left, split_at + 1,
+			   nd_right->tn_keyn);
 
 	/* backup it because the below btr_node_insert_rec_only may
 	 * overwrite it.
@@ -1071,6 +1278,7 @@ btr_node_insert_rec(struct btr_context *tcx, struct btr_trace *trace,
 		rc = btr_node_split_and_insert(tcx, trace, rec);
 	else
 		btr_node_insert_rec_only(tcx, trace, rec);
+
 	return rc;
 }
 
@@ -1141,6 +1349,7 @@ btr_probe(struct btr_context *tcx, dbtree_probe_opc_t probe_opc,
 	int			 cmp;
 	int			 level;
 	bool			 next_level;
+	bool			 narrow = false;
 	struct btr_trace	 traces[BTR_TRACE_MAX];
 	struct btr_trace	*trace = NULL;
 	TMMID(struct btr_node)	 nd_mmid;
@@ -1171,6 +1380,9 @@ btr_probe(struct btr_context *tcx, dbtree_probe_opc_t probe_opc,
 	for (start = end = 0, level = 0, next_level = true ;;) {
 		if (next_level) { /* search a new level of the tree */
 			next_level = false;
+			narrow	= btr_has_key_array(tcx) &&
+				  (btr_is_direct_key(tcx) ? key != NULL :
+							    hkey != NULL);
 			start	= 0;
 			end	= btr_mmid2ptr(tcx, nd_mmid)->tn_keyn - 1;
 
@@ -1186,6 +1398,19 @@ btr_probe(struct btr_context *tcx, dbtree_probe_opc_t probe_opc,
 		} else if (probe_opc == BTR_PROBE_LAST) {
 			at = start = end;
 			cmp = BTR_CMP_LT;
+		} else if (narrow) {
+			D_ASSERT(probe_opc & BTR_PROBE_SPEC);
+			/* search the key array, then only compare records
+			 * with the same key prefix.
+			 */
+			narrow = false;
+			cmp = btr_node_keys_search(tcx, nd_mmid, hkey, key,
+						   &start, &end);
+			at = start;
+			if (cmp == BTR_CMP_UNKNOWN) {
+				at = (start + end) / 2;
+				cmp = btr_cmp(tcx, nd_mmid, at, hkey, key);
+			}
 		} else {
 			D_ASSERT(probe_opc & BTR_PROBE_SPEC);
 			/* binary search */
@@ -1732,6 +1957,369 @@ dbtree_upsert(daos_handle_t toh, dbtree_probe_opc_t opc,
 	return rc;
 }
 
+/** fill factor of dbtree_build_sorted if caller doesn't specify it */
+#define BTR_BUILD_FILL_DEF	100
+
+/**
+ * Generate hkeys of the batch and check they are in strictly ascending
+ * order, it is done before allocating anything so a failed check has
+ * nothing to undo.
+ */
+static int
+btr_build_check(struct btr_context *tcx, int nr, daos_iov_t *keys)
+{
+	union btr_rec_buf	 rec_bufs[2];
+	struct btr_record	*prev = NULL;
+	struct btr_record	*rec;
+	int			 i;
+
+	for (i = 0; i < nr; i++) {
+		rec = &rec_bufs[i % 2].rb_rec;
+		btr_hkey_gen(tcx, &keys[i], &rec->rec_hkey[0]);
+		/* NB: BTR_CMP_MATCHED can be set for keys in order */
+		if (prev != NULL &&
+		    (btr_hkey_cmp(tcx, prev, &rec->rec_hkey[0]) &
+		     (BTR_CMP_LT | BTR_CMP_ERR)) != BTR_CMP_LT) {
+			D_DEBUG(DB_TRACE, "Key %d is out of order\n", i);
+			return -DER_INVAL;
+		}
+		prev = rec;
+	}
+	return 0;
+}
+
+/** Release nodes created by a failed btr_build_sorted */
+static void
+btr_build_abort(struct btr_context *tcx, TMMID(struct btr_node) *nodes,
+		int nodes_nr)
+{
+	struct btr_node	*nd;
+	int		 i;
+	int		 j;
+
+	for (i = 0; i < nodes_nr; i++) {
+		nd = btr_mmid2ptr(tcx, nodes[i]);
+		if (btr_node_is_leaf(tcx, nodes[i])) {
+			for (j = 0; j < nd->tn_keyn; j++)
+				btr_rec_free(tcx,
+					     btr_node_rec_at(tcx, nodes[i], j),
+					     NULL);
+		}
+		btr_node_free(tcx, nodes[i]);
+	}
+}
+
+/**
+ * Build the tree bottom-up from a sorted batch: leaves are filled from left
+ * to right, then each upper level is built from the level below it, until a
+ * level has only one node which becomes the root.
+ *
+ * The batch is spread evenly over the minimum number of nodes which have at
+ * most \a cap records, so the last node of a level is never left near empty.
+ */
+static int
+btr_build_sorted(struct btr_context *tcx, int nr, daos_iov_t *keys,
+		 daos_iov_t *vals, int cap)
+{
+	struct btr_root		*root = tcx->tc_tins.ti_root;
+	TMMID(struct btr_node)	*nodes;
+	TMMID(struct btr_node)	*lefts;
+	TMMID(struct btr_node)	 nd_mmid;
+	union btr_rec_buf	 rec_buf;
+	struct btr_record	*rec;
+	struct btr_node		*nd;
+	int			 nodes_nr = 0;
+	int			 lo;
+	int			 hi;
+	int			 cnt;
+	int			 nr_max;
+	int			 depth;
+	int			 i;
+	int			 j;
+	int			 k;
+	int			 rc = 0;
+
+	/* every level has at most half the nodes of the level below, so
+	 * twice the leaves is enough for the whole tree.
+	 */
+	nr_max = 2 * ((nr + cap - 1) / cap) + 1;
+	D_ALLOC_ARRAY(nodes, nr_max);
+	if (nodes == NULL)
+		return -DER_NOMEM;
+
+	/* the leftmost leaf of each node, it provides the separator key */
+	D_ALLOC_ARRAY(lefts, nr_max);
+	if (lefts == NULL)
+		D_GOTO(out, rc = -DER_NOMEM);
+
+	rec = &rec_buf.rb_rec;
+	cnt = (nr + cap - 1) / cap;
+	for (i = 0, k = 0; i < cnt; i++) {
+		int	recs = nr / cnt + (i < nr % cnt);
+
+		rc = btr_node_alloc(tcx, &nd_mmid);
+		if (rc != 0)
+			D_GOTO(failed, rc);
+
+		nodes[nodes_nr] = lefts[nodes_nr] = nd_mmid;
+		nodes_nr++;
+		btr_node_set(tcx, nd_mmid, BTR_NODE_LEAF);
+
+		nd = btr_mmid2ptr(tcx, nd_mmid);
+		for (j = 0; j < recs; j++, k++) {
+			btr_hkey_gen(tcx, &keys[k], &rec->rec_hkey[0]);
+			rc = btr_rec_alloc(tcx, &keys[k], &vals[k], rec);
+			if (rc != 0)
+				D_GOTO(failed, rc);
+
+			btr_rec_copy(tcx, btr_node_rec_at(tcx, nd_mmid, j),
+				     rec, 1);
+			btr_node_keys_set(tcx, nd_mmid, j);
+			nd->tn_keyn++;
+		}
+	}
+	D_ASSERT(k == nr);
+
+	/* non-leaf node has one more child than its keys, it should have two
+	 * children at least.
+	 */
+	cap = max(cap, 2) + 1;
+	for (depth = 1, lo = 0, hi = nodes_nr; hi - lo > 1; depth++) {
+		k = hi - lo;
+		cnt = (k + cap - 1) / cap;
+		for (i = 0; i < cnt; i++) {
+			int	children = k / cnt + (i < k % cnt);
+
+			rc = btr_node_alloc(tcx, &nd_mmid);
+			if (rc != 0)
+				D_GOTO(failed, rc);
+
+			D_ASSERT(nodes_nr < nr_max);
+			nodes[nodes_nr] = nd_mmid;
+			lefts[nodes_nr] = lefts[lo];
+			nodes_nr++;
+
+			nd = btr_mmid2ptr(tcx, nd_mmid);
+			nd->tn_child = nodes[lo++];
+			for (j = 1; j < children; j++, lo++) {
+				rec = btr_node_rec_at(tcx, nd_mmid, j - 1);
+				rec->rec_mmid = umem_id_t2u(nodes[lo]);
+				btr_rec_copy_hkey(tcx, rec,
+					btr_node_rec_at(tcx, lefts[lo], 0));
+				btr_node_keys_set(tcx, nd_mmid, j - 1);
+			}
+			nd->tn_keyn = children - 1;
+		}
+		hi = nodes_nr;
+	}
+
+	btr_node_set(tcx, nodes[lo], BTR_NODE_ROOT);
+	if (btr_has_tx(tcx)) {
+		rc = btr_root_tx_add(tcx);
+		if (rc != 0)
+			D_GOTO(failed, rc);
+	}
+	root->tr_node = nodes[lo];
+	root->tr_depth = depth;
+	btr_context_set_depth(tcx, depth);
+
+	D_DEBUG(DB_TRACE, "Built tree with %d records, %d nodes, depth %d\n",
+		nr, nodes_nr, depth);
+	D_GOTO(out, rc = 0);
+ failed:
+	btr_build_abort(tcx, nodes, nodes_nr);
+ out:
+	if (lefts != NULL)
+		D_FREE(lefts);
+	D_FREE(nodes);
+	return rc;
+}
+
+static int
+btr_tx_build_sorted(struct btr_context *tcx, int nr, daos_iov_t *keys,
+		    daos_iov_t *vals, int cap)
+{
+	struct umem_instance *umm = btr_umm(tcx);
+	int		      rc = 0;
+
+	TX_BEGIN(umm->umm_pool) {
+		rc = btr_build_sorted(tcx, nr, keys, vals, cap);
+		if (rc != 0)
+			pmemobj_tx_abort(rc);
+	} TX_ONABORT {
+		rc = umem_tx_errno(rc);
+		D_DEBUG(DB_TRACE, "dbtree_build_sorted tx aborted: %d\n", rc);
+
+	} TX_FINALLY {
+		D_DEBUG(DB_TRACE, "dbtree_build_sorted tx exited\n");
+	} TX_END
+
+	return rc;
+}
+
+/** Build the empty tree from a sorted batch, see dbtree_build_sorted */
+static int
+btr_build(struct btr_context *tcx, int nr, daos_iov_t *keys, daos_iov_t *vals,
+	  unsigned int fill)
+{
+	int	cap;
+	int	rc;
+
+	/* a node splits when it has order - 1 records */
+	cap = max(((tcx->tc_order - 1) * fill) / 100, 1);
+	if (btr_has_tx(tcx))
+		rc = btr_tx_build_sorted(tcx, nr, keys, vals, cap);
+	else
+		rc = btr_build_sorted(tcx, nr, keys, vals, cap);
+
+	tcx->tc_probe_rc = PROBE_RC_UNKNOWN; /* path changed */
+	return rc;
+}
+
+/**
+ * Build an empty tree from a batch of keys and values sorted in ascending
+ * order of the tree. Leaves are filled from left to right, then the upper
+ * levels are built on top of them, the whole batch is committed in a single
+ * transaction.
+ *
+ * The tree order is hashed key order for trees without BTR_FEAT_UINT_KEY,
+ * dbtree_bulk_insert should be used if caller can't sort keys that way.
+ * Trees with BTR_FEAT_DIRECT_KEY are not supported.
+ *
+ * \param toh		[IN]	Tree open handle.
+ * \param nr		[IN]	Number of keys and values.
+ * \param keys		[IN]	Sorted keys without duplicate.
+ * \param vals		[IN]	Values of the keys.
+ * \param fill		[IN]	Fill factor of tree nodes in percentage,
+ *				100 is used if it is zero. A lower fill
+ *				factor leaves room for following inserts.
+ *
+ * \return		0		success
+ *			-DER_INVAL	keys are not sorted, or invalid
+ *					fill factor
+ *			-DER_NO_PERM	tree is not empty
+ *			-DER_NOSYS	tree has direct key
+ *			-ve		other error code
+ */
+int
+dbtree_build_sorted(daos_handle_t toh, int nr, daos_iov_t *keys,
+		    daos_iov_t *vals, unsigned int fill)
+{
+	struct btr_context *tcx;
+	int		    rc;
+
+	tcx = btr_hdl2tcx(toh);
+	if (tcx == NULL)
+		return -DER_NO_HDL;
+
+	if (fill == 0)
+		fill = BTR_BUILD_FILL_DEF;
+	if (fill > 100 || nr < 0)
+		return -DER_INVAL;
+
+	if (btr_is_direct_key(tcx))
+		return -DER_NOSYS;
+
+	if (!btr_root_empty(tcx))
+		return -DER_NO_PERM;
+
+	if (nr == 0)
+		return 0;
+
+	rc = btr_build_check(tcx, nr, keys);
+	if (rc != 0)
+		return rc;
+
+	return btr_build(tcx, nr, keys, vals, fill);
+}
+
+static int
+btr_bulk_upsert(struct btr_context *tcx, int nr, daos_iov_t *keys,
+		daos_iov_t *vals)
+{
+	int	i;
+	int	rc = 0;
+
+	for (i = 0; i < nr && rc == 0; i++)
+		rc = btr_upsert(tcx, BTR_PROBE_EQ, &keys[i], &vals[i]);
+
+	return rc;
+}
+
+static int
+btr_tx_bulk_upsert(struct btr_context *tcx, int nr, daos_iov_t *keys,
+		   daos_iov_t *vals)
+{
+	struct umem_instance *umm = btr_umm(tcx);
+	int		      rc = 0;
+
+	TX_BEGIN(umm->umm_pool) {
+		rc = btr_bulk_upsert(tcx, nr, keys, vals);
+		if (rc != 0)
+			pmemobj_tx_abort(rc);
+	} TX_ONABORT {
+		rc = umem_tx_errno(rc);
+		D_DEBUG(DB_TRACE, "dbtree_bulk_insert tx aborted: %d\n", rc);
+
+	} TX_FINALLY {
+		D_DEBUG(DB_TRACE, "dbtree_bulk_insert tx exited\n");
+	} TX_END
+
+	return rc;
+}
+
+/**
+ * Update or insert a batch of keys and values. If the tree is empty, has no
+ * direct key, and the batch is sorted in tree order without duplicate, the
+ * tree is built bottom-up as dbtree_build_sorted does, otherwise the keys are
+ * upserted one by one. Either way the whole batch is committed in a single
+ * transaction for trees on PMEM, which means a failed batch leaves the tree
+ * unchanged.
+ *
+ * The single transaction is where most of the gain comes from, trees in DRAM
+ * only save the rebalancing when they are built from scratch. Unlike
+ * dbtree_update(), existing keys are overwritten silently, so callers which
+ * count new keys have to look them up first.
+ *
+ * \param toh		[IN]	Tree open handle.
+ * \param nr		[IN]	Number of keys and values.
+ * \param keys		[IN]	Keys to update or insert.
+ * \param vals		[IN]	Values of the keys.
+ *
+ * \return		0		success
+ *			-DER_INVAL	invalid key number
+ *			-ve		other error code
+ */
+int
+dbtree_bulk_insert(daos_handle_t toh, int nr, daos_iov_t *keys,
+		   daos_iov_t *vals)
+{
+	struct btr_context *tcx;
+	int		    rc;
+
+	tcx = btr_hdl2tcx(toh);
+	if (tcx == NULL)
+		return -DER_NO_HDL;
+
+	if (nr < 0)
+		return -DER_INVAL;
+
+	if (nr == 0)
+		return 0;
+
+	if (!btr_is_direct_key(tcx) && btr_root_empty(tcx) &&
+	    btr_build_check(tcx, nr, keys) == 0)
+		return btr_build(tcx, nr, keys, vals, BTR_BUILD_FILL_DEF);
+
+	D_DEBUG(DB_TRACE, "Can't build the tree, upsert %d keys\n", nr);
+	if (btr_has_tx(tcx))
+		rc = btr_tx_bulk_upsert(tcx, nr, keys, vals);
+	else
+		rc = btr_bulk_upsert(tcx, nr, keys, vals);
+
+	return rc;
+}
+
 /**
  * Delete the leaf record pointed by @cur_tr from the current node, then fill
  * the deletion gap by shifting remainded records on the specified direction.
@@ -1759,6 +2347,9 @@ btr_node_del_leaf_only(struct btr_context *tcx, struct btr_trace *trace,
 		 */
 		btr_rec_move(tcx, rec, btr_rec_at(tcx, rec, 1),
 			     nd->tn_keyn - trace->tr_at);
+		btr_node_keys_move(tcx, trace->tr_node, trace->tr_at,
+				   trace->tr_node, trace->tr_at + 1,
+				   nd->tn_keyn - trace->tr_at);
 
 	} else if (!shift_left && trace->tr_at != 0) {
 		/* shift right records which are on the left side of the
@@ -1767,6 +2358,8 @@ btr_node_del_leaf_only(struct btr_context *tcx, struct btr_trace *trace,
 		rec = btr_node_rec_at(tcx, trace->tr_node, 0);
 		btr_rec_move(tcx, btr_rec_at(tcx, rec, 1), rec,
 			     trace->tr_at);
+		btr_node_keys_move(tcx, trace->tr_node, 1, trace->tr_node, 0,
+				   trace->tr_at);
 	}
 }
 
@@ -1818,23 +2411,30 @@ btr_node_del_leaf_rebal(struct btr_context *tcx,
 		dst_rec = btr_node_rec_at(tcx, cur_tr->tr_node,
 					  cur_nd->tn_keyn);
 		btr_rec_copy(tcx, dst_rec, src_rec, 1);
+		btr_node_keys_set(tcx, cur_tr->tr_node, cur_nd->tn_keyn);
 		/* shift left remainded record on the sibling */
 		btr_rec_move(tcx, src_rec, btr_rec_at(tcx, src_rec, 1),
 			     sib_nd->tn_keyn - 1);
+		btr_node_keys_move(tcx, sib_mmid, 0, sib_mmid, 1,
+				   sib_nd->tn_keyn - 1);
 
 		/* copy the first hkey of the right sibling node to the
 		 * parent node.
 		 */
 		par_rec = btr_node_rec_at(tcx, par_tr->tr_node, par_tr->tr_at);
 
-		/* NB: Direct key of parent already points here */
+		/* NB: Direct key of parent already points here, but the key
+		 * array still has the prefix of the grabbed record.
+		 */
 		if (!btr_is_direct_key(tcx))
 			btr_rec_copy_hkey(tcx, par_rec, src_rec);
+		btr_node_keys_set(tcx, par_tr->tr_node, par_tr->tr_at);
 	} else {
 		/* grab the last record from the left sibling */
 		src_rec = btr_node_rec_at(tcx, sib_mmid, sib_nd->tn_keyn - 1);
 		dst_rec = btr_node_rec_at(tcx, cur_tr->tr_node, 0);
 		btr_rec_copy(tcx, dst_rec, src_rec, 1);
+		btr_node_keys_set(tcx, cur_tr->tr_node, 0);
 		/* copy the first record key of the current node to the
 		 * parent node.
 		 */
@@ -1843,6 +2443,7 @@ btr_node_del_leaf_rebal(struct btr_context *tcx,
 		/* NB: Direct key of parent already points to this leaf */
 		if (!btr_is_direct_key(tcx))
 			btr_rec_copy_hkey(tcx, par_rec, dst_rec);
+		btr_node_keys_set(tcx, par_tr->tr_node, par_tr->tr_at - 1);
 	}
 	cur_nd->tn_keyn++;
 	sib_nd->tn_keyn--;
@@ -1869,6 +2470,8 @@ btr_node_del_leaf_merge(struct btr_context *tcx,
 	struct btr_node		*dst_nd;
 	struct btr_record	*src_rec;
 	struct btr_record	*dst_rec;
+	TMMID(struct btr_node)	 src_mmid;
+	TMMID(struct btr_node)	 dst_mmid;
 
 	/* NB: always left shift because it is easier for the following
 	 * operations.
@@ -1878,6 +2481,8 @@ btr_node_del_leaf_merge(struct btr_context *tcx,
 		/* move all records from the right sibling node to the
 		 * current node.
 		 */
+		src_mmid = sib_mmid;
+		dst_mmid = cur_tr->tr_node;
 
 		src_nd = btr_mmid2ptr(tcx, sib_mmid);
 		dst_nd = btr_mmid2ptr(tcx, cur_tr->tr_node);
@@ -1894,6 +2499,9 @@ btr_node_del_leaf_merge(struct btr_context *tcx,
 		/* move all records from the current node to the left
 		 * sibling node.
 		 */
+		src_mmid = cur_tr->tr_node;
+		dst_mmid = sib_mmid;
+
 		src_nd = btr_mmid2ptr(tcx, cur_tr->tr_node);
 		dst_nd = btr_mmid2ptr(tcx, sib_mmid);
 
@@ -1912,6 +2520,8 @@ btr_node_del_leaf_merge(struct btr_context *tcx,
 
 	if (src_rec != NULL) {
 		btr_rec_copy(tcx, dst_rec, src_rec, src_nd->tn_keyn);
+		btr_node_keys_move(tcx, dst_mmid, dst_nd->tn_keyn, src_mmid, 0,
+				   src_nd->tn_keyn);
 
 		dst_nd->tn_keyn += src_nd->tn_keyn;
 		D_ASSERT(dst_nd->tn_keyn < tcx->tc_order);
@@ -2000,7 +2610,8 @@ btr_node_del_child_only(struct btr_context *tcx, struct btr_trace *trace,
 		 * deleted record.
 		 */
 		if (trace->tr_at == 0) {
-			nd->tn_child = umem_id_u2t(nd->tn_recs[0].rec_mmid,
+			rec = btr_node_rec_at(tcx, trace->tr_node, 0);
+			nd->tn_child = umem_id_u2t(rec->rec_mmid,
 						   struct btr_node);
 		} else {
 			trace->tr_at -= 1;
@@ -2011,6 +2622,9 @@ btr_node_del_child_only(struct btr_context *tcx, struct btr_trace *trace,
 					      trace->tr_at);
 			btr_rec_move(tcx, rec, btr_rec_at(tcx, rec, 1),
 				     nd->tn_keyn - trace->tr_at);
+			btr_node_keys_move(tcx, trace->tr_node, trace->tr_at,
+					   trace->tr_node, trace->tr_at + 1,
+					   nd->tn_keyn - trace->tr_at);
 		}
 
 	} else {
@@ -2022,6 +2636,9 @@ btr_node_del_child_only(struct btr_context *tcx, struct btr_trace *trace,
 			if (trace->tr_at > 1) {
 				btr_rec_move(tcx, btr_rec_at(tcx, rec, 1), rec,
 					     trace->tr_at - 1);
+				btr_node_keys_move(tcx, trace->tr_node, 1,
+						   trace->tr_node, 0,
+						   trace->tr_at - 1);
 			}
 			rec->rec_mmid = umem_id_t2u(nd->tn_child);
 		}
@@ -2070,11 +2687,15 @@ btr_node_del_child_rebal(struct btr_context *tcx,
 
 		btr_rec_copy_hkey(tcx, dst_rec, par_rec);
 		btr_rec_copy_hkey(tcx, par_rec, src_rec);
+		btr_node_keys_set(tcx, cur_tr->tr_node, cur_nd->tn_keyn);
+		btr_node_keys_set(tcx, par_tr->tr_node, par_tr->tr_at);
 
 		sib_nd->tn_child = umem_id_u2t(src_rec->rec_mmid,
 					       struct btr_node);
 		btr_rec_move(tcx, src_rec, btr_rec_at(tcx, src_rec, 1),
 			     sib_nd->tn_keyn - 1);
+		btr_node_keys_move(tcx, sib_mmid, 0, sib_mmid, 1,
+				   sib_nd->tn_keyn - 1);
 
 	} else {
 		/* grab the last child from the left sibling */
@@ -2085,6 +2706,8 @@ btr_node_del_child_rebal(struct btr_context *tcx,
 
 		btr_rec_copy_hkey(tcx, dst_rec, par_rec);
 		btr_rec_copy_hkey(tcx, par_rec, src_rec);
+		btr_node_keys_set(tcx, cur_tr->tr_node, 0);
+		btr_node_keys_set(tcx, par_tr->tr_node, par_tr->tr_at - 1);
 
 		cur_nd->tn_child = umem_id_u2t(src_rec->rec_mmid,
 					       struct btr_node);
@@ -2113,6 +2736,8 @@ btr_node_del_child_merge(struct btr_context *tcx,
 	struct btr_record	*par_rec;
 	struct btr_record	*src_rec;
 	struct btr_record	*dst_rec;
+	TMMID(struct btr_node)	 src_mmid;
+	TMMID(struct btr_node)	 dst_mmid;
 
 	/* NB: always left shift because it is easier for the following
 	 * operations.
@@ -2120,6 +2745,9 @@ btr_node_del_child_merge(struct btr_context *tcx,
 	btr_node_del_child_only(tcx, cur_tr, true);
 	if (sib_on_right) {
 		/* move children from the right sibling to the current node. */
+		src_mmid = sib_mmid;
+		dst_mmid = cur_tr->tr_node;
+
 		src_nd = btr_mmid2ptr(tcx, sib_mmid);
 		dst_nd = btr_mmid2ptr(tcx, cur_tr->tr_node);
 
@@ -2136,6 +2764,9 @@ btr_node_del_child_merge(struct btr_context *tcx,
 
 	} else {
 		/* move children of the current node to the left sibling. */
+		src_mmid = cur_tr->tr_node;
+		dst_mmid = sib_mmid;
+
 		src_nd = btr_mmid2ptr(tcx, cur_tr->tr_node);
 		dst_nd = btr_mmid2ptr(tcx, sib_mmid);
 
@@ -2152,10 +2783,13 @@ btr_node_del_child_merge(struct btr_context *tcx,
 			  NULL : btr_node_rec_at(tcx, cur_tr->tr_node, 0);
 	}
 	btr_rec_copy_hkey(tcx, dst_rec, par_rec);
+	btr_node_keys_set(tcx, dst_mmid, dst_nd->tn_keyn);
 
 	if (src_rec != NULL) {
 		dst_rec = btr_rec_at(tcx, dst_rec, 1); /* the next record */
 		btr_rec_copy(tcx, dst_rec, src_rec, src_nd->tn_keyn);
+		btr_node_keys_move(tcx, dst_mmid, dst_nd->tn_keyn + 1,
+				   src_mmid, 0, src_nd->tn_keyn);
 	}
 
 	/* NB: destination got an extra key from the parent, and an extra
@@ -3366,6 +4000,16 @@ btr_class_init(TMMID(struct btr_root) root_mmid, struct btr_root *root,
 		return -DER_PROTO;
 	}
 
+	if ((*tree_feats & BTR_FEAT_KEY_ARRAY) &&
+	    ((*tree_feats & BTR_FEAT_DIRECT_KEY) ?
+	     tc->tc_ops->to_key_prefix == NULL :
+	     (!(*tree_feats & BTR_FEAT_UINT_KEY) &&
+	      tc->tc_ops->to_hkey_prefix == NULL))) {
+		D_ERROR("Key array requires integer key or key prefix, "
+			"features "DF_X64"\n", *tree_feats);
+		return -DER_INVAL;
+	}
+
 	tins->ti_ops = tc->tc_ops;
 	return rc;
 }
@@ -3394,6 +4038,10 @@ dbtree_class_register(unsigned int tree_class, uint64_t tree_feats,
 		D_ASSERT(ops->to_hkey_gen != NULL);
 		D_ASSERT(ops->to_hkey_size != NULL);
 	}
+	if (tree_feats & BTR_FEAT_KEY_ARRAY)
+		D_ASSERT((tree_feats & BTR_FEAT_UINT_KEY) ||
+			 ops->to_hkey_prefix != NULL ||
+			 ops->to_key_prefix != NULL);
 	if (tree_feats & BTR_FEAT_DIRECT_KEY) {
 		D_ASSERT(ops->to_key_cmp != NULL);
 		D_ASSERT(ops->to_key_encode != NULL);
@@ -23,10 +23,15 @@
 #define DDSUBSYS	DDFAC(common)
 
 #include <daos/checksum.h>
+#if defined(__x86_64__)
+#include <nmmintrin.h>
+#endif
 
 struct daos_csum_entry {
 	char		*cs_name;	/**< name string of the checksum */
 	uint64_t	 cs_size;
+	/** bit-reflected generator polynomial, used by crc combine */
+	uint64_t	 cs_poly;
 };
 
 
@@ -34,10 +39,12 @@ static struct daos_csum_entry	csum_dict[] = {
 	[DAOS_CS_CRC32] = {
 		.cs_name	= "crc32",
 		.cs_size	= sizeof(uint32_t),
+		.cs_poly	= 0x82F63B78ULL,	/* CRC32C (iSCSI) */
 	},
 	[DAOS_CS_CRC64] = {
 		.cs_name	= "crc64",
 		.cs_size	= sizeof(uint64_t),
+		.cs_poly	= 0xC96C5795D7870F42ULL, /* ECMA-182 */
 	},
 };
 
@@ -235,3 +242,396 @@ failed:
 	return rc;
 }
 
+
+#if defined(__x86_64__)
+/**
+ * Chunked checksum.
+ *
+ * The data described by an SGL is treated as one logical byte stream which
+ * is cut into fixed size chunks, chunk boundaries are independent of the iov
+ * layout so the same data always produces the same chunk checksums. Each
+ * chunk is checksummed from a zero seed as an independent dependency chain,
+ * and the per-chunk results are folded into the running checksum of @csum
+ * with a CRC combine step, so the final checksum is identical to the one
+ * computed by daos_csum_compute().
+ *
+ * CRC combine follows the GF(2) matrix method used by zlib: the CRC of
+ * A || B is the CRC of A advanced over len(B) zero bytes, xor the CRC of B
+ * computed from a zero seed, and advancing a CRC over N zero bytes is a
+ * linear operator which can be precomputed for a given N. This holds for both crc64_ecma_refl (which
+ * inverts its seed and result) and crc32_iscsi (which doesn't).
+ */
+#define CSUM_GF2_DIM	64
+
+static inline uint64_t
+csum_gf2_times(const uint64_t *mat, uint64_t vec)
+{
+	uint64_t	sum = 0;
+
+	while (vec) {
+		if (vec & 1)
+			sum ^= *mat;
+		vec >>= 1;
+		mat++;
+	}
+	return sum;
+}
+
+/** @dst = @a x @b, @dst can't alias the inputs */
+static inline void
+csum_gf2_mult(uint64_t *dst, const uint64_t *a, const uint64_t *b, int width)
+{
+	int	n;
+
+	for (n = 0; n < width; n++)
+		dst[n] = csum_gf2_times(a, b[n]);
+}
+
+/**
+ * Build the operator which advances a CRC over @len zero bytes, it is built
+ * once per chunk length and then costs one matrix-vector product per chunk.
+ */
+static void
+csum_crc_shift_op(int type, uint64_t len, uint64_t *op)
+{
+	struct daos_csum_entry	*dict = &csum_dict[type];
+	uint64_t		 base[CSUM_GF2_DIM];
+	uint64_t		 tmp[CSUM_GF2_DIM];
+	uint64_t		 row;
+	int			 width;
+	int			 n;
+
+	width = dict->cs_size * NBBY;
+	/* operator for one zero bit */
+	base[0] = dict->cs_poly;
+	for (n = 1, row = 1; n < width; n++, row <<= 1)
+		base[n] = row;
+
+	/* square it three times to get the operator for one zero byte */
+	for (n = 0; n < 3; n++) {
+		csum_gf2_mult(tmp, base, base, width);
+		memcpy(base, tmp, width * sizeof(*base));
+	}
+
+	for (n = 0; n < width; n++)
+		op[n] = 1ULL << n;
+
+	while (len != 0) {
+		if (len & 1) {
+			csum_gf2_mult(tmp, base, op, width);
+			memcpy(op, tmp, width * sizeof(*op));
+		}
+		len >>= 1;
+		if (len == 0)
+			break;
+		csum_gf2_mult(tmp, base, base, width);
+		memcpy(base, tmp, width * sizeof(*base));
+	}
+}
+
+/** CRC of A || B from CRC(A) and CRC(B), @op is the shift op of len(B) */
+static inline uint64_t
+csum_crc_combine(const uint64_t *op, uint64_t crc1, uint64_t crc2)
+{
+	/* nothing to shift for the leading chunk */
+	if (crc1 == 0)
+		return crc2;
+
+	return csum_gf2_times(op, crc1) ^ crc2;
+}
+
+static inline uint64_t
+csum_crc_buf(int type, const void *buf, uint64_t len, uint64_t seed)
+{
+	if (type == DAOS_CS_CRC64)
+		return crc64_ecma_refl(seed, (const unsigned char *)buf, len);
+
+	return crc32_iscsi((unsigned char *)buf, (int)len, (uint32_t)seed);
+}
+
+static inline uint64_t
+csum_crc_load(daos_csum_t *csum)
+{
+	if (csum->dc_csum == DAOS_CS_CRC64)
+		return *(uint64_t *)csum->dc_buf;
+
+	return *(uint32_t *)csum->dc_buf;
+}
+
+static inline void
+csum_crc_store(int type, void *buf, uint64_t crc)
+{
+	if (type == DAOS_CS_CRC64)
+		*(uint64_t *)buf = crc;
+	else
+		*(uint32_t *)buf = (uint32_t)crc;
+}
+
+/**
+ * Multi-buffer CRC32C: CSUM_MB_LANES chunks of the same length are walked in
+ * lock step, one crc32 instruction per lane per word. The lanes are
+ * independent dependency chains, so the 3-cycle latency of the instruction
+ * is hidden and a core retires one crc32 per cycle. There is no such
+ * instruction for CRC64/ECMA, whose ISA-L kernel already folds several
+ * streams with PCLMUL, so CRC64 chunks are still computed one by one.
+ */
+#define CSUM_MB_LANES	4
+
+static int	csum_mb_supported = -1;
+
+static inline bool
+csum_mb_enabled(int type)
+{
+	if (type != DAOS_CS_CRC32)
+		return false;
+
+	if (csum_mb_supported < 0)
+		csum_mb_supported = __builtin_cpu_supports("sse4.2");
+
+	return csum_mb_supported;
+}
+
+static inline uint64_t
+csum_load64(const char *buf)
+{
+	uint64_t	word;
+
+	memcpy(&word, buf, sizeof(word));
+	return word;
+}
+
+/**
+ * Checksum the CSUM_MB_LANES chunks of \a len bytes which start at \a buf,
+ * back to back, from a zero seed.
+ */
+__attribute__((target("sse4.2")))
+static void
+csum_crc32c_mb(const char *buf, daos_size_t len, uint64_t *crcs)
+{
+	const char	*p0 = buf;
+	const char	*p1 = p0 + len;
+	const char	*p2 = p1 + len;
+	const char	*p3 = p2 + len;
+	uint64_t	 c0 = 0;
+	uint64_t	 c1 = 0;
+	uint64_t	 c2 = 0;
+	uint64_t	 c3 = 0;
+	daos_size_t	 off;
+
+	for (off = 0; off + sizeof(uint64_t) <= len;
+	     off += sizeof(uint64_t)) {
+		c0 = _mm_crc32_u64(c0, csum_load64(p0 + off));
+		c1 = _mm_crc32_u64(c1, csum_load64(p1 + off));
+		c2 = _mm_crc32_u64(c2, csum_load64(p2 + off));
+		c3 = _mm_crc32_u64(c3, csum_load64(p3 + off));
+	}
+
+	for (; off < len; off++) {
+		c0 = _mm_crc32_u8(c0, p0[off]);
+		c1 = _mm_crc32_u8(c1, p1[off]);
+		c2 = _mm_crc32_u8(c2, p2[off]);
+		c3 = _mm_crc32_u8(c3, p3[off]);
+	}
+
+	crcs[0] = c0;
+	crcs[1] = c1;
+	crcs[2] = c2;
+	crcs[3] = c3;
+}
+#endif
+
+daos_size_t
+daos_csum_chunk_nr(daos_size_t len, daos_size_t chunk_size)
+{
+	if (chunk_size == 0)
+		return 0;
+
+	return (len + chunk_size - 1) / chunk_size;
+}
+
+int
+daos_csum_compute_chunks(daos_csum_t *csum, daos_sg_list_t *sgl,
+			 daos_size_t chunk_size, daos_csum_buf_t *chunks)
+{
+#if defined(__x86_64__)
+	uint64_t	 op[CSUM_GF2_DIM];
+	bool		 op_ready = false;
+	bool		 mb;
+	char		*out = NULL;
+	daos_size_t	 cs_size;
+	daos_size_t	 total = 0;
+	daos_size_t	 chunk_len = 0;
+	uint64_t	 chunk_crc = 0;
+	uint64_t	 crc;
+	unsigned int	 nr = 0;
+	int		 i;
+
+	if (!csum->dc_init)
+		return -DER_UNINIT;
+
+	if (chunk_size == 0)
+		return -DER_INVAL;
+
+	if (!sgl->sg_iovs)
+		return 0;
+
+	for (i = 0; i < sgl->sg_nr_out; i++) {
+		if (sgl->sg_iovs[i].iov_buf != NULL)
+			total += sgl->sg_iovs[i].iov_len;
+	}
+
+	cs_size = csum_dict[csum->dc_csum].cs_size;
+	if (chunks != NULL) {
+		if (chunks->cs_csum == NULL ||
+		    chunks->cs_buf_len <
+		    daos_csum_chunk_nr(total, chunk_size) * cs_size) {
+			D_ERROR("Chunk checksum buffer too small: %hu\n",
+				chunks->cs_buf_len);
+			return -DER_INVAL;
+		}
+		chunks->cs_type = csum->dc_csum;
+		out = chunks->cs_csum;
+	}
+
+	mb = csum_mb_enabled(csum->dc_csum);
+	crc = csum_crc_load(csum);
+	for (i = 0; i < sgl->sg_nr_out; i++) {
+		char		*buf = sgl->sg_iovs[i].iov_buf;
+		daos_size_t	 len = sgl->sg_iovs[i].iov_len;
+
+		if (buf == NULL || len == 0)
+			continue;
+
+		while (len > 0) {
+			daos_size_t	nob = min(len, chunk_size - chunk_len);
+
+			if (chunk_len == 0 && mb &&
+			    len >= CSUM_MB_LANES * chunk_size) {
+				uint64_t	crcs[CSUM_MB_LANES];
+				int		j;
+
+				csum_crc32c_mb(buf, chunk_size, crcs);
+				if (!op_ready) {
+					csum_crc_shift_op(csum->dc_csum,
+							  chunk_size, op);
+					op_ready = true;
+				}
+				for (j = 0; j < CSUM_MB_LANES; j++, nr++) {
+					if (out != NULL)
+						csum_crc_store(csum->dc_csum,
+							out + nr * cs_size,
+							crcs[j]);
+					crc = csum_crc_combine(op, crc,
+							       crcs[j]);
+				}
+				buf += CSUM_MB_LANES * chunk_size;
+				len -= CSUM_MB_LANES * chunk_size;
+				continue;
+			}
+
+			/* the tail of a chunk may straddle iovs */
+			chunk_crc = csum_crc_buf(csum->dc_csum, buf, nob,
+						 chunk_len ? chunk_crc : 0);
+			chunk_len += nob;
+			buf += nob;
+			len -= nob;
+			if (chunk_len < chunk_size)
+				continue;
+
+			if (out != NULL)
+				csum_crc_store(csum->dc_csum,
+					       out + nr * cs_size, chunk_crc);
+			if (crc != 0 && !op_ready) {
+				csum_crc_shift_op(csum->dc_csum, chunk_size,
+						  op);
+				op_ready = true;
+			}
+			crc = csum_crc_combine(op, crc, chunk_crc);
+			chunk_len = 0;
+			nr++;
+		}
+	}
+
+	if (chunk_len != 0) {
+		if (out != NULL)
+			csum_crc_store(csum->dc_csum, out + nr * cs_size,
+				       chunk_crc);
+		/* the tail chunk is shorter, it needs its own operator */
+		if (crc != 0)
+			csum_crc_shift_op(csum->dc_csum, chunk_len, op);
+		crc = csum_crc_combine(op, crc, chunk_crc);
+		nr++;
+	}
+
+	if (chunks != NULL)
+		chunks->cs_len = nr * cs_size;
+	csum_crc_store(csum->dc_csum, csum->dc_buf, crc);
+	return 0;
+#else
+	return -DER_NOSYS;
+#endif
+}
+
+int
+daos_csum_combine(daos_csum_t *csum, daos_csum_t *next, daos_size_t next_len)
+{
+#if defined(__x86_64__)
+	uint64_t	op[CSUM_GF2_DIM];
+	uint64_t	crc;
+
+	if (!csum->dc_init || !next->dc_init)
+		return -DER_UNINIT;
+
+	if (csum->dc_csum != next->dc_csum)
+		return -DER_INVAL;
+
+	if (next_len == 0)
+		return 0;
+
+	crc = csum_crc_load(csum);
+	if (crc != 0)
+		csum_crc_shift_op(csum->dc_csum, next_len, op);
+	crc = csum_crc_combine(op, crc, csum_crc_load(next));
+	csum_crc_store(csum->dc_csum, csum->dc_buf, crc);
+	return 0;
+#else
+	return -DER_NOSYS;
+#endif
+}
+
+int
+daos_csum_chunk_verify(daos_csum_t *csum, daos_csum_buf_t *chunks,
+		       unsigned int idx, const void *buf, daos_size_t len)
+{
+#if defined(__x86_64__)
+	daos_size_t	cs_size;
+	uint64_t	crc;
+	uint64_t	expected;
+
+	if (!csum->dc_init)
+		return -DER_UNINIT;
+
+	cs_size = csum_dict[csum->dc_csum].cs_size;
+	if (chunks->cs_type != csum->dc_csum ||
+	    (idx + 1) * cs_size > chunks->cs_len) {
+		D_ERROR("Invalid chunk %u, type %u/%d, len %hu\n",
+			idx, chunks->cs_type, csum->dc_csum, chunks->cs_len);
+		return -DER_INVAL;
+	}
+
+	crc = csum_crc_buf(csum->dc_csum, buf, len, 0);
+	if (csum->dc_csum == DAOS_CS_CRC64)
+		expected = ((uint64_t *)chunks->cs_csum)[idx];
+	else
+		expected = ((uint32_t *)chunks->cs_csum)[idx];
+
+	if (crc != expected) {
+		D_ERROR("Checksum mismatch on chunk %u: "DF_X64" != "DF_X64
+			"\n", idx, crc, expected);
+		return -DER_IO;
+	}
+	return 0;
+#else
+	return -DER_NOSYS;
+#endif
+}
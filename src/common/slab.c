@@ -0,0 +1,161 @@
+/**
+ * (C) Copyright 2019 Intel Corporation.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * GOVERNMENT LICENSE RIGHTS-OPEN SOURCE SOFTWARE
+ * The Government's rights to use, modify, reproduce, release, perform, display,
+ * or disclose this software are subject to the terms of the Apache License
+ * provided in Contract No. B609815.
+ * Any reproduction of computer software, computer software documentation, or
+ * portions thereof marked with this legend must also reproduce the markings.
+ */
+/**
+ * This file is part of daos
+ *
+ * common/slab.c
+ */
+#define D_LOGFAC	DD_FAC(common)
+
+#include <daos/slab.h>
+
+/** the slab cache of the calling xstream */
+static __thread struct daos_slab_cache	*slab_cache_tls;
+
+static const char *slab_names[DAOS_SLAB_MAX] = {
+	[DAOS_SLAB_BTR_CTX]	= "btr_ctx",
+	[DAOS_SLAB_EVT_CTX]	= "evt_ctx",
+	[DAOS_SLAB_EVT_ENTS]	= "evt_ents",
+	[DAOS_SLAB_VOS_IOC]	= "vos_ioc",
+	[DAOS_SLAB_DSS_RPC]	= "dss_rpc",
+};
+
+int
+daos_slab_cache_create(unsigned int max, struct daos_slab_cache **cache_p)
+{
+	struct daos_slab_cache	*cache;
+	int			 i;
+
+	D_ALLOC_PTR(cache);
+	if (cache == NULL)
+		return -DER_NOMEM;
+
+	for (i = 0; i < DAOS_SLAB_MAX; i++)
+		cache->sc_slabs[i].sl_max = max;
+
+	*cache_p = cache;
+	return 0;
+}
+
+void
+daos_slab_cache_destroy(struct daos_slab_cache *cache)
+{
+	int	i;
+
+	D_ASSERT(cache != slab_cache_tls);
+	for (i = 0; i < DAOS_SLAB_MAX; i++) {
+		struct daos_slab	*slab = &cache->sc_slabs[i];
+		void			*obj;
+
+		D_DEBUG(DB_MEM, "slab %s: hits "DF_U64", misses "DF_U64
+			", frees "DF_U64", drops "DF_U64"\n", slab_names[i],
+			slab->sl_stats.ss_hits, slab->sl_stats.ss_misses,
+			slab->sl_stats.ss_frees, slab->sl_stats.ss_drops);
+
+		while ((obj = slab->sl_free) != NULL) {
+			slab->sl_free = *(void **)obj;
+			D_FREE(obj);
+		}
+	}
+	D_FREE(cache);
+}
+
+void
+daos_slab_cache_bind(struct daos_slab_cache *cache)
+{
+	slab_cache_tls = cache;
+}
+
+struct daos_slab_cache *
+daos_slab_cache_current(void)
+{
+	return slab_cache_tls;
+}
+
+void
+daos_slab_query(struct daos_slab_cache *cache, enum daos_slab_type type,
+		struct daos_slab_stats *stats)
+{
+	D_ASSERT(type < DAOS_SLAB_MAX);
+	*stats = cache->sc_slabs[type].sl_stats;
+}
+
+void *
+daos_slab_alloc(enum daos_slab_type type, size_t size)
+{
+	struct daos_slab	*slab;
+	void			*obj;
+
+	D_ASSERT(type < DAOS_SLAB_MAX);
+	D_ASSERT(size >= sizeof(void *));
+	if (slab_cache_tls == NULL) {
+		D_ALLOC(obj, size);
+		return obj;
+	}
+
+	slab = &slab_cache_tls->sc_slabs[type];
+	if (slab->sl_size == 0)
+		slab->sl_size = size;
+	D_ASSERTF(slab->sl_size == size, "slab %s: size %zu/%zu\n",
+		  slab_names[type], slab->sl_size, size);
+
+	obj = slab->sl_free;
+	if (obj == NULL) {
+		slab->sl_stats.ss_misses++;
+		D_ALLOC(obj, size);
+		return obj;
+	}
+
+	slab->sl_free = *(void **)obj;
+	slab->sl_stats.ss_cached--;
+	slab->sl_stats.ss_hits++;
+	memset(obj, 0, size);
+	return obj;
+}
+
+void
+daos_slab_free(enum daos_slab_type type, void *ptr)
+{
+	struct daos_slab	*slab;
+
+	D_ASSERT(type < DAOS_SLAB_MAX);
+	if (ptr == NULL)
+		return;
+
+	if (slab_cache_tls == NULL) {
+		D_FREE(ptr);
+		return;
+	}
+
+	slab = &slab_cache_tls->sc_slabs[type];
+	if (slab->sl_stats.ss_cached >= slab->sl_max) {
+		slab->sl_stats.ss_drops++;
+		D_FREE(ptr);
+		return;
+	}
+
+	*(void **)ptr = slab->sl_free;
+	slab->sl_free = ptr;
+	slab->sl_stats.ss_cached++;
+	slab->sl_stats.ss_frees++;
+}
@@ -272,6 +272,9 @@ ik_btr_open_create(bool create, char *args)
 		if (args[0] == '+') {
 			feats = BTR_FEAT_UINT_KEY;
 			args += 1;
+		} else if (args[0] == '%') { /* integer key with key array */
+			feats = BTR_FEAT_UINT_KEY | BTR_FEAT_KEY_ARRAY;
+			args += 1;
 		}
 		if (args[0] == 'i') { /* inplace create/open */
 			inplace = true;
@@ -740,6 +743,178 @@ ik_btr_batch_oper(unsigned int key_nr)
 	return 0;
 }
 
+/**
+ * Insert @keys one by one to a reference tree with the same attributes as
+ * the bulk built tree, then probe both trees with every key in [0, key_max]
+ * and all probe opcodes, they should find the same records.
+ */
+static int
+ik_btr_bulk_verify(daos_iov_t *keys, daos_iov_t *vals, unsigned int key_nr,
+		   uint64_t key_max)
+{
+	static const dbtree_probe_opc_t opcs[] = {
+		BTR_PROBE_EQ, BTR_PROBE_GE, BTR_PROBE_LE, BTR_PROBE_GT,
+		BTR_PROBE_LT,
+	};
+	struct btr_attr	attr;
+	daos_handle_t	ref_toh;
+	uint64_t	key;
+	int		i;
+	int		rc;
+
+	rc = dbtree_query(ik_toh, &attr, NULL);
+	if (rc != 0) {
+		D_PRINT("Failed to query btree: %d\n", rc);
+		return -1;
+	}
+
+	rc = dbtree_create(IK_TREE_CLASS, attr.ba_feats, attr.ba_order,
+			   &ik_uma, NULL, &ref_toh);
+	if (rc != 0) {
+		D_PRINT("Failed to create reference tree: %d\n", rc);
+		return -1;
+	}
+
+	for (i = 0; i < key_nr; i++) {
+		rc = dbtree_update(ref_toh, &keys[i], &vals[i]);
+		if (rc != 0) {
+			D_PRINT("Reference update failed: %d\n", rc);
+			D_GOTO(out, rc = -1);
+		}
+	}
+
+	D_PRINT("Compare %d records with the reference tree.\n", key_nr);
+	for (key = 0; key <= key_max; key++) {
+		for (i = 0; i < ARRAY_SIZE(opcs); i++) {
+			daos_iov_t	key_iov;
+			daos_iov_t	kout[2];
+			daos_iov_t	vout[2];
+			int		rcs[2];
+
+			daos_iov_set(&key_iov, &key, sizeof(key));
+			daos_iov_set(&kout[0], NULL, 0);
+			daos_iov_set(&kout[1], NULL, 0);
+			daos_iov_set(&vout[0], NULL, 0);
+			daos_iov_set(&vout[1], NULL, 0);
+
+			rcs[0] = dbtree_fetch(ik_toh, opcs[i], &key_iov,
+					      &kout[0], &vout[0]);
+			rcs[1] = dbtree_fetch(ref_toh, opcs[i], &key_iov,
+					      &kout[1], &vout[1]);
+			if (rcs[0] != rcs[1] ||
+			    (rcs[0] == 0 &&
+			     (*(uint64_t *)kout[0].iov_buf !=
+			      *(uint64_t *)kout[1].iov_buf ||
+			      vout[0].iov_len != vout[1].iov_len ||
+			      memcmp(vout[0].iov_buf, vout[1].iov_buf,
+				     vout[0].iov_len) != 0))) {
+				D_PRINT("Probe "DF_U64" opc %d mismatch: "
+					"%d/%d\n", key, opcs[i], rcs[0],
+					rcs[1]);
+				D_GOTO(out, rc = -1);
+			}
+		}
+	}
+out:
+	dbtree_destroy(ref_toh);
+	return rc;
+}
+
+/**
+ * bulk btree operations:
+ * 1) bulk insert @key_nr number of sorted even integer keys to the empty tree
+ * 2) compare it with a tree which has the same keys inserted one by one
+ * 3) lookup and verify all the keys
+ * 4) bulk insert the same keys in random order, they are all updates
+ * 5) delete all the keys in random order
+ */
+static int
+ik_btr_bulk_oper(unsigned int key_nr)
+{
+	unsigned int	*arr;
+	uint64_t	*ukeys;
+	daos_iov_t	*keys;
+	daos_iov_t	*vals;
+	daos_iov_t	 val_iov;
+	int		 i;
+	int		 rc = 0;
+
+	if (key_nr == 0 || key_nr > (1U << 28)) {
+		D_PRINT("Invalid key number: %d\n", key_nr);
+		return -1;
+	}
+
+	D_ALLOC_ARRAY(arr, key_nr);
+	D_ALLOC_ARRAY(ukeys, key_nr);
+	D_ALLOC_ARRAY(keys, key_nr);
+	D_ALLOC_ARRAY(vals, key_nr);
+	D_ASSERT(arr != NULL && ukeys != NULL && keys != NULL && vals != NULL);
+
+	/* even keys leave holes for GT/LT probes of the reference check */
+	D_PRINT("Bulk insert %d sorted records.\n", key_nr);
+	for (i = 0; i < key_nr; i++) {
+		ukeys[i] = 2 * (i + 1);
+		daos_iov_set(&keys[i], &ukeys[i], sizeof(ukeys[i]));
+		daos_iov_set(&vals[i], &ukeys[i], sizeof(ukeys[i]));
+	}
+	rc = dbtree_bulk_insert(ik_toh, key_nr, keys, vals);
+	if (rc != 0) {
+		D_PRINT("Bulk insert failed: %d\n", rc);
+		D_GOTO(out, rc = -1);
+	}
+	ik_btr_query();
+
+	rc = ik_btr_bulk_verify(keys, vals, key_nr, 2 * key_nr + 1);
+	if (rc != 0)
+		D_GOTO(out, rc = -1);
+
+	D_PRINT("Bulk lookup %d records.\n", key_nr);
+	ik_btr_gen_keys(arr, key_nr);
+	for (i = 0; i < key_nr; i++) {
+		uint64_t	key = 2 * arr[i];
+
+		daos_iov_set(&keys[0], &key, sizeof(key));
+		daos_iov_set(&val_iov, NULL, 0);
+		rc = dbtree_lookup(ik_toh, &keys[0], &val_iov);
+		if (rc != 0 || val_iov.iov_len != sizeof(key) ||
+		    *(uint64_t *)val_iov.iov_buf != key) {
+			D_PRINT("Bulk lookup "DF_U64" failed: %d\n", key, rc);
+			D_GOTO(out, rc = -1);
+		}
+	}
+
+	D_PRINT("Bulk update %d unsorted records.\n", key_nr);
+	for (i = 0; i < key_nr; i++) {
+		ukeys[i] = 2 * arr[i];
+		daos_iov_set(&keys[i], &ukeys[i], sizeof(ukeys[i]));
+	}
+	rc = dbtree_bulk_insert(ik_toh, key_nr, keys, vals);
+	if (rc != 0) {
+		D_PRINT("Bulk update failed: %d\n", rc);
+		D_GOTO(out, rc = -1);
+	}
+
+	D_PRINT("Delete %d records.\n", key_nr);
+	ik_btr_gen_keys(arr, key_nr);
+	for (i = 0; i < key_nr; i++) {
+		uint64_t	key = 2 * arr[i];
+
+		daos_iov_set(&keys[0], &key, sizeof(key));
+		rc = dbtree_delete(ik_toh, &keys[0], NULL);
+		if (rc != 0) {
+			D_PRINT("Delete "DF_U64" failed: %d\n", key, rc);
+			D_GOTO(out, rc = -1);
+		}
+	}
+	ik_btr_query();
+out:
+	D_FREE(vals);
+	D_FREE(keys);
+	D_FREE(ukeys);
+	D_FREE(arr);
+	return rc;
+}
+
 static int
 ik_btr_perf(unsigned int key_nr)
 {
@@ -793,7 +968,27 @@ ik_btr_perf(unsigned int key_nr)
 	now = dts_time_now();
 	D_PRINT("lookup = %10.2f/sec\n", key_nr / (now - then));
 
-	/* step-3: delete performance */
+	/* step-3: probe performance, no string parsing */
+	ik_btr_gen_keys(arr, key_nr);
+	then = dts_time_now();
+
+	for (i = 0; i < key_nr; i++) {
+		daos_iov_t	key_iov;
+		daos_iov_t	val_iov;
+		uint64_t	key = arr[i];
+
+		daos_iov_set(&key_iov, &key, sizeof(key));
+		daos_iov_set(&val_iov, NULL, 0);
+		rc = dbtree_lookup(ik_toh, &key_iov, &val_iov);
+		if (rc != 0) {
+			D_PRINT("probe failed: %d\n", rc);
+			D_GOTO(out, rc = -1);
+		}
+	}
+	now = dts_time_now();
+	D_PRINT("probe  = %10.2f/sec\n", key_nr / (now - then));
+
+	/* step-4: delete performance */
 	ik_btr_gen_keys(arr, key_nr);
 	then = dts_time_now();
 
@@ -826,6 +1021,7 @@ static struct option btr_ops[] = {
 	{ "query",	no_argument,		NULL,	'q'	},
 	{ "iterate",	required_argument,	NULL,	'i'	},
 	{ "batch",	required_argument,	NULL,	'b'	},
+	{ "bulk",	required_argument,	NULL,	'B'	},
 	{ "perf",	required_argument,	NULL,	'p'	},
 	{ NULL,		0,			NULL,	0	},
 };
@@ -843,12 +1039,14 @@ main(int argc, char **argv)
 	if (rc != 0)
 		return rc;
 
-	rc = dbtree_class_register(IK_TREE_CLASS, BTR_FEAT_UINT_KEY, &ik_ops);
+	rc = dbtree_class_register(IK_TREE_CLASS,
+				   BTR_FEAT_UINT_KEY | BTR_FEAT_KEY_ARRAY,
+				   &ik_ops);
 	D_ASSERT(rc == 0);
 
 	optind = 0;
 	ik_uma.uma_id = UMEM_CLASS_VMEM;
-	while ((rc = getopt_long(argc, argv, "mC:Docqu:d:r:f:i:b:p:",
+	while ((rc = getopt_long(argc, argv, "mC:Docqu:d:r:f:i:b:B:p:",
 				 btr_ops, NULL)) != -1) {
 		switch (rc) {
 		case 'C':
@@ -885,6 +1083,9 @@ main(int argc, char **argv)
 		case 'b':
 			rc = ik_btr_batch_oper(atoi(optarg));
 			break;
+		case 'B':
+			rc = ik_btr_bulk_oper(atoi(optarg));
+			break;
 		case 'p':
 			rc = ik_btr_perf(atoi(optarg));
 			break;
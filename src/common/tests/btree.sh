@@ -30,7 +30,9 @@ Usage: btree.sh [OPTIONS]
     Options:
         -s [num]  Run with num keys
         ukey      Use integer keys
+        keyarray  Use the key array node layout (integer keys unless direct)
         perf      Run performance tests
+        probe     Compare performance of record and key array layouts
         direct    Use direct string key
 EOF
     exit 1
@@ -57,6 +59,14 @@ while [ $# -gt 0 ]; do
         shift
         UINT="+"
         ;;
+    keyarray)
+        shift
+        UINT="%"
+        ;;
+    probe)
+        shift
+        PERF="probe"
+        ;;
     direct)
         BTR=$DAOS_DIR/build/src/common/tests/btree_direct
         KEYS=${KEYS:-"delta,lambda,kappa,omega,beta,alpha,epsilon"}
@@ -73,7 +83,15 @@ done
 
 set -x
 
-if [ -z ${PERF} ]; then
+if [ "x$PERF" == "xprobe" ]; then
+
+    for layout in "+" "%"; do
+        echo "B+tree probe test, layout ${layout}..."
+        "$BTR" -C "${layout}${IPL}o:$ORDER" \
+        -p "$BAT_NUM"                       \
+        -D
+    done
+elif [ -z ${PERF} ]; then
 
     echo "B+tree functional test..."
     DAOS_DEBUG="$DDEBUG"              \
@@ -100,6 +118,13 @@ if [ -z ${PERF} ]; then
     -o                                \
     -b "$BAT_NUM"                     \
     -D
+
+    echo "B+tree bulk operations test..."
+    "$BTR" -C "${UINT}${IPL}o:$ORDER" \
+    -c                                \
+    -o                                \
+    -B "$BAT_NUM"                     \
+    -D
 else
     echo "B+tree performance test..."
     "$BTR" -C "${UINT}${IPL}o:$ORDER" \
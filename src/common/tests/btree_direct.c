@@ -26,6 +26,7 @@
 #include <stdlib.h>
 #include <fcntl.h>
 #include <string.h>
+#include <ctype.h>
 #include <errno.h>
 #include <sys/types.h>
 #include <sys/stat.h>
@@ -110,6 +111,40 @@ sk_key_cmp(struct btr_instance *tins, struct btr_record *rec,
 	return dbtree_key_cmp_rc(strncmp(s1, s2, len));
 }
 
+/**
+ * Case folded leading bytes of the key, it orders keys the same way as
+ * strncasecmp() in sk_key_cmp(), ties are resolved by sk_key_cmp().
+ */
+static uint64_t
+sk_key_prefix(struct btr_instance *tins, struct btr_record *rec,
+	      daos_iov_t *key_iov)
+{
+	struct sk_rec	*srec;
+	char		*str;
+	uint64_t	 len;
+	uint64_t	 prefix = 0;
+	int		 i;
+
+	if (rec != NULL) {
+		srec = (struct sk_rec *)umem_id2ptr(&tins->ti_umm,
+						    rec->rec_mmid);
+		str = &srec->sr_key[0];
+		len = srec->sr_key_len;
+	} else {
+		str = key_iov->iov_buf;
+		len = key_iov->iov_len;
+	}
+
+	for (i = 0; i < sizeof(prefix); i++) {
+		prefix <<= 8;
+		if (i < len && str[i] != '\0')
+			prefix |= (unsigned char)tolower(str[i]);
+		else
+			len = 0;
+	}
+	return prefix;
+}
+
 static int
 sk_rec_alloc(struct btr_instance *tins, daos_iov_t *key_iov,
 	      daos_iov_t *val_iov, struct btr_record *rec)
@@ -270,6 +305,7 @@ sk_rec_stat(struct btr_instance *tins, struct btr_record *rec,
 
 static btr_ops_t sk_ops = {
 	.to_key_cmp	= sk_key_cmp,
+	.to_key_prefix	= sk_key_prefix,
 	.to_key_encode	= sk_key_encode,
 	.to_key_decode	= sk_key_decode,
 	.to_rec_alloc	= sk_rec_alloc,
@@ -304,6 +340,10 @@ sk_btr_open_create(bool create, char *args)
 	}
 
 	if (create && args != NULL) {
+		if (args[0] == '%') { /* direct key with key array */
+			feats |= BTR_FEAT_KEY_ARRAY;
+			args += 1;
+		}
 		if (args[0] == 'i') { /* inplace create/open */
 			inplace = true;
 			if (args[1] != SK_SEP) {
@@ -1067,7 +1107,9 @@ main(int argc, char **argv)
 	if (rc != 0)
 		return rc;
 
-	rc = dbtree_class_register(SK_TREE_CLASS, BTR_FEAT_DIRECT_KEY, &sk_ops);
+	rc = dbtree_class_register(SK_TREE_CLASS,
+				   BTR_FEAT_DIRECT_KEY | BTR_FEAT_KEY_ARRAY,
+				   &sk_ops);
 	D_ASSERT(rc == 0);
 
 	optind = 0;
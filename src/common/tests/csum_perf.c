@@ -0,0 +1,300 @@
+/**
+ * (C) Copyright 2019 Intel Corporation.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * GOVERNMENT LICENSE RIGHTS-OPEN SOURCE SOFTWARE
+ * The Government's rights to use, modify, reproduce, release, perform, display,
+ * or disclose this software are subject to the terms of the Apache License as
+ * provided in Contract No. B609815.
+ * Any reproduction of computer software, computer software documentation, or
+ * portions thereof marked with this legend must also reproduce the markings.
+ */
+/**
+ * Checksum micro-benchmark, it compares bytes per cycle of the serial
+ * checksum path (daos_csum_compute), the chunked path
+ * (daos_csum_compute_chunks) and the chunked path spread over threads, whose
+ * segment checksums are merged with daos_csum_combine().
+ */
+#define D_LOGFAC	DD_FAC(tests)
+
+#include <getopt.h>
+#include <pthread.h>
+#include <x86intrin.h>
+#include <daos/checksum.h>
+
+#define CSP_IOV_NR	4
+
+static daos_size_t	opt_size	= (1 << 20);
+static daos_size_t	opt_chunk	= (32 << 10);
+static int		opt_iters	= 1000;
+static int		opt_threads	= 4;
+
+#define CSP_THREADS_MAX	64
+
+struct csp_segment {
+	pthread_t	 cg_thread;
+	daos_csum_t	 cg_csum;
+	char		*cg_buf;
+	daos_size_t	 cg_len;
+	int		 cg_rc;
+};
+
+static double
+csp_bytes_per_cycle(daos_csum_t *csum, daos_sg_list_t *sgl,
+		    daos_size_t chunk_size, daos_csum_buf_t *chunks)
+{
+	uint64_t	start;
+	uint64_t	cycles;
+	int		i;
+	int		rc;
+
+	daos_csum_reset(csum);
+	start = __rdtsc();
+	for (i = 0; i < opt_iters; i++) {
+		if (chunk_size == 0)
+			rc = daos_csum_compute(csum, sgl);
+		else
+			rc = daos_csum_compute_chunks(csum, sgl, chunk_size,
+						      chunks);
+		if (rc != 0) {
+			fprintf(stderr, "checksum failed: %d\n", rc);
+			return 0;
+		}
+	}
+	cycles = __rdtsc() - start;
+
+	return (double)opt_size * opt_iters / cycles;
+}
+
+static void *
+csp_segment_ult(void *arg)
+{
+	struct csp_segment	*seg = arg;
+	daos_iov_t		 iov;
+	daos_sg_list_t		 sgl;
+
+	daos_iov_set(&iov, seg->cg_buf, seg->cg_len);
+	sgl.sg_nr = sgl.sg_nr_out = 1;
+	sgl.sg_iovs = &iov;
+
+	daos_csum_reset(&seg->cg_csum);
+	seg->cg_rc = daos_csum_compute_chunks(&seg->cg_csum, &sgl, opt_chunk,
+					      NULL);
+	return NULL;
+}
+
+/**
+ * Cut \a buf into one chunk aligned segment per thread, checksum the segments
+ * concurrently and combine them in order into \a csum.
+ */
+static double
+csp_parallel_bytes_per_cycle(char *cs_name, daos_csum_t *csum, char *buf)
+{
+	struct csp_segment	 segs[CSP_THREADS_MAX];
+	daos_size_t		 seg_len;
+	uint64_t		 start;
+	uint64_t		 cycles;
+	int			 nr = opt_threads;
+	int			 i;
+	int			 j;
+	int			 rc;
+
+	seg_len = daos_csum_chunk_nr(opt_size, opt_chunk * nr) * opt_chunk;
+	for (i = 0; i < nr; i++) {
+		rc = daos_csum_init(cs_name, &segs[i].cg_csum);
+		if (rc != 0)
+			return 0;
+		segs[i].cg_buf = buf + i * seg_len;
+		segs[i].cg_len = i * seg_len >= opt_size ? 0 :
+				 min(seg_len, opt_size - i * seg_len);
+	}
+
+	daos_csum_reset(csum);
+	start = __rdtsc();
+	for (i = 0; i < opt_iters; i++) {
+		for (j = 0; j < nr; j++)
+			pthread_create(&segs[j].cg_thread, NULL,
+				       csp_segment_ult, &segs[j]);
+		for (j = 0; j < nr; j++) {
+			pthread_join(segs[j].cg_thread, NULL);
+			if (segs[j].cg_rc != 0) {
+				fprintf(stderr, "checksum failed: %d\n",
+					segs[j].cg_rc);
+				return 0;
+			}
+			daos_csum_combine(csum, &segs[j].cg_csum,
+					  segs[j].cg_len);
+		}
+	}
+	cycles = __rdtsc() - start;
+
+	for (i = 0; i < nr; i++)
+		daos_csum_free(&segs[i].cg_csum);
+
+	return (double)opt_size * opt_iters / cycles;
+}
+
+static int
+csp_run(char *cs_name)
+{
+	daos_csum_t	 serial;
+	daos_csum_t	 chunked;
+	daos_csum_t	 parallel;
+	daos_csum_buf_t	 chunks;
+	daos_iov_t	 iovs[CSP_IOV_NR];
+	daos_sg_list_t	 sgl;
+	char		*buf;
+	daos_size_t	 chunk_nr;
+	double		 serial_bpc;
+	double		 chunked_bpc;
+	double		 parallel_bpc;
+	int		 i;
+	int		 rc;
+
+	rc = daos_csum_init(cs_name, &serial);
+	if (rc != 0)
+		return rc;
+
+	rc = daos_csum_init(cs_name, &chunked);
+	if (rc != 0)
+		goto out_serial;
+
+	rc = daos_csum_init(cs_name, &parallel);
+	if (rc != 0)
+		goto out_chunked;
+
+	D_ALLOC(buf, opt_size);
+	if (buf == NULL)
+		D_GOTO(out_parallel, rc = -DER_NOMEM);
+
+	for (i = 0; i < opt_size; i++)
+		buf[i] = rand();
+
+	/* unaligned iovs, so chunks straddle iov boundaries */
+	sgl.sg_nr = sgl.sg_nr_out = CSP_IOV_NR;
+	sgl.sg_iovs = iovs;
+	for (i = 0; i < CSP_IOV_NR; i++) {
+		daos_size_t	len = opt_size / CSP_IOV_NR;
+
+		if (i == CSP_IOV_NR - 1)
+			len = opt_size - i * len;
+		daos_iov_set(&iovs[i], buf + i * (opt_size / CSP_IOV_NR), len);
+	}
+
+	chunk_nr = daos_csum_chunk_nr(opt_size, opt_chunk);
+	chunks.cs_buf_len = chunk_nr * daos_csum_get_size(&chunked);
+	D_ALLOC(chunks.cs_csum, chunks.cs_buf_len);
+	if (chunks.cs_csum == NULL)
+		D_GOTO(out_buf, rc = -DER_NOMEM);
+
+	serial_bpc = csp_bytes_per_cycle(&serial, &sgl, 0, NULL);
+	chunked_bpc = csp_bytes_per_cycle(&chunked, &sgl, opt_chunk, &chunks);
+	parallel_bpc = csp_parallel_bytes_per_cycle(cs_name, &parallel, buf);
+
+	if (!daos_csum_compare(&serial, &chunked)) {
+		fprintf(stderr, "%s: chunked checksum mismatch\n", cs_name);
+		D_GOTO(out_chunks, rc = -DER_IO);
+	}
+
+	if (!daos_csum_compare(&serial, &parallel)) {
+		fprintf(stderr, "%s: parallel checksum mismatch\n", cs_name);
+		D_GOTO(out_chunks, rc = -DER_IO);
+	}
+
+	for (i = 0; i < chunk_nr; i++) {
+		rc = daos_csum_chunk_verify(&chunked, &chunks, i,
+					    buf + i * opt_chunk,
+					    min(opt_chunk,
+						opt_size - i * opt_chunk));
+		if (rc != 0) {
+			fprintf(stderr, "%s: chunk %d verify failed\n",
+				cs_name, i);
+			D_GOTO(out_chunks, rc);
+		}
+	}
+
+	printf("%-6s size "DF_U64" chunk "DF_U64": serial %.3f B/cycle, "
+	       "chunked %.3f B/cycle (%u chunks), %d threads %.3f B/cycle\n",
+	       cs_name, opt_size, opt_chunk, serial_bpc, chunked_bpc,
+	       (unsigned int)chunk_nr, opt_threads, parallel_bpc);
+out_chunks:
+	D_FREE(chunks.cs_csum);
+out_buf:
+	D_FREE(buf);
+out_parallel:
+	daos_csum_free(&parallel);
+out_chunked:
+	daos_csum_free(&chunked);
+out_serial:
+	daos_csum_free(&serial);
+	return rc;
+}
+
+static struct option csp_ops[] = {
+	/** total size of the checksummed SGL */
+	{ "size",	required_argument,	NULL,	's'	},
+	/** chunk size of the chunked checksum */
+	{ "chunk",	required_argument,	NULL,	'c'	},
+	/** number of iterations */
+	{ "iters",	required_argument,	NULL,	'i'	},
+	/** number of threads of the parallel path */
+	{ "threads",	required_argument,	NULL,	't'	},
+	{ NULL,		0,			NULL,	0	},
+};
+
+int
+main(int argc, char **argv)
+{
+	int	rc;
+
+	while ((rc = getopt_long(argc, argv, "s:c:i:t:",
+				 csp_ops, NULL)) != -1) {
+		switch (rc) {
+		default:
+			fprintf(stderr, "unknown opc=%c\n", rc);
+			exit(-1);
+		case 's':
+			opt_size = strtoul(optarg, NULL, 0);
+			break;
+		case 'c':
+			opt_chunk = strtoul(optarg, NULL, 0);
+			break;
+		case 'i':
+			opt_iters = atoi(optarg);
+			break;
+		case 't':
+			opt_threads = atoi(optarg);
+			break;
+		}
+	}
+
+	if (opt_size == 0 || opt_chunk == 0 || opt_iters <= 0 ||
+	    opt_threads <= 0 || opt_threads > CSP_THREADS_MAX) {
+		fprintf(stderr, "invalid size/chunk/iterations/threads\n");
+		return -1;
+	}
+
+	/* each chunk checksum has to fit in daos_csum_buf_t::cs_buf_len */
+	if (daos_csum_chunk_nr(opt_size, opt_chunk) * sizeof(uint64_t) >
+	    (unsigned short)-1) {
+		fprintf(stderr, "too many chunks, use a larger chunk size\n");
+		return -1;
+	}
+
+	rc = csp_run("crc32");
+	if (rc == 0)
+		rc = csp_run("crc64");
+
+	return rc;
+}
@@ -0,0 +1,89 @@
+/**
+ * (C) Copyright 2019 Intel Corporation.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * GOVERNMENT LICENSE RIGHTS-OPEN SOURCE SOFTWARE
+ * The Government's rights to use, modify, reproduce, release, perform, display,
+ * or disclose this software are subject to the terms of the Apache License
+ * provided in Contract No. B609815.
+ * Any reproduction of computer software, computer software documentation, or
+ * portions thereof marked with this legend must also reproduce the markings.
+ */
+#define D_LOGFAC	DD_FAC(tests)
+
+#include <daos/common.h>
+#include <daos/slab.h>
+
+#define SLAB_TEST_SIZE	256
+#define SLAB_TEST_MAX	4
+#define SLAB_TEST_LOOPS	1000
+
+int
+main(int argc, char **argv)
+{
+	struct daos_slab_cache	*cache;
+	struct daos_slab_stats	 stats;
+	char			*objs[SLAB_TEST_MAX + 1];
+	int			 i;
+	int			 j;
+	int			 rc;
+
+	rc = daos_debug_init(NULL);
+	if (rc != 0)
+		return rc;
+
+	rc = daos_slab_cache_create(SLAB_TEST_MAX, &cache);
+	if (rc != 0)
+		D_GOTO(out, rc);
+
+	daos_slab_cache_bind(cache);
+	D_ASSERT(daos_slab_cache_current() == cache);
+
+	/* warm up, then the steady state should never touch the heap */
+	for (i = 0; i < SLAB_TEST_LOOPS; i++) {
+		for (j = 0; j < SLAB_TEST_MAX; j++) {
+			objs[j] = daos_slab_alloc(DAOS_SLAB_BTR_CTX,
+						  SLAB_TEST_SIZE);
+			D_ASSERT(objs[j] != NULL);
+			D_ASSERT(objs[j][SLAB_TEST_SIZE - 1] == 0);
+			memset(objs[j], 0xff, SLAB_TEST_SIZE);
+		}
+		for (j = 0; j < SLAB_TEST_MAX; j++)
+			daos_slab_free(DAOS_SLAB_BTR_CTX, objs[j]);
+	}
+
+	daos_slab_query(cache, DAOS_SLAB_BTR_CTX, &stats);
+	D_PRINT("hits "DF_U64", misses "DF_U64", cached %u\n",
+		stats.ss_hits, stats.ss_misses, stats.ss_cached);
+	D_ASSERT(stats.ss_misses == SLAB_TEST_MAX);
+	D_ASSERT(stats.ss_hits == (SLAB_TEST_LOOPS - 1) * SLAB_TEST_MAX);
+	D_ASSERT(stats.ss_cached == SLAB_TEST_MAX);
+
+	/* overflow the free list */
+	for (j = 0; j <= SLAB_TEST_MAX; j++)
+		objs[j] = daos_slab_alloc(DAOS_SLAB_BTR_CTX, SLAB_TEST_SIZE);
+	for (j = 0; j <= SLAB_TEST_MAX; j++)
+		daos_slab_free(DAOS_SLAB_BTR_CTX, objs[j]);
+
+	daos_slab_query(cache, DAOS_SLAB_BTR_CTX, &stats);
+	D_ASSERT(stats.ss_drops == 1);
+	D_ASSERT(stats.ss_cached == SLAB_TEST_MAX);
+
+	daos_slab_cache_bind(NULL);
+	daos_slab_cache_destroy(cache);
+	D_PRINT("slab test passed\n");
+out:
+	daos_debug_fini();
+	return rc;
+}
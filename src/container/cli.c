@@ -295,6 +295,7 @@ dc_cont_free(struct d_hlink *hlink)
 	dc = container_of(hlink, struct dc_cont, dc_hlink);
 	D_ASSERT(daos_hhash_link_empty(&dc->dc_hlink));
 	D_RWLOCK_DESTROY(&dc->dc_obj_list_lock);
+	D_MUTEX_DESTROY(&dc->dc_oid_lock);
 	D_ASSERT(d_list_empty(&dc->dc_po_list));
 	D_ASSERT(d_list_empty(&dc->dc_obj_list));
 	D_FREE(dc);
@@ -335,9 +336,15 @@ dc_cont_alloc(const uuid_t uuid)
 	uuid_copy(dc->dc_uuid, uuid);
 	D_INIT_LIST_HEAD(&dc->dc_obj_list);
 	D_INIT_LIST_HEAD(&dc->dc_po_list);
+	dc->dc_oid_lease = CONT_OID_LEASE_MIN;
 	if (D_RWLOCK_INIT(&dc->dc_obj_list_lock, NULL) != 0) {
-		free(dc);
-		dc = NULL;
+		D_FREE(dc);
+		return NULL;
+	}
+	if (D_MUTEX_INIT(&dc->dc_oid_lock, NULL) != 0) {
+		D_RWLOCK_DESTROY(&dc->dc_obj_list_lock);
+		D_FREE(dc);
+		return NULL;
 	}
 
 	return dc;
@@ -788,6 +795,10 @@ cont_query_complete(tse_task_t *task, void *data)
 	arg->cqa_info->ci_nsnapshots = 0;
 	arg->cqa_info->ci_snapshots = NULL;
 	arg->cqa_info->ci_lsnapshot = 0;
+	arg->cqa_info->ci_agg_objs = out->cqo_agg_objs;
+	arg->cqa_info->ci_agg_recs = out->cqo_agg_recs;
+	arg->cqa_info->ci_agg_bytes = out->cqo_agg_bytes;
+	arg->cqa_info->ci_agg_merged = out->cqo_agg_merged;
 
 out:
 	crt_req_decref(arg->rpc);
@@ -866,15 +877,81 @@ err:
 	return rc;
 }
 
+/*
+ * A client leases more OIDs than asked for and serves the following
+ * allocations from the leftover. The lease doubles if it is used up within
+ * CONT_OID_LEASE_FAST seconds, and halves if it lasts more than
+ * CONT_OID_LEASE_SLOW seconds.
+ */
+#define CONT_OID_LEASE_MIN	32
+#define CONT_OID_LEASE_MAX	(1ULL << 16)
+#define CONT_OID_LEASE_FAST	1
+#define CONT_OID_LEASE_SLOW	10
+
 struct cont_oid_alloc_args {
 	struct dc_pool		*coaa_pool;
 	struct dc_cont		*coaa_cont;
 	crt_rpc_t		*rpc;
 	daos_handle_t		hdl;
 	daos_size_t		num_oids;
+	/* # OIDs requested from the server, including the lease */
+	daos_size_t		coaa_lease;
 	uint64_t		*oid;
 };
 
+/* Serve \a num_oids OIDs from the lease of \a cont, if there are enough. */
+static bool
+cont_oid_lease_get(struct dc_cont *cont, daos_size_t num_oids, uint64_t *oid)
+{
+	bool found = false;
+
+	D_MUTEX_LOCK(&cont->dc_oid_lock);
+	if (cont->dc_oid_left >= num_oids) {
+		*oid = cont->dc_oid_next;
+		cont->dc_oid_next += num_oids;
+		cont->dc_oid_left -= num_oids;
+		found = true;
+	}
+	D_MUTEX_UNLOCK(&cont->dc_oid_lock);
+	return found;
+}
+
+/* Return the # OIDs to lease for the allocation of \a num_oids. */
+static daos_size_t
+cont_oid_lease_size(struct dc_cont *cont, daos_size_t num_oids)
+{
+	time_t		now = time(NULL);
+	daos_size_t	lease;
+
+	D_MUTEX_LOCK(&cont->dc_oid_lock);
+	if (cont->dc_oid_refill != 0) {
+		if (now - cont->dc_oid_refill <= CONT_OID_LEASE_FAST &&
+		    cont->dc_oid_lease < CONT_OID_LEASE_MAX)
+			cont->dc_oid_lease *= 2;
+		else if (now - cont->dc_oid_refill > CONT_OID_LEASE_SLOW &&
+			 cont->dc_oid_lease > CONT_OID_LEASE_MIN)
+			cont->dc_oid_lease /= 2;
+	}
+	cont->dc_oid_refill = now;
+	lease = cont->dc_oid_lease;
+	D_MUTEX_UNLOCK(&cont->dc_oid_lock);
+
+	return num_oids + lease;
+}
+
+/* Keep the OIDs leased beyond the allocation for the next allocations. */
+static void
+cont_oid_lease_put(struct dc_cont *cont, uint64_t oid, daos_size_t num_oids)
+{
+	D_MUTEX_LOCK(&cont->dc_oid_lock);
+	/* Concurrent refills may race, keep the larger leftover. */
+	if (num_oids > cont->dc_oid_left) {
+		cont->dc_oid_next = oid;
+		cont->dc_oid_left = num_oids;
+	}
+	D_MUTEX_UNLOCK(&cont->dc_oid_lock);
+}
+
 static int
 pool_query_cb(tse_task_t *task, void *data)
 {
@@ -954,6 +1031,8 @@ cont_oid_alloc_complete(tse_task_t *task, void *data)
 
 	if (arg->oid)
 		*arg->oid = out->oid;
+	cont_oid_lease_put(cont, out->oid + arg->num_oids,
+			   arg->coaa_lease - arg->num_oids);
 
 out:
 	crt_req_decref(arg->rpc);
@@ -1005,6 +1084,13 @@ dc_cont_alloc_oids(tse_task_t *task)
 	if (cont == NULL)
 		D_GOTO(err, rc = -DER_NO_HDL);
 
+	/* Most allocations are served by the lease, without any RPC. */
+	if (cont_oid_lease_get(cont, args->num_oids, args->oid)) {
+		dc_cont_put(cont);
+		tse_task_complete(task, 0);
+		return 0;
+	}
+
 	pool = dc_hdl2pool(cont->dc_pool_hdl);
 	D_ASSERT(pool != NULL);
 
@@ -1029,13 +1115,14 @@ dc_cont_alloc_oids(tse_task_t *task)
 	uuid_copy(in->coai_op.ci_pool_hdl, pool->dp_pool_hdl);
 	uuid_copy(in->coai_op.ci_uuid, cont->dc_uuid);
 	uuid_copy(in->coai_op.ci_hdl, cont->dc_cont_hdl);
-	in->num_oids = args->num_oids;
+	in->num_oids = cont_oid_lease_size(cont, args->num_oids);
 
 	arg.coaa_pool	= pool;
 	arg.coaa_cont	= cont;
 	arg.rpc		= rpc;
 	arg.hdl		= args->coh;
 	arg.num_oids	= args->num_oids;
+	arg.coaa_lease	= in->num_oids;
 	arg.oid		= args->oid;
 	crt_req_addref(rpc);
 
@@ -43,6 +43,13 @@ struct dc_cont {
 	uint64_t	  dc_capas;
 	/* pool handler of the container */
 	daos_handle_t	  dc_pool_hdl;
+	/* OIDs leased from the servers, see dc_cont_alloc_oids() */
+	pthread_mutex_t	  dc_oid_lock;
+	uint64_t	  dc_oid_next;
+	uint64_t	  dc_oid_left;
+	/* # OIDs to lease on next refill, adapted to the allocation rate */
+	uint64_t	  dc_oid_lease;
+	time_t		  dc_oid_refill;
 	uint32_t	  dc_closing:1,
 			  dc_slave:1; /* generated via g2l */
 };
@@ -0,0 +1,448 @@
+/**
+ * (C) Copyright 2018 Intel Corporation.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * GOVERNMENT LICENSE RIGHTS-OPEN SOURCE SOFTWARE
+ * The Government's rights to use, modify, reproduce, release, perform, display,
+ * or disclose this software are subject to the terms of the Apache License as
+ * provided in Contract No. B609815.
+ * Any reproduction of computer software, computer software documentation, or
+ * portions thereof marked with this legend must also reproduce the markings.
+ */
+/**
+ * ds_cont: Container handle capability IV
+ *
+ * Container open does not broadcast the new handle to the targets any more.
+ * A target looks the capabilities of an unknown handle up through the pool
+ * IV namespace the first time the handle is used, the root (colocated with
+ * the container service leader) reads them from the container handle KVS,
+ * and every node on the way caches them.
+ *
+ * Closing a handle revokes it on every node: the cached capabilities are
+ * dropped, and the handle is remembered for CONT_IV_REVOKE_TTL seconds, so
+ * that a lookup racing with the close can neither be served by the root nor
+ * cached on the way back.
+ */
+#define D_LOGFAC	DD_FAC(container)
+
+#include <abt.h>
+#include <cart/iv.h>
+#include <daos/common.h>
+#include <gurt/list.h>
+#include <daos_srv/iv.h>
+#include "srv_internal.h"
+
+/* Seconds a revoked handle stays revoked on a node */
+#define CONT_IV_REVOKE_TTL	60.0
+
+static d_rank_t		myrank;
+
+struct cont_iv_key {
+	/** Pool uuid, needed at the root to find the container service */
+	uuid_t		pool_uuid;
+	/** Container handle uuid */
+	uuid_t		coh_uuid;
+};
+
+/** IV cache entry will be represented by this structure on each node. */
+struct cont_iv_entry {
+	/** link in cont_iv_entry_list */
+	d_list_t		link;
+	/** value of the IV entry */
+	struct cont_iv_capa	capa;
+	/** \a capa has been looked up and not revoked since */
+	bool			valid;
+};
+
+/** A revoked container handle */
+struct cont_iv_revoked {
+	d_list_t		cir_link;
+	uuid_t			cir_coh_uuid;
+	double			cir_time;
+};
+
+/**
+ * All the cache entries and the revoked handles of this node, the latter in
+ * revocation order. Both protected by cont_iv_lock, as are the entries.
+ */
+static d_list_t			cont_iv_entry_list;
+static d_list_t			cont_iv_revoked_list;
+static ABT_mutex		cont_iv_lock;
+
+static struct cont_iv_key *
+key2priv(struct ds_iv_key *iv_key)
+{
+	return (struct cont_iv_key *)iv_key->key_buf;
+}
+
+/* Drop the expired revocations, with cont_iv_lock held. */
+static void
+cont_iv_revoked_prune(double now)
+{
+	struct cont_iv_revoked	*rvk;
+	struct cont_iv_revoked	*tmp;
+
+	d_list_for_each_entry_safe(rvk, tmp, &cont_iv_revoked_list,
+				   cir_link) {
+		if (now - rvk->cir_time <= CONT_IV_REVOKE_TTL)
+			break;
+		d_list_del(&rvk->cir_link);
+		D_FREE(rvk);
+	}
+}
+
+/* Has \a coh_uuid been revoked on this node? With cont_iv_lock held. */
+static bool
+cont_iv_revoked_locked(const uuid_t coh_uuid)
+{
+	struct cont_iv_revoked	*rvk;
+
+	cont_iv_revoked_prune(ABT_get_wtime());
+	d_list_for_each_entry(rvk, &cont_iv_revoked_list, cir_link)
+		if (uuid_compare(rvk->cir_coh_uuid, coh_uuid) == 0)
+			return true;
+
+	return false;
+}
+
+/**
+ * Revoke container handle \a coh_uuid on this node: drop the capabilities
+ * cached for it, and refuse to look it up or to cache it again for
+ * CONT_IV_REVOKE_TTL seconds.
+ */
+int
+cont_iv_capa_revoke(const uuid_t coh_uuid)
+{
+	struct cont_iv_revoked	*rvk;
+	struct cont_iv_entry	*entry;
+	double			 now = ABT_get_wtime();
+
+	D_ALLOC_PTR(rvk);
+	if (rvk == NULL)
+		return -DER_NOMEM;
+
+	uuid_copy(rvk->cir_coh_uuid, coh_uuid);
+	rvk->cir_time = now;
+
+	ABT_mutex_lock(cont_iv_lock);
+	cont_iv_revoked_prune(now);
+	d_list_add_tail(&rvk->cir_link, &cont_iv_revoked_list);
+	d_list_for_each_entry(entry, &cont_iv_entry_list, link)
+		if (uuid_compare(entry->capa.cic_coh_uuid, coh_uuid) == 0)
+			entry->valid = false;
+	ABT_mutex_unlock(cont_iv_lock);
+
+	D_DEBUG(DF_DSMS, "revoked hdl="DF_UUID"\n", DP_UUID(coh_uuid));
+	return 0;
+}
+
+/** Has container handle \a coh_uuid been revoked on this node? */
+bool
+cont_iv_capa_revoked(const uuid_t coh_uuid)
+{
+	bool revoked;
+
+	ABT_mutex_lock(cont_iv_lock);
+	revoked = cont_iv_revoked_locked(coh_uuid);
+	ABT_mutex_unlock(cont_iv_lock);
+
+	return revoked;
+}
+
+static bool
+cont_iv_key_cmp(void *key1, void *key2)
+{
+	struct cont_iv_key *cont_key1 = key1;
+	struct cont_iv_key *cont_key2 = key2;
+
+	if (uuid_compare(cont_key1->pool_uuid, cont_key2->pool_uuid) == 0 &&
+	    uuid_compare(cont_key1->coh_uuid, cont_key2->coh_uuid) == 0)
+		return true;
+
+	return false;
+}
+
+static int
+cont_iv_ent_fetch(struct ds_iv_entry *entry, d_sg_list_t *dst, d_sg_list_t *src,
+		  void **priv)
+{
+	D_ASSERT(0);
+	return 0;
+}
+
+/* Cache \a capa in \a entry unless the handle has been revoked. */
+static int
+cont_iv_ent_cache(struct cont_iv_entry *entry, struct cont_iv_capa *capa)
+{
+	int rc = 0;
+
+	ABT_mutex_lock(cont_iv_lock);
+	if (cont_iv_revoked_locked(capa->cic_coh_uuid)) {
+		rc = -DER_NO_HDL;
+	} else {
+		entry->capa = *capa;
+		entry->valid = true;
+	}
+	ABT_mutex_unlock(cont_iv_lock);
+
+	return rc;
+}
+
+static int
+cont_iv_ent_refresh(d_sg_list_t *dst, d_sg_list_t *src, int ref_rc,
+		    void **priv)
+{
+	struct cont_iv_entry	*entry;
+
+	if (ref_rc != 0)
+		return ref_rc;
+
+	entry = dst->sg_iovs[0].iov_buf;
+	D_ASSERT(entry != NULL);
+
+	return cont_iv_ent_cache(entry, src->sg_iovs[0].iov_buf);
+}
+
+static int
+cont_iv_ent_update(struct ds_iv_entry *ns_entry, d_sg_list_t *dst,
+		   d_sg_list_t *src, void **priv)
+{
+	struct cont_iv_entry	*entry;
+	struct cont_iv_capa	*capa;
+	struct cont_iv_key	*key;
+	int			 rc = 0;
+
+	entry = dst->sg_iovs[0].iov_buf;
+	capa = src->sg_iovs[0].iov_buf;
+	key = key2priv(&ns_entry->iv_key);
+
+	ABT_mutex_lock(cont_iv_lock);
+	if (cont_iv_revoked_locked(key->coh_uuid))
+		rc = -DER_NO_HDL;
+	else if (entry->valid)
+		*capa = entry->capa;
+	else if (ns_entry->ns->iv_master_rank != myrank)
+		/** not cached, ask the parent */
+		rc = -DER_IVCB_FORWARD;
+	else
+		rc = 1;
+	ABT_mutex_unlock(cont_iv_lock);
+	if (rc <= 0)
+		return rc;
+
+	/** the root looks the handle up in the container service */
+	uuid_copy(capa->cic_coh_uuid, key->coh_uuid);
+	rc = ds_cont_hdl_capa_lookup(key->pool_uuid, key->coh_uuid,
+				     capa->cic_cont_uuid, &capa->cic_capas);
+	if (rc != 0) {
+		D_DEBUG(DF_DSMS, "failed to look up hdl="DF_UUID": %d\n",
+			DP_UUID(key->coh_uuid), rc);
+		return rc;
+	}
+
+	return cont_iv_ent_cache(entry, capa);
+}
+
+static int
+cont_iv_ent_get(struct ds_iv_entry *entry, void **priv)
+{
+	return 0;
+}
+
+static int
+cont_iv_ent_put(struct ds_iv_entry *entry, void **priv)
+{
+	return 0;
+}
+
+static int
+cont_iv_ent_init(struct ds_iv_key *iv_key, void *data,
+		 struct ds_iv_entry *entry)
+{
+	struct cont_iv_entry	*cont_entry;
+	struct cont_iv_key	*key, *ent_key;
+	int			 rc;
+
+	rc = daos_sgl_init(&entry->iv_value, 1);
+	if (rc)
+		return rc;
+
+	D_ALLOC_PTR(cont_entry);
+	if (cont_entry == NULL) {
+		daos_sgl_fini(&entry->iv_value, false);
+		return -DER_NOMEM;
+	}
+
+	/** init the entry key */
+	entry->iv_key.class_id = iv_key->class_id;
+	entry->iv_key.rank = iv_key->rank;
+	key = key2priv(iv_key);
+	ent_key = key2priv(&entry->iv_key);
+	uuid_copy(ent_key->pool_uuid, key->pool_uuid);
+	uuid_copy(ent_key->coh_uuid, key->coh_uuid);
+
+	uuid_copy(cont_entry->capa.cic_coh_uuid, key->coh_uuid);
+	ABT_mutex_lock(cont_iv_lock);
+	d_list_add(&cont_entry->link, &cont_iv_entry_list);
+	ABT_mutex_unlock(cont_iv_lock);
+
+	entry->iv_value.sg_iovs[0].iov_buf = cont_entry;
+	entry->iv_value.sg_iovs[0].iov_buf_len = sizeof(*cont_entry);
+	entry->iv_value.sg_iovs[0].iov_len = sizeof(*cont_entry);
+
+	return 0;
+}
+
+static int
+cont_iv_ent_destroy(d_sg_list_t *sgl)
+{
+	struct cont_iv_entry *entry;
+
+	entry = sgl->sg_iovs[0].iov_buf;
+	ABT_mutex_lock(cont_iv_lock);
+	d_list_del(&entry->link);
+	ABT_mutex_unlock(cont_iv_lock);
+	daos_sgl_fini(sgl, true);
+
+	return 0;
+}
+
+static int
+cont_iv_alloc(struct ds_iv_entry *entry, d_sg_list_t *sgl)
+{
+	int rc;
+
+	rc = daos_sgl_init(sgl, 1);
+	if (rc)
+		return rc;
+
+	D_ALLOC(sgl->sg_iovs[0].iov_buf, sizeof(struct cont_iv_capa));
+	if (sgl->sg_iovs[0].iov_buf == NULL)
+		D_GOTO(free, rc = -DER_NOMEM);
+	sgl->sg_iovs[0].iov_buf_len = sizeof(struct cont_iv_capa);
+	sgl->sg_iovs[0].iov_len = sizeof(struct cont_iv_capa);
+
+free:
+	if (rc)
+		daos_sgl_fini(sgl, true);
+	return rc;
+}
+
+struct ds_iv_class_ops cont_iv_ops = {
+	.ivc_key_cmp		= cont_iv_key_cmp,
+	.ivc_ent_init		= cont_iv_ent_init,
+	.ivc_ent_get		= cont_iv_ent_get,
+	.ivc_ent_put		= cont_iv_ent_put,
+	.ivc_ent_destroy	= cont_iv_ent_destroy,
+	.ivc_ent_fetch		= cont_iv_ent_fetch,
+	.ivc_ent_update		= cont_iv_ent_update,
+	.ivc_ent_refresh	= cont_iv_ent_refresh,
+	.ivc_value_alloc	= cont_iv_alloc,
+};
+
+struct cont_iv_fetch_arg {
+	void			*cfa_ns;
+	uuid_t			 cfa_pool_uuid;
+	uuid_t			 cfa_coh_uuid;
+	struct cont_iv_capa	*cfa_capa;
+};
+
+static int
+cont_iv_capa_fetch_ult(void *data)
+{
+	struct cont_iv_fetch_arg	*arg = data;
+	struct cont_iv_key		*cont_key;
+	struct ds_iv_key		 key;
+	d_sg_list_t			 sgl;
+	daos_iov_t			 iov;
+
+	memset(&key, 0, sizeof(key));
+	key.class_id = IV_CONT_CAPA;
+	cont_key = key2priv(&key);
+	uuid_copy(cont_key->pool_uuid, arg->cfa_pool_uuid);
+	uuid_copy(cont_key->coh_uuid, arg->cfa_coh_uuid);
+
+	daos_iov_set(&iov, arg->cfa_capa, sizeof(*arg->cfa_capa));
+	sgl.sg_nr = 1;
+	sgl.sg_nr_out = 0;
+	sgl.sg_iovs = &iov;
+
+	/** like OID allocation, the lookup travels up as an update */
+	return ds_iv_update(arg->cfa_ns, &key, &sgl, 0, CRT_IV_SYNC_NONE,
+			    CRT_IV_SYNC_BIDIRECTIONAL);
+}
+
+/**
+ * Look the capabilities of container handle \a coh_uuid up through the IV
+ * namespace \a ns of pool \a pool_uuid. Can be called from any xstream, the
+ * IV operation itself is issued from the first one.
+ */
+int
+cont_iv_capa_fetch(void *ns, uuid_t pool_uuid, uuid_t coh_uuid,
+		   struct cont_iv_capa *capa)
+{
+	struct cont_iv_fetch_arg	arg;
+	int				rc;
+
+	if (cont_iv_capa_revoked(coh_uuid))
+		return -DER_NO_HDL;
+
+	arg.cfa_ns = ns;
+	uuid_copy(arg.cfa_pool_uuid, pool_uuid);
+	uuid_copy(arg.cfa_coh_uuid, coh_uuid);
+	arg.cfa_capa = capa;
+	uuid_copy(capa->cic_coh_uuid, coh_uuid);
+
+	rc = dss_ult_create_execute(cont_iv_capa_fetch_ult, &arg, NULL, NULL,
+				    0, 0);
+	if (rc != 0)
+		D_DEBUG(DF_DSMS, "hdl="DF_UUID" lookup failed: %d\n",
+			DP_UUID(coh_uuid), rc);
+	return rc;
+}
+
+int
+ds_cont_iv_init(void)
+{
+	int rc;
+
+	crt_group_rank(NULL, &myrank);
+	D_INIT_LIST_HEAD(&cont_iv_entry_list);
+	D_INIT_LIST_HEAD(&cont_iv_revoked_list);
+	rc = ABT_mutex_create(&cont_iv_lock);
+	if (rc != ABT_SUCCESS)
+		return dss_abterr2der(rc);
+
+	rc = ds_iv_class_register(IV_CONT_CAPA, &iv_cache_ops, &cont_iv_ops);
+	if (rc)
+		ABT_mutex_free(&cont_iv_lock);
+	return rc;
+}
+
+int
+ds_cont_iv_fini(void)
+{
+	struct cont_iv_revoked	*rvk;
+	struct cont_iv_revoked	*tmp;
+
+	ds_iv_class_unregister(IV_CONT_CAPA);
+
+	d_list_for_each_entry_safe(rvk, tmp, &cont_iv_revoked_list,
+				   cir_link) {
+		d_list_del(&rvk->cir_link);
+		D_FREE(rvk);
+	}
+	ABT_mutex_free(&cont_iv_lock);
+	return 0;
+}
@@ -33,7 +33,19 @@
 #include "srv_internal.h"
 
 /** #define OID_IV_DEBUG */
-#define OID_BLOCK 32
+
+/**
+ * Each node of the IV tree, the root included, leases more OIDs than asked
+ * for from its parent (the container service for the root) and serves the
+ * following requests from the leftover. The lease doubles if it is used up
+ * within OID_LEASE_FAST seconds and halves if it lasts more than
+ * OID_LEASE_SLOW seconds, so that a steady allocation rate is served without
+ * going to the container service.
+ */
+#define OID_BLOCK	32
+#define OID_BLOCK_MAX	(1ULL << 24)
+#define OID_LEASE_FAST	1.0
+#define OID_LEASE_SLOW	10.0
 
 static d_rank_t		myrank;
 
@@ -50,6 +62,10 @@ struct oid_iv_key {
 struct oid_iv_entry {
 	/** value of the IV entry */
 	struct oid_iv_range	rg;
+	/** # OIDs to lease on next refill */
+	daos_size_t		block;
+	/** time of the last refill */
+	double			refill;
 	/** protect the entry */
 	ABT_mutex		lock;
 };
@@ -80,6 +96,37 @@ oid_iv_key_cmp(void *key1, void *key2)
 	return false;
 }
 
+/* Return the # OIDs to lease from the parent for a request of \a num_oids */
+static daos_size_t
+oid_iv_lease_size(struct oid_iv_entry *entry, daos_size_t num_oids)
+{
+	double	now = ABT_get_wtime();
+
+	if (entry->refill != 0) {
+		if (now - entry->refill <= OID_LEASE_FAST &&
+		    entry->block < OID_BLOCK_MAX)
+			entry->block *= 2;
+		else if (now - entry->refill > OID_LEASE_SLOW &&
+			 entry->block > OID_BLOCK)
+			entry->block /= 2;
+	}
+	entry->refill = now;
+
+	return num_oids + entry->block;
+}
+
+/* Serve \a num_oids OIDs of \a oids from the range available in \a avail */
+static void
+oid_iv_reserve_avail(struct oid_iv_range *avail, struct oid_iv_range *oids,
+		     daos_size_t num_oids)
+{
+	D_ASSERT(avail->num_oids >= num_oids);
+	oids->oid = avail->oid;
+	oids->num_oids = num_oids;
+	avail->num_oids -= num_oids;
+	avail->oid += num_oids;
+}
+
 static int
 oid_iv_ent_fetch(struct ds_iv_entry *entry, d_sg_list_t *dst, d_sg_list_t *src,
 		 void **priv)
@@ -117,13 +164,8 @@ oid_iv_ent_refresh(d_sg_list_t *dst, d_sg_list_t *src, int ref_rc, void **_priv)
 	avail->num_oids = oids->num_oids;
 	avail->oid = oids->oid;
 
-	/** Update the entry by reserving what was asked for */
-	D_ASSERT(avail->num_oids >= num_oids);
-	avail->num_oids -= num_oids;
-	avail->oid += num_oids;
-
-	/** Set the number of oids to what was asked for. */
-	oids->num_oids = num_oids;
+	/** Reserve what was asked for, and keep the rest of the lease */
+	oid_iv_reserve_avail(avail, oids, num_oids);
 
 out:
 	ABT_mutex_unlock(entry->lock);
@@ -156,20 +198,34 @@ oid_iv_ent_update(struct ds_iv_entry *ns_entry, d_sg_list_t *dst,
 		myrank, avail->num_oids, avail->oid);
 #endif
 
+	if (avail->num_oids >= num_oids) {
+#ifdef OID_IV_DEBUG
+		fprintf(stderr, "%u: IDs available\n", myrank);
+#endif
+		oid_iv_reserve_avail(avail, oids, num_oids);
+		priv->num_oids = 0;
+		/** release entry lock */
+		ABT_mutex_unlock(entry->lock);
+		return 0;
+	}
+
 	rc = crt_group_rank(NULL, &myrank);
 	if (ns_entry->ns->iv_master_rank == myrank) {
-		struct oid_iv_key *key;
+		struct oid_iv_key	*key;
+		daos_size_t		 lease;
 
 		key = key2priv(&ns_entry->iv_key);
+		lease = oid_iv_lease_size(entry, num_oids);
 		rc = ds_cont_oid_fetch_add(key->poh_uuid, key->key_id,
-					   key->coh_uuid, num_oids,
+					   key->coh_uuid, lease,
 					   &avail->oid);
 		if (rc) {
 			D_ERROR("failed to fetch and update max_oid %d\n", rc);
+			avail->num_oids = 0;
 			D_GOTO(err_lock, rc);
 		}
-		oids->oid = avail->oid;
-		oids->num_oids = num_oids;
+		avail->num_oids = lease;
+		oid_iv_reserve_avail(avail, oids, num_oids);
 #ifdef OID_IV_DEBUG
 		fprintf(stderr, "%u: ROOT MAX_OID = %"PRIu64"\n",
 			myrank, avail->oid);
@@ -179,30 +235,8 @@ oid_iv_ent_update(struct ds_iv_entry *ns_entry, d_sg_list_t *dst,
 		return 0;
 	}
 
-	if (avail->num_oids >= num_oids) {
-#ifdef OID_IV_DEBUG
-		fprintf(stderr, "%u: IDs available\n", myrank);
-#endif
-		/** set the oid value in the iv value */
-		oids->oid = avail->oid;
-		oids->num_oids = num_oids;
-
-		/** Update the current entry */
-		avail->num_oids -= num_oids;
-		avail->oid += num_oids;
-
-		priv->num_oids = 0;
-		/** release entry lock */
-		ABT_mutex_unlock(entry->lock);
-
-		return 0;
-	}
-
-	/** increase the number of oids requested before forwarding */
-	if (num_oids < OID_BLOCK)
-		oids->num_oids = OID_BLOCK;
-	else
-		oids->num_oids = (num_oids / OID_BLOCK) * OID_BLOCK * 2;
+	/** lease more oids than requested from the parent */
+	oids->num_oids = oid_iv_lease_size(entry, num_oids);
 
 	/** Keep track of how much this node originally requested */
 	priv->num_oids = num_oids;
@@ -269,6 +303,7 @@ oid_iv_ent_init(struct ds_iv_key *iv_key, void *data, struct ds_iv_entry *entry)
 
 	/* create the entry mutex */
 	ABT_mutex_create(&oid_entry->lock);
+	oid_entry->block = OID_BLOCK;
 
 	/** init the entry key */
 	entry->iv_key.class_id = iv_key->class_id;
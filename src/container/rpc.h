@@ -41,7 +41,7 @@
  * These are for daos_rpc::dr_opc and DAOS_RPC_OPCODE(opc, ...) rather than
  * crt_req_create(..., opc, ...). See src/include/daos/rpc.h.
  */
-#define DAOS_CONT_VERSION 1
+#define DAOS_CONT_VERSION 3
 /* LIST of internal RPCS in form of:
  * OPCODE, flags, FMT, handler, corpc_hdlr,
  */
@@ -189,7 +189,12 @@ CRT_RPC_DECLARE(cont_close, DAOS_ISEQ_CONT_CLOSE, DAOS_OSEQ_CONT_CLOSE)
 
 /** Add more items to query when needed */
 #define DAOS_OSEQ_CONT_QUERY	/* output fields */		 \
-	((struct cont_op_out)	(cqo_op)		CRT_VAR)
+	((struct cont_op_out)	(cqo_op)		CRT_VAR) \
+				/* aggregation statistics */	 \
+	((uint64_t)		(cqo_agg_objs)		CRT_VAR) \
+	((uint64_t)		(cqo_agg_recs)		CRT_VAR) \
+	((uint64_t)		(cqo_agg_bytes)		CRT_VAR) \
+	((uint64_t)		(cqo_agg_merged)	CRT_VAR)
 
 CRT_RPC_DECLARE(cont_query, DAOS_ISEQ_CONT_QUERY, DAOS_OSEQ_CONT_QUERY)
 
@@ -305,11 +310,17 @@ CRT_RPC_DECLARE(cont_tgt_close, DAOS_ISEQ_TGT_CLOSE, DAOS_OSEQ_TGT_CLOSE)
 #define DAOS_OSEQ_TGT_QUERY	/* output fields */		 \
 	((int32_t)		(tqo_rc)		CRT_VAR) \
 	((int32_t)		(tqo_pad32)		CRT_VAR) \
-	((daos_epoch_t)		(tqo_min_purged_epoch)	CRT_VAR)
+	((daos_epoch_t)		(tqo_min_purged_epoch)	CRT_VAR) \
+				/* summed over all xstreams */	 \
+	((uint64_t)		(tqo_agg_objs)		CRT_VAR) \
+	((uint64_t)		(tqo_agg_recs)		CRT_VAR) \
+	((uint64_t)		(tqo_agg_bytes)		CRT_VAR) \
+	((uint64_t)		(tqo_agg_merged)	CRT_VAR)
 
 CRT_RPC_DECLARE(cont_tgt_query, DAOS_ISEQ_TGT_QUERY, DAOS_OSEQ_TGT_QUERY)
 
 #define DAOS_ISEQ_CONT_TGT_EPOCH_DISCARD /* input fields */	 \
+	((uuid_t)		(tii_pool_uuid)		CRT_VAR) \
 	((uuid_t)		(tii_hdl)		CRT_VAR) \
 	((daos_epoch_t)		(tii_epoch)		CRT_VAR)
 
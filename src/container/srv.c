@@ -41,8 +41,14 @@ init(void)
 	rc = ds_oid_iv_init();
 	if (rc)
 		D_GOTO(err, rc);
+
+	rc = ds_cont_iv_init();
+	if (rc)
+		D_GOTO(err_oid_iv, rc);
 	return 0;
 
+err_oid_iv:
+	ds_oid_iv_fini();
 err:
 	return rc;
 }
@@ -50,6 +56,7 @@ err:
 static int
 fini(void)
 {
+	ds_cont_iv_fini();
 	ds_oid_iv_fini();
 	return 0;
 }
@@ -129,6 +136,8 @@ dsm_tls_init(const struct dss_thread_local_storage *dtls,
 		return NULL;
 	}
 
+	D_INIT_LIST_HEAD(&tls->dt_agg_list);
+	D_INIT_LIST_HEAD(&tls->dt_agg_stats);
 	return tls;
 }
 
@@ -138,6 +147,7 @@ dsm_tls_fini(const struct dss_thread_local_storage *dtls,
 {
 	struct dsm_tls *tls = data;
 
+	ds_cont_tgt_agg_list_fini(tls);
 	ds_cont_hdl_hash_destroy(&tls->dt_cont_hdl_hash);
 	ds_cont_cache_destroy(tls->dt_cont_cache);
 	D_FREE(tls);
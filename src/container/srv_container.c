@@ -55,10 +55,23 @@ cont_svc_init(struct cont_svc **svcp, const uuid_t pool_uuid, uint64_t id,
 		D_GOTO(err, rc = dss_abterr2der(rc));
 	}
 
+	rc = ABT_mutex_create(&svc->cs_revoke_lock);
+	if (rc != ABT_SUCCESS) {
+		D_ERROR("failed to create cs_revoke_lock: %d\n", rc);
+		D_GOTO(err_lock, rc = dss_abterr2der(rc));
+	}
+
+	rc = ABT_cond_create(&svc->cs_revoke_cv);
+	if (rc != ABT_SUCCESS) {
+		D_ERROR("failed to create cs_revoke_cv: %d\n", rc);
+		D_GOTO(err_revoke_lock, rc = dss_abterr2der(rc));
+	}
+	D_INIT_LIST_HEAD(&svc->cs_revoke_list);
+
 	/* cs_root */
 	rc = rdb_path_init(&svc->cs_root);
 	if (rc != 0)
-		D_GOTO(err_lock, rc);
+		D_GOTO(err_revoke_cv, rc);
 	rc = rdb_path_push(&svc->cs_root, &rdb_path_root_key);
 	if (rc != 0)
 		D_GOTO(err_root, rc);
@@ -87,6 +100,10 @@ err_conts:
 	rdb_path_fini(&svc->cs_conts);
 err_root:
 	rdb_path_fini(&svc->cs_root);
+err_revoke_cv:
+	ABT_cond_free(&svc->cs_revoke_cv);
+err_revoke_lock:
+	ABT_mutex_free(&svc->cs_revoke_lock);
 err_lock:
 	ABT_rwlock_free(&svc->cs_lock);
 err:
@@ -99,6 +116,9 @@ cont_svc_fini(struct cont_svc *svc)
 	rdb_path_fini(&svc->cs_hdls);
 	rdb_path_fini(&svc->cs_conts);
 	rdb_path_fini(&svc->cs_root);
+	D_ASSERT(d_list_empty(&svc->cs_revoke_list));
+	ABT_cond_free(&svc->cs_revoke_cv);
+	ABT_mutex_free(&svc->cs_revoke_lock);
 	ABT_rwlock_free(&svc->cs_lock);
 }
 
@@ -552,53 +572,6 @@ cont_put(struct cont *cont)
 	D_FREE(cont);
 }
 
-static int
-cont_open_bcast(crt_context_t ctx, struct cont *cont, const uuid_t pool_hdl,
-		const uuid_t cont_hdl, uint64_t capas)
-{
-	struct cont_tgt_open_in	       *in;
-	struct cont_tgt_open_out       *out;
-	crt_rpc_t		       *rpc;
-	int				rc;
-
-	D_DEBUG(DF_DSMS, DF_CONT": bcasting: pool_hdl="DF_UUID" cont_hdl="
-		DF_UUID" capas="DF_X64"\n",
-		DP_CONT(cont->c_svc->cs_pool_uuid, cont->c_uuid),
-		DP_UUID(pool_hdl), DP_UUID(cont_hdl), capas);
-
-	rc = ds_cont_bcast_create(ctx, cont->c_svc, CONT_TGT_OPEN, &rpc);
-	if (rc != 0)
-		D_GOTO(out, rc);
-
-	in = crt_req_get(rpc);
-	uuid_copy(in->toi_pool_uuid, cont->c_svc->cs_pool_uuid);
-	uuid_copy(in->toi_pool_hdl, pool_hdl);
-	uuid_copy(in->toi_uuid, cont->c_uuid);
-	uuid_copy(in->toi_hdl, cont_hdl);
-	in->toi_capas = capas;
-
-	rc = dss_rpc_send(rpc);
-	if (rc != 0)
-		D_GOTO(out_rpc, rc);
-
-	out = crt_reply_get(rpc);
-	rc = out->too_rc;
-	if (rc != 0) {
-		D_ERROR(DF_CONT": failed to open %d targets\n",
-			DP_CONT(cont->c_svc->cs_pool_uuid, cont->c_uuid), rc);
-		rc = -DER_IO;
-	}
-
-out_rpc:
-	crt_req_decref(rpc);
-out:
-	D_DEBUG(DF_DSMS, DF_CONT": bcasted: pool_hdl="DF_UUID" cont_hdl="DF_UUID
-		" capas="DF_X64": %d\n",
-		DP_CONT(cont->c_svc->cs_pool_uuid, cont->c_uuid),
-		DP_UUID(pool_hdl), DP_UUID(cont_hdl), capas, rc);
-	return rc;
-}
-
 static int
 cont_open(struct rdb_tx *tx, struct ds_pool_hdl *pool_hdl, struct cont *cont,
 	  crt_rpc_t *rpc)
@@ -634,13 +607,11 @@ cont_open(struct rdb_tx *tx, struct ds_pool_hdl *pool_hdl, struct cont *cont,
 		D_GOTO(out, rc);
 	}
 
-	rc = cont_open_bcast(rpc->cr_ctx, cont, in->coi_op.ci_pool_hdl,
-			     in->coi_op.ci_hdl, in->coi_capas);
-	if (rc != 0)
-		D_GOTO(out, rc);
-
-	/* TODO: Rollback cont_open_bcast() on errors from now on. */
-
+	/*
+	 * The targets are not told about the new handle. They look it up
+	 * through the capability IV (see container_iv.c) when it is first
+	 * used on them.
+	 */
 	uuid_copy(chdl.ch_pool_hdl, pool_hdl->sph_uuid);
 	uuid_copy(chdl.ch_cont, cont->c_uuid);
 	chdl.ch_capas = in->coi_capas;
@@ -702,6 +673,106 @@ out:
 	return rc;
 }
 
+/* A close waiting for its handles to be revoked on the targets */
+struct cont_revoke {
+	d_list_t			cr_link;
+	struct cont_tgt_close_rec      *cr_recs;
+	int				cr_nrecs;
+	int				cr_rc;
+	bool				cr_done;
+};
+
+/* Broadcast the records of all the closes in \a batch at once. */
+static int
+cont_revoke_flush(crt_context_t ctx, struct cont_svc *svc, d_list_t *batch)
+{
+	struct cont_revoke	       *cr;
+	struct cont_tgt_close_rec      *recs;
+	int				nrecs = 0;
+	int				rc;
+
+	cr = d_list_entry(batch->next, struct cont_revoke, cr_link);
+	if (batch->next->next == batch)
+		return cont_close_bcast(ctx, svc, cr->cr_recs, cr->cr_nrecs);
+
+	d_list_for_each_entry(cr, batch, cr_link)
+		nrecs += cr->cr_nrecs;
+
+	D_ALLOC_ARRAY(recs, nrecs);
+	if (recs == NULL)
+		return -DER_NOMEM;
+
+	nrecs = 0;
+	d_list_for_each_entry(cr, batch, cr_link) {
+		memcpy(&recs[nrecs], cr->cr_recs,
+		       sizeof(*recs) * cr->cr_nrecs);
+		nrecs += cr->cr_nrecs;
+	}
+
+	rc = cont_close_bcast(ctx, svc, recs, nrecs);
+	D_FREE(recs);
+	return rc;
+}
+
+/*
+ * Revoke the handles of \a recs on all targets. The handles stop being served
+ * by the capability IV right away. The closes arriving while a broadcast is in
+ * flight queue up and are broadcasted together by one of them once it
+ * completes, so that a burst of closes costs a few broadcasts rather than one
+ * per handle.
+ */
+static int
+cont_close_revoke(crt_context_t ctx, struct cont_svc *svc,
+		  struct cont_tgt_close_rec *recs, int nrecs)
+{
+	struct cont_revoke	cr;
+	struct cont_revoke     *tmp;
+	struct cont_revoke     *next;
+	d_list_t		batch;
+	int			i;
+	int			rc;
+
+	for (i = 0; i < nrecs; i++) {
+		rc = cont_iv_capa_revoke(recs[i].tcr_hdl);
+		if (rc != 0)
+			return rc;
+	}
+
+	cr.cr_recs = recs;
+	cr.cr_nrecs = nrecs;
+	cr.cr_rc = 0;
+	cr.cr_done = false;
+
+	ABT_mutex_lock(svc->cs_revoke_lock);
+	d_list_add_tail(&cr.cr_link, &svc->cs_revoke_list);
+	while (!cr.cr_done) {
+		if (svc->cs_revoking) {
+			ABT_cond_wait(svc->cs_revoke_cv, svc->cs_revoke_lock);
+			continue;
+		}
+
+		/* Broadcast everything queued so far, ours included. */
+		svc->cs_revoking = true;
+		D_INIT_LIST_HEAD(&batch);
+		d_list_splice_init(&svc->cs_revoke_list, &batch);
+		ABT_mutex_unlock(svc->cs_revoke_lock);
+
+		rc = cont_revoke_flush(ctx, svc, &batch);
+
+		ABT_mutex_lock(svc->cs_revoke_lock);
+		d_list_for_each_entry_safe(tmp, next, &batch, cr_link) {
+			d_list_del(&tmp->cr_link);
+			tmp->cr_rc = rc;
+			tmp->cr_done = true;
+		}
+		svc->cs_revoking = false;
+		ABT_cond_broadcast(svc->cs_revoke_cv);
+	}
+	ABT_mutex_unlock(svc->cs_revoke_lock);
+
+	return cr.cr_rc;
+}
+
 static int
 cont_close_one_hdl(struct rdb_tx *tx, struct cont_svc *svc,
 		   crt_context_t ctx, const uuid_t uuid)
@@ -746,7 +817,7 @@ cont_close_hdls(struct cont_svc *svc, struct cont_tgt_close_rec *recs,
 		" recs[0].hce="DF_U64"\n", DP_CONT(svc->cs_pool_uuid, NULL),
 		nrecs, DP_UUID(recs[0].tcr_hdl), recs[0].tcr_hce);
 
-	rc = cont_close_bcast(ctx, svc, recs, nrecs);
+	rc = cont_close_revoke(ctx, svc, recs, nrecs);
 	if (rc != 0)
 		D_GOTO(out, rc);
 
@@ -783,11 +854,16 @@ out:
 	return rc;
 }
 
+/*
+ * Unlike the other operations, a close runs most of its course without
+ * holding cs_lock, so that concurrent closes can share the revocation
+ * broadcasts.
+ */
 static int
-cont_close(struct rdb_tx *tx, struct ds_pool_hdl *pool_hdl, struct cont *cont,
-	   crt_rpc_t *rpc)
+cont_close(struct ds_pool_hdl *pool_hdl, struct cont_svc *svc, crt_rpc_t *rpc)
 {
 	struct cont_close_in	       *in = crt_req_get(rpc);
+	struct rdb_tx			tx;
 	daos_iov_t			key;
 	daos_iov_t			value;
 	struct container_hdl		chdl;
@@ -798,15 +874,21 @@ cont_close(struct rdb_tx *tx, struct ds_pool_hdl *pool_hdl, struct cont *cont,
 		DP_CONT(pool_hdl->sph_pool->sp_uuid, in->cci_op.ci_uuid), rpc,
 		DP_UUID(in->cci_op.ci_hdl));
 
+	rc = rdb_tx_begin(svc->cs_db, cont_svc_term(svc), &tx);
+	if (rc != 0)
+		D_GOTO(out, rc);
+
 	/* See if this container handle is already closed. */
+	ABT_rwlock_rdlock(svc->cs_lock);
 	daos_iov_set(&key, in->cci_op.ci_hdl, sizeof(uuid_t));
 	daos_iov_set(&value, &chdl, sizeof(chdl));
-	rc = rdb_tx_lookup(tx, &cont->c_svc->cs_hdls, &key, &value);
+	rc = rdb_tx_lookup(&tx, &svc->cs_hdls, &key, &value);
+	ABT_rwlock_unlock(svc->cs_lock);
+	rdb_tx_end(&tx);
 	if (rc != 0) {
 		if (rc == -DER_NONEXIST) {
 			D_DEBUG(DF_DSMS, DF_CONT": already closed: "DF_UUID"\n",
-				DP_CONT(cont->c_svc->cs_pool->sp_uuid,
-					cont->c_uuid),
+				DP_CONT(svc->cs_pool_uuid, in->cci_op.ci_uuid),
 				DP_UUID(in->cci_op.ci_hdl));
 			rc = 0;
 		}
@@ -817,14 +899,26 @@ cont_close(struct rdb_tx *tx, struct ds_pool_hdl *pool_hdl, struct cont *cont,
 	rec.tcr_hce = chdl.ch_hce;
 
 	D_DEBUG(DF_DSMS, DF_CONT": closing: hdl="DF_UUID" hce="DF_U64"\n",
-		DP_CONT(cont->c_svc->cs_pool_uuid, in->cci_op.ci_uuid),
+		DP_CONT(svc->cs_pool_uuid, in->cci_op.ci_uuid),
 		DP_UUID(rec.tcr_hdl), rec.tcr_hce);
 
-	rc = cont_close_bcast(rpc->cr_ctx, cont->c_svc, &rec, 1 /* nrecs */);
+	rc = cont_close_revoke(rpc->cr_ctx, svc, &rec, 1 /* nrecs */);
 	if (rc != 0)
 		D_GOTO(out, rc);
 
-	rc = cont_close_one_hdl(tx, cont->c_svc, rpc->cr_ctx, rec.tcr_hdl);
+	rc = rdb_tx_begin(svc->cs_db, cont_svc_term(svc), &tx);
+	if (rc != 0)
+		D_GOTO(out, rc);
+
+	ABT_rwlock_wrlock(svc->cs_lock);
+	rc = cont_close_one_hdl(&tx, svc, rpc->cr_ctx, rec.tcr_hdl);
+	if (rc == 0)
+		rc = rdb_tx_commit(&tx);
+	else if (rc == -DER_NONEXIST)
+		/* closed by a concurrent retry */
+		rc = 0;
+	ABT_rwlock_unlock(svc->cs_lock);
+	rdb_tx_end(&tx);
 
 out:
 	D_DEBUG(DF_DSMS, DF_CONT": replying rpc %p: %d\n",
@@ -869,6 +963,10 @@ cont_query_bcast(crt_context_t ctx, struct cont *cont, const uuid_t pool_hdl,
 		D_GOTO(out_rpc, rc = -DER_IO);
 	}
 
+	query_out->cqo_agg_objs = out->tqo_agg_objs;
+	query_out->cqo_agg_recs = out->tqo_agg_recs;
+	query_out->cqo_agg_bytes = out->tqo_agg_bytes;
+	query_out->cqo_agg_merged = out->tqo_agg_merged;
 out_rpc:
 	crt_req_decref(rpc);
 out:
@@ -1442,9 +1540,6 @@ cont_op_with_cont(struct rdb_tx *tx, struct ds_pool_hdl *pool_hdl,
 	case CONT_OPEN:
 		rc = cont_open(tx, pool_hdl, cont, rpc);
 		break;
-	case CONT_CLOSE:
-		rc = cont_close(tx, pool_hdl, cont, rpc);
-		break;
 	default:
 		/* Look up the container handle. */
 		daos_iov_set(&key, in->ci_hdl, sizeof(uuid_t));
@@ -1487,6 +1582,9 @@ cont_op_with_svc(struct ds_pool_hdl *pool_hdl, struct cont_svc *svc,
 	struct cont	       *cont = NULL;
 	int			rc;
 
+	if (opc == CONT_CLOSE)
+		return cont_close(pool_hdl, svc, rpc);
+
 	rc = rdb_tx_begin(svc->cs_db, cont_svc_term(svc), &tx);
 	if (rc != 0)
 		D_GOTO(out, rc);
@@ -1653,3 +1751,49 @@ out_pool_hdl:
 out:
 	return rc;
 }
+
+/*
+ * Look the capabilities of container handle \a coh_uuid up, on behalf of the
+ * capability IV root.
+ */
+int
+ds_cont_hdl_capa_lookup(uuid_t pool_uuid, uuid_t coh_uuid, uuid_t cont_uuid,
+			uint64_t *capas)
+{
+	struct cont_svc		*svc;
+	struct rdb_tx		tx;
+	daos_iov_t		key;
+	daos_iov_t		value;
+	struct container_hdl	hdl;
+	int			rc;
+
+	rc = cont_svc_lookup_leader(pool_uuid, 0, &svc, NULL);
+	if (rc != 0)
+		D_GOTO(out, rc);
+
+	rc = rdb_tx_begin(svc->cs_db, cont_svc_term(svc), &tx);
+	if (rc != 0)
+		D_GOTO(out_svc, rc);
+
+	ABT_rwlock_rdlock(svc->cs_lock);
+
+	daos_iov_set(&key, coh_uuid, sizeof(uuid_t));
+	daos_iov_set(&value, &hdl, sizeof(hdl));
+	rc = rdb_tx_lookup(&tx, &svc->cs_hdls, &key, &value);
+	if (rc != 0) {
+		if (rc == -DER_NONEXIST)
+			rc = -DER_NO_HDL;
+		D_GOTO(out_lock, rc);
+	}
+
+	uuid_copy(cont_uuid, hdl.ch_cont);
+	*capas = hdl.ch_capas;
+
+out_lock:
+	ABT_rwlock_unlock(svc->cs_lock);
+	rdb_tx_end(&tx);
+out_svc:
+	cont_svc_put_leader(svc);
+out:
+	return rc;
+}
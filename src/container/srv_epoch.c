@@ -892,6 +892,7 @@ cont_epoch_discard_bcast(crt_context_t ctx, struct cont *cont,
 		D_GOTO(out, rc);
 
 	in = crt_req_get(rpc);
+	uuid_copy(in->tii_pool_uuid, cont->c_svc->cs_pool_uuid);
 	uuid_copy(in->tii_hdl, hdl_uuid);
 	in->tii_epoch = epoch;
 
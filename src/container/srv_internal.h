@@ -38,10 +38,28 @@ struct container_hdl;
 struct ds_pool;
 struct ds_pool_hdl;
 
+/*
+ * Statistics of the background aggregation of one container on one xstream,
+ * they are reported by the container query.
+ */
+struct cont_agg_stats {
+	d_list_t		cas_link;
+	uuid_t			cas_cont_uuid;
+	uint64_t		cas_objs;	/* aggregated objects */
+	uint64_t		cas_recs;	/* removed records */
+	uint64_t		cas_bytes;	/* reclaimed bytes */
+	uint64_t		cas_merged;	/* merged extents */
+};
+
 /* ds_cont thread local storage structure */
 struct dsm_tls {
 	struct daos_lru_cache  *dt_cont_cache;
 	struct d_hash_table	dt_cont_hdl_hash;
+	/* pending aggregation requests, served by the aggregation ULT */
+	d_list_t		dt_agg_list;
+	/* aggregation statistics of each container, cont_agg_stats */
+	d_list_t		dt_agg_stats;
+	bool			dt_agg_running;
 };
 
 extern struct dss_module_key cont_module_key;
@@ -72,6 +90,11 @@ struct cont_svc {
 	rdb_path_t		cs_conts;	/* container KVS */
 	rdb_path_t		cs_hdls;	/* container handle KVS */
 	struct ds_pool	       *cs_pool;
+	/* closes waiting for their handles to be revoked on the targets */
+	ABT_mutex		cs_revoke_lock;
+	ABT_cond		cs_revoke_cv;
+	d_list_t		cs_revoke_list;
+	bool			cs_revoking;	/* a revocation is in flight */
 };
 
 /* Container descriptor */
@@ -91,6 +114,13 @@ struct oid_iv_range {
 	daos_size_t	num_oids;
 };
 
+/* Capabilities of a container handle, looked up through the IV */
+struct cont_iv_capa {
+	uuid_t		cic_coh_uuid;
+	uuid_t		cic_cont_uuid;
+	uint64_t	cic_capas;
+};
+
 /*
  * srv.c
  */
@@ -103,6 +133,8 @@ int ds_cont_bcast_create(crt_context_t ctx, struct cont_svc *svc,
 			 crt_opcode_t opcode, crt_rpc_t **rpc);
 int ds_cont_oid_fetch_add(uuid_t poh_uuid, uuid_t co_uuid, uuid_t coh_uuid,
 			  uint64_t num_oids, uint64_t *oid);
+int ds_cont_hdl_capa_lookup(uuid_t pool_uuid, uuid_t coh_uuid,
+			    uuid_t cont_uuid, uint64_t *capas);
 /*
  * srv_epoch.c
  */
@@ -147,6 +179,7 @@ int ds_cont_tgt_epoch_discard_aggregator(crt_rpc_t *source, crt_rpc_t *result,
 void ds_cont_tgt_epoch_aggregate_handler(crt_rpc_t *rpc);
 int ds_cont_tgt_epoch_aggregate_aggregator(crt_rpc_t *source, crt_rpc_t *result,
 					   void *priv);
+void ds_cont_tgt_agg_list_fini(struct dsm_tls *tls);
 int ds_cont_cache_create(struct daos_lru_cache **cache);
 void ds_cont_cache_destroy(struct daos_lru_cache *cache);
 int ds_cont_hdl_hash_create(struct d_hash_table *hash);
@@ -161,4 +194,14 @@ int ds_oid_iv_fini(void);
 int oid_iv_reserve(void *ns, uuid_t poh_uuid, uuid_t co_uuid, uuid_t coh_uuid,
 		   uint64_t num_oids, d_sg_list_t *value);
 
+/**
+ * container_iv.c
+ */
+int ds_cont_iv_init(void);
+int ds_cont_iv_fini(void);
+int cont_iv_capa_fetch(void *ns, uuid_t pool_uuid, uuid_t coh_uuid,
+		       struct cont_iv_capa *capa);
+int cont_iv_capa_revoke(const uuid_t coh_uuid);
+bool cont_iv_capa_revoked(const uuid_t coh_uuid);
+
 #endif /* __CONTAINER_SRV_INTERNAL_H__ */
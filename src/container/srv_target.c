@@ -40,6 +40,7 @@
 
 #include <daos_srv/container.h>
 
+#include <daos/object.h>
 #include <daos/rpc.h>
 #include <daos_srv/pool.h>
 #include <daos_srv/vos.h>
@@ -313,6 +314,41 @@ ds_cont_hdl_get(struct ds_cont_hdl *hdl)
 	cont_hdl_get_internal(hash, hdl);
 }
 
+/* cont_agg_stats *************************************************************/
+
+/*
+ * Look up the aggregation statistics of container \a uuid on the current
+ * xstream, allocate them if \a create is true.
+ */
+static struct cont_agg_stats *
+cont_agg_stats_lookup(struct dsm_tls *tls, const uuid_t uuid, bool create)
+{
+	struct cont_agg_stats	*stats;
+
+	d_list_for_each_entry(stats, &tls->dt_agg_stats, cas_link) {
+		if (uuid_compare(stats->cas_cont_uuid, uuid) == 0)
+			return stats;
+	}
+
+	if (!create)
+		return NULL;
+
+	D_ALLOC_PTR(stats);
+	if (stats == NULL)
+		return NULL;
+
+	uuid_copy(stats->cas_cont_uuid, uuid);
+	d_list_add(&stats->cas_link, &tls->dt_agg_stats);
+	return stats;
+}
+
+static void
+cont_agg_stats_free(struct cont_agg_stats *stats)
+{
+	d_list_del(&stats->cas_link);
+	D_FREE_PTR(stats);
+}
+
 /*
  * Called via dss_collective() to destroy the ds_cont object as well as the vos
  * container.
@@ -324,6 +360,7 @@ cont_destroy_one(void *vin)
 	struct dsm_tls		       *tls = dsm_tls_get();
 	struct ds_pool_child	       *pool;
 	struct ds_cont		       *cont;
+	struct cont_agg_stats	       *stats;
 	int				rc;
 
 	pool = ds_pool_child_lookup(in->tdi_pool_uuid);
@@ -340,6 +377,10 @@ cont_destroy_one(void *vin)
 		D_GOTO(out_pool, rc);
 	}
 
+	stats = cont_agg_stats_lookup(tls, in->tdi_uuid, false);
+	if (stats != NULL)
+		cont_agg_stats_free(stats);
+
 	D_DEBUG(DF_DSMS, DF_CONT": destroying vos container\n",
 		DP_CONT(pool->spc_uuid, in->tdi_uuid));
 
@@ -543,6 +584,74 @@ err:
 	return rc;
 }
 
+/* Look the capabilities of \a cont_hdl_uuid up through the IV of the pool */
+static int
+cont_hdl_capa_get(uuid_t pool_uuid, uuid_t cont_hdl_uuid,
+		  struct cont_iv_capa *capa)
+{
+	struct ds_pool	*pool;
+	int		 rc;
+
+	pool = ds_pool_lookup(pool_uuid);
+	if (pool == NULL)
+		return -DER_NO_HDL;
+
+	if (pool->sp_iv_ns == NULL)
+		D_GOTO(out, rc = -DER_NO_HDL);
+
+	rc = cont_iv_capa_fetch(pool->sp_iv_ns, pool_uuid, cont_hdl_uuid, capa);
+out:
+	ds_pool_put(pool);
+	return rc;
+}
+
+/**
+ * Open container handle \a cont_hdl_uuid on this xstream, looking its
+ * capabilities up through the capability IV of pool \a pool_uuid. Called on
+ * the first use of a handle on this xstream, as container open does not
+ * broadcast the new handles to the targets.
+ *
+ * \param pool_uuid [IN]	pool uuid
+ * \param cont_hdl_uuid [IN]	container handle uuid
+ * \param cont_hdl [OUT]	target container handle if succeeds
+ *
+ * \return			0 if succeeds, -DER_NO_HDL if the handle is
+ *				unknown or has been closed.
+ */
+int
+ds_cont_hdl_fetch(uuid_t pool_uuid, uuid_t cont_hdl_uuid,
+		  struct ds_cont_hdl **cont_hdl)
+{
+	struct cont_iv_capa	 capa;
+	int			 rc;
+
+	rc = cont_hdl_capa_get(pool_uuid, cont_hdl_uuid, &capa);
+	if (rc != 0)
+		return rc;
+
+	D_DEBUG(DF_DSMS, DF_CONT": fetched hdl="DF_UUID" capas="DF_X64"\n",
+		DP_CONT(pool_uuid, capa.cic_cont_uuid), DP_UUID(cont_hdl_uuid),
+		capa.cic_capas);
+
+	rc = ds_cont_local_open(pool_uuid, cont_hdl_uuid, capa.cic_cont_uuid,
+				capa.cic_capas, cont_hdl);
+	if (rc != 0)
+		return rc;
+
+	/*
+	 * The close of the handle may have run on this xstream while it was
+	 * being looked up, do not let it come back.
+	 */
+	if (cont_iv_capa_revoked(cont_hdl_uuid)) {
+		ds_cont_local_close(cont_hdl_uuid);
+		ds_cont_hdl_put(*cont_hdl);
+		*cont_hdl = NULL;
+		rc = -DER_NO_HDL;
+	}
+
+	return rc;
+}
+
 /*
  * Called via dss_collective() to establish the ds_cont_hdl object as well as
  * the ds_cont object.
@@ -586,6 +695,23 @@ ds_cont_tgt_open_aggregator(crt_rpc_t *source, crt_rpc_t *result, void *priv)
 	return 0;
 }
 
+/*
+ * Discard \a range of \a cookie, objects leased by in-flight fetches are
+ * skipped by VOS, so yield to let those fetches finish and discard again.
+ */
+static int
+cont_epoch_discard(struct ds_cont *cont, daos_epoch_range_t *range,
+		   uuid_t cookie)
+{
+	int	rc;
+
+	while ((rc = vos_epoch_discard(cont->sc_hdl, range, cookie)) ==
+	       -DER_BUSY)
+		ABT_thread_yield();
+
+	return rc;
+}
+
 /* Close a single record (i.e., handle). */
 static int
 cont_close_one_rec(struct cont_tgt_close_rec *rec)
@@ -611,7 +737,7 @@ cont_close_one_rec(struct cont_tgt_close_rec *rec)
 	range.epr_lo = rec->tcr_hce + 1;
 	range.epr_hi = DAOS_EPOCH_MAX;
 
-	rc = vos_epoch_discard(hdl->sch_cont->sc_hdl, &range, rec->tcr_hdl);
+	rc = cont_epoch_discard(hdl->sch_cont, &range, rec->tcr_hdl);
 	if (rc != 0) {
 		D_ERROR(DF_CONT": failed to discard uncommitted epochs ["DF_U64
 			", "DF_X64"): hdl="DF_UUID" rc=%d\n",
@@ -654,6 +780,7 @@ ds_cont_tgt_close_handler(crt_rpc_t *rpc)
 	struct cont_tgt_close_in       *in = crt_req_get(rpc);
 	struct cont_tgt_close_out      *out = crt_reply_get(rpc);
 	struct cont_tgt_close_rec      *recs = in->tci_recs.ca_arrays;
+	int				i;
 	int				rc;
 
 	if (in->tci_recs.ca_count == 0)
@@ -667,6 +794,13 @@ ds_cont_tgt_close_handler(crt_rpc_t *rpc)
 		rpc, DP_UUID(recs[0].tcr_hdl), recs[0].tcr_hce,
 		in->tci_recs.ca_count);
 
+	/* Stop looking these handles up before closing them. */
+	for (i = 0; i < in->tci_recs.ca_count; i++) {
+		rc = cont_iv_capa_revoke(recs[i].tcr_hdl);
+		if (rc != 0)
+			D_GOTO(out, rc);
+	}
+
 	rc = dss_thread_collective(cont_close_one, in);
 	D_ASSERTF(rc == 0, "%d\n", rc);
 
@@ -690,6 +824,7 @@ ds_cont_tgt_close_aggregator(crt_rpc_t *source, crt_rpc_t *result, void *priv)
 struct xstream_cont_query {
 	struct cont_tgt_query_in	*xcq_rpc_in;
 	daos_epoch_t			xcq_purged_epoch;
+	struct cont_agg_stats		xcq_agg_stats;
 };
 
 static int
@@ -701,6 +836,7 @@ cont_query_one(void *vin)
 	int				tid	   = info->dmi_tid;
 	struct xstream_cont_query	*pack_args = streams[tid].st_arg;
 	struct cont_tgt_query_in	*in	   = pack_args->xcq_rpc_in;
+	struct cont_agg_stats		*stats;
 	struct ds_pool_hdl		*pool_hdl;
 	struct ds_pool_child		*pool_child;
 	daos_handle_t			vos_chdl;
@@ -737,6 +873,9 @@ cont_query_one(void *vin)
 	}
 	pack_args->xcq_purged_epoch = vos_cinfo.pci_purged_epoch;
 
+	stats = cont_agg_stats_lookup(dsm_tls_get(), in->tqi_cont_uuid, false);
+	if (stats != NULL)
+		pack_args->xcq_agg_stats = *stats;
 out:
 	vos_cont_close(vos_chdl);
 ds_child:
@@ -755,6 +894,12 @@ ds_cont_query_coll_reduce(void *a_args, void *s_args)
 
 	min_epoch = &aggregator->xcq_purged_epoch;
 	*min_epoch = MIN(*min_epoch, stream->xcq_purged_epoch);
+
+	aggregator->xcq_agg_stats.cas_objs += stream->xcq_agg_stats.cas_objs;
+	aggregator->xcq_agg_stats.cas_recs += stream->xcq_agg_stats.cas_recs;
+	aggregator->xcq_agg_stats.cas_bytes += stream->xcq_agg_stats.cas_bytes;
+	aggregator->xcq_agg_stats.cas_merged +=
+		stream->xcq_agg_stats.cas_merged;
 }
 
 static int
@@ -798,6 +943,7 @@ ds_cont_tgt_query_handler(crt_rpc_t *rpc)
 	coll_ops.co_reduce_arg_free	= ds_cont_query_stream_free;
 
 	/** packing arguments for aggregator args */
+	memset(&pack_args, 0, sizeof(pack_args));
 	pack_args.xcq_rpc_in		= in;
 	pack_args.xcq_purged_epoch	= DAOS_EPOCH_MAX;
 
@@ -811,6 +957,10 @@ ds_cont_tgt_query_handler(crt_rpc_t *rpc)
 	D_ASSERTF(rc == 0, "%d\n", rc);
 	out->tqo_min_purged_epoch = MIN(out->tqo_min_purged_epoch,
 					pack_args.xcq_purged_epoch);
+	out->tqo_agg_objs = pack_args.xcq_agg_stats.cas_objs;
+	out->tqo_agg_recs = pack_args.xcq_agg_stats.cas_recs;
+	out->tqo_agg_bytes = pack_args.xcq_agg_stats.cas_bytes;
+	out->tqo_agg_merged = pack_args.xcq_agg_stats.cas_merged;
 	out->tqo_rc = (rc == 0 ? 0 : 1);
 
 	D_DEBUG(DF_DSMS, DF_CONT": replying rpc %p: %d (%d)\n",
@@ -827,6 +977,10 @@ ds_cont_tgt_query_aggregator(crt_rpc_t *source, crt_rpc_t *result, void *priv)
 	out_result->tqo_min_purged_epoch =
 		MIN(out_result->tqo_min_purged_epoch,
 		    out_source->tqo_min_purged_epoch);
+	out_result->tqo_agg_objs += out_source->tqo_agg_objs;
+	out_result->tqo_agg_recs += out_source->tqo_agg_recs;
+	out_result->tqo_agg_bytes += out_source->tqo_agg_bytes;
+	out_result->tqo_agg_merged += out_source->tqo_agg_merged;
 	out_result->tqo_rc += out_source->tqo_rc;
 	return 0;
 }
@@ -838,17 +992,25 @@ cont_epoch_discard_one(void *vin)
 	struct cont_tgt_epoch_discard_in       *in = vin;
 	struct dsm_tls			       *tls = dsm_tls_get();
 	struct ds_cont_hdl		       *hdl;
+	struct cont_iv_capa			capa;
 	daos_epoch_range_t			range;
 	int					rc;
 
 	hdl = cont_hdl_lookup_internal(&tls->dt_cont_hdl_hash, in->tii_hdl);
-	if (hdl == NULL)
-		return -DER_NO_PERM;
+	if (hdl == NULL) {
+		/*
+		 * Handles are opened on the first I/O on each xstream, nothing
+		 * has been written with a valid one this xstream does not know,
+		 * but a handle unknown to the IV as well is not valid at all.
+		 */
+		rc = cont_hdl_capa_get(in->tii_pool_uuid, in->tii_hdl, &capa);
+		return rc == -DER_NO_HDL ? -DER_NO_PERM : rc;
+	}
 
 	range.epr_lo = in->tii_epoch;
 	range.epr_hi = in->tii_epoch;
 
-	rc = vos_epoch_discard(hdl->sch_cont->sc_hdl, &range, in->tii_hdl);
+	rc = cont_epoch_discard(hdl->sch_cont, &range, in->tii_hdl);
 	if (rc != 0)
 		D_ERROR(DF_CONT": failed to discard epoch "DF_U64": hdl="DF_UUID
 			" rc=%d\n",
@@ -898,26 +1060,117 @@ ds_cont_tgt_epoch_discard_aggregator(crt_rpc_t *source, crt_rpc_t *result,
 	return 0;
 }
 
+/* Aggregation request queued on each xstream */
+struct cont_agg_req {
+	d_list_t		 car_link;
+	uuid_t			 car_pool_uuid;
+	uuid_t			 car_cont_uuid;
+	daos_epoch_range_t	*car_eprs;
+	unsigned int		 car_epr_nr;
+	/* objects to aggregate, all objects of the container if it's NULL */
+	daos_unit_oid_t		*car_oids;
+	unsigned int		 car_oid_nr;
+};
+
+/* Max number of hot objects which are aggregated ahead of the others */
+#define CONT_AGG_HOT_MAX	32
+/* Divide the credits by this number while the xstream has pending I/O */
+#define CONT_AGG_BUSY_SHIFT	3
+
 static void
-set_container_purged_epoch(daos_handle_t vos_chdl,
-			   struct cont_tgt_epoch_aggregate_in *in,
+set_container_purged_epoch(daos_handle_t vos_chdl, struct cont_agg_req *req,
 			   daos_epoch_range_t *range)
 {
 	daos_unit_oid_t		oid_tmp;
 	bool			finish;
 
 	D_DEBUG(DF_DSMS, DF_CONT" Setting aggregated epoch as "DF_U64"\n",
-		DP_CONT(in->tai_pool_uuid, in->tai_cont_uuid),
+		DP_CONT(req->car_pool_uuid, req->car_cont_uuid),
 		range->epr_hi);
 	memset(&oid_tmp, 0, sizeof(oid_tmp));
 	vos_epoch_aggregate(vos_chdl, oid_tmp, range, NULL,
 			    NULL, &finish);
 }
 
+/* Aggregate one object, yield to the I/O ULTs after each round of credits */
 static int
-cont_epoch_aggregate_one(void *vin)
+cont_agg_obj(daos_handle_t vos_chdl, daos_unit_oid_t oid,
+	     daos_epoch_range_t *epr, unsigned int credits,
+	     struct cont_agg_stats *stats)
 {
-	struct cont_tgt_epoch_aggregate_in	*in  = vin;
+	vos_purge_anchor_t	anchor;
+	bool			finish;
+	int			rc;
+
+	memset(&anchor, 0, sizeof(vos_purge_anchor_t));
+	while (true) {
+		unsigned int	l_credits = credits;
+
+		/* back off while there are pending requests on this xstream */
+		if (dss_xstream_is_busy())
+			l_credits = max(credits >> CONT_AGG_BUSY_SHIFT, 1);
+
+		finish = false;
+		rc = vos_epoch_aggregate(vos_chdl, oid, epr, &l_credits,
+					 &anchor, &finish);
+		if (rc != 0)
+			return rc;
+
+		if (finish) {
+			D_DEBUG(DB_EPC, "Finished "DF_U64"->"DF_U64")\n",
+				epr->epr_lo, epr->epr_hi);
+			break;
+		}
+		ABT_thread_yield();
+	}
+
+	stats->cas_objs++;
+	stats->cas_recs += anchor.pa_nr_removed;
+	stats->cas_bytes += anchor.pa_size_removed;
+	stats->cas_merged += anchor.pa_nr_merged;
+	return 0;
+}
+
+static bool
+cont_agg_is_hot(daos_unit_oid_t *hot, int hot_nr, daos_unit_oid_t oid)
+{
+	int	i;
+
+	for (i = 0; i < hot_nr; i++) {
+		if (daos_unit_oid_compare(hot[i], oid) == 0)
+			return true;
+	}
+	return false;
+}
+
+/* Aggregate the objects found deep or overlapped by updates */
+static int
+cont_agg_oids(daos_handle_t vos_chdl, struct cont_agg_req *req,
+	      unsigned int credits, struct cont_agg_stats *stats)
+{
+	int	i;
+	int	j;
+	int	rc;
+
+	for (i = 0; i < req->car_epr_nr; i++) {
+		for (j = 0; j < req->car_oid_nr; j++) {
+			rc = cont_agg_obj(vos_chdl, req->car_oids[j],
+					  &req->car_eprs[i], credits, stats);
+			if (rc != 0)
+				return rc;
+		}
+	}
+
+	D_DEBUG(DF_DSMS, DF_CONT": aggregated %u objects on update\n",
+		DP_CONT(req->car_pool_uuid, req->car_cont_uuid),
+		req->car_oid_nr);
+	return 0;
+}
+
+static int
+cont_agg_one(struct cont_agg_req *req, struct cont_agg_stats *stats)
+{
+	daos_unit_oid_t				hot[CONT_AGG_HOT_MAX];
 	unsigned int				credits;
 	vos_iter_param_t			param;
 	struct ds_pool_child			*pool_child;
@@ -927,8 +1180,9 @@ cont_epoch_aggregate_one(void *vin)
 	char					*opstr;
 	int					aggregated;
 	int					found;
+	int					hot_nr;
 	int					rc;
-	bool					finish;
+	int					j;
 	size_t					i;
 
 	purge_credits = getenv("DAOS_PURGE_CREDITS");
@@ -936,21 +1190,21 @@ cont_epoch_aggregate_one(void *vin)
 	if (credits == 0)
 		credits = DAOS_PURGE_CREDITS_MAX;
 
-	pool_child = ds_pool_child_lookup(in->tai_pool_uuid);
+	pool_child = ds_pool_child_lookup(req->car_pool_uuid);
 	if (pool_child == NULL) {
 		D_ERROR(DF_CONT": pool child is NULL\n",
-			DP_CONT(in->tai_pool_uuid,
-				in->tai_cont_uuid));
+			DP_CONT(req->car_pool_uuid,
+				req->car_cont_uuid));
 		return -DER_NO_HDL;
 	}
 
 	opstr = "opening vos container handle\n";
-	rc = vos_cont_open(pool_child->spc_hdl, in->tai_cont_uuid,
+	rc = vos_cont_open(pool_child->spc_hdl, req->car_cont_uuid,
 			   &vos_chdl);
 	if (rc != 0) {
 		D_ERROR(DF_CONT": Failed %s : %d",
-			DP_CONT(in->tai_pool_uuid,
-				in->tai_cont_uuid), opstr, rc);
+			DP_CONT(req->car_pool_uuid,
+				req->car_cont_uuid), opstr, rc);
 		/*
 		 * Aggregate ULT is run in background so ignore return values
 		 * further more aggregation is idempotent.
@@ -958,23 +1212,40 @@ cont_epoch_aggregate_one(void *vin)
 		goto pool_child;
 	}
 
+	if (req->car_oids != NULL) {
+		rc = cont_agg_oids(vos_chdl, req, credits, stats);
+		goto cont_close;
+	}
+
+	/* The most updated objects are aggregated ahead of the others */
+	hot_nr = vos_cont_hot_objs(vos_chdl, hot, CONT_AGG_HOT_MAX);
+	if (hot_nr < 0)
+		hot_nr = 0;
+
 	memset(&param, 0, sizeof(param));
 	param.ip_hdl = vos_chdl;
 	found = 0;
 	aggregated = 0;
-	for (i = 0; i < in->tai_epr_list.ca_count; i++) {
-		param.ip_epr = ((daos_epoch_range_t *)
-				 in->tai_epr_list.ca_arrays)[i];
+	for (i = 0; i < req->car_epr_nr; i++) {
+		param.ip_epr = req->car_eprs[i];
 		D_DEBUG(DF_DSMS, DF_CONT": epr[%lu]="DF_U64"->"DF_U64"\n",
-			DP_CONT(in->tai_pool_uuid, in->tai_cont_uuid),
+			DP_CONT(req->car_pool_uuid, req->car_cont_uuid),
 			i, param.ip_epr.epr_lo, param.ip_epr.epr_hi);
 
+		for (j = 0; j < hot_nr; j++) {
+			rc = cont_agg_obj(vos_chdl, hot[j], &param.ip_epr,
+					  credits, stats);
+			if (rc != 0)
+				goto cont_close;
+			aggregated++;
+		}
+
 		opstr = "preparing vos obj iterator ";
 		rc = vos_iter_prepare(VOS_ITER_OBJ, &param, &iter_hdl);
 		if (rc != 0) {
 			D_ERROR(DF_CONT": failed %s : %d",
-				DP_CONT(in->tai_pool_uuid,
-					in->tai_cont_uuid), opstr, rc);
+				DP_CONT(req->car_pool_uuid,
+					req->car_cont_uuid), opstr, rc);
 			goto cont_close;
 		}
 
@@ -982,9 +1253,11 @@ cont_epoch_aggregate_one(void *vin)
 		rc = vos_iter_probe(iter_hdl, NULL);
 		if (rc == -DER_NONEXIST) {
 			D_DEBUG(DF_DSMS, DF_CONT": No objects to iterate\n",
-				DP_CONT(in->tai_pool_uuid, in->tai_cont_uuid));
+				DP_CONT(req->car_pool_uuid,
+					req->car_cont_uuid));
 			/* empty container then set highest epoch and exit */
-			set_container_purged_epoch(vos_chdl, in, &param.ip_epr);
+			set_container_purged_epoch(vos_chdl, req,
+						   &param.ip_epr);
 			rc = 0;
 			goto end_loop;
 		}
@@ -996,7 +1269,6 @@ cont_epoch_aggregate_one(void *vin)
 
 		while (true) {
 			vos_iter_entry_t	ent;
-			vos_purge_anchor_t	anchor;
 
 			if (rc == 0) {
 				opstr = "iter fetch with vos obj iterator";
@@ -1006,9 +1278,9 @@ cont_epoch_aggregate_one(void *vin)
 			if (rc == -DER_NONEXIST) {
 				D_DEBUG(DF_DSMS, DF_CONT
 					": Finish obj iteration\n",
-					DP_CONT(in->tai_pool_uuid,
-						in->tai_cont_uuid));
-				set_container_purged_epoch(vos_chdl, in,
+					DP_CONT(req->car_pool_uuid,
+						req->car_cont_uuid));
+				set_container_purged_epoch(vos_chdl, req,
 							   &param.ip_epr);
 				rc = 0;
 				break;
@@ -1017,34 +1289,20 @@ cont_epoch_aggregate_one(void *vin)
 			if (rc != 0) {
 				D_ERROR("obj iterator in "DF_CONT
 					" failed to %s: %d",
-					DP_CONT(in->tai_pool_uuid,
-						in->tai_cont_uuid), opstr, rc);
+					DP_CONT(req->car_pool_uuid,
+						req->car_cont_uuid), opstr, rc);
 				goto end_loop;
 			}
 			found++;
 
-			memset(&anchor, 0, sizeof(vos_purge_anchor_t));
-			while (true) {
-				unsigned int	l_credits = credits;
-
-				finish = false;
-				rc = vos_epoch_aggregate(vos_chdl, ent.ie_oid,
-							 &param.ip_epr,
-							 &l_credits,
-							 &anchor, &finish);
+			if (!cont_agg_is_hot(hot, hot_nr, ent.ie_oid)) {
+				rc = cont_agg_obj(vos_chdl, ent.ie_oid,
+						  &param.ip_epr, credits,
+						  stats);
 				if (rc != 0)
 					goto end_loop;
-
-				if (finish) {
-					D_DEBUG(DB_EPC, "Finished "
-						DF_U64"->"DF_U64")\n",
-						param.ip_epr.epr_lo,
-						param.ip_epr.epr_hi);
-					break;
-				}
-				ABT_thread_yield();
+				aggregated++;
 			}
-			aggregated++;
 			opstr = "iter next with vos obj iterator";
 			rc = vos_iter_next(iter_hdl);
 		}
@@ -1053,9 +1311,9 @@ end_loop:
 		if (rc != 0)
 			goto cont_close;
 	}
-	D_DEBUG(DF_DSMS, DF_CONT": aggregated %d/%d objects\n",
-		DP_CONT(in->tai_pool_uuid, in->tai_cont_uuid),
-			aggregated, found);
+	D_DEBUG(DF_DSMS, DF_CONT": aggregated %d/%d objects (%d hot)\n",
+		DP_CONT(req->car_pool_uuid, req->car_cont_uuid),
+			aggregated, found, hot_nr);
 cont_close:
 	vos_cont_close(vos_chdl);
 pool_child:
@@ -1063,10 +1321,208 @@ pool_child:
 	return rc;
 }
 
+static void
+cont_agg_req_free(struct cont_agg_req *req)
+{
+	D_FREE(req->car_oids);
+	D_FREE(req->car_eprs);
+	D_FREE_PTR(req);
+}
+
+/**
+ * Per-xstream aggregation ULT, it runs in the aggregation pool so it only
+ * gets the CPU when the xstream is idle or for its reserved share, and it
+ * exits once all the queued requests are served.
+ */
+static void
+cont_agg_ult(void *arg)
+{
+	struct dsm_tls		*tls = dsm_tls_get();
+	struct cont_agg_stats	*stats;
+	struct cont_agg_stats	 delta;
+	struct cont_agg_req	*req;
+	int			 rc;
+
+	while (!d_list_empty(&tls->dt_agg_list)) {
+		req = d_list_entry(tls->dt_agg_list.next, struct cont_agg_req,
+				   car_link);
+		d_list_del(&req->car_link);
+
+		/* the statistics may be freed while yielding, add up after */
+		memset(&delta, 0, sizeof(delta));
+		rc = cont_agg_one(req, &delta);
+		if (rc != 0)
+			D_ERROR(DF_CONT": Aggregation failed: %d\n",
+				DP_CONT(req->car_pool_uuid,
+					req->car_cont_uuid), rc);
+
+		D_DEBUG(DF_DSMS, DF_CONT": aggregated "DF_U64" objects, "
+			"removed "DF_U64" records, reclaimed "DF_U64" bytes, "
+			"merged "DF_U64" extents\n",
+			DP_CONT(req->car_pool_uuid, req->car_cont_uuid),
+			delta.cas_objs, delta.cas_recs, delta.cas_bytes,
+			delta.cas_merged);
+		stats = NULL;
+		if (delta.cas_objs != 0)
+			stats = cont_agg_stats_lookup(tls, req->car_cont_uuid,
+						      true);
+		if (stats != NULL) {
+			stats->cas_objs += delta.cas_objs;
+			stats->cas_recs += delta.cas_recs;
+			stats->cas_bytes += delta.cas_bytes;
+			stats->cas_merged += delta.cas_merged;
+		}
+		cont_agg_req_free(req);
+	}
+
+	tls->dt_agg_running = false;
+}
+
+/* Queue \a req on the current xstream, start the aggregation ULT if needed */
+static int
+cont_agg_submit(struct dsm_tls *tls, struct cont_agg_req *req)
+{
+	int	rc;
+
+	d_list_add_tail(&req->car_link, &tls->dt_agg_list);
+	if (tls->dt_agg_running)
+		return 0;
+
+	rc = dss_aggregate_ult_create(cont_agg_ult, NULL, -1, 0, NULL);
+	if (rc != 0) {
+		d_list_del(&req->car_link);
+		return rc;
+	}
+	tls->dt_agg_running = true;
+	return 0;
+}
+
+/* Queue the aggregation request on the current xstream */
+static int
+cont_agg_enqueue_one(void *vin)
+{
+	struct cont_tgt_epoch_aggregate_in	*in = vin;
+	struct dsm_tls				*tls = dsm_tls_get();
+	struct cont_agg_req			*req;
+	struct ds_cont				*cont;
+	unsigned int				 i;
+	int					 rc;
+
+	D_ALLOC_PTR(req);
+	if (req == NULL)
+		return -DER_NOMEM;
+
+	req->car_epr_nr = in->tai_epr_list.ca_count;
+	D_ALLOC_ARRAY(req->car_eprs, req->car_epr_nr);
+	if (req->car_eprs == NULL) {
+		D_FREE_PTR(req);
+		return -DER_NOMEM;
+	}
+	memcpy(req->car_eprs, in->tai_epr_list.ca_arrays,
+	       sizeof(*req->car_eprs) * req->car_epr_nr);
+	uuid_copy(req->car_pool_uuid, in->tai_pool_uuid);
+	uuid_copy(req->car_cont_uuid, in->tai_cont_uuid);
+
+	/*
+	 * Remember the newest range for the aggregation triggered by updates,
+	 * only containers opened on this xstream can be updated.
+	 */
+	if (cont_lookup(tls->dt_cont_cache, in->tai_cont_uuid, NULL,
+			&cont) == 0) {
+		for (i = 0; i < req->car_epr_nr; i++) {
+			if (req->car_eprs[i].epr_hi > cont->sc_agg_epr.epr_hi)
+				cont->sc_agg_epr = req->car_eprs[i];
+		}
+		cont_put(tls->dt_cont_cache, cont);
+	}
+
+	rc = cont_agg_submit(tls, req);
+	if (rc != 0)
+		cont_agg_req_free(req);
+	return rc;
+}
+
+/**
+ * Called after an update of \a epoch through \a hdl on the current xstream,
+ * it queues the aggregation of the objects VOS found deep or overlapped.
+ *
+ * Aggregation can't go beyond the ranges granted by the container service,
+ * so nothing is queued if the update is out of the latest granted range.
+ * VOS keeps such objects, they are aggregated ahead of the others on the
+ * next broadcast (see vos_cont_hot_objs()).
+ */
+void
+ds_cont_agg_check(struct ds_cont_hdl *hdl, daos_epoch_t epoch)
+{
+	struct dsm_tls		*tls = dsm_tls_get();
+	struct ds_cont		*cont = hdl->sch_cont;
+	struct cont_agg_req	*req;
+	daos_unit_oid_t		 oids[CONT_AGG_HOT_MAX];
+	int			 nr;
+	int			 rc;
+
+	if (epoch < cont->sc_agg_epr.epr_lo || epoch > cont->sc_agg_epr.epr_hi)
+		return;
+
+	/* objects found meanwhile are kept for the pending request */
+	d_list_for_each_entry(req, &tls->dt_agg_list, car_link) {
+		if (req->car_oids != NULL &&
+		    uuid_compare(req->car_cont_uuid, cont->sc_uuid) == 0)
+			return;
+	}
+
+	nr = vos_cont_agg_objs(cont->sc_hdl, oids, CONT_AGG_HOT_MAX);
+	if (nr <= 0)
+		return;
+
+	D_ALLOC_PTR(req);
+	if (req == NULL)
+		goto failed;
+
+	D_ALLOC_ARRAY(req->car_eprs, 1);
+	D_ALLOC_ARRAY(req->car_oids, nr);
+	if (req->car_eprs == NULL || req->car_oids == NULL) {
+		cont_agg_req_free(req);
+		goto failed;
+	}
+	req->car_eprs[0] = cont->sc_agg_epr;
+	req->car_epr_nr = 1;
+	memcpy(req->car_oids, oids, sizeof(*oids) * nr);
+	req->car_oid_nr = nr;
+	uuid_copy(req->car_pool_uuid, hdl->sch_pool->spc_uuid);
+	uuid_copy(req->car_cont_uuid, cont->sc_uuid);
+
+	rc = cont_agg_submit(tls, req);
+	if (rc == 0)
+		return;
+
+	cont_agg_req_free(req);
+failed:
+	/* not fatal, the objects are still in the hot object table */
+	D_DEBUG(DF_DSMS, DF_CONT": failed to queue aggregation of %d objects\n",
+		DP_CONT(hdl->sch_pool->spc_uuid, cont->sc_uuid), nr);
+}
+
+void
+ds_cont_tgt_agg_list_fini(struct dsm_tls *tls)
+{
+	struct cont_agg_req	*req;
+	struct cont_agg_req	*tmp;
+
+	d_list_for_each_entry_safe(req, tmp, &tls->dt_agg_list, car_link) {
+		d_list_del(&req->car_link);
+		cont_agg_req_free(req);
+	}
+
+	while (!d_list_empty(&tls->dt_agg_stats))
+		cont_agg_stats_free(d_list_entry(tls->dt_agg_stats.next,
+						 struct cont_agg_stats,
+						 cas_link));
+}
+
 void
 ds_cont_tgt_epoch_aggregate_handler(crt_rpc_t *rpc)
 {
-	struct cont_tgt_epoch_aggregate_in	 in_copy;
 	struct cont_tgt_epoch_aggregate_in	*in  = crt_req_get(rpc);
 	struct cont_tgt_epoch_aggregate_out	*out = crt_reply_get(rpc);
 	daos_epoch_range_t			*epr;
@@ -1099,32 +1555,20 @@ ds_cont_tgt_epoch_aggregate_handler(crt_rpc_t *rpc)
 		}
 	}
 
-	/* TODO: Use bulk transfer to avoid memory copy? */
-	D_ALLOC_ARRAY(epr, (int) in->tai_epr_list.ca_count);
-	if (epr == NULL) {
-		rc = -DER_NOMEM;
-		goto out;
-	}
-	memcpy(epr, in->tai_epr_list.ca_arrays,
-	       sizeof(*epr) * in->tai_epr_list.ca_count);
-	in_copy = *in;
-	in_copy.tai_epr_list.ca_arrays = epr;
-
+	/*
+	 * Queue the request to the aggregation ULT of each xstream, the
+	 * actual aggregation is done in background.
+	 */
+	rc = dss_thread_collective(cont_agg_enqueue_one, in);
+	if (rc != 0)
+		D_ERROR(DF_CONT": Failed to queue aggregation: %d\n",
+			DP_CONT(in->tai_pool_uuid, in->tai_cont_uuid), rc);
 out:
-	/* Reply without waiting for the aggregation ULTs to finish. */
 	out->tao_rc = (rc == 0 ? 0 : 1);
 	D_DEBUG(DF_DSMS, DF_CONT": replying rpc %p: %d (%d)\n",
 		DP_CONT(in->tai_pool_uuid, in->tai_cont_uuid),
 		rpc, out->tao_rc, rc);
 	crt_reply_send(rpc);
-	if (out->tao_rc != 0)
-		return;
-
-	rc = dss_thread_collective(cont_epoch_aggregate_one, &in_copy);
-	if (rc != 0)
-		D_ERROR(DF_CONT": Aggregation failed: %d\n",
-			DP_CONT(in->tai_pool_uuid, in->tai_cont_uuid), rc);
-	D_FREE(epr);
 }
 
 int
@@ -1140,9 +1584,15 @@ ds_cont_tgt_epoch_aggregate_aggregator(crt_rpc_t *source, crt_rpc_t *result,
 	return 0;
 }
 
-/* iterate all of objects of the container. */
+/**
+ * Iterate all of objects of the container.
+ *
+ * \param[in,out] anchor	[in]: where to begin, NULL or zero anchor to
+ *				begin from the first object; [out]: updated to
+ *				the current object before each \a callback.
+ */
 int
-ds_cont_obj_iter(daos_handle_t ph, uuid_t co_uuid,
+ds_cont_obj_iter(daos_handle_t ph, uuid_t co_uuid, daos_anchor_t *anchor,
 		 cont_iter_cb_t callback, void *arg)
 {
 	vos_iter_param_t param;
@@ -1168,7 +1618,10 @@ ds_cont_obj_iter(daos_handle_t ph, uuid_t co_uuid,
 		D_GOTO(close, rc);
 	}
 
-	rc = vos_iter_probe(iter_h, NULL);
+	if (anchor != NULL && daos_anchor_is_zero(anchor))
+		rc = vos_iter_probe(iter_h, NULL);
+	else
+		rc = vos_iter_probe(iter_h, anchor);
 	if (rc != 0) {
 		if (rc == -DER_NONEXIST)
 			rc = 0;
@@ -1180,7 +1633,7 @@ ds_cont_obj_iter(daos_handle_t ph, uuid_t co_uuid,
 	while (1) {
 		vos_iter_entry_t ent;
 
-		rc = vos_iter_fetch(iter_h, &ent, NULL);
+		rc = vos_iter_fetch(iter_h, &ent, anchor);
 		if (rc != 0) {
 			/* reach to the end of the container */
 			if (rc == -DER_NONEXIST)
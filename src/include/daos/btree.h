@@ -81,6 +81,11 @@ struct btr_record {
 /**
  * Tree node.
  *
+ * If the tree has BTR_FEAT_KEY_ARRAY, the records are preceded by an array of
+ * tree order integers, which mirrors the integer keys, or prefixes of hashed
+ * or direct keys of the records. The search within a node is narrowed down by
+ * this array before calling any key callback.
+ *
  * NB: could be PM data structure.
  */
 struct btr_node {
@@ -94,7 +99,7 @@ struct btr_node {
 	uint64_t			tn_gen;
 	/** the first child, it is unused on leaf node */
 	TMMID(struct btr_node)		tn_child;
-	/** records in this node */
+	/** records in this node, they follow the key array if there is one */
 	struct btr_record		tn_recs[0];
 };
 
@@ -265,6 +270,39 @@ typedef struct {
 	 */
 	int		(*to_hkey_cmp)(struct btr_instance *tins,
 				       struct btr_record *rec, void *hkey);
+	/**
+	 * Optional:
+	 * Return the leading 64 bits of a hashed key, they are stored in the
+	 * key array of a node, see BTR_FEAT_KEY_ARRAY. Prefixes should be
+	 * ordered as hashed keys, and \a to_hkey_cmp should only return
+	 * BTR_CMP_EQ or BTR_CMP_MATCHED for hashed keys with the same prefix.
+	 *
+	 * Absent:
+	 * The tree can't have the key array unless it has integer key.
+	 *
+	 * \param tins	[IN]	Tree instance which contains the root mmid
+	 *			and memory class etc.
+	 * \param hkey	[IN]	hashed key
+	 */
+	uint64_t	(*to_hkey_prefix)(struct btr_instance *tins,
+					  void *hkey);
+	/**
+	 * Optional:
+	 * Return the leading 64 bits of a direct key, they are stored in the
+	 * key array of a node, see BTR_FEAT_KEY_ARRAY. Prefixes should be
+	 * ordered as keys by \a to_key_cmp.
+	 *
+	 * Absent:
+	 * Direct key tree can't have the key array.
+	 *
+	 * \param tins	[IN]	Tree instance which contains the root mmid
+	 *			and memory class etc.
+	 * \param rec	[IN]	Record of the key, NULL to use \a key.
+	 * \param key	[IN]	The key if \a rec is NULL.
+	 */
+	uint64_t	(*to_key_prefix)(struct btr_instance *tins,
+					 struct btr_record *rec,
+					 daos_iov_t *key);
 	/**
 	 * Optional:
 	 * Comparison of real key. It can be ignored if there is no hash
@@ -514,6 +552,12 @@ enum btr_feats {
 	 * to_key_cmp callback
 	 */
 	BTR_FEAT_DIRECT_KEY		= (1 << 1),
+	/** Keys, or prefixes of hashed or direct keys of a node are also
+	 * stored in a contiguous array which is searched before calling any
+	 * key callback, see btr_node. Requires BTR_FEAT_UINT_KEY,
+	 * btr_ops::to_hkey_prefix, or btr_ops::to_key_prefix for direct key.
+	 */
+	BTR_FEAT_KEY_ARRAY		= (1 << 2),
 };
 
 /**
@@ -553,6 +597,10 @@ int  dbtree_fetch(daos_handle_t toh, dbtree_probe_opc_t opc,
 		  daos_iov_t *key, daos_iov_t *key_out, daos_iov_t *val_out);
 int  dbtree_upsert(daos_handle_t toh, dbtree_probe_opc_t opc,
 		   daos_iov_t *key, daos_iov_t *val);
+int  dbtree_build_sorted(daos_handle_t toh, int nr, daos_iov_t *keys,
+			 daos_iov_t *vals, unsigned int fill);
+int  dbtree_bulk_insert(daos_handle_t toh, int nr, daos_iov_t *keys,
+			daos_iov_t *vals);
 int  dbtree_delete(daos_handle_t toh, daos_iov_t *key, void *args);
 int  dbtree_query(daos_handle_t toh, struct btr_attr *attr,
 		  struct btr_stat *stat);
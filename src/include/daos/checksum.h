@@ -59,4 +59,34 @@ int		daos_csum_compute(daos_csum_t *csum, daos_sg_list_t *sgl);
 daos_size_t	daos_csum_get_size(daos_csum_t *csum);
 int		daos_csum_get(daos_csum_t *csum, daos_csum_buf_t *csum_buf);
 int		daos_csum_compare(daos_csum_t *csum, daos_csum_t *csum_src);
+
+/**
+ * Chunked checksum: the data is split into fixed size chunks which are
+ * checksummed independently, so a partial read can be verified without
+ * reading the whole record. The per-chunk checksums are packed back to back
+ * in \a chunks->cs_csum, which can be stored as the checksum of an extent.
+ * The running checksum of \a csum is updated as well, and is identical to
+ * the one produced by daos_csum_compute() on the same data.
+ *
+ * The checksums of an array extent in daos_iod_t::iod_csums are computed
+ * with DAOS_CSUM_CHUNK_SIZE.
+ */
+#define DAOS_CSUM_CHUNK_SIZE	(32UL << 10)
+
+daos_size_t	daos_csum_chunk_nr(daos_size_t len, daos_size_t chunk_size);
+int		daos_csum_compute_chunks(daos_csum_t *csum, daos_sg_list_t *sgl,
+					 daos_size_t chunk_size,
+					 daos_csum_buf_t *chunks);
+/**
+ * Fold the checksum \a next of the \a next_len bytes which follow the data
+ * checksummed by \a csum into \a csum. \a next must have been computed
+ * from a reset checksum, so the segments of a large SGL can be checksummed
+ * in parallel and combined in order afterwards.
+ */
+int		daos_csum_combine(daos_csum_t *csum, daos_csum_t *next,
+				  daos_size_t next_len);
+int		daos_csum_chunk_verify(daos_csum_t *csum,
+				       daos_csum_buf_t *chunks,
+				       unsigned int idx, const void *buf,
+				       daos_size_t len);
 #endif
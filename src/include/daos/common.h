@@ -285,6 +285,17 @@ enum {
 	DSS_KEY_FAIL_LOC = 0,
 	DSS_KEY_FAIL_VALUE,
 	DSS_REBUILD_RES_PERCENTAGE,
+	DSS_AGGREGATE_RES_PERCENTAGE,
+	/** p99 queueing delay target (us) of I/O ULTs, 0 to disable */
+	DSS_SCHED_IO_LATENCY_TARGET,
+	/** p99 queueing delay target (us) of metadata ULTs, 0 to disable */
+	DSS_SCHED_META_LATENCY_TARGET,
+	/** print the scheduler statistics of all xstreams */
+	DSS_SCHED_STATS_DUMP,
+	/** enable (1) or disable (0) work stealing between xstreams */
+	DSS_SCHED_WORK_STEALING,
+	/** min size (bytes) of zero-copy fetch from SCM, 0 for always */
+	DSS_OBJ_ZC_THRESHOLD,
 	DSS_KEY_NUM,
 };
 
@@ -351,6 +362,7 @@ daos_fail_value_get(void);
 #define DAOS_REBUILD_NO_REBUILD (DAOS_REBUILD_FAIL_MOD | 0x00d)
 #define DAOS_REBUILD_NO_UPDATE (DAOS_REBUILD_FAIL_MOD | 0x00e)
 #define DAOS_REBUILD_TGT_NOSPACE (DAOS_REBUILD_FAIL_MOD | 0x00f)
+#define DAOS_REBUILD_TGT_CKPT_HANG (DAOS_REBUILD_FAIL_MOD | 0x010)
 
 /* failure for DAOS_RDB_MODULE */
 #define DAOS_RDB_SKIP_APPENDENTRIES_FAIL (DAOS_RDB_FAIL_MOD | 0x001)
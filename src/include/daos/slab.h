@@ -0,0 +1,124 @@
+/**
+ * (C) Copyright 2019 Intel Corporation.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * GOVERNMENT LICENSE RIGHTS-OPEN SOURCE SOFTWARE
+ * The Government's rights to use, modify, reproduce, release, perform, display,
+ * or disclose this software are subject to the terms of the Apache License
+ * provided in Contract No. B609815.
+ * Any reproduction of computer software, computer software documentation, or
+ * portions thereof marked with this legend must also reproduce the markings.
+ */
+/**
+ * Per-xstream slab cache for volatile DAOS structures.
+ *
+ * Tree contexts, I/O contexts and entry arrays are allocated and freed on
+ * every tree open and every I/O. A slab cache recycles them through per-type
+ * free lists instead of returning them to the heap. A slab cache is owned by
+ * exactly one thread (xstream) and is bound to it by daos_slab_cache_bind(),
+ * so it takes no lock.
+ *
+ * Callers allocate through daos_slab_alloc()/daos_slab_free() which fall
+ * back to the heap if no cache is bound to the calling thread (client
+ * library, standalone VOS), so the same code runs in both environments.
+ */
+#ifndef __DAOS_SLAB_H__
+#define __DAOS_SLAB_H__
+
+#include <daos/common.h>
+
+/** Types of object which are cached */
+enum daos_slab_type {
+	/** btree context, see btr_context_create() */
+	DAOS_SLAB_BTR_CTX,
+	/** evtree context, see evt_tcx_create() */
+	DAOS_SLAB_EVT_CTX,
+	/** evtree entry array of the minimum allocation size */
+	DAOS_SLAB_EVT_ENTS,
+	/** VOS I/O context, see vos_ioc_create() */
+	DAOS_SLAB_VOS_IOC,
+	/** RPC handler ULT argument, see dss_process_rpc() */
+	DAOS_SLAB_DSS_RPC,
+	DAOS_SLAB_MAX,
+};
+
+/** default number of cached objects per type */
+#define DAOS_SLAB_CACHED_MAX	64
+
+struct daos_slab_stats {
+	/** allocations served from the free list */
+	uint64_t		ss_hits;
+	/** allocations which went to the heap */
+	uint64_t		ss_misses;
+	/** frees which went back to the free list */
+	uint64_t		ss_frees;
+	/** frees which went to the heap because the free list was full */
+	uint64_t		ss_drops;
+	/** objects currently on the free list */
+	uint32_t		ss_cached;
+};
+
+struct daos_slab {
+	/** singly linked free list, linked through the object itself */
+	void			*sl_free;
+	/** object size, set by the first allocation */
+	size_t			 sl_size;
+	/** maximum number of objects on the free list */
+	uint32_t		 sl_max;
+	struct daos_slab_stats	 sl_stats;
+};
+
+struct daos_slab_cache {
+	struct daos_slab	 sc_slabs[DAOS_SLAB_MAX];
+};
+
+/**
+ * Create a slab cache.
+ *
+ * \param max		[IN]	Maximum number of cached objects per type
+ * \param cache_p	[OUT]	Returned slab cache
+ *
+ * \return			0 on success, negative value on error
+ */
+int daos_slab_cache_create(unsigned int max, struct daos_slab_cache **cache_p);
+
+/**
+ * Release all cached objects and destroy the slab cache, it must have been
+ * unbound from its thread.
+ */
+void daos_slab_cache_destroy(struct daos_slab_cache *cache);
+
+/**
+ * Bind \a cache to the calling thread, or unbind the current one if \a cache
+ * is NULL.
+ */
+void daos_slab_cache_bind(struct daos_slab_cache *cache);
+
+/** Return the slab cache bound to the calling thread, or NULL */
+struct daos_slab_cache *daos_slab_cache_current(void);
+
+/** Return counters of slab \a type of \a cache */
+void daos_slab_query(struct daos_slab_cache *cache, enum daos_slab_type type,
+		     struct daos_slab_stats *stats);
+
+/**
+ * Allocate a zeroed object of \a size bytes, \a size must be the same for
+ * all allocations of the same \a type.
+ */
+void *daos_slab_alloc(enum daos_slab_type type, size_t size);
+
+/** Free an object which was allocated by daos_slab_alloc() */
+void daos_slab_free(enum daos_slab_type type, void *ptr);
+
+#endif /* __DAOS_SLAB_H__ */
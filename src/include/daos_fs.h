@@ -37,6 +37,9 @@
 extern "C" {
 #endif
 
+#include <daos_types.h>
+#include <daos_addons.h>
+
 #define DFS_MAX_PATH 128
 #define DFS_MAX_FSIZE (~0ULL)
 
@@ -73,6 +76,28 @@ dfs_mount(daos_handle_t poh, daos_handle_t coh, int flags, dfs_t **dfs);
 int
 dfs_umount(dfs_t *dfs);
 
+/**
+ * Set the memory budget of the client data cache of the file system. The
+ * regular files opened after the cache is enabled are cached in units of one
+ * array chunk: sequential reads prefetch the next chunks asynchronously, and
+ * writes are buffered and coalesced per chunk until a chunk is full, or the
+ * file is flushed by dfs_sync(), dfs_release(), dfs_get_size(), dfs_ostat(),
+ * dfs_punch() or dfs_readx(). dfs_writex() only flushes and drops the chunks
+ * it overlaps. Cached data written by other clients may be stale, and data
+ * written through the cache is only seen by other clients after it's flushed.
+ * The cache is disabled by default.
+ *
+ * \param[in]	dfs	Pointer to the mounted file system.
+ * \param[in]	size	Cache budget in bytes, 0 to disable the cache, which
+ *			fails with -DER_BUSY if cached files are still open.
+ *			Files whose chunk is larger than half of the budget
+ *			are not cached.
+ *
+ * \return		0 on Success. Negative on Failure.
+ */
+int
+dfs_set_cache(dfs_t *dfs, daos_size_t size);
+
 /**
  * Lookup a path in the DFS and return the associated open object and mode.
  * The object must be released with dfs_release().
@@ -89,6 +114,26 @@ int
 dfs_lookup(dfs_t *dfs, const char *path, int flags, dfs_obj_t **obj,
 	   mode_t *mode);
 
+/**
+ * Lookup an entry in an open parent directory and return the associated open
+ * object, its mode and optionally its stat attributes. Unlike dfs_lookup(),
+ * only the entry itself is fetched, the path is not walked from the root.
+ * The object must be released with dfs_release().
+ *
+ * \param[in]	dfs	Pointer to the mounted file system.
+ * \param[in]	parent	Opened parent directory object. If NULL, use root obj.
+ * \param[in]	name	Link name of the object in the parent.
+ * \param[in]	flags	Access flags to open with (O_RDONLY or O_RDWR).
+ * \param[out]	obj	Pointer to the object looked up.
+ * \param[out]	mode	(Optional) mode_t (permissions + type).
+ * \param[out]	stbuf	(Optional) Stat struct, filled as by dfs_stat().
+ *
+ * \return		0 on Success. Negative on Failure.
+ */
+int
+dfs_lookup_rel(dfs_t *dfs, dfs_obj_t *parent, const char *name, int flags,
+	       dfs_obj_t **obj, mode_t *mode, struct stat *stbuf);
+
 /**
  * Create/Open a directory, file, or Symlink.
  * The object must be released with dfs_release().
@@ -151,6 +196,45 @@ dfs_read(dfs_t *dfs, dfs_obj_t *obj, daos_sg_list_t sgl, daos_off_t off,
 int
 dfs_write(dfs_t *dfs, dfs_obj_t *obj, daos_sg_list_t sgl, daos_off_t off);
 
+/**
+ * Read data from multiple ranges of the file object. With an event, the call
+ * returns once the I/O is submitted and \a read_size is set when the event
+ * completes; \a iod, \a sgl and \a read_size must stay valid until then.
+ * Buffer content for ranges past the end of file is undefined.
+ *
+ * \param[in]	dfs	Pointer to the mounted file system.
+ * \param[in]	obj	Opened file object.
+ * \param[in]	iod	IO descriptor with the list of file ranges to read.
+ * \param[in]	sgl	Scatter/Gather list for data buffer, sized to hold
+ *			all the ranges of \a iod.
+ * \param[out]	read_size
+ *			How much data is actually read (not past EOF).
+ * \param[in]	ev	Completion event, it is optional and can be NULL.
+ *			The function will run in blocking mode if \a ev is NULL.
+ *
+ * \return		0 on Success. Negative on Failure.
+ */
+int
+dfs_readx(dfs_t *dfs, dfs_obj_t *obj, daos_array_iod_t *iod,
+	  daos_sg_list_t *sgl, daos_size_t *read_size, daos_event_t *ev);
+
+/**
+ * Write data to multiple ranges of the file object. With an event, \a iod and
+ * \a sgl must stay valid until the event completes.
+ *
+ * \param[in]	dfs	Pointer to the mounted file system.
+ * \param[in]	obj	Opened file object.
+ * \param[in]	iod	IO descriptor with the list of file ranges to write.
+ * \param[in]	sgl	Scatter/Gather list for data buffer.
+ * \param[in]	ev	Completion event, it is optional and can be NULL.
+ *			The function will run in blocking mode if \a ev is NULL.
+ *
+ * \return		0 on Success. Negative on Failure.
+ */
+int
+dfs_writex(dfs_t *dfs, dfs_obj_t *obj, daos_array_iod_t *iod,
+	   daos_sg_list_t *sgl, daos_event_t *ev);
+
 /**
  * Query size of file data.
  *
@@ -213,6 +297,38 @@ int
 dfs_readdir(dfs_t *dfs, dfs_obj_t *obj, daos_anchor_t *anchor,
 	    uint32_t *nr, struct dirent *dirs);
 
+/**
+ * directory readdir, returning the attributes of the entries as well. The
+ * entries of a batch are fetched in parallel, instead of one lookup and one
+ * stat call per entry. Entries removed while the directory is enumerated are
+ * skipped.
+ *
+ * \param[in]	dfs	Pointer to the mounted file system.
+ * \param[in]	obj	Opened directory object.
+ * \param[in,out]
+ *		anchor	Hash anchor for the next call, it should be set to
+ *			zeroes for the first call, it should not be changed
+ *			by caller between calls.
+ * \param[in,out]
+ *		nr	[in]: number of entries allocated in \a dirs, \a objs
+ *			and \a stbufs.
+ *			[out]: number of returned entries.
+ * \param[in,out]
+ *		dirs	[in] preallocated array of dirents.
+ *			[out]: dirents returned with d_name filled only.
+ * \param[out]	objs	Optional array of the entries opened with the access
+ *			mode of the mount, to be released with dfs_release().
+ * \param[out]	stbufs	Optional array of the stat of the entries. The link
+ *			count of a directory is not computed and reported as
+ *			1, which tools like find(1) take as unknown.
+ *
+ * \return		0 on Success. Negative on Failure.
+ */
+int
+dfs_readdirplus(dfs_t *dfs, dfs_obj_t *obj, daos_anchor_t *anchor,
+		uint32_t *nr, struct dirent *dirs, dfs_obj_t **objs,
+		struct stat *stbufs);
+
 /**
  * Create a directory.
  *
@@ -241,6 +357,20 @@ dfs_mkdir(dfs_t *dfs, dfs_obj_t *parent, const char *name, mode_t mode);
 int
 dfs_remove(dfs_t *dfs, dfs_obj_t *parent, const char *name, bool force);
 
+/**
+ * Remove all the entries of a directory recursively, the directory itself is
+ * kept. The entries are removed in parallel, with a bounded number of them in
+ * flight. dfs_remove() with force set uses the same path for the contents of
+ * the directory.
+ *
+ * \param[in]	dfs	Pointer to the mounted file system.
+ * \param[in]	obj	Opened directory object.
+ *
+ * \return		0 on Success. Negative on Failure.
+ */
+int
+dfs_remove_tree(dfs_t *dfs, dfs_obj_t *obj);
+
 /**
  * Move an object possible between different dirs with a new link name.
  *
@@ -283,6 +413,33 @@ dfs_exchange(dfs_t *dfs, dfs_obj_t *parent1, char *name1,
 int
 dfs_get_mode(dfs_obj_t *obj, mode_t *mode);
 
+/**
+ * Retrieve the DAOS object ID of an open object. The ID is unique in the
+ * namespace for files and directories; symlinks have no object and return a
+ * zero ID.
+ *
+ * \param[in]	obj	Open object to query.
+ * \param[out]	oid	DAOS object ID.
+ *
+ * \return		0 on Success. Negative on Failure.
+ */
+int
+dfs_obj2id(dfs_obj_t *obj, daos_obj_id_t *oid);
+
+/**
+ * Update the parent and the entry name of an open object after it has been
+ * moved with dfs_move() or dfs_exchange(), so that operations on the object
+ * keep working on its new entry.
+ *
+ * \param[in]	obj	Open object that was moved.
+ * \param[in]	parent	Opened new parent directory object.
+ * \param[in]	name	New link name of the object.
+ *
+ * \return		0 on Success. Negative on Failure.
+ */
+int
+dfs_update_parent(dfs_obj_t *obj, dfs_obj_t *parent, const char *name);
+
 /**
  * Retrieve the DAOS open handle of a DFS file object. User should not close
  * this handle. This is used in cases like MPI-IO where 1 rank creates the file
@@ -382,6 +539,23 @@ dfs_access(dfs_t *dfs, dfs_obj_t *parent, const char *name, int mask);
 int
 dfs_chmod(dfs_t *dfs, dfs_obj_t *parent, const char *name, mode_t mode);
 
+/**
+ * Change the access and modification times of an entry, the status change
+ * time is set to the current time. Symlinks are not dereferenced.
+ *
+ * \param[in]	dfs	Pointer to the mounted file system.
+ * \param[in]	parent	Opened parent directory object. If NULL, use root obj.
+ * \param[in]	name	Link name of the object. Can be NULL if parent is root,
+ *			which means operation will be on root object.
+ * \param[in]	atime	New access time, NULL to keep it.
+ * \param[in]	mtime	New modification time, NULL to keep it.
+ *
+ * \return		0 on Success. Negative on Failure.
+ */
+int
+dfs_utimes(dfs_t *dfs, dfs_obj_t *parent, const char *name,
+	   const time_t *atime, const time_t *mtime);
+
 /**
  * Sync to commit the latest epoch on the container. This applies to the entire
  * namespace and not to a particular file/directory.
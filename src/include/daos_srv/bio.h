@@ -48,9 +48,19 @@ typedef struct {
 	uint16_t	ba_type;
 	/* Is the address a hole ? */
 	uint16_t	ba_hole;
-	uint32_t	ba_padding;
+	/* BIO_ADDR_FL_* */
+	uint16_t	ba_flags;
+	uint16_t	ba_padding;
 } bio_addr_t;
 
+enum {
+	/*
+	 * NVMe extent packed into a block shared with other extents, the
+	 * extents written before this flag was introduced are whole blocks.
+	 */
+	BIO_ADDR_FL_FRAG	= (1 << 0),
+};
+
 struct bio_iov {
 	/*
 	 * For SCM, it's direct memory address of 'ba_off';
@@ -107,6 +117,18 @@ bio_addr_set_hole(bio_addr_t *addr, uint16_t hole)
 	addr->ba_hole = hole;
 }
 
+static inline bool
+bio_addr_is_frag(bio_addr_t *addr)
+{
+	return addr->ba_flags & BIO_ADDR_FL_FRAG;
+}
+
+static inline void
+bio_addr_set_frag(bio_addr_t *addr)
+{
+	addr->ba_flags |= BIO_ADDR_FL_FRAG;
+}
+
 static inline uint64_t
 bio_iov2off(struct bio_iov *biov)
 {
@@ -54,6 +54,8 @@ struct ds_cont {
 	struct daos_llink	sc_list;
 	daos_handle_t		sc_hdl;
 	uuid_t			sc_uuid;
+	/* latest aggregation range granted by the container service */
+	daos_epoch_range_t	sc_agg_epr;
 };
 
 /*
@@ -72,6 +74,8 @@ struct ds_cont_hdl {
 };
 
 struct ds_cont_hdl *ds_cont_hdl_lookup(const uuid_t uuid);
+int ds_cont_hdl_fetch(uuid_t pool_uuid, uuid_t cont_hdl_uuid,
+		      struct ds_cont_hdl **cont_hdl);
 void ds_cont_hdl_put(struct ds_cont_hdl *hdl);
 
 int ds_cont_close_by_pool_hdls(const uuid_t pool_uuid, uuid_t *pool_hdls,
@@ -89,10 +93,12 @@ ds_cont_lookup(uuid_t pool_uuid, uuid_t cont_uuid, struct ds_cont **ds_cont);
 
 void ds_cont_put(struct ds_cont *cont);
 
+void ds_cont_agg_check(struct ds_cont_hdl *hdl, daos_epoch_t epoch);
+
 typedef int (*cont_iter_cb_t)(uuid_t co_uuid, daos_unit_oid_t,
 			      daos_epoch_t eph, void *arg);
 
 int
-ds_cont_obj_iter(daos_handle_t ph, uuid_t co_uuid, cont_iter_cb_t callback,
-		 void *arg);
+ds_cont_obj_iter(daos_handle_t ph, uuid_t co_uuid, daos_anchor_t *anchor,
+		 cont_iter_cb_t callback, void *arg);
 #endif /* ___DAOS_SRV_CONTAINER_H_ */
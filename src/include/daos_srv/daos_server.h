@@ -55,6 +55,12 @@ extern const char      *dss_nvme_conf;
 /** Socket Directory */
 extern const char      *dss_socket_dir;
 
+/**
+ * Fetches of at least this many bytes are transferred from SCM in place,
+ * smaller ones are staged through DRAM, see DSS_OBJ_ZC_THRESHOLD.
+ */
+extern unsigned int	dss_zc_threshold;
+
 
 /**
  * Stackable Module API
@@ -71,8 +77,10 @@ extern const char      *dss_socket_dir;
  * Thead-local storage
  */
 struct dss_thread_local_storage {
-	uint32_t	dtls_tag;
-	void		**dtls_values;
+	uint32_t		 dtls_tag;
+	void			**dtls_values;
+	/** slab cache for tree/IO contexts of this xstream */
+	struct daos_slab_cache	*dtls_slabs;
 };
 
 enum dss_module_tag {
@@ -216,10 +224,17 @@ int dss_ult_create(void (*func)(void *), void *arg,
 		   int stream_id, size_t stack_size, ABT_thread *ult);
 int dss_rebuild_ult_create(void (*func)(void *), void *arg,
 			   int stream_id, size_t stack_size, ABT_thread *ult);
+int dss_aggregate_ult_create(void (*func)(void *), void *arg,
+			     int stream_id, size_t stack_size,
+			     ABT_thread *ult);
+int dss_steal_ult_create(void (*func)(void *), void *arg,
+			 int stream_id, size_t stack_size, ABT_thread *ult);
+bool dss_xstream_is_busy(void);
 int dss_ult_create_all(void (*func)(void *), void *arg);
 int dss_ult_create_execute(int (*func)(void *), void *arg,
 			   void (*user_cb)(void *), void *cb_args,
 			   int stream_id, size_t stack_size);
+int dss_helper_execute(int (*func)(void *), void *arg);
 
 /* Pack return codes with additional argument to reduce */
 struct dss_stream_arg_type {
@@ -364,20 +379,49 @@ struct dss_acc_task {
  */
 int dss_acc_offload(struct dss_acc_task *at_args);
 
-/** Different type of ES pools, there are 3 pools for now
+/** Different type of ES pools
  *
  *  DSS_POOL_PRIV     Private pool: I/O requests will be added to this pool.
  *  DSS_POOL_SHARE    Shared pool: Other requests and ULT created during
  *                    processing rpc.
  *  DSS_POOL_REBUILD  rebuild pool: pools specially for rebuild tasks.
+ *  DSS_POOL_AGGREGATE
+ *		      aggregate pool: background aggregation, it runs when
+ *		      the other pools are empty, or for a share of
+ *		      dss_agg_res_percentage.
+ *  DSS_POOL_STEAL    steal pool: ULTs which are not bound to the target of
+ *		      the xstream, idle xstreams can steal them if work
+ *		      stealing is enabled, see dss_steal_ult_create().
+ *
+ * Each pool is a scheduling class, the xstream scheduler shares the CPU
+ * among the pools with runnable ULTs by weight, see dss_sched_unit_pop().
  */
 enum {
 	DSS_POOL_PRIV,
 	DSS_POOL_SHARE,
 	DSS_POOL_REBUILD,
+	DSS_POOL_AGGREGATE,
+	DSS_POOL_STEAL,
 	DSS_POOL_CNT,
 };
 
+/** Scheduler statistics of a pool (scheduling class) of an xstream */
+struct dss_sched_stat {
+	/** base weight, see dss_parameters_set() */
+	unsigned int	ss_weight;
+	/** weight multiplier raised by the latency target */
+	unsigned int	ss_boost;
+	/** number of ULTs scheduled from the pool */
+	uint64_t	ss_runs;
+	/** p99 queueing delay of the last window in microseconds */
+	uint64_t	ss_p99_us;
+	/** p99 queueing delay target in microseconds, 0 if none */
+	uint64_t	ss_target_us;
+};
+
+int dss_sched_query(int stream_id, struct dss_sched_stat *stats,
+		    uint64_t *steals);
+
 /* DAOS object API on the server side */
 int ds_obj_open(daos_handle_t coh, daos_obj_id_t oid,
 		unsigned int mode, daos_handle_t *oh);
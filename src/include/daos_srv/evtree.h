@@ -65,6 +65,23 @@ struct evt_desc {
 	uint32_t			dc_ver;
 	/** Magic number for validation */
 	uint32_t			dc_magic;
+	/** struct evt_desc_csum of EVT_FEAT_CSUM tree */
+	char				dc_body[0];
+};
+
+/**
+ * Per-chunk checksums of an extent, it follows evt_desc in the same
+ * allocation if the tree has EVT_FEAT_CSUM.
+ */
+struct evt_desc_csum {
+	/** chunk size in bytes, chunks start from the low offset of extent */
+	uint32_t			dcc_chunk_size;
+	/** checksum type, see daos_csum_buf_t::cs_type */
+	uint16_t			dcc_type;
+	/** bytes of checksums in \a dcc_csum, zero if extent has none */
+	uint16_t			dcc_len;
+	/** checksums of chunks, packed back to back */
+	char				dcc_csum[0];
 };
 
 struct evt_extent {
@@ -183,6 +200,8 @@ struct evt_root {
 enum evt_feats {
 	/** rectangles are Sorted by their Start Offset */
 	EVT_FEAT_SORT_SOFF		= (1 << 0),
+	/** descriptors carry the per-chunk checksums of extents */
+	EVT_FEAT_CSUM			= (1 << 1),
 };
 
 #define EVT_FEAT_DEFAULT		EVT_FEAT_SORT_SOFF
@@ -199,6 +218,10 @@ struct evt_entry_in {
 	uint32_t	ei_ver;
 	/** number of bytes per record, zero for punch */
 	uint32_t	ei_inob;
+	/** chunk size of \a ei_chunk_csum in bytes */
+	uint32_t	ei_chunk_size;
+	/** per-chunk checksums, stored by EVT_FEAT_CSUM tree only */
+	daos_csum_buf_t	ei_chunk_csum;
 	/** Address of record to insert */
 	bio_addr_t	ei_addr;
 };
@@ -225,6 +248,13 @@ struct evt_entry {
 	uuid_t				en_cookie;
 	/** checksum of entry */
 	uint64_t			en_csum;
+	/**
+	 * Per-chunk checksums of the full extent \a en_ext, it references
+	 * the tree, \a cs_len is zero if the extent has none.
+	 */
+	daos_csum_buf_t			en_chunk_csum;
+	/** chunk size of \a en_chunk_csum in bytes */
+	uint32_t			en_chunk_size;
 	/** pool map version */
 	uint32_t			en_ver;
 	/** Visibility flags for extent */
@@ -427,6 +457,28 @@ int evt_destroy(daos_handle_t toh);
  */
 int evt_insert(daos_handle_t toh, const struct evt_entry_in *entry);
 
+/** Shape of an evtree, see evt_query() */
+struct evt_stat {
+	/** depth of the tree */
+	uint32_t	es_depth;
+	/**
+	 * number of extents in the leaf node of the last inserted extent
+	 * which overlap with it, zero if nothing has been inserted by the
+	 * open handle
+	 */
+	uint32_t	es_overlap;
+};
+
+/**
+ * Query the depth of a opened tree and the overlap seen by the last insert
+ * through this open handle, it's cheap enough to be called after each
+ * update.
+ *
+ * \param toh		[IN]	The tree open handle
+ * \param stat		[OUT]	The returned tree shape
+ */
+int evt_query(daos_handle_t toh, struct evt_stat *stat);
+
 /**
  * Delete an extent \a rect from an opened tree.
  *
@@ -454,6 +506,24 @@ int evt_delete(daos_handle_t toh, const struct evt_rect *rect,
 int evt_find(daos_handle_t toh, const struct evt_rect *rect,
 	     struct evt_entry_array *ent_array);
 
+/** Algorithms used to resolve the visibility of overlapping extents */
+enum evt_sort_type {
+	/** Legacy for a few entries, sweep for the larger searches */
+	EVT_SORT_AUTO		= 0,
+	/** Sweep-line merge over the sorted runs of the tree leaves */
+	EVT_SORT_SWEEP,
+	/** Sort, truncate and re-sort the whole entry array */
+	EVT_SORT_LEGACY,
+};
+
+/**
+ * Select the algorithm used by all evtree searches of this process. This is
+ * mostly intended for benchmarks, the default is EVT_SORT_AUTO.
+ *
+ * \param type		[IN]	The algorithm to use
+ */
+void evt_sort_type_set(enum evt_sort_type type);
+
 /** Scan the tree for the non-punched visible rectangle with the highest
  *  end offset and return the offset + 1 as the size.  Size is set to 0
  *  if no entries exist.   Size is undefined if an error is returned.
@@ -89,6 +89,9 @@ struct ds_pool_child {
 	uuid_t		spc_uuid;
 	uint32_t	spc_map_version;
 	int		spc_ref;
+	/* media migration ULT, see pool_tier_ult() */
+	ABT_thread	spc_tier_ult;
+	bool		spc_tier_stop;
 };
 
 struct ds_pool_child *ds_pool_child_lookup(const uuid_t uuid);
@@ -139,7 +142,15 @@ int ds_pool_hdl_evict(const uuid_t pool_uuid, const uuid_t handle_uuid);
 
 typedef int (*obj_iter_cb_t)(uuid_t cont_uuid, daos_unit_oid_t oid,
 			     daos_epoch_t eph, void *arg);
-int ds_pool_obj_iter(uuid_t pool_uuid, obj_iter_cb_t callback, void *arg);
+/*
+ * Called before iterating the objects of a container. Returns 1 to skip the
+ * container, otherwise "anchor" can return where the iteration should begin,
+ * which is updated to the current object during the iteration.
+ */
+typedef int (*obj_iter_cont_cb_t)(uuid_t cont_uuid, daos_anchor_t **anchor,
+				  void *arg);
+int ds_pool_obj_iter(uuid_t pool_uuid, obj_iter_cont_cb_t cont_cb,
+		     obj_iter_cb_t callback, void *arg);
 
 char *ds_pool_svc_rdb_path(const uuid_t pool_uuid);
 int ds_pool_svc_rdb_uuid_store(const uuid_t pool_uuid, const uuid_t uuid);
@@ -148,6 +148,16 @@ struct rdb_cbs {
 	void (*dc_stop)(struct rdb *db, int err, void *arg);
 };
 
+/** Commit counters of a database replica, accumulated since rdb_start() */
+struct rdb_stat {
+	uint64_t	rs_commits;	/**< committed TXs */
+	uint64_t	rs_batches;	/**< batches of appended TXs */
+	uint64_t	rs_entries;	/**< TXs in these batches */
+	uint32_t	rs_batch_max;	/**< largest batch */
+	double		rs_latency;	/**< total commit latency (s) */
+	double		rs_latency_max;	/**< max commit latency (s) */
+};
+
 /** Database methods */
 void rdb_get_uuid(struct rdb *db, uuid_t uuid);
 int rdb_create(const char *path, const uuid_t uuid, size_t size,
@@ -160,6 +170,7 @@ void rdb_resign(struct rdb *db, uint64_t term);
 bool rdb_is_leader(struct rdb *db, uint64_t *term);
 int rdb_get_leader(struct rdb *db, uint64_t *term, d_rank_t *rank);
 int rdb_get_ranks(struct rdb *db, d_rank_list_t **ranksp);
+void rdb_get_stat(struct rdb *db, struct rdb_stat *stat);
 int rdb_add_replicas(struct rdb *db, d_rank_list_t *replicas);
 int rdb_remove_replicas(struct rdb *db, d_rank_list_t *replicas);
 
@@ -71,6 +71,13 @@ struct vea_resrvd_ext {
 	uint64_t		 vre_hint_seq;
 	/* Total reserved blocks */
 	uint32_t		 vre_blk_cnt;
+	/*
+	 * Byte offset within the block and byte length of a packed
+	 * reservation, see vea_reserve_frag(). vre_frag_len is 0 for
+	 * extent reservation.
+	 */
+	uint32_t		 vre_frag_off;
+	uint32_t		 vre_frag_len;
 	/* Extent vector for non-contiguous reserve */
 	struct vea_ext_vector	*vre_vector;
 };
@@ -104,6 +111,14 @@ struct vea_unmap_context {
 	void *vnc_data;
 };
 
+/* Compatible features of vea_space_df::vsd_compat */
+enum {
+	/* vsd_frag_tree is initialized, packed reservations are supported */
+	VEA_COMPAT_FEATURE_FRAG	= (1 << 0),
+};
+
+#define VEA_COMPAT_FEATURES	(VEA_COMPAT_FEATURE_FRAG)
+
 /* Free space tracking information on SCM */
 struct vea_space_df {
 	uint32_t	vsd_magic;
@@ -118,6 +133,11 @@ struct vea_space_df {
 	struct btr_root	vsd_free_tree;
 	/* Allocated extent vector tree, for non-contiguous allocation */
 	struct btr_root	vsd_vec_tree;
+	/*
+	 * Reference count of the packed blocks, sorted by offset, only valid
+	 * with VEA_COMPAT_FEATURE_FRAG.
+	 */
+	struct btr_root	vsd_frag_tree;
 };
 
 /* VEA attributes */
@@ -138,6 +158,7 @@ struct vea_stat {
 	uint64_t	vs_resrv_small;	/* Number of small reserve */
 	uint64_t	vs_resrv_vec;	/* Number of vector reserve */
 	uint32_t	vs_largest_blks;/* Largest free frag size in blocks */
+	uint64_t	vs_free_blks;	/* Total free blocks */
 };
 
 struct vea_space_info;
@@ -233,6 +254,31 @@ void vea_hint_unload(struct vea_hint_context *thc);
 int vea_reserve(struct vea_space_info *vsi, uint32_t blk_cnt,
 		struct vea_hint_context *hint, d_list_t *resrvd_list);
 
+/**
+ * Reserve less than one block by packing it into a block shared with other
+ * packed reservations. Packed reservations are appended to the block being
+ * packed for the I/O stream of @hint, a new block is reserved in
+ * @resrvd_list when it's full.
+ *
+ * Only one reserved list of an I/O stream can hold unpublished packed
+ * reservations at any time, so the caller can do read-modify-write of the
+ * block without racing with other writers.
+ *
+ * \param vsi         [IN]	In-memory compound index
+ * \param size        [IN]	Bytes to be reserved, less than block size
+ * \param hint        [IN]	Hint data
+ * \param resrvd_list [OUT]	List for storing the reserved extents
+ *
+ * \return			Zero on success, the packed reservation will be
+ *				added at the tail of @resrvd_list; -DER_BUSY if
+ *				another reserved list is packing the block;
+ *				-DER_NOSYS if packing isn't supported, see
+ *				vea_frag_supported(); Appropriated negative
+ *				value on other error
+ */
+int vea_reserve_frag(struct vea_space_info *vsi, uint32_t size,
+		     struct vea_hint_context *hint, d_list_t *resrvd_list);
+
 /**
  * Cancel the reserved extent(s)
  *
@@ -272,6 +318,28 @@ int vea_tx_publish(struct vea_space_info *vsi, struct vea_hint_context *hint,
  */
 int vea_free(struct vea_space_info *vsi, uint64_t blk_off, uint32_t blk_cnt);
 
+/**
+ * Free a packed reservation published by vea_tx_publish(). The block is
+ * freed once all the packed reservations in it are freed.
+ *
+ * \param vsi     [IN]		In-memory compound index
+ * \param blk_off [IN]		Offset of the block holding the reservation
+ *
+ * \return			Zero on success; Appropriated negative value
+ *				on error
+ */
+int vea_free_frag(struct vea_space_info *vsi, uint64_t blk_off);
+
+/**
+ * Check if packed reservations are supported, they aren't on the space
+ * formatted without VEA_COMPAT_FEATURE_FRAG.
+ *
+ * \param vsi     [IN]		In-memory compound index
+ *
+ * \return			True if vea_reserve_frag() can be used
+ */
+bool vea_frag_supported(struct vea_space_info *vsi);
+
 /**
  * Set an arbitrary age to a free extent with specified start offset.
  *
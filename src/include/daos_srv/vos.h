@@ -194,6 +194,34 @@ vos_cont_close(daos_handle_t coh);
 int
 vos_cont_query(daos_handle_t coh, vos_cont_info_t *cinfo);
 
+/**
+ * Return the most frequently updated objects of a container since the last
+ * call, the hottest object is the first one. They are the best candidates
+ * of aggregation.
+ *
+ * \param coh	[IN]	Container open handle.
+ * \param oids	[OUT]	Returned object IDs.
+ * \param nr	[IN]	Size of \a oids.
+ *
+ * \return		Number of returned objects, negative value if error
+ */
+int
+vos_cont_hot_objs(daos_handle_t coh, daos_unit_oid_t *oids, int nr);
+
+/**
+ * Return the objects whose evtree has been found deep or overlapped by
+ * updates since the last call, they should be aggregated without waiting
+ * for the hot objects.
+ *
+ * \param coh	[IN]	Container open handle.
+ * \param oids	[OUT]	Returned object IDs.
+ * \param nr	[IN]	Size of \a oids.
+ *
+ * \return		Number of returned objects, negative value if error
+ */
+int
+vos_cont_agg_objs(daos_handle_t coh, daos_unit_oid_t *oids, int nr);
+
 /**
  * Flush changes in the specified epoch to storage
  *
@@ -210,6 +238,8 @@ vos_epoch_flush(daos_handle_t coh, daos_epoch_t epoch);
  * Data in all these epochs will be aggregated to the last epoch
  * \a epr::epr_hi, aggregated epochs will be discarded except the last one,
  * which is kept as aggregation result.
+ * The aggregated epochs can't be fetched anymore, the data visible within
+ * the range may be the one from before \a epr::epr_lo.
  *
  * \param coh	  [IN]		Container open handle
  * \param oid	  [IN]		Object handle for aggregation
@@ -227,6 +257,27 @@ vos_epoch_aggregate(daos_handle_t coh, daos_unit_oid_t oid,
 		    daos_epoch_range_t *epr, unsigned int *credits,
 		    vos_purge_anchor_t *anchor, bool *finished);
 
+/**
+ * Migrate the array extents of an object between SCM and NVMe by the media
+ * policy of the pool: extents of a cold object are moved to NVMe when SCM
+ * is above the high watermark, small extents of a hot object are moved back
+ * to SCM while it is below. An object is hot if it's frequently fetched.
+ *
+ * Each moved extent consumes one credit, the caller should yield and call
+ * it again if all the credits are consumed.
+ *
+ * \param coh	  [IN]		Container open handle
+ * \param oid	  [IN]		Object to migrate
+ * \param credits [IN/OUT]	max number of extents to move, returned
+ *				the unused credits
+ * \param stats	  [IN/OUT]	migration statistics to be accumulated
+ *
+ * \return			Zero on success, negative value if error
+ */
+int
+vos_obj_tier(daos_handle_t coh, daos_unit_oid_t oid, unsigned int *credits,
+	     vos_tier_stats_t *stats);
+
 /**
  * Discards changes in all epochs with the epoch range \a epr
  * and \a cookie id.
@@ -249,7 +300,12 @@ vos_epoch_aggregate(daos_handle_t coh, daos_unit_oid_t oid,
  * \param cookie	[IN]	Cookie ID to identify records,
  *				keys to discard
  *
- * \return			Zero on success, negative value if error
+ * \return			Zero on success
+ *				-DER_BUSY if some objects were skipped
+ *				because they are leased by in-flight
+ *				fetches, the caller should yield and
+ *				discard again
+ *				Negative value if other error
  */
 int
 vos_epoch_discard(daos_handle_t coh, daos_epoch_range_t *epr,
@@ -36,7 +36,8 @@ enum vos_oi_attr {
 };
 
 /**
- * pool attributes returned to query
+ * pool attributes returned to query, the space usage isn't stored in the
+ * pool, it's collected on query.
  */
 typedef struct {
 	/** # of containers in this pool */
@@ -47,9 +48,25 @@ typedef struct {
 	daos_size_t		pif_blob_sz;
 	/** Current available space */
 	daos_size_t		pif_avail;
+	/** Space used on SCM, 0 if it can't be queried from PMDK */
+	daos_size_t		pif_scm_used;
+	/** Space used on NVMe */
+	daos_size_t		pif_nvme_used;
 	/** TODO */
 } vos_pool_info_t;
 
+/**
+ * Statistics of the media migration, see vos_obj_tier()
+ */
+typedef struct {
+	/** extents moved from SCM to NVMe */
+	uint64_t		ts_demoted;
+	/** extents moved from NVMe to SCM */
+	uint64_t		ts_promoted;
+	/** bytes moved */
+	daos_size_t		ts_bytes;
+} vos_tier_stats_t;
+
 /**
  * container attributes returned to query
  */
@@ -125,6 +142,12 @@ typedef struct {
 	daos_anchor_t		pa_recx_max;
 	/** Save OID for aggregation optimization */
 	daos_unit_oid_t		pa_oid;
+	/** Number of records removed by aggregation with this anchor */
+	uint64_t		pa_nr_removed;
+	/** Size of records removed by aggregation with this anchor */
+	daos_size_t		pa_size_removed;
+	/** Number of extents merged by aggregation with this anchor */
+	uint64_t		pa_nr_merged;
 } vos_purge_anchor_t;
 
 enum {
@@ -211,6 +211,8 @@ struct daos_rebuild_status {
 	uint64_t		rs_obj_nr;
 	/** # rebuilt records, it's non-zero only if rs_done is 1 */
 	uint64_t		rs_rec_nr;
+	/** # rebuilt bytes, it's non-zero only if rs_done is 1 */
+	uint64_t		rs_size;
 };
 
 /**
@@ -313,6 +315,15 @@ typedef struct {
 	uint32_t		ci_nsnapshots;
 	/** Epochs of returns snapshots */
 	daos_epoch_t	       *ci_snapshots;
+	/**
+	 * Statistics of the background aggregation on all targets since they
+	 * were started: aggregated objects, removed records, reclaimed bytes
+	 * and extents merged into larger ones.
+	 */
+	uint64_t		ci_agg_objs;
+	uint64_t		ci_agg_recs;
+	uint64_t		ci_agg_bytes;
+	uint64_t		ci_agg_merged;
 	/* TODO: add more members, e.g., size, # objects, uid, gid... */
 } daos_cont_info_t;
 
@@ -616,7 +627,8 @@ typedef struct {
 	daos_recx_t		*iod_recxs;
 	/*
 	 * Checksum associated with each extent. If the type of the iod is
-	 * single, will only have a single checksum.
+	 * single, will only have a single checksum. The checksum of an extent
+	 * is the per-chunk checksums of its data, see DAOS_CSUM_CHUNK_SIZE.
 	 */
 	daos_csum_buf_t		*iod_csums;
 	/** Epoch range associated with each extent */
@@ -96,7 +96,7 @@ register_dbtree_classes(void)
 	}
 
 	rc = dbtree_class_register(DBTREE_CLASS_IV,
-				   BTR_FEAT_UINT_KEY /* feats */,
+				   BTR_FEAT_UINT_KEY | BTR_FEAT_KEY_ARRAY,
 				   &dbtree_iv_ops);
 	if (rc != 0) {
 		D_ERROR("failed to register DBTREE_CLASS_IV: %d\n", rc);
@@ -32,6 +32,7 @@
 #include <abt.h>
 #include <daos/common.h>
 #include <daos/event.h>
+#include <daos/slab.h>
 #include <daos_errno.h>
 #include <daos_srv/bio.h>
 #include <daos_srv/smd.h>
@@ -39,10 +40,20 @@
 #include "srv_internal.h"
 
 #define REBUILD_DEFAULT_SCHEDULE_RATIO 30
+#define AGGREGATE_DEFAULT_SCHEDULE_RATIO 10
 
 /** Number of started xstreams or cores used */
 unsigned int	dss_nxstreams;
 unsigned int	dss_rebuild_res_percentage = REBUILD_DEFAULT_SCHEDULE_RATIO;
+unsigned int	dss_agg_res_percentage = AGGREGATE_DEFAULT_SCHEDULE_RATIO;
+unsigned int	dss_zc_threshold;
+/** Idle xstreams steal ULTs from the steal pools of the others if set */
+static bool	dss_sched_steal;
+/** Steal pool of each xstream, indexed by the xstream rank - 1 */
+static ABT_pool	*dss_steal_pools;
+/** Helper xstream for the ULTs blocked by system calls, and its pool */
+static ABT_xstream	dss_helper_xs = ABT_XSTREAM_NULL;
+static ABT_pool		dss_helper_pool = ABT_POOL_NULL;
 
 /** Per-xstream configuration data */
 struct dss_xstream {
@@ -52,6 +63,8 @@ struct dss_xstream {
 	ABT_xstream	dx_xstream;
 	ABT_pool	dx_pools[DSS_POOL_CNT];
 	ABT_sched	dx_sched;
+	/** scheduler state and statistics, owned by dx_sched */
+	struct sched_data *dx_sched_data;
 	ABT_thread	dx_progress;
 	unsigned int	dx_idx;
 };
@@ -72,8 +85,53 @@ struct dss_xstream_data {
 
 static struct dss_xstream_data	xstream_data;
 
+/** base weight of the I/O, metadata and stealable ULTs */
+#define DSS_SCHED_IO_WEIGHT	50
+#define DSS_SCHED_META_WEIGHT	20
+#define DSS_SCHED_STEAL_WEIGHT	20
+/** upper bound of the weight multiplier raised by the latency targets */
+#define DSS_SCHED_BOOST_MAX	16
+/** interval to evaluate the latency targets, in microseconds */
+#define DSS_SCHED_WINDOW_US	100000
+/** queueing delay histogram buckets, bucket N counts delays < 2^N us */
+#define DSS_SCHED_HIST_NR	32
+
+/** p99 queueing delay target of each pool in microseconds, 0 if none */
+static uint64_t	dss_sched_targets[DSS_POOL_CNT];
+
+static const char *dss_sched_names[DSS_POOL_CNT] = {
+	[DSS_POOL_PRIV]		= "io",
+	[DSS_POOL_SHARE]	= "meta",
+	[DSS_POOL_REBUILD]	= "rebuild",
+	[DSS_POOL_AGGREGATE]	= "aggregate",
+	[DSS_POOL_STEAL]	= "steal",
+};
+
+/**
+ * Scheduling state of a class of ULTs, each pool of the xstream is a class.
+ */
+struct dss_sched_class {
+	/** current credit of the smooth weighted round-robin */
+	int		sc_current;
+	/** weight multiplier, adjusted to meet the latency target */
+	unsigned int	sc_boost;
+	/** number of ULTs scheduled from this class */
+	uint64_t	sc_runs;
+	/** p99 queueing delay of the last window */
+	uint64_t	sc_p99_us;
+	/** number of delay samples in the current window */
+	uint64_t	sc_samples;
+	/** queueing delay histogram of the current window */
+	uint32_t	sc_hist[DSS_SCHED_HIST_NR];
+};
+
 struct sched_data {
-    uint32_t event_freq;
+	uint32_t		event_freq;
+	/** start time of the current statistics window */
+	uint64_t		sd_window_start;
+	/** number of ULTs stolen from the other xstreams */
+	uint64_t		sd_steals;
+	struct dss_sched_class	sd_classes[DSS_POOL_CNT];
 };
 
 static int
@@ -81,6 +139,7 @@ dss_sched_init(ABT_sched sched, ABT_sched_config config)
 {
 	struct sched_data	*p_data;
 	int			 ret;
+	int			 i;
 
 	D_ALLOC_PTR(p_data);
 	if (p_data == NULL)
@@ -91,41 +150,151 @@ dss_sched_init(ABT_sched sched, ABT_sched_config config)
 	if (ret != ABT_SUCCESS)
 		return ret;
 
+	for (i = 0; i < DSS_POOL_CNT; i++)
+		p_data->sd_classes[i].sc_boost = 1;
+	p_data->sd_window_start = d_timeus_secdiff(0);
+
 	ret = ABT_sched_set_data(sched, (void *)p_data);
 
 	return ret;
 }
 
-static ABT_unit
-normal_unit_pop(ABT_pool *pools, ABT_pool *pool)
+/**
+ * Base weight of each class. The rebuild and the aggregation weights are the
+ * percentages set by dss_parameters_set(), so setting them to zero still
+ * stops the rebuild or the aggregation from being scheduled.
+ */
+static unsigned int
+dss_sched_weight(int idx)
 {
-	ABT_unit unit;
-
-	/* Let's pop I/O request ULT first */
-	ABT_pool_pop(pools[DSS_POOL_PRIV], &unit);
-	if (unit != ABT_UNIT_NULL) {
-		*pool = pools[DSS_POOL_PRIV];
-		return unit;
+	switch (idx) {
+	case DSS_POOL_PRIV:
+		return DSS_SCHED_IO_WEIGHT;
+	case DSS_POOL_SHARE:
+		return DSS_SCHED_META_WEIGHT;
+	case DSS_POOL_REBUILD:
+		return dss_rebuild_res_percentage;
+	case DSS_POOL_AGGREGATE:
+		return dss_agg_res_percentage;
+	case DSS_POOL_STEAL:
+		return DSS_SCHED_STEAL_WEIGHT;
+	default:
+		D_ASSERTF(0, "invalid pool %d\n", idx);
+		return 0;
 	}
+}
 
-	/* Other request and ollective ULT or created ULT */
-	ABT_pool_pop(pools[DSS_POOL_SHARE], &unit);
-	if (unit != ABT_UNIT_NULL) {
-		*pool = pools[DSS_POOL_SHARE];
-		return unit;
+/** Account the queueing delay of a ULT of class \a idx */
+static void
+dss_sched_delay_add(struct sched_data *sd, int idx, uint64_t delay_us)
+{
+	struct dss_sched_class	*cls = &sd->sd_classes[idx];
+	int			 bucket = 0;
+
+	while (bucket < DSS_SCHED_HIST_NR - 1 && (1ULL << bucket) <= delay_us)
+		bucket++;
+
+	cls->sc_hist[bucket]++;
+	cls->sc_samples++;
+}
+
+static uint64_t
+dss_sched_class_p99(struct dss_sched_class *cls)
+{
+	uint64_t	threshold;
+	uint64_t	sum = 0;
+	int		i;
+
+	if (cls->sc_samples == 0)
+		return 0;
+
+	threshold = (cls->sc_samples * 99 + 99) / 100;
+	for (i = 0; i < DSS_SCHED_HIST_NR; i++) {
+		sum += cls->sc_hist[i];
+		if (sum >= threshold)
+			break;
 	}
+	return 1ULL << min(i, DSS_SCHED_HIST_NR - 1);
+}
 
-	return ABT_UNIT_NULL;
+/**
+ * Close the statistics window: compute the p99 queueing delay of each class
+ * and adjust its weight multiplier, double it if the target is missed and
+ * halve it if the delay is well below the target.
+ */
+static void
+dss_sched_adjust(struct sched_data *sd, uint64_t now)
+{
+	struct dss_sched_class	*cls;
+	uint64_t		 target;
+	int			 i;
+
+	for (i = 0; i < DSS_POOL_CNT; i++) {
+		cls = &sd->sd_classes[i];
+		target = dss_sched_targets[i];
+
+		cls->sc_p99_us = dss_sched_class_p99(cls);
+		if (target == 0)
+			cls->sc_boost = 1;
+		else if (cls->sc_samples != 0 && cls->sc_p99_us > target)
+			cls->sc_boost = min(cls->sc_boost * 2,
+					    DSS_SCHED_BOOST_MAX);
+		else if (cls->sc_p99_us < target / 2 && cls->sc_boost > 1)
+			cls->sc_boost /= 2;
+
+		memset(cls->sc_hist, 0, sizeof(cls->sc_hist));
+		cls->sc_samples = 0;
+	}
+	sd->sd_window_start = now;
 }
 
+/**
+ * Steal a ULT from the steal pool of another xstream, starting from a random
+ * victim. The stolen ULT is migrated to the share pool of this xstream, so
+ * it is pinned to this xstream once it starts.
+ *
+ * The migration is carried out by ABT_xstream_run_unit() on the returned
+ * unit: it pushes the ULT to the share pool instead of running it, then the
+ * ULT is scheduled from there like any other ULT of this xstream.
+ */
 static ABT_unit
-rebuild_unit_pop(ABT_pool *pools, ABT_pool *pool)
+dss_sched_steal_pop(struct sched_data *sd, ABT_pool *pools, ABT_pool *pool)
 {
-	ABT_unit unit;
+	ABT_thread	thread;
+	ABT_unit	unit;
+	unsigned int	nr = dss_nxstreams;
+	unsigned int	start;
+	unsigned int	i;
+
+	if (dss_steal_pools == NULL || nr == 0)
+		return ABT_UNIT_NULL;
 
-	ABT_pool_pop(pools[DSS_POOL_REBUILD], &unit);
-	if (unit != ABT_UNIT_NULL) {
-		*pool = pools[DSS_POOL_REBUILD];
+	start = rand() % nr;
+	for (i = 0; i < nr; i++) {
+		ABT_pool	victim = dss_steal_pools[(start + i) % nr];
+		size_t		cnt;
+		int		rc;
+
+		if (victim == ABT_POOL_NULL || victim == pools[DSS_POOL_STEAL])
+			continue;
+
+		rc = ABT_pool_get_size(victim, &cnt);
+		if (rc != ABT_SUCCESS || cnt == 0)
+			continue;
+
+		ABT_pool_pop(victim, &unit);
+		if (unit == ABT_UNIT_NULL)
+			continue;
+
+		ABT_unit_get_thread(unit, &thread);
+		rc = ABT_thread_migrate_to_pool(thread, pools[DSS_POOL_SHARE]);
+		if (rc != ABT_SUCCESS) {
+			/* not migratable, leave it to the victim */
+			ABT_pool_push(victim, unit);
+			continue;
+		}
+		sd->sd_steals++;
+		*pool = victim;
 		return unit;
 	}
 
@@ -133,29 +302,75 @@ rebuild_unit_pop(ABT_pool *pools, ABT_pool *pool)
 }
 
 /**
- * Choose ULT from the pool. Note: the rebuild ULT will be
- * be choosen by dss_rebuild_res_percentage.
+ * Choose ULT from the pools by smooth weighted round-robin, so each class
+ * gets the share of its weight (dss_sched_weight() by the multiplier from
+ * the latency target) among the classes which have runnable ULTs. The
+ * aggregation ULT is still chosen if no other pool has runnable ULTs, not
+ * even a pool of zero weight.
  *
- * XXX we may change the sequence later once we have more cases.
+ * If work stealing is enabled and the only runnable ULT is the progress ULT,
+ * try to steal a ULT from the other xstreams first.
  */
 static ABT_unit
-dss_sched_unit_pop(ABT_pool *pools, ABT_pool *pool)
+dss_sched_unit_pop(struct sched_data *sd, ABT_pool *pools, ABT_pool *pool)
 {
-	size_t	 rebuild_cnt;
-	int	 rc;
+	struct dss_sched_class	*cls;
+	ABT_unit		 unit;
+	unsigned int		 weight;
+	size_t			 runnable = 0;
+	int			 total = 0;
+	int			 best = -1;
+	int			 i;
 
-	rc = ABT_pool_get_total_size(pools[DSS_POOL_REBUILD],
-				     &rebuild_cnt);
-	if (rc != ABT_SUCCESS)
-		return ABT_UNIT_NULL;
+	for (i = 0; i < DSS_POOL_CNT; i++) {
+		size_t	cnt;
+		int	rc;
 
-	if (rebuild_cnt == 0 ||
-	    rand() % 100 >= dss_rebuild_res_percentage)
-		return normal_unit_pop(pools, pool);
-	else
-		return rebuild_unit_pop(pools, pool);
+		cls = &sd->sd_classes[i];
+		weight = dss_sched_weight(i) * cls->sc_boost;
+		rc = ABT_pool_get_size(pools[i], &cnt);
+		if (rc == ABT_SUCCESS)
+			runnable += cnt;
+		if (rc != ABT_SUCCESS || cnt == 0 || weight == 0) {
+			cls->sc_current = 0;
+			continue;
+		}
 
-	return ABT_UNIT_NULL;
+		cls->sc_current += weight;
+		total += weight;
+		if (best < 0 ||
+		    cls->sc_current > sd->sd_classes[best].sc_current)
+			best = i;
+	}
+
+	if (dss_sched_steal && runnable <= 1) {
+		unit = dss_sched_steal_pop(sd, pools, pool);
+		if (unit != ABT_UNIT_NULL)
+			return unit;
+	}
+
+	if (best >= 0) {
+		sd->sd_classes[best].sc_current -= total;
+	} else {
+		size_t	cnt = 0;
+
+		/* Run the background aggregation only if xstream is idle, the
+		 * ULTs of a class with zero weight (e.g. rebuild paused by
+		 * dss_rebuild_res_percentage) still count.
+		 */
+		ABT_pool_get_size(pools[DSS_POOL_AGGREGATE], &cnt);
+		if (runnable > cnt)
+			return ABT_UNIT_NULL;
+		best = DSS_POOL_AGGREGATE;
+	}
+
+	ABT_pool_pop(pools[best], &unit);
+	if (unit == ABT_UNIT_NULL)
+		return ABT_UNIT_NULL;
+
+	sd->sd_classes[best].sc_runs++;
+	*pool = pools[best];
+	return unit;
 }
 
 static void
@@ -178,11 +393,16 @@ dss_sched_run(ABT_sched sched)
 
 	while (1) {
 		/* Execute one work unit from the scheduler's pool */
-		unit = dss_sched_unit_pop(pools, &pool);
+		unit = dss_sched_unit_pop(p_data, pools, &pool);
 		if (unit != ABT_UNIT_NULL && pool != ABT_UNIT_NULL)
 			ABT_xstream_run_unit(unit, pool);
 		if (++work_count >= p_data->event_freq) {
 			ABT_bool stop;
+			uint64_t now = d_timeus_secdiff(0);
+
+			if (now - p_data->sd_window_start >=
+			    DSS_SCHED_WINDOW_US)
+				dss_sched_adjust(p_data, now);
 
 			ABT_sched_has_to_stop(sched, &stop);
 			if (stop == ABT_TRUE) {
@@ -260,6 +480,31 @@ dss_abt_pool_choose_cb_register(unsigned int mod_id,
 	abt_pool_choose_cbs[mod_id] = cb;
 }
 
+/** Argument of the RPC handler ULT, to measure its queueing delay */
+struct dss_rpc_ult {
+	void		(*ru_hdlr)(void *);
+	crt_rpc_t	*ru_rpc;
+	/** time when the ULT is queued */
+	uint64_t	 ru_queued;
+	/** pool index of the ULT */
+	int		 ru_pool;
+};
+
+static void
+dss_rpc_ult(void *arg)
+{
+	struct dss_rpc_ult	*ru = arg;
+	struct dss_xstream	*dx = dss_get_module_info()->dmi_xstream;
+	void			(*hdlr)(void *) = ru->ru_hdlr;
+	crt_rpc_t		*rpc = ru->ru_rpc;
+
+	dss_sched_delay_add(dx->dx_sched_data, ru->ru_pool,
+			    d_timeus_secdiff(0) - ru->ru_queued);
+	daos_slab_free(DAOS_SLAB_DSS_RPC, ru);
+
+	hdlr(rpc);
+}
+
 /**
  * Process the rpc received, let's create a ABT thread for each request.
  */
@@ -267,20 +512,36 @@ int
 dss_process_rpc(crt_context_t *ctx, crt_rpc_t *rpc,
 		void (*real_rpc_hdlr)(void *), void *arg)
 {
-	unsigned int	mod_id = opc_get_mod_id(rpc->cr_opc);
-	ABT_pool	*pools = arg;
-	ABT_pool	pool;
-	int		rc;
+	unsigned int		 mod_id = opc_get_mod_id(rpc->cr_opc);
+	ABT_pool		*pools = arg;
+	ABT_pool		 pool;
+	struct dss_rpc_ult	*ru;
+	int			 rc;
 
 	if (abt_pool_choose_cbs[mod_id] != NULL)
 		pool = abt_pool_choose_cbs[mod_id](rpc, pools);
 	else
 		pool = pools[DSS_POOL_SHARE];
 
-	rc = ABT_thread_create(pool, real_rpc_hdlr, rpc,
+	ru = daos_slab_alloc(DAOS_SLAB_DSS_RPC, sizeof(*ru));
+	if (ru == NULL)
+		return -DER_NOMEM;
+
+	ru->ru_hdlr = real_rpc_hdlr;
+	ru->ru_rpc = rpc;
+	ru->ru_queued = d_timeus_secdiff(0);
+	for (ru->ru_pool = 0; ru->ru_pool < DSS_POOL_CNT; ru->ru_pool++) {
+		if (pools[ru->ru_pool] == pool)
+			break;
+	}
+	D_ASSERT(ru->ru_pool < DSS_POOL_CNT);
+
+	rc = ABT_thread_create(pool, dss_rpc_ult, ru,
 			       ABT_THREAD_ATTR_NULL, NULL);
-	if (rc != ABT_SUCCESS)
+	if (rc != ABT_SUCCESS) {
+		daos_slab_free(DAOS_SLAB_DSS_RPC, ru);
 		rc = dss_abterr2der(rc);
+	}
 	return rc;
 }
 
@@ -508,8 +769,13 @@ dss_start_one_xstream(hwloc_cpuset_t cpus, int idx)
 	for (i = 0; i < DSS_POOL_CNT; i++) {
 		ABT_pool_access access;
 
-		access = (i == DSS_POOL_SHARE || i == DSS_POOL_REBUILD) ?
-			 ABT_POOL_ACCESS_MPSC : ABT_POOL_ACCESS_PRIV;
+		if (i == DSS_POOL_STEAL)
+			access = ABT_POOL_ACCESS_MPMC;
+		else if (i == DSS_POOL_SHARE || i == DSS_POOL_REBUILD ||
+			 i == DSS_POOL_AGGREGATE)
+			access = ABT_POOL_ACCESS_MPSC;
+		else
+			access = ABT_POOL_ACCESS_PRIV;
 
 		rc = ABT_pool_create_basic(ABT_POOL_FIFO, access, ABT_TRUE,
 					   &dx->dx_pools[i]);
@@ -522,6 +788,8 @@ dss_start_one_xstream(hwloc_cpuset_t cpus, int idx)
 		D_ERROR("create scheduler fails: %d\n", rc);
 		D_GOTO(out_pool, rc);
 	}
+	ABT_sched_get_data(dx->dx_sched, (void **)&dx->dx_sched_data);
+	dss_steal_pools[idx - 1] = dx->dx_pools[DSS_POOL_STEAL];
 
 	/** start execution stream, rank must be non-null */
 	rc = ABT_xstream_create_with_rank(dx->dx_sched, idx, &dx->dx_xstream);
@@ -555,11 +823,13 @@ dss_start_one_xstream(hwloc_cpuset_t cpus, int idx)
 
 	return 0;
 out_xstream:
+	dss_steal_pools[idx - 1] = ABT_POOL_NULL;
 	ABT_xstream_join(dx->dx_xstream);
 	ABT_xstream_free(&dx->dx_xstream);
 	dss_xstream_free(dx);
 	return rc;
 out_sched:
+	dss_steal_pools[idx - 1] = ABT_POOL_NULL;
 	ABT_sched_free(&dx->dx_sched);
 out_pool:
 	for (i = 0; i < DSS_POOL_CNT; i++) {
@@ -579,6 +849,9 @@ dss_xstreams_fini(bool force)
 
 	D_DEBUG(DB_TRACE, "Stopping execution streams\n");
 
+	/* xstreams can't steal ULTs once they start to finalize TLS */
+	dss_sched_steal = false;
+
 	/** Stop & free progress ULTs */
 	d_list_for_each_entry(dx, &xstream_data.xd_list, dx_list)
 		ABT_future_set(dx->dx_shutdown, dx);
@@ -603,6 +876,7 @@ dss_xstreams_fini(bool force)
 
 	/* All other xstreams have terminated. */
 	dss_nxstreams = 0;
+	D_FREE(dss_steal_pools);
 
 	/* release local storage */
 	rc = pthread_key_delete(dss_tls_key);
@@ -612,6 +886,41 @@ dss_xstreams_fini(bool force)
 	D_DEBUG(DB_TRACE, "Execution streams stopped\n");
 }
 
+/**
+ * Start the helper xstream, it is not bound to any target and only runs the
+ * ULTs of dss_helper_execute(). It has to be started after the server
+ * xstreams, which take the ABT ranks from 1.
+ */
+static int
+dss_helper_xstream_init(void)
+{
+	int	rc;
+
+	rc = ABT_pool_create_basic(ABT_POOL_FIFO, ABT_POOL_ACCESS_MPSC,
+				   ABT_TRUE, &dss_helper_pool);
+	if (rc != ABT_SUCCESS)
+		return dss_abterr2der(rc);
+
+	rc = ABT_xstream_create_basic(ABT_SCHED_BASIC, 1, &dss_helper_pool,
+				      ABT_SCHED_CONFIG_NULL, &dss_helper_xs);
+	if (rc != ABT_SUCCESS) {
+		D_ERROR("create helper xstream fails %d\n", rc);
+		ABT_pool_free(&dss_helper_pool);
+		return dss_abterr2der(rc);
+	}
+
+	return 0;
+}
+
+static void
+dss_helper_xstream_fini(void)
+{
+	/* the basic scheduler exits once its pool is drained */
+	ABT_xstream_join(dss_helper_xs);
+	ABT_xstream_free(&dss_helper_xs);
+	dss_helper_pool = ABT_POOL_NULL;
+}
+
 static void
 dss_xstreams_open_barrier(void)
 {
@@ -644,10 +953,15 @@ dss_xstreams_init(int nr)
 	/** default: one xstream per core (ncores) */
 	dss_nxstreams = (nr > 0 && nr <= ncores) ? nr : ncores;
 
+	D_ALLOC_ARRAY(dss_steal_pools, dss_nxstreams);
+	if (dss_steal_pools == NULL)
+		return -DER_NOMEM;
+
 	/* initialize xstream-local storage */
 	rc = pthread_key_create(&dss_tls_key, NULL);
 	if (rc) {
 		D_ERROR("failed to create dtc: %d\n", rc);
+		D_FREE(dss_steal_pools);
 		return -DER_NOMEM;
 	}
 
@@ -672,8 +986,10 @@ dss_xstreams_init(int nr)
 		dss_nxstreams);
 failed:
 	dss_xstreams_open_barrier();
-	if (dss_xstreams_empty()) /* started nothing */
+	if (dss_xstreams_empty()) { /* started nothing */
 		pthread_key_delete(dss_tls_key);
+		D_FREE(dss_steal_pools);
+	}
 
 	return rc;
 }
@@ -798,6 +1114,46 @@ dss_rebuild_ult_create(void (*func)(void *), void *arg, int stream_id,
 				   DSS_POOL_REBUILD);
 }
 
+/* Create the ULT in the background aggregation pool */
+int
+dss_aggregate_ult_create(void (*func)(void *), void *arg, int stream_id,
+			 size_t stack_size, ABT_thread *ult)
+{
+	return dss_ult_pool_create(func, arg, stream_id, stack_size, ult,
+				   DSS_POOL_AGGREGATE);
+}
+
+/**
+ * Create the ULT in the steal pool, it may run on another xstream than
+ * \a stream_id if work stealing is enabled, so \a func must not access
+ * the VOS target or the TLS of \a stream_id.
+ */
+int
+dss_steal_ult_create(void (*func)(void *), void *arg, int stream_id,
+		     size_t stack_size, ABT_thread *ult)
+{
+	return dss_ult_pool_create(func, arg, stream_id, stack_size, ult,
+				   DSS_POOL_STEAL);
+}
+
+/**
+ * Check if the current xstream has pending I/O requests, background tasks
+ * can use it to throttle themselves.
+ */
+bool
+dss_xstream_is_busy(void)
+{
+	struct dss_xstream	*dx = dss_get_module_info()->dmi_xstream;
+	size_t			 cnt = 0;
+	int			 rc;
+
+	rc = ABT_pool_get_size(dx->dx_pools[DSS_POOL_PRIV], &cnt);
+	if (rc != ABT_SUCCESS)
+		return false;
+
+	return cnt != 0;
+}
+
 /**
  * Create an ULT on each server xtream to execute a \a func(\a arg)
  *
@@ -879,12 +1235,13 @@ dss_ult_create_execute_cb(void *data)
  * \param[in]	user_cb	user call back (mandatory for async mode)
  * \param[in]	arg	argument for \a user callback
  * \param[in]	stream_id indicate which xtream the ULT is executed.
+ * \param[in]	pool	ULT pool type indicates where the ULT is created.
  * \param[out]		error code.
  *
  */
-int
-dss_ult_create_execute(int (*func)(void *), void *arg, void (*user_cb)(void *),
-		       void *cb_args, int stream_id, size_t stack_size)
+static int
+dss_ult_pool_execute(int (*func)(void *), void *arg, void (*user_cb)(void *),
+		     void *cb_args, int stream_id, size_t stack_size, int pool)
 {
 	struct dss_future_arg	future_arg;
 	ABT_future		future;
@@ -907,8 +1264,8 @@ dss_ult_create_execute(int (*func)(void *), void *arg, void (*user_cb)(void *),
 		future_arg.dfa_async	= true;
 	}
 
-	rc = dss_ult_create(dss_ult_create_execute_cb, &future_arg, stream_id,
-			    stack_size, NULL);
+	rc = dss_ult_pool_create(dss_ult_create_execute_cb, &future_arg,
+				 stream_id, stack_size, NULL, pool);
 	if (rc)
 		D_GOTO(free, rc);
 
@@ -924,6 +1281,52 @@ free:
 	return rc;
 }
 
+int
+dss_ult_create_execute(int (*func)(void *), void *arg, void (*user_cb)(void *),
+		       void *cb_args, int stream_id, size_t stack_size)
+{
+	return dss_ult_pool_execute(func, arg, user_cb, cb_args, stream_id,
+				    stack_size, DSS_POOL_SHARE);
+}
+
+/**
+ * Execute \a func(\a arg) on the helper xstream and wait until it has been
+ * executed, the calling xstream keeps running its other ULTs meanwhile. It is
+ * for blocking system calls (e.g. file I/O), \a func runs out of the server
+ * xstreams, so it must not access the xstream-local storage.
+ *
+ * \param[in]	func	function to execute
+ * \param[in]	arg	argument for \a func
+ *
+ * \return		the return value of \a func, or error code
+ */
+int
+dss_helper_execute(int (*func)(void *), void *arg)
+{
+	struct dss_future_arg	future_arg;
+	int			rc;
+
+	memset(&future_arg, 0, sizeof(future_arg));
+	future_arg.dfa_func = func;
+	future_arg.dfa_arg = arg;
+	future_arg.dfa_async = false;
+
+	rc = ABT_future_create(1, NULL, &future_arg.dfa_future);
+	if (rc != ABT_SUCCESS)
+		return dss_abterr2der(rc);
+
+	rc = ABT_thread_create(dss_helper_pool, dss_ult_create_execute_cb,
+			       &future_arg, ABT_THREAD_ATTR_NULL, NULL);
+	if (rc != ABT_SUCCESS)
+		D_GOTO(free, rc = dss_abterr2der(rc));
+
+	ABT_future_wait(future_arg.dfa_future);
+	rc = future_arg.dfa_status;
+free:
+	ABT_future_free(&future_arg.dfa_future);
+	return rc;
+}
+
 struct collective_arg {
 	struct dss_future_arg		ca_future;
 };
@@ -1169,8 +1572,8 @@ dss_acc_offload(struct dss_acc_task *at_args)
 
 
 	/**
-	 * Currently just launching it in this stream,
-	 * ideally will move to a separate exclusive xstream
+	 * Launch it in the steal pool of this stream, an idle xstream
+	 * may take it over if work stealing is enabled.
 	 */
 	tid = dss_get_module_info()->dmi_tid;
 	if (at_args == NULL) {
@@ -1186,11 +1589,11 @@ dss_acc_offload(struct dss_acc_task *at_args)
 
 	switch (at_args->at_offload_type) {
 	case DSS_OFFLOAD_ULT:
-		rc = dss_ult_create_execute(compute_checksum_ult,
-					    at_args->at_params,
-					    NULL /* user-cb */,
-					    NULL /* user-cb args */,
-					    tid, 0);
+		rc = dss_ult_pool_execute(compute_checksum_ult,
+					  at_args->at_params,
+					  NULL /* user-cb */,
+					  NULL /* user-cb args */,
+					  tid, 0, DSS_POOL_STEAL);
 		break;
 	case DSS_OFFLOAD_ACC:
 		/** calls to offload to FPGA*/
@@ -1380,6 +1783,68 @@ err:
 	return rc;
 }
 
+/**
+ * Query the scheduler statistics of an xstream, the counters are updated by
+ * the xstream without lock, so they are only approximate.
+ *
+ * \param[in] stream_id	xstream index
+ * \param[out] stats	statistics of each pool, DSS_POOL_CNT entries
+ * \param[out] steals	optional, number of ULTs stolen by the xstream
+ *
+ * \return		0 on success, -DER_NONEXIST if no such xstream
+ */
+int
+dss_sched_query(int stream_id, struct dss_sched_stat *stats, uint64_t *steals)
+{
+	struct dss_xstream	*dx;
+	struct dss_sched_class	*cls;
+	int			 i;
+
+	d_list_for_each_entry(dx, &xstream_data.xd_list, dx_list) {
+		if (dx->dx_idx != stream_id)
+			continue;
+
+		for (i = 0; i < DSS_POOL_CNT; i++) {
+			cls = &dx->dx_sched_data->sd_classes[i];
+			stats[i].ss_weight = dss_sched_weight(i);
+			stats[i].ss_boost = cls->sc_boost;
+			stats[i].ss_runs = cls->sc_runs;
+			stats[i].ss_p99_us = cls->sc_p99_us;
+			stats[i].ss_target_us = dss_sched_targets[i];
+		}
+		if (steals != NULL)
+			*steals = dx->dx_sched_data->sd_steals;
+		return 0;
+	}
+	return -DER_NONEXIST;
+}
+
+/** Print the scheduler statistics of all xstreams, see dss_sched_query() */
+static void
+dss_sched_stats_dump(void)
+{
+	struct dss_sched_stat	 stats[DSS_POOL_CNT];
+	struct dss_xstream	*dx;
+	uint64_t		 steals;
+	int			 i;
+
+	d_list_for_each_entry(dx, &xstream_data.xd_list, dx_list) {
+		if (dss_sched_query(dx->dx_idx, stats, &steals) != 0)
+			continue;
+
+		D_PRINT("xstream %u: stolen "DF_U64" ULTs\n", dx->dx_idx,
+			steals);
+		for (i = 0; i < DSS_POOL_CNT; i++) {
+			D_PRINT("xstream %u %s: weight %u, boost %u, runs "
+				DF_U64", p99 delay "DF_U64"us, target "
+				DF_U64"us\n", dx->dx_idx, dss_sched_names[i],
+				stats[i].ss_weight, stats[i].ss_boost,
+				stats[i].ss_runs, stats[i].ss_p99_us,
+				stats[i].ss_target_us);
+		}
+	}
+}
+
 /*
  * Set parameters on the server.
  *
@@ -1411,6 +1876,34 @@ dss_parameters_set(unsigned int key_id, uint64_t value)
 		D_WARN("set rebuild percentage to "DF_U64"\n", value);
 		dss_rebuild_res_percentage = value;
 		break;
+	case DSS_AGGREGATE_RES_PERCENTAGE:
+		if (value >= 100) {
+			D_ERROR("invalid value "DF_U64"\n", value);
+			rc = -DER_INVAL;
+			break;
+		}
+		D_WARN("set aggregation percentage to "DF_U64"\n", value);
+		dss_agg_res_percentage = value;
+		break;
+	case DSS_SCHED_IO_LATENCY_TARGET:
+		D_WARN("set I/O latency target to "DF_U64"us\n", value);
+		dss_sched_targets[DSS_POOL_PRIV] = value;
+		break;
+	case DSS_SCHED_META_LATENCY_TARGET:
+		D_WARN("set metadata latency target to "DF_U64"us\n", value);
+		dss_sched_targets[DSS_POOL_SHARE] = value;
+		break;
+	case DSS_SCHED_STATS_DUMP:
+		dss_sched_stats_dump();
+		break;
+	case DSS_SCHED_WORK_STEALING:
+		D_WARN("%s work stealing\n", value ? "enable" : "disable");
+		dss_sched_steal = (value != 0);
+		break;
+	case DSS_OBJ_ZC_THRESHOLD:
+		D_WARN("set zero-copy fetch threshold to "DF_U64"\n", value);
+		dss_zc_threshold = min(value, UINT32_MAX);
+		break;
 	default:
 		D_ERROR("invalid key_id %d\n", key_id);
 		rc = -DER_INVAL;
@@ -1437,6 +1930,7 @@ enum {
 	XD_INIT_REG_KEY,
 	XD_INIT_NVME,
 	XD_INIT_XSTREAMS,
+	XD_INIT_HELPER,
 };
 
 /**
@@ -1448,6 +1942,9 @@ dss_srv_fini(bool force)
 	switch (xstream_data.xd_init_step) {
 	default:
 		D_ASSERT(0);
+	case XD_INIT_HELPER:
+		dss_helper_xstream_fini();
+		/* fall through */
 	case XD_INIT_XSTREAMS:
 		dss_xstreams_fini(force);
 		/* fall through */
@@ -1519,6 +2016,11 @@ dss_srv_init(int nr)
 	if (rc != 0)
 		D_GOTO(failed, rc);
 
+	rc = dss_helper_xstream_init();
+	if (rc != 0)
+		D_GOTO(failed, rc);
+	xstream_data.xd_init_step = XD_INIT_HELPER;
+
 	return 0;
 failed:
 	dss_srv_fini(true);
@@ -27,6 +27,7 @@
 #define D_LOGFAC       DD_FAC(server)
 
 #include <pthread.h>
+#include <daos/slab.h>
 #include "srv_internal.h"
 
 /* The array remember all of registered module keys on one node. */
@@ -144,21 +145,31 @@ dss_tls_init(int tag)
 		return NULL;
 
 	dtls->dtls_tag = tag;
-	rc = dss_thread_local_storage_init(dtls);
+	rc = daos_slab_cache_create(DAOS_SLAB_CACHED_MAX, &dtls->dtls_slabs);
 	if (rc != 0) {
 		D_FREE(dtls);
 		return NULL;
 	}
+	/* bind it before module keys, which may allocate tree contexts */
+	daos_slab_cache_bind(dtls->dtls_slabs);
+
+	rc = dss_thread_local_storage_init(dtls);
+	if (rc != 0)
+		goto failed;
 
 	rc = pthread_setspecific(dss_tls_key, dtls);
 	if (rc) {
 		D_ERROR("failed to initialize tls: %d\n", rc);
 		dss_thread_local_storage_fini(dtls);
-		D_FREE(dtls);
-		return NULL;
+		goto failed;
 	}
 
 	return dtls;
+failed:
+	daos_slab_cache_bind(NULL);
+	daos_slab_cache_destroy(dtls->dtls_slabs);
+	D_FREE(dtls);
+	return NULL;
 }
 
 /* Free DTC for a particular thread. */
@@ -167,5 +178,7 @@ dss_tls_fini(struct dss_thread_local_storage *dtls)
 {
 	pthread_setspecific(dss_tls_key, NULL);
 	dss_thread_local_storage_fini(dtls);
+	daos_slab_cache_bind(NULL);
+	daos_slab_cache_destroy(dtls->dtls_slabs);
 	D_FREE(dtls);
 }
@@ -34,6 +34,7 @@
 
 bool	cli_bypass_rpc;
 bool	srv_io_dispatch = true;
+bool	cli_hedged_read;
 
 /**
  * Initialize object interface
@@ -56,10 +57,20 @@ dc_obj_init(void)
 	else
 		D_DEBUG(DB_IO, "Server IO dispatch disabled.\n");
 
+	d_getenv_bool("DAOS_IO_HEDGED_READ", &cli_hedged_read);
+	if (cli_hedged_read)
+		D_DEBUG(DB_IO, "Hedged read enabled.\n");
+
+	rc = obj_tgt_load_init();
+	if (rc != 0)
+		return rc;
+
 	rc = daos_rpc_register(&obj_proto_fmt, OBJ_PROTO_CLI_COUNT,
 				NULL, DAOS_OBJ_MODULE);
-	if (rc != 0)
+	if (rc != 0) {
 		D_ERROR("failed to register daos obj RPCs: %d\n", rc);
+		obj_tgt_load_fini();
+	}
 
 	return rc;
 }
@@ -71,4 +82,5 @@ void
 dc_obj_fini(void)
 {
 	daos_rpc_unregister(&obj_proto_fmt);
+	obj_tgt_load_fini();
 }
@@ -319,6 +319,45 @@ obj_dkey2grp(struct dc_object *obj, uint64_t hash, unsigned int map_ver)
 	return grp_idx;
 }
 
+/**
+ * Select the least loaded replica for a read, starting from \a start which
+ * is the first valid one, so ties are broken randomly. With hedged read,
+ * the stalled replicas are skipped if there is any other choice.
+ */
+static int
+obj_grp_replica_select(struct dc_object *obj, int idx_first, int start,
+		       int grp_size)
+{
+	struct dc_obj_shard	*shard;
+	uint64_t		 cost;
+	uint64_t		 best_cost = UINT64_MAX;
+	bool			 stalled;
+	bool			 best_stalled = true;
+	int			 best = start;
+	int			 idx = start;
+	int			 i;
+
+	for (i = 0; i < grp_size;
+	     i++, idx = idx_first + (idx + 1 - idx_first) % grp_size) {
+		shard = &obj->cob_shards[idx];
+		if (shard->do_rebuilding || shard->do_target_id == -1)
+			continue;
+
+		stalled = cli_hedged_read &&
+			  obj_tgt_load_stalled(shard->do_target_id);
+		if (stalled && !best_stalled)
+			continue;
+
+		cost = obj_tgt_load_cost(shard->do_target_id);
+		if (cost < best_cost || (best_stalled && !stalled)) {
+			best = idx;
+			best_cost = cost;
+			best_stalled = stalled;
+		}
+	}
+	return best;
+}
+
 /* Get a valid shard from an object group */
 static int
 obj_grp_valid_shard_get(struct dc_object *obj, int idx,
@@ -369,6 +408,9 @@ obj_grp_valid_shard_get(struct dc_object *obj, int idx,
 			break;
 	}
 
+	if (i < grp_size && op != DAOS_OBJ_RPC_UPDATE && grp_size > 1)
+		idx = obj_grp_replica_select(obj, idx_first, idx, grp_size);
+
 	D_RWLOCK_UNLOCK(&obj->cob_lock);
 
 	if (i == grp_size)
@@ -2064,10 +2106,13 @@ dc_obj_query_key(tse_task_t *api_task)
 		/** set data len to 0 before retrieving dkey. */
 		api_args->dkey->iov_len = 0;
 	} else {
-		rc = obj_dkeyhash2update_grp(obj, dkey_hash, map_ver,
-					     &shard_first, &shard_nr);
-		if (rc != 0)
+		/* the replicas are identical, ask the least loaded one */
+		rc = obj_dkeyhash2shard(obj, dkey_hash, map_ver,
+					DAOS_OBJ_RPC_QUERY_KEY);
+		if (rc < 0)
 			D_GOTO(out_task, rc);
+		shard_first = rc;
+		shard_nr = 1;
 	}
 
 	obj_auxi->map_ver_req = map_ver;
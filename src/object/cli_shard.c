@@ -25,6 +25,7 @@
  */
 #define D_LOGFAC	DD_FAC(object)
 
+#include <time.h>
 #include <daos/container.h>
 #include <daos/pool.h>
 #include <daos/pool_map.h>
@@ -56,6 +57,162 @@ obj_shard_addref(struct dc_obj_shard *shard)
 	D_SPIN_UNLOCK(&shard->do_obj->cob_spin);
 }
 
+/**
+ * Client-side load of the targets, it's indexed by the pool map target ID,
+ * so targets of different pools may share a slot, which only skews the
+ * replica selection.
+ */
+#define OBJ_TGT_LOAD_NR		1024
+/** weight of a new latency sample in the EWMA is 1/8 */
+#define OBJ_TGT_LOAD_SHIFT	3
+/** the latency of an idle target is halved every second */
+#define OBJ_TGT_LOAD_AGE_US	1000000
+/** buckets of the histogram are halved after this many samples */
+#define OBJ_TGT_LOAD_DECAY	1024
+
+struct obj_tgt_load {
+	/** EWMA of the RPC latency (us) */
+	uint64_t	tl_lat;
+	/** last time the target completed an RPC or became busy (us) */
+	uint64_t	tl_active;
+	/** RPCs in flight */
+	uint32_t	tl_inflight;
+	uint32_t	tl_samples;
+	/** log2 histogram of the RPC latency (us) */
+	uint32_t	tl_hist[32];
+};
+
+static struct obj_tgt_load	obj_tgt_loads[OBJ_TGT_LOAD_NR];
+static pthread_spinlock_t	obj_tgt_load_lock;
+
+int
+obj_tgt_load_init(void)
+{
+	return D_SPIN_INIT(&obj_tgt_load_lock, PTHREAD_PROCESS_PRIVATE);
+}
+
+void
+obj_tgt_load_fini(void)
+{
+	D_SPIN_DESTROY(&obj_tgt_load_lock);
+}
+
+uint64_t
+obj_tgt_load_now(void)
+{
+	struct timespec	ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
+}
+
+static struct obj_tgt_load *
+obj_tgt_load_get(uint32_t tgt_id)
+{
+	return &obj_tgt_loads[tgt_id % OBJ_TGT_LOAD_NR];
+}
+
+/** An RPC has been sent to the target */
+void
+obj_tgt_load_begin(uint32_t tgt_id)
+{
+	struct obj_tgt_load	*tl = obj_tgt_load_get(tgt_id);
+
+	D_SPIN_LOCK(&obj_tgt_load_lock);
+	if (tl->tl_inflight++ == 0)
+		tl->tl_active = obj_tgt_load_now();
+	D_SPIN_UNLOCK(&obj_tgt_load_lock);
+}
+
+/** An RPC sent to the target at \a start has completed */
+void
+obj_tgt_load_end(uint32_t tgt_id, uint64_t start)
+{
+	struct obj_tgt_load	*tl = obj_tgt_load_get(tgt_id);
+	uint64_t		 now = obj_tgt_load_now();
+	uint64_t		 lat = now - start;
+	int			 i;
+
+	D_SPIN_LOCK(&obj_tgt_load_lock);
+	D_ASSERT(tl->tl_inflight > 0);
+	tl->tl_inflight--;
+	tl->tl_active = now;
+	if (tl->tl_samples == 0)
+		tl->tl_lat = lat;
+	else
+		tl->tl_lat += ((int64_t)lat - (int64_t)tl->tl_lat) >>
+			      OBJ_TGT_LOAD_SHIFT;
+
+	tl->tl_hist[min(lat ? 64 - __builtin_clzll(lat) : 0, 31)]++;
+	if (++tl->tl_samples % OBJ_TGT_LOAD_DECAY == 0) {
+		for (i = 0; i < 32; i++)
+			tl->tl_hist[i] >>= 1;
+	}
+	D_SPIN_UNLOCK(&obj_tgt_load_lock);
+}
+
+/**
+ * Expected cost of sending one more RPC to the target, it's the latency
+ * EWMA scaled by the number of RPCs in flight. The latency of a target
+ * which has been idle for a while is aged, so a target which was slow
+ * once is tried again later. A target has never been used costs 0.
+ */
+uint64_t
+obj_tgt_load_cost(uint32_t tgt_id)
+{
+	struct obj_tgt_load	*tl = obj_tgt_load_get(tgt_id);
+	uint64_t		 age;
+	uint64_t		 cost;
+
+	D_SPIN_LOCK(&obj_tgt_load_lock);
+	cost = tl->tl_lat;
+	if (tl->tl_inflight == 0) {
+		age = (obj_tgt_load_now() - tl->tl_active) /
+		      OBJ_TGT_LOAD_AGE_US;
+		cost = age < 64 ? cost >> age : 0;
+	}
+	cost *= tl->tl_inflight + 1;
+	D_SPIN_UNLOCK(&obj_tgt_load_lock);
+
+	return cost;
+}
+
+/**
+ * The target is stalled if it has RPCs in flight but hasn't completed any
+ * of them for longer than its p95 latency.
+ */
+bool
+obj_tgt_load_stalled(uint32_t tgt_id)
+{
+	struct obj_tgt_load	*tl = obj_tgt_load_get(tgt_id);
+	uint32_t		 total = 0;
+	uint32_t		 sum = 0;
+	uint64_t		 p95 = 0;
+	bool			 stalled = false;
+	int			 i;
+
+	D_SPIN_LOCK(&obj_tgt_load_lock);
+	if (tl->tl_inflight == 0)
+		goto out;
+
+	for (i = 0; i < 32; i++)
+		total += tl->tl_hist[i];
+	if (total < 20) /* not enough samples for a p95 */
+		goto out;
+
+	for (i = 0; i < 32; i++) {
+		sum += tl->tl_hist[i];
+		if (sum * 100 >= total * 95) {
+			p95 = 1ULL << i;
+			break;
+		}
+	}
+	stalled = (obj_tgt_load_now() - tl->tl_active > p95);
+out:
+	D_SPIN_UNLOCK(&obj_tgt_load_lock);
+	return stalled;
+}
+
 int
 dc_obj_shard_open(struct dc_object *obj, daos_unit_oid_t oid,
 		  unsigned int mode, struct dc_obj_shard *shard)
@@ -115,6 +272,8 @@ struct obj_rw_args {
 	struct dc_obj_shard	*dobj;
 	unsigned int	*map_ver;
 	uint32_t	 rwaa_nr;
+	/** send time of the RPC, see obj_tgt_load_end() */
+	uint64_t	 rwaa_start;
 };
 
 static int
@@ -213,6 +372,7 @@ dc_rw_cb(tse_task_t *task, void *arg)
 		}
 	}
 out:
+	obj_tgt_load_end(rw_args->dobj->do_target_id, rw_args->rwaa_start);
 	obj_shard_rw_bulk_fini(rw_args->rpc);
 	crt_req_decref(rw_args->rpc);
 	obj_shard_decref(rw_args->dobj);
@@ -348,6 +508,7 @@ obj_shard_rw(struct dc_obj_shard *shard, enum obj_rpc_opc opc,
 	orw->orw_oid = shard->do_id;
 	uuid_copy(orw->orw_co_hdl, cont_hdl_uuid);
 	uuid_copy(orw->orw_co_uuid, cont_uuid);
+	uuid_copy(orw->orw_pool_uuid, pool->dp_pool);
 
 	orw->orw_epoch = epoch;
 	orw->orw_nr = nr;
@@ -428,11 +589,15 @@ obj_shard_rw(struct dc_obj_shard *shard, enum obj_rpc_opc opc,
 	if (DAOS_FAIL_CHECK(DAOS_SHARD_OBJ_RW_CRT_ERROR))
 		D_GOTO(out_args, rc = -DER_HG);
 
+	rw_args.rwaa_start = obj_tgt_load_now();
 	rc = tse_task_register_comp_cb(task, dc_rw_cb, &rw_args,
 				       sizeof(rw_args));
 	if (rc != 0)
 		D_GOTO(out_args, rc);
 
+	/* dc_rw_cb() is called from now on */
+	obj_tgt_load_begin(shard->do_target_id);
+
 	if (cli_bypass_rpc) {
 		rc = daos_rpc_complete(req, task);
 	} else {
@@ -494,6 +659,7 @@ dc_obj_shard_punch(struct dc_obj_shard *shard, uint32_t opc, daos_epoch_t epoch,
 	struct obj_punch_cb_args	 cb_args;
 	daos_unit_oid_t			 oid;
 	crt_endpoint_t			 tgt_ep;
+	uuid_t				 pool_uuid;
 	uint64_t			 dkey_hash;
 	int				 rc;
 
@@ -510,6 +676,7 @@ dc_obj_shard_punch(struct dc_obj_shard *shard, uint32_t opc, daos_epoch_t epoch,
 	if ((int)tgt_ep.ep_rank < 0)
 		D_GOTO(out, rc = (int)tgt_ep.ep_rank);
 
+	uuid_copy(pool_uuid, pool->dp_pool);
 	dc_pool_put(pool);
 
 	D_DEBUG(DB_IO, "opc=%d, rank=%d tag=%d epoch "DF_U64".\n",
@@ -547,6 +714,7 @@ dc_obj_shard_punch(struct dc_obj_shard *shard, uint32_t opc, daos_epoch_t epoch,
 	}
 	uuid_copy(opi->opi_co_hdl, coh_uuid);
 	uuid_copy(opi->opi_co_uuid, cont_uuid);
+	uuid_copy(opi->opi_pool_uuid, pool_uuid);
 
 	rc = daos_rpc_send(req, task);
 	if (rc != 0) {
@@ -598,6 +766,7 @@ struct obj_enum_args {
 	daos_epoch_range_t	*eaa_eprs;
 	daos_size_t		*eaa_size;
 	unsigned int		*eaa_map_ver;
+	uint64_t		 eaa_start;
 };
 
 static int
@@ -685,8 +854,11 @@ dc_enumerate_cb(tse_task_t *task, void *arg)
 		enum_anchor_copy(enum_args->eaa_anchor,
 				 &oeo->oeo_anchor);
 out:
-	if (enum_args->eaa_obj != NULL)
+	if (enum_args->eaa_obj != NULL) {
+		obj_tgt_load_end(enum_args->eaa_obj->do_target_id,
+				 enum_args->eaa_start);
 		obj_shard_decref(enum_args->eaa_obj);
+	}
 
 	if (oei->oei_bulk != NULL)
 		crt_bulk_free(oei->oei_bulk);
@@ -760,6 +932,7 @@ dc_obj_shard_list(struct dc_obj_shard *obj_shard, unsigned int opc,
 	oei->oei_rec_type	= type;
 	uuid_copy(oei->oei_co_hdl, cont_hdl_uuid);
 	uuid_copy(oei->oei_co_uuid, cont_uuid);
+	uuid_copy(oei->oei_pool_uuid, pool->dp_pool);
 
 	if (anchor != NULL)
 		enum_anchor_copy(&oei->oei_anchor, anchor);
@@ -812,11 +985,14 @@ dc_obj_shard_list(struct dc_obj_shard *obj_shard, unsigned int opc,
 	enum_args.eaa_map_ver = map_ver;
 	enum_args.eaa_recxs = recxs;
 	enum_args.eaa_eprs = eprs;
+	enum_args.eaa_start = obj_tgt_load_now();
 	rc = tse_task_register_comp_cb(task, dc_enumerate_cb, &enum_args,
 				       sizeof(enum_args));
 	if (rc != 0)
 		D_GOTO(out_eaa, rc);
 
+	obj_tgt_load_begin(obj_shard->do_target_id);
+
 	rc = daos_rpc_send(req, task);
 	if (rc != 0) {
 		D_ERROR("enumerate rpc failed rc %d\n", rc);
@@ -847,6 +1023,8 @@ struct obj_query_key_cb_args {
 	daos_key_t	*dkey;
 	daos_key_t	*akey;
 	daos_recx_t	*recx;
+	uint32_t	tgt_id;
+	uint64_t	start;
 };
 
 static int
@@ -945,6 +1123,7 @@ obj_shard_query_key_cb(tse_task_t *task, void *data)
 	}
 
 out:
+	obj_tgt_load_end(cb_args->tgt_id, cb_args->start);
 	crt_req_decref(rpc);
 	if (ret == 0 || obj_retry_error(rc))
 		ret = rc;
@@ -964,6 +1143,7 @@ dc_obj_shard_query_key(struct dc_obj_shard *shard, daos_epoch_t epoch,
 	struct obj_query_key_cb_args	 cb_args;
 	daos_unit_oid_t			 oid;
 	crt_endpoint_t			 tgt_ep;
+	uuid_t				 pool_uuid;
 	uint64_t			 dkey_hash;
 	int				 rc;
 
@@ -977,6 +1157,7 @@ dc_obj_shard_query_key(struct dc_obj_shard *shard, daos_epoch_t epoch,
 	tgt_ep.ep_grp	= pool->dp_group;
 	tgt_ep.ep_tag	= shard->do_target_idx;
 	tgt_ep.ep_rank = shard->do_target_rank;
+	uuid_copy(pool_uuid, pool->dp_pool);
 	dc_pool_put(pool);
 	if ((int)tgt_ep.ep_rank < 0)
 		D_GOTO(out, rc = (int)tgt_ep.ep_rank);
@@ -997,12 +1178,16 @@ dc_obj_shard_query_key(struct dc_obj_shard *shard, daos_epoch_t epoch,
 	cb_args.dkey	= dkey;
 	cb_args.akey	= akey;
 	cb_args.recx	= recx;
+	cb_args.tgt_id	= shard->do_target_id;
+	cb_args.start	= obj_tgt_load_now();
 
 	rc = tse_task_register_comp_cb(task, obj_shard_query_key_cb, &cb_args,
 				       sizeof(cb_args));
 	if (rc != 0)
 		D_GOTO(out_req, rc);
 
+	obj_tgt_load_begin(shard->do_target_id);
+
 	okqi = crt_req_get(req);
 	D_ASSERT(okqi != NULL);
 
@@ -1016,6 +1201,7 @@ dc_obj_shard_query_key(struct dc_obj_shard *shard, daos_epoch_t epoch,
 		okqi->okqi_akey		= *akey;
 	uuid_copy(okqi->okqi_co_hdl, coh_uuid);
 	uuid_copy(okqi->okqi_co_uuid, cont_uuid);
+	uuid_copy(okqi->okqi_pool_uuid, pool_uuid);
 
 	rc = daos_rpc_send(req, task);
 	if (rc != 0) {
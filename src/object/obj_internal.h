@@ -51,6 +51,11 @@
 extern bool	cli_bypass_rpc;
 /** Switch of server-side IO dispatch */
 extern bool	srv_io_dispatch;
+/**
+ * Replicated reads avoid the replicas which have stopped completing RPCs
+ * for longer than their p95 latency, see obj_tgt_load_stalled().
+ */
+extern bool	cli_hedged_read;
 
 /**
  * Bypass bulk transfer on server side, instead data will be copy from/to
@@ -166,6 +171,14 @@ obj_retry_error(int err)
 	       daos_crt_network_error(err);
 }
 
+int obj_tgt_load_init(void);
+void obj_tgt_load_fini(void);
+uint64_t obj_tgt_load_now(void);
+void obj_tgt_load_begin(uint32_t tgt_id);
+void obj_tgt_load_end(uint32_t tgt_id, uint64_t start);
+uint64_t obj_tgt_load_cost(uint32_t tgt_id);
+bool obj_tgt_load_stalled(uint32_t tgt_id);
+
 void obj_shard_decref(struct dc_obj_shard *shard);
 void obj_shard_addref(struct dc_obj_shard *shard);
 void obj_addref(struct dc_object *obj);
@@ -178,6 +191,12 @@ void ds_obj_enum_handler(crt_rpc_t *rpc);
 void ds_obj_punch_handler(crt_rpc_t *rpc);
 void ds_obj_query_key_handler(crt_rpc_t *rpc);
 #define OBJ_TGTS_IGNORE		((d_rank_t)-1)
+/* Values up to this size are packed into the enumeration reply */
+#define OBJ_ENUM_INLINE_THRES		32
+/* Rebuild enumeration inlines larger values, so the rebuild puller can
+ * skip the fetch RPC of each small dkey.
+ */
+#define OBJ_REBUILD_INLINE_THRES	4096
 ABT_pool
 ds_obj_abt_pool_choose_cb(crt_rpc_t *rpc, ABT_pool *pools);
 typedef int (*ds_iofw_cb_t)(crt_rpc_t *req, uint32_t shard, void *arg);
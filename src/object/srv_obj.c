@@ -98,6 +98,11 @@ ds_obj_rw_complete(crt_rpc_t *rpc, struct ds_cont_hdl *cont_hdl,
 	if (rc != 0)
 		D_ERROR("send reply failed: %d\n", rc);
 
+	/* the update may have made the object worth aggregating */
+	if (opc_get(rpc->cr_opc) == DAOS_OBJ_RPC_UPDATE && status == 0 &&
+	    cont_hdl != NULL && cont_hdl->sch_cont != NULL)
+		ds_cont_agg_check(cont_hdl, orwi->orw_epoch);
+
 	if (opc_get(rpc->cr_opc) == DAOS_OBJ_RPC_FETCH) {
 		if (orwo->orw_sizes.ca_arrays != NULL) {
 			D_FREE(orwo->orw_sizes.ca_arrays);
@@ -436,10 +441,11 @@ ds_obj_update_nrs_in_reply(crt_rpc_t *rpc, daos_handle_t ioh,
 /**
  * Lookup and return the container handle, if it is a rebuild handle, which
  * will never associate a particular container, then the contaier structure
- * will be returned to \a contp.
+ * will be returned to \a contp. A handle used for the first time on this
+ * xstream is looked up from the container service of pool \a pool_uuid.
  */
 static int
-ds_check_container(uuid_t cont_hdl_uuid, uuid_t cont_uuid,
+ds_check_container(uuid_t pool_uuid, uuid_t cont_hdl_uuid, uuid_t cont_uuid,
 		   struct ds_cont_hdl **hdlp, struct ds_cont **contp)
 {
 	struct ds_cont_hdl	*cont_hdl;
@@ -447,9 +453,12 @@ ds_check_container(uuid_t cont_hdl_uuid, uuid_t cont_uuid,
 
 	cont_hdl = ds_cont_hdl_lookup(cont_hdl_uuid);
 	if (cont_hdl == NULL) {
-		D_DEBUG(DB_TRACE, "can not find "DF_UUID" hdl\n",
-			 DP_UUID(cont_hdl_uuid));
-		D_GOTO(failed, rc = -DER_NO_HDL);
+		rc = ds_cont_hdl_fetch(pool_uuid, cont_hdl_uuid, &cont_hdl);
+		if (rc != 0) {
+			D_DEBUG(DB_TRACE, "can not find "DF_UUID" hdl: %d\n",
+				DP_UUID(cont_hdl_uuid), rc);
+			D_GOTO(failed, rc);
+		}
 	}
 
 	if (cont_hdl->sch_cont != NULL) { /* a regular container */
@@ -607,6 +616,7 @@ obj_update_prefw(crt_rpc_t *req, uint32_t shard, void *arg)
 	orw->orw_oid.id_shard = shard;
 	uuid_copy(orw->orw_co_hdl, orw_parent->orw_co_hdl);
 	uuid_copy(orw->orw_co_uuid, orw_parent->orw_co_uuid);
+	uuid_copy(orw->orw_pool_uuid, orw_parent->orw_pool_uuid);
 	orw->orw_shard_tgts.ca_count	= 0;
 	orw->orw_shard_tgts.ca_arrays	= NULL;
 	orw->orw_flags			= ORW_FLAG_BULK_BIND;
@@ -614,6 +624,102 @@ obj_update_prefw(crt_rpc_t *req, uint32_t shard, void *arg)
 	return 0;
 }
 
+/* Size of the fetched data, the holes are not counted */
+static daos_size_t
+ds_obj_fetch_size(daos_handle_t ioh, int nr)
+{
+	struct bio_sglist	*bsgl;
+	daos_size_t		 size = 0;
+	int			 i, j;
+
+	for (i = 0; i < nr; i++) {
+		bsgl = vos_iod_sgl_at(ioh, i);
+		D_ASSERT(bsgl != NULL);
+		for (j = 0; j < bsgl->bs_nr_out; j++) {
+			if (bsgl->bs_iovs[j].bi_buf != NULL)
+				size += bsgl->bs_iovs[j].bi_data_len;
+		}
+	}
+	return size;
+}
+
+/**
+ * Copy the fetched data into a DRAM buffer and end the VOS fetch before the
+ * bulk transfer, so the lease on the object is held only for the copy. It's
+ * used for small fetches, for which pinning the SCM extents during the bulk
+ * transfer isn't worth it, see dss_zc_threshold.
+ */
+static int
+ds_obj_fetch_bounce(crt_rpc_t *rpc, struct bio_desc *biod, daos_handle_t *ioh)
+{
+	struct obj_rw_in	*orw = crt_req_get(rpc);
+	daos_sg_list_t		*sgls = NULL;
+	daos_sg_list_t		**sgl_ptrs = NULL;
+	char			*buf = NULL;
+	char			*ptr;
+	daos_size_t		 size;
+	int			 nr = orw->orw_nr;
+	int			 i, j;
+	int			 rc = 0, err;
+
+	size = ds_obj_fetch_size(*ioh, nr);
+	D_ALLOC_ARRAY(sgls, nr);
+	D_ALLOC_ARRAY(sgl_ptrs, nr);
+	if (sgls == NULL || sgl_ptrs == NULL)
+		D_GOTO(post, rc = -DER_NOMEM);
+
+	if (size != 0) {
+		D_ALLOC(buf, size);
+		if (buf == NULL)
+			D_GOTO(post, rc = -DER_NOMEM);
+	}
+
+	ptr = buf;
+	for (i = 0; i < nr; i++) {
+		rc = bio_sgl_convert(vos_iod_sgl_at(*ioh, i), &sgls[i]);
+		if (rc != 0)
+			goto post;
+
+		sgl_ptrs[i] = &sgls[i];
+		/* keep the holes as empty iovs, see ds_bulk_transfer() */
+		for (j = 0; j < sgls[i].sg_nr_out; j++) {
+			daos_iov_t	*iov = &sgls[i].sg_iovs[j];
+
+			if (iov->iov_buf == NULL)
+				continue;
+			memcpy(ptr, iov->iov_buf, iov->iov_len);
+			iov->iov_buf = ptr;
+			ptr += iov->iov_len;
+		}
+	}
+post:
+	err = bio_iod_post(biod);
+	rc = rc ? : err;
+	if (rc != 0)
+		goto out;
+
+	rc = vos_fetch_end(*ioh, 0);
+	*ioh = DAOS_HDL_INVAL;
+	if (rc != 0)
+		goto out;
+
+	rc = ds_bulk_transfer(rpc, CRT_BULK_PUT,
+			      orw->orw_flags & ORW_FLAG_BULK_BIND,
+			      orw->orw_bulks.ca_arrays, DAOS_HDL_INVAL,
+			      sgl_ptrs, nr);
+out:
+	if (sgls != NULL) {
+		for (i = 0; i < nr; i++)
+			daos_sgl_fini(&sgls[i], false);
+		D_FREE(sgls);
+	}
+	if (sgl_ptrs != NULL)
+		D_FREE(sgl_ptrs);
+	if (buf != NULL)
+		D_FREE(buf);
+	return rc;
+}
+
 static int
 ds_obj_rw_local_hdlr(crt_rpc_t *rpc, uint32_t tag, struct ds_cont_hdl *cont_hdl,
 		     struct ds_cont *cont, daos_handle_t *ioh, bool update)
@@ -688,6 +794,15 @@ ds_obj_rw_local_hdlr(crt_rpc_t *rpc, uint32_t tag, struct ds_cont_hdl *cont_hdl,
 		goto out;
 	}
 
+	if (rma && !update && dss_zc_threshold != 0 &&
+	    ds_obj_fetch_size(*ioh, orw->orw_nr) < dss_zc_threshold) {
+		rc = ds_obj_fetch_bounce(rpc, biod, ioh);
+		if (rc == -DER_OVERFLOW)
+			rc = -DER_REC2BIG;
+		goto out;
+	}
+
+	/* SCM extents are transferred in place, under the fetch lease */
 	if (rma) {
 		bulk_bind = orw->orw_flags & ORW_FLAG_BULK_BIND;
 		rc = ds_bulk_transfer(rpc, bulk_op, bulk_bind,
@@ -734,8 +849,8 @@ ds_obj_rw_handler(crt_rpc_t *rpc)
 		DF_U64".\n", rpc, opc_get(rpc->cr_opc), DP_UOID(orw->orw_oid),
 		(int)orw->orw_dkey.iov_len, (char *)orw->orw_dkey.iov_buf,
 		tag, orw->orw_epoch);
-	rc = ds_check_container(orw->orw_co_hdl, orw->orw_co_uuid,
-				&cont_hdl, &cont);
+	rc = ds_check_container(orw->orw_pool_uuid, orw->orw_co_hdl,
+				orw->orw_co_uuid, &cont_hdl, &cont);
 	if (rc)
 		goto out;
 
@@ -848,8 +963,8 @@ ds_iter_vos(crt_rpc_t *rpc, struct dss_enum_arg *enum_arg,
 	int			type;
 	int			rc;
 
-	rc = ds_check_container(oei->oei_co_hdl, oei->oei_co_uuid,
-				&cont_hdl, &cont);
+	rc = ds_check_container(oei->oei_pool_uuid, oei->oei_co_hdl,
+				oei->oei_co_uuid, &cont_hdl, &cont);
 	if (rc)
 		D_GOTO(out, rc);
 
@@ -997,7 +1112,10 @@ ds_obj_enum_handler(crt_rpc_t *rpc)
 	enum_arg.recx_anchor = oei->oei_anchor;
 
 	/* TODO: Transfer the inline_thres from enumerate RPC */
-	enum_arg.inline_thres = 32;
+	if (opc == DAOS_OBJ_RPC_ENUMERATE)
+		enum_arg.inline_thres = OBJ_REBUILD_INLINE_THRES;
+	else
+		enum_arg.inline_thres = OBJ_ENUM_INLINE_THRES;
 
 	if (opc == DAOS_OBJ_RECX_RPC_ENUMERATE ||
 	    opc == DAOS_OBJ_RPC_ENUMERATE) {
@@ -1106,6 +1224,7 @@ obj_punch_prefw(crt_rpc_t *req, uint32_t shard, void *arg)
 	opi->opi_oid.id_shard = shard;
 	uuid_copy(opi->opi_co_hdl, opi_parent->opi_co_hdl);
 	uuid_copy(opi->opi_co_uuid, opi_parent->opi_co_uuid);
+	uuid_copy(opi->opi_pool_uuid, opi_parent->opi_pool_uuid);
 	opi->opi_shard_tgts.ca_count = 0;
 	opi->opi_shard_tgts.ca_arrays = NULL;
 
@@ -1182,8 +1301,8 @@ ds_obj_punch_handler(crt_rpc_t *rpc)
 	D_ASSERT(opi != NULL);
 	dispatch = opi->opi_shard_tgts.ca_arrays != NULL;
 
-	rc = ds_check_container(opi->opi_co_hdl, opi->opi_co_uuid,
-				&cont_hdl, &cont);
+	rc = ds_check_container(opi->opi_pool_uuid, opi->opi_co_hdl,
+				opi->opi_co_uuid, &cont_hdl, &cont);
 	if (rc)
 		D_GOTO(out, rc);
 
@@ -1262,8 +1381,8 @@ ds_obj_query_key_handler(crt_rpc_t *rpc)
 	D_DEBUG(DB_IO, "ds_obj_query_key_handler: flags = %d\n",
 		okqi->okqi_flags);
 
-	rc = ds_check_container(okqi->okqi_co_hdl, okqi->okqi_co_uuid,
-				&cont_hdl, &cont);
+	rc = ds_check_container(okqi->okqi_pool_uuid, okqi->okqi_co_hdl,
+				okqi->okqi_co_uuid, &cont_hdl, &cont);
 	if (rc)
 		D_GOTO(out, rc);
 
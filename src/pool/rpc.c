@@ -98,6 +98,10 @@ crt_proc_struct_daos_rebuild_status(crt_proc_t proc,
 	if (rc != 0)
 		return -DER_HG;
 
+	rc = crt_proc_uint64_t(proc, &drs->rs_size);
+	if (rc != 0)
+		return -DER_HG;
+
 	return 0;
 }
 
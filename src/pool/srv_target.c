@@ -51,6 +51,9 @@
 
 /* ds_pool_child **************************************************************/
 
+static void pool_tier_start(struct ds_pool_child *child);
+static void pool_tier_stop(struct ds_pool_child *child);
+
 struct ds_pool_child *
 ds_pool_child_lookup(const uuid_t uuid)
 {
@@ -89,6 +92,7 @@ ds_pool_child_purge(struct pool_tls *tls)
 	d_list_for_each_entry_safe(child, n, &tls->dt_pool_list, spc_list) {
 		D_ASSERTF(child->spc_ref == 1, DF_UUID": %d\n",
 			  DP_UUID(child->spc_uuid), child->spc_ref);
+		pool_tier_stop(child);
 		d_list_del_init(&child->spc_list);
 		ds_pool_child_put(child);
 	}
@@ -144,6 +148,7 @@ ds_pool_child_open(uuid_t uuid, unsigned int version)
 	child->spc_ref = 1; /* 1 for the list */
 
 	d_list_add(&child->spc_list, &tls->dt_pool_list);
+	pool_tier_start(child);
 
 	return 0;
 }
@@ -169,6 +174,7 @@ ds_pool_child_close(uuid_t uuid)
 	if (child == NULL)
 		return 0;
 
+	pool_tier_stop(child);
 	d_list_del_init(&child->spc_list);
 	ds_pool_child_put(child); /* -1 for the list */
 	ds_pool_child_put(child); /* -1 for lookup */
@@ -816,9 +822,147 @@ iter_fini:
 	return rc;
 }
 
+/* Max number of extents moved before yielding */
+#define POOL_TIER_CREDITS	32
+/* Default interval (in seconds) between the media migration rounds */
+#define POOL_TIER_INTV_DEF	10
+
+/* Migrate the extents of the objects in a container between SCM and NVMe */
+static int
+pool_tier_cont_cb(daos_handle_t ph, uuid_t co_uuid, void *data)
+{
+	struct ds_pool_child	*child = data;
+	vos_tier_stats_t	 stats = { 0 };
+	vos_iter_param_t	 param;
+	daos_handle_t		 coh;
+	daos_handle_t		 ih;
+	unsigned int		 credits;
+	int			 rc;
+
+	rc = vos_cont_open(ph, co_uuid, &coh);
+	if (rc != 0)
+		return rc;
+
+	memset(&param, 0, sizeof(param));
+	param.ip_hdl = coh;
+	param.ip_epr.epr_lo = 0;
+	param.ip_epr.epr_hi = DAOS_EPOCH_MAX;
+
+	rc = vos_iter_prepare(VOS_ITER_OBJ, &param, &ih);
+	if (rc != 0) {
+		rc = (rc == -DER_NONEXIST) ? 0 : rc;
+		goto close;
+	}
+
+	rc = vos_iter_probe(ih, NULL);
+	while (rc == 0 && !child->spc_tier_stop) {
+		vos_iter_entry_t	ent;
+
+		rc = vos_iter_fetch(ih, &ent, NULL);
+		if (rc != 0)
+			break;
+
+		/* come back for the object until it's done */
+		do {
+			credits = POOL_TIER_CREDITS;
+			rc = vos_obj_tier(coh, ent.ie_oid, &credits, &stats);
+			ABT_thread_yield();
+		} while (rc == 0 && credits == 0 && !child->spc_tier_stop);
+
+		if (rc != 0)
+			break;
+		rc = vos_iter_next(ih);
+	}
+	vos_iter_finish(ih);
+	if (rc == -DER_NONEXIST)
+		rc = 0;
+
+	if (stats.ts_promoted != 0 || stats.ts_demoted != 0)
+		D_DEBUG(DF_DSMS, DF_CONT": promoted "DF_U64", demoted "DF_U64
+			" extents, "DF_U64" bytes\n",
+			DP_CONT(child->spc_uuid, co_uuid), stats.ts_promoted,
+			stats.ts_demoted, stats.ts_bytes);
+close:
+	vos_cont_close(coh);
+	return rc;
+}
+
+/**
+ * Per pool & xstream ULT which periodically walks the objects and migrates
+ * the cold extents to NVMe and the hot ones to SCM, as the media policy of
+ * the VOS pool decides. It runs in the background aggregation pool.
+ */
+static void
+pool_tier_ult(void *arg)
+{
+	struct ds_pool_child	*child = arg;
+	unsigned int		 intv = POOL_TIER_INTV_DEF;
+	unsigned int		 i;
+	char			*env;
+	int			 rc;
+
+	env = getenv("DAOS_TIER_INTERVAL");
+	if (env != NULL)
+		intv = atoi(env);
+
+	while (!child->spc_tier_stop) {
+		for (i = 0; i < intv && !child->spc_tier_stop; i++)
+			dss_sleep(1000);
+		if (child->spc_tier_stop)
+			break;
+
+		rc = ds_pool_cont_iter(child->spc_hdl, pool_tier_cont_cb,
+				       child);
+		if (rc != 0)
+			D_ERROR(DF_UUID": media migration failed: %d\n",
+				DP_UUID(child->spc_uuid), rc);
+	}
+}
+
+/* Start the media migration ULT if the pool has NVMe */
+static void
+pool_tier_start(struct ds_pool_child *child)
+{
+	vos_pool_info_t	pinfo;
+	char		*env;
+	int		rc;
+
+	child->spc_tier_ult = ABT_THREAD_NULL;
+	child->spc_tier_stop = false;
+
+	env = getenv("DAOS_TIER_INTERVAL");
+	if (env != NULL && atoi(env) <= 0)
+		return;
+
+	rc = vos_pool_query(child->spc_hdl, &pinfo);
+	if (rc != 0 || pinfo.pif_blob_sz == 0)
+		return;
+
+	rc = dss_aggregate_ult_create(pool_tier_ult, child, -1, 0,
+				      &child->spc_tier_ult);
+	if (rc != 0) {
+		D_ERROR(DF_UUID": failed to start media migration: %d\n",
+			DP_UUID(child->spc_uuid), rc);
+		child->spc_tier_ult = ABT_THREAD_NULL;
+	}
+}
+
+static void
+pool_tier_stop(struct ds_pool_child *child)
+{
+	if (child->spc_tier_ult == ABT_THREAD_NULL)
+		return;
+
+	child->spc_tier_stop = true;
+	ABT_thread_join(child->spc_tier_ult);
+	ABT_thread_free(&child->spc_tier_ult);
+	child->spc_tier_ult = ABT_THREAD_NULL;
+}
+
 struct obj_iter_arg {
-	cont_iter_cb_t	callback;
-	void		*arg;
+	obj_iter_cont_cb_t	cont_cb;
+	cont_iter_cb_t		callback;
+	void			*arg;
 };
 
 static int
@@ -833,14 +977,25 @@ cont_obj_iter_cb(uuid_t cont_uuid, daos_unit_oid_t oid, daos_epoch_t eph,
 static int
 pool_obj_iter_cb(daos_handle_t ph, uuid_t co_uuid, void *data)
 {
-	return ds_cont_obj_iter(ph, co_uuid, cont_obj_iter_cb, data);
+	struct obj_iter_arg	*arg = data;
+	daos_anchor_t		*anchor = NULL;
+	int			 rc;
+
+	if (arg->cont_cb != NULL) {
+		rc = arg->cont_cb(co_uuid, &anchor, arg->arg);
+		if (rc)
+			return rc > 0 ? 0 : rc;
+	}
+
+	return ds_cont_obj_iter(ph, co_uuid, anchor, cont_obj_iter_cb, data);
 }
 
 /**
  * Iterate all of the objects in the pool.
  **/
 int
-ds_pool_obj_iter(uuid_t pool_uuid, obj_iter_cb_t callback, void *data)
+ds_pool_obj_iter(uuid_t pool_uuid, obj_iter_cont_cb_t cont_cb,
+		 obj_iter_cb_t callback, void *data)
 {
 	struct obj_iter_arg	arg;
 	struct ds_pool_child	*child;
@@ -850,6 +1005,7 @@ ds_pool_obj_iter(uuid_t pool_uuid, obj_iter_cb_t callback, void *data)
 	if (child == NULL)
 		return -DER_NONEXIST;
 
+	arg.cont_cb = cont_cb;
 	arg.callback = callback;
 	arg.arg = data;
 	rc = ds_pool_cont_iter(child->spc_hdl, pool_obj_iter_cb, &arg);
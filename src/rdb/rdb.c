@@ -500,6 +500,19 @@ rdb_get_ranks(struct rdb *db, d_rank_list_t **ranksp)
 	return daos_rank_list_dup(ranksp, db->d_replicas);
 }
 
+/**
+ * Get the commit counters of this replica. Only the TXs committed through
+ * this replica as the leader are counted.
+ *
+ * \param[in]	db	database
+ * \param[out]	stat	commit counters
+ */
+void
+rdb_get_stat(struct rdb *db, struct rdb_stat *stat)
+{
+	*stat = db->d_stat;
+}
+
 /**
  * Get the UUID of the database.
  *
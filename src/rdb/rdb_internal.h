@@ -80,6 +80,14 @@ struct rdb {
 	ABT_cond		d_events_cv;	/* for d_events enqueues */
 	uint64_t		d_compact_thres;/* of compactable entries */
 	ABT_cond		d_compact_cv;	/* for base updates */
+	double			d_election_timeout; /* (s) */
+	uint64_t		d_lease_term;	/* of d_lease */
+	double			d_lease;	/* leader lease expiry */
+	double			d_leader_contact; /* last AE from leader */
+	d_list_t		d_commits;	/* rdb_raft_commit queue */
+	bool			d_committing;	/* appending d_commits */
+	bool			d_lc_defer;	/* defer log tail updates */
+	struct rdb_stat		d_stat;		/* commit counters */
 	bool			d_stop;		/* for rdb_stop() */
 	ABT_thread		d_timerd;
 	ABT_thread		d_callbackd;
@@ -133,6 +141,7 @@ struct rdb_raft_node {
 	/* Leader fields */
 	uint64_t		dn_term;	/* of leader */
 	struct rdb_raft_is	dn_is;
+	double			dn_ack;		/* send time of last AE acked */
 };
 
 int rdb_raft_init(daos_handle_t pool, daos_handle_t mc,
@@ -141,12 +150,16 @@ int rdb_raft_start(struct rdb *db);
 void rdb_raft_stop(struct rdb *db);
 void rdb_raft_resign(struct rdb *db, uint64_t term);
 int rdb_raft_verify_leadership(struct rdb *db);
+double rdb_raft_lease_expiry(double *acks, int nacks, double election_timeout);
+bool rdb_raft_vote_blocked(double leader_contact, double election_timeout,
+			   double now);
 int rdb_raft_append_apply(struct rdb *db, msg_entry_t *mentry, void *result);
 int rdb_raft_wait_applied(struct rdb *db, uint64_t index, uint64_t term);
 void rdb_requestvote_handler(crt_rpc_t *rpc);
 void rdb_appendentries_handler(crt_rpc_t *rpc);
 void rdb_installsnapshot_handler(crt_rpc_t *rpc);
-void rdb_raft_process_reply(struct rdb *db, raft_node_t *node, crt_rpc_t *rpc);
+void rdb_raft_process_reply(struct rdb *db, raft_node_t *node, crt_rpc_t *rpc,
+			    double sent);
 void rdb_raft_free_request(struct rdb *db, crt_rpc_t *rpc);
 
 /* rdb_rpc.c ******************************************************************/
@@ -1117,6 +1117,25 @@ rdb_raft_update_node(struct rdb *db, uint64_t index, raft_entry_t *entry)
 	return rc;
 }
 
+/*
+ * Persist the log tail, which is in memory only while db->d_lc_defer is
+ * true, so that a batch of entries costs one metadata update.
+ */
+static int
+rdb_raft_store_tail(struct rdb *db)
+{
+	daos_iov_t	value;
+	int		rc;
+
+	daos_iov_set(&value, &db->d_lc_record, sizeof(db->d_lc_record));
+	rc = rdb_mc_update(db->d_mc, RDB_MC_ATTRS, 1 /* n */, &rdb_mc_lc,
+			   &value);
+	if (rc != 0)
+		D_ERROR(DF_DB": failed to update log tail "DF_U64": %d\n",
+			DP_DB(db), db->d_lc_record.dlr_tail, rc);
+	return rc;
+}
+
 static int
 rdb_raft_log_offer_single(raft_server_t *raft, void *arg,
 			  raft_entry_t *entry, uint64_t index)
@@ -1187,16 +1206,17 @@ rdb_raft_log_offer_single(raft_server_t *raft, void *arg,
 		entry->data.buf = NULL;
 	}
 
-	/* Update the log tail. See the log tail assertion above. */
+	/*
+	 * Update the log tail. See the log tail assertion above. If a batch
+	 * is being appended, the batch will persist the tail once.
+	 */
 	db->d_lc_record.dlr_tail++;
-	daos_iov_set(&values[0], &db->d_lc_record, sizeof(db->d_lc_record));
-	rc = rdb_mc_update(db->d_mc, RDB_MC_ATTRS, 1 /* n */, &rdb_mc_lc,
-			   &values[0]);
-	if (rc != 0) {
-		D_ERROR(DF_DB": failed to update log tail "DF_U64": %d\n",
-			DP_DB(db), db->d_lc_record.dlr_tail, rc);
-		db->d_lc_record.dlr_tail--;
-		goto err_discard;
+	if (!db->d_lc_defer) {
+		rc = rdb_raft_store_tail(db);
+		if (rc != 0) {
+			db->d_lc_record.dlr_tail--;
+			goto err_discard;
+		}
 	}
 
 	D_DEBUG(DB_TRACE, DF_DB": appended entry "DF_U64": term=%d type=%d "
@@ -1216,15 +1236,54 @@ static int
 rdb_raft_cb_log_offer(raft_server_t *raft, void *arg, raft_entry_t *entries,
 		      int index, int *n_entries)
 {
-	int i;
-	int rc = 0;
+	struct rdb     *db = arg;
+	bool		batch = !db->d_lc_defer && *n_entries > 1;
+	int		i;
+	int		n;
+	int		rc = 0;
+	int		rc_tmp;
 
+	/* Persist the tail once for all entries of an AE. */
+	if (batch)
+		db->d_lc_defer = true;
 	for (i = 0; i < *n_entries; ++i) {
 		rc = rdb_raft_log_offer_single(raft, arg, &entries[i],
 					       index + i);
 		if (rc != 0)
 			break;
 	}
+	if (!batch || i == 0)
+		goto out;
+
+	rc_tmp = rdb_raft_store_tail(db);
+	if (rc_tmp != 0) {
+		/*
+		 * Persist the tail entry by entry instead, so that only the
+		 * entries from the first failure on are discarded.
+		 */
+		for (n = 0; n < i; n++) {
+			db->d_lc_record.dlr_tail = index + n + 1;
+			rc_tmp = rdb_raft_store_tail(db);
+			if (rc_tmp != 0)
+				break;
+		}
+		db->d_lc_record.dlr_tail = index + n;
+		if (n == i)
+			goto out;
+
+		rdb_kvs_cache_evict(db->d_kvss);
+		rc = rdb_lc_discard(db->d_lc, index + n, index + i - 1);
+		if (rc != 0)
+			D_ERROR(DF_DB": failed to discard entries "DF_U64
+				"-"DF_U64": %d\n", DP_DB(db),
+				(uint64_t)index + n, (uint64_t)index + i - 1,
+				rc);
+		rc = rc_tmp;
+		i = n;
+	}
+out:
+	if (batch)
+		db->d_lc_defer = false;
 	*n_entries = i;
 	return rc;
 }
@@ -1606,6 +1665,25 @@ rdb_callbackd(void *arg)
 	D_DEBUG(DB_MD, DF_DB": callbackd stopping\n", DP_DB(db));
 }
 
+/* Forget the AE acknowledgements and the lease of the previous term. */
+static void
+rdb_raft_reset_lease(struct rdb *db)
+{
+	int i;
+
+	for (i = 0; i < raft_get_num_nodes(db->d_raft); i++) {
+		raft_node_t	       *node;
+		struct rdb_raft_node   *rdb_node;
+
+		node = raft_get_node_from_idx(db->d_raft, i);
+		rdb_node = raft_node_get_udata(node);
+		if (rdb_node != NULL)
+			rdb_node->dn_ack = 0;
+	}
+	db->d_lease = 0;
+	db->d_lease_term = 0;
+}
+
 static int
 rdb_raft_step_up(struct rdb *db, uint64_t term)
 {
@@ -1614,6 +1692,7 @@ rdb_raft_step_up(struct rdb *db, uint64_t term)
 	int			rc;
 
 	D_WARN(DF_DB": became leader of term "DF_U64"\n", DP_DB(db), term);
+	rdb_raft_reset_lease(db);
 	/* Commit an empty entry for an up-to-date last committed index. */
 	mentry.term = raft_get_current_term(db->d_raft);
 	mentry.id = 0; /* unused */
@@ -1638,6 +1717,7 @@ rdb_raft_step_down(struct rdb *db, uint64_t term)
 	D_WARN(DF_DB": no longer leader of term "DF_U64"\n", DP_DB(db),
 	       term);
 	db->d_debut = 0;
+	db->d_lease = 0;
 	rdb_raft_queue_event(db, RDB_RAFT_STEP_DOWN, term);
 }
 
@@ -1805,11 +1885,25 @@ rdb_raft_unregister_result(struct rdb *db, uint64_t index)
 	D_FREE(result);
 }
 
-/* Append and wait for \a entry to be applied. */
-int
-rdb_raft_append_apply(struct rdb *db, msg_entry_t *mentry, void *result)
+/* A TX entry waiting to be appended by the current batch */
+struct rdb_raft_commit {
+	d_list_t		dcm_link;	/* in rdb::d_commits */
+	msg_entry_t	       *dcm_entry;
+	void		       *dcm_result;
+	msg_entry_response_t	dcm_response;
+	int			dcm_rc;
+	bool			dcm_appended;
+};
+
+/* Max number of entries appended as one batch */
+#define RDB_BATCH_MAX		128
+/* Number of commits between two reports of the commit counters */
+#define RDB_STAT_INTV		1024
+
+/* Append \a c to the log. Must not yield. */
+static int
+rdb_raft_append_one(struct rdb *db, struct rdb_raft_commit *c)
 {
-	msg_entry_response_t	mresponse;
 	struct rdb_raft_state	state;
 	uint64_t		index;
 	int			rc;
@@ -1819,41 +1913,269 @@ rdb_raft_append_apply(struct rdb *db, msg_entry_t *mentry, void *result)
 	 * assertion below will hold.
 	 */
 	index = raft_get_current_idx(db->d_raft) + 1;
-	if (result != NULL) {
-		rc = rdb_raft_register_result(db, index, result);
+	if (c->dcm_result != NULL) {
+		rc = rdb_raft_register_result(db, index, c->dcm_result);
 		if (rc != 0)
-			goto out;
+			return rc;
 	}
 
 	rdb_raft_save_state(db, &state);
-	rc = raft_recv_entry(db->d_raft, mentry, &mresponse);
+	rc = raft_recv_entry(db->d_raft, c->dcm_entry, &c->dcm_response);
 	rc = rdb_raft_check_state(db, &state, rc);
 	if (rc != 0) {
 		if (rc != -DER_NOTLEADER)
 			D_ERROR(DF_DB": failed to append entry: %d\n",
 				DP_DB(db), rc);
-		goto out_result;
+		if (c->dcm_result != NULL)
+			rdb_raft_unregister_result(db, index);
+		return rc;
 	}
 
 	/* The actual index must match the expected index. */
-	D_ASSERTF(mresponse.idx == index, "%d == "DF_U64"\n", mresponse.idx,
-		  index);
+	D_ASSERTF(c->dcm_response.idx == index, "%d == "DF_U64"\n",
+		  c->dcm_response.idx, index);
+	return 0;
+}
 
-	rc = rdb_raft_wait_applied(db, mresponse.idx, mresponse.term);
+/*
+ * Append the queued entries in batches. Within a batch, the entries are
+ * appended back to back, and the log tail is persisted once at the end; the
+ * entries appended while an AE is in flight also go to the followers in one
+ * AE.
+ */
+static void
+rdb_raft_append_batches(struct rdb *db)
+{
+	while (!d_list_empty(&db->d_commits)) {
+		struct rdb_raft_commit *c;
+		struct rdb_raft_commit *tmp;
+		d_list_t		batch;
+		uint64_t		tail = db->d_lc_record.dlr_tail;
+		int			n = 0;
+		int			rc;
+
+		D_INIT_LIST_HEAD(&batch);
+		db->d_lc_defer = true;
+		d_list_for_each_entry_safe(c, tmp, &db->d_commits, dcm_link) {
+			if (n == RDB_BATCH_MAX)
+				break;
+			d_list_move_tail(&c->dcm_link, &batch);
+			c->dcm_rc = rdb_raft_append_one(db, c);
+			n++;
+		}
+		db->d_lc_defer = false;
+
+		if (db->d_lc_record.dlr_tail != tail) {
+			rc = rdb_raft_store_tail(db);
+			if (rc != 0) {
+				/*
+				 * raft already considers these entries
+				 * appended; stop the DB like other log I/O
+				 * errors do.
+				 */
+				d_list_for_each_entry(c, &batch, dcm_link) {
+					if (c->dcm_rc == 0)
+						c->dcm_rc = rc;
+				}
+				db->d_cbs->dc_stop(db, rc, db->d_arg);
+			}
+		}
 
-out_result:
+		db->d_stat.rs_batches++;
+		db->d_stat.rs_entries += n;
+		if (n > db->d_stat.rs_batch_max)
+			db->d_stat.rs_batch_max = n;
+
+		ABT_mutex_lock(db->d_mutex);
+		d_list_for_each_entry_safe(c, tmp, &batch, dcm_link) {
+			d_list_del_init(&c->dcm_link);
+			c->dcm_appended = true;
+		}
+		ABT_cond_broadcast(db->d_applied_cv);
+		ABT_mutex_unlock(db->d_mutex);
+	}
+}
+
+static void
+rdb_raft_commit_stat(struct rdb *db, double latency)
+{
+	struct rdb_stat *stat = &db->d_stat;
+
+	stat->rs_commits++;
+	stat->rs_latency += latency;
+	if (latency > stat->rs_latency_max)
+		stat->rs_latency_max = latency;
+	if (stat->rs_commits % RDB_STAT_INTV != 0)
+		return;
+
+	D_DEBUG(DB_MD, DF_DB": commits="DF_U64" batches="DF_U64" avg_batch=%.1f "
+		"max_batch=%u avg_latency=%.3fms max_latency=%.3fms\n",
+		DP_DB(db), stat->rs_commits, stat->rs_batches,
+		stat->rs_batches == 0 ? 0.0 :
+		(double)stat->rs_entries / stat->rs_batches,
+		stat->rs_batch_max, stat->rs_latency * 1000 / stat->rs_commits,
+		stat->rs_latency_max * 1000);
+}
+
+/*
+ * Append and wait for \a entry to be applied. Concurrent callers are group
+ * committed: the first one appends the entries queued by all of them.
+ */
+int
+rdb_raft_append_apply(struct rdb *db, msg_entry_t *mentry, void *result)
+{
+	struct rdb_raft_commit	c = {};
+	double			start = ABT_get_wtime();
+	int			rc;
+
+	D_INIT_LIST_HEAD(&c.dcm_link);
+	c.dcm_entry = mentry;
+	c.dcm_result = result;
+	d_list_add_tail(&c.dcm_link, &db->d_commits);
+
+	if (db->d_committing) {
+		/* Wait for the current batch appender to pick up c. */
+		ABT_mutex_lock(db->d_mutex);
+		while (!c.dcm_appended)
+			ABT_cond_wait(db->d_applied_cv, db->d_mutex);
+		ABT_mutex_unlock(db->d_mutex);
+	} else {
+		db->d_committing = true;
+		/* Let the concurrent TXs join this batch. */
+		ABT_thread_yield();
+		rdb_raft_append_batches(db);
+		db->d_committing = false;
+	}
+
+	rc = c.dcm_rc;
+	if (rc != 0)
+		goto out;
+
+	rc = rdb_raft_wait_applied(db, c.dcm_response.idx,
+				   c.dcm_response.term);
 	if (result != NULL)
-		rdb_raft_unregister_result(db, mresponse.idx);
+		rdb_raft_unregister_result(db, c.dcm_response.idx);
+	if (rc == 0)
+		rdb_raft_commit_stat(db, ABT_get_wtime() - start);
 out:
 	return rc;
 }
 
-/* Verify the leadership with a quorum. */
+/*
+ * Leader lease
+ *
+ * A follower that has heard from the leader does not grant votes until an
+ * election timeout has passed (see rdb_requestvote_handler()). Hence, once a
+ * majority has acknowledged an AE sent at time t, no other leader can be
+ * elected before t + election timeout, and the leader may serve queries
+ * locally until then. RDB_LEASE_RATIO leaves a margin for clock drifts.
+ */
+#define RDB_LEASE_RATIO 0.9
+
+/* The number of replicas is stored as a uint8_t. */
+#define RDB_LEASE_ACKS_MAX UINT8_MAX
+
+/*
+ * Should a follower that last heard from the leader at \a leader_contact
+ * (0 if never) reject a RequestVote received at \a now? The leader may still
+ * hold its lease until an election timeout has passed.
+ */
+bool
+rdb_raft_vote_blocked(double leader_contact, double election_timeout,
+		      double now)
+{
+	return leader_contact != 0 && now < leader_contact + election_timeout;
+}
+
+/* Is the leader lease of the current term still valid? */
+static bool
+rdb_raft_lease_valid(struct rdb *db)
+{
+	if (!raft_is_leader(db->d_raft))
+		return false;
+	if (db->d_lease_term != raft_get_current_term(db->d_raft))
+		return false;
+	return ABT_get_wtime() < db->d_lease;
+}
+
+/*
+ * Return the lease expiry granted by the latest acknowledgement times \a acks
+ * of the \a nacks other voting replicas, or 0 if no majority has acknowledged
+ * the leadership yet. Sorts \a acks in descending order.
+ */
+double
+rdb_raft_lease_expiry(double *acks, int nacks, double election_timeout)
+{
+	int	nvoting = nacks + 1;	/* self */
+	int	i;
+	int	j;
+
+	for (i = 1; i < nacks; i++) {
+		double ack = acks[i];
+
+		for (j = i; j > 0 && acks[j - 1] < ack; j--)
+			acks[j] = acks[j - 1];
+		acks[j] = ack;
+	}
+
+	/* Self plus nvoting / 2 others form a majority. */
+	if (nvoting / 2 == 0 || acks[nvoting / 2 - 1] == 0)
+		return 0;
+	return acks[nvoting / 2 - 1] + election_timeout * RDB_LEASE_RATIO;
+}
+
+/*
+ * Record that \a node has acknowledged an AE sent at \a sent, and extend the
+ * lease to the time at which a majority had acknowledged the leadership.
+ */
+static void
+rdb_raft_renew_lease(struct rdb *db, raft_node_t *node, double sent)
+{
+	struct rdb_raft_node   *rdb_node = raft_node_get_udata(node);
+	double			acks[RDB_LEASE_ACKS_MAX];
+	double			lease;
+	int			nacks = 0;
+	int			i;
+
+	if (sent > rdb_node->dn_ack)
+		rdb_node->dn_ack = sent;
+
+	/* Collect the acknowledgements of the other voting replicas. */
+	for (i = 0; i < raft_get_num_nodes(db->d_raft); i++) {
+		raft_node_t	       *n = raft_get_node_from_idx(db->d_raft, i);
+		struct rdb_raft_node   *rn = raft_node_get_udata(n);
+
+		if (n == raft_get_my_node(db->d_raft) ||
+		    !raft_node_is_voting(n))
+			continue;
+		if (nacks == ARRAY_SIZE(acks))
+			return;
+		acks[nacks++] = rn->dn_ack;
+	}
+
+	lease = rdb_raft_lease_expiry(acks, nacks, db->d_election_timeout);
+	if (lease == 0)
+		return;
+	db->d_lease = lease;
+	db->d_lease_term = raft_get_current_term(db->d_raft);
+}
+
+/*
+ * Verify the leadership with a quorum. Return immediately if the leader lease
+ * is still valid.
+ */
 int
 rdb_raft_verify_leadership(struct rdb *db)
 {
 	msg_entry_t		entry = {};
 
+	/* A single replica is always a majority of itself. */
+	if (raft_is_leader(db->d_raft) &&
+	    raft_get_num_voting_nodes(db->d_raft) == 1)
+		return 0;
+	if (rdb_raft_lease_valid(db))
+		return 0;
+
 	entry.type = RAFT_LOGTYPE_NORMAL;
 	entry.data.buf = NULL;
 	entry.data.len = 0;
@@ -2236,6 +2558,7 @@ rdb_raft_start(struct rdb *db)
 
 	D_INIT_LIST_HEAD(&db->d_requests);
 	D_INIT_LIST_HEAD(&db->d_replies);
+	D_INIT_LIST_HEAD(&db->d_commits);
 	db->d_compact_thres = rdb_raft_get_compact_thres();
 
 	rc = d_hash_table_create_inplace(D_HASH_FT_NOLOCK, 4 /* bits */,
@@ -2313,6 +2636,7 @@ rdb_raft_start(struct rdb *db)
 
 	election_timeout = rdb_raft_get_election_timeout();
 	request_timeout = rdb_raft_get_request_timeout();
+	db->d_election_timeout = election_timeout / 1000.0;
 	raft_set_election_timeout(db->d_raft, election_timeout);
 	raft_set_request_timeout(db->d_raft, request_timeout);
 
@@ -2483,6 +2807,20 @@ rdb_requestvote_handler(crt_rpc_t *rpc)
 
 	D_DEBUG(DB_TRACE, DF_DB": handling raft rv from rank %u\n", DP_DB(db),
 		rpc->cr_ep.ep_rank);
+	/*
+	 * Don't help elect a new leader while the current one may still hold
+	 * its lease. See rdb_raft_lease_valid().
+	 */
+	if (!raft_is_leader(db->d_raft) &&
+	    rdb_raft_vote_blocked(db->d_leader_contact,
+				  db->d_election_timeout, ABT_get_wtime())) {
+		D_DEBUG(DB_MD, DF_DB": rejecting rv from rank %u: leader "
+			"contacted %fs ago\n", DP_DB(db), rpc->cr_ep.ep_rank,
+			ABT_get_wtime() - db->d_leader_contact);
+		out->rvo_msg.term = raft_get_current_term(db->d_raft);
+		out->rvo_msg.vote_granted = 0;
+		D_GOTO(out_db, rc = 0);
+	}
 	rdb_raft_save_state(db, &state);
 	rc = raft_recv_requestvote(db->d_raft,
 				   raft_get_node(db->d_raft,
@@ -2529,6 +2867,9 @@ rdb_appendentries_handler(crt_rpc_t *rpc)
 				     raft_get_node(db->d_raft,
 						   rpc->cr_ep.ep_rank),
 				     &in->aei_msg, &out->aeo_msg);
+	/* The sender is the leader of our current term. */
+	if (rc == 0 && in->aei_msg.term == raft_get_current_term(db->d_raft))
+		db->d_leader_contact = ABT_get_wtime();
 	rc = rdb_raft_check_state(db, &state, rc);
 	if (rc != 0) {
 		D_ERROR(DF_DB": failed to process APPENDENTRIES from rank %u: "
@@ -2609,7 +2950,8 @@ out:
 }
 
 void
-rdb_raft_process_reply(struct rdb *db, raft_node_t *node, crt_rpc_t *rpc)
+rdb_raft_process_reply(struct rdb *db, raft_node_t *node, crt_rpc_t *rpc,
+		       double sent)
 {
 	struct rdb_raft_state		state;
 	crt_opcode_t			opc = opc_get(rpc->cr_opc);
@@ -2637,6 +2979,10 @@ rdb_raft_process_reply(struct rdb *db, raft_node_t *node, crt_rpc_t *rpc)
 		out_ae = out;
 		rc = raft_recv_appendentries_response(db->d_raft, node,
 						      &out_ae->aeo_msg);
+		/* The follower has accepted our leadership. */
+		if (rc == 0 && raft_is_leader(db->d_raft) &&
+		    out_ae->aeo_msg.term == raft_get_current_term(db->d_raft))
+			rdb_raft_renew_lease(db, node, sent);
 		break;
 	case RDB_INSTALLSNAPSHOT:
 		out_is = out;
@@ -83,7 +83,8 @@ rdb_tx_begin(struct rdb *db, uint64_t term, struct rdb_tx *tx)
 		return rc;
 	/*
 	 * If this verification succeeds, then queries in this TX will return
-	 * valid results.
+	 * valid results. While the leader lease is valid, this is a local
+	 * check; otherwise, it costs a round of replication.
 	 */
 	rc = rdb_raft_verify_leadership(db);
 	if (rc != 0)
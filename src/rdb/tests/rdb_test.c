@@ -93,6 +93,71 @@ rdbt_test_util(void)
 	ioveq(&v1, &v2);
 }
 
+static void
+rdbt_test_lease(void)
+{
+	double	timeout = 1.0;
+	double	acks[4];
+	double	lease;
+	double	lease_old;
+
+	D_WARN("no lease without a majority of acks\n");
+	acks[0] = 0;
+	acks[1] = 0;
+	lease = rdb_raft_lease_expiry(acks, 2, timeout);
+	D_ASSERTF(lease == 0, "%f\n", lease);
+	acks[0] = 0;
+	acks[1] = 0;
+	acks[2] = 10.0;
+	acks[3] = 0;
+	lease = rdb_raft_lease_expiry(acks, 4, timeout);
+	D_ASSERTF(lease == 0, "%f\n", lease);
+
+	D_WARN("lease granted by a majority of acks\n");
+	acks[0] = 0;
+	acks[1] = 10.0;
+	lease = rdb_raft_lease_expiry(acks, 2, timeout);
+	D_ASSERTF(lease > 10.0 && lease <= 10.0 + timeout, "%f\n", lease);
+	acks[0] = 10.0;
+	acks[1] = 10.0;
+	acks[2] = 10.0;
+	acks[3] = 10.0;
+	lease = rdb_raft_lease_expiry(acks, 4, timeout);
+	D_ASSERTF(lease > 10.0 && lease <= 10.0 + timeout, "%f\n", lease);
+	lease_old = lease;
+
+	D_WARN("lease expires after losing a majority\n");
+	acks[0] = 10.0;
+	acks[1] = 20.0;
+	acks[2] = 10.0;
+	acks[3] = 10.0;
+	lease = rdb_raft_lease_expiry(acks, 4, timeout);
+	D_ASSERTF(lease == lease_old, "%f == %f\n", lease, lease_old);
+	D_ASSERTF(20.0 >= lease, "%f\n", lease);
+	acks[0] = 10.0;
+	acks[1] = 20.0;
+	acks[2] = 10.0;
+	acks[3] = 20.0;
+	lease = rdb_raft_lease_expiry(acks, 4, timeout);
+	D_ASSERTF(lease > 20.0 && lease <= 20.0 + timeout, "%f\n", lease);
+
+	D_WARN("reject votes while the leader may hold its lease\n");
+	D_ASSERT(!rdb_raft_vote_blocked(0 /* leader_contact */, timeout,
+					10.0));
+	D_ASSERT(rdb_raft_vote_blocked(10.0, timeout, 10.0));
+	D_ASSERT(rdb_raft_vote_blocked(10.0, timeout, 10.0 + timeout / 2));
+	D_ASSERT(!rdb_raft_vote_blocked(10.0, timeout, 10.0 + timeout));
+	/*
+	 * A follower that acknowledged an AE sent at 10.0 heard from the
+	 * leader no earlier than that, so it rejects votes until the lease
+	 * granted by its ack has expired.
+	 */
+	acks[0] = 10.0;
+	acks[1] = 0;
+	lease = rdb_raft_lease_expiry(acks, 2, timeout);
+	D_ASSERT(rdb_raft_vote_blocked(10.0, timeout, lease));
+}
+
 struct rdbt_test_path_arg {
 	int		n;
 	daos_iov_t     *keys;
@@ -230,6 +295,12 @@ rdbt_test_tx(bool update)
 	rdb_tx_end(&tx);
 
 	if (update) {
+		struct rdb_stat	stat;
+		uint64_t	commits;
+
+		rdb_get_stat(rdb_db, &stat);
+		commits = stat.rs_commits;
+
 		D_WARN("create KVSs and regular keys\n");
 		MUST(rdb_tx_begin(rdb_db, RDB_NIL_TERM, &tx));
 		/* Create the root KVS. */
@@ -255,6 +326,13 @@ rdbt_test_tx(bool update)
 		/* Commit. */
 		MUST(rdb_tx_commit(&tx));
 		rdb_tx_end(&tx);
+
+		/* The update TX is counted. */
+		rdb_get_stat(rdb_db, &stat);
+		D_ASSERTF(stat.rs_commits == commits + 1, DF_U64" == "DF_U64
+			  " + 1\n", stat.rs_commits, commits);
+		D_ASSERT(stat.rs_batches > 0 && stat.rs_batch_max > 0);
+		D_ASSERT(stat.rs_entries >= stat.rs_batches);
 	}
 
 	D_WARN("query regular keys\n");
@@ -413,6 +491,7 @@ rdbt_test_handler(crt_rpc_t *rpc)
 	D_ASSERTF(rc == 0, "%d\n", rc);
 	D_WARN("testing rank %u: update=%d\n", rank, in->tti_update);
 	rdbt_test_util();
+	rdbt_test_lease();
 	rdbt_test_path();
 	rdbt_test_tx(in->tti_update);
 	crt_reply_send(rpc);
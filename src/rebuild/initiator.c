@@ -348,11 +348,18 @@ rebuild_rdone(struct rebuild_tgt_pool_tracker *rpt,
 	/* DAOS_REBUILD_TGT_NO_REBUILD are for testing purpose */
 	if ((data_size > 0 || data_size == (daos_size_t)(-1)) &&
 	    !DAOS_FAIL_CHECK(DAOS_REBUILD_NO_REBUILD)) {
-		if (data_size < MAX_BUF_SIZE || data_size == (daos_size_t)(-1))
+		/* Data packed by the enumeration does not need to be fetched
+		 * again, no matter how large it is.
+		 */
+		if (rdone->ro_sgls != NULL || data_size < MAX_BUF_SIZE ||
+		    data_size == (daos_size_t)(-1))
 			rc = rebuild_fetch_update_inline(rdone, oh,
 							 rebuild_cont);
 		else
 			rc = rebuild_fetch_update_bulk(rdone, oh, rebuild_cont);
+
+		if (rc == 0 && data_size != (daos_size_t)(-1))
+			tls->rebuild_pool_size += data_size;
 	}
 
 	tls->rebuild_pool_rec_count += rdone->ro_rec_num;
@@ -413,94 +420,96 @@ rebuild_one_ult(void *arg)
 	D_ASSERT(rpt->rt_pullers != NULL);
 	idx = dss_get_module_info()->dmi_tid;
 	puller = &rpt->rt_pullers[idx];
-	puller->rp_ult_running = 1;
 	while (1) {
-		struct rebuild_one	*rdone;
-		struct rebuild_one	*tmp;
-		d_list_t		rebuild_list;
+		struct rebuild_one	*rdone = NULL;
 		int			rc = 0;
 
-		D_INIT_LIST_HEAD(&rebuild_list);
+		/* Take one dkey at a time, so the other puller ULTs of this
+		 * xstream can pull from the list while this one is waiting
+		 * for its fetch.
+		 */
 		ABT_mutex_lock(puller->rp_lock);
-		d_list_for_each_entry_safe(rdone, tmp, &puller->rp_one_list,
-					   ro_list) {
-			d_list_move_tail(&rdone->ro_list, &rebuild_list);
+		if (!d_list_empty(&puller->rp_one_list)) {
+			rdone = d_list_entry(puller->rp_one_list.next,
+					     struct rebuild_one, ro_list);
+			d_list_del_init(&rdone->ro_list);
+			D_ASSERT(puller->rp_queued > 0);
+			puller->rp_queued--;
 			puller->rp_inflight++;
+		} else if (rpt->rt_finishing) {
+			/* check if it should exist */
+			ABT_mutex_unlock(puller->rp_lock);
+			break;
 		}
+		/* XXX exist if rebuild is aborted */
 		ABT_mutex_unlock(puller->rp_lock);
 
-		d_list_for_each_entry_safe(rdone, tmp, &rebuild_list, ro_list) {
-			d_list_del_init(&rdone->ro_list);
-			if (!rpt->rt_abort) {
-				rc = rebuild_rdone(rpt, rdone);
-				D_DEBUG(DB_REBUILD, DF_UOID" rebuild dkey %d %s"
-					" rc %d tag %d rpt %p\n",
-					DP_UOID(rdone->ro_oid),
-					(int)rdone->ro_dkey.iov_len,
-					(char *)rdone->ro_dkey.iov_buf, rc,
-					idx, rpt);
-			}
+		if (rdone == NULL) {
+			ABT_thread_yield();
+			continue;
+		}
 
+		if (!rpt->rt_abort) {
+			rc = rebuild_rdone(rpt, rdone);
+			D_DEBUG(DB_REBUILD, DF_UOID" rebuild dkey %d %s rc %d"
+				" tag %d rpt %p\n", DP_UOID(rdone->ro_oid),
+				(int)rdone->ro_dkey.iov_len,
+				(char *)rdone->ro_dkey.iov_buf, rc, idx, rpt);
+		}
+
+		if (rc == -DER_NOSPACE) {
+			/* If there are no space on current VOS, let's
+			 * hang the rebuild ULT on the current xstream,
+			 * and waitting for the space is reclaimed or
+			 * the drive is replaced.
+			 *
+			 * If the space is reclaimed, then it will
+			 * resume the rebuild ULT.
+			 * If the drive is replaced, then it will
+			 * abort the current rebuild by other process.
+			 */
+			rebuild_hang();
+			ABT_thread_yield();
+			D_DEBUG(DB_REBUILD, "%p rebuild got back.\n", rpt);
+			/* Added it back to rdone */
+			ABT_mutex_lock(puller->rp_lock);
+			d_list_add_tail(&rdone->ro_list, &puller->rp_one_list);
+			puller->rp_queued++;
 			D_ASSERT(puller->rp_inflight > 0);
 			puller->rp_inflight--;
+			ABT_mutex_unlock(puller->rp_lock);
+			continue;
+		}
 
-			if (rc == -DER_NOSPACE) {
-				/* If there are no space on current VOS, let's
-				 * hang the rebuild ULT on the current xstream,
-				 * and waitting for the space is reclaimed or
-				 * the drive is replaced.
-				 *
-				 * If the space is reclaimed, then it will
-				 * resume the rebuild ULT.
-				 * If the drive is replaced, then it will
-				 * abort the current rebuild by other process.
-				 */
-				rebuild_hang();
-				ABT_thread_yield();
-				D_DEBUG(DB_REBUILD, "%p rebuild got back.\n",
-					rpt);
-				rc = 0;
-				/* Added it back to rdone */
-				ABT_mutex_lock(puller->rp_lock);
-				d_list_add_tail(&rdone->ro_list,
-						&puller->rp_one_list);
-				ABT_mutex_unlock(puller->rp_lock);
-				continue;
-			}
-
-			/* Ignore nonexistent error because puller could race
-			 * with user's container destroy:
-			 * - puller got the container+oid from a remote scanner
-			 * - user destroyed the container
-			 * - puller try to open container or pulling data
-			 *   (nonexistent)
-			 * This is just a workaround...
-			 */
-			if (tls->rebuild_pool_status == 0 && rc != 0 &&
-			    rc != -DER_NONEXIST) {
-				tls->rebuild_pool_status = rc;
-				rpt->rt_abort = 1;
-			}
-			/* XXX If rebuild fails, Should we add this back to
-			 * dkey list
-			 */
-			rebuild_one_destroy(rdone);
+		/* Ignore nonexistent error because puller could race
+		 * with user's container destroy:
+		 * - puller got the container+oid from a remote scanner
+		 * - user destroyed the container
+		 * - puller try to open container or pulling data
+		 *   (nonexistent)
+		 * This is just a workaround...
+		 */
+		if (tls->rebuild_pool_status == 0 && rc != 0 &&
+		    rc != -DER_NONEXIST) {
+			tls->rebuild_pool_status = rc;
+			rpt->rt_abort = 1;
 		}
+		/* XXX If rebuild fails, Should we add this back to
+		 * dkey list
+		 */
+		rebuild_one_destroy(rdone);
 
-		/* check if it should exist */
 		ABT_mutex_lock(puller->rp_lock);
-		if (d_list_empty(&puller->rp_one_list) && rpt->rt_finishing) {
-			ABT_mutex_unlock(puller->rp_lock);
-			break;
-		}
-		/* XXX exist if rebuild is aborted */
+		D_ASSERT(puller->rp_inflight > 0);
+		puller->rp_inflight--;
 		ABT_mutex_unlock(puller->rp_lock);
-		ABT_thread_yield();
 	}
 
 	ABT_mutex_lock(puller->rp_lock);
-	ABT_cond_signal(puller->rp_fini_cond);
-	puller->rp_ult_running = 0;
+	D_ASSERT(puller->rp_ult_running > 0);
+	puller->rp_ult_running--;
+	if (puller->rp_ult_running == 0)
+		ABT_cond_signal(puller->rp_fini_cond);
 	ABT_mutex_unlock(puller->rp_lock);
 	rpt_put(rpt);
 }
@@ -677,22 +686,6 @@ rebuild_one_queue(struct rebuild_iter_obj_arg *iter_arg, daos_unit_oid_t *oid,
 	rdone->ro_version = version;
 	uuid_copy(rdone->ro_cookie, cookie);
 	puller = &rpt->rt_pullers[iter_arg->tgt_idx];
-	if (puller->rp_ult == NULL) {
-		/* Create puller ULT thread, and destroy ULT until
-		 * rebuild finish in rebuild_fini().
-		 */
-		D_ASSERT(puller->rp_ult_running == 0);
-		D_DEBUG(DB_REBUILD, "create rebuild dkey ult %d\n",
-			iter_arg->tgt_idx);
-		rpt_get(rpt);
-		rc = dss_rebuild_ult_create(rebuild_one_ult, rpt,
-					    iter_arg->tgt_idx,
-					    PULLER_STACK_SIZE, &puller->rp_ult);
-		if (rc) {
-			rpt_put(rpt);
-			D_GOTO(free, rc);
-		}
-	}
 
 	D_INIT_LIST_HEAD(&rdone->ro_list);
 	rc = daos_iov_copy(&rdone->ro_dkey, dkey);
@@ -708,8 +701,40 @@ rebuild_one_queue(struct rebuild_iter_obj_arg *iter_arg, daos_unit_oid_t *oid,
 		rdone->ro_max_eph, rdone->ro_iod_num);
 
 	ABT_mutex_lock(puller->rp_lock);
-	d_list_add_tail(&rdone->ro_list, &puller->rp_one_list);
+	/* Create puller ULTs, and destroy them until rebuild finish in
+	 * rebuild_fini().
+	 */
+	while (puller->rp_ult_nr < rebuild_gst.rg_puller_ults) {
+		D_DEBUG(DB_REBUILD, "create rebuild dkey ult %d/%u\n",
+			iter_arg->tgt_idx, puller->rp_ult_nr);
+		rpt_get(rpt);
+		rc = dss_rebuild_ult_create(rebuild_one_ult, rpt,
+				iter_arg->tgt_idx, PULLER_STACK_SIZE,
+				&puller->rp_ults[puller->rp_ult_nr]);
+		if (rc) {
+			rpt_put(rpt);
+			break;
+		}
+		puller->rp_ult_nr++;
+		puller->rp_ult_running++;
+	}
+
+	/* At least one puller is needed to drain the list */
+	if (puller->rp_ult_nr > 0) {
+		d_list_add_tail(&rdone->ro_list, &puller->rp_one_list);
+		puller->rp_queued++;
+		rc = 0;
+	}
 	ABT_mutex_unlock(puller->rp_lock);
+	if (rc)
+		D_GOTO(free, rc);
+
+	/* Throttle the enumeration until the pullers catch up, so the queued
+	 * dkeys and their inline data do not grow without bound.
+	 */
+	while (puller->rp_queued >= rebuild_gst.rg_puller_queue_max &&
+	       !rpt->rt_abort)
+		ABT_thread_yield();
 
 free:
 	if (rc != 0 && rdone != NULL)
@@ -755,8 +780,11 @@ rebuild_obj_punch(struct rebuild_iter_obj_arg *arg)
 	return dss_task_collective(rebuild_obj_punch_one, arg);
 }
 
-#define KDS_NUM		16
-#define ITER_BUF_SIZE   2048
+/* The enumeration buffer is large enough to carry the inline data of a
+ * batch of small dkeys, see OBJ_REBUILD_INLINE_THRES.
+ */
+#define KDS_NUM		128
+#define ITER_BUF_SIZE   (64 << 10)
 
 /**
  * Iterate akeys/dkeys of the object
@@ -765,23 +793,18 @@ static void
 rebuild_obj_ult(void *data)
 {
 	struct rebuild_iter_obj_arg	*arg = data;
-	struct rebuild_pool_tls		*tls;
+	struct rebuild_puller		*puller;
 	daos_anchor_t			 anchor;
 	daos_anchor_t			 dkey_anchor;
 	daos_anchor_t			 akey_anchor;
 	daos_handle_t			 oh;
 	daos_sg_list_t			 sgl = { 0 };
 	daos_iov_t			 iov = { 0 };
-	char				 stack_buf[ITER_BUF_SIZE];
 	char				*buf = NULL;
 	daos_size_t			 buf_len;
 	struct dss_enum_arg		 enum_arg;
 	int				 rc;
 
-	tls = rebuild_pool_tls_lookup(arg->rpt->rt_pool_uuid,
-				      arg->rpt->rt_rebuild_ver);
-	D_ASSERT(tls != NULL);
-
 	if (arg->epoch != DAOS_EPOCH_MAX) {
 		rc = rebuild_obj_punch(arg);
 		if (rc)
@@ -805,8 +828,11 @@ rebuild_obj_ult(void *data)
 	enum_arg.param.ip_oid = arg->oid;
 	enum_arg.recursive = true;
 
-	buf = stack_buf;
 	buf_len = ITER_BUF_SIZE;
+	D_ALLOC(buf, buf_len);
+	if (buf == NULL)
+		D_GOTO(close, rc = -DER_NOMEM);
+
 	while (1) {
 		daos_key_desc_t	kds[KDS_NUM] = { 0 };
 		daos_epoch_range_t eprs[KDS_NUM];
@@ -831,8 +857,7 @@ rebuild_obj_ult(void *data)
 				"-DER_KEY2BIG, key_len "DF_U64"\n",
 				DP_UOID(arg->oid), kds[0].kd_key_len);
 			buf_len = roundup(kds[0].kd_key_len * 2, 8);
-			if (buf != stack_buf)
-				D_FREE(buf);
+			D_FREE(buf);
 			D_ALLOC(buf, buf_len);
 			if (buf == NULL) {
 				rc = -DER_NOMEM;
@@ -872,15 +897,26 @@ rebuild_obj_ult(void *data)
 			break;
 	}
 
+close:
 	ds_obj_close(oh);
 free:
-	if (buf != NULL && buf != stack_buf)
+	if (buf != NULL)
 		D_FREE(buf);
-	tls->rebuild_pool_obj_count++;
-	if (tls->rebuild_pool_status == 0 && rc < 0)
-		tls->rebuild_pool_status = rc;
+	/* This ULT can be stolen by another xstream, so charge the puller of
+	 * the target instead of the TLS of the xstream running it.
+	 */
+	puller = &arg->rpt->rt_pullers[arg->tgt_idx];
+	ABT_mutex_lock(puller->rp_lock);
+	puller->rp_obj_count++;
+	if (puller->rp_obj_status == 0 && rc < 0)
+		puller->rp_obj_status = rc;
+	ABT_mutex_unlock(puller->rp_lock);
 	D_DEBUG(DB_REBUILD, "stop rebuild obj "DF_UOID" for shard %u rc %d\n",
 		DP_UOID(arg->oid), arg->shard, rc);
+	ABT_mutex_lock(arg->rpt->rt_lock);
+	D_ASSERT(arg->rpt->rt_obj_inflight > 0);
+	arg->rpt->rt_obj_inflight--;
+	ABT_mutex_unlock(arg->rpt->rt_lock);
 	rpt_put(arg->rpt);
 	D_FREE(arg);
 }
@@ -908,11 +944,19 @@ rebuild_obj_callback(daos_unit_oid_t oid, daos_epoch_t eph, unsigned int shard,
 	obj_arg->rpt = iter_arg->rpt;
 	obj_arg->rpt->rt_toberb_objs++;
 
-	/* Let's iterate the object on different xstream */
+	/* Let's iterate the object on different xstream, the object is
+	 * enumerated from the remote replicas, so idle xstreams can steal it.
+	 */
 	stream_id = oid.id_pub.lo % dss_get_threads_number();
-	rc = dss_rebuild_ult_create(rebuild_obj_ult, obj_arg, stream_id,
-				    PULLER_STACK_SIZE, NULL);
+	ABT_mutex_lock(obj_arg->rpt->rt_lock);
+	obj_arg->rpt->rt_obj_inflight++;
+	ABT_mutex_unlock(obj_arg->rpt->rt_lock);
+	rc = dss_steal_ult_create(rebuild_obj_ult, obj_arg, stream_id,
+				  PULLER_STACK_SIZE, NULL);
 	if (rc) {
+		ABT_mutex_lock(obj_arg->rpt->rt_lock);
+		obj_arg->rpt->rt_obj_inflight--;
+		ABT_mutex_unlock(obj_arg->rpt->rt_lock);
 		rpt_put(iter_arg->rpt);
 		D_FREE(obj_arg);
 	}
@@ -921,6 +965,14 @@ rebuild_obj_callback(daos_unit_oid_t oid, daos_epoch_t eph, unsigned int shard,
 }
 
 #define DEFAULT_YIELD_FREQ			128
+
+static inline bool
+rebuild_obj_throttled(struct rebuild_tgt_pool_tracker *rpt)
+{
+	return rpt->rt_obj_inflight >= rebuild_gst.rg_obj_inflight_max &&
+	       !rpt->rt_abort;
+}
+
 static int
 puller_obj_iter_cb(daos_handle_t ih, daos_iov_t *key_iov,
 		   daos_iov_t *val_iov, void *data)
@@ -958,9 +1010,14 @@ puller_obj_iter_cb(daos_handle_t ih, daos_iov_t *key_iov,
 		if (rc)
 			return rc;
 
-		if (arg->yield_freq == 0) {
+		if (arg->yield_freq == 0 || rebuild_obj_throttled(rpt)) {
 			arg->yield_freq = DEFAULT_YIELD_FREQ;
-			ABT_thread_yield();
+			/* Bound the object ULTs in flight, each of them holds
+			 * a stack and an enumeration buffer.
+			 */
+			do {
+				ABT_thread_yield();
+			} while (rebuild_obj_throttled(rpt));
 			arg->yielded = true;
 			if (arg->cont_root->count > arg->obj_cnt) {
 				arg->obj_cnt = arg->cont_root->count;
@@ -1313,9 +1370,9 @@ rebuild_obj_handler(crt_rpc_t *rpc)
 	shards = rebuild_in->roi_shards.ca_arrays;
 	shards_count = rebuild_in->roi_shards.ca_count;
 
-	if (co_count == 0 || oids_count == 0 || shards_count == 0 ||
-	    ephs_count == 0 || oids_count != co_count ||
-	    oids_count != shards_count || oids_count != ephs_count) {
+	/* An empty list only probes the incarnation of the initiator */
+	if (oids_count != co_count || oids_count != shards_count ||
+	    oids_count != ephs_count) {
 		D_ERROR("oids %u cont %u shards %u ephs %d\n",
 			oids_count, co_count, shards_count, ephs_count);
 		D_GOTO(out, rc = -DER_INVAL);
@@ -1335,6 +1392,9 @@ rebuild_obj_handler(crt_rpc_t *rpc)
 	if (rpt == NULL || rpt->rt_pool == NULL)
 		D_GOTO(out, rc = -DER_AGAIN);
 
+	if (oids_count == 0)
+		D_GOTO(out, rc = 0);
+
 	/* Initialize the local rebuild tree */
 	rc = rebuild_btr_hdl_get(rpt, &btr_hdl, &rebuilt_btr_hdl);
 	if (rc)
@@ -1419,9 +1479,11 @@ rebuild_obj_handler(crt_rpc_t *rpc)
 		}
 	}
 out:
-	if (rpt)
-		rpt_put(rpt);
 	rebuild_out = crt_reply_get(rpc);
 	rebuild_out->roo_status = rc;
+	if (rpt) {
+		rebuild_out->roo_incarnation = rpt->rt_incarnation;
+		rpt_put(rpt);
+	}
 	dss_rpc_reply(rpc, DAOS_REBUILD_DROP_OBJ);
 }
@@ -56,12 +56,21 @@ struct rebuild_one {
 
 struct rebuild_puller {
 	unsigned int	rp_inflight;
-	ABT_thread	rp_ult;
+	/** # rebuild_one queued on rp_one_list */
+	unsigned int	rp_queued;
+	/** puller ULTs of this xstream, rebuild_gst.rg_puller_ults of them */
+	ABT_thread	*rp_ults;
+	unsigned int	rp_ult_nr;
+	/** # puller ULTs still running */
+	unsigned int	rp_ult_running;
 	ABT_mutex	rp_lock;
 	/** serialize initialization of ULTs */
 	ABT_cond	rp_fini_cond;
 	d_list_t	rp_one_list;
-	unsigned int	rp_ult_running:1;
+	/** # objects enumerated for this xstream, see rebuild_obj_ult() */
+	uint64_t	rp_obj_count;
+	/** first error of the object enumeration */
+	int		rp_obj_status;
 };
 
 struct rebuild_obj_key {
@@ -107,6 +116,10 @@ struct rebuild_tgt_pool_tracker {
 	int			rt_errno;
 	int			rt_refcount;
 	uint64_t		rt_leader_term;
+	/* changes each time the tracker is created, e.g. after a restart, so
+	 * the scanners can tell whether the objects they sent are lost.
+	 */
+	uint64_t		rt_incarnation;
 	ABT_cond		rt_fini_cond;
 	/* # to-be-rebuilt objs */
 	uint64_t		rt_toberb_objs;
@@ -114,6 +127,9 @@ struct rebuild_tgt_pool_tracker {
 	/* reported # rebuilt objs */
 	uint64_t		rt_reported_obj_cnt;
 	uint64_t		rt_reported_rec_cnt;
+	uint64_t		rt_reported_size;
+	/* # object ULTs in flight, bounded by rg_obj_inflight_max */
+	unsigned int		rt_obj_inflight;
 
 	unsigned int		rt_lead_puller_running:1,
 				rt_abort:1,
@@ -122,7 +138,12 @@ struct rebuild_tgt_pool_tracker {
 				rt_finishing:1,
 				rt_scan_done:1,
 				rt_global_scan_done:1,
-				rt_global_done:1;
+				rt_global_done:1,
+				/* scan leader is running, and it should
+				 * rescan from the checkpoints once done.
+				 */
+				rt_scanning:1,
+				rt_rescan:1;
 };
 
 /* Track the rebuild status globally */
@@ -174,6 +195,13 @@ struct rebuild_status_completed {
 	uuid_t				rsc_pool_uuid;
 };
 
+/* Default # puller ULTs per xstream, see DAOS_REBUILD_PULLERS */
+#define REBUILD_PULLER_ULTS		4
+/* Default max # queued dkeys per xstream, see DAOS_REBUILD_QUEUE_MAX */
+#define REBUILD_PULLER_QUEUE_MAX	1024
+/* Default max # object ULTs in flight, see DAOS_REBUILD_OBJ_INFLIGHT */
+#define REBUILD_OBJ_INFLIGHT_MAX	256
+
 /* Structure on all targets to track all pool rebuilding */
 struct rebuild_global {
 	/* Link rebuild_tgt_pool_tracker on all targets.
@@ -206,6 +234,12 @@ struct rebuild_global {
 	ABT_cond	rg_stop_cond;
 	/* how many pools is being rebuilt */
 	unsigned int	rg_inflight;
+	/* # puller ULTs per xstream */
+	unsigned int	rg_puller_ults;
+	/* max # dkeys queued per xstream before enumeration is throttled */
+	unsigned int	rg_puller_queue_max;
+	/* max # object enumeration ULTs in flight per pool */
+	unsigned int	rg_obj_inflight_max;
 	unsigned int	rg_rebuild_running:1,
 			rg_abort:1;
 };
@@ -230,8 +264,8 @@ struct rebuild_pool_tls {
 	uuid_t		rebuild_coh_uuid;
 	daos_handle_t	rebuild_pool_hdl;
 	d_list_t	rebuild_pool_list;
-	uint64_t	rebuild_pool_obj_count;
 	uint64_t	rebuild_pool_rec_count;
+	uint64_t	rebuild_pool_size;
 	unsigned int	rebuild_pool_ver;
 	int		rebuild_pool_status;
 	unsigned int	rebuild_pool_scanning:1;
@@ -254,6 +288,7 @@ struct rebuild_tgt_query_info {
 	int status;
 	uint64_t rec_count;
 	uint64_t obj_count;
+	uint64_t size;
 	bool rebuilding;
 	ABT_mutex lock;
 };
@@ -263,6 +298,7 @@ struct rebuild_iv {
 	uint64_t	riv_toberb_obj_count;
 	uint64_t	riv_obj_count;
 	uint64_t	riv_rec_count;
+	uint64_t	riv_size;
 	uint64_t	riv_leader_term;
 	unsigned int	riv_rank;
 	unsigned int	riv_master_rank;
@@ -292,6 +328,7 @@ void rebuild_pool_map_put(struct pool_map *map);
 
 void rebuild_obj_handler(crt_rpc_t *rpc);
 void rebuild_tgt_scan_handler(crt_rpc_t *rpc);
+void rebuild_scan_ckpt_remove(uuid_t pool_uuid);
 int rebuild_tgt_scan_aggregator(crt_rpc_t *source, crt_rpc_t *result,
 				void *priv);
 
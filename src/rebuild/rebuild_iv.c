@@ -138,6 +138,7 @@ rebuild_iv_ent_update(struct ds_iv_entry *entry, d_sg_list_t *dst,
 				src_iv->riv_toberb_obj_count;
 			rgt->rgt_status.rs_obj_nr += src_iv->riv_obj_count;
 			rgt->rgt_status.rs_rec_nr += src_iv->riv_rec_count;
+			rgt->rgt_status.rs_size += src_iv->riv_size;
 		}
 
 		rebuild_global_status_update(rgt, src_iv);
@@ -207,6 +208,7 @@ rebuild_iv_ent_refresh(d_sg_list_t *dst, d_sg_list_t *src, int ref_rc,
 			rs.rs_done	= 1;
 			rs.rs_obj_nr	= src_iv->riv_obj_count;
 			rs.rs_rec_nr	= src_iv->riv_rec_count;
+			rs.rs_size	= src_iv->riv_size;
 			rs.rs_toberb_obj_nr	=
 				src_iv->riv_toberb_obj_count;
 
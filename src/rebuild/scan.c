@@ -28,12 +28,15 @@
  */
 #define D_LOGFAC	DD_FAC(rebuild)
 
+#include <fcntl.h>
+#include <unistd.h>
 #include <daos_srv/pool.h>
 
 #include <daos/btree_class.h>
 #include <daos/pool_map.h>
 #include <daos/pool.h>
 #include <daos/rpc.h>
+#include <daos/object.h>
 #include <daos/placement.h>
 #include <daos_srv/container.h>
 #include <daos_srv/daos_mgmt_srv.h>
@@ -45,58 +48,102 @@
 
 #define REBUILD_SEND_LIMIT	512
 struct rebuild_send_arg {
-	struct rebuild_root *tgt_root;
-	daos_unit_oid_t	    *oids;
-	daos_epoch_t	    *ephs;
-	uuid_t		    *uuids;
-	unsigned int	    *shards;
-	uuid_t		    current_uuid;
-	int		    count;
+	struct rebuild_root	*tgt_root;
+	daos_unit_oid_t		*oids;
+	daos_epoch_t		*ephs;
+	uuid_t			*uuids;
+	unsigned int		*shards;
+	/* keys of the objects collected from the current container */
+	struct rebuild_obj_key	*keys;
+	uuid_t			current_uuid;
+	int			count;
+	int			key_count;
 };
 
+/* Shared by the scanners of all xstreams */
 struct rebuild_scan_arg {
-	daos_handle_t		rebuild_tree_hdl;
 	struct rebuild_tgt_pool_tracker *rpt;
-	ABT_mutex		scan_lock;
 	int			rebuild_tgt_nr;
 };
 
+#define REBUILD_CKPT_FILE	"rebuild-ckpt"
+#define REBUILD_CKPT_MAGIC	0x7eb1dc4c
+/* # objects scanned between two checkpoints */
+#define REBUILD_CKPT_INTV	(REBUILD_SEND_LIMIT * 8)
+
+/*
+ * Scan progress of a xstream, which is stored in a file of the pool target
+ * directory and followed by the UUIDs of the fully scanned containers, then
+ * by the initiators the objects were sent to. It is only written after all
+ * the objects scanned before it have been sent to the rebuild initiators, so
+ * a restarted scan can resume from it without missing any object, as long as
+ * none of these initiators has been restarted since.
+ */
+struct rebuild_scan_ckpt {
+	uint32_t	rsc_magic;
+	uint32_t	rsc_rebuild_ver;
+	/* # fully scanned containers */
+	uint32_t	rsc_done_nr;
+	/* # initiators */
+	uint32_t	rsc_tgt_nr;
+	/* the container being scanned, and where to resume it */
+	uuid_t		rsc_cont;
+	daos_anchor_t	rsc_anchor;
+};
+
+/* Initiator which has been sent objects, see rebuild_tgt_pool_tracker */
+struct rebuild_ckpt_tgt {
+	uint32_t	rct_tgt_id;
+	uint32_t	rct_padding;
+	uint64_t	rct_incarnation;
+};
+
+/*
+ * Per-xstream scanner, each of them owns its object tree and sends its own
+ * batches, so the scanners of different xstreams do not contend on a lock.
+ */
+struct rebuild_scanner_arg {
+	struct rebuild_scan_arg	*scan_arg;
+	daos_handle_t		tree_hdl;
+	d_rank_t		myrank;
+	/* the last checked object and its rebuild targets */
+	daos_obj_id_t		last_oid;
+	unsigned int		*tgts;
+	unsigned int		*shards;
+	int			rebuild_nr;
+	/* # objects scanned since the last checkpoint */
+	unsigned int		scanned;
+	/* container being scanned */
+	uuid_t			cur_cont;
+	struct rebuild_scan_ckpt ckpt;
+	uuid_t			*done_conts;
+	unsigned int		done_cap;
+	struct rebuild_ckpt_tgt	*ckpt_tgts;
+	unsigned int		tgt_cap;
+};
+
 static int
 rebuild_obj_fill_buf(daos_handle_t ih, daos_iov_t *key_iov,
 		     daos_iov_t *val_iov, void *data)
 {
 	struct rebuild_send_arg *arg = data;
-	struct rebuild_root	*root = arg->tgt_root;
 	daos_unit_oid_t		*oids = arg->oids;
 	daos_epoch_t		*ephs = arg->ephs;
 	struct rebuild_obj_key	*key = key_iov->iov_buf;
 	uuid_t			*uuids = arg->uuids;
 	unsigned int		*shards = arg->shards;
 	int			count = arg->count;
-	int			rc;
 
 	D_ASSERT(count < REBUILD_SEND_LIMIT);
 	oids[count] = key->oid;
 	ephs[count] = key->eph;
 	shards[count] = *((unsigned int *)val_iov->iov_buf);
 	uuid_copy(uuids[count], arg->current_uuid);
+	arg->keys[arg->key_count++] = *key;
 	arg->count++;
 
-	rc = dbtree_iter_delete(ih, NULL);
-	if (rc != 0)
-		return rc;
-
-	D_ASSERT(root->count > 0);
-	root->count--;
-
-	D_DEBUG(DB_REBUILD, "send oid/con "DF_UOID"/"DF_UUID" cnt %d"
-		" left %d\n", DP_UOID(oids[count]), DP_UUID(arg->current_uuid),
-		arg->count, root->count);
-
-	/* re-probe the dbtree after delete */
-	rc = dbtree_iter_probe(ih, BTR_PROBE_FIRST, NULL, NULL);
-	if (rc == -DER_NONEXIST)
-		return 1;
+	D_DEBUG(DB_REBUILD, "send oid/con "DF_UOID"/"DF_UUID" cnt %d\n",
+		DP_UOID(oids[count]), DP_UUID(arg->current_uuid), arg->count);
 
 	/* Exist the loop, if there are enough objects to be sent */
 	if (arg->count >= REBUILD_SEND_LIMIT)
@@ -111,19 +158,34 @@ rebuild_cont_iter_cb(daos_handle_t ih, daos_iov_t *key_iov,
 {
 	struct rebuild_root *root = val_iov->iov_buf;
 	struct rebuild_send_arg *arg = data;
+	daos_iov_t obj_iov;
+	int i;
 	int rc;
 
 	uuid_copy(arg->current_uuid, *(uuid_t *)key_iov->iov_buf);
 
-	while (!dbtree_is_empty(root->root_hdl)) {
-		rc = dbtree_iterate(root->root_hdl, false, rebuild_obj_fill_buf,
-				    data);
-		if (rc < 0)
+	/* Collect the objects in one pass, then delete them from the tree,
+	 * so the tree does not have to be re-probed after each deletion.
+	 */
+	arg->key_count = 0;
+	rc = dbtree_iterate(root->root_hdl, false, rebuild_obj_fill_buf, data);
+	if (rc < 0)
+		return rc;
+
+	for (i = 0; i < arg->key_count; i++) {
+		daos_iov_set(&obj_iov, &arg->keys[i], sizeof(arg->keys[i]));
+		rc = dbtree_delete(root->root_hdl, &obj_iov, NULL);
+		if (rc != 0)
 			return rc;
 
-		/* Exist the loop, if there are enough objects to be sent */
-		if (arg->count >= REBUILD_SEND_LIMIT)
-			return 1;
+		D_ASSERT(arg->tgt_root->count > 0);
+		arg->tgt_root->count--;
+	}
+
+	/* Exist the loop, if there are enough objects to be sent */
+	if (!dbtree_is_empty(root->root_hdl)) {
+		D_ASSERT(arg->count >= REBUILD_SEND_LIMIT);
+		return 1;
 	}
 
 	/* Delete the current container tree */
@@ -136,52 +198,65 @@ rebuild_cont_iter_cb(daos_handle_t ih, daos_iov_t *key_iov,
 	if (rc == -DER_NONEXIST)
 		return 1;
 
+	if (rc == 0 && arg->count >= REBUILD_SEND_LIMIT)
+		return 1;
+
 	return rc;
 }
 
+static void
+rebuild_send_arg_free(struct rebuild_send_arg *arg)
+{
+	if (arg->oids != NULL)
+		D_FREE(arg->oids);
+	if (arg->uuids != NULL)
+		D_FREE(arg->uuids);
+	if (arg->shards != NULL)
+		D_FREE(arg->shards);
+	if (arg->ephs != NULL)
+		D_FREE(arg->ephs);
+	if (arg->keys != NULL)
+		D_FREE(arg->keys);
+	D_FREE(arg);
+}
+
+/**
+ * Move up to REBUILD_SEND_LIMIT objects out of the target tree into a send
+ * buffer, the caller should hold the scan lock.
+ */
 static int
-rebuild_objects_send(struct rebuild_root *root, unsigned int tgt_id,
-		     struct rebuild_scan_arg *scan_arg)
+rebuild_objects_collect(struct rebuild_root *root,
+			struct rebuild_send_arg **argp)
 {
-	struct rebuild_in	*rebuild_in = NULL;
-	struct rebuild_out	*rebuild_out = NULL;
-	struct rebuild_tgt_pool_tracker	*rpt = scan_arg->rpt;
-	struct pool_target	*target;
-	struct rebuild_send_arg *arg = NULL;
-	daos_unit_oid_t		*oids = NULL;
-	daos_epoch_t		*ephs = NULL;
-	uuid_t			*uuids = NULL;
-	unsigned int		*shards = NULL;
-	crt_rpc_t		*rpc = NULL;
-	crt_endpoint_t		tgt_ep = {0};
+	struct rebuild_send_arg *arg;
 	int			rc = 0;
 
 	D_ALLOC_PTR(arg);
 	if (arg == NULL)
 		return -DER_NOMEM;
 
-	D_ALLOC_ARRAY(oids, REBUILD_SEND_LIMIT);
-	if (oids == NULL)
+	D_ALLOC_ARRAY(arg->oids, REBUILD_SEND_LIMIT);
+	if (arg->oids == NULL)
 		D_GOTO(out, rc = -DER_NOMEM);
 
-	D_ALLOC_ARRAY(uuids, REBUILD_SEND_LIMIT);
-	if (uuids == NULL)
+	D_ALLOC_ARRAY(arg->uuids, REBUILD_SEND_LIMIT);
+	if (arg->uuids == NULL)
 		D_GOTO(out, rc = -DER_NOMEM);
 
-	D_ALLOC_ARRAY(shards, REBUILD_SEND_LIMIT);
-	if (shards == NULL)
+	D_ALLOC_ARRAY(arg->shards, REBUILD_SEND_LIMIT);
+	if (arg->shards == NULL)
 		D_GOTO(out, rc = -DER_NOMEM);
 
-	D_ALLOC_ARRAY(ephs, REBUILD_SEND_LIMIT);
-	if (ephs == NULL)
+	D_ALLOC_ARRAY(arg->ephs, REBUILD_SEND_LIMIT);
+	if (arg->ephs == NULL)
+		D_GOTO(out, rc = -DER_NOMEM);
+
+	D_ALLOC_ARRAY(arg->keys, REBUILD_SEND_LIMIT);
+	if (arg->keys == NULL)
 		D_GOTO(out, rc = -DER_NOMEM);
 
 	arg->tgt_root = root;
 	arg->count = 0;
-	arg->oids = oids;
-	arg->uuids = uuids;
-	arg->shards = shards;
-	arg->ephs = ephs;
 
 	while (!dbtree_is_empty(root->root_hdl)) {
 		rc = dbtree_iterate(root->root_hdl, false, rebuild_cont_iter_cb,
@@ -192,15 +267,45 @@ rebuild_objects_send(struct rebuild_root *root, unsigned int tgt_id,
 		if (arg->count >= REBUILD_SEND_LIMIT)
 			break;
 	}
+	rc = 0;
+out:
+	if (rc == 0)
+		*argp = arg;
+	else
+		rebuild_send_arg_free(arg);
+	return rc;
+}
 
-	if (arg->count == 0)
+/**
+ * Send the collected objects to the target, this could yield, so it should
+ * be called without the scan lock, i.e. other scanners can keep filling the
+ * tree while the batch is in flight.
+ *
+ * Without \a arg, only the incarnation of the target is probed, which is
+ * returned in \a incarnation, or 0 if the target has failed.
+ */
+static int
+rebuild_objects_send(struct rebuild_send_arg *arg, unsigned int tgt_id,
+		     struct rebuild_tgt_pool_tracker *rpt,
+		     uint64_t *incarnation)
+{
+	struct rebuild_in	*rebuild_in = NULL;
+	struct rebuild_out	*rebuild_out = NULL;
+	struct pool_target	*target;
+	crt_rpc_t		*rpc = NULL;
+	crt_endpoint_t		tgt_ep = {0};
+	unsigned int		count = arg != NULL ? arg->count : 0;
+	int			rc = 0;
+
+	*incarnation = 0;
+	if (arg != NULL && arg->count == 0)
 		D_GOTO(out, rc);
 
 	if (daos_fail_check(DAOS_REBUILD_TGT_SEND_OBJS_FAIL))
 		D_GOTO(out, rc = 0);
 
 	D_DEBUG(DB_REBUILD, "send rebuild objects "DF_UUID" to tgt %d"
-		" cnt %d\n", DP_UUID(rpt->rt_pool_uuid), tgt_id, arg->count);
+		" cnt %u\n", DP_UUID(rpt->rt_pool_uuid), tgt_id, count);
 
 	rc = pool_map_find_target(rpt->rt_pool->sp_map, tgt_id, &target);
 	D_ASSERT(rc == 1);
@@ -223,22 +328,26 @@ rebuild_objects_send(struct rebuild_root *root, unsigned int tgt_id,
 
 		rebuild_in = crt_req_get(rpc);
 		rebuild_in->roi_rebuild_ver = rpt->rt_rebuild_ver;
-		rebuild_in->roi_oids.ca_count = arg->count;
-		rebuild_in->roi_oids.ca_arrays = oids;
-		rebuild_in->roi_ephs.ca_count = arg->count;
-		rebuild_in->roi_ephs.ca_arrays = ephs;
-		rebuild_in->roi_uuids.ca_count = arg->count;
-		rebuild_in->roi_uuids.ca_arrays = uuids;
-		rebuild_in->roi_shards.ca_count = arg->count;
-		rebuild_in->roi_shards.ca_arrays = shards;
+		rebuild_in->roi_oids.ca_count = count;
+		rebuild_in->roi_ephs.ca_count = count;
+		rebuild_in->roi_uuids.ca_count = count;
+		rebuild_in->roi_shards.ca_count = count;
+		if (arg != NULL) {
+			rebuild_in->roi_oids.ca_arrays = arg->oids;
+			rebuild_in->roi_ephs.ca_arrays = arg->ephs;
+			rebuild_in->roi_uuids.ca_arrays = arg->uuids;
+			rebuild_in->roi_shards.ca_arrays = arg->shards;
+		}
 		uuid_copy(rebuild_in->roi_pool_uuid, rpt->rt_pool_uuid);
 		rebuild_in->roi_tgt_idx = target->ta_comp.co_index;
 
 		rc = dss_rpc_send(rpc);
 
 		rebuild_out = crt_reply_get(rpc);
-		if (rc == 0 && rebuild_out->roo_status == 0)
+		if (rc == 0 && rebuild_out->roo_status == 0) {
+			*incarnation = rebuild_out->roo_incarnation;
 			break;
+		}
 
 		/* If it is failed, but no need retry, let's just fail */
 		if ((rc != 0 && rc != -DER_TIMEDOUT &&
@@ -287,40 +396,128 @@ rebuild_objects_send(struct rebuild_root *root, unsigned int tgt_id,
 out:
 	if (rpc)
 		crt_req_decref(rpc);
-	if (oids != NULL)
-		D_FREE(oids);
-	if (uuids != NULL)
-		D_FREE(uuids);
-	if (shards != NULL)
-		D_FREE(shards);
-	if (ephs != NULL)
-		D_FREE(ephs);
-	if (arg != NULL)
-		D_FREE(arg);
 
 	return rc;
 }
 
+static int
+rebuild_ckpt_path(uuid_t pool_uuid, char **path)
+{
+	int idx = dss_get_module_info()->dmi_tid;
+
+	return ds_mgmt_tgt_file(pool_uuid, REBUILD_CKPT_FILE, &idx, path);
+}
+
+/* Remove the scan checkpoint of the current xstream */
+void
+rebuild_scan_ckpt_remove(uuid_t pool_uuid)
+{
+	char	*path;
+
+	if (rebuild_ckpt_path(pool_uuid, &path) != 0)
+		return;
+
+	if (unlink(path) != 0 && errno != ENOENT)
+		D_WARN("failed to remove %s: %d\n", path, errno);
+	D_FREE(path);
+}
+
+/**
+ * Forget the scan progress, the next checkpoint restarts the scan from
+ * scratch, and so does the stale one on reload, see rebuild_ckpt_load().
+ */
+static void
+rebuild_ckpt_discard(struct rebuild_scanner_arg *arg)
+{
+	memset(&arg->ckpt, 0, sizeof(arg->ckpt));
+	uuid_clear(arg->cur_cont);
+}
+
+/**
+ * Remember the initiator which has been sent objects, if it has been
+ * restarted since the objects sent before, these objects are lost, so
+ * the scan has to be restarted from scratch.
+ */
+static int
+rebuild_ckpt_tgt_add(struct rebuild_scanner_arg *arg, unsigned int tgt_id,
+		     uint64_t incarnation)
+{
+	struct rebuild_tgt_pool_tracker *rpt = arg->scan_arg->rpt;
+	struct rebuild_scan_ckpt	*ckpt = &arg->ckpt;
+	struct rebuild_ckpt_tgt		*tgt;
+	int				 i;
+
+	/* not sent, or the target has failed */
+	if (incarnation == 0)
+		return 0;
+
+	for (i = 0; i < ckpt->rsc_tgt_nr; i++) {
+		tgt = &arg->ckpt_tgts[i];
+		if (tgt->rct_tgt_id != tgt_id)
+			continue;
+
+		if (tgt->rct_incarnation != incarnation) {
+			D_DEBUG(DB_REBUILD, DF_UUID" tgt %u restarted, "
+				"rescan\n", DP_UUID(rpt->rt_pool_uuid),
+				tgt_id);
+			rebuild_ckpt_discard(arg);
+			ABT_mutex_lock(rpt->rt_lock);
+			rpt->rt_rescan = 1;
+			ABT_mutex_unlock(rpt->rt_lock);
+		}
+		return 0;
+	}
+
+	if (ckpt->rsc_tgt_nr == arg->tgt_cap) {
+		unsigned int	cap = max(arg->tgt_cap * 2, 8U);
+
+		D_REALLOC(tgt, arg->ckpt_tgts, cap * sizeof(*tgt));
+		if (tgt == NULL)
+			return -DER_NOMEM;
+
+		arg->ckpt_tgts = tgt;
+		arg->tgt_cap = cap;
+	}
+
+	tgt = &arg->ckpt_tgts[ckpt->rsc_tgt_nr++];
+	tgt->rct_tgt_id = tgt_id;
+	tgt->rct_padding = 0;
+	tgt->rct_incarnation = incarnation;
+	return 0;
+}
+
 static int
 rebuild_tgt_fini_obj_send_cb(daos_handle_t ih, daos_iov_t *key_iov,
 			     daos_iov_t *val_iov, void *data)
 {
+	struct rebuild_scanner_arg *arg = data;
 	struct rebuild_root *root;
-	struct rebuild_scan_arg *arg = data;
+	struct rebuild_send_arg *send_arg;
 	unsigned int tgt_id;
+	uint64_t incarnation;
 	int rc;
 
 	tgt_id = *((unsigned int *)key_iov->iov_buf);
 	root = val_iov->iov_buf;
 
-	/* This is called when scanning is done, so the objects
-	 * under each target should less than LIMIT. And also
-	 * only 1 thread accessing the tree, so no need lock.
+	/* This is called when the scanner flushes its tree, so the
+	 * objects under each target should less than LIMIT. And also
+	 * only the owner xstream accesses the tree, so no need lock.
 	 **/
-	rc = rebuild_objects_send(root, tgt_id, arg);
+	rc = rebuild_objects_collect(root, &send_arg);
 	if (rc < 0)
 		return rc;
 
+	rc = rebuild_objects_send(send_arg, tgt_id, arg->scan_arg->rpt,
+				  &incarnation);
+	rebuild_send_arg_free(send_arg);
+	if (rc < 0)
+		return rc;
+
+	rc = rebuild_ckpt_tgt_add(arg, tgt_id, incarnation);
+	if (rc)
+		return rc;
+
 	rc = dbtree_destroy(root->root_hdl);
 	if (rc)
 		return rc;
@@ -490,28 +687,27 @@ out:
  * target id.
  **/
 static int
-rebuild_object_insert(struct rebuild_scan_arg *arg, unsigned int tgt_id,
+rebuild_object_insert(struct rebuild_scanner_arg *arg, unsigned int tgt_id,
 		      unsigned int shard, uuid_t pool_uuid, uuid_t co_uuid,
 		      daos_unit_oid_t oid, daos_epoch_t epoch)
 {
 	daos_iov_t		key_iov;
 	daos_iov_t		val_iov;
 	struct rebuild_root	*tgt_root;
-	daos_handle_t		toh = arg->rebuild_tree_hdl;
+	struct rebuild_send_arg	*send_arg;
+	daos_handle_t		toh = arg->tree_hdl;
+	uint64_t		incarnation;
 	int			rc;
 
 	/* look up the target tree */
 	daos_iov_set(&key_iov, &tgt_id, sizeof(tgt_id));
 	daos_iov_set(&val_iov, NULL, 0);
-	ABT_mutex_lock(arg->scan_lock);
 	rc = dbtree_lookup(toh, &key_iov, &val_iov);
 	if (rc < 0) {
 		/* Try to find the target rebuild tree */
 		rc = rebuild_tgt_tree_create(toh, tgt_id, &tgt_root);
-		if (rc) {
-			ABT_mutex_unlock(arg->scan_lock);
+		if (rc)
 			D_GOTO(out, rc);
-		}
 	} else {
 		tgt_root = val_iov.iov_buf;
 	}
@@ -519,50 +715,379 @@ rebuild_object_insert(struct rebuild_scan_arg *arg, unsigned int tgt_id,
 	rc = rebuild_cont_obj_insert(tgt_root->root_hdl, co_uuid, oid, epoch,
 				     shard, tgt_id, NULL, 0,
 				     rebuild_obj_insert_cb);
-	if (rc <= 0) {
-		ABT_mutex_unlock(arg->scan_lock);
+	if (rc <= 0)
 		D_GOTO(out, rc);
+
+	rc = 0;
+	/* Check if we need send the object list */
+	if (++tgt_root->count >= REBUILD_SEND_LIMIT) {
+		rc = rebuild_objects_collect(tgt_root, &send_arg);
+		if (rc == 0) {
+			rc = rebuild_objects_send(send_arg, tgt_id,
+						  arg->scan_arg->rpt,
+						  &incarnation);
+			rebuild_send_arg_free(send_arg);
+		}
+		if (rc == 0)
+			rc = rebuild_ckpt_tgt_add(arg, tgt_id, incarnation);
 	}
 
-	if (rc == 1) {
-		/* Check if we need send the object list */
-		if (++tgt_root->count >= REBUILD_SEND_LIMIT) {
-			rc = rebuild_objects_send(tgt_root, tgt_id, arg);
-			if (rc < 0)
-				D_GOTO(out, rc);
+	D_DEBUG(DB_REBUILD, "insert "DF_UOID"/"DF_UUID" tgt %u rc %d\n",
+		DP_UOID(oid), DP_UUID(co_uuid), tgt_id, rc);
+out:
+	return rc;
+}
+
+/* Send all of the objects in the tree of the scanner */
+static int
+rebuild_scanner_flush(struct rebuild_scanner_arg *arg)
+{
+	int rc = 0;
+
+	while (!dbtree_is_empty(arg->tree_hdl)) {
+		/* walk through the rebuild tree and send the rebuild objects */
+		rc = dbtree_iterate(arg->tree_hdl, false,
+				    rebuild_tgt_fini_obj_send_cb, arg);
+		if (rc)
+			break;
+	}
+
+	return rc;
+}
+
+static int
+rebuild_ckpt_done_add(struct rebuild_scanner_arg *arg, uuid_t co_uuid)
+{
+	struct rebuild_scan_ckpt *ckpt = &arg->ckpt;
+
+	if (ckpt->rsc_done_nr == arg->done_cap) {
+		unsigned int	 cap = max(arg->done_cap * 2, 16U);
+		uuid_t		*conts;
+
+		D_REALLOC(conts, arg->done_conts, cap * sizeof(*conts));
+		if (conts == NULL)
+			return -DER_NOMEM;
+
+		arg->done_conts = conts;
+		arg->done_cap = cap;
+	}
+
+	uuid_copy(arg->done_conts[ckpt->rsc_done_nr++], co_uuid);
+	return 0;
+}
+
+struct rebuild_ckpt_io {
+	struct rebuild_scanner_arg	*rci_arg;
+	char				*rci_path;
+};
+
+/**
+ * Read or write the checkpoint file on the helper xstream, the xstream keeps
+ * running the other ULTs while this one waits for the blocking I/O.
+ */
+static int
+rebuild_ckpt_io_exec(struct rebuild_scanner_arg *arg, int (*func)(void *))
+{
+	struct rebuild_ckpt_io	io;
+	int			rc;
+
+	rc = rebuild_ckpt_path(arg->scan_arg->rpt->rt_pool_uuid, &io.rci_path);
+	if (rc)
+		return rc;
+
+	io.rci_arg = arg;
+	rc = dss_helper_execute(func, &io);
+	D_FREE(io.rci_path);
+	return rc;
+}
+
+static int
+rebuild_ckpt_read(void *data)
+{
+	struct rebuild_ckpt_io		*io = data;
+	struct rebuild_scanner_arg	*arg = io->rci_arg;
+	struct rebuild_tgt_pool_tracker	*rpt = arg->scan_arg->rpt;
+	struct rebuild_scan_ckpt	 ckpt;
+	struct rebuild_ckpt_tgt		 tgt;
+	uuid_t				 co_uuid;
+	int				 fd;
+	int				 i;
+	int				 rc;
+
+	fd = open(io->rci_path, O_RDONLY);
+	if (fd < 0) {
+		if (errno == ENOENT)
+			return 0;
+
+		D_ERROR("failed to open %s: %d\n", io->rci_path, errno);
+		return daos_errno2der(errno);
+	}
+
+	rc = read(fd, &ckpt, sizeof(ckpt));
+	if (rc != sizeof(ckpt) || ckpt.rsc_magic != REBUILD_CKPT_MAGIC ||
+	    ckpt.rsc_rebuild_ver != rpt->rt_rebuild_ver) {
+		D_DEBUG(DB_REBUILD, "ignore checkpoint %s: %d ver %u/%u\n",
+			io->rci_path, rc, ckpt.rsc_rebuild_ver,
+			rpt->rt_rebuild_ver);
+		D_GOTO(out, rc = 0);
+	}
+
+	for (i = 0; i < ckpt.rsc_done_nr; i++) {
+		rc = read(fd, co_uuid, sizeof(uuid_t));
+		if (rc != sizeof(uuid_t))
+			D_GOTO(truncated, rc);
+
+		rc = rebuild_ckpt_done_add(arg, co_uuid);
+		if (rc)
+			D_GOTO(out, rc);
+	}
+
+	for (i = 0; i < ckpt.rsc_tgt_nr; i++) {
+		rc = read(fd, &tgt, sizeof(tgt));
+		if (rc != sizeof(tgt))
+			D_GOTO(truncated, rc);
+
+		rc = rebuild_ckpt_tgt_add(arg, tgt.rct_tgt_id,
+					  tgt.rct_incarnation);
+		if (rc)
+			D_GOTO(out, rc);
+	}
+
+	uuid_copy(arg->ckpt.rsc_cont, ckpt.rsc_cont);
+	arg->ckpt.rsc_anchor = ckpt.rsc_anchor;
+	D_GOTO(out, rc = 0);
+truncated:
+	D_ERROR("truncated checkpoint %s: %d\n", io->rci_path, rc);
+	memset(&arg->ckpt, 0, sizeof(arg->ckpt));
+	rc = 0;
+out:
+	close(fd);
+	return rc;
+}
+
+/**
+ * Load the scan checkpoint of the current xstream, a checkpoint left by
+ * another rebuild is simply ignored, and so is the one of which any of the
+ * initiators has been restarted since, the objects sent to it are lost.
+ */
+static int
+rebuild_ckpt_load(struct rebuild_scanner_arg *arg)
+{
+	struct rebuild_tgt_pool_tracker	*rpt = arg->scan_arg->rpt;
+	struct rebuild_ckpt_tgt		*tgt;
+	uint64_t			 incarnation;
+	int				 i;
+	int				 rc;
+
+	rc = rebuild_ckpt_io_exec(arg, rebuild_ckpt_read);
+	if (rc)
+		return rc;
+
+	for (i = 0; i < arg->ckpt.rsc_tgt_nr; i++) {
+		tgt = &arg->ckpt_tgts[i];
+		rc = rebuild_objects_send(NULL, tgt->rct_tgt_id, rpt,
+					  &incarnation);
+		if (rc != 0 || (incarnation != 0 &&
+				incarnation != tgt->rct_incarnation)) {
+			D_DEBUG(DB_REBUILD, DF_UUID" tgt %u restarted, "
+				"discard checkpoint: %d\n",
+				DP_UUID(rpt->rt_pool_uuid), tgt->rct_tgt_id,
+				rc);
+			rebuild_ckpt_discard(arg);
+			return 0;
 		}
-		rc = 0;
 	}
-	ABT_mutex_unlock(arg->scan_lock);
 
-	D_DEBUG(DB_REBUILD, "insert "DF_UOID"/"DF_UUID" tgt %u cnt %d rc %d\n",
-		DP_UOID(oid), DP_UUID(co_uuid), tgt_id, tgt_root->count, rc);
+	D_DEBUG(DB_REBUILD, DF_UUID" ver %u resume scan after %u containers, "
+		"cont "DF_UUID"\n", DP_UUID(rpt->rt_pool_uuid),
+		rpt->rt_rebuild_ver, arg->ckpt.rsc_done_nr,
+		DP_UUID(arg->ckpt.rsc_cont));
+	return 0;
+}
+
+static int
+rebuild_ckpt_write_buf(int fd, const char *path, void *buf, size_t size)
+{
+	ssize_t	rc;
+
+	if (size == 0)
+		return 0;
+
+	rc = write(fd, buf, size);
+	if (rc == size)
+		return 0;
+
+	if (rc != -1)
+		errno = EIO;
+	D_ERROR("failed to write %s: %zd %d\n", path, rc, errno);
+	return daos_errno2der(errno);
+}
+
+static int
+rebuild_ckpt_write(void *data)
+{
+	struct rebuild_ckpt_io		*io = data;
+	struct rebuild_scanner_arg	*arg = io->rci_arg;
+	struct rebuild_scan_ckpt	*ckpt = &arg->ckpt;
+	char				*tmp;
+	int				 fd;
+	int				 rc;
+
+	rc = asprintf(&tmp, "%s.tmp", io->rci_path);
+	if (rc < 0)
+		return -DER_NOMEM;
+
+	/* Write a new file and rename it, so a crash never leaves a partial
+	 * checkpoint behind.
+	 */
+	fd = open(tmp, O_WRONLY | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR);
+	if (fd < 0) {
+		D_ERROR("failed to create %s: %d\n", tmp, errno);
+		D_GOTO(out, rc = daos_errno2der(errno));
+	}
+
+	rc = rebuild_ckpt_write_buf(fd, tmp, ckpt, sizeof(*ckpt));
+	if (rc == 0)
+		rc = rebuild_ckpt_write_buf(fd, tmp, arg->done_conts,
+					    ckpt->rsc_done_nr *
+					    sizeof(uuid_t));
+	if (rc == 0)
+		rc = rebuild_ckpt_write_buf(fd, tmp, arg->ckpt_tgts,
+					    ckpt->rsc_tgt_nr *
+					    sizeof(*arg->ckpt_tgts));
+	if (rc) {
+		close(fd);
+		D_GOTO(remove, rc);
+	}
+
+	rc = fsync(fd);
+	close(fd);
+	if (rc != 0) {
+		D_ERROR("failed to fsync %s: %d\n", tmp, errno);
+		D_GOTO(remove, rc = daos_errno2der(errno));
+	}
+
+	rc = rename(tmp, io->rci_path);
+	if (rc != 0) {
+		D_ERROR("failed to rename %s: %d\n", tmp, errno);
+		D_GOTO(remove, rc = daos_errno2der(errno));
+	}
+	D_GOTO(out, rc = 0);
+remove:
+	unlink(tmp);
 out:
+	free(tmp);
 	return rc;
 }
 
-#define LOCAL_ARRAY_SIZE	128
+/**
+ * Send all of the objects scanned so far, then persist the scan progress of
+ * the current xstream, so the objects before the checkpoint do not have to
+ * be scanned again if the scan is restarted.
+ */
+static int
+rebuild_ckpt_store(struct rebuild_scanner_arg *arg)
+{
+	struct rebuild_tgt_pool_tracker	*rpt = arg->scan_arg->rpt;
+	struct rebuild_scan_ckpt	*ckpt = &arg->ckpt;
+	int				 rc;
+
+	rc = rebuild_scanner_flush(arg);
+	if (rc)
+		return rc;
+
+	arg->scanned = 0;
+	ckpt->rsc_magic = REBUILD_CKPT_MAGIC;
+	ckpt->rsc_rebuild_ver = rpt->rt_rebuild_ver;
+
+	rc = rebuild_ckpt_io_exec(arg, rebuild_ckpt_write);
+	if (rc)
+		return rc;
+
+	D_DEBUG(DB_REBUILD, DF_UUID" checkpoint scan: %u containers done, cont "
+		DF_UUID"\n", DP_UUID(rpt->rt_pool_uuid), ckpt->rsc_done_nr,
+		DP_UUID(ckpt->rsc_cont));
+	return 0;
+}
+
+static int
+rebuild_scan_cont_cb(uuid_t co_uuid, daos_anchor_t **anchor, void *data)
+{
+	struct rebuild_scanner_arg	*arg = data;
+	struct rebuild_scan_ckpt	*ckpt = &arg->ckpt;
+	int				 i;
+	int				 rc;
+
+	if (arg->scan_arg->rpt->rt_abort || arg->scan_arg->rpt->rt_rescan)
+		return 1;
+
+	for (i = 0; i < ckpt->rsc_done_nr; i++) {
+		if (uuid_compare(arg->done_conts[i], co_uuid) == 0) {
+			D_DEBUG(DB_REBUILD, "skip scanned cont "DF_UUID"\n",
+				DP_UUID(co_uuid));
+			return 1;
+		}
+	}
+
+	/* The previous container has been fully scanned */
+	if (!uuid_is_null(arg->cur_cont)) {
+		rc = rebuild_ckpt_done_add(arg, arg->cur_cont);
+		if (rc)
+			return rc;
+	}
+	uuid_copy(arg->cur_cont, co_uuid);
+
+	/* Resume the container from the checkpoint, or start a new one */
+	if (uuid_compare(ckpt->rsc_cont, co_uuid) != 0) {
+		uuid_copy(ckpt->rsc_cont, co_uuid);
+		daos_anchor_set_zero(&ckpt->rsc_anchor);
+	}
+	*anchor = &ckpt->rsc_anchor;
+
+	return 0;
+}
+
 static int
 placement_check(uuid_t co_uuid, daos_unit_oid_t oid,
 		daos_epoch_t epoch, void *data)
 {
-	struct rebuild_scan_arg	*arg = data;
-	struct rebuild_tgt_pool_tracker *rpt = arg->rpt;
-	struct pl_obj_layout	*layout = NULL;
+	struct rebuild_scanner_arg	*arg = data;
+	struct rebuild_tgt_pool_tracker *rpt = arg->scan_arg->rpt;
 	struct pl_map		*map = NULL;
+	struct daos_oclass_attr	*oc_attr;
 	struct daos_obj_md	md;
-	unsigned int		tgt_array[LOCAL_ARRAY_SIZE];
-	unsigned int		shard_array[LOCAL_ARRAY_SIZE];
-	unsigned int		*tgts = NULL;
-	unsigned int		*shards = NULL;
 	int			rebuild_nr;
-	d_rank_t		myrank;
 	int			i;
-	int			rc;
+	int			rc = 0;
 
-	if (rpt->rt_abort)
+	if (rpt->rt_abort || rpt->rt_rescan)
 		return 1;
 
+	/* Shards and epochs of the same object are iterated one after
+	 * another, their placement is the same, so reuse the result.
+	 */
+	if (arg->rebuild_nr >= 0 &&
+	    daos_obj_compare_id(arg->last_oid, oid.id_pub) == 0) {
+		rebuild_nr = arg->rebuild_nr;
+		D_GOTO(insert, rc = 0);
+	}
+
+	arg->rebuild_nr = -1;
+	arg->last_oid = oid.id_pub;
+
+	/* Only the placement map knows whether the layout of an object
+	 * covers the rebuilding targets, i.e. the layout can't be filtered
+	 * without being computed, so it is computed once per object (see
+	 * above) instead. The object without redundancy is the exception,
+	 * it can't be rebuilt, pl_obj_find_rebuild() finds nothing for it
+	 * either, so skip the placement.
+	 */
+	oc_attr = daos_oclass_attr_find(oid.id_pub);
+	if (oc_attr != NULL && daos_oclass_grp_size(oc_attr) == 1) {
+		rebuild_nr = arg->rebuild_nr = 0;
+		D_GOTO(out, rc = 0);
+	}
+
 	map = pl_map_find(rpt->rt_pool_uuid, oid.id_pub);
 	if (map == NULL) {
 		D_ERROR(DF_UOID"Cannot find valid placement map"
@@ -572,28 +1097,21 @@ placement_check(uuid_t co_uuid, daos_unit_oid_t oid,
 	}
 
 	dc_obj_fetch_md(oid.id_pub, &md);
-	crt_group_rank(rpt->rt_pool->sp_group, &myrank);
 	md.omd_ver = rpt->rt_rebuild_ver;
-	if (arg->rebuild_tgt_nr > LOCAL_ARRAY_SIZE) {
-		D_ALLOC_ARRAY(tgts, arg->rebuild_tgt_nr);
-		D_ALLOC_ARRAY(shards, arg->rebuild_tgt_nr);
-		if (tgts == NULL || shards == NULL)
-			D_GOTO(out, rc = -DER_NOMEM);
-	} else {
-		tgts = tgt_array;
-		shards = shard_array;
-	}
-
 	rebuild_nr = pl_obj_find_rebuild(map, &md, NULL, rpt->rt_rebuild_ver,
-					 tgts, shards, arg->rebuild_tgt_nr);
-	if (rebuild_nr <= 0) /* No need rebuild */
+					 arg->tgts, arg->shards,
+					 arg->scan_arg->rebuild_tgt_nr);
+	if (rebuild_nr < 0)
 		D_GOTO(out, rc = rebuild_nr);
 
-	D_ASSERT(rebuild_nr <= arg->rebuild_tgt_nr);
+	D_ASSERT(rebuild_nr <= arg->scan_arg->rebuild_tgt_nr);
+	arg->rebuild_nr = rebuild_nr;
+insert:
 	for (i = 0; i < rebuild_nr; i++) {
 		D_DEBUG(DB_REBUILD, "rebuild obj "DF_UOID"/"DF_UUID"/"DF_UUID
 			" on %d for shard %d\n", DP_UOID(oid), DP_UUID(co_uuid),
-			DP_UUID(rpt->rt_pool_uuid), tgts[i], shards[i]);
+			DP_UUID(rpt->rt_pool_uuid), arg->tgts[i],
+			arg->shards[i]);
 
 		/* During rebuild test, it will manually exclude some target to
 		 * trigger the rebuild, then later add it back, so some objects
@@ -602,8 +1120,9 @@ placement_check(uuid_t co_uuid, daos_unit_oid_t oid,
 		 * now. When we have better support from CART exclude/addback,
 		 * myrank should always not equal to tgt_rebuild. XXX
 		 */
-		if (myrank != tgts[i]) {
-			rc = rebuild_object_insert(arg, tgts[i], shards[i],
+		if (arg->myrank != arg->tgts[i]) {
+			rc = rebuild_object_insert(arg, arg->tgts[i],
+						   arg->shards[i],
 						   rpt->rt_pool_uuid, co_uuid,
 						   oid, epoch);
 			if (rc)
@@ -614,40 +1133,93 @@ placement_check(uuid_t co_uuid, daos_unit_oid_t oid,
 		}
 	}
 out:
-	if (layout != NULL)
-		pl_obj_layout_free(layout);
-
-	if (tgts != tgt_array && tgts != NULL)
-		D_FREE(tgts);
-
-	if (shards != shard_array && shards != NULL)
-		D_FREE(shards);
-
 	if (map != NULL)
 		pl_map_decref(map);
 
+	if (rc == 0 && (++arg->scanned >= REBUILD_CKPT_INTV ||
+			daos_fail_check(DAOS_REBUILD_TGT_CKPT_HANG))) {
+		rc = rebuild_ckpt_store(arg);
+		while (daos_fail_check(DAOS_REBUILD_TGT_CKPT_HANG) &&
+		       !rpt->rt_abort && !rpt->rt_rescan)
+			ABT_thread_yield();
+	}
+
 	return rc;
 }
 
-struct rebuild_iter_arg {
-	cont_iter_cb_t	callback;
-	void		*arg;
-};
-
-int
+/* Scan the objects of the pool on the current xstream */
+static int
 rebuild_scanner(void *data)
 {
-	struct rebuild_iter_arg *arg = data;
-	struct rebuild_scan_arg	*scan_arg = arg->arg;
+	struct rebuild_scan_arg		*scan_arg = data;
 	struct rebuild_tgt_pool_tracker *rpt = scan_arg->rpt;
+	struct rebuild_scanner_arg	*arg;
+	struct umem_attr		 uma;
+	int				 rc;
 
 	D_ASSERT(rpt != NULL);
 
 	while (daos_fail_check(DAOS_REBUILD_TGT_SCAN_HANG))
 		ABT_thread_yield();
 
-	return ds_pool_obj_iter(rpt->rt_pool_uuid, arg->callback,
-				arg->arg);
+	D_ALLOC_PTR(arg);
+	if (arg == NULL)
+		return -DER_NOMEM;
+
+	arg->scan_arg = scan_arg;
+	arg->tree_hdl = DAOS_HDL_INVAL;
+	arg->rebuild_nr = -1;
+	crt_group_rank(rpt->rt_pool->sp_group, &arg->myrank);
+
+	D_ALLOC_ARRAY(arg->tgts, scan_arg->rebuild_tgt_nr);
+	D_ALLOC_ARRAY(arg->shards, scan_arg->rebuild_tgt_nr);
+	if (arg->tgts == NULL || arg->shards == NULL)
+		D_GOTO(out, rc = -DER_NOMEM);
+
+	/* Create the btree root for the object scan list of this xstream */
+	memset(&uma, 0, sizeof(uma));
+	uma.uma_id = UMEM_CLASS_VMEM;
+	rc = dbtree_create(DBTREE_CLASS_NV, 0, 4, &uma, NULL, &arg->tree_hdl);
+	if (rc != 0) {
+		D_ERROR("failed to create rebuild tree: %d\n", rc);
+		D_GOTO(out, rc);
+	}
+
+	rc = rebuild_ckpt_load(arg);
+	if (rc)
+		D_GOTO(out, rc);
+
+	rc = ds_pool_obj_iter(rpt->rt_pool_uuid, rebuild_scan_cont_cb,
+			      placement_check, arg);
+	/* The scan leader rescans from the checkpoint, see
+	 * rebuild_scan_restart().
+	 */
+	if (rc || rpt->rt_abort || rpt->rt_rescan)
+		D_GOTO(out, rc);
+
+	/* The last container has been fully scanned as well */
+	if (!uuid_is_null(arg->cur_cont)) {
+		rc = rebuild_ckpt_done_add(arg, arg->cur_cont);
+		if (rc)
+			D_GOTO(out, rc);
+		uuid_clear(arg->ckpt.rsc_cont);
+	}
+
+	/* send the left objects, and mark the whole scan done */
+	rc = rebuild_ckpt_store(arg);
+out:
+	if (!daos_handle_is_inval(arg->tree_hdl))
+		dbtree_destroy(arg->tree_hdl);
+	if (arg->tgts != NULL)
+		D_FREE(arg->tgts);
+	if (arg->shards != NULL)
+		D_FREE(arg->shards);
+	if (arg->done_conts != NULL)
+		D_FREE(arg->done_conts);
+	if (arg->ckpt_tgts != NULL)
+		D_FREE(arg->ckpt_tgts);
+	D_FREE(arg);
+	return rc;
 }
 
 static int
@@ -664,6 +1236,20 @@ rebuild_scan_done(void *data)
 	return 0;
 }
 
+static int
+rebuild_scan_start(void *data)
+{
+	struct rebuild_tgt_pool_tracker *rpt = data;
+	struct rebuild_pool_tls *tls;
+
+	tls = rebuild_pool_tls_lookup(rpt->rt_pool_uuid,
+				      rpt->rt_rebuild_ver);
+	D_ASSERT(tls != NULL);
+
+	tls->rebuild_pool_scanning = 1;
+	return 0;
+}
+
 /**
  * Wait for pool map and setup global status, then spawn scanners for all
  * service xsteams
@@ -675,11 +1261,9 @@ rebuild_scan_leader(void *data)
 	struct pool_map		  *map;
 	struct rebuild_tgt_pool_tracker *rpt;
 	struct rebuild_pool_tls	  *tls;
-	struct rebuild_iter_arg    iter_arg;
 	int			   rc;
 
 	D_ASSERT(arg != NULL);
-	D_ASSERT(!daos_handle_is_inval(arg->rebuild_tree_hdl));
 
 	rpt = arg->rpt;
 	/* refresh placement for the server stack */
@@ -693,29 +1277,25 @@ rebuild_scan_leader(void *data)
 	}
 	ABT_mutex_unlock(rpt->rt_lock);
 
-	iter_arg.arg = arg;
-	iter_arg.callback = placement_check;
-
-	rc = dss_thread_collective(rebuild_scanner, &iter_arg);
+again:
+	/* Each xstream scans its own VOS and sends the objects by itself */
+	rc = dss_thread_collective(rebuild_scanner, arg);
 	if (rc)
 		D_GOTO(put_plmap, rc);
 
 	D_DEBUG(DB_REBUILD, "rebuild scan collective "DF_UUID" done.\n",
 		DP_UUID(rpt->rt_pool_uuid));
 
-	/* NB: only leading xstream will operate the scan tree since then,
-	 * so no need lock rebuild tgt tree.
-	 */
-	while (!dbtree_is_empty(arg->rebuild_tree_hdl)) {
-		/* walk through the rebuild tree and send the rebuild objects */
-		rc = dbtree_iterate(arg->rebuild_tree_hdl, false,
-				    rebuild_tgt_fini_obj_send_cb, arg);
-		if (rc)
-			D_GOTO(put_plmap, rc);
-	}
-
 	ABT_mutex_lock(rpt->rt_lock);
+	if (rpt->rt_rescan && !rpt->rt_abort) {
+		rpt->rt_rescan = 0;
+		ABT_mutex_unlock(rpt->rt_lock);
+		D_DEBUG(DB_REBUILD, DF_UUID" rescan from the checkpoints\n",
+			DP_UUID(rpt->rt_pool_uuid));
+		goto again;
+	}
 	rc = dss_task_collective(rebuild_scan_done, rpt);
+	rpt->rt_scanning = 0;
 	ABT_mutex_unlock(rpt->rt_lock);
 	if (rc) {
 		D_ERROR(DF_UUID" send rebuild object list failed:%d\n",
@@ -730,26 +1310,84 @@ put_plmap:
 	pl_map_disconnect(rpt->rt_pool_uuid);
 out_map:
 	rebuild_pool_map_put(map);
-	dbtree_destroy(arg->rebuild_tree_hdl);
+	ABT_mutex_lock(rpt->rt_lock);
+	rpt->rt_scanning = 0;
+	rpt->rt_rescan = 0;
+	ABT_mutex_unlock(rpt->rt_lock);
 	tls = rebuild_pool_tls_lookup(rpt->rt_pool_uuid, rpt->rt_rebuild_ver);
 	D_ASSERT(tls != NULL);
 	if (tls->rebuild_pool_status == 0 && rc != 0)
 		tls->rebuild_pool_status = rc;
 	D_DEBUG(DB_REBUILD, DF_UUID"scan leader done %d\n",
 		DP_UUID(rpt->rt_pool_uuid), rc);
-	ABT_mutex_free(&arg->scan_lock);
 	D_FREE(arg);
 	rpt_put(rpt);
 }
 
+static int
+rebuild_scan_leader_start(struct rebuild_tgt_pool_tracker *rpt,
+			  int rebuild_tgt_nr)
+{
+	struct rebuild_scan_arg	*scan_arg;
+	int			 rc;
+
+	D_ALLOC_PTR(scan_arg);
+	if (scan_arg == NULL)
+		return -DER_NOMEM;
+
+	scan_arg->rebuild_tgt_nr = rebuild_tgt_nr;
+	rpt_get(rpt);
+	scan_arg->rpt = rpt;
+	rpt->rt_scanning = 1;
+	rc = dss_ult_create(rebuild_scan_leader, scan_arg, -1, 0, NULL);
+	if (rc != 0) {
+		rpt->rt_scanning = 0;
+		rpt_put(rpt);
+		D_FREE(scan_arg);
+	}
+	return rc;
+}
+
+/**
+ * The objects sent to an initiator which has been restarted since are lost,
+ * so the scan is restarted on a leader change, then each scanner checks the
+ * initiators it sent to, and either resumes from its checkpoint or scans
+ * from scratch, see rebuild_ckpt_load().
+ */
+static int
+rebuild_scan_restart(struct rebuild_tgt_pool_tracker *rpt, int rebuild_tgt_nr)
+{
+	int rc = 0;
+
+	ABT_mutex_lock(rpt->rt_lock);
+	if (rpt->rt_abort || rpt->rt_global_scan_done)
+		D_GOTO(out, rc = 0);
+
+	/* The running scanners stop and rescan from their checkpoints */
+	if (rpt->rt_scanning) {
+		rpt->rt_rescan = 1;
+		D_GOTO(out, rc = 0);
+	}
+
+	rc = dss_task_collective(rebuild_scan_start, rpt);
+	if (rc)
+		D_GOTO(out, rc);
+
+	rpt->rt_scan_done = 0;
+	rc = rebuild_scan_leader_start(rpt, rebuild_tgt_nr);
+out:
+	ABT_mutex_unlock(rpt->rt_lock);
+	D_DEBUG(DB_REBUILD, DF_UUID" restart scan: %d\n",
+		DP_UUID(rpt->rt_pool_uuid), rc);
+	return rc;
+}
+
 /* Scan the local target and generate rebuild object list */
 void
 rebuild_tgt_scan_handler(crt_rpc_t *rpc)
 {
 	struct rebuild_scan_in		*rsi;
 	struct rebuild_scan_out		*ro;
-	struct rebuild_scan_arg		*scan_arg;
-	struct umem_attr		 uma;
 	struct rebuild_tgt_pool_tracker	*rpt = NULL;
 	int				 rc;
 
@@ -806,7 +1444,8 @@ rebuild_tgt_scan_handler(crt_rpc_t *rpc)
 
 		rpt->rt_leader_term = rsi->rsi_leader_term;
 
-		D_GOTO(out, rc = 0);
+		rc = rebuild_scan_restart(rpt, rsi->rsi_tgts_num);
+		D_GOTO(out, rc);
 	}
 
 	if (daos_fail_check(DAOS_REBUILD_TGT_START_FAIL))
@@ -823,44 +1462,9 @@ rebuild_tgt_scan_handler(crt_rpc_t *rpc)
 		D_GOTO(out, rc);
 	}
 
-	/* step-1: parameters for scanner */
-	D_ALLOC_PTR(scan_arg);
-	if (scan_arg == NULL)
-		D_GOTO(out, rc = -DER_NOMEM);
-
-	rc = ABT_mutex_create(&scan_arg->scan_lock);
-	if (rc != ABT_SUCCESS) {
-		rc = dss_abterr2der(rc);
-		D_GOTO(out_arg, rc);
-	}
-
-	/* step-2: Create the btree root for global object scan list */
-	memset(&uma, 0, sizeof(uma));
-	uma.uma_id = UMEM_CLASS_VMEM;
-	rc = dbtree_create(DBTREE_CLASS_NV, 0, 4, &uma, NULL,
-			   &scan_arg->rebuild_tree_hdl);
-	if (rc != 0) {
-		D_ERROR("failed to create rebuild tree: %d\n", rc);
-		D_GOTO(out_lock, rc);
-	}
-
-	scan_arg->rebuild_tgt_nr = rsi->rsi_tgts_num;
-	rpt_get(rpt);
-	scan_arg->rpt = rpt;
-	/* step-3: start scann leader */
-	rc = dss_ult_create(rebuild_scan_leader, scan_arg, -1, 0, NULL);
-	if (rc != 0) {
-		rpt_put(rpt);
-		D_GOTO(out_tree, rc);
-	}
-
-	D_GOTO(out, rc);
-out_tree:
-	dbtree_destroy(scan_arg->rebuild_tree_hdl);
-out_lock:
-	ABT_mutex_free(&scan_arg->scan_lock);
-out_arg:
-	D_FREE(scan_arg);
+	ABT_mutex_lock(rpt->rt_lock);
+	rc = rebuild_scan_leader_start(rpt, rsi->rsi_tgts_num);
+	ABT_mutex_unlock(rpt->rt_lock);
 out:
 	if (rpt)
 		rpt_put(rpt);
@@ -27,6 +27,8 @@
  */
 #define D_LOGFAC	DD_FAC(rebuild)
 
+#include <stdlib.h>
+#include <time.h>
 #include <daos/rpc.h>
 #include <daos/pool.h>
 #include <daos_srv/daos_server.h>
@@ -377,28 +379,39 @@ dss_rebuild_check_one(void *data)
 	struct rebuild_pool_tls		*pool_tls;
 	struct rebuild_tgt_query_info	*status = arg->status;
 	struct rebuild_tgt_pool_tracker	*rpt = arg->rpt;
+	struct rebuild_puller		*puller;
 	unsigned int idx = dss_get_module_info()->dmi_tid;
+	uint64_t			 obj_count;
+	int				 obj_status;
 
 	pool_tls = rebuild_pool_tls_lookup(rpt->rt_pool_uuid,
 					   rpt->rt_rebuild_ver);
 	D_ASSERTF(pool_tls != NULL, DF_UUID" ver %d\n",
 		   DP_UUID(rpt->rt_pool_uuid), rpt->rt_rebuild_ver);
 
+	/* objects are charged to the puller, see rebuild_obj_ult() */
+	puller = &rpt->rt_pullers[idx];
+	ABT_mutex_lock(puller->rp_lock);
+	obj_count = puller->rp_obj_count;
+	obj_status = puller->rp_obj_status;
+	ABT_mutex_unlock(puller->rp_lock);
+
 	D_DEBUG(DB_REBUILD, "%d rec_count "DF_U64" obj_count "DF_U64
 		" scanning %d status %d inflight %d\n",
-		idx, pool_tls->rebuild_pool_rec_count,
-		pool_tls->rebuild_pool_obj_count,
+		idx, pool_tls->rebuild_pool_rec_count, obj_count,
 		pool_tls->rebuild_pool_scanning,
-		pool_tls->rebuild_pool_status,
-		rpt->rt_pullers[idx].rp_inflight);
+		pool_tls->rebuild_pool_status, puller->rp_inflight);
 	ABT_mutex_lock(status->lock);
 	if (pool_tls->rebuild_pool_scanning)
 		status->scanning = 1;
 	if (pool_tls->rebuild_pool_status != 0 && status->status == 0)
 		status->status = pool_tls->rebuild_pool_status;
+	if (obj_status != 0 && status->status == 0)
+		status->status = obj_status;
 
 	status->rec_count += pool_tls->rebuild_pool_rec_count;
-	status->obj_count += pool_tls->rebuild_pool_obj_count;
+	status->obj_count += obj_count;
+	status->size += pool_tls->rebuild_pool_size;
 
 	ABT_mutex_unlock(status->lock);
 
@@ -451,10 +464,12 @@ rebuild_tgt_query(struct rebuild_tgt_pool_tracker *rpt,
 	ABT_mutex_unlock(rpt->rt_lock);
 
 	D_DEBUG(DB_REBUILD, "pool "DF_UUID" scanning %d/%d rebuilding=%s, "
-		"obj_count="DF_U64", tobe_obj="DF_U64" rec_count="DF_U64"\n",
+		"obj_count="DF_U64", tobe_obj="DF_U64" rec_count="DF_U64
+		" size="DF_U64"\n",
 		DP_UUID(rpt->rt_pool_uuid), status->scanning,
 		status->status, status->rebuilding ? "yes" : "no",
-		status->obj_count, rpt->rt_toberb_objs, status->rec_count);
+		status->obj_count, rpt->rt_toberb_objs, status->rec_count,
+		status->size);
 out:
 	return rc;
 }
@@ -502,9 +517,10 @@ ds_rebuild_query(uuid_t pool_uuid, struct daos_rebuild_status *status)
 
 out:
 	D_DEBUG(DB_REBUILD, "rebuild "DF_UUID" done %s rec "DF_U64" obj "
-		DF_U64" ver %d err %d\n", DP_UUID(pool_uuid),
+		DF_U64" size "DF_U64" ver %d err %d\n", DP_UUID(pool_uuid),
 		status->rs_done ? "yes" : "no", status->rs_rec_nr,
-		status->rs_obj_nr, status->rs_version, status->rs_errno);
+		status->rs_obj_nr, status->rs_size, status->rs_version,
+		status->rs_errno);
 
 	return rc;
 }
@@ -613,10 +629,13 @@ rebuild_status_check(struct ds_pool *pool, uint32_t map_ver,
 
 		snprintf(sbuf, RBLD_SBUF_LEN,
 			"Rebuild [%s] (pool "DF_UUID" ver=%u, toberb_obj="
-			DF_U64", rb_obj="DF_U64", rec= "DF_U64", done %d "
-			"status %d duration=%d secs)\n",
+			DF_U64", rb_obj="DF_U64", rec= "DF_U64", size= "
+			DF_U64" (%.1f MB/s), done %d status %d duration=%d "
+			"secs)\n",
 			str, DP_UUID(pool->sp_uuid), map_ver,
 			rs->rs_toberb_obj_nr, rs->rs_obj_nr, rs->rs_rec_nr,
+			rs->rs_size, now > begin ?
+			rs->rs_size / ((now - begin) * 1024 * 1024) : 0,
 			rs->rs_done, rs->rs_errno, (int)(now - begin));
 
 		D_DEBUG(DB_REBUILD, "%s", sbuf);
@@ -970,7 +989,9 @@ rpt_destroy(struct rebuild_tgt_pool_tracker *rpt)
 
 			puller = &rpt->rt_pullers[i];
 
-			D_ASSERT(puller->rp_ult == NULL);
+			D_ASSERT(puller->rp_ult_nr == 0);
+			if (puller->rp_ults)
+				D_FREE(puller->rp_ults);
 			if (puller->rp_fini_cond)
 				ABT_cond_free(&puller->rp_fini_cond);
 			if (puller->rp_lock)
@@ -1141,6 +1162,7 @@ rebuild_task_ult(void *arg)
 	iv.riv_toberb_obj_count	= rgt->rgt_status.rs_toberb_obj_nr;
 	iv.riv_obj_count	= rgt->rgt_status.rs_obj_nr;
 	iv.riv_rec_count	= rgt->rgt_status.rs_rec_nr;
+	iv.riv_size		= rgt->rgt_status.rs_size;
 
 	rc = rebuild_iv_update(pool->sp_iv_ns,
 			       &iv, CRT_IV_SHORTCUT_NONE,
@@ -1431,6 +1453,9 @@ rebuild_fini_one(void *arg)
 	struct rebuild_tgt_pool_tracker	*rpt = arg;
 	struct rebuild_pool_tls		*pool_tls;
 
+	/* The rebuild is done or aborted, the scan should not resume */
+	rebuild_scan_ckpt_remove(rpt->rt_pool_uuid);
+
 	pool_tls = rebuild_pool_tls_lookup(rpt->rt_pool_uuid,
 					   rpt->rt_rebuild_ver);
 	if (pool_tls == NULL)
@@ -1485,13 +1510,13 @@ rebuild_tgt_fini(struct rebuild_tgt_pool_tracker *rpt)
 		puller = &rpt->rt_pullers[i];
 
 		ABT_mutex_lock(puller->rp_lock);
-		if (puller->rp_ult_running)
+		while (puller->rp_ult_running > 0)
 			ABT_cond_wait(puller->rp_fini_cond, puller->rp_lock);
 		ABT_mutex_unlock(puller->rp_lock);
 
-		if (puller->rp_ult) {
-			ABT_thread_free(&puller->rp_ult);
-			puller->rp_ult = NULL;
+		while (puller->rp_ult_nr > 0) {
+			puller->rp_ult_nr--;
+			ABT_thread_free(&puller->rp_ults[puller->rp_ult_nr]);
 		}
 
 		/* since the dkey thread has been stopped, so we do not
@@ -1500,6 +1525,7 @@ rebuild_tgt_fini(struct rebuild_tgt_pool_tracker *rpt)
 		d_list_for_each_entry_safe(rdone, tmp, &puller->rp_one_list,
 					   ro_list) {
 			d_list_del_init(&rdone->ro_list);
+			puller->rp_queued--;
 			D_WARN(DF_UUID" left rebuild rdone %*.s\n",
 			       DP_UUID(rpt->rt_pool_uuid),
 			      (int)rdone->ro_dkey.iov_len,
@@ -1564,11 +1590,13 @@ rebuild_tgt_status_check(void *arg)
 
 		D_ASSERT(status.obj_count >= rpt->rt_reported_obj_cnt);
 		D_ASSERT(status.rec_count >= rpt->rt_reported_rec_cnt);
+		D_ASSERT(status.size >= rpt->rt_reported_size);
 		D_ASSERT(rpt->rt_toberb_objs >= rpt->rt_reported_toberb_objs);
 		if (rpt->rt_re_report) {
 			iv.riv_toberb_obj_count = rpt->rt_toberb_objs;
 			iv.riv_obj_count = status.obj_count;
 			iv.riv_rec_count = status.rec_count;
+			iv.riv_size = status.size;
 		} else {
 			iv.riv_toberb_obj_count = rpt->rt_toberb_objs -
 						  rpt->rt_reported_toberb_objs;
@@ -1576,6 +1604,7 @@ rebuild_tgt_status_check(void *arg)
 					   rpt->rt_reported_obj_cnt;
 			iv.riv_rec_count = status.rec_count -
 					   rpt->rt_reported_rec_cnt;
+			iv.riv_size = status.size - rpt->rt_reported_size;
 		}
 		iv.riv_status = status.status;
 		if (status.scanning == 0 || rpt->rt_abort) {
@@ -1619,6 +1648,7 @@ rebuild_tgt_status_check(void *arg)
 				}
 				rpt->rt_reported_obj_cnt = status.obj_count;
 				rpt->rt_reported_rec_cnt = status.rec_count;
+				rpt->rt_reported_size = status.size;
 			} else {
 				D_WARN("rebuild tgt iv update failed: %d\n",
 					rc);
@@ -1662,7 +1692,7 @@ rebuild_prepare_one(void *data)
 
 	pool_tls->rebuild_pool_scanning = 1;
 	pool_tls->rebuild_pool_rec_count = 0;
-	pool_tls->rebuild_pool_obj_count = 0;
+	pool_tls->rebuild_pool_size = 0;
 
 	uuid_copy(pool_tls->rebuild_poh_uuid, rpt->rt_poh_uuid);
 	uuid_copy(pool_tls->rebuild_coh_uuid, rpt->rt_coh_uuid);
@@ -1717,6 +1747,10 @@ rpt_create(struct ds_pool *pool, d_rank_list_t *svc_list, uint32_t pm_ver,
 		rc = ABT_cond_create(&puller->rp_fini_cond);
 		if (rc != ABT_SUCCESS)
 			D_GOTO(free, rc = dss_abterr2der(rc));
+
+		D_ALLOC_ARRAY(puller->rp_ults, rebuild_gst.rg_puller_ults);
+		if (puller->rp_ults == NULL)
+			D_GOTO(free, rc = -DER_NOMEM);
 	}
 
 	uuid_copy(rpt->rt_pool_uuid, pool->sp_uuid);
@@ -1726,8 +1760,11 @@ rpt_create(struct ds_pool *pool, d_rank_list_t *svc_list, uint32_t pm_ver,
 	rpt->rt_reported_toberb_objs = 0;
 	rpt->rt_reported_obj_cnt = 0;
 	rpt->rt_reported_rec_cnt = 0;
+	rpt->rt_reported_size = 0;
+	rpt->rt_obj_inflight = 0;
 	rpt->rt_rebuild_ver = pm_ver;
 	rpt->rt_leader_term = leader_term;
+	rpt->rt_incarnation = ((uint64_t)time(NULL) << 32) | (uint32_t)rand();
 	crt_group_rank(pool->sp_group, &rank);
 	rpt->rt_rank = rank;
 
@@ -1899,6 +1936,27 @@ init(void)
 	D_INIT_LIST_HEAD(&rebuild_gst.rg_queue_list);
 	D_INIT_LIST_HEAD(&rebuild_gst.rg_running_list);
 
+	rebuild_gst.rg_puller_ults = REBUILD_PULLER_ULTS;
+	d_getenv_int("DAOS_REBUILD_PULLERS", &rebuild_gst.rg_puller_ults);
+	if (rebuild_gst.rg_puller_ults == 0)
+		rebuild_gst.rg_puller_ults = 1;
+
+	rebuild_gst.rg_puller_queue_max = REBUILD_PULLER_QUEUE_MAX;
+	d_getenv_int("DAOS_REBUILD_QUEUE_MAX",
+		     &rebuild_gst.rg_puller_queue_max);
+	if (rebuild_gst.rg_puller_queue_max == 0)
+		rebuild_gst.rg_puller_queue_max = 1;
+
+	rebuild_gst.rg_obj_inflight_max = REBUILD_OBJ_INFLIGHT_MAX;
+	d_getenv_int("DAOS_REBUILD_OBJ_INFLIGHT",
+		     &rebuild_gst.rg_obj_inflight_max);
+	if (rebuild_gst.rg_obj_inflight_max == 0)
+		rebuild_gst.rg_obj_inflight_max = 1;
+
+	D_DEBUG(DB_REBUILD, "rebuild pullers %u/xstream, queue %u, obj %u\n",
+		rebuild_gst.rg_puller_ults, rebuild_gst.rg_puller_queue_max,
+		rebuild_gst.rg_obj_inflight_max);
+
 	rc = ABT_mutex_create(&rebuild_gst.rg_lock);
 	if (rc != ABT_SUCCESS)
 		return dss_abterr2der(rc);
@@ -106,6 +106,11 @@ main(int argc, char **argv)
 	daos_test_print(rank, "=====================");
 	nr_failed += run_hl_test(rank, size);
 
+	daos_test_print(rank, "\n\n=================");
+	daos_test_print(rank, "DAOS ADDONS DFS tests..");
+	daos_test_print(rank, "=====================");
+	nr_failed += run_dfs_test(rank, size);
+
 exit:
 	MPI_Allreduce(&nr_failed, &nr_total_failed, 1, MPI_INT, MPI_SUM,
 		      MPI_COMM_WORLD);
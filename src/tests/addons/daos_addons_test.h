@@ -30,5 +30,6 @@
 /** Addons tests */
 int run_array_test(int rank, int size);
 int run_hl_test(int rank, int size);
+int run_dfs_test(int rank, int size);
 
 #endif
@@ -0,0 +1,379 @@
+/**
+ * (C) Copyright 2018 Intel Corporation.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * GOVERNMENT LICENSE RIGHTS-OPEN SOURCE SOFTWARE
+ * The Government's rights to use, modify, reproduce, release, perform, display,
+ * or disclose this software are subject to the terms of the Apache License as
+ * provided in Contract No. B609815.
+ * Any reproduction of computer software, computer software documentation, or
+ * portions thereof marked with this legend must also reproduce the markings.
+ */
+/**
+ * This file is part of daos
+ *
+ * src/tests/addons/dfs_tests.c
+ *
+ * Tests of the DFS client cache. The files are accessed through a mount with
+ * the cache enabled, and checked through another mount without the cache.
+ */
+
+#include <pthread.h>
+#include <daos_types.h>
+#include <daos_fs.h>
+#include "daos_test.h"
+#include "daos_addons_test.h"
+
+/** DFS files use 1MiB chunks by default */
+#define DFS_TEST_CHUNK		(1024 * 1024)
+#define DFS_TEST_CACHE		(8 * DFS_TEST_CHUNK)
+#define DFS_TEST_THREADS	4
+
+/** mount with the cache, and without it */
+static dfs_t	*dfs_cached;
+static dfs_t	*dfs_plain;
+
+static dfs_obj_t *
+dfs_test_open(dfs_t *dfs, const char *name, int flags)
+{
+	dfs_obj_t	*obj;
+	int		 rc;
+
+	rc = dfs_open(dfs, NULL, name, S_IFREG | S_IWUSR | S_IRUSR, flags, 0,
+		      NULL, &obj);
+	assert_int_equal(rc, 0);
+	return obj;
+}
+
+static void
+dfs_test_write(dfs_t *dfs, dfs_obj_t *obj, char *buf, daos_off_t off,
+	       daos_size_t len)
+{
+	daos_sg_list_t	sgl;
+	daos_iov_t	iov;
+	int		rc;
+
+	daos_iov_set(&iov, buf, len);
+	sgl.sg_nr = 1;
+	sgl.sg_nr_out = 0;
+	sgl.sg_iovs = &iov;
+	rc = dfs_write(dfs, obj, sgl, off);
+	assert_int_equal(rc, 0);
+}
+
+static daos_size_t
+dfs_test_read(dfs_t *dfs, dfs_obj_t *obj, char *buf, daos_off_t off,
+	      daos_size_t len)
+{
+	daos_sg_list_t	sgl;
+	daos_iov_t	iov;
+	daos_size_t	read_size;
+	int		rc;
+
+	daos_iov_set(&iov, buf, len);
+	sgl.sg_nr = 1;
+	sgl.sg_nr_out = 0;
+	sgl.sg_iovs = &iov;
+	rc = dfs_read(dfs, obj, sgl, off, &read_size);
+	assert_int_equal(rc, 0);
+	return read_size;
+}
+
+/** Read @len bytes at @off in pieces of @io_size, and compare with @buf */
+static void
+dfs_test_verify(dfs_t *dfs, dfs_obj_t *obj, char *buf, daos_off_t off,
+		daos_size_t len, daos_size_t io_size)
+{
+	char		*rbuf;
+	daos_size_t	 done, n;
+
+	D_ALLOC(rbuf, io_size);
+	assert_non_null(rbuf);
+
+	for (done = 0; done < len; done += n) {
+		n = min(io_size, len - done);
+		assert_int_equal(dfs_test_read(dfs, obj, rbuf, off + done, n),
+				 n);
+		assert_memory_equal(rbuf, buf + done, n);
+	}
+	D_FREE(rbuf);
+}
+
+static void
+dfs_cache_readahead(void **state)
+{
+	daos_size_t	 len = 4 * DFS_TEST_CHUNK + 100;
+	daos_size_t	 io_size = 64 * 1024;
+	daos_size_t	 size;
+	dfs_obj_t	*obj;
+	char		*buf;
+
+	D_ALLOC(buf, len + io_size);
+	assert_non_null(buf);
+	dts_buf_render(buf, len);
+
+	obj = dfs_test_open(dfs_plain, "ra", O_RDWR | O_CREAT);
+	dfs_test_write(dfs_plain, obj, buf, 0, len);
+	assert_int_equal(dfs_release(obj), 0);
+
+	/** sequential reads are served by the readahead, up to EOF */
+	obj = dfs_test_open(dfs_cached, "ra", O_RDWR);
+	dfs_test_verify(dfs_cached, obj, buf, 0, len, io_size);
+	size = dfs_test_read(dfs_cached, obj, buf + len, len, io_size);
+	assert_int_equal(size, 0);
+
+	/** random reads, of cached chunks or not */
+	dfs_test_verify(dfs_cached, obj, buf + DFS_TEST_CHUNK + 10,
+			DFS_TEST_CHUNK + 10, io_size, io_size);
+	dfs_test_verify(dfs_cached, obj, buf + 100, 100, 2 * DFS_TEST_CHUNK,
+			2 * DFS_TEST_CHUNK);
+	assert_int_equal(dfs_release(obj), 0);
+	D_FREE(buf);
+}
+
+static void
+dfs_cache_write_behind(void **state)
+{
+	daos_size_t	 len = 3 * DFS_TEST_CHUNK + 512;
+	daos_size_t	 io_size = 4096;
+	daos_size_t	 size, done;
+	dfs_obj_t	*obj;
+	dfs_obj_t	*pobj;
+	char		*buf;
+	int		 rc;
+
+	D_ALLOC(buf, len);
+	assert_non_null(buf);
+	dts_buf_render(buf, len);
+
+	obj = dfs_test_open(dfs_cached, "wb", O_RDWR | O_CREAT);
+	for (done = 0; done < len; done += io_size)
+		dfs_test_write(dfs_cached, obj, buf + done, done,
+			       min(io_size, len - done));
+
+	/** a non contiguous write in a dirty chunk flushes it first */
+	dts_buf_render(buf + 100, 200);
+	dfs_test_write(dfs_cached, obj, buf + 100, 100, 200);
+	dts_buf_render(buf + 3 * DFS_TEST_CHUNK + 256, 100);
+	dfs_test_write(dfs_cached, obj, buf + 3 * DFS_TEST_CHUNK + 256,
+		       3 * DFS_TEST_CHUNK + 256, 100);
+
+	/** the writes are seen through the cache before being flushed */
+	dfs_test_verify(dfs_cached, obj, buf, 0, len, DFS_TEST_CHUNK);
+	rc = dfs_get_size(dfs_cached, obj, &size);
+	assert_int_equal(rc, 0);
+	assert_int_equal(size, len);
+
+	/** and by the other clients once flushed */
+	rc = dfs_sync(dfs_cached);
+	assert_int_equal(rc, 0);
+	pobj = dfs_test_open(dfs_plain, "wb", O_RDWR);
+	dfs_test_verify(dfs_plain, pobj, buf, 0, len, len);
+	assert_int_equal(dfs_release(pobj), 0);
+
+	assert_int_equal(dfs_release(obj), 0);
+	D_FREE(buf);
+}
+
+static void
+dfs_cache_writex(void **state)
+{
+	daos_size_t		 len = 3 * DFS_TEST_CHUNK;
+	daos_array_iod_t	 iod;
+	daos_range_t		 rg;
+	daos_sg_list_t		 sgl;
+	daos_iov_t		 iov;
+	dfs_obj_t		*obj;
+	dfs_obj_t		*pobj;
+	char			*buf;
+	char			*new_buf;
+	int			 rc;
+
+	D_ALLOC(buf, len);
+	assert_non_null(buf);
+	D_ALLOC(new_buf, DFS_TEST_CHUNK);
+	assert_non_null(new_buf);
+	dts_buf_render(buf, len);
+
+	pobj = dfs_test_open(dfs_plain, "wx", O_RDWR | O_CREAT);
+	dfs_test_write(dfs_plain, pobj, buf, 0, len);
+
+	/** cache the 3 chunks */
+	obj = dfs_test_open(dfs_cached, "wx", O_RDWR);
+	dfs_test_verify(dfs_cached, obj, buf, 0, len, DFS_TEST_CHUNK);
+
+	/** chunk 0 changes behind the cache, which still has the old data */
+	dts_buf_render(new_buf, DFS_TEST_CHUNK);
+	dfs_test_write(dfs_plain, pobj, new_buf, 0, DFS_TEST_CHUNK);
+
+	/** write the middle of chunk 2 */
+	dts_buf_render(buf + 2 * DFS_TEST_CHUNK + 100, 1000);
+	rg.rg_idx = 2 * DFS_TEST_CHUNK + 100;
+	rg.rg_len = 1000;
+	iod.arr_nr = 1;
+	iod.arr_rgs = &rg;
+	daos_iov_set(&iov, buf + rg.rg_idx, rg.rg_len);
+	sgl.sg_nr = 1;
+	sgl.sg_nr_out = 0;
+	sgl.sg_iovs = &iov;
+	rc = dfs_writex(dfs_cached, obj, &iod, &sgl, NULL);
+	assert_int_equal(rc, 0);
+
+	/** chunk 2 is read again, chunk 0 is still cached */
+	dfs_test_verify(dfs_cached, obj, buf + 2 * DFS_TEST_CHUNK,
+			2 * DFS_TEST_CHUNK, DFS_TEST_CHUNK, DFS_TEST_CHUNK);
+	dfs_test_verify(dfs_cached, obj, buf, 0, DFS_TEST_CHUNK,
+			DFS_TEST_CHUNK);
+
+	/** all of it is dropped by a punch */
+	rc = dfs_punch(dfs_cached, obj, len, DFS_MAX_FSIZE);
+	assert_int_equal(rc, 0);
+	dfs_test_verify(dfs_cached, obj, new_buf, 0, DFS_TEST_CHUNK,
+			DFS_TEST_CHUNK);
+
+	assert_int_equal(dfs_release(obj), 0);
+	assert_int_equal(dfs_release(pobj), 0);
+	D_FREE(new_buf);
+	D_FREE(buf);
+}
+
+struct dfs_test_thread {
+	pthread_t	 tt_thread;
+	dfs_obj_t	*tt_obj;
+	char		*tt_buf;
+	daos_off_t	 tt_off;
+	daos_size_t	 tt_len;
+};
+
+/** Write then read back a region sharing its first & last chunks */
+static void *
+dfs_test_thread_io(void *arg)
+{
+	struct dfs_test_thread	*tt = arg;
+	daos_size_t		 io_size = 16 * 1024;
+	daos_size_t		 done;
+
+	for (done = 0; done < tt->tt_len; done += io_size)
+		dfs_test_write(dfs_cached, tt->tt_obj, tt->tt_buf + done,
+			       tt->tt_off + done,
+			       min(io_size, tt->tt_len - done));
+
+	dfs_test_verify(dfs_cached, tt->tt_obj, tt->tt_buf, tt->tt_off,
+			tt->tt_len, io_size);
+	return NULL;
+}
+
+static void
+dfs_cache_threads(void **state)
+{
+	struct dfs_test_thread	 tts[DFS_TEST_THREADS];
+	daos_size_t		 region = 3 * DFS_TEST_CHUNK / 2;
+	daos_size_t		 len = DFS_TEST_THREADS * region;
+	dfs_obj_t		*obj;
+	dfs_obj_t		*pobj;
+	char			*buf;
+	int			 i;
+	int			 rc;
+
+	D_ALLOC(buf, len);
+	assert_non_null(buf);
+	dts_buf_render(buf, len);
+
+	/** a budget smaller than the file, so the chunks are reclaimed */
+	rc = dfs_set_cache(dfs_cached, 4 * DFS_TEST_CHUNK);
+	assert_int_equal(rc, 0);
+
+	obj = dfs_test_open(dfs_cached, "mt", O_RDWR | O_CREAT);
+	for (i = 0; i < DFS_TEST_THREADS; i++) {
+		tts[i].tt_obj = obj;
+		tts[i].tt_off = i * region;
+		tts[i].tt_len = region;
+		tts[i].tt_buf = buf + tts[i].tt_off;
+		rc = pthread_create(&tts[i].tt_thread, NULL,
+				    dfs_test_thread_io, &tts[i]);
+		assert_int_equal(rc, 0);
+	}
+	for (i = 0; i < DFS_TEST_THREADS; i++)
+		pthread_join(tts[i].tt_thread, NULL);
+	assert_int_equal(dfs_release(obj), 0);
+
+	pobj = dfs_test_open(dfs_plain, "mt", O_RDWR);
+	dfs_test_verify(dfs_plain, pobj, buf, 0, len, len);
+	assert_int_equal(dfs_release(pobj), 0);
+
+	rc = dfs_set_cache(dfs_cached, DFS_TEST_CACHE);
+	assert_int_equal(rc, 0);
+	D_FREE(buf);
+}
+
+static const struct CMUnitTest dfs_tests[] = {
+	{"DFS1: cache readahead",
+	 dfs_cache_readahead, NULL, NULL},
+	{"DFS2: cache write-behind",
+	 dfs_cache_write_behind, NULL, NULL},
+	{"DFS3: writex only drops the chunks it overlaps",
+	 dfs_cache_writex, NULL, NULL},
+	{"DFS4: cached I/O from concurrent threads",
+	 dfs_cache_threads, NULL, NULL},
+};
+
+static int
+dfs_setup(void **state)
+{
+	test_arg_t	*arg;
+	int		 rc;
+
+	rc = test_setup(state, SETUP_CONT_CONNECT, true, DEFAULT_POOL_SIZE,
+			NULL);
+	if (rc)
+		return rc;
+
+	arg = *state;
+	rc = dfs_mount(arg->pool.poh, arg->coh, O_RDWR, &dfs_plain);
+	if (rc)
+		return rc;
+
+	rc = dfs_mount(arg->pool.poh, arg->coh, O_RDWR, &dfs_cached);
+	if (rc)
+		return rc;
+
+	return dfs_set_cache(dfs_cached, DFS_TEST_CACHE);
+}
+
+static int
+dfs_teardown(void **state)
+{
+	int rc;
+
+	rc = dfs_umount(dfs_cached);
+	if (rc == 0)
+		rc = dfs_umount(dfs_plain);
+	if (rc)
+		return rc;
+
+	return test_teardown(state);
+}
+
+int
+run_dfs_test(int rank, int size)
+{
+	int rc = 0;
+
+	if (rank == 0)
+		rc = cmocka_run_group_tests_name("DFS client cache tests",
+						 dfs_tests, dfs_setup,
+						 dfs_teardown);
+	MPI_Barrier(MPI_COMM_WORLD);
+	return rc;
+}
@@ -76,6 +76,8 @@ bool			 ts_overwrite;
 bool			 ts_zero_copy;
 /* verify the output of fetch */
 bool			 ts_verify_fetch;
+/* stage fetched data through DRAM on server, only for "daos" */
+bool			 ts_bounce;
 
 uuid_t			 ts_cookie;		/* update cookie for VOS */
 daos_handle_t		 ts_oh;			/* object open handle */
@@ -649,10 +651,11 @@ ts_add_server(d_rank_t rank)
 }
 
 static void
-ts_rebuild_wait()
+ts_rebuild_wait(double start_time)
 {
 	daos_pool_info_t	   pinfo;
 	struct daos_rebuild_status *rst = &pinfo.pi_rebuild_st;
+	double			   secs;
 	int			   rc = 0;
 
 	while (1) {
@@ -665,6 +668,17 @@ ts_rebuild_wait()
 		}
 		sleep(2);
 	}
+
+	secs = dts_time_now() - start_time;
+	if (rc != 0 || secs <= 0)
+		return;
+
+	fprintf(stderr, "Rebuilt %"PRIu64" objs, %"PRIu64" recs, %"PRIu64
+		" bytes in %.2f secs\n", rst->rs_obj_nr, rst->rs_rec_nr,
+		rst->rs_size, secs);
+	fprintf(stderr, "Rebuild rate: %.1f objs/sec, %.1f recs/sec, "
+		"%.2f MB/sec\n", rst->rs_obj_nr / secs, rst->rs_rec_nr / secs,
+		rst->rs_size / (secs * 1024 * 1024));
 }
 
 static int
@@ -692,7 +706,7 @@ ts_rebuild_perf(double *start_time, double *end_time)
 		return rc;
 
 	*start_time = dts_time_now();
-	ts_rebuild_wait();
+	ts_rebuild_wait(*start_time);
 	*end_time = dts_time_now();
 
 	rc = ts_add_server(RANK_ZERO);
@@ -827,6 +841,10 @@ The options are as follows:\n\
 \n\
 -z	Use zero copy API, this option is only valid for 'vos'\n\
 \n\
+-b	Servers stage the fetched data through a DRAM buffer instead of\n\
+	transferring it from SCM in place, for comparison with the default\n\
+	zero-copy fetch. This option is only valid for 'daos'.\n\
+\n\
 -t	Instead of using different indices and epochs, all I/Os land to the\n\
 	same extent in the same epoch. This option can reduce usage of\n\
 	storage space.\n\
@@ -865,6 +883,7 @@ static struct option ts_ops[] = {
 	{ "array",	no_argument,		NULL,	'A' },
 	{ "size",	required_argument,	NULL,	's' },
 	{ "zcopy",	no_argument,		NULL,	'z' },
+	{ "bounce",	no_argument,		NULL,	'b' },
 	{ "overwrite",	no_argument,		NULL,	't' },
 	{ "nest_iter",	no_argument,		NULL,	'n' },
 	{ "file",	required_argument,	NULL,	'f' },
@@ -976,7 +995,7 @@ main(int argc, char **argv)
 
 	memset(ts_pmem_file, 0, sizeof(ts_pmem_file));
 	while ((rc = getopt_long(argc, argv,
-				 "P:N:T:C:c:o:d:a:r:nAs:ztf:hUFRBvIiu",
+				 "P:N:T:C:c:o:d:a:r:nAs:zbtf:hUFRBvIiu",
 				 ts_ops, NULL)) != -1) {
 		char	*endp;
 
@@ -1060,6 +1079,9 @@ main(int argc, char **argv)
 		case 'z':
 			ts_zero_copy = true;
 			break;
+		case 'b':
+			ts_bounce = true;
+			break;
 		case 'f':
 			strncpy(ts_pmem_file, optarg, PATH_MAX - 1);
 			break;
@@ -1140,6 +1162,13 @@ main(int argc, char **argv)
 		return -1;
 	}
 
+	if (ts_bounce && ts_level != TS_LVL_DAOS) {
+		fprintf(stderr, "bounce can only run with -T \"daos\"\n");
+		if (ts_ctx.tsc_mpi_rank == 0)
+			ts_print_usage();
+		return -1;
+	}
+
 	if (ts_dkey_p_obj == 0 || ts_akey_p_dkey == 0 ||
 	    ts_recx_p_akey == 0) {
 		fprintf(stderr, "Invalid arguments %d/%d/%d/\n",
@@ -1211,6 +1240,10 @@ main(int argc, char **argv)
 	if (rc)
 		return -1;
 
+	if (ts_bounce && ts_ctx.tsc_mpi_rank == 0)
+		daos_mgmt_set_params(NULL, -1, DSS_OBJ_ZC_THRESHOLD,
+				     UINT32_MAX, 0, NULL);
+
 	if (ts_ctx.tsc_mpi_rank == 0)
 		fprintf(stdout, "Started...\n");
 
@@ -1237,6 +1270,10 @@ main(int argc, char **argv)
 		show_result(now, then, vsize, perf_tests_name[i]);
 	}
 
+	if (ts_bounce && ts_ctx.tsc_mpi_rank == 0)
+		daos_mgmt_set_params(NULL, -1, DSS_OBJ_ZC_THRESHOLD, 0, 0,
+				     NULL);
+
 	dts_ctx_fini(&ts_ctx);
 	MPI_Finalize();
 
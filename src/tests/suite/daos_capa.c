@@ -529,6 +529,169 @@ update_ro(void **state)
 	MPI_Barrier(MPI_COMM_WORLD);
 }
 
+/** update or fetch one record of \a oid through \a coh */
+static int
+capa_obj_io(daos_handle_t coh, daos_obj_id_t oid, bool update)
+{
+	daos_handle_t		 oh;
+	daos_iov_t		 dkey;
+	daos_sg_list_t		 sgl;
+	daos_iov_t		 sg_iov;
+	daos_iod_t		 iod;
+	daos_recx_t		 recx;
+	char			 buf[STACK_BUF_LEN];
+	int			 rc;
+
+	rc = daos_obj_open(coh, oid, 0, &oh, NULL);
+	assert_int_equal(rc, 0);
+
+	daos_iov_set(&dkey, "dkey", strlen("dkey"));
+	daos_iov_set(&sg_iov, buf, sizeof(buf));
+	sgl.sg_nr		= 1;
+	sgl.sg_nr_out		= 0;
+	sgl.sg_iovs		= &sg_iov;
+	daos_iov_set(&iod.iod_name, "akey", strlen("akey"));
+	daos_csum_set(&iod.iod_kcsum, NULL, 0);
+	iod.iod_nr	= 1;
+	iod.iod_size	= 1;
+	recx.rx_idx	= 0;
+	recx.rx_nr	= sizeof(buf);
+	iod.iod_recxs	= &recx;
+	iod.iod_eprs	= NULL;
+	iod.iod_csums	= NULL;
+	iod.iod_type	= DAOS_IOD_ARRAY;
+
+	if (update) {
+		memset(buf, 'a', sizeof(buf));
+		rc = daos_obj_update(oh, DAOS_TX_NONE, &dkey, 1, &iod, &sgl,
+				     NULL);
+	} else {
+		rc = daos_obj_fetch(oh, DAOS_TX_NONE, &dkey, 1, &iod, &sgl,
+				    NULL, NULL);
+	}
+
+	assert_int_equal(daos_obj_close(oh, NULL), 0);
+	return rc;
+}
+
+/** update/fetch with closed container handle */
+static void
+io_closed_coh(void **state)
+{
+	test_arg_t		*arg = *state;
+	daos_handle_t		 coh;
+	daos_iov_t		 ghdl = { NULL, 0, 0 };
+	daos_obj_id_t		 oid_used;
+	daos_obj_id_t		 oid_new;
+	int			 rc;
+
+	if (arg->myrank != 0)
+		goto out;
+
+	rc = daos_cont_open(arg->pool.poh, arg->co_uuid, DAOS_COO_RW, &coh,
+			    NULL, NULL);
+	assert_int_equal(rc, 0);
+
+	/** only the target of the tiny object opens the handle */
+	oid_used = dts_oid_gen(DAOS_OC_TINY_RW, 0, arg->myrank);
+	rc = capa_obj_io(coh, oid_used, true);
+	assert_int_equal(rc, 0);
+
+	/** keep a copy of the handle across the close */
+	rc = daos_cont_local2global(coh, &ghdl);
+	assert_int_equal(rc, 0);
+	D_ALLOC(ghdl.iov_buf, ghdl.iov_buf_len);
+	assert_non_null(ghdl.iov_buf);
+	ghdl.iov_len = ghdl.iov_buf_len;
+	rc = daos_cont_local2global(coh, &ghdl);
+	assert_int_equal(rc, 0);
+
+	print_message("closing container handle\n");
+	rc = daos_cont_close(coh, NULL);
+	assert_int_equal(rc, 0);
+
+	rc = daos_cont_global2local(arg->pool.poh, ghdl, &coh);
+	assert_int_equal(rc, 0);
+	D_FREE(ghdl.iov_buf);
+
+	print_message("update/fetch on the target which opened it ...\n");
+	assert_int_equal(capa_obj_io(coh, oid_used, true), -DER_NO_HDL);
+	assert_int_equal(capa_obj_io(coh, oid_used, false), -DER_NO_HDL);
+
+	print_message("update/fetch on targets which never opened it ...\n");
+	oid_new = dts_oid_gen(DAOS_OC_REPL_MAX_RW, 0, arg->myrank);
+	assert_int_equal(capa_obj_io(coh, oid_new, true), -DER_NO_HDL);
+	assert_int_equal(capa_obj_io(coh, oid_new, false), -DER_NO_HDL);
+	print_message("got -DER_NO_HDL as expected\n");
+
+	rc = daos_cont_close(coh, NULL);
+	assert_int_equal(rc, 0);
+out:
+	MPI_Barrier(MPI_COMM_WORLD);
+}
+
+/**
+ * Global container handle, see struct dc_cont_glob, only used to forge a
+ * handle the servers have never heard of.
+ */
+struct capa_cont_glob {
+	uint32_t	ccg_magic;
+	uint32_t	ccg_padding;
+	uuid_t		ccg_pool_hdl;
+	uuid_t		ccg_uuid;
+	uuid_t		ccg_cont_hdl;
+	uint64_t	ccg_capas;
+};
+
+/** update/fetch with container handle unknown to the servers */
+static void
+io_unknown_coh(void **state)
+{
+	test_arg_t		*arg = *state;
+	daos_handle_t		 coh;
+	daos_iov_t		 ghdl = { NULL, 0, 0 };
+	struct capa_cont_glob	*glob;
+	daos_obj_id_t		 oid;
+	int			 rc;
+
+	if (arg->myrank != 0)
+		goto out;
+
+	rc = daos_cont_open(arg->pool.poh, arg->co_uuid, DAOS_COO_RW, &coh,
+			    NULL, NULL);
+	assert_int_equal(rc, 0);
+
+	rc = daos_cont_local2global(coh, &ghdl);
+	assert_int_equal(rc, 0);
+	assert_int_equal(ghdl.iov_buf_len, sizeof(*glob));
+	D_ALLOC(ghdl.iov_buf, ghdl.iov_buf_len);
+	assert_non_null(ghdl.iov_buf);
+	ghdl.iov_len = ghdl.iov_buf_len;
+	rc = daos_cont_local2global(coh, &ghdl);
+	assert_int_equal(rc, 0);
+
+	rc = daos_cont_close(coh, NULL);
+	assert_int_equal(rc, 0);
+
+	/** same container and capabilities, but a new handle uuid */
+	glob = ghdl.iov_buf;
+	uuid_generate(glob->ccg_cont_hdl);
+	rc = daos_cont_global2local(arg->pool.poh, ghdl, &coh);
+	assert_int_equal(rc, 0);
+	D_FREE(ghdl.iov_buf);
+
+	print_message("update/fetch with unknown container handle ...\n");
+	oid = dts_oid_gen(DAOS_OC_REPL_MAX_RW, 0, arg->myrank);
+	assert_int_equal(capa_obj_io(coh, oid, true), -DER_NO_HDL);
+	assert_int_equal(capa_obj_io(coh, oid, false), -DER_NO_HDL);
+	print_message("got -DER_NO_HDL as expected\n");
+
+	/** closing a handle the service does not know succeeds */
+	rc = daos_cont_close(coh, NULL);
+	assert_int_equal(rc, 0);
+out:
+	MPI_Barrier(MPI_COMM_WORLD);
+}
 
 static const struct CMUnitTest capa_tests[] = {
 	{ "CAPA1: query pool with invalid pool handle",
@@ -545,6 +708,10 @@ static const struct CMUnitTest capa_tests[] = {
 	  io_invalid_coh, NULL, test_case_teardown},
 	{ "CAPA7: update with read-only container handle",
 	  update_ro, NULL, test_case_teardown},
+	{ "CAPA8: update/fetch with closed container handle",
+	  io_closed_coh, NULL, test_case_teardown},
+	{ "CAPA9: update/fetch with unknown container handle",
+	  io_unknown_coh, NULL, test_case_teardown},
 };
 
 static int
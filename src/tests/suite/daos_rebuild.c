@@ -1718,6 +1718,42 @@ multi_pools_rebuild_concurrently(void **state)
 	}
 }
 
+static void
+rebuild_resume_scan_from_ckpt(void **state)
+{
+	test_arg_t	*arg = *state;
+	daos_obj_id_t	oids[OBJ_NR];
+	int		i;
+
+	if (!test_runable(arg, 6) || arg->pool.svc.rl_nr == 1)
+		return;
+
+	for (i = 0; i < OBJ_NR; i++) {
+		oids[i] = dts_oid_gen(DAOS_OC_R3S_SPEC_RANK, 0, arg->myrank);
+		oids[i] = dts_oid_set_rank(oids[i], ranks_to_kill[0]);
+	}
+
+	rebuild_io(arg, oids, OBJ_NR);
+
+	/* Scanners checkpoint after the first object and wait there, then
+	 * the leader change restarts the scan, which resumes from the
+	 * checkpoints.
+	 */
+	if (arg->myrank == 0)
+		daos_mgmt_set_params(arg->group, -1, DSS_KEY_FAIL_LOC,
+				 DAOS_REBUILD_TGT_CKPT_HANG | DAOS_FAIL_VALUE,
+				 0, NULL);
+	MPI_Barrier(MPI_COMM_WORLD);
+	arg->rebuild_cb = rebuild_change_leader_cb;
+
+	rebuild_single_pool_target(arg, ranks_to_kill[0]);
+
+	arg->rebuild_cb = NULL;
+
+	/* Verify the data */
+	rebuild_io_validate(arg, oids, OBJ_NR, true);
+}
+
 /** create a new pool/container for each test */
 static const struct CMUnitTest rebuild_tests[] = {
 	{"REBUILD1: rebuild small rec mulitple dkeys",
@@ -1786,6 +1822,8 @@ static const struct CMUnitTest rebuild_tests[] = {
 	 rebuild_fail_all_replicas, NULL, test_case_teardown},
 	{"REBUILD33: multi-pools rebuild concurrently",
 	 multi_pools_rebuild_concurrently, NULL, test_case_teardown},
+	{"REBUILD34: resume scan from checkpoint with master change",
+	 rebuild_resume_scan_from_ckpt, NULL, test_case_teardown},
 };
 
 #define REBUILD_POOL_SIZE	(10ULL << 30)
@@ -436,8 +436,9 @@ pool_op_hdlr(int argc, char *argv[])
 			else
 				sstr = "busy";
 
-			D_PRINT("Rebuild %s, "DF_U64" objs, "DF_U64" recs\n",
-				sstr, rstat->rs_obj_nr, rstat->rs_rec_nr);
+			D_PRINT("Rebuild %s, "DF_U64" objs, "DF_U64" recs, "
+				DF_U64" bytes\n", sstr, rstat->rs_obj_nr,
+				rstat->rs_rec_nr, rstat->rs_size);
 		} else {
 			D_PRINT("Rebuild failed, rc=%d, status=%d\n",
 				rc, rstat->rs_errno);
@@ -24,6 +24,7 @@
 #define __EVT_PRIV_H__
 
 #include <daos_srv/evtree.h>
+#include <daos/slab.h>
 
 /**
  * Tree node types.
@@ -82,6 +83,8 @@ struct evt_context {
 	uint16_t			 tc_depth;
 	/** cached number of bytes per entry */
 	uint32_t			 tc_inob;
+	/** extents overlapping with the last inserted one in its leaf */
+	uint32_t			 tc_overlap;
 	/** cached tree feature bits (reduce PMEM access) */
 	uint64_t			 tc_feats;
 	/** memory instance (PMEM or DRAM) */
@@ -212,7 +215,7 @@ evt_tcx_decref(struct evt_context *tcx)
 		tcx->tc_magic = EVT_HDL_DEAD;
 		/* Free any memory allocated by embedded iterator */
 		evt_ent_array_fini(&tcx->tc_iter.it_entries);
-		D_FREE(tcx);
+		daos_slab_free(DAOS_SLAB_EVT_CTX, tcx);
 	}
 }
 
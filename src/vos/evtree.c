@@ -22,6 +22,7 @@
  */
 #define D_LOGFAC	DD_FAC(vos)
 
+#include <gurt/heap.h>
 #include "evt_priv.h"
 #include "vos_internal.h"
 
@@ -201,6 +202,35 @@ evt_weight_diff(struct evt_weight *wt1, struct evt_weight *wt2,
 	wt_diff->wt_minor = wt1->wt_minor - wt2->wt_minor;
 }
 
+/** When we go over the embedded limit, set a minimum allocation */
+#define EVT_MIN_ALLOC 4096
+
+/**
+ * Allocate entries for an entry list. Arrays of the minimum allocation size
+ * are by far the most common ones, they are recycled by the slab cache.
+ */
+static struct evt_list_entry *
+ent_array_ents_alloc(uint32_t size)
+{
+	struct evt_list_entry	*ents;
+
+	if (size == EVT_MIN_ALLOC)
+		return daos_slab_alloc(DAOS_SLAB_EVT_ENTS,
+				       sizeof(*ents) * EVT_MIN_ALLOC);
+
+	D_ALLOC_ARRAY(ents, size);
+	return ents;
+}
+
+static void
+ent_array_ents_free(struct evt_list_entry *ents, uint32_t size)
+{
+	if (size == EVT_MIN_ALLOC)
+		daos_slab_free(DAOS_SLAB_EVT_ENTS, ents);
+	else
+		D_FREE(ents);
+}
+
 /** Initialize an entry list */
 void
 evt_ent_array_init(struct evt_entry_array *ent_array)
@@ -215,14 +245,11 @@ void
 evt_ent_array_fini(struct evt_entry_array *ent_array)
 {
 	if (ent_array->ea_size > EVT_EMBEDDED_NR)
-		D_FREE(ent_array->ea_ents);
+		ent_array_ents_free(ent_array->ea_ents, ent_array->ea_size);
 
 	ent_array->ea_size = ent_array->ea_ent_nr = 0;
 }
 
-/** When we go over the embedded limit, set a minimum allocation */
-#define EVT_MIN_ALLOC 4096
-
 static void
 ent_array_reset(struct evt_context *tcx, struct evt_entry_array *ent_array)
 {
@@ -240,14 +267,14 @@ ent_array_resize(struct evt_context *tcx, struct evt_entry_array *ent_array,
 {
 	struct evt_list_entry	*ents;
 
-	D_ALLOC_ARRAY(ents, new_size);
+	ents = ent_array_ents_alloc(new_size);
 	if (ents == NULL)
 		return -DER_NOMEM;
 
 	memcpy(ents, ent_array->ea_ents,
 	       sizeof(ents[0]) * ent_array->ea_ent_nr);
 	if (ent_array->ea_ents != ent_array->ea_embedded_ents)
-		D_FREE(ent_array->ea_ents);
+		ent_array_ents_free(ent_array->ea_ents, ent_array->ea_size);
 	ent_array->ea_ents = ents;
 	ent_array->ea_size = new_size;
 	return 0;
@@ -636,32 +663,35 @@ evt_find_visible(struct evt_context *tcx, struct evt_entry_array *ent_array,
 	return 0;
 }
 
+/** Algorithm used by evt_ent_array_sort, see evt_sort_type_set() */
+static enum evt_sort_type evt_sort_alg = EVT_SORT_AUTO;
+
+/** Below this number of entries, the setup cost of the sweep (scratch space,
+ * heaps) outweighs what it saves over the legacy algorithm.
+ */
+#define EVT_SWEEP_MIN_NR	EVT_EMBEDDED_NR
+
+void
+evt_sort_type_set(enum evt_sort_type type)
+{
+	evt_sort_alg = type;
+}
+
 /** Place all entries into covered list in sorted order based on selected
  * range.   Then walk through the range to find only extents that are visible
  * and place them in the main list.   Update the selection bounds for visible
  * rectangles.
  */
-int
-evt_ent_array_sort(struct evt_context *tcx, struct evt_entry_array *ent_array,
-		   int flags)
+static int
+evt_ent_array_sort_legacy(struct evt_context *tcx,
+			  struct evt_entry_array *ent_array, int flags)
 {
 	struct evt_list_entry	*ents;
-	struct evt_entry	*ent;
 	int			(*compar)(const void *, const void *);
 	int			 total;
 	int			 num_visible;
 	int			 rc;
 
-	if (ent_array->ea_ent_nr == 0)
-		return 0;
-
-	if (ent_array->ea_ent_nr == 1) {
-		ent = evt_ent_array_get(ent_array, 0);
-		ent->en_visibility = EVT_VISIBLE;
-		num_visible = 1;
-		goto re_sort;
-	}
-
 	for (;;) {
 		ents = ent_array->ea_ents;
 
@@ -680,7 +710,6 @@ evt_ent_array_sort(struct evt_context *tcx, struct evt_entry_array *ent_array,
 		break;
 	}
 
-re_sort:
 	ents = ent_array->ea_ents;
 	total = ent_array->ea_ent_nr;
 	compar = evt_ent_list_cmp;
@@ -693,14 +722,425 @@ re_sort:
 		total = ent_array->ea_ent_nr - num_visible;
 	}
 
-	if (ent_array->ea_ent_nr != 1)
-		qsort(ents, ent_array->ea_ent_nr, sizeof(ents[0]), compar);
-
+	qsort(ents, ent_array->ea_ent_nr, sizeof(ents[0]), compar);
 	ent_array->ea_ent_nr = total;
 
 	return 0;
 }
 
+/** Sweep state of an input entry */
+struct evt_sweep_ent {
+	/** Link in the active heap, ordered by epoch */
+	struct d_binheap_node	 se_node;
+	/** The input entry */
+	struct evt_entry	*se_ent;
+	/** First offset of the entry which is not classified yet */
+	daos_off_t		 se_cursor;
+	/** Admission order, breaks ties between entries of the same epoch */
+	uint32_t		 se_seq;
+	/** All offsets of the entry have been classified */
+	bool			 se_done;
+};
+
+/** A sorted run of input entries, normally the hits of one leaf node */
+struct evt_sweep_run {
+	struct d_binheap_node	 sr_node;
+	/** Current head of the run */
+	struct evt_list_entry	*sr_cur;
+	/** End of the run (exclusive) */
+	struct evt_list_entry	*sr_end;
+};
+
+struct evt_sweep {
+	struct evt_context	*sw_tcx;
+	/** Runs of the input array, ordered by their head entry */
+	struct d_binheap	 sw_runs;
+	/** The only run of a sorted input array, sw_runs isn't used if set */
+	struct evt_sweep_run	*sw_run;
+	/** Entries overlapping the sweep position, latest epoch on top */
+	struct d_binheap	 sw_active;
+	/** Visible entries grow up from the start of the output array, covered
+	 * entries grow down from the end of it.
+	 */
+	struct evt_list_entry	*sw_out;
+	uint32_t		 sw_out_size;
+	uint32_t		 sw_vis_nr;
+	uint32_t		 sw_cov_nr;
+	/** Owner of the last visible entry, it can be extended in place */
+	struct evt_sweep_ent	*sw_last;
+	/** Covered entries are requested */
+	bool			 sw_covered;
+};
+
+static bool
+evt_sweep_run_cmp(struct d_binheap_node *a, struct d_binheap_node *b)
+{
+	struct evt_sweep_run	*ra;
+	struct evt_sweep_run	*rb;
+
+	ra = container_of(a, struct evt_sweep_run, sr_node);
+	rb = container_of(b, struct evt_sweep_run, sr_node);
+
+	return evt_ent_cmp(&ra->sr_cur->le_ent, &rb->sr_cur->le_ent, 0) < 0;
+}
+
+static bool
+evt_sweep_ent_cmp(struct d_binheap_node *a, struct d_binheap_node *b)
+{
+	struct evt_sweep_ent	*sa;
+	struct evt_sweep_ent	*sb;
+
+	sa = container_of(a, struct evt_sweep_ent, se_node);
+	sb = container_of(b, struct evt_sweep_ent, se_node);
+
+	if (sa->se_ent->en_epoch != sb->se_ent->en_epoch)
+		return sa->se_ent->en_epoch > sb->se_ent->en_epoch;
+
+	return sa->se_seq > sb->se_seq;
+}
+
+static struct d_binheap_ops evt_sweep_run_ops = {
+	.hop_enter	= NULL,
+	.hop_exit	= NULL,
+	.hop_compare	= evt_sweep_run_cmp,
+};
+
+static struct d_binheap_ops evt_sweep_ent_ops = {
+	.hop_enter	= NULL,
+	.hop_exit	= NULL,
+	.hop_compare	= evt_sweep_ent_cmp,
+};
+
+/** Return the next input entry in sorted order, or NULL if there is none */
+static struct evt_list_entry *
+evt_sweep_peek(struct evt_sweep *sw)
+{
+	struct d_binheap_node	*node;
+
+	if (sw->sw_run != NULL)
+		return sw->sw_run->sr_cur == sw->sw_run->sr_end ?
+		       NULL : sw->sw_run->sr_cur;
+
+	node = d_binheap_root(&sw->sw_runs);
+	if (node == NULL)
+		return NULL;
+
+	return container_of(node, struct evt_sweep_run, sr_node)->sr_cur;
+}
+
+/** Consume the entry returned by evt_sweep_peek */
+static int
+evt_sweep_advance(struct evt_sweep *sw)
+{
+	struct evt_sweep_run	*run;
+
+	if (sw->sw_run != NULL) {
+		sw->sw_run->sr_cur++;
+		return 0;
+	}
+
+	run = container_of(d_binheap_root(&sw->sw_runs), struct evt_sweep_run,
+			   sr_node);
+	d_binheap_remove(&sw->sw_runs, &run->sr_node);
+
+	run->sr_cur++;
+	if (run->sr_cur == run->sr_end)
+		return 0;
+
+	return d_binheap_insert(&sw->sw_runs, &run->sr_node);
+}
+
+/** Fill \a dst with the [lo, hi] part of \a src */
+static void
+evt_sweep_fill(struct evt_sweep *sw, struct evt_entry *dst,
+	       const struct evt_entry *src, daos_off_t lo, daos_off_t hi,
+	       uint32_t flags)
+{
+	*dst = *src;
+	dst->en_visibility = flags | (src->en_visibility & EVT_PARTIAL);
+	if (lo != src->en_sel_ext.ex_lo || hi != src->en_sel_ext.ex_hi)
+		dst->en_visibility |= EVT_PARTIAL;
+
+	dst->en_sel_ext.ex_lo = lo;
+	dst->en_sel_ext.ex_hi = hi;
+	evt_ent_addr_update(sw->sw_tcx, dst, lo - src->en_sel_ext.ex_lo);
+}
+
+/** Emit the unclassified part of \a se up to \a hi as a covered entry */
+static void
+evt_sweep_covered(struct evt_sweep *sw, struct evt_sweep_ent *se,
+		  daos_off_t hi)
+{
+	struct evt_list_entry	*le;
+
+	if (!sw->sw_covered)
+		return;
+
+	sw->sw_cov_nr++;
+	D_ASSERT(sw->sw_vis_nr + sw->sw_cov_nr <= sw->sw_out_size);
+	le = &sw->sw_out[sw->sw_out_size - sw->sw_cov_nr];
+	evt_sweep_fill(sw, &le->le_ent, se->se_ent, se->se_cursor, hi,
+		       EVT_COVERED);
+}
+
+/** Emit [lo, hi] of \a se as visible, anything it skipped is covered */
+static void
+evt_sweep_visible(struct evt_sweep *sw, struct evt_sweep_ent *se,
+		  daos_off_t lo, daos_off_t hi)
+{
+	struct evt_entry	*ent;
+
+	if (se->se_cursor < lo)
+		evt_sweep_covered(sw, se, lo - 1);
+	se->se_cursor = hi + 1;
+	se->se_done = hi == se->se_ent->en_sel_ext.ex_hi;
+
+	if (sw->sw_last == se) {
+		ent = &sw->sw_out[sw->sw_vis_nr - 1].le_ent;
+		if (ent->en_sel_ext.ex_hi + 1 == lo) {
+			/* the same extent is still on top, extend it */
+			lo = ent->en_sel_ext.ex_lo;
+			goto fill;
+		}
+	}
+
+	D_ASSERT(sw->sw_vis_nr + sw->sw_cov_nr < sw->sw_out_size);
+	ent = &sw->sw_out[sw->sw_vis_nr++].le_ent;
+	sw->sw_last = se;
+fill:
+	evt_sweep_fill(sw, ent, se->se_ent, lo, hi, EVT_VISIBLE);
+}
+
+/** Remove \a se from the active heap, the rest of it is covered */
+static void
+evt_sweep_retire(struct evt_sweep *sw, struct evt_sweep_ent *se)
+{
+	d_binheap_remove(&sw->sw_active, &se->se_node);
+	if (!se->se_done)
+		evt_sweep_covered(sw, se, se->se_ent->en_sel_ext.ex_hi);
+}
+
+/** Walk the selected range from left to right. The entries are admitted in
+ * sorted order by merging the sorted runs of the input array; the leaves of
+ * the tree are sorted so every leaf contributes one run.  At any offset, the
+ * active entry with the highest epoch is the visible one.
+ */
+static int
+evt_sweep(struct evt_sweep *sw, struct evt_sweep_ent *ses,
+	  struct evt_list_entry *ents)
+{
+	struct evt_list_entry	*next;
+	struct evt_sweep_ent	*se;
+	struct evt_extent	*ext;
+	daos_off_t		 pos = 0;
+	daos_off_t		 end;
+	uint32_t		 seq = 0;
+	int			 rc;
+
+	next = evt_sweep_peek(sw);
+	while (1) {
+		if (d_binheap_is_empty(&sw->sw_active)) {
+			if (next == NULL)
+				break;
+			pos = next->le_ent.en_sel_ext.ex_lo;
+		}
+
+		while (next != NULL && next->le_ent.en_sel_ext.ex_lo <= pos) {
+			se = &ses[next - ents];
+			se->se_seq = seq++;
+			rc = d_binheap_insert(&sw->sw_active, &se->se_node);
+			if (rc != 0)
+				return rc;
+
+			rc = evt_sweep_advance(sw);
+			if (rc != 0)
+				return rc;
+			next = evt_sweep_peek(sw);
+		}
+
+		se = container_of(d_binheap_root(&sw->sw_active),
+				  struct evt_sweep_ent, se_node);
+		ext = &se->se_ent->en_sel_ext;
+		if (ext->ex_hi < pos) {
+			evt_sweep_retire(sw, se);
+			continue;
+		}
+
+		end = ext->ex_hi;
+		if (next != NULL && next->le_ent.en_sel_ext.ex_lo <= end)
+			end = next->le_ent.en_sel_ext.ex_lo - 1;
+
+		evt_sweep_visible(sw, se, pos, end);
+		if (end == ~(0ULL))
+			break; /* nothing can start after this */
+		pos = end + 1;
+	}
+
+	while (!d_binheap_is_empty(&sw->sw_active)) {
+		se = container_of(d_binheap_root(&sw->sw_active),
+				  struct evt_sweep_ent, se_node);
+		evt_sweep_retire(sw, se);
+	}
+
+	return 0;
+}
+
+/** Resolve visibility with a sweep line. Unlike the legacy algorithm, the
+ * output array is sized up front so there is no restart on reallocation,
+ * visible entries are produced in order, and covered entries are only
+ * generated (and sorted) when they are requested.
+ */
+static int
+evt_ent_array_sort_sweep(struct evt_context *tcx,
+			 struct evt_entry_array *ent_array, int flags)
+{
+	struct evt_list_entry	*ents = ent_array->ea_ents;
+	struct evt_sweep_ent	*ses;
+	struct evt_sweep_run	*runs;
+	struct evt_list_entry	*out;
+	struct evt_sweep	 sw = { 0 };
+	uint32_t		 nr = ent_array->ea_ent_nr;
+	uint32_t		 run_nr = 0;
+	uint32_t		 total;
+	uint32_t		 i;
+	int			 rc;
+
+	sw.sw_tcx = tcx;
+	sw.sw_covered = !evt_flags_equal(flags, EVT_VISIBLE);
+	/* Extents only start at an input lo or right after an input hi, so
+	 * there are at most 2 visible entries per input entry.  An input entry
+	 * has at most one more covered entry than it has visible ones.
+	 */
+	sw.sw_out_size = sw.sw_covered ? nr * 5 : nr * 2;
+	/* Take it from the slab rather than zeroing a smaller array */
+	if (sw.sw_out_size < EVT_MIN_ALLOC)
+		sw.sw_out_size = EVT_MIN_ALLOC;
+
+	/* One scratch buffer for the sweep state and the runs */
+	D_ALLOC(ses, nr * (sizeof(*ses) + sizeof(*runs)));
+	if (ses == NULL)
+		return -DER_NOMEM;
+	runs = (struct evt_sweep_run *)&ses[nr];
+
+	sw.sw_out = ent_array_ents_alloc(sw.sw_out_size);
+	if (sw.sw_out == NULL)
+		D_GOTO(free_ses, rc = -DER_NOMEM);
+
+	rc = d_binheap_create_inplace(DBH_FT_NOLOCK, 0, NULL,
+				      &evt_sweep_ent_ops, &sw.sw_active);
+	if (rc != 0)
+		D_GOTO(free_out, rc = -DER_NOMEM);
+
+	runs[0].sr_cur = &ents[0];
+	for (i = 0; i < nr; i++) {
+		ses[i].se_ent = &ents[i].le_ent;
+		ses[i].se_cursor = ents[i].le_ent.en_sel_ext.ex_lo;
+
+		if (i == 0 || evt_ent_cmp(&ents[i - 1].le_ent,
+					  &ents[i].le_ent, 0) <= 0)
+			continue;
+		runs[run_nr++].sr_end = &ents[i];
+		runs[run_nr].sr_cur = &ents[i];
+	}
+	runs[run_nr++].sr_end = &ents[nr];
+
+	if (run_nr == 1) {
+		/* Already sorted, e.g. all hits are in one leaf */
+		sw.sw_run = &runs[0];
+	} else {
+		rc = d_binheap_create_inplace(DBH_FT_NOLOCK, 0, NULL,
+					      &evt_sweep_run_ops, &sw.sw_runs);
+		if (rc != 0)
+			D_GOTO(out, rc = -DER_NOMEM);
+
+		for (i = 0; i < run_nr; i++) {
+			rc = d_binheap_insert(&sw.sw_runs, &runs[i].sr_node);
+			if (rc != 0)
+				D_GOTO(free_runs_heap, rc);
+		}
+	}
+
+	rc = evt_sweep(&sw, ses, ents);
+	if (rc != 0)
+		D_GOTO(free_runs_heap, rc);
+
+	D_DEBUG(DB_TRACE, "%u entries in %u runs, %u visible, %u covered\n",
+		nr, run_nr, sw.sw_vis_nr, sw.sw_cov_nr);
+
+	out = sw.sw_out;
+	total = sw.sw_vis_nr;
+	if (sw.sw_covered) {
+		uint32_t	first = 0;
+
+		if (!evt_flags_equal(flags, EVT_COVERED)) {
+			first = sw.sw_vis_nr;
+			total += sw.sw_cov_nr;
+		} else {
+			total = sw.sw_cov_nr;
+		}
+		memmove(&out[first], &out[sw.sw_out_size - sw.sw_cov_nr],
+			sizeof(out[0]) * sw.sw_cov_nr);
+		/* Covered entries are emitted as their extents are retired
+		 * rather than in offset order.
+		 */
+		qsort(out, total, sizeof(out[0]), evt_ent_list_cmp);
+	}
+
+	/* Keep the larger array, the output always fits in it */
+	if (sw.sw_out_size <= ent_array->ea_size) {
+		memcpy(ent_array->ea_ents, out, sizeof(out[0]) * total);
+	} else {
+		if (ent_array->ea_ents != ent_array->ea_embedded_ents)
+			ent_array_ents_free(ent_array->ea_ents,
+					    ent_array->ea_size);
+		ent_array->ea_ents = out;
+		ent_array->ea_size = sw.sw_out_size;
+		if (ent_array->ea_max < ent_array->ea_size)
+			ent_array->ea_max = ent_array->ea_size;
+		sw.sw_out = NULL;
+	}
+	ent_array->ea_ent_nr = total;
+free_runs_heap:
+	if (sw.sw_run == NULL)
+		d_binheap_destroy_inplace(&sw.sw_runs);
+out:
+	d_binheap_destroy_inplace(&sw.sw_active);
+free_out:
+	if (sw.sw_out != NULL)
+		ent_array_ents_free(sw.sw_out, sw.sw_out_size);
+free_ses:
+	D_FREE(ses);
+	return rc;
+}
+
+/** Resolve the visibility of the entries of \a ent_array and only keep the
+ * ones selected by \a flags, sorted by start offset and high epoch.
+ */
+int
+evt_ent_array_sort(struct evt_context *tcx, struct evt_entry_array *ent_array,
+		   int flags)
+{
+	struct evt_entry	*ent;
+
+	if (ent_array->ea_ent_nr == 0)
+		return 0;
+
+	if (ent_array->ea_ent_nr == 1) {
+		ent = evt_ent_array_get(ent_array, 0);
+		ent->en_visibility = EVT_VISIBLE;
+		if (evt_flags_equal(flags, EVT_COVERED))
+			ent_array->ea_ent_nr = 0;
+		return 0;
+	}
+
+	if (evt_sort_alg == EVT_SORT_LEGACY ||
+	    (evt_sort_alg == EVT_SORT_AUTO &&
+	     ent_array->ea_ent_nr <= EVT_SWEEP_MIN_NR))
+		return evt_ent_array_sort_legacy(tcx, ent_array, flags);
+
+	return evt_ent_array_sort_sweep(tcx, ent_array, flags);
+}
+
 daos_handle_t
 evt_tcx2hdl(struct evt_context *tcx)
 {
@@ -785,7 +1225,7 @@ evt_tcx_create(TMMID(struct evt_root) root_mmid, struct evt_root *root,
 	int			 depth;
 	int			 rc;
 
-	D_ALLOC_PTR(tcx);
+	tcx = daos_slab_alloc(DAOS_SLAB_EVT_CTX, sizeof(*tcx));
 	if (tcx == NULL)
 		return -DER_NOMEM;
 
@@ -877,16 +1317,11 @@ evt_desc_free(struct evt_context *tcx, struct evt_desc *desc, daos_size_t size)
 		rc = umem_free(evt_umm(tcx), mmid);
 	} else {
 		struct vea_space_info *vsi = tcx->tc_blks_info;
-		uint64_t blk_off;
-		uint32_t blk_cnt;
 
 		D_ASSERT(addr->ba_type == BIO_ADDR_NVME);
 		D_ASSERT(vsi != NULL);
 
-		blk_off = vos_byte2blkoff(addr->ba_off);
-		blk_cnt = vos_byte2blkcnt(size);
-
-		rc = vea_free(vsi, blk_off, blk_cnt);
+		rc = vos_blk_free(vsi, addr, size);
 		if (rc)
 			D_ERROR("Error on block free. %d\n", rc);
 	}
@@ -894,6 +1329,67 @@ evt_desc_free(struct evt_context *tcx, struct evt_desc *desc, daos_size_t size)
 	return rc;
 }
 
+/** Bytes of the descriptor of \a ent, including the per-chunk checksums */
+static daos_size_t
+evt_desc_size(struct evt_context *tcx, const struct evt_entry_in *ent)
+{
+	if (!(tcx->tc_feats & EVT_FEAT_CSUM))
+		return sizeof(struct evt_desc);
+
+	return sizeof(struct evt_desc) + sizeof(struct evt_desc_csum) +
+	       ent->ei_chunk_csum.cs_len;
+}
+
+static inline struct evt_desc_csum *
+evt_desc2csum(struct evt_context *tcx, struct evt_desc *desc)
+{
+	if (!(tcx->tc_feats & EVT_FEAT_CSUM))
+		return NULL;
+
+	return (struct evt_desc_csum *)&desc->dc_body[0];
+}
+
+static void
+evt_desc_set(struct evt_context *tcx, struct evt_desc *desc,
+	     const struct evt_entry_in *ent)
+{
+	struct evt_desc_csum	*dcc = evt_desc2csum(tcx, desc);
+
+	uuid_copy(desc->dc_cookie, ent->ei_cookie);
+	desc->dc_ex_addr = ent->ei_addr;
+	desc->dc_ver = ent->ei_ver;
+	desc->dc_csum = ent->ei_csum;
+	if (dcc == NULL)
+		return;
+
+	dcc->dcc_chunk_size = ent->ei_chunk_size;
+	dcc->dcc_type = ent->ei_chunk_csum.cs_type;
+	dcc->dcc_len = ent->ei_chunk_csum.cs_len;
+	if (dcc->dcc_len != 0)
+		memcpy(&dcc->dcc_csum[0], ent->ei_chunk_csum.cs_csum,
+		       dcc->dcc_len);
+}
+
+/** Allocate the descriptor of \a ent, its offset is returned by \a desc_off */
+static int
+evt_desc_alloc(struct evt_context *tcx, const struct evt_entry_in *ent,
+	       uint64_t *desc_off)
+{
+	TMMID(struct evt_desc)	 desc_mmid;
+	struct evt_desc		*desc;
+
+	desc_mmid = umem_zalloc_typed(evt_umm(tcx), struct evt_desc,
+				      evt_desc_size(tcx, ent));
+	if (TMMID_IS_NULL(desc_mmid))
+		return -DER_NOMEM;
+
+	desc = evt_tmmid2ptr(tcx, desc_mmid);
+	desc->dc_magic = EVT_DESC_MAGIC;
+	evt_desc_set(tcx, desc, ent);
+	*desc_off = desc_mmid.oid.off;
+	return 0;
+}
+
 /** check if a node is full */
 static bool
 evt_node_is_full(struct evt_context *tcx, uint64_t nd_off)
@@ -1555,6 +2051,27 @@ evt_insert_or_split(struct evt_context *tcx, const struct evt_entry_in *ent_new)
 	return rc;
 }
 
+/**
+ * Count the extents in leaf \a nd_off which overlap with \a rect, it's a
+ * hint for aggregation, see evt_query().
+ */
+static void
+evt_leaf_overlap(struct evt_context *tcx, uint64_t nd_off,
+		 const struct evt_rect *rect)
+{
+	struct evt_node	*nd = evt_off2node(tcx, nd_off);
+	int		 range;
+	int		 time;
+	int		 i;
+
+	for (i = 0; i < nd->tn_nr; i++) {
+		evt_rect_overlap(evt_node_rect_at(tcx, nd_off, i), rect,
+				 &range, &time);
+		if (range != RT_OVERLAP_NO)
+			tcx->tc_overlap++;
+	}
+}
+
 /** Insert a single entry to evtree */
 static int
 evt_insert_entry(struct evt_context *tcx, const struct evt_entry_in *ent)
@@ -1578,6 +2095,7 @@ evt_insert_entry(struct evt_context *tcx, const struct evt_entry_in *ent)
 
 		if (evt_node_is_leaf(tcx, nd_off)) {
 			evt_tcx_set_trace(tcx, level, nd_off, 0);
+			evt_leaf_overlap(tcx, nd_off, &ent->ei_rect);
 			break;
 		}
 
@@ -1609,13 +2127,16 @@ evt_insert_entry(struct evt_context *tcx, const struct evt_entry_in *ent)
 	return evt_insert_or_split(tcx, ent);
 }
 
-static void
+static int
 evt_desc_copy(struct evt_context *tcx, const struct evt_entry_in *ent)
 {
+	struct evt_node_entry	*ne;
+	struct evt_desc_csum	*dcc;
 	struct evt_desc		*dst_desc;
 	struct evt_trace	*trace;
 	uint64_t		 nd_off;
 	daos_size_t		 size;
+	int			 rc;
 
 	trace = &tcx->tc_trace[tcx->tc_depth - 1];
 	nd_off = trace->tr_node;
@@ -1627,10 +2148,29 @@ evt_desc_copy(struct evt_context *tcx, const struct evt_entry_in *ent)
 	/* Free the pmem that dst_desc references */
 	evt_desc_free(tcx, dst_desc, size);
 
-	uuid_copy(dst_desc->dc_cookie, ent->ei_cookie);
-	dst_desc->dc_ex_addr = ent->ei_addr;
-	dst_desc->dc_ver = ent->ei_ver;
-	dst_desc->dc_csum = ent->ei_csum;
+	dcc = evt_desc2csum(tcx, dst_desc);
+	if (dcc == NULL || dcc->dcc_len == ent->ei_chunk_csum.cs_len) {
+		rc = umem_tx_add_ptr(evt_umm(tcx), dst_desc,
+				     evt_desc_size(tcx, ent));
+		if (rc == 0)
+			evt_desc_set(tcx, dst_desc, ent);
+		return rc;
+	}
+
+	/* the checksums don't fit in the old descriptor, replace it */
+	if (!trace->tr_tx_added) {
+		rc = evt_node_tx_add(tcx, nd_off);
+		if (rc != 0)
+			return rc;
+		trace->tr_tx_added = true;
+	}
+
+	ne = evt_node_entry_at(tcx, nd_off, trace->tr_at);
+	rc = umem_free(evt_umm(tcx), evt_off2mmid(tcx, ne->ne_child));
+	if (rc != 0)
+		return rc;
+
+	return evt_desc_alloc(tcx, ent, &ne->ne_child);
 }
 
 /**
@@ -1655,6 +2195,19 @@ evt_insert(daos_handle_t toh, const struct evt_entry_in *entry)
 		return -DER_INVAL;
 	}
 
+	if ((tcx->tc_feats & EVT_FEAT_CSUM) && entry->ei_chunk_csum.cs_len &&
+	    (entry->ei_chunk_size == 0 || entry->ei_inob == 0 ||
+	     entry->ei_chunk_csum.cs_len %
+	     daos_csum_chunk_nr(entry->ei_inob *
+				evt_rect_width(&entry->ei_rect),
+				entry->ei_chunk_size) != 0)) {
+		D_ERROR("Invalid checksums of "DF_RECT": len %hu, chunk %u\n",
+			DP_RECT(&entry->ei_rect), entry->ei_chunk_csum.cs_len,
+			entry->ei_chunk_size);
+		return -DER_INVAL;
+	}
+
+	tcx->tc_overlap = 0;
 	evt_ent_array_init(&ent_array);
 
 	/* Phase-1: Check for overwrite */
@@ -1686,7 +2239,7 @@ evt_insert(daos_handle_t toh, const struct evt_entry_in *entry)
 		 * No copy for duplicate punch.
 		 */
 		if (entry->ei_inob > 0)
-			evt_desc_copy(tcx, entry);
+			rc = evt_desc_copy(tcx, entry);
 		goto out;
 	}
 
@@ -1700,12 +2253,27 @@ out:
 	return evt_tx_end(tcx, rc);
 }
 
+int
+evt_query(daos_handle_t toh, struct evt_stat *stat)
+{
+	struct evt_context	*tcx;
+
+	tcx = evt_hdl2tcx(toh);
+	if (tcx == NULL)
+		return -DER_NO_HDL;
+
+	stat->es_depth = tcx->tc_depth;
+	stat->es_overlap = tcx->tc_overlap;
+	return 0;
+}
+
 /** Fill the entry with the extent at the specified position of \a nd_off */
 void
 evt_entry_fill(struct evt_context *tcx, uint64_t nd_off,
 	       unsigned int at, const struct evt_rect *rect_srch,
 	       struct evt_entry *entry)
 {
+	struct evt_desc_csum *dcc;
 	struct evt_desc	   *desc;
 	struct evt_rect	   *rect;
 	daos_off_t	    offset;
@@ -1744,6 +2312,17 @@ evt_entry_fill(struct evt_context *tcx, uint64_t nd_off,
 	entry->en_ver = desc->dc_ver;
 	entry->en_csum = desc->dc_csum;
 
+	dcc = evt_desc2csum(tcx, desc);
+	if (dcc != NULL && dcc->dcc_len != 0) {
+		daos_csum_set(&entry->en_chunk_csum, &dcc->dcc_csum[0],
+			      dcc->dcc_len);
+		entry->en_chunk_csum.cs_type = dcc->dcc_type;
+		entry->en_chunk_size = dcc->dcc_chunk_size;
+	} else {
+		memset(&entry->en_chunk_csum, 0, sizeof(entry->en_chunk_csum));
+		entry->en_chunk_size = 0;
+	}
+
 	if (offset != 0) {
 		/* Adjust cached pointer since we're only referencing a
 		 * part of the extent
@@ -2519,20 +3098,11 @@ evt_ssof_insert(struct evt_context *tcx, uint64_t nd_off,
 
 	ne->ne_rect = ent->ei_rect;
 	if (leaf) {
-		TMMID(struct evt_desc)	 desc_mmid;
-		struct evt_desc		*desc;
-
-		desc_mmid = umem_zalloc_typed(evt_umm(tcx), struct evt_desc,
-					     sizeof(struct evt_desc));
-		if (TMMID_IS_NULL(desc_mmid))
-			return -DER_NOMEM;
-		ne->ne_child = desc_mmid.oid.off;
-		desc = evt_tmmid2ptr(tcx, desc_mmid);
-		desc->dc_magic = EVT_DESC_MAGIC;
-		desc->dc_ex_addr = ent->ei_addr;
-		desc->dc_csum = ent->ei_csum;
-		desc->dc_ver = ent->ei_ver;
-		uuid_copy(desc->dc_cookie, ent->ei_cookie);
+		int	rc;
+
+		rc = evt_desc_alloc(tcx, ent, &ne->ne_child);
+		if (rc != 0)
+			return rc;
 	} else {
 		ne->ne_child = in_off;
 	}
@@ -641,6 +641,286 @@ ts_many_add(char *args)
 	return rc;
 }
 
+#define TS_BENCH_STRIDE	8
+#define TS_BENCH_LOOPS	10
+
+/** Start offset of the next benchmark, each one uses a separate range */
+static daos_off_t	ts_bench_base = 1ULL << 32;
+
+static const char *ts_bench_names[] = {
+	[EVT_SORT_SWEEP]	= "sweep",
+	[EVT_SORT_LEGACY]	= "legacy",
+};
+
+/** Iterator options whose output is compared between the algorithms */
+static const struct {
+	const char	*bo_name;
+	unsigned int	 bo_options;
+} ts_bench_opts[] = {
+	{ "visible",	EVT_ITER_VISIBLE },
+	{ "covered",	EVT_ITER_COVERED },
+	{ "both",	EVT_ITER_VISIBLE | EVT_ITER_COVERED },
+};
+
+/** Visibility of an entry without the EVT_PARTIAL flag */
+#define TS_BENCH_VIS(ent)	((ent)->en_visibility & \
+				 (EVT_VISIBLE | EVT_COVERED))
+
+/** Group the entries by in-tree extent, then by visibility and offset */
+static int
+ts_bench_ent_cmp(const void *p1, const void *p2)
+{
+	const struct evt_entry	*e1 = p1;
+	const struct evt_entry	*e2 = p2;
+
+	if (e1->en_ext.ex_lo != e2->en_ext.ex_lo)
+		return e1->en_ext.ex_lo < e2->en_ext.ex_lo ? -1 : 1;
+	if (e1->en_epoch != e2->en_epoch)
+		return e1->en_epoch < e2->en_epoch ? -1 : 1;
+	if (TS_BENCH_VIS(e1) != TS_BENCH_VIS(e2))
+		return TS_BENCH_VIS(e1) < TS_BENCH_VIS(e2) ? -1 : 1;
+	if (e1->en_sel_ext.ex_lo != e2->en_sel_ext.ex_lo)
+		return e1->en_sel_ext.ex_lo < e2->en_sel_ext.ex_lo ? -1 : 1;
+	return 0;
+}
+
+/**
+ * Fetch all entries of the sorted iterator with \a options into \a ents.
+ * The legacy algorithm can cut a covered range into several pieces, so the
+ * adjacent pieces of an extent are merged if their addresses are contiguous
+ * (the benchmark uses one byte records).
+ */
+static int
+ts_bench_collect(const struct evt_filter *filter, unsigned int options,
+		 struct evt_entry *ents, int max, int *nr)
+{
+	struct evt_entry	*last = NULL;
+	struct evt_entry	*ent;
+	daos_handle_t		 ih;
+	unsigned int		 inob;
+	int			 total;
+	int			 i;
+	int			 rc;
+
+	rc = evt_iter_prepare(ts_toh, options, filter, &ih);
+	if (rc != 0) {
+		D_PRINT("Failed to prepare iterator: %d\n", rc);
+		return rc;
+	}
+
+	total = 0;
+	rc = evt_iter_probe(ih, EVT_ITER_FIRST, NULL, NULL);
+	while (rc == 0) {
+		if (total == max) {
+			D_PRINT("More than %d entries\n", max);
+			D_GOTO(out, rc = -DER_OVERFLOW);
+		}
+		rc = evt_iter_fetch(ih, &inob, &ents[total], NULL);
+		if (rc != 0)
+			break;
+		total++;
+		rc = evt_iter_next(ih);
+	}
+	if (rc != -DER_NONEXIST) {
+		D_PRINT("Failed to iterate: %d\n", rc);
+		D_GOTO(out, rc);
+	}
+	rc = 0;
+
+	qsort(ents, total, sizeof(ents[0]), ts_bench_ent_cmp);
+	*nr = 0;
+	for (i = 0; i < total; i++) {
+		ent = &ents[i];
+		if (last != NULL &&
+		    last->en_ext.ex_lo == ent->en_ext.ex_lo &&
+		    last->en_epoch == ent->en_epoch &&
+		    TS_BENCH_VIS(last) == TS_BENCH_VIS(ent) &&
+		    last->en_sel_ext.ex_hi + 1 == ent->en_sel_ext.ex_lo &&
+		    ent->en_addr.ba_off - last->en_addr.ba_off ==
+		    evt_extent_width(&last->en_sel_ext)) {
+			last->en_sel_ext.ex_hi = ent->en_sel_ext.ex_hi;
+			continue;
+		}
+		last = &ents[(*nr)++];
+		*last = *ent;
+	}
+out:
+	evt_iter_finish(ih);
+	return rc;
+}
+
+/** Compare the output of the sweep and the legacy algorithm entry by entry */
+static int
+ts_bench_check(const char *name, struct evt_entry *ents[], int nr[])
+{
+	struct evt_entry	*sweep;
+	struct evt_entry	*legacy;
+	int			 i;
+
+	if (nr[EVT_SORT_SWEEP] != nr[EVT_SORT_LEGACY]) {
+		D_PRINT("%s: entry count mismatch: %d != %d\n", name,
+			nr[EVT_SORT_SWEEP], nr[EVT_SORT_LEGACY]);
+		return -1;
+	}
+
+	for (i = 0; i < nr[EVT_SORT_SWEEP]; i++) {
+		sweep = &ents[EVT_SORT_SWEEP][i];
+		legacy = &ents[EVT_SORT_LEGACY][i];
+		if (sweep->en_ext.ex_lo == legacy->en_ext.ex_lo &&
+		    sweep->en_ext.ex_hi == legacy->en_ext.ex_hi &&
+		    sweep->en_sel_ext.ex_lo == legacy->en_sel_ext.ex_lo &&
+		    sweep->en_sel_ext.ex_hi == legacy->en_sel_ext.ex_hi &&
+		    sweep->en_epoch == legacy->en_epoch &&
+		    TS_BENCH_VIS(sweep) == TS_BENCH_VIS(legacy) &&
+		    sweep->en_addr.ba_off == legacy->en_addr.ba_off &&
+		    sweep->en_addr.ba_type == legacy->en_addr.ba_type)
+			continue;
+
+		D_PRINT("%s: entry %d mismatch:\n", name, i);
+		D_PRINT("  sweep:  "DF_ENT", vis=%x, addr="DF_U64"\n",
+			DP_ENT(sweep), sweep->en_visibility,
+			sweep->en_addr.ba_off);
+		D_PRINT("  legacy: "DF_ENT", vis=%x, addr="DF_U64"\n",
+			DP_ENT(legacy), legacy->en_visibility,
+			legacy->en_addr.ba_off);
+		return -1;
+	}
+
+	D_PRINT("%s: %d entries match\n", name, nr[EVT_SORT_SWEEP]);
+	return 0;
+}
+
+static int
+ts_bench_find(char *args)
+{
+	struct evt_entry_array	 ent_array;
+	struct evt_entry_in	 entry;
+	struct evt_entry	*ents[EVT_SORT_LEGACY + 1] = { NULL };
+	struct evt_filter	 filter;
+	struct evt_rect		 rect;
+	bio_addr_t		 bio_addr = {0}; /* Fake bio addr */
+	char			*tmp;
+	int			*seq;
+	int			 nr[EVT_SORT_LEGACY + 1];
+	int			 depth;
+	int			 loops = TS_BENCH_LOOPS;
+	int			 type;
+	int			 i;
+	int			 rc = 0;
+
+	/* argument format: "d:NUM[,l:NUM]"
+	 * d: overlap depth, number of extents overlapping in the middle of
+	 *    the searched range
+	 * l: number of searches per algorithm
+	 */
+	if (args[0] != 'd' || args[1] != EVT_SEP_VAL) {
+		D_PRINT("Invalid parameter %s\n", args);
+		return -1;
+	}
+	depth = strtol(&args[2], &tmp, 0);
+	if (depth <= 0) {
+		D_PRINT("Invalid overlap depth %d\n", depth);
+		return -1;
+	}
+
+	if (*tmp == EVT_SEP) {
+		args = tmp + 1;
+		if (args[0] != 'l' || args[1] != EVT_SEP_VAL) {
+			D_PRINT("Invalid parameter %s\n", args);
+			return -1;
+		}
+		loops = strtol(&args[2], &tmp, 0);
+		if (loops <= 0) {
+			D_PRINT("Invalid loop count %d\n", loops);
+			return -1;
+		}
+	}
+
+	/* Random epochs so that visible extents are fragmented */
+	seq = dts_rand_iarr_alloc(depth, 1);
+	if (!seq)
+		return -1;
+
+	for (i = 0; i < depth; i++) {
+		entry.ei_rect.rc_ex.ex_lo = ts_bench_base + i * TS_BENCH_STRIDE;
+		entry.ei_rect.rc_ex.ex_hi = entry.ei_rect.rc_ex.ex_lo +
+					    depth * TS_BENCH_STRIDE - 1;
+		entry.ei_rect.rc_epc = seq[i];
+
+		rc = bio_strdup(&bio_addr, "bench");
+		if (rc != 0) {
+			D_FATAL("Insufficient memory for test\n");
+			goto out;
+		}
+		entry.ei_addr = bio_addr;
+		uuid_copy(entry.ei_cookie, ts_uuid);
+		entry.ei_ver = 0;
+		entry.ei_inob = 1;
+
+		rc = evt_insert(ts_toh, &entry);
+		if (rc != 0) {
+			D_FATAL("Add rect %d failed %d\n", i, rc);
+			goto out;
+		}
+	}
+
+	rect.rc_ex.ex_lo = ts_bench_base;
+	rect.rc_ex.ex_hi = ts_bench_base + 2 * depth * TS_BENCH_STRIDE - 1;
+	rect.rc_epc = DAOS_EPOCH_MAX;
+
+	for (type = EVT_SORT_SWEEP; type <= EVT_SORT_LEGACY; type++) {
+		double	start;
+		double	elapsed;
+
+		evt_sort_type_set(type);
+		start = dts_time_now();
+		for (i = 0; i < loops; i++) {
+			rc = evt_find(ts_toh, &rect, &ent_array);
+			if (rc != 0) {
+				D_FATAL("Find rect failed %d\n", rc);
+				goto out;
+			}
+			nr[type] = ent_array.ea_ent_nr;
+			evt_ent_array_fini(&ent_array);
+		}
+		elapsed = dts_time_now() - start;
+
+		D_PRINT("depth=%d %s: %d visible, %.2f us per search\n",
+			depth, ts_bench_names[type], nr[type],
+			elapsed * 1000000.0 / loops);
+
+		/* At most 2 visible and 3 covered entries per extent */
+		D_ALLOC_ARRAY(ents[type], depth * 5);
+		if (ents[type] == NULL)
+			D_GOTO(out, rc = -DER_NOMEM);
+	}
+
+	filter.fr_ex = rect.rc_ex;
+	filter.fr_epr.epr_lo = 0;
+	filter.fr_epr.epr_hi = DAOS_EPOCH_MAX;
+	for (i = 0; i < ARRAY_SIZE(ts_bench_opts); i++) {
+		for (type = EVT_SORT_SWEEP; type <= EVT_SORT_LEGACY; type++) {
+			evt_sort_type_set(type);
+			rc = ts_bench_collect(&filter,
+					      ts_bench_opts[i].bo_options,
+					      ents[type], depth * 5, &nr[type]);
+			if (rc != 0)
+				goto out;
+		}
+
+		rc = ts_bench_check(ts_bench_opts[i].bo_name, ents, nr);
+		if (rc != 0)
+			goto out;
+	}
+out:
+	evt_sort_type_set(EVT_SORT_AUTO);
+	ts_bench_base += 2 * depth * TS_BENCH_STRIDE;
+	for (type = EVT_SORT_SWEEP; type <= EVT_SORT_LEGACY; type++)
+		D_FREE(ents[type]);
+	D_FREE(seq);
+	return rc;
+}
+
 static int
 ts_get_size(char *args)
 {
@@ -713,6 +993,7 @@ static struct option ts_ops[] = {
 	{ "list",	optional_argument,	NULL,	'l'	},
 	{ "get_size",	required_argument,	NULL,	'g'	},
 	{ "debug",	required_argument,	NULL,	'b'	},
+	{ "bench",	required_argument,	NULL,	'p'	},
 	{ NULL,		0,			NULL,	0	},
 };
 
@@ -755,6 +1036,9 @@ ts_cmd_run(char opc, char *args)
 	case 'b':
 		rc = ts_tree_debug(args);
 		break;
+	case 'p':
+		rc = ts_bench_find(args);
+		break;
 	default:
 		D_PRINT("Unsupported command %c\n", opc);
 		rc = 0;
@@ -791,7 +1075,7 @@ main(int argc, char **argv)
 	}
 
 	optind = 0;
-	while ((rc = getopt_long(argc, argv, "C:a:m:f:g:d:b:Docl::",
+	while ((rc = getopt_long(argc, argv, "C:a:m:f:g:d:b:p:Docl::",
 				 ts_ops, NULL)) != -1) {
 		rc = ts_cmd_run(rc, optarg);
 		if (rc != 0)
@@ -6,6 +6,19 @@ DAOS_DIR=$(cd "${cwd}/../../.." && echo "$PWD")
 source "$DAOS_DIR/.build_vars.sh"
 EVT_CTL="$SL_PREFIX/bin/evt_ctl"
 
+# "evt_ctl.sh bench" times and compares the visibility algorithms of evt_find
+if [ "$1" == "bench" ]; then
+    cmd="$EVT_CTL -C o:16"
+    for depth in 1 10 100 1000 10000; do
+        cmd+=" -p d:$depth"
+    done
+    cmd+=" -D"
+    echo "$cmd"
+
+    $cmd
+    exit $?
+fi
+
 cmd="$EVT_CTL -C o:4"
 
 function word_set {
@@ -155,6 +168,12 @@ cmd+=$(cat << EOF
 EOF
 )
 
+# Compare the output of the visibility algorithms. 1000 overlapping extents
+# need more than the minimum entry array when covered entries are requested.
+for depth in 1 20 100 1000; do
+    cmd+=" -p d:$depth,l:1"
+done
+
 cmd+=" -b -2 -D"
 echo "$cmd"
 
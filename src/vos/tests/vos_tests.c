@@ -49,6 +49,7 @@ print_usage()
 	print_message("%8s DAOS_OF_AKEY_UINT64, DAOS_OF_AKEY_LEXICAL\n", " ");
 	print_message("vos_tests -d |--discard-tests\n");
 	print_message("vos_tests -a |--aggregate-tests\n");
+	print_message("vos_tests -t |--tier-tests\n");
 	print_message("vos_tests -A|--all_tests\n");
 	print_message("vos_tests -h|--help\n");
 	print_message("Default <vos_tests> runs all tests\n");
@@ -66,6 +67,7 @@ run_all_tests(int keys, bool nest_iterators)
 		failed += run_io_test(i, keys, nest_iterators);
 	failed += run_discard_tests(keys);
 	failed += run_aggregate_tests();
+	failed += run_tier_tests();
 	return failed;
 }
 
@@ -88,6 +90,7 @@ main(int argc, char **argv)
 		{"discard_tests",	no_argument, 0, 'd'},
 		{"nest_iterators",	no_argument, 0, 'n'},
 		{"aggregate_tests",	no_argument, 0, 'a'},
+		{"tier_tests",		no_argument, 0, 't'},
 		{"help",		no_argument, 0, 'h'},
 	};
 
@@ -130,6 +133,9 @@ main(int argc, char **argv)
 			case 'd':
 				nr_failed += run_discard_tests(0);
 				break;
+			case 't':
+				nr_failed += run_tier_tests();
+				break;
 			case 'A':
 				keys = atoi(optarg);
 				nr_failed = run_all_tests(keys, nest_iterators);
@@ -108,6 +108,9 @@ run_discard_tests(int keys);
 int
 run_aggregate_tests(void);
 
+int
+run_tier_tests(void);
+
 int run_io_test(daos_ofeat_t feats, int keys, bool nest_iterators);
 
 #endif
@@ -738,7 +738,7 @@ exit:
 }
 
 static inline int
-hold_objects(struct vos_object **objs, struct daos_lru_cache *occ,
+hold_objects(struct vos_object **objs, struct vos_obj_cache *occ,
 	     daos_handle_t *coh, daos_unit_oid_t *oid, int start, int end)
 {
 	int i = 0, rc = 0;
@@ -751,6 +751,94 @@ hold_objects(struct vos_object **objs, struct daos_lru_cache *occ,
 	return rc;
 }
 
+#define ZIPF_OBJ_NR		4096
+#define ZIPF_CACHE_BITS		10
+#define ZIPF_ACCESS_NR		200000
+
+/** Pick an object index by the Zipf distribution (s = 1) of \a cdf */
+static int
+zipf_next(double *cdf, int nr)
+{
+	double	r = (double)rand() / RAND_MAX;
+	int	lo = 0;
+	int	hi = nr - 1;
+
+	while (lo < hi) {
+		int mid = (lo + hi) / 2;
+
+		if (cdf[mid] < r)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	return lo;
+}
+
+/**
+ * Access 4K objects through a 1K entries object cache with Zipfian
+ * popularity, report the hit ratio and the average hold/release latency.
+ */
+static void
+io_obj_cache_zipf_test(void **state)
+{
+	struct io_test_args	*arg = *state;
+	struct vos_obj_cache	*occ = NULL;
+	struct vos_obj_cache_stats *stats;
+	struct vos_object	*obj;
+	daos_unit_oid_t		*oids;
+	double			*cdf;
+	double			 sum = 0;
+	struct timespec		 start;
+	struct timespec		 end;
+	double			 usec;
+	int			 i;
+	int			 rc;
+
+	D_ALLOC_ARRAY(oids, ZIPF_OBJ_NR);
+	D_ALLOC_ARRAY(cdf, ZIPF_OBJ_NR);
+	assert_non_null(oids);
+	assert_non_null(cdf);
+
+	for (i = 0; i < ZIPF_OBJ_NR; i++) {
+		oids[i] = gen_oid(arg->ofeat);
+		sum += 1.0 / (i + 1);
+		cdf[i] = sum;
+	}
+	for (i = 0; i < ZIPF_OBJ_NR; i++)
+		cdf[i] /= sum;
+
+	rc = vos_obj_cache_create(ZIPF_CACHE_BITS, &occ);
+	assert_int_equal(rc, 0);
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (i = 0; i < ZIPF_ACCESS_NR; i++) {
+		rc = vos_obj_hold(occ, arg->ctx.tc_co_hdl,
+				  oids[zipf_next(cdf, ZIPF_OBJ_NR)], 1, true,
+				  &obj);
+		assert_int_equal(rc, 0);
+		vos_obj_release(occ, obj);
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+
+	stats = &occ->occ_stats;
+	assert_int_equal(stats->ocs_hits + stats->ocs_misses, ZIPF_ACCESS_NR);
+	assert_true(occ->occ_nr <= occ->occ_size);
+	assert_true(stats->ocs_hits > stats->ocs_misses);
+
+	usec = (end.tv_sec - start.tv_sec) * 1e6 +
+	       (end.tv_nsec - start.tv_nsec) / 1e3;
+	print_message("hits "DF_U64", misses "DF_U64", evictions "DF_U64
+		      ", hit ratio %.2f%%, %.3f us per access\n",
+		      stats->ocs_hits, stats->ocs_misses,
+		      stats->ocs_evictions,
+		      stats->ocs_hits * 100.0 / ZIPF_ACCESS_NR,
+		      usec / ZIPF_ACCESS_NR);
+
+	vos_obj_cache_destroy(occ);
+	D_FREE(cdf);
+	D_FREE(oids);
+}
+
 static void
 io_oi_test(void **state)
 {
@@ -777,7 +865,7 @@ io_obj_cache_test(void **state)
 {
 	struct io_test_args	*arg = *state;
 	struct vos_test_ctx	*ctx = &arg->ctx;
-	struct daos_lru_cache	*occ = NULL;
+	struct vos_obj_cache	*occ = NULL;
 	struct vos_object	*objs[20];
 	daos_unit_oid_t		 oids[2];
 	char			*po_name;
@@ -1977,6 +2065,118 @@ io_fetch_hole(void **state)
 	assert_memory_equal(ground_truth, fetch_buf, 3 * 1024);
 }
 
+#define CSUM_TEST_CHUNKS	4
+
+/**
+ * Update an extent with its per-chunk checksums, a partial fetch only
+ * verifies the chunks it covers.
+ */
+static void
+io_chunk_csum(void **state)
+{
+	struct io_test_args	*arg = *state;
+	daos_size_t		 size = CSUM_TEST_CHUNKS * DAOS_CSUM_CHUNK_SIZE;
+	daos_csum_t		 checksum;
+	daos_csum_buf_t		 csum;
+	daos_iov_t		 val_iov;
+	daos_key_t		 dkey;
+	daos_key_t		 akey;
+	daos_recx_t		 rex;
+	daos_iod_t		 iod;
+	daos_sg_list_t		 sgl;
+	struct d_uuid		 dsm_cookie;
+	char			 dkey_buf[UPDATE_DKEY_SIZE];
+	char			 akey_buf[UPDATE_AKEY_SIZE];
+	char			 csum_buf[CSUM_TEST_CHUNKS * DAOS_CSUM_SIZE];
+	char			*update_buf;
+	char			*fetch_buf;
+	char			*env;
+	int			 rc;
+
+	env = getenv("VOS_CHECKSUM");
+	if (env == NULL) {
+		print_message("VOS_CHECKSUM is not set, skip\n");
+		skip();
+	}
+
+	rc = daos_csum_init(env, &checksum);
+	assert_int_equal(rc, 0);
+
+	D_ALLOC(update_buf, size);
+	assert_non_null(update_buf);
+	D_ALLOC(fetch_buf, size);
+	assert_non_null(fetch_buf);
+
+	memset(&iod, 0, sizeof(iod));
+	memset(&sgl, 0, sizeof(sgl));
+	memset(&csum, 0, sizeof(csum));
+
+	dts_key_gen(&dkey_buf[0], arg->dkey_size, arg->dkey);
+	dts_key_gen(&akey_buf[0], arg->akey_size, arg->akey);
+	set_iov(&dkey, &dkey_buf[0], arg->ofeat & DAOS_OF_DKEY_UINT64);
+	set_iov(&akey, &akey_buf[0], arg->ofeat & DAOS_OF_AKEY_UINT64);
+
+	dts_buf_render(update_buf, size);
+	daos_iov_set(&val_iov, update_buf, size);
+	sgl.sg_iovs = &val_iov;
+	sgl.sg_nr = sgl.sg_nr_out = 1;
+
+	csum.cs_csum = &csum_buf[0];
+	csum.cs_buf_len = sizeof(csum_buf);
+	rc = daos_csum_compute_chunks(&checksum, &sgl, DAOS_CSUM_CHUNK_SIZE,
+				      &csum);
+	assert_int_equal(rc, 0);
+
+	rex.rx_idx = 0;
+	rex.rx_nr = size;
+	iod.iod_type = DAOS_IOD_ARRAY;
+	iod.iod_size = 1;
+	iod.iod_name = akey;
+	iod.iod_recxs = &rex;
+	iod.iod_csums = &csum;
+	iod.iod_nr = 1;
+
+	uuid_copy(dsm_cookie.uuid, cookie_dict[(rand() % NUM_UNIQUE_COOKIES)]);
+	rc = vos_obj_update(arg->ctx.tc_co_hdl, arg->oid, 1, dsm_cookie.uuid,
+			    0, &dkey, 1, &iod, &sgl);
+	assert_int_equal(rc, 0);
+	inc_cntr(arg->ta_flags);
+
+	/* Overwrite it with a corrupted checksum of the last chunk */
+	csum_buf[(CSUM_TEST_CHUNKS - 1) * daos_csum_get_size(&checksum)] ^= 1;
+	rc = vos_obj_update(arg->ctx.tc_co_hdl, arg->oid, 2, dsm_cookie.uuid,
+			    0, &dkey, 1, &iod, &sgl);
+	assert_int_equal(rc, 0);
+
+	/* Fetch across the two middle chunks, the last one isn't read */
+	iod.iod_csums = NULL;
+	rex.rx_idx = DAOS_CSUM_CHUNK_SIZE + DAOS_CSUM_CHUNK_SIZE / 2;
+	rex.rx_nr = DAOS_CSUM_CHUNK_SIZE;
+	daos_iov_set(&val_iov, fetch_buf, rex.rx_nr);
+	rc = vos_obj_fetch(arg->ctx.tc_co_hdl, arg->oid, 2, &dkey, 1, &iod,
+			   &sgl);
+	assert_int_equal(rc, 0);
+	assert_memory_equal(&update_buf[rex.rx_idx], fetch_buf, rex.rx_nr);
+
+	/* The last chunk is verified by the fetch of its last record */
+	rex.rx_idx = size - 1;
+	rex.rx_nr = 1;
+	daos_iov_set(&val_iov, fetch_buf, rex.rx_nr);
+	rc = vos_obj_fetch(arg->ctx.tc_co_hdl, arg->oid, 2, &dkey, 1, &iod,
+			   &sgl);
+	assert_int_equal(rc, -DER_IO);
+
+	/* The old extent has good checksums */
+	rc = vos_obj_fetch(arg->ctx.tc_co_hdl, arg->oid, 1, &dkey, 1, &iod,
+			   &sgl);
+	assert_int_equal(rc, 0);
+	assert_memory_equal(&update_buf[rex.rx_idx], fetch_buf, rex.rx_nr);
+
+	daos_csum_free(&checksum);
+	D_FREE(fetch_buf);
+	D_FREE(update_buf);
+}
+
 static int
 io_iter_cookie_test(void **state)
 {
@@ -2063,6 +2263,8 @@ static const struct CMUnitTest io_tests[] = {
 		io_oi_test, NULL, NULL},
 	{ "VOS202: VOS object cache test",
 		io_obj_cache_test, NULL, NULL},
+	{ "VOS202.1: VOS object cache Zipfian access test",
+		io_obj_cache_zipf_test, NULL, NULL},
 	{ "VOS203: Simple update/fetch/verify test",
 		io_simple_one_key, NULL, NULL},
 	{ "VOS204: Simple Punch test",
@@ -2075,6 +2277,8 @@ static const struct CMUnitTest io_tests[] = {
 		io_sgl_fetch, NULL, NULL},
 	{ "VOS208: Extent hole test",
 		io_fetch_hole, NULL, NULL},
+	{ "VOS209: Partial fetch verifies per-chunk checksums of extent",
+		io_chunk_csum, NULL, NULL},
 	{ "VOS220: 100K update/fetch/verify test",
 		io_multiple_dkey, NULL, NULL},
 	{ "VOS222: overwrite test",
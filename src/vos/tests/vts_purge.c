@@ -320,6 +320,48 @@ io_simple_one_key_discard(void **state)
 		D_FREE(req[i]);
 }
 
+static void
+io_leased_discard(void **state)
+{
+	struct io_test_args	*arg = *state;
+	struct io_req		*req;
+	struct d_uuid		cookie;
+	daos_epoch_range_t	range;
+	daos_handle_t		ioh;
+	int			rc;
+
+	arg->ta_flags = 0;
+	cookie = gen_rand_cookie();
+	rc = io_simple_update(arg, &cookie, 1, &req);
+	assert_int_equal(rc, 0);
+
+	/* The fetch holds a lease on the object until vos_fetch_end() */
+	req->iod.iod_size = UPDATE_BUF_SIZE;
+	rc = vos_fetch_begin(arg->ctx.tc_co_hdl, arg->oid, 1, &req->dkey,
+			     1, &req->iod, false, &ioh);
+	assert_int_equal(rc, 0);
+
+	range.epr_lo = 1;
+	range.epr_hi = 1;
+	rc = vos_epoch_discard(arg->ctx.tc_co_hdl, &range, cookie.uuid);
+	assert_int_equal(rc, -DER_BUSY);
+
+	/* The leased object has been skipped */
+	rc = io_fetch(arg, 1, req, FETCH_VERBOSE);
+	assert_int_equal(rc, 0);
+
+	rc = vos_fetch_end(ioh, 0);
+	assert_int_equal(rc, 0);
+
+	rc = vos_epoch_discard(arg->ctx.tc_co_hdl, &range, cookie.uuid);
+	assert_int_equal(rc, 0);
+
+	rc = io_fetch(arg, 1, req, FETCH_VERBOSE);
+	assert_int_equal(rc, -DER_NONEXIST);
+
+	D_FREE(req);
+}
+
 static int
 io_simple_discard_teardown(void **state)
 {
@@ -1017,6 +1059,217 @@ io_multi_recx_aggregate_test(void **state)
 	verify_io_fetch(arg);
 }
 
+/** Number of adjacent extents which are coalesced by aggregation */
+#define TF_MERGE_RECXS	(256)
+
+static void
+io_recx_merge_aggregate_test(void **state)
+{
+	struct io_test_args	*arg = *state;
+	struct io_req		*req;
+	int			 i;
+	int			 rc = 0;
+	daos_epoch_t		 epoch;
+	struct d_uuid		 cookie;
+	daos_epoch_range_t	 range;
+	struct vts_counter	 cntrs;
+	char			 dkey_buf[UPDATE_DKEY_SIZE];
+	char			 akey_buf[UPDATE_AKEY_SIZE];
+	vos_purge_anchor_t	 vp_anchor = {0};
+	unsigned int		 credits;
+	bool			 finish;
+
+	arg->ta_flags = TF_REC_EXT;
+	cookie = gen_rand_cookie();
+	epoch = 1;
+	set_key_and_index(&dkey_buf[0], &akey_buf[0], NULL);
+
+	/* Write an array in small adjacent extents */
+	for (i = 0; i < TF_MERGE_RECXS; i++) {
+		req = NULL;
+		rc = io_update(arg, epoch + i, &cookie, &dkey_buf[0],
+			       &akey_buf[0], &cntrs, &req, i, UPDATE_VERBOSE);
+		assert_int_equal(rc, 0);
+		d_list_add(&req->rlist, &arg->req_list);
+	}
+
+	range.epr_lo = epoch;
+	range.epr_hi = epoch + TF_MERGE_RECXS - 1;
+	do {
+		credits = -1;
+		rc = vos_epoch_aggregate(arg->ctx.tc_co_hdl, arg->oid, &range,
+					 &credits, &vp_anchor, &finish);
+		assert_int_equal(rc, 0);
+	} while (!finish);
+
+	/* The extents are merged on NVMe, or on SCM if there is no NVMe */
+	assert_true(vp_anchor.pa_nr_removed > 0);
+	assert_true(vp_anchor.pa_nr_merged > vp_anchor.pa_nr_removed);
+
+	/* All extents are visible at the upper bound of the range */
+	d_list_for_each_entry(req, &arg->req_list, rlist) {
+		rc = io_fetch(arg, range.epr_hi, req, FETCH_VERBOSE);
+		assert_int_equal(rc, 0);
+	}
+}
+
+static void
+io_recx_merge_epoch_aggregate_test(void **state)
+{
+	struct io_test_args	*arg = *state;
+	struct io_req		*req;
+	struct io_req		*old = NULL;
+	struct io_req		*first = NULL;
+	int			 i;
+	int			 rc = 0;
+	daos_epoch_t		 epoch;
+	struct d_uuid		 cookie;
+	daos_epoch_range_t	 range;
+	struct vts_counter	 cntrs;
+	char			 dkey_buf[UPDATE_DKEY_SIZE];
+	char			 akey_buf[UPDATE_AKEY_SIZE];
+	vos_purge_anchor_t	 vp_anchor = {0};
+	unsigned int		 credits;
+	bool			 finish;
+
+	arg->ta_flags = TF_REC_EXT;
+	cookie = gen_rand_cookie();
+	epoch = 1;
+	set_key_and_index(&dkey_buf[0], &akey_buf[0], NULL);
+
+	/* Data written before the aggregation range */
+	rc = io_update(arg, epoch, &cookie, &dkey_buf[0], &akey_buf[0],
+		       &cntrs, &old, 0, UPDATE_VERBOSE);
+	assert_int_equal(rc, 0);
+	d_list_add(&old->rlist, &arg->req_list);
+
+	/* Overwritten by the first one of the adjacent extents */
+	for (i = 0; i < TF_MERGE_RECXS; i++) {
+		req = NULL;
+		rc = io_update(arg, epoch + 1 + i, &cookie, &dkey_buf[0],
+			       &akey_buf[0], &cntrs, &req, i, UPDATE_VERBOSE);
+		assert_int_equal(rc, 0);
+		d_list_add(&req->rlist, &arg->req_list);
+		if (first == NULL)
+			first = req;
+	}
+
+	range.epr_lo = epoch + 1;
+	range.epr_hi = epoch + TF_MERGE_RECXS;
+	do {
+		credits = -1;
+		rc = vos_epoch_aggregate(arg->ctx.tc_co_hdl, arg->oid, &range,
+					 &credits, &vp_anchor, &finish);
+		assert_int_equal(rc, 0);
+	} while (!finish);
+	assert_true(vp_anchor.pa_nr_removed > 0);
+
+	/* The old data is still visible before the range */
+	rc = io_fetch(arg, epoch, old, FETCH_VERBOSE);
+	assert_int_equal(rc, 0);
+
+	/*
+	 * The merged extent is stamped with the upper bound of the range, the
+	 * aggregated epochs are gone and a fetch between the bounds sees the
+	 * data from before the range, not the one written after the fetch.
+	 */
+	rc = io_fetch(arg, range.epr_lo, old, FETCH_VERBOSE);
+	assert_int_equal(rc, 0);
+	rc = io_fetch(arg, (range.epr_lo + range.epr_hi) / 2, old,
+		      FETCH_VERBOSE);
+	assert_int_equal(rc, 0);
+	rc = io_fetch(arg, range.epr_hi - 1, old, FETCH_VERBOSE);
+	assert_int_equal(rc, 0);
+
+	/* The newest data shows from the upper bound */
+	rc = io_fetch(arg, range.epr_hi, first, FETCH_VERBOSE);
+	assert_int_equal(rc, 0);
+
+	d_list_for_each_entry(req, &arg->req_list, rlist) {
+		if (req == old)
+			continue;
+		rc = io_fetch(arg, range.epr_hi, req, FETCH_VERBOSE);
+		assert_int_equal(rc, 0);
+	}
+}
+
+/** Number of overlapping extents written by the overlap aggregate test */
+#define TF_OVERLAP_RECXS	(32)
+
+static void
+io_recx_overlap_aggregate_test(void **state)
+{
+	struct io_test_args	*arg = *state;
+	struct io_req		*req;
+	struct io_req		*last = NULL;
+	int			 i;
+	int			 rc = 0;
+	daos_epoch_t		 epoch;
+	daos_unit_oid_t		 oid;
+	struct d_uuid		 cookie;
+	daos_epoch_range_t	 range;
+	struct vts_counter	 cntrs;
+	char			 dkey_buf[UPDATE_DKEY_SIZE];
+	char			 akey_buf[UPDATE_AKEY_SIZE];
+	vos_purge_anchor_t	 vp_anchor = {0};
+	unsigned int		 credits;
+	bool			 finish;
+
+	arg->ta_flags = TF_REC_EXT;
+	cookie = gen_rand_cookie();
+	epoch = 1;
+	set_key_and_index(&dkey_buf[0], &akey_buf[0], NULL);
+
+	/* objects reported by the former tests */
+	while (vos_cont_agg_objs(arg->ctx.tc_co_hdl, &oid, 1) > 0)
+		;
+
+	/* Overwrite the same extent, the object is reported once the new
+	 * extents overlap enough of the old ones.
+	 */
+	for (i = 0; i < TF_OVERLAP_RECXS; i++) {
+		req = NULL;
+		rc = io_update(arg, epoch + i, &cookie, &dkey_buf[0],
+			       &akey_buf[0], &cntrs, &req, 0, UPDATE_VERBOSE);
+		assert_int_equal(rc, 0);
+		d_list_add(&req->rlist, &arg->req_list);
+		last = req;
+
+		rc = vos_cont_agg_objs(arg->ctx.tc_co_hdl, &oid, 1);
+		if (i < VOS_AGG_EVT_OVERLAP) {
+			assert_int_equal(rc, 0);
+		} else if (i == VOS_AGG_EVT_OVERLAP) {
+			assert_int_equal(rc, 1);
+			assert_memory_equal(&oid, &arg->oid, sizeof(oid));
+		}
+	}
+
+	range.epr_lo = epoch;
+	range.epr_hi = epoch + TF_OVERLAP_RECXS - 1;
+	do {
+		credits = -1;
+		rc = vos_epoch_aggregate(arg->ctx.tc_co_hdl, arg->oid, &range,
+					 &credits, &vp_anchor, &finish);
+		assert_int_equal(rc, 0);
+	} while (!finish);
+
+	/* Only the newest extent is left */
+	assert_int_equal(vp_anchor.pa_nr_removed, TF_OVERLAP_RECXS - 1);
+	rc = io_fetch(arg, range.epr_hi, last, FETCH_VERBOSE);
+	assert_int_equal(rc, 0);
+
+	/* So the next overwrite doesn't report the object */
+	vos_cont_agg_objs(arg->ctx.tc_co_hdl, &oid, 1);
+	req = NULL;
+	rc = io_update(arg, range.epr_hi + 1, &cookie, &dkey_buf[0],
+		       &akey_buf[0], &cntrs, &req, 0, UPDATE_VERBOSE);
+	assert_int_equal(rc, 0);
+	d_list_add(&req->rlist, &arg->req_list);
+
+	rc = vos_cont_agg_objs(arg->ctx.tc_co_hdl, &oid, 1);
+	assert_int_equal(rc, 0);
+}
+
 static void
 verify_io_fetch_in_epoch_range(struct io_test_args *arg,
 	daos_epoch_t min_epoch, daos_epoch_t max_epoch, d_list_t *req_list)
@@ -1344,6 +1597,9 @@ static const struct CMUnitTest discard_tests[] = {
 	{ "VOS306: VOS epoch range discard test",
 		io_epoch_range_discard_test, io_multikey_discard_setup,
 		io_multikey_discard_teardown},
+	{ "VOS307: VOS discard skips objects leased by fetch",
+		io_leased_discard, io_simple_discard_setup,
+		io_simple_discard_teardown},
 };
 
 static const struct CMUnitTest aggregate_tests[] = {
@@ -1371,6 +1627,15 @@ static const struct CMUnitTest aggregate_tests[] = {
 	{ "VOS403.3: VOS recx update aggregate test",
 		io_multi_recx_aggregate_test, io_multi_recx_discard_setup,
 		io_multikey_discard_teardown},
+	{ "VOS404.1: VOS recx extent merge aggregate test",
+		io_recx_merge_aggregate_test, io_multikey_discard_setup,
+		io_multikey_discard_teardown},
+	{ "VOS404.2: VOS recx extent merge within epoch range",
+		io_recx_merge_epoch_aggregate_test, io_multikey_discard_setup,
+		io_multikey_discard_teardown},
+	{ "VOS405: VOS overlapped recx aggregate test",
+		io_recx_overlap_aggregate_test, io_multikey_discard_setup,
+		io_multikey_discard_teardown},
 
 };
 
@@ -0,0 +1,318 @@
+/**
+ * (C) Copyright 2018 Intel Corporation.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * GOVERNMENT LICENSE RIGHTS-OPEN SOURCE SOFTWARE
+ * The Government's rights to use, modify, reproduce, release, perform, display,
+ * or disclose this software are subject to the terms of the Apache License as
+ * provided in Contract No. B609815.
+ * Any reproduction of computer software, computer software documentation, or
+ * portions thereof marked with this legend must also reproduce the markings.
+ */
+/**
+ * This file is part of vos/tests/
+ *
+ * vos/tests/vts_tier.c
+ *
+ * Tests of the media selection, the space usage accounting and the SCM/NVMe
+ * migration, see vos_tier.c.
+ */
+#define D_LOGFAC	DD_FAC(tests)
+
+#include "vts_io.h"
+
+#define TIER_DKEY	"tier_dkey"
+#define TIER_AKEY	"tier_akey"
+/** size of the small extent, it's packed when it's stored on NVMe */
+#define TIER_SMALL_SZ	512
+
+static struct vos_container *
+tier_arg2cont(struct io_test_args *arg)
+{
+	return vos_hdl2cont(arg->ctx.tc_co_hdl);
+}
+
+/**
+ * Update \a size bytes of array at index 0 of the test akey with \a cookie,
+ * or fetch it if \a cookie is NULL.
+ */
+static int
+tier_io(struct io_test_args *arg, daos_epoch_t epoch, char *buf,
+	daos_size_t size, struct d_uuid *cookie)
+{
+	daos_key_t	dkey;
+	daos_iod_t	iod;
+	daos_recx_t	recx;
+	daos_sg_list_t	sgl;
+	daos_iov_t	iov;
+
+	daos_iov_set(&dkey, TIER_DKEY, strlen(TIER_DKEY));
+	memset(&iod, 0, sizeof(iod));
+	daos_iov_set(&iod.iod_name, TIER_AKEY, strlen(TIER_AKEY));
+	recx.rx_idx = 0;
+	recx.rx_nr = size;
+	iod.iod_type = DAOS_IOD_ARRAY;
+	iod.iod_size = 1;
+	iod.iod_nr = 1;
+	iod.iod_recxs = &recx;
+
+	daos_iov_set(&iov, buf, size);
+	sgl.sg_nr = 1;
+	sgl.sg_nr_out = 0;
+	sgl.sg_iovs = &iov;
+
+	if (cookie == NULL)
+		return io_test_obj_fetch(arg, epoch, &dkey, &iod, &sgl, true);
+
+	return io_test_obj_update(arg, epoch, &dkey, &iod, &sgl, cookie,
+				  true);
+}
+
+static void
+tier_verify(struct io_test_args *arg, daos_epoch_t epoch, char *buf,
+	    daos_size_t size)
+{
+	char	*fetch_buf;
+	int	 rc;
+
+	D_ALLOC(fetch_buf, size);
+	assert_non_null(fetch_buf);
+
+	rc = tier_io(arg, epoch, fetch_buf, size, NULL);
+	assert_int_equal(rc, 0);
+	assert_memory_equal(fetch_buf, buf, size);
+	D_FREE(fetch_buf);
+}
+
+static int
+tier_setup(void **state)
+{
+	struct io_test_args	*arg = *state;
+
+	arg->ta_flags = 0;
+	arg->oid = dts_unit_oid_gen(0, 0, 0);
+	return 0;
+}
+
+/** Restore the default policy changed by the test */
+static int
+tier_teardown(void **state)
+{
+	struct io_test_args	*arg = *state;
+	struct vos_container	*cont = tier_arg2cont(arg);
+
+	vos_media_policy_init(&cont->vc_pool->vp_policy);
+	*vos_obj_heat_bucket(cont, arg->oid) = 0;
+	return 0;
+}
+
+static void
+tier_media_select_test(void **state)
+{
+	struct io_test_args	*arg = *state;
+	struct vos_container	*cont = tier_arg2cont(arg);
+	struct vos_pool		*pool = cont->vc_pool;
+	struct vos_media_policy	*policy = &pool->vp_policy;
+	struct vos_media_hint	 hint;
+	daos_key_t		 akey;
+	char			 rules[64];
+	int			 rc;
+
+	daos_iov_set(&akey, TIER_AKEY, strlen(TIER_AKEY));
+	hint.mh_oid = arg->oid;
+	hint.mh_akey = &akey;
+	hint.mh_type = DAOS_IOD_ARRAY;
+	hint.mh_size = policy->mp_size_thresh;
+
+	/* Everything is on SCM without NVMe */
+	if (pool->vp_vea_info == NULL) {
+		assert_int_equal(vos_media_select(cont, &hint), BIO_ADDR_SCM);
+		print_message("No NVMe, skip the test\n");
+		skip();
+	}
+
+	/* Large record goes to NVMe */
+	assert_int_equal(vos_media_select(cont, &hint), BIO_ADDR_NVME);
+	hint.mh_type = DAOS_IOD_SINGLE;
+	assert_int_equal(vos_media_select(cont, &hint), BIO_ADDR_NVME);
+
+	/* Small single value always stays with its index record */
+	hint.mh_size = TIER_SMALL_SZ;
+	policy->mp_scm_hwm = 0;
+	assert_int_equal(vos_media_select(cont, &hint), BIO_ADDR_SCM);
+
+	/* Small array extent is on SCM while SCM is below the watermark */
+	hint.mh_type = DAOS_IOD_ARRAY;
+	policy->mp_scm_hwm = 100;
+	assert_int_equal(vos_media_select(cont, &hint), BIO_ADDR_SCM);
+
+	/* It's packed on NVMe above the watermark, unless the object is hot */
+	assert_true(vea_frag_supported(pool->vp_vea_info));
+	policy->mp_scm_hwm = 0;
+	assert_int_equal(vos_media_select(cont, &hint), BIO_ADDR_NVME);
+	*vos_obj_heat_bucket(cont, arg->oid) = VOS_TIER_HOT_FETCHES;
+	assert_int_equal(vos_media_select(cont, &hint), BIO_ADDR_SCM);
+	*vos_obj_heat_bucket(cont, arg->oid) = 0;
+
+	/* Malformed rules are rejected */
+	assert_int_equal(vos_media_rules_parse(policy, "ssd:akey=tier"),
+			 -DER_INVAL);
+	assert_int_equal(vos_media_rules_parse(policy, "scm:oclass=x"),
+			 -DER_INVAL);
+	assert_int_equal(policy->mp_rule_nr, 0);
+
+	/* The rules override the size and the watermark, first match wins */
+	snprintf(rules, sizeof(rules), "scm:akey=tier_,nvme:oclass=%u",
+		 daos_obj_id2class(arg->oid.id_pub));
+	rc = vos_media_rules_parse(policy, rules);
+	assert_int_equal(rc, 0);
+	assert_int_equal(policy->mp_rule_nr, 2);
+	hint.mh_size = policy->mp_size_thresh;
+	assert_int_equal(vos_media_select(cont, &hint), BIO_ADDR_SCM);
+
+	/* Other akeys of the object follow the object class rule */
+	daos_iov_set(&akey, "other", strlen("other"));
+	hint.mh_size = TIER_SMALL_SZ;
+	policy->mp_scm_hwm = 100;
+	assert_int_equal(vos_media_select(cont, &hint), BIO_ADDR_NVME);
+}
+
+static void
+tier_usage_test(void **state)
+{
+	struct io_test_args	*arg = *state;
+	struct vos_container	*cont = tier_arg2cont(arg);
+	vos_pool_info_t		 before;
+	vos_pool_info_t		 after;
+	daos_epoch_range_t	 epr;
+	struct d_uuid		 cookie;
+	daos_size_t		 size = 2 * VOS_BLK_SZ;
+	char			*buf;
+	int			 rc;
+
+	D_ALLOC(buf, size);
+	assert_non_null(buf);
+	dts_buf_render(buf, size);
+
+	rc = vos_pool_query(arg->ctx.tc_po_hdl, &before);
+	assert_int_equal(rc, 0);
+	assert_true(before.pif_scm_used <= before.pif_scm_sz);
+
+	cookie = gen_rand_cookie();
+	rc = tier_io(arg, 1, buf, size, &cookie);
+	assert_int_equal(rc, 0);
+
+	rc = vos_pool_query(arg->ctx.tc_po_hdl, &after);
+	assert_int_equal(rc, 0);
+
+	/* The index records are on SCM, unless PMDK can't tell the usage */
+	if (before.pif_scm_used != 0)
+		assert_true(after.pif_scm_used > before.pif_scm_used);
+
+	if (cont->vc_pool->vp_vea_info == NULL) {
+		assert_int_equal(after.pif_nvme_used, 0);
+		D_FREE(buf);
+		return;
+	}
+
+	/* The extent is on NVMe, its blocks are accounted on publish */
+	assert_int_equal(after.pif_nvme_used, before.pif_nvme_used + size);
+	tier_verify(arg, 1, buf, size);
+
+	/* And given back on free */
+	epr.epr_lo = 1;
+	epr.epr_hi = 1;
+	rc = vos_epoch_discard(arg->ctx.tc_co_hdl, &epr, cookie.uuid);
+	assert_int_equal(rc, 0);
+
+	rc = vos_pool_query(arg->ctx.tc_po_hdl, &after);
+	assert_int_equal(rc, 0);
+	assert_int_equal(after.pif_nvme_used, before.pif_nvme_used);
+	D_FREE(buf);
+}
+
+static void
+tier_migrate_test(void **state)
+{
+	struct io_test_args	*arg = *state;
+	struct vos_container	*cont = tier_arg2cont(arg);
+	struct vos_media_policy	*policy = &cont->vc_pool->vp_policy;
+	vos_tier_stats_t	 stats;
+	vos_pool_info_t		 before;
+	vos_pool_info_t		 after;
+	struct d_uuid		 cookie;
+	unsigned int		 credits;
+	char			 buf[TIER_SMALL_SZ];
+	int			 rc;
+
+	if (cont->vc_pool->vp_vea_info == NULL) {
+		print_message("No NVMe, skip the test\n");
+		skip();
+	}
+
+	/* Small extent written below the watermark is on SCM */
+	dts_buf_render(buf, sizeof(buf));
+	policy->mp_scm_hwm = 100;
+	cookie = gen_rand_cookie();
+	rc = tier_io(arg, 2, buf, sizeof(buf), &cookie);
+	assert_int_equal(rc, 0);
+
+	rc = vos_pool_query(arg->ctx.tc_po_hdl, &before);
+	assert_int_equal(rc, 0);
+
+	/* Nothing to move for a cold object below the watermark */
+	memset(&stats, 0, sizeof(stats));
+	credits = VOS_TIER_HOT_FETCHES;
+	rc = vos_obj_tier(arg->ctx.tc_co_hdl, arg->oid, &credits, &stats);
+	assert_int_equal(rc, 0);
+	assert_int_equal(stats.ts_demoted + stats.ts_promoted, 0);
+
+	/* Demoted above the watermark, packed into one NVMe block */
+	policy->mp_scm_hwm = 0;
+	rc = vos_obj_tier(arg->ctx.tc_co_hdl, arg->oid, &credits, &stats);
+	assert_int_equal(rc, 0);
+	assert_int_equal(stats.ts_demoted, 1);
+	assert_int_equal(stats.ts_bytes, sizeof(buf));
+
+	rc = vos_pool_query(arg->ctx.tc_po_hdl, &after);
+	assert_int_equal(rc, 0);
+	assert_int_equal(after.pif_nvme_used,
+			 before.pif_nvme_used + VOS_BLK_SZ);
+	tier_verify(arg, 2, buf, sizeof(buf));
+
+	/* Hot object is promoted back below the watermark */
+	policy->mp_scm_hwm = 100;
+	*vos_obj_heat_bucket(cont, arg->oid) = VOS_TIER_HOT_FETCHES;
+	rc = vos_obj_tier(arg->ctx.tc_co_hdl, arg->oid, &credits, &stats);
+	assert_int_equal(rc, 0);
+	assert_int_equal(stats.ts_promoted, 1);
+	tier_verify(arg, 2, buf, sizeof(buf));
+}
+
+static const struct CMUnitTest tier_tests[] = {
+	{ "VOS501: VOS media selection test",
+		tier_media_select_test, tier_setup, tier_teardown},
+	{ "VOS502: VOS space usage accounting test",
+		tier_usage_test, tier_setup, tier_teardown},
+	{ "VOS503: VOS SCM/NVMe migration test",
+		tier_migrate_test, tier_setup, tier_teardown},
+};
+
+int
+run_tier_tests(void)
+{
+	return cmocka_run_group_tests_name("VOS media tier test",
+					   tier_tests, setup_io,
+					   teardown_io);
+}
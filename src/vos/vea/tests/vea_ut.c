@@ -133,6 +133,7 @@ ut_query(void **state)
 	assert_int_equal(stat.vs_resrv_small, 0);
 	assert_int_equal(stat.vs_resrv_vec, 0);
 	assert_int_equal(stat.vs_largest_blks, tot_blks);
+	assert_int_equal(stat.vs_free_blks, tot_blks);
 }
 
 static void
@@ -495,7 +496,7 @@ vea_ut_setup(void **state)
 		return rc;
 
 	rc = dbtree_class_register(DBTREE_CLASS_IV,
-				   BTR_FEAT_UINT_KEY,
+				   BTR_FEAT_UINT_KEY | BTR_FEAT_KEY_ARRAY,
 				   &dbtree_iv_ops);
 	if (rc != 0 && rc != -DER_EXIST) {
 		fprintf(stderr, "register DBTREE_CLASS_IV error %d\n", rc);
@@ -608,6 +609,133 @@ ut_reserve_special(void **state)
 	ut_teardown(&args);
 }
 
+static void
+ut_reserve_frag(void **state)
+{
+	struct vea_ut_args args;
+	struct vea_unmap_context unmap_ctxt;
+	struct vea_resrvd_ext *ext;
+	d_list_t *r_list, *r_list_b;
+	uint64_t capacity = 2UL << 30; /* 2GB */
+	uint64_t blk_off;
+	uint32_t blk_sz = 4096;
+	int rc;
+
+	print_message("Test packed reservations\n");
+	ut_setup(&args);
+	rc = vea_format(&args.vua_umm, &args.vua_txd, args.vua_md, blk_sz,
+			1, capacity, NULL, NULL, false);
+	assert_int_equal(rc, 0);
+
+	unmap_ctxt.vnc_unmap = NULL;
+	unmap_ctxt.vnc_data = NULL;
+	rc = vea_load(&args.vua_umm, &args.vua_txd, args.vua_md, &unmap_ctxt,
+		      &args.vua_vsi);
+	assert_int_equal(rc, 0);
+
+	r_list = &args.vua_resrvd_list[0];
+	r_list_b = &args.vua_resrvd_list[1];
+
+	/* block size or larger can't be packed */
+	rc = vea_reserve_frag(args.vua_vsi, blk_sz, NULL, r_list);
+	assert_int_equal(rc, -DER_INVAL);
+
+	/* the first packed reservation reserves the block as well */
+	rc = vea_reserve_frag(args.vua_vsi, 100, NULL, r_list);
+	assert_int_equal(rc, 0);
+	ext = d_list_entry(r_list->prev, struct vea_resrvd_ext, vre_link);
+	assert_int_equal(ext->vre_frag_off, 0);
+	assert_int_equal(ext->vre_frag_len, 100);
+	blk_off = ext->vre_blk_off;
+
+	rc = vea_reserve_frag(args.vua_vsi, 200, NULL, r_list);
+	assert_int_equal(rc, 0);
+	ext = d_list_entry(r_list->prev, struct vea_resrvd_ext, vre_link);
+	assert_int_equal(ext->vre_blk_off, blk_off);
+	assert_int_equal(ext->vre_frag_off, 100);
+
+	/* the block is being packed by another reserved list */
+	rc = vea_reserve_frag(args.vua_vsi, 100, NULL, r_list_b);
+	assert_int_equal(rc, -DER_BUSY);
+
+	rc = umem_tx_begin(&args.vua_umm, &args.vua_txd);
+	assert_int_equal(rc, 0);
+	rc = vea_tx_publish(args.vua_vsi, NULL, r_list);
+	assert_int_equal(rc, 0);
+	rc = umem_tx_commit(&args.vua_umm);
+	assert_int_equal(rc, 0);
+
+	rc = vea_verify_alloc(args.vua_vsi, false, blk_off, 1);
+	assert_int_equal(rc, 0);
+
+	/* packing continues in the same block after publish */
+	rc = vea_reserve_frag(args.vua_vsi, 300, NULL, r_list_b);
+	assert_int_equal(rc, 0);
+	ext = d_list_entry(r_list_b->prev, struct vea_resrvd_ext, vre_link);
+	assert_int_equal(ext->vre_blk_off, blk_off);
+	assert_int_equal(ext->vre_frag_off, 300);
+
+	/* cancelled tail space is reused */
+	rc = vea_cancel(args.vua_vsi, NULL, r_list_b);
+	assert_int_equal(rc, 0);
+	rc = vea_reserve_frag(args.vua_vsi, 4000, NULL, r_list_b);
+	assert_int_equal(rc, 0);
+	ext = d_list_entry(r_list_b->prev, struct vea_resrvd_ext, vre_link);
+	assert_int_not_equal(ext->vre_blk_off, blk_off);
+	rc = vea_cancel(args.vua_vsi, NULL, r_list_b);
+	assert_int_equal(rc, 0);
+
+	/* the block is freed along with the last packed reservation */
+	rc = vea_free_frag(args.vua_vsi, blk_off);
+	assert_int_equal(rc, 0);
+	rc = vea_verify_alloc(args.vua_vsi, false, blk_off, 1);
+	assert_int_equal(rc, 0);
+
+	rc = vea_free_frag(args.vua_vsi, blk_off);
+	assert_int_equal(rc, 0);
+	rc = vea_verify_alloc(args.vua_vsi, false, blk_off, 1);
+	assert_int_equal(rc, 1);
+
+	/* each I/O stream packs its own block */
+	rc = vea_hint_load(args.vua_hint[0], &args.vua_hint_ctxt[0]);
+	assert_int_equal(rc, 0);
+	rc = vea_hint_load(args.vua_hint[1], &args.vua_hint_ctxt[1]);
+	assert_int_equal(rc, 0);
+
+	rc = vea_reserve_frag(args.vua_vsi, 100, args.vua_hint_ctxt[0],
+			      r_list);
+	assert_int_equal(rc, 0);
+	ext = d_list_entry(r_list->prev, struct vea_resrvd_ext, vre_link);
+	blk_off = ext->vre_blk_off;
+
+	rc = vea_reserve_frag(args.vua_vsi, 100, args.vua_hint_ctxt[1],
+			      r_list_b);
+	assert_int_equal(rc, 0);
+	ext = d_list_entry(r_list_b->prev, struct vea_resrvd_ext, vre_link);
+	assert_int_not_equal(ext->vre_blk_off, blk_off);
+	assert_int_equal(ext->vre_frag_off, 0);
+
+	rc = vea_cancel(args.vua_vsi, args.vua_hint_ctxt[0], r_list);
+	assert_int_equal(rc, 0);
+	rc = vea_cancel(args.vua_vsi, args.vua_hint_ctxt[1], r_list_b);
+	assert_int_equal(rc, 0);
+	vea_hint_unload(args.vua_hint_ctxt[0]);
+	vea_hint_unload(args.vua_hint_ctxt[1]);
+	vea_unload(args.vua_vsi);
+
+	/* space formatted without packed block support */
+	args.vua_md->vsd_compat &= ~VEA_COMPAT_FEATURE_FRAG;
+	rc = vea_load(&args.vua_umm, &args.vua_txd, args.vua_md, &unmap_ctxt,
+		      &args.vua_vsi);
+	assert_int_equal(rc, 0);
+	assert_false(vea_frag_supported(args.vua_vsi));
+	rc = vea_reserve_frag(args.vua_vsi, 100, NULL, r_list);
+	assert_int_equal(rc, -DER_NOSYS);
+
+	vea_unload(args.vua_vsi);
+	ut_teardown(&args);
+}
+
 static void
 ut_inval_params_format(void **state)
 {
@@ -1244,6 +1372,7 @@ static const struct CMUnitTest vea_uts[] = {
 	{ "vea_hint_unload", ut_hint_unload, NULL, NULL},
 	{ "vea_unload", ut_unload, NULL, NULL},
 	{ "vea_reserve_special", ut_reserve_special, NULL, NULL},
+	{ "vea_reserve_frag", ut_reserve_frag, NULL, NULL},
 	{ "vea_inval_params_format", ut_inval_params_format, NULL, NULL},
 	{ "vea_inval_params_load", ut_inval_params_load, NULL, NULL},
 	{ "vea_inval_param_reserve", ut_inval_params_reserve, NULL, NULL},
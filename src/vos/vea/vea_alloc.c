@@ -440,5 +440,7 @@ persistent_alloc(struct vea_space_info *vsi, struct vea_free_extent *vfe)
 			return rc;
 	}
 
+	D_ASSERT(vsi->vsi_free_blks >= vfe->vfe_blk_cnt);
+	vsi->vsi_free_blks -= vfe->vfe_blk_cnt;
 	return 0;
 }
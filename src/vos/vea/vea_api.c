@@ -28,12 +28,14 @@
 
 #define VEA_BLK_SZ	(4 * 1024)	/* 4K */
 #define VEA_TREE_ODR	20
+/* in-memory trees search the integer key array of each node */
+#define VEA_TREE_FEATS	(BTR_FEAT_UINT_KEY | BTR_FEAT_KEY_ARRAY)
 
 static void
 erase_md(struct umem_instance *umem, struct vea_space_df *md)
 {
 	struct umem_attr uma;
-	daos_handle_t free_btr, vec_btr;
+	daos_handle_t free_btr, vec_btr, frag_btr;
 	int rc;
 
 	uma.uma_id = umem->umm_id;
@@ -51,6 +53,16 @@ erase_md(struct umem_instance *umem, struct vea_space_df *md)
 		if (rc)
 			D_ERROR("destroy vector tree error: %d\n", rc);
 	}
+
+	if (!(md->vsd_compat & VEA_COMPAT_FEATURE_FRAG))
+		return;
+
+	rc = dbtree_open_inplace(&md->vsd_frag_tree, &uma, &frag_btr);
+	if (rc == 0) {
+		rc = dbtree_destroy(frag_btr);
+		if (rc)
+			D_ERROR("destroy packed block tree error: %d\n", rc);
+	}
 }
 
 /*
@@ -66,7 +78,7 @@ vea_format(struct umem_instance *umem, struct umem_tx_stage_data *txd,
 	struct vea_free_extent free_ext;
 	struct umem_attr uma;
 	uint64_t tot_blks;
-	daos_handle_t free_btr, vec_btr;
+	daos_handle_t free_btr, vec_btr, frag_btr;
 	daos_iov_t key, val;
 	int rc;
 
@@ -125,14 +137,14 @@ vea_format(struct umem_instance *umem, struct umem_tx_stage_data *txd,
 	if (rc != 0)
 		return rc;
 
-	free_btr = vec_btr = DAOS_HDL_INVAL;
+	free_btr = vec_btr = frag_btr = DAOS_HDL_INVAL;
 
 	rc = umem_tx_add_ptr(umem, md, sizeof(*md));
 	if (rc != 0)
 		goto out;
 
 	md->vsd_magic = VEA_MAGIC;
-	md->vsd_compat = 0;
+	md->vsd_compat = VEA_COMPAT_FEATURE_FRAG;
 	md->vsd_blk_sz = blk_sz;
 	md->vsd_tot_blks = tot_blks;
 	md->vsd_hdr_blks = hdr_blks;
@@ -165,11 +177,19 @@ vea_format(struct umem_instance *umem, struct umem_tx_stage_data *txd,
 	if (rc != 0)
 		goto out;
 
+	/* Create packed block tree */
+	rc = dbtree_create_inplace(DBTREE_CLASS_IV, 0, VEA_TREE_ODR, &uma,
+				   &md->vsd_frag_tree, &frag_btr);
+	if (rc != 0)
+		goto out;
+
 out:
 	if (!daos_handle_is_inval(free_btr))
 		dbtree_close(free_btr);
 	if (!daos_handle_is_inval(vec_btr))
 		dbtree_close(vec_btr);
+	if (!daos_handle_is_inval(frag_btr))
+		dbtree_close(frag_btr);
 
 	/* Commit/Abort transaction on success/error */
 	return rc ? umem_tx_abort(umem, rc) : umem_tx_commit(umem);
@@ -182,6 +202,11 @@ vea_unload(struct vea_space_info *vsi)
 	D_ASSERT(vsi != NULL);
 	unload_space_info(vsi);
 
+	/* The I/O streams might outlive the space, stop their packing */
+	while (!d_list_empty(&vsi->vsi_frag_list))
+		frag_reset(d_list_entry(vsi->vsi_frag_list.next,
+					struct vea_frag_context, vfc_link));
+
 	/* Destroy the in-memory free extent tree */
 	if (!daos_handle_is_inval(vsi->vsi_free_btr)) {
 		dbtree_destroy(vsi->vsi_free_btr);
@@ -228,6 +253,13 @@ vea_load(struct umem_instance *umem, struct umem_tx_stage_data *txd,
 		return -DER_UNINIT;
 	}
 
+	/* Compatible features unknown to this version are ignored */
+	if (md->vsd_compat & ~VEA_COMPAT_FEATURES)
+		D_WARN("unknown compat features %#x\n",
+		       md->vsd_compat & ~VEA_COMPAT_FEATURES);
+	if (!(md->vsd_compat & VEA_COMPAT_FEATURE_FRAG))
+		D_DEBUG(DB_IO, "packed reservation isn't supported\n");
+
 	D_ALLOC_PTR(vsi);
 	if (vsi == NULL)
 		return -DER_NOMEM;
@@ -237,12 +269,15 @@ vea_load(struct umem_instance *umem, struct umem_tx_stage_data *txd,
 	vsi->vsi_md = md;
 	vsi->vsi_md_free_btr = DAOS_HDL_INVAL;
 	vsi->vsi_md_vec_btr = DAOS_HDL_INVAL;
+	vsi->vsi_md_frag_btr = DAOS_HDL_INVAL;
 	vsi->vsi_free_btr = DAOS_HDL_INVAL;
 	D_INIT_LIST_HEAD(&vsi->vsi_agg_lru);
 	vsi->vsi_agg_btr = DAOS_HDL_INVAL;
 	vsi->vsi_vec_btr = DAOS_HDL_INVAL;
 	vsi->vsi_agg_time = 0;
 	vsi->vsi_unmap_ctxt = *unmap_ctxt;
+	frag_context_init(&vsi->vsi_frag);
+	D_INIT_LIST_HEAD(&vsi->vsi_frag_list);
 
 	rc = create_free_class(&vsi->vsi_class, md);
 	if (rc)
@@ -251,19 +286,19 @@ vea_load(struct umem_instance *umem, struct umem_tx_stage_data *txd,
 	memset(&uma, 0, sizeof(uma));
 	uma.uma_id = UMEM_CLASS_VMEM;
 	/* Create in-memory free extent tree */
-	rc = dbtree_create(DBTREE_CLASS_IV, 0, VEA_TREE_ODR, &uma,
+	rc = dbtree_create(DBTREE_CLASS_IV, VEA_TREE_FEATS, VEA_TREE_ODR, &uma,
 			   NULL, &vsi->vsi_free_btr);
 	if (rc != 0)
 		goto error;
 
 	/* Create in-memory extent vector tree */
-	rc = dbtree_create(DBTREE_CLASS_IV, 0, VEA_TREE_ODR, &uma,
+	rc = dbtree_create(DBTREE_CLASS_IV, VEA_TREE_FEATS, VEA_TREE_ODR, &uma,
 			   NULL, &vsi->vsi_vec_btr);
 	if (rc != 0)
 		goto error;
 
 	/* Create in-memory aggregation tree */
-	rc = dbtree_create(DBTREE_CLASS_IV, 0, VEA_TREE_ODR, &uma,
+	rc = dbtree_create(DBTREE_CLASS_IV, VEA_TREE_FEATS, VEA_TREE_ODR, &uma,
 			   NULL, &vsi->vsi_agg_btr);
 	if (rc != 0)
 		goto error;
@@ -273,6 +308,11 @@ vea_load(struct umem_instance *umem, struct umem_tx_stage_data *txd,
 	if (rc)
 		goto error;
 
+	/* Free the packed blocks left empty on last shutdown */
+	rc = frag_cleanup(vsi);
+	if (rc)
+		goto error;
+
 	*vsip = vsi;
 	return 0;
 error:
@@ -369,10 +409,81 @@ error:
 	return rc;
 }
 
+/*
+ * Reserve less than one block by packing it into the block being packed by
+ * the I/O stream.
+ *
+ * Switch to a new block when the current one is full, the new block is
+ * reserved in @resrvd_list as an ordinary one block extent, so it's
+ * published or cancelled along with the packed reservations.
+ */
+int
+vea_reserve_frag(struct vea_space_info *vsi, uint32_t size,
+		 struct vea_hint_context *hint, d_list_t *resrvd_list)
+{
+	struct vea_frag_context *vfc;
+	struct vea_resrvd_ext *resrvd;
+	uint32_t blk_sz;
+	int rc;
+
+	D_ASSERT(vsi != NULL);
+	D_ASSERT(resrvd_list != NULL);
+
+	if (!vea_frag_supported(vsi))
+		return -DER_NOSYS;
+
+	blk_sz = vsi->vsi_md->vsd_blk_sz;
+	if (size == 0 || size >= blk_sz)
+		return -DER_INVAL;
+
+	vfc = frag_context(vsi, hint);
+	if (vfc->vfc_owner != NULL && vfc->vfc_owner != resrvd_list)
+		return -DER_BUSY;
+
+	if (vfc->vfc_blk == 0 || vfc->vfc_used + size > blk_sz) {
+		rc = frag_retire(vsi, vfc);
+		if (rc)
+			return rc;
+
+		rc = vea_reserve(vsi, 1, hint, resrvd_list);
+		if (rc)
+			return rc;
+
+		resrvd = d_list_entry(resrvd_list->prev, struct vea_resrvd_ext,
+				      vre_link);
+		frag_start(vsi, vfc, resrvd->vre_blk_off);
+	}
+
+	D_ALLOC_PTR(resrvd);
+	if (resrvd == NULL)
+		return -DER_NOMEM;
+
+	D_INIT_LIST_HEAD(&resrvd->vre_link);
+	resrvd->vre_hint_off = VEA_HINT_OFF_INVAL;
+	resrvd->vre_blk_off = vfc->vfc_blk;
+	resrvd->vre_frag_off = vfc->vfc_used;
+	resrvd->vre_frag_len = size;
+
+	vfc->vfc_used += size;
+	vfc->vfc_inflight++;
+	vfc->vfc_owner = resrvd_list;
+	d_list_add_tail(&resrvd->vre_link, resrvd_list);
+
+	return 0;
+}
+
+bool
+vea_frag_supported(struct vea_space_info *vsi)
+{
+	D_ASSERT(vsi != NULL);
+	return !daos_handle_is_inval(vsi->vsi_md_frag_btr);
+}
+
 static int
 process_resrvd_list(struct vea_space_info *vsi, struct vea_hint_context *hint,
 		    d_list_t *resrvd_list, bool publish)
 {
+	struct vea_frag_context *vfc = frag_context(vsi, hint);
 	struct vea_resrvd_ext *resrvd, *tmp;
 	struct vea_free_extent vfe;
 	unsigned int flags = VEA_FL_GEN_AGE;
@@ -386,10 +497,27 @@ process_resrvd_list(struct vea_space_info *vsi, struct vea_hint_context *hint,
 	vfe.vfe_blk_cnt = 0;
 
 	d_list_for_each_entry(resrvd, resrvd_list, vre_link) {
+		/* Packed reservation, the block is reserved separately */
+		if (resrvd->vre_frag_len != 0) {
+			if (!publish) {
+				frag_cancel(vfc, resrvd);
+				continue;
+			}
+			rc = frag_publish(vsi, vfc, resrvd);
+			if (rc)
+				goto error;
+			continue;
+		}
+
 		rc = verify_resrvd_ext(resrvd);
 		if (rc)
 			goto error;
 
+		/* Stop packing the block being cancelled */
+		if (!publish && vfc->vfc_blk >= resrvd->vre_blk_off &&
+		    vfc->vfc_blk < resrvd->vre_blk_off + resrvd->vre_blk_cnt)
+			frag_reset(vfc);
+
 		/* Reserved list is sorted by hint sequence */
 		if (seq_min == 0) {
 			seq_min = resrvd->vre_hint_seq;
@@ -410,10 +538,11 @@ process_resrvd_list(struct vea_space_info *vsi, struct vea_hint_context *hint,
 		} else if (vfe.vfe_blk_cnt != 0) {
 			rc = publish ? persistent_alloc(vsi, &vfe) :
 				       compound_free(vsi, &vfe, flags);
-			vfe.vfe_blk_cnt = 0;
 			if (rc)
 				goto error;
 
+			vfe.vfe_blk_off = resrvd->vre_blk_off;
+			vfe.vfe_blk_cnt = resrvd->vre_blk_cnt;
 		}
 	}
 
@@ -425,9 +554,14 @@ process_resrvd_list(struct vea_space_info *vsi, struct vea_hint_context *hint,
 			goto error;
 	}
 
-	rc = publish ? hint_tx_publish(hint, off_p, seq_min, seq_max) :
-		       hint_cancel(hint, off_c, seq_min, seq_max);
+	/* Skip hint for the list having nothing but packed reservations */
+	if (seq_min != 0)
+		rc = publish ? hint_tx_publish(hint, off_p, seq_min, seq_max) :
+			       hint_cancel(hint, off_c, seq_min, seq_max);
 error:
+	if (vfc->vfc_owner == resrvd_list)
+		vfc->vfc_owner = NULL;
+
 	d_list_for_each_entry_safe(resrvd, tmp, resrvd_list, vre_link) {
 		d_list_del_init(&resrvd->vre_link);
 		D_FREE(resrvd);
@@ -482,6 +616,8 @@ free_commit_cb(void *data, bool noop)
 	if (noop)
 		goto free;
 
+	fca->fca_vsi->vsi_free_blks += fca->fca_vfe.vfe_blk_cnt;
+
 	/*
 	 * Aggregated free will be executed on outermost transaction
 	 * commit.
@@ -563,6 +699,28 @@ error:
 	return rc;
 }
 
+/*
+ * Free a published packed reservation, the block will be freed along with
+ * the last packed reservation in it.
+ */
+int
+vea_free_frag(struct vea_space_info *vsi, uint64_t blk_off)
+{
+	struct umem_instance *umem;
+	int rc;
+
+	D_ASSERT(vsi != NULL);
+	umem = vsi->vsi_umem;
+
+	rc = umem_tx_begin(umem, vsi->vsi_txd);
+	if (rc != 0)
+		return rc;
+
+	rc = frag_put(vsi, blk_off);
+
+	return rc ? umem_tx_abort(umem, rc) : umem_tx_commit(umem);
+}
+
 /* Set an arbitrary age to a free extent with specified start offset. */
 int
 vea_set_ext_age(struct vea_space_info *vsi, uint64_t blk_off, uint64_t age)
@@ -596,6 +754,7 @@ vea_hint_load(struct vea_hint_df *phd, struct vea_hint_context **thc)
 	hint_ctxt->vhc_pd = phd;
 	hint_ctxt->vhc_off = phd->vhd_off;
 	hint_ctxt->vhc_seq = phd->vhd_seq;
+	frag_context_init(&hint_ctxt->vhc_frag);
 	*thc = hint_ctxt;
 
 	return 0;
@@ -605,6 +764,15 @@ vea_hint_load(struct vea_hint_df *phd, struct vea_hint_context **thc)
 void
 vea_hint_unload(struct vea_hint_context *thc)
 {
+	struct vea_frag_context *vfc = &thc->vhc_frag;
+	int rc;
+
+	/* Stop packing the block of the I/O stream */
+	if (vfc->vfc_vsi != NULL) {
+		rc = frag_retire(vfc->vfc_vsi, vfc);
+		if (rc)
+			D_ERROR("Failed to retire packed block: %d\n", rc);
+	}
 	D_FREE(thc);
 }
 
@@ -658,6 +826,7 @@ vea_query(struct vea_space_info *vsi, struct vea_attr *attr,
 		stat->vs_resrv_large = vsi->vsi_stat[STAT_RESRV_LARGE];
 		stat->vs_resrv_small = vsi->vsi_stat[STAT_RESRV_SMALL];
 		stat->vs_resrv_vec = vsi->vsi_stat[STAT_RESRV_VEC];
+		stat->vs_free_blks = vsi->vsi_free_blks;
 	}
 
 	return 0;
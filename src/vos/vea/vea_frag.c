@@ -0,0 +1,268 @@
+/**
+ * (C) Copyright 2018 Intel Corporation.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * GOVERNMENT LICENSE RIGHTS-OPEN SOURCE SOFTWARE
+ * The Government's rights to use, modify, reproduce, release, perform, display,
+ * or disclose this software are subject to the terms of the Apache License as
+ * provided in Contract No. B620873.
+ * Any reproduction of computer software, computer software documentation, or
+ * portions thereof marked with this legend must also reproduce the markings.
+ */
+#define D_LOGFAC	DD_FAC(vos)
+
+#include <daos/common.h>
+#include "vea_internal.h"
+
+/*
+ * Blocks shared by packed reservations are tracked in the persistent frag
+ * tree, keyed by block offset, the value is the count of published packed
+ * reservations in the block. The block is freed when the count drops to 0,
+ * unless it's still being packed.
+ */
+static int
+frag_ref_lookup(struct vea_space_info *vsi, uint64_t blk_off, uint32_t *ref)
+{
+	daos_iov_t key, val;
+
+	D_ASSERT(!daos_handle_is_inval(vsi->vsi_md_frag_btr));
+	daos_iov_set(&key, &blk_off, sizeof(blk_off));
+	daos_iov_set(&val, ref, sizeof(*ref));
+
+	return dbtree_lookup(vsi->vsi_md_frag_btr, &key, &val);
+}
+
+static int
+frag_ref_update(struct vea_space_info *vsi, uint64_t blk_off, uint32_t ref)
+{
+	daos_iov_t key, val;
+
+	daos_iov_set(&key, &blk_off, sizeof(blk_off));
+	daos_iov_set(&val, &ref, sizeof(ref));
+
+	return dbtree_update(vsi->vsi_md_frag_btr, &key, &val);
+}
+
+/* Free a packed block without any packed reservation */
+static int
+frag_release(struct vea_space_info *vsi, uint64_t blk_off)
+{
+	daos_iov_t key;
+	int rc;
+
+	D_ASSERT(pmemobj_tx_stage() == TX_STAGE_WORK);
+	D_DEBUG(DB_IO, "Release packed block "DF_U64"\n", blk_off);
+
+	daos_iov_set(&key, &blk_off, sizeof(blk_off));
+	rc = dbtree_delete(vsi->vsi_md_frag_btr, &key, NULL);
+	if (rc)
+		return rc;
+
+	return vea_free(vsi, blk_off, 1);
+}
+
+void
+frag_context_init(struct vea_frag_context *vfc)
+{
+	memset(vfc, 0, sizeof(*vfc));
+	D_INIT_LIST_HEAD(&vfc->vfc_link);
+}
+
+/*
+ * Each I/O stream packs its own block, so the updates of different I/O
+ * streams don't wait for each other. Reservations without hint share the
+ * context of the space.
+ */
+struct vea_frag_context *
+frag_context(struct vea_space_info *vsi, struct vea_hint_context *hint)
+{
+	return hint != NULL ? &hint->vhc_frag : &vsi->vsi_frag;
+}
+
+/* Start packing the newly reserved block */
+void
+frag_start(struct vea_space_info *vsi, struct vea_frag_context *vfc,
+	   uint64_t blk_off)
+{
+	D_ASSERT(vfc->vfc_blk == 0);
+	vfc->vfc_vsi = vsi;
+	vfc->vfc_blk = blk_off;
+	d_list_add_tail(&vfc->vfc_link, &vsi->vsi_frag_list);
+}
+
+void
+frag_reset(struct vea_frag_context *vfc)
+{
+	d_list_del_init(&vfc->vfc_link);
+	vfc->vfc_vsi = NULL;
+	vfc->vfc_blk = 0;
+	vfc->vfc_used = 0;
+	vfc->vfc_inflight = 0;
+}
+
+/* Is the block being packed by any I/O stream? */
+static bool
+frag_is_packing(struct vea_space_info *vsi, uint64_t blk_off)
+{
+	struct vea_frag_context *vfc;
+
+	d_list_for_each_entry(vfc, &vsi->vsi_frag_list, vfc_link) {
+		if (vfc->vfc_blk == blk_off)
+			return true;
+	}
+	return false;
+}
+
+/* Stop packing the current block, free it if nothing is packed in it */
+int
+frag_retire(struct vea_space_info *vsi, struct vea_frag_context *vfc)
+{
+	struct umem_instance *umem = vsi->vsi_umem;
+	uint64_t blk_off = vfc->vfc_blk;
+	uint32_t inflight = vfc->vfc_inflight;
+	uint32_t ref;
+	int rc;
+
+	frag_reset(vfc);
+
+	/* Unpublished reservations will take the block on publish */
+	if (blk_off == 0 || inflight != 0)
+		return 0;
+
+	rc = frag_ref_lookup(vsi, blk_off, &ref);
+	if (rc == -DER_NONEXIST)
+		return 0;
+	else if (rc != 0 || ref != 0)
+		return rc;
+
+	rc = umem_tx_begin(umem, vsi->vsi_txd);
+	if (rc)
+		return rc;
+
+	rc = frag_release(vsi, blk_off);
+
+	return rc ? umem_tx_abort(umem, rc) : umem_tx_commit(umem);
+}
+
+int
+frag_publish(struct vea_space_info *vsi, struct vea_frag_context *vfc,
+	     struct vea_resrvd_ext *resrvd)
+{
+	uint32_t ref = 0;
+	int rc;
+
+	D_ASSERT(pmemobj_tx_stage() == TX_STAGE_WORK);
+	D_ASSERT(resrvd->vre_frag_len != 0);
+
+	rc = frag_ref_lookup(vsi, resrvd->vre_blk_off, &ref);
+	if (rc != 0 && rc != -DER_NONEXIST)
+		return rc;
+
+	rc = frag_ref_update(vsi, resrvd->vre_blk_off, ref + 1);
+	if (rc)
+		return rc;
+
+	if (resrvd->vre_blk_off == vfc->vfc_blk) {
+		D_ASSERT(vfc->vfc_inflight > 0);
+		vfc->vfc_inflight--;
+	}
+	return 0;
+}
+
+void
+frag_cancel(struct vea_frag_context *vfc, struct vea_resrvd_ext *resrvd)
+{
+	D_ASSERT(resrvd->vre_frag_len != 0);
+
+	if (resrvd->vre_blk_off != vfc->vfc_blk)
+		return;
+
+	D_ASSERT(vfc->vfc_inflight > 0);
+	vfc->vfc_inflight--;
+
+	/* Reuse the space if it's at the tail of the block */
+	if (vfc->vfc_used == resrvd->vre_frag_off + resrvd->vre_frag_len)
+		vfc->vfc_used = resrvd->vre_frag_off;
+}
+
+/* Drop a published packed reservation, it should be called in transaction */
+int
+frag_put(struct vea_space_info *vsi, uint64_t blk_off)
+{
+	uint32_t ref;
+	int rc;
+
+	D_ASSERT(pmemobj_tx_stage() == TX_STAGE_WORK);
+
+	rc = frag_ref_lookup(vsi, blk_off, &ref);
+	if (rc) {
+		D_ERROR("packed block "DF_U64" isn't found. %d\n", blk_off, rc);
+		return rc;
+	}
+
+	if (ref == 0) {
+		D_CRIT("packed block "DF_U64" is already empty\n", blk_off);
+		return -DER_INVAL;
+	}
+
+	ref--;
+	if (ref == 0 && !frag_is_packing(vsi, blk_off))
+		return frag_release(vsi, blk_off);
+
+	return frag_ref_update(vsi, blk_off, ref);
+}
+
+static int
+find_empty_frag(daos_handle_t ih, daos_iov_t *key, daos_iov_t *val, void *arg)
+{
+	uint64_t *blk_off = arg;
+
+	if (*(uint32_t *)val->iov_buf != 0)
+		return 0;
+
+	*blk_off = *(uint64_t *)key->iov_buf;
+	return 1;
+}
+
+/*
+ * The block being packed on last shutdown could be left without any packed
+ * reservation, free such blocks on load.
+ */
+int
+frag_cleanup(struct vea_space_info *vsi)
+{
+	struct umem_instance *umem = vsi->vsi_umem;
+	uint64_t blk_off;
+	int rc;
+
+	if (daos_handle_is_inval(vsi->vsi_md_frag_btr))
+		return 0;
+
+	while (1) {
+		blk_off = 0;
+		rc = dbtree_iterate(vsi->vsi_md_frag_btr, false,
+				    find_empty_frag, &blk_off);
+		if (rc != 0 || blk_off == 0)
+			return rc;
+
+		rc = umem_tx_begin(umem, vsi->vsi_txd);
+		if (rc)
+			return rc;
+
+		rc = frag_release(vsi, blk_off);
+		rc = rc ? umem_tx_abort(umem, rc) : umem_tx_commit(umem);
+		if (rc)
+			return rc;
+	}
+}
@@ -142,13 +142,60 @@ blkcnt_to_lru(struct vea_free_class *vfc, uint32_t blkcnt)
 	return &vfc->vfc_lrus[idx];
 }
 
+/*
+ * Add an in-tree free extent entry to the heap if it's large, otherwise to
+ * one of the size categorized LRUs. @newest means the entry is the youngest
+ * one and can be appended to the LRU without sorting by age.
+ */
+int
+free_class_add(struct vea_free_class *vfc, struct vea_entry *entry,
+	       bool newest)
+{
+	D_INIT_LIST_HEAD(&entry->ve_link);
+
+	/* Add to heap if it's a large free extent */
+	if (entry->ve_ext.vfe_blk_cnt > vfc->vfc_large_thresh) {
+		int rc;
+
+		rc = d_binheap_insert(&vfc->vfc_heap, &entry->ve_node);
+		if (rc != 0)
+			return rc;
+
+		entry->ve_in_heap = 1;
+	} else { /* Otherwise add to one of size categarized LRU */
+		struct vea_entry *cur;
+		d_list_t *lru_head, *tmp;
+
+		lru_head = blkcnt_to_lru(vfc, entry->ve_ext.vfe_blk_cnt);
+
+		if (newest) {
+			d_list_add_tail(&entry->ve_link, lru_head);
+		} else {
+			/* Sort by free extent age */
+			d_list_for_each_prev(tmp, lru_head) {
+				cur = d_list_entry(tmp, struct vea_entry,
+						   ve_link);
+
+				if (entry->ve_ext.vfe_age >=
+				    cur->ve_ext.vfe_age) {
+					d_list_add(&entry->ve_link, tmp);
+					break;
+				}
+			}
+			if (d_list_empty(&entry->ve_link))
+				d_list_add(&entry->ve_link, lru_head);
+		}
+	}
+
+	return 0;
+}
+
 /* Free extent to in-memory compound index */
 int
 compound_free(struct vea_space_info *vsi, struct vea_free_extent *vfe,
 	      unsigned int flags)
 {
 	struct vea_entry *entry, dummy;
-	struct vea_free_class *vfc = &vsi->vsi_class;
 	daos_iov_t key, val;
 	uint64_t cur_time = 0;
 	int rc;
@@ -189,42 +236,9 @@ compound_free(struct vea_space_info *vsi, struct vea_free_extent *vfe,
 		return rc;
 
 	entry = (struct vea_entry *)val.iov_buf;
-	D_INIT_LIST_HEAD(&entry->ve_link);
-
-	/* Add to heap if it's a large free extent */
-	if (entry->ve_ext.vfe_blk_cnt > vfc->vfc_large_thresh) {
-		rc = d_binheap_insert(&vfc->vfc_heap, &entry->ve_node);
-		if (rc != 0)
-			return rc;
-
-		entry->ve_in_heap = 1;
-	} else { /* Otherwise add to one of size categarized LRU */
-		struct vea_entry *cur;
-		d_list_t *lru_head, *tmp;
-
-		lru_head = blkcnt_to_lru(vfc, entry->ve_ext.vfe_blk_cnt);
-
-		if ((flags & VEA_FL_GEN_AGE) &&
-		    entry->ve_ext.vfe_age == cur_time) {
-			d_list_add_tail(&entry->ve_link, lru_head);
-		} else {
-			/* Sort by free extent age */
-			d_list_for_each_prev(tmp, lru_head) {
-				cur = d_list_entry(tmp, struct vea_entry,
-						   ve_link);
-
-				if (entry->ve_ext.vfe_age >=
-				    cur->ve_ext.vfe_age) {
-					d_list_add(&entry->ve_link, tmp);
-					break;
-				}
-			}
-			if (d_list_empty(&entry->ve_link))
-				d_list_add(&entry->ve_link, lru_head);
-		}
-	}
-
-	return 0;
+	return free_class_add(&vsi->vsi_class, entry,
+			      (flags & VEA_FL_GEN_AGE) &&
+			      entry->ve_ext.vfe_age == cur_time);
 }
 
 /* Free extent to persistent free tree */
@@ -139,17 +139,30 @@ unload_space_info(struct vea_space_info *vsi)
 		dbtree_close(vsi->vsi_md_vec_btr);
 		vsi->vsi_md_vec_btr = DAOS_HDL_INVAL;
 	}
+
+	if (!daos_handle_is_inval(vsi->vsi_md_frag_btr)) {
+		dbtree_close(vsi->vsi_md_frag_btr);
+		vsi->vsi_md_frag_btr = DAOS_HDL_INVAL;
+	}
 }
 
+/* Free extents loaded from SCM, they are bulk inserted to compound index */
+struct free_load_ctxt {
+	struct vea_entry	*flc_ents;
+	int			 flc_nr;
+	int			 flc_max;
+};
+
 static int
 load_free_entry(daos_handle_t ih, daos_iov_t *key, daos_iov_t *val, void *arg)
 {
+	struct free_load_ctxt *flc;
 	struct vea_free_extent *vfe;
-	struct vea_space_info *vsi;
+	struct vea_entry *entry;
 	uint64_t *off;
 	int rc;
 
-	vsi = (struct vea_space_info *)arg;
+	flc = (struct free_load_ctxt *)arg;
 	off = (uint64_t *)key->iov_buf;
 	vfe = (struct vea_free_extent *)val->iov_buf;
 
@@ -157,7 +170,97 @@ load_free_entry(daos_handle_t ih, daos_iov_t *key, daos_iov_t *val, void *arg)
 	if (rc != 0)
 		return rc;
 
-	return compound_free(vsi, vfe, VEA_FL_NO_MERGE);
+	/*
+	 * Extents are iterated in offset order, so checking the previous
+	 * one catches all the overlapping and adjacent extents.
+	 */
+	if (flc->flc_nr > 0) {
+		entry = &flc->flc_ents[flc->flc_nr - 1];
+		rc = ext_adjacent(&entry->ve_ext, vfe);
+		if (rc < 0)
+			return rc;
+		if (rc > 0) {
+			D_ERROR("unexpected adjacent extents:"
+				" ["DF_U64", %u], ["DF_U64", %u]\n",
+				entry->ve_ext.vfe_blk_off,
+				entry->ve_ext.vfe_blk_cnt,
+				vfe->vfe_blk_off, vfe->vfe_blk_cnt);
+			return -DER_INVAL;
+		}
+	}
+
+	if (flc->flc_nr == flc->flc_max) {
+		int max = flc->flc_max ? flc->flc_max * 2 : 1024;
+
+		D_REALLOC(entry, flc->flc_ents, max * sizeof(*entry));
+		if (entry == NULL)
+			return -DER_NOMEM;
+
+		flc->flc_ents = entry;
+		flc->flc_max = max;
+	}
+
+	entry = &flc->flc_ents[flc->flc_nr++];
+	memset(entry, 0, sizeof(*entry));
+	entry->ve_ext = *vfe;
+
+	return 0;
+}
+
+static int
+load_free_class(daos_handle_t ih, daos_iov_t *key, daos_iov_t *val,
+		 void *arg)
+{
+	struct vea_space_info *vsi = (struct vea_space_info *)arg;
+
+	return free_class_add(&vsi->vsi_class,
+			      (struct vea_entry *)val->iov_buf, false);
+}
+
+/*
+ * Build up the in-memory compound free extent index. The free extent tree
+ * on SCM is sorted by offset, so the in-memory tree is bulk built in one go,
+ * then the in-tree entries are added to the free class.
+ */
+static int
+load_free_index(struct vea_space_info *vsi)
+{
+	struct free_load_ctxt flc = { 0 };
+	daos_iov_t *keys = NULL, *vals;
+	int i, rc;
+
+	rc = dbtree_iterate(vsi->vsi_md_free_btr, false, load_free_entry,
+			    (void *)&flc);
+	if (rc != 0 || flc.flc_nr == 0)
+		goto out;
+
+	D_ALLOC_ARRAY(keys, 2 * flc.flc_nr);
+	if (keys == NULL) {
+		rc = -DER_NOMEM;
+		goto out;
+	}
+	vals = &keys[flc.flc_nr];
+
+	vsi->vsi_free_blks = 0;
+	for (i = 0; i < flc.flc_nr; i++) {
+		vsi->vsi_free_blks += flc.flc_ents[i].ve_ext.vfe_blk_cnt;
+		daos_iov_set(&keys[i], &flc.flc_ents[i].ve_ext.vfe_blk_off,
+			     sizeof(flc.flc_ents[i].ve_ext.vfe_blk_off));
+		daos_iov_set(&vals[i], &flc.flc_ents[i],
+			     sizeof(flc.flc_ents[i]));
+	}
+
+	D_ASSERT(!daos_handle_is_inval(vsi->vsi_free_btr));
+	rc = dbtree_bulk_insert(vsi->vsi_free_btr, flc.flc_nr, keys, vals);
+	if (rc != 0)
+		goto out;
+
+	rc = dbtree_iterate(vsi->vsi_free_btr, false, load_free_class,
+			    (void *)vsi);
+out:
+	D_FREE(keys);
+	D_FREE(flc.flc_ents);
+	return rc;
 }
 
 static int
@@ -205,9 +308,17 @@ load_space_info(struct vea_space_info *vsi)
 	if (rc != 0)
 		goto error;
 
+	/* Open SCM packed block tree, the old format doesn't have it */
+	D_ASSERT(daos_handle_is_inval(vsi->vsi_md_frag_btr));
+	if (vsi->vsi_md->vsd_compat & VEA_COMPAT_FEATURE_FRAG) {
+		rc = dbtree_open_inplace(&vsi->vsi_md->vsd_frag_tree, &uma,
+					 &vsi->vsi_md_frag_btr);
+		if (rc != 0)
+			goto error;
+	}
+
 	/* Build up in-memory compound free extent index */
-	rc = dbtree_iterate(vsi->vsi_md_free_btr, false, load_free_entry,
-			    (void *)vsi);
+	rc = load_free_index(vsi);
 	if (rc != 0)
 		goto error;
 
@@ -32,6 +32,22 @@
 
 #define VEA_MAGIC	(0xea201804)
 
+/* Block being packed by vea_reserve_frag() for an I/O stream */
+struct vea_frag_context {
+	/* Link to vsi_frag_list while a block is being packed */
+	d_list_t		 vfc_link;
+	/* Space of the block being packed */
+	struct vea_space_info	*vfc_vsi;
+	/* Block being packed, 0 if there is none */
+	uint64_t		 vfc_blk;
+	/* Bytes already packed in vfc_blk */
+	uint32_t		 vfc_used;
+	/* Unpublished packed reservations in vfc_blk */
+	uint32_t		 vfc_inflight;
+	/* The reserved list holding unpublished packed reservations */
+	d_list_t		*vfc_owner;
+};
+
 /* Per I/O stream hint context */
 struct vea_hint_context {
 	struct vea_hint_df	*vhc_pd;
@@ -39,6 +55,8 @@ struct vea_hint_context {
 	uint64_t		 vhc_off;
 	/* In-memory hint sequence */
 	uint64_t		 vhc_seq;
+	/* Packed block of the I/O stream */
+	struct vea_frag_context	 vhc_frag;
 };
 
 /* Free extent informat stored in the in-memory compound free extent index */
@@ -115,6 +133,8 @@ struct vea_space_info {
 	daos_handle_t			 vsi_md_free_btr;
 	/* Open handles for the persistent extent vector tree */
 	daos_handle_t			 vsi_md_vec_btr;
+	/* Open handles for the persistent packed block tree */
+	daos_handle_t			 vsi_md_frag_btr;
 	/* Free extent tree sorted by offset, for all free extents. */
 	daos_handle_t			 vsi_free_btr;
 	/* Extent vector tree, for non-contiguous allocation */
@@ -132,6 +152,15 @@ struct vea_space_info {
 	uint64_t			 vsi_agg_time;
 	/* Unmap context to perform unmap against freed extent */
 	struct vea_unmap_context	 vsi_unmap_ctxt;
+	/* Packed block of the reservations without hint */
+	struct vea_frag_context		 vsi_frag;
+	/* All the frag contexts packing a block, see vea_frag_context */
+	d_list_t			 vsi_frag_list;
+	/*
+	 * Free blocks in the persistent free extent tree, it's summed up on
+	 * load and adjusted on persistent alloc and free commit.
+	 */
+	uint64_t			 vsi_free_blks;
 	/* Statistics */
 	uint64_t			 vsi_stat[STAT_MAX];
 };
@@ -188,12 +217,28 @@ int reserve_vector(struct vea_space_info *vsi, uint32_t blk_cnt,
 int persistent_alloc(struct vea_space_info *vsi, struct vea_free_extent *vfe);
 
 /* vea_free.c */
+int free_class_add(struct vea_free_class *vfc, struct vea_entry *entry,
+		   bool newest);
 int compound_free(struct vea_space_info *vsi, struct vea_free_extent *vfe,
 		  unsigned int flags);
 int persistent_free(struct vea_space_info *vsi, struct vea_free_extent *vfe);
 int aggregated_free(struct vea_space_info *vsi, struct vea_free_extent *vfe);
 void migrate_free_exts(struct vea_space_info *vsi);
 
+/* vea_frag.c */
+void frag_context_init(struct vea_frag_context *vfc);
+struct vea_frag_context *frag_context(struct vea_space_info *vsi,
+				      struct vea_hint_context *hint);
+void frag_start(struct vea_space_info *vsi, struct vea_frag_context *vfc,
+		uint64_t blk_off);
+int frag_retire(struct vea_space_info *vsi, struct vea_frag_context *vfc);
+void frag_reset(struct vea_frag_context *vfc);
+int frag_publish(struct vea_space_info *vsi, struct vea_frag_context *vfc,
+		 struct vea_resrvd_ext *resrvd);
+void frag_cancel(struct vea_frag_context *vfc, struct vea_resrvd_ext *resrvd);
+int frag_put(struct vea_space_info *vsi, uint64_t blk_off);
+int frag_cleanup(struct vea_space_info *vsi);
+
 /* vea_hint.c */
 void hint_get(struct vea_hint_context *hint, uint64_t *off);
 void hint_update(struct vea_hint_context *hint, uint64_t off, uint64_t *seq);
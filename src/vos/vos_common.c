@@ -32,14 +32,13 @@
 #include <daos/rpc.h>
 #include <daos_srv/daos_server.h>
 #include <vos_internal.h>
-#include <daos/lru.h>
 #include <daos/btree_class.h>
 
 static pthread_mutex_t	mutex = PTHREAD_MUTEX_INITIALIZER;
 /**
  * Object cache based on mode of instantiation
  */
-struct daos_lru_cache*
+struct vos_obj_cache *
 vos_get_obj_cache(void)
 {
 #ifdef VOS_STANDALONE
@@ -82,6 +81,57 @@ vos_csum_compute(daos_sg_list_t *sgl, daos_csum_buf_t *csum)
 	return rc;
 }
 
+int
+vos_csum_compute_chunks(daos_sg_list_t *sgl, daos_size_t len,
+			daos_csum_buf_t *chunks)
+{
+#ifdef VOS_STANDALONE
+	daos_csum_t *checksum = &vsa_imems_inst->vis_checksum;
+#else
+	daos_csum_t *checksum =
+		&vos_tls_get()->vtl_imems_inst.vis_checksum;
+#endif
+	daos_size_t	 nob;
+	void		*buf;
+	int		 rc;
+
+	nob = daos_csum_chunk_nr(len, DAOS_CSUM_CHUNK_SIZE) *
+	      daos_csum_get_size(checksum);
+	if (nob > UINT16_MAX) {
+		D_ERROR("Too many chunks for "DF_U64" bytes\n", len);
+		return -DER_OVERFLOW;
+	}
+
+	D_ALLOC(buf, nob);
+	if (buf == NULL)
+		return -DER_NOMEM;
+
+	daos_csum_set(chunks, buf, nob);
+	rc = daos_csum_reset(checksum);
+	if (rc == 0)
+		rc = daos_csum_compute_chunks(checksum, sgl,
+					      DAOS_CSUM_CHUNK_SIZE, chunks);
+	if (rc != 0) {
+		D_ERROR("Chunk checksum compute error from VOS: %d\n", rc);
+		D_FREE(buf);
+		daos_csum_set(chunks, NULL, 0);
+	}
+	return rc;
+}
+
+int
+vos_csum_chunk_verify(daos_csum_buf_t *chunks, unsigned int idx,
+		      const void *buf, daos_size_t len)
+{
+#ifdef VOS_STANDALONE
+	daos_csum_t *checksum = &vsa_imems_inst->vis_checksum;
+#else
+	daos_csum_t *checksum =
+		&vos_tls_get()->vtl_imems_inst.vis_checksum;
+#endif
+	return daos_csum_chunk_verify(checksum, chunks, idx, buf, len);
+}
+
 /**
  * VOS in-memory structure creation.
  * Handle-hash:
@@ -115,11 +165,21 @@ static inline int
 vos_imem_strts_create(struct vos_imem_strts *imem_inst)
 {
 	char		*env;
+	int		cache_bits = OBJ_CACHE_BITS;
 	int		rc;
 
 	imem_inst->vis_enable_checksum = 0;
-	rc = vos_obj_cache_create(LRU_CACHE_BITS,
-				  &imem_inst->vis_ocache);
+	env = getenv("VOS_OBJ_CACHE_BITS");
+	if (env != NULL) {
+		cache_bits = atoi(env);
+		if (cache_bits < 0 || cache_bits > 24) {
+			D_WARN("invalid VOS_OBJ_CACHE_BITS %s, use %d\n",
+			       env, OBJ_CACHE_BITS);
+			cache_bits = OBJ_CACHE_BITS;
+		}
+	}
+
+	rc = vos_obj_cache_create(cache_bits, &imem_inst->vis_ocache);
 	if (rc) {
 		D_ERROR("Error in createing object cache\n");
 		return rc;
@@ -284,7 +344,7 @@ vos_nvme_init(void)
 
 	/* IV tree used by VEA */
 	rc = dbtree_class_register(DBTREE_CLASS_IV,
-				   BTR_FEAT_UINT_KEY,
+				   BTR_FEAT_UINT_KEY | BTR_FEAT_KEY_ARRAY,
 				   &dbtree_iv_ops);
 	if (rc != 0 && rc != -DER_EXIST)
 		return rc;
@@ -34,6 +34,7 @@
 #include <daos/mem.h>
 #include <gurt/hash.h>
 #include <daos/btree.h>
+#include <daos/object.h>
 #include <daos_types.h>
 #include <vos_internal.h>
 #include <vos_obj.h>
@@ -420,6 +421,116 @@ vos_cont_query(daos_handle_t coh, vos_cont_info_t *cont_info)
 	return 0;
 }
 
+/**
+ * Objects waiting for aggregation are ordered ahead of the others, then the
+ * most updated ones.
+ */
+static bool
+hot_obj_less(struct vos_hot_obj *h1, struct vos_hot_obj *h2)
+{
+	if (h1->ho_agg != h2->ho_agg)
+		return h2->ho_agg;
+	return h1->ho_cnt < h2->ho_cnt;
+}
+
+/**
+ * Account \a cnt updates of object \a oid in the hot object table of the
+ * container. The table has a fixed number of slots, an object which is not
+ * in the full table takes the slot of the least updated one and inherits its
+ * count, so a frequently updated object can't be missed, while the count of
+ * a rarely updated one may be overestimated.
+ *
+ * \a agg is set if the update found the object should be aggregated, such
+ * an object is not evicted by the others until vos_cont_agg_objs() returns
+ * it, unless all the slots are taken by such objects.
+ */
+void
+vos_cont_hot_update(struct vos_container *cont, daos_unit_oid_t oid,
+		    unsigned int cnt, bool agg)
+{
+	struct vos_hot_obj	*hot;
+	struct vos_hot_obj	*min = NULL;
+	int			 i;
+
+	for (i = 0; i < cont->vc_hot_nr; i++) {
+		hot = &cont->vc_hot[i];
+		if (daos_unit_obj_id_equal(hot->ho_oid, oid)) {
+			hot->ho_cnt += cnt;
+			hot->ho_agg |= agg;
+			return;
+		}
+		if (min == NULL || hot_obj_less(hot, min))
+			min = hot;
+	}
+
+	if (cont->vc_hot_nr < VOS_HOT_OBJ_MAX) {
+		hot = &cont->vc_hot[cont->vc_hot_nr++];
+		hot->ho_cnt = cnt;
+	} else {
+		hot = min;
+		hot->ho_cnt += cnt;
+	}
+	hot->ho_oid = oid;
+	hot->ho_agg = agg;
+}
+
+/**
+ * Return the most updated objects of the container, and drain the table
+ */
+int
+vos_cont_hot_objs(daos_handle_t coh, daos_unit_oid_t *oids, int nr)
+{
+	struct vos_container	*cont;
+	struct vos_hot_obj	 tmp;
+	int			 i;
+	int			 j;
+
+	cont = vos_hdl2cont(coh);
+	if (cont == NULL) {
+		D_ERROR("Empty container handle for hot objects?\n");
+		return -DER_INVAL;
+	}
+
+	for (i = 0; i < nr && i < cont->vc_hot_nr; i++) {
+		for (j = i + 1; j < cont->vc_hot_nr; j++) {
+			if (!hot_obj_less(&cont->vc_hot[i], &cont->vc_hot[j]))
+				continue;
+			tmp = cont->vc_hot[i];
+			cont->vc_hot[i] = cont->vc_hot[j];
+			cont->vc_hot[j] = tmp;
+		}
+		oids[i] = cont->vc_hot[i].ho_oid;
+	}
+	cont->vc_hot_nr = 0;
+	return i;
+}
+
+/**
+ * Return the objects which have been found deep or overlapped by updates,
+ * they are kept in the hot object table with their update counts.
+ */
+int
+vos_cont_agg_objs(daos_handle_t coh, daos_unit_oid_t *oids, int nr)
+{
+	struct vos_container	*cont;
+	int			 found;
+	int			 i;
+
+	cont = vos_hdl2cont(coh);
+	if (cont == NULL) {
+		D_ERROR("Empty container handle for aggregation?\n");
+		return -DER_INVAL;
+	}
+
+	for (i = found = 0; i < cont->vc_hot_nr && found < nr; i++) {
+		if (!cont->vc_hot[i].ho_agg)
+			continue;
+		cont->vc_hot[i].ho_agg = false;
+		oids[found++] = cont->vc_hot[i].ho_oid;
+	}
+	return found;
+}
+
 /**
  * Destroy a container
  */
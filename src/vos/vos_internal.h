@@ -35,7 +35,6 @@
 #include <daos/btree.h>
 #include <daos/common.h>
 #include <daos/checksum.h>
-#include <daos/lru.h>
 #include <daos_srv/daos_server.h>
 #include <daos_srv/bio.h>
 #include <vos_layout.h>
@@ -70,6 +69,21 @@ static inline uint64_t vos_byte2blkoff(uint64_t bytes)
 	return bytes >> VOS_BLK_SHIFT;
 }
 
+/*
+ * Free NVMe extent @addr of @bytes. Packed extent (see vea_reserve_frag())
+ * shares the block with other small extents, the block is freed along with
+ * the last extent in it.
+ */
+static inline int vos_blk_free(struct vea_space_info *vsi, bio_addr_t *addr,
+			       daos_size_t bytes)
+{
+	if (bio_addr_is_frag(addr))
+		return vea_free_frag(vsi, addr->ba_off >> VOS_BLK_SHIFT);
+
+	return vea_free(vsi, vos_byte2blkoff(addr->ba_off),
+			vos_byte2blkcnt(bytes));
+}
+
 /**
  * VOS cookie table
  * In-memory btree to hold all cookies and max epoch updated
@@ -78,6 +92,63 @@ struct vos_cookie_table {
 	struct btr_root		cit_btr;
 };
 
+/**
+ * Record information passed to the media selection policy
+ */
+struct vos_media_hint {
+	/** object of the record, carries the object class */
+	daos_unit_oid_t		 mh_oid;
+	/** akey of the record */
+	daos_key_t		*mh_akey;
+	/** single value or array */
+	daos_iod_type_t		 mh_type;
+	/** record size in bytes */
+	daos_size_t		 mh_size;
+};
+
+/** Max number of placement rules of a media policy */
+#define VOS_MEDIA_RULE_MAX	8
+/** Max length of the akey prefix of a placement rule */
+#define VOS_MEDIA_AKEY_MAX	32
+
+/**
+ * Placement rule of a media policy, records of the object class, or whose
+ * akey starts with the prefix, are always stored on the media of the rule.
+ */
+struct vos_media_rule {
+	/** object class, 0 if the rule matches on akey */
+	daos_oclass_id_t	 mr_oclass;
+	/** BIO_ADDR_SCM or BIO_ADDR_NVME */
+	uint16_t		 mr_media;
+	/** length of \a mr_akey, 0 if the rule matches on object class */
+	uint32_t		 mr_akey_len;
+	char			 mr_akey[VOS_MEDIA_AKEY_MAX];
+};
+
+/**
+ * Media selection policy of a VOS pool, it decides where a new record is
+ * stored, and where the background migration moves a cold or hot extent.
+ * The default policy is set by vos_media_policy_init().
+ */
+struct vos_media_policy {
+	/** records of this size or larger are stored on NVMe */
+	daos_size_t		 mp_size_thresh;
+	/**
+	 * SCM usage in percentage, above it small array extents are stored
+	 * on NVMe, and the cold extents are migrated to NVMe.
+	 */
+	unsigned int		 mp_scm_hwm;
+	/** hot NVMe extents up to this size are promoted, 0 to disable */
+	daos_size_t		 mp_promote_max;
+	/**
+	 * Placement rules by object class or akey, checked in order before
+	 * the rules above. The migration never moves an extent out of the
+	 * media of its rule.
+	 */
+	unsigned int		 mp_rule_nr;
+	struct vos_media_rule	 mp_rules[VOS_MEDIA_RULE_MAX];
+};
+
 /**
  * VOS pool (DRAM)
  */
@@ -102,6 +173,42 @@ struct vos_pool {
 	struct bio_io_context	*vp_io_ctxt;
 	/** In-memory free space tracking for NVMe device */
 	struct vea_space_info	*vp_vea_info;
+	/** media selection policy, see vos_media_select() */
+	struct vos_media_policy	 vp_policy;
+	/** cached SCM usage in percentage, see vos_pool_scm_usage() */
+	unsigned int		 vp_scm_usage;
+	/** time (in seconds) when \a vp_scm_usage was refreshed */
+	uint64_t		 vp_scm_time;
+	/** new trees have the key array, see VOS_POOL_INCOMPAT_KEY_ARRAY */
+	bool			 vp_key_array;
+	/** new extents can have checksums, see VOS_POOL_INCOMPAT_EXT_CSUM */
+	bool			 vp_ext_csum;
+};
+
+/** number of objects tracked by the hot object table of a container */
+#define VOS_HOT_OBJ_MAX		32
+/** number of fetch lease buckets per container, see vos_obj_lease_get() */
+#define VOS_LEASE_BUCKETS	64
+/** number of fetch heat buckets per container, see vos_obj_heat_inc() */
+#define VOS_HEAT_BUCKETS	256
+/** fetches in a decay interval which make an object hot */
+#define VOS_TIER_HOT_FETCHES	8
+
+/** evtree depth from which an overwritten object is aggregated in advance */
+#define VOS_AGG_EVT_DEPTH	4
+/**
+ * number of overlapped extents (in the leaf node of an inserted extent) from
+ * which an updated object is aggregated in advance
+ */
+#define VOS_AGG_EVT_OVERLAP	8
+
+/** entry of the hot object table, see vos_cont_hot_update() */
+struct vos_hot_obj {
+	daos_unit_oid_t		ho_oid;
+	/** number of updates since the table was drained */
+	uint64_t		ho_cnt;
+	/** an evtree of the object is deep or overlapped, see akey_update() */
+	bool			ho_agg;
 };
 
 /**
@@ -127,6 +234,15 @@ struct vos_container {
 	 * durable hint in vos_cont_df
 	 */
 	struct vea_hint_context	*vc_hint_ctxt;
+	/** the most updated objects, candidates of aggregation */
+	struct vos_hot_obj	 vc_hot[VOS_HOT_OBJ_MAX];
+	int			 vc_hot_nr;
+	/** in-flight fetches, hashed by object ID */
+	uint32_t		 vc_leases[VOS_LEASE_BUCKETS];
+	/** decayed fetch counts, hashed by object ID */
+	uint16_t		 vc_heat[VOS_HEAT_BUCKETS];
+	/** time (in seconds) when \a vc_heat was decayed */
+	uint64_t		 vc_heat_time;
 };
 
 struct vos_imem_strts {
@@ -134,7 +250,7 @@ struct vos_imem_strts {
 	 * In-memory object cache for the PMEM
 	 * object table
 	 */
-	struct daos_lru_cache	*vis_ocache;
+	struct vos_obj_cache	*vis_ocache;
 	/** Hash table to refcount VOS handles */
 	/** (container/pool, etc.,) */
 	struct d_hash_table	*vis_pool_hhash;
@@ -162,6 +278,8 @@ enum {
 	VOS_KEY_CMP_UINT64	= (1ULL << 63),
 	VOS_KEY_CMP_LEXICAL	= (1ULL << 62),
 	VOS_KEY_CMP_ANY		= (VOS_KEY_CMP_UINT64 | VOS_KEY_CMP_LEXICAL),
+	/** evtrees under the key tree have EVT_FEAT_CSUM */
+	VOS_KEY_EXT_CSUM	= (1ULL << 61),
 };
 
 #define VOS_KEY_CMP_UINT64_SET	(VOS_KEY_CMP_UINT64  | BTR_FEAT_DIRECT_KEY)
@@ -174,8 +292,14 @@ enum {
  * A cached object (DRAM data structure).
  */
 struct vos_object {
-	/** llink for daos lru cache */
-	struct daos_llink		obj_llink;
+	/** hash of obj_cont and obj_id, see obj_cache_hash() */
+	uint64_t			obj_hash;
+	/** number of references held by the callers */
+	uint32_t			obj_ref;
+	/** CLOCK reference bit, set by vos_obj_hold() */
+	uint32_t			obj_clock:1,
+	/** has been evicted, it is freed on the last release */
+					obj_evicted:1;
 	/** Key for searching, object ID within a container */
 	daos_unit_oid_t			obj_id;
 	/** dkey tree open handle of the object */
@@ -319,7 +443,7 @@ PMEMobjpool *vos_coh2pop(daos_handle_t coh);
  * Getting object cache
  * Wrapper for TLS and standalone mode
  */
-struct daos_lru_cache *vos_get_obj_cache(void);
+struct vos_obj_cache *vos_get_obj_cache(void);
 
 /**
  * Check if checksum is enabled
@@ -330,6 +454,20 @@ int vos_csum_enabled(void);
  * compute checksum for a sgl using CRC64
  */
 int vos_csum_compute(daos_sg_list_t *sgl, daos_csum_buf_t *csum);
+
+/**
+ * Compute the per-chunk checksums of the \a len bytes of \a sgl with
+ * DAOS_CSUM_CHUNK_SIZE, \a chunks->cs_csum is allocated and should be freed
+ * by the caller.
+ */
+int vos_csum_compute_chunks(daos_sg_list_t *sgl, daos_size_t len,
+			    daos_csum_buf_t *chunks);
+/**
+ * Verify chunk \a idx of the per-chunk checksums \a chunks with the \a len
+ * bytes of \a buf, it returns -DER_IO on mismatch.
+ */
+int vos_csum_chunk_verify(daos_csum_buf_t *chunks, unsigned int idx,
+			  const void *buf, daos_size_t len);
 /**
  * Register btree class for container table, it is called within vos_init()
  *
@@ -718,8 +856,77 @@ vos_hdl2cont(daos_handle_t coh)
 }
 
 void vos_cont_addref(struct vos_container *cont);
+void vos_cont_hot_update(struct vos_container *cont, daos_unit_oid_t oid,
+			 unsigned int cnt, bool agg);
 void vos_cont_decref(struct vos_container *cont);
 
+void vos_media_policy_init(struct vos_media_policy *policy);
+int vos_media_rules_parse(struct vos_media_policy *policy, const char *str);
+uint16_t vos_media_select(struct vos_container *cont,
+			  const struct vos_media_hint *hint);
+unsigned int vos_pool_scm_usage(struct vos_pool *pool);
+
+static inline uint32_t *
+vos_obj_lease_bucket(struct vos_container *cont, daos_unit_oid_t oid)
+{
+	uint64_t	hash;
+
+	hash = oid.id_pub.lo ^ oid.id_pub.hi ^ oid.id_shard;
+	return &cont->vc_leases[hash % VOS_LEASE_BUCKETS];
+}
+
+/**
+ * A fetch holds a lease on the object from vos_fetch_begin() until
+ * vos_fetch_end(), the SCM extents it returned may be accessed directly
+ * (e.g. as the source of a bulk transfer) while the lease is held, so
+ * aggregation must not free them. Leases are hashed into buckets, so an
+ * object may be reported as leased by the fetch of a different object,
+ * which only delays its aggregation.
+ */
+static inline void
+vos_obj_lease_get(struct vos_container *cont, daos_unit_oid_t oid)
+{
+	(*vos_obj_lease_bucket(cont, oid))++;
+}
+
+static inline void
+vos_obj_lease_put(struct vos_container *cont, daos_unit_oid_t oid)
+{
+	uint32_t	*bucket = vos_obj_lease_bucket(cont, oid);
+
+	D_ASSERT(*bucket > 0);
+	(*bucket)--;
+}
+
+static inline bool
+vos_obj_leased(struct vos_container *cont, daos_unit_oid_t oid)
+{
+	return *vos_obj_lease_bucket(cont, oid) != 0;
+}
+
+static inline uint16_t *
+vos_obj_heat_bucket(struct vos_container *cont, daos_unit_oid_t oid)
+{
+	uint64_t	hash;
+
+	hash = oid.id_pub.lo ^ oid.id_pub.hi ^ oid.id_shard;
+	return &cont->vc_heat[hash % VOS_HEAT_BUCKETS];
+}
+
+/**
+ * Account a fetch of the object, the counts are halved periodically by the
+ * media migration (see vos_obj_tier()), so they reflect recent fetches.
+ * Like the leases, objects sharing a bucket share the count.
+ */
+static inline void
+vos_obj_heat_inc(struct vos_container *cont, daos_unit_oid_t oid)
+{
+	uint16_t	*bucket = vos_obj_heat_bucket(cont, oid);
+
+	if (*bucket < UINT16_MAX)
+		(*bucket)++;
+}
+
 static inline void
 vos_cont_set_purged_epoch(daos_handle_t coh, daos_epoch_t update_epoch)
 {
@@ -895,6 +1102,8 @@ key_tree_release(daos_handle_t toh, bool is_array);
 int
 key_tree_punch(struct vos_object *obj, daos_handle_t toh, daos_iov_t *key_iov,
 	       daos_iov_t *val_iov, int flags);
+int
+recx_data_free(struct vos_object *obj, struct evt_entry *ent, uint32_t inob);
 
 /* Update the timestamp in a key or object.  The latest and earliest must be
  * contiguous in the struct being updated.  This is ensured at present by
@@ -29,6 +29,7 @@
 
 #include <daos/common.h>
 #include <daos/btree.h>
+#include <daos/slab.h>
 #include <daos_types.h>
 #include <daos_srv/vos.h>
 #include "vos_internal.h"
@@ -58,7 +59,10 @@ struct vos_io_context {
 	d_list_t		 ic_blk_exts;
 	/** flags */
 	unsigned int		 ic_update:1,
-				 ic_size_fetch:1;
+				 ic_size_fetch:1,
+				 ic_lease:1,
+				 /** an updated evtree needs aggregation */
+				 ic_agg:1;
 };
 
 static struct vos_io_context *
@@ -144,11 +148,14 @@ vos_ioc_destroy(struct vos_io_context *ioc)
 	if (ioc->ic_biod != NULL)
 		bio_iod_free(ioc->ic_biod);
 
+	if (ioc->ic_lease)
+		vos_obj_lease_put(ioc->ic_obj->obj_cont, ioc->ic_obj->obj_id);
+
 	if (ioc->ic_obj)
 		vos_obj_release(vos_obj_cache_current(), ioc->ic_obj);
 
 	vos_ioc_reserve_fini(ioc);
-	D_FREE(ioc);
+	daos_slab_free(DAOS_SLAB_VOS_IOC, ioc);
 }
 
 static int
@@ -160,7 +167,7 @@ vos_ioc_create(daos_handle_t coh, daos_unit_oid_t oid, bool read_only,
 	struct bio_io_context *bioc;
 	int i, rc;
 
-	D_ALLOC_PTR(ioc);
+	ioc = daos_slab_alloc(DAOS_SLAB_VOS_IOC, sizeof(*ioc));
 	if (ioc == NULL)
 		return -DER_NOMEM;
 
@@ -298,6 +305,67 @@ biov_set_hole(struct bio_iov *biov, ssize_t len)
 	bio_addr_set_hole(&biov->bi_addr, 1);
 }
 
+/**
+ * Verify the per-chunk checksums of the part of extent \a ent selected by the
+ * fetch. Only the chunks covering the selection are read, so a partial fetch
+ * of a large extent doesn't read the whole extent.
+ */
+static int
+akey_fetch_verify(struct vos_io_context *ioc, struct evt_entry *ent,
+		  uint32_t inob)
+{
+	struct bio_io_context	*bioc;
+	daos_size_t		 chunk_size = ent->en_chunk_size;
+	daos_size_t		 ext_size;
+	daos_size_t		 lo;
+	daos_size_t		 hi;
+	daos_size_t		 off;
+	bio_addr_t		 addr;
+	daos_iov_t		 iov;
+	char			*buf;
+	unsigned int		 idx;
+	int			 rc = 0;
+
+	if (!vos_csum_enabled() || ent->en_chunk_csum.cs_len == 0)
+		return 0;
+
+	/* byte range of the selection in the extent, rounded to chunks */
+	ext_size = evt_extent_width(&ent->en_ext) * inob;
+	off = (ent->en_sel_ext.ex_lo - ent->en_ext.ex_lo) * inob;
+	lo = off - off % chunk_size;
+	hi = off + evt_extent_width(&ent->en_sel_ext) * inob;
+	hi = min((hi + chunk_size - 1) / chunk_size * chunk_size, ext_size);
+
+	/* en_addr points to the selection */
+	addr = ent->en_addr;
+	addr.ba_off -= off - lo;
+
+	D_ALLOC(buf, hi - lo);
+	if (buf == NULL)
+		return -DER_NOMEM;
+
+	bioc = ioc->ic_obj->obj_cont->vc_pool->vp_io_ctxt;
+	daos_iov_set(&iov, buf, hi - lo);
+	rc = bio_readv(bioc, addr, &iov);
+	if (rc != 0)
+		goto out;
+
+	for (off = lo; off < hi; off += chunk_size) {
+		idx = off / chunk_size;
+		rc = vos_csum_chunk_verify(&ent->en_chunk_csum, idx,
+					   buf + off - lo,
+					   min(chunk_size, hi - off));
+		if (rc != 0) {
+			D_ERROR("Corrupted chunk %u of "DF_ENT": %d\n", idx,
+				DP_ENT(ent), rc);
+			break;
+		}
+	}
+out:
+	D_FREE(buf);
+	return rc;
+}
+
 /** Fetch an extent from an akey */
 static int
 akey_fetch_recx(daos_handle_t toh, daos_epoch_t epoch, daos_recx_t *recx,
@@ -371,6 +439,12 @@ akey_fetch_recx(daos_handle_t toh, daos_epoch_t epoch, daos_recx_t *recx,
 			holes = 0;
 		}
 
+		if (!ioc->ic_size_fetch) {
+			rc = akey_fetch_verify(ioc, ent, rsize);
+			if (rc != 0)
+				goto failed;
+		}
+
 		biov.bi_data_len = nr * rsize;
 		biov.bi_addr = ent->en_addr;
 		rc = iod_fetch(ioc, &biov);
@@ -598,6 +672,11 @@ vos_fetch_begin(daos_handle_t coh, daos_unit_oid_t oid, daos_epoch_t epoch,
 	if (rc != 0)
 		return rc;
 
+	/* held until vos_fetch_end(), see vos_obj_lease_get() */
+	vos_obj_lease_get(ioc->ic_obj->obj_cont, oid);
+	ioc->ic_lease = 1;
+	vos_obj_heat_inc(ioc->ic_obj->obj_cont, oid);
+
 	if (vos_obj_is_empty(ioc->ic_obj)) {
 		for (i = 0; i < iod_nr; i++)
 			iod_empty_sgl(ioc, i);
@@ -692,20 +771,26 @@ akey_update_single(daos_handle_t toh, daos_epoch_t epoch,
  */
 static int
 akey_update_recx(daos_handle_t toh, daos_epoch_t epoch, uuid_t cookie,
-		 uint32_t pm_ver, daos_recx_t *recx, daos_size_t rsize,
-		 struct vos_io_context *ioc)
+		 uint32_t pm_ver, daos_recx_t *recx, daos_csum_buf_t *csum,
+		 daos_size_t rsize, struct vos_io_context *ioc)
 {
 	struct evt_entry_in ent;
 	struct bio_iov *biov;
 	int rc;
 
 	D_ASSERT(recx->rx_nr > 0);
+	memset(&ent, 0, sizeof(ent));
 	ent.ei_rect.rc_epc = epoch;
 	ent.ei_rect.rc_ex.ex_lo = recx->rx_idx;
 	ent.ei_rect.rc_ex.ex_hi = recx->rx_idx + recx->rx_nr - 1;
 	ent.ei_ver = pm_ver;
 	ent.ei_inob = rsize;
 	uuid_copy(ent.ei_cookie, cookie);
+	/* per-chunk checksums, stored if the pool supports them */
+	if (csum != NULL && csum->cs_len != 0 && rsize != 0) {
+		ent.ei_chunk_csum = *csum;
+		ent.ei_chunk_size = DAOS_CSUM_CHUNK_SIZE;
+	}
 
 	biov = iod_update_biov(ioc);
 	ent.ei_addr = biov->bi_addr;
@@ -714,6 +799,23 @@ akey_update_recx(daos_handle_t toh, daos_epoch_t epoch, uuid_t cookie,
 	return rc;
 }
 
+/**
+ * Check if the evtree is deep or overlapped enough by the updates that the
+ * object should be aggregated in advance.
+ */
+static bool
+akey_evt_agg_check(daos_handle_t toh)
+{
+	struct evt_stat	stat;
+
+	if (evt_query(toh, &stat) != 0)
+		return false;
+
+	/* NB: a deep tree is not worth aggregating if nothing is overwritten */
+	return stat.es_overlap >= VOS_AGG_EVT_OVERLAP ||
+	       (stat.es_depth >= VOS_AGG_EVT_DEPTH && stat.es_overlap != 0);
+}
+
 static void
 update_bounds(daos_epoch_range_t *epr_bound,
 	      const daos_epoch_range_t *new_epr)
@@ -798,9 +900,15 @@ akey_update(struct vos_io_context *ioc, uuid_t cookie, uint32_t pm_ver,
 
 		D_DEBUG(DB_IO, "Array update %d eph "DF_U64"\n", i, epoch);
 		rc = akey_update_recx(toh, epoch, cookie, pm_ver,
-				      &iod->iod_recxs[i], iod->iod_size, ioc);
+				      &iod->iod_recxs[i],
+				      iod->iod_csums ? &iod->iod_csums[i] :
+						       NULL,
+				      iod->iod_size, ioc);
 		if (rc != 0)
 			goto failed;
+
+		if (!ioc->ic_agg && akey_evt_agg_check(toh))
+			ioc->ic_agg = 1;
 	}
 out:
 	rc = vos_df_ts_update(ioc->ic_obj, &krec->kr_latest, &akey_epr);
@@ -931,6 +1039,20 @@ vos_reserve(struct vos_io_context *ioc, uint16_t media, daos_size_t size,
 	D_ASSERT(vsi);
 	hint_ctxt = obj->obj_cont->vc_hint_ctxt;
 	D_ASSERT(hint_ctxt);
+
+	/* Pack the small record into a block shared with others */
+	if (size < VOS_BLK_SZ) {
+		rc = vea_reserve_frag(vsi, size, hint_ctxt, &ioc->ic_blk_exts);
+		if (rc)
+			return rc;
+
+		ext = d_list_entry(ioc->ic_blk_exts.prev,
+				   struct vea_resrvd_ext, vre_link);
+		D_ASSERT(ext->vre_frag_len == size);
+		*off = (ext->vre_blk_off << VOS_BLK_SHIFT) + ext->vre_frag_off;
+		return 0;
+	}
+
 	blk_cnt = vos_byte2blkcnt(size);
 
 	rc = vea_reserve(vsi, blk_cnt, hint_ctxt, &ioc->ic_blk_exts);
@@ -1056,10 +1178,23 @@ vos_reserve_recx(struct vos_io_context *ioc, uint16_t media, daos_size_t size)
 	 * larger rect will be stored on NVMe and small reminder on SCM.
 	 */
 	rc = vos_reserve(ioc, media, size, &off);
+	/*
+	 * The packed block is being written by another update of the same
+	 * container, or the pool doesn't support packing, use SCM.
+	 */
+	if ((rc == -DER_BUSY || rc == -DER_NOSYS) && media == BIO_ADDR_NVME) {
+		D_ASSERT(size < VOS_BLK_SZ);
+		media = BIO_ADDR_SCM;
+		rc = vos_reserve(ioc, media, size, &off);
+	}
 	if (rc) {
 		D_ERROR("Reserve recx failed. %d\n", rc);
 		return rc;
 	}
+
+	/* Record the allocation class, it decides how the extent is freed */
+	if (media == BIO_ADDR_NVME && size < VOS_BLK_SZ)
+		bio_addr_set_frag(&biov.bi_addr);
 done:
 	bio_addr_set(&biov.bi_addr, media, off);
 	biov.bi_data_len = size;
@@ -1068,21 +1203,19 @@ done:
 	return rc;
 }
 
-/*
- * A simple media selection policy embedded in VOS, which select media by
- * akey type and record size.
- */
+/* Select media for a record by the media policy of the pool */
 static uint16_t
-akey_media_select(struct vos_io_context *ioc, daos_iod_type_t type,
+akey_media_select(struct vos_io_context *ioc, daos_iod_t *iod,
 		  daos_size_t size)
 {
-	struct vea_space_info *vsi;
+	struct vos_media_hint	hint;
 
-	vsi = ioc->ic_obj->obj_cont->vc_pool->vp_vea_info;
-	if (vsi == NULL)
-		return BIO_ADDR_SCM;
-	else
-		return (size >= VOS_BLK_SZ) ? BIO_ADDR_NVME : BIO_ADDR_SCM;
+	hint.mh_oid = ioc->ic_obj->obj_id;
+	hint.mh_akey = &iod->iod_name;
+	hint.mh_type = iod->iod_type;
+	hint.mh_size = size;
+
+	return vos_media_select(ioc->ic_obj->obj_cont, &hint);
 }
 
 static int
@@ -1103,7 +1236,7 @@ akey_update_begin(struct vos_io_context *ioc)
 		size = (iod->iod_type == DAOS_IOD_SINGLE) ? iod->iod_size :
 				iod->iod_recxs[i].rx_nr * iod->iod_size;
 
-		media = akey_media_select(ioc, iod->iod_type, size);
+		media = akey_media_select(ioc, iod, size);
 
 		if (iod->iod_type == DAOS_IOD_SINGLE)
 			rc = vos_reserve_single(ioc, media, size);
@@ -1236,6 +1369,9 @@ vos_update_end(daos_handle_t ioh, uuid_t cookie, uint32_t pm_ver,
 
 abort:
 	err = err ? umem_tx_abort(umem, err) : umem_tx_commit(umem);
+	if (err == 0)
+		vos_cont_hot_update(ioc->ic_obj->obj_cont, ioc->ic_obj->obj_id,
+				    ioc->ic_iod_nr, ioc->ic_agg);
 out:
 	if (err != 0)
 		update_cancel(ioc);
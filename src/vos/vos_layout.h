@@ -97,6 +97,45 @@ struct vos_cookie_rec_df {
 	daos_epoch_t		cr_max_epoch;
 };
 
+/**
+ * Persistent pool info, it's the leading part of vos_pool_info_t, the rest of
+ * vos_pool_info_t is collected by vos_pool_query() from DRAM.
+ */
+struct vos_pool_info_df {
+	/** # of containers in this pool */
+	uint64_t		pi_cont_nr;
+	/** Total space available on SCM */
+	daos_size_t		pi_scm_sz;
+	/** Total space available on NVMe */
+	daos_size_t		pi_blob_sz;
+	/** Current available space */
+	daos_size_t		pi_avail;
+};
+
+/** Magic of the pool root, pools created without it are layout version 0 */
+#define VOS_POOL_MAGIC			0x5ca1ab1e
+/**
+ * Layout version of the pool.
+ * 1: OI, dkey and akey trees can have the in-node key array, see
+ *    VOS_POOL_INCOMPAT_KEY_ARRAY.
+ * 2: Extents can have per-chunk checksums, see VOS_POOL_INCOMPAT_EXT_CSUM.
+ */
+#define VOS_POOL_DF_VERSION		2
+
+/**
+ * The trees of the pool may have BTR_FEAT_KEY_ARRAY, which changes the node
+ * layout. Only the pools with this flag create such trees.
+ */
+#define VOS_POOL_INCOMPAT_KEY_ARRAY	(1ULL << 0)
+/**
+ * The evtrees of the pool may have EVT_FEAT_CSUM, which stores the per-chunk
+ * checksums of an extent with its descriptor.
+ */
+#define VOS_POOL_INCOMPAT_EXT_CSUM	(1ULL << 1)
+/** Incompatible features understood by this version */
+#define VOS_POOL_INCOMPAT_SUPPORTED	(VOS_POOL_INCOMPAT_KEY_ARRAY |	\
+					 VOS_POOL_INCOMPAT_EXT_CSUM)
+
 /**
  * VOS Pool root object
  */
@@ -105,6 +144,10 @@ struct vos_pool_df {
 	uint32_t				pd_magic;
 	/* Unique PoolID for each VOS pool assigned on creation */
 	uuid_t					pd_id;
+	/* Layout version, see VOS_POOL_DF_VERSION. It was padding before
+	 * the version was introduced, zero for pools of version 0.
+	 */
+	uint32_t				pd_version;
 	/* Flags for compatibility features */
 	uint64_t				pd_compat_flags;
 	/* Flags for incompatibility features */
@@ -112,7 +155,7 @@ struct vos_pool_df {
 	/* Typed PMEMoid pointer for the container index table */
 	struct vos_cont_table_df		pd_ctab_df;
 	/* Pool info of objects, containers, space availability */
-	vos_pool_info_t				pd_pool_info;
+	struct vos_pool_info_df			pd_pool_info;
 	/* Free space tracking for NVMe device */
 	struct vea_space_df			pd_vea_df;
 };
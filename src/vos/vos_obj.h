@@ -34,11 +34,11 @@
 #define __VOS_OBJ_H__
 
 #include <daos/btree.h>
-#include <daos/lru.h>
 #include "vos_layout.h"
 
 #define OT_BTREE_ORDER 20
-#define LRU_CACHE_BITS 16
+/** default object cache size in bits, see env VOS_OBJ_CACHE_BITS */
+#define OBJ_CACHE_BITS 16
 
 /**
  * Reference of a cached object.
@@ -49,6 +49,37 @@ struct vos_object;
 /* Internal container handle structure */
 struct vos_container;
 
+struct vos_obj_cache_stats {
+	/** lookups which found the object in the cache */
+	uint64_t		 ocs_hits;
+	/** lookups which had to load the object */
+	uint64_t		 ocs_misses;
+	/** idle objects reclaimed by the CLOCK hand */
+	uint64_t		 ocs_evictions;
+};
+
+/**
+ * Object cache, it is owned by one xstream so it takes no lock.
+ *
+ * Objects are indexed by an open-addressed hash table with linear probing,
+ * the slot array is twice the cache size so probe sequences are short.
+ * The CLOCK hand sweeps the same slot array to find an idle object which
+ * has not been accessed since the last sweep.
+ */
+struct vos_obj_cache {
+	/** hash slots, NULL for empty slot */
+	struct vos_object	**occ_slots;
+	/** number of slots - 1, number of slots is power of 2 */
+	uint32_t		  occ_mask;
+	/** maximum number of cached objects */
+	uint32_t		  occ_size;
+	/** number of cached objects, including the busy ones */
+	uint32_t		  occ_nr;
+	/** slot index of the CLOCK hand */
+	uint32_t		  occ_hand;
+	struct vos_obj_cache_stats occ_stats;
+};
+
 /**
  * Find an object in the cache \a occ and take its reference. If the object is
  * not in cache, this function will load it from PMEM pool or create it, then
@@ -62,7 +93,7 @@ struct vos_container;
  * \param obj_p [OUT]	Returned object cache reference.
  */
 int
-vos_obj_hold(struct daos_lru_cache *occ, daos_handle_t coh,
+vos_obj_hold(struct vos_obj_cache *occ, daos_handle_t coh,
 	     daos_unit_oid_t oid, daos_epoch_t epoch,
 	     bool no_create, struct vos_object **obj_p);
 
@@ -72,13 +103,13 @@ vos_obj_hold(struct daos_lru_cache *occ, daos_handle_t coh,
  * \param obj	[IN]	Reference to be released.
  */
 void
-vos_obj_release(struct daos_lru_cache *occ, struct vos_object *obj);
+vos_obj_release(struct vos_obj_cache *occ, struct vos_object *obj);
 
 /**
  * Varify if the object reference is still valid, and refresh it if it's
  * invalide (evicted)
  */
-int vos_obj_revalidate(struct daos_lru_cache *occ, daos_epoch_t epoch,
+int vos_obj_revalidate(struct vos_obj_cache *occ, daos_epoch_t epoch,
 		       struct vos_object **obj_p);
 
 /** Evict an object reference from the cache */
@@ -90,11 +121,11 @@ bool vos_obj_evicted(struct vos_object *obj);
 /**
  * Create an object cache.
  *
- * \param cache_size	[IN]	Cache size
+ * \param cache_size	[IN]	Cache size in bits, i.e. 2^cache_size objects
  * \param occ_p		[OUT]	Newly created cache.
  */
 int
-vos_obj_cache_create(int32_t cache_size, struct daos_lru_cache **occ_p);
+vos_obj_cache_create(int32_t cache_size, struct vos_obj_cache **occ_p);
 
 /**
  * Destroy an object cache, and release all cached object references.
@@ -102,16 +133,16 @@ vos_obj_cache_create(int32_t cache_size, struct daos_lru_cache **occ_p);
  * \param occ	[IN]	Cache to be destroyed.
  */
 void
-vos_obj_cache_destroy(struct daos_lru_cache *occ);
+vos_obj_cache_destroy(struct vos_obj_cache *occ);
 
 /** evict cached objects for the specified container */
-void vos_obj_cache_evict(struct daos_lru_cache *occ,
+void vos_obj_cache_evict(struct vos_obj_cache *occ,
 			 struct vos_container *cont);
 
 /**
  * Return object cache for the current thread.
  */
-struct daos_lru_cache *vos_obj_cache_current(void);
+struct vos_obj_cache *vos_obj_cache_current(void);
 
 /**
  * Object Index API and handles
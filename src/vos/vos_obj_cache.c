@@ -23,14 +23,19 @@
 /**
  * Object cache for VOS OI table.
  * Object index is in Persistent memory. This cache in DRAM
- * maintains an LRU which is accessible in the I/O path. The object
- * index API defined for PMEM are used here by the cache..
+ * maintains the recently used objects which are accessible in the I/O path.
+ * The object index API defined for PMEM are used here by the cache.
  *
- * LRU cache implementation:
- * Simple LRU based object cache for Object index table
- * Uses a hashtable and a doubly linked list to set and get
- * entries. The size of both hashtable and linked list are
- * fixed length.
+ * Cache implementation:
+ * Objects are indexed by an open-addressed hash table keyed on the container
+ * and the object ID, collisions are resolved by linear probing and removal
+ * shifts the following entries backward, so there is no tombstone. The
+ * cache is per-xstream and takes no lock.
+ *
+ * Eviction uses the CLOCK algorithm: vos_obj_hold() sets the reference bit
+ * of an object, the clock hand sweeps the slot array when the cache is full,
+ * it clears the reference bit of the idle objects it passes and reclaims
+ * the first idle object whose bit is already clear.
  *
  * Author: Vishwanath Venkatesan <vishwanath.venkatesan@intel.com>
  */
@@ -43,74 +48,73 @@
 #include <vos_internal.h>
 #include <daos_errno.h>
 
-/**
- * Local type for VOS LRU key
- * VOS LRU key must consist of
- * Object ID and container UUID
- */
-struct obj_lru_key {
-	/* container the object belongs to */
-	struct vos_container	*olk_cont;
-	/* Object ID */
-	daos_unit_oid_t		 olk_oid;
-};
-
-static int
-obj_lop_alloc(void *key, unsigned int ksize, void *args,
-	      struct daos_llink **llink_p)
+static uint64_t
+obj_cache_hash(struct vos_container *cont, daos_unit_oid_t *oid)
 {
-	struct vos_object	*obj;
-	struct obj_lru_key	*lkey;
-	struct vos_container	*cont;
-	int			 rc;
-
-	cont = (struct vos_container *)args;
-	D_ASSERT(cont != NULL);
-
-	lkey = (struct obj_lru_key *)key;
-	D_ASSERT(lkey != NULL);
-
-	D_DEBUG(DB_TRACE, "cont="DF_UUID", obj="DF_UOID"\n",
-		DP_UUID(cont->vc_id), DP_UOID(lkey->olk_oid));
-
-	D_ALLOC_PTR(obj);
-	if (!obj)
-		D_GOTO(failed, rc = -DER_NOMEM);
-	/**
-	 * Saving a copy of oid to avoid looking up in vos_obj_df, which
-	 * is a direct pointer to pmem data structure
-	 */
-	obj->obj_id	= lkey->olk_oid;
-	obj->obj_cont	= cont;
-	vos_cont_addref(cont);
-
-	*llink_p = &obj->obj_llink;
-	rc = 0;
-failed:
-	return rc;
+	uint64_t	h;
+
+	h = oid->id_pub.lo * 0x9e3779b97f4a7c15ULL;
+	h ^= oid->id_pub.hi + 0x632be59bd9b4e019ULL + (h << 6) + (h >> 2);
+	h ^= ((uint64_t)oid->id_shard << 32) ^ (uintptr_t)cont;
+	/* finalizer of murmur3 */
+	h ^= h >> 33;
+	h *= 0xff51afd7ed558ccdULL;
+	h ^= h >> 33;
+	h *= 0xc4ceb9fe1a85ec53ULL;
+	h ^= h >> 33;
+	return h;
 }
 
-static bool
-obj_lop_cmp_key(const void *key, unsigned int ksize, struct daos_llink *llink)
+/** Return the slot index of \a obj */
+static uint32_t
+obj_cache_slot(struct vos_obj_cache *occ, struct vos_object *obj)
 {
-	struct vos_object	*obj;
-	struct obj_lru_key	*lkey = (struct obj_lru_key *)key;
-
-	D_ASSERT(ksize == sizeof(struct obj_lru_key));
+	uint32_t	idx = obj->obj_hash & occ->occ_mask;
 
-	obj = container_of(llink, struct vos_object, obj_llink);
-	return lkey->olk_cont == obj->obj_cont &&
-	       !memcmp(&lkey->olk_oid, &obj->obj_id, sizeof(obj->obj_id));
+	while (occ->occ_slots[idx] != obj) {
+		D_ASSERT(occ->occ_slots[idx] != NULL);
+		idx = (idx + 1) & occ->occ_mask;
+	}
+	return idx;
 }
 
+/**
+ * Remove the object in slot \a idx from the hash table and free it. The
+ * entries after it are shifted backward if the removed slot is on their
+ * probe sequence.
+ */
 static void
-obj_lop_free(struct daos_llink *llink)
+obj_cache_remove(struct vos_obj_cache *occ, uint32_t idx)
 {
-	struct vos_object	*obj;
+	struct vos_object	*obj = occ->occ_slots[idx];
+	uint32_t		 next = idx;
+	uint32_t		 home;
+
+	D_ASSERT(obj != NULL && obj->obj_ref == 0);
+	occ->occ_slots[idx] = NULL;
+	occ->occ_nr--;
+
+	while (1) {
+		struct vos_object *tmp;
+
+		next = (next + 1) & occ->occ_mask;
+		tmp = occ->occ_slots[next];
+		if (tmp == NULL)
+			break;
+
+		home = tmp->obj_hash & occ->occ_mask;
+		/* stay if the home slot is cyclically in (idx, next] */
+		if (idx <= next ? (idx < home && home <= next) :
+				  (idx < home || home <= next))
+			continue;
 
-	D_DEBUG(DB_TRACE, "lru free callback for vos_obj_cache\n");
+		occ->occ_slots[idx] = tmp;
+		occ->occ_slots[next] = NULL;
+		idx = next;
+	}
 
-	obj = container_of(llink, struct vos_object, obj_llink);
+	D_DEBUG(DB_TRACE, "free obj "DF_UOID" from vos_obj_cache\n",
+		DP_UOID(obj->obj_id));
 	if (obj->obj_cont != NULL)
 		vos_cont_decref(obj->obj_cont);
 
@@ -118,90 +122,191 @@ obj_lop_free(struct daos_llink *llink)
 	D_FREE(obj);
 }
 
+/**
+ * Advance the CLOCK hand until it reclaims an idle object, give up after
+ * two rounds if all objects are busy.
+ */
 static void
-obj_lop_print_key(void *key, unsigned int ksize)
+obj_cache_clock_evict(struct vos_obj_cache *occ)
 {
-	struct obj_lru_key	*lkey = (struct obj_lru_key *)key;
-	struct vos_container	*cont = lkey->olk_cont;
-
-	D_DEBUG(DB_TRACE, "pool="DF_UUID" cont="DF_UUID", obj="DF_UOID"\n",
-		DP_UUID(cont->vc_pool->vp_id),
-		DP_UUID(cont->vc_id), DP_UOID(lkey->olk_oid));
+	struct vos_object	*obj;
+	uint32_t		 i;
+
+	for (i = 0; i <= 2 * occ->occ_mask; i++) {
+		obj = occ->occ_slots[occ->occ_hand];
+		if (obj != NULL && obj->obj_ref == 0) {
+			if (!obj->obj_clock) {
+				/* the next entry is shifted to the hand */
+				obj_cache_remove(occ, occ->occ_hand);
+				occ->occ_stats.ocs_evictions++;
+				return;
+			}
+			obj->obj_clock = 0;
+		}
+		occ->occ_hand = (occ->occ_hand + 1) & occ->occ_mask;
+	}
+	D_DEBUG(DB_TRACE, "All %u cached objects are busy\n", occ->occ_nr);
 }
 
-static struct daos_llink_ops obj_lru_ops = {
-	.lop_free_ref	=  obj_lop_free,
-	.lop_alloc_ref	=  obj_lop_alloc,
-	.lop_cmp_keys	=  obj_lop_cmp_key,
-	.lop_print_key	=  obj_lop_print_key,
-};
+/**
+ * Find the object of \a cont and \a oid in the cache, or add a new one.
+ */
+static int
+obj_cache_lookup(struct vos_obj_cache *occ, struct vos_container *cont,
+		 daos_unit_oid_t oid, struct vos_object **obj_p)
+{
+	struct vos_object	*obj;
+	uint64_t		 hash = obj_cache_hash(cont, &oid);
+	uint32_t		 idx = hash & occ->occ_mask;
+
+	while ((obj = occ->occ_slots[idx]) != NULL) {
+		if (obj->obj_hash == hash && !obj->obj_evicted &&
+		    obj->obj_cont == cont &&
+		    !memcmp(&obj->obj_id, &oid, sizeof(oid))) {
+			occ->occ_stats.ocs_hits++;
+			goto found;
+		}
+		idx = (idx + 1) & occ->occ_mask;
+	}
+
+	occ->occ_stats.ocs_misses++;
+	if (occ->occ_nr >= occ->occ_size) {
+		obj_cache_clock_evict(occ);
+		/* eviction shifts entries, find the empty slot again */
+		idx = hash & occ->occ_mask;
+		while (occ->occ_slots[idx] != NULL)
+			idx = (idx + 1) & occ->occ_mask;
+	}
+
+	/* keep at least one empty slot to terminate the probing */
+	if (occ->occ_nr >= occ->occ_mask) {
+		D_ERROR("Object cache is full of busy objects: %u\n",
+			occ->occ_nr);
+		return -DER_NOMEM;
+	}
+
+	D_DEBUG(DB_TRACE, "cont="DF_UUID", obj="DF_UOID"\n",
+		DP_UUID(cont->vc_id), DP_UOID(oid));
+
+	D_ALLOC_PTR(obj);
+	if (obj == NULL)
+		return -DER_NOMEM;
+	/**
+	 * Saving a copy of oid to avoid looking up in vos_obj_df, which
+	 * is a direct pointer to pmem data structure
+	 */
+	obj->obj_id	= oid;
+	obj->obj_cont	= cont;
+	obj->obj_hash	= hash;
+	vos_cont_addref(cont);
+
+	occ->occ_slots[idx] = obj;
+	occ->occ_nr++;
+found:
+	obj->obj_ref++;
+	obj->obj_clock = 1;
+	*obj_p = obj;
+	return 0;
+}
 
 int
-vos_obj_cache_create(int32_t cache_size, struct daos_lru_cache **occ)
+vos_obj_cache_create(int32_t cache_size, struct vos_obj_cache **occ_p)
 {
-	int	rc;
+	struct vos_obj_cache	*occ;
 
 	D_DEBUG(DB_TRACE, "Creating an object cache %d\n", (1 << cache_size));
-	rc = daos_lru_cache_create(cache_size, D_HASH_FT_NOLOCK,
-				   &obj_lru_ops, occ);
-	if (rc)
-		D_ERROR("Error in creating lru cache: %d\n", rc);
-	return rc;
+	D_ASSERT(cache_size >= 0 && cache_size < 31);
+
+	D_ALLOC_PTR(occ);
+	if (occ == NULL)
+		return -DER_NOMEM;
+
+	occ->occ_size = 1U << cache_size;
+	occ->occ_mask = (occ->occ_size << 1) - 1;
+	D_ALLOC_ARRAY(occ->occ_slots, occ->occ_mask + 1);
+	if (occ->occ_slots == NULL) {
+		D_ERROR("Error in creating object cache\n");
+		D_FREE(occ);
+		return -DER_NOMEM;
+	}
+
+	*occ_p = occ;
+	return 0;
 }
 
 void
-vos_obj_cache_destroy(struct daos_lru_cache *occ)
+vos_obj_cache_destroy(struct vos_obj_cache *occ)
 {
 	D_ASSERT(occ != NULL);
-	daos_lru_cache_destroy(occ);
-}
-
-static bool
-obj_cache_evict_cond(struct daos_llink *llink, void *args)
-{
-	struct vos_container	*cont = (struct vos_container *)args;
-	struct vos_object	*obj;
 
-	if (cont == NULL)
-		return true;
+	vos_obj_cache_evict(occ, NULL);
+	D_ASSERTF(occ->occ_nr == 0, "busy=%u\n", occ->occ_nr);
 
-	obj = container_of(llink, struct vos_object, obj_llink);
-	return obj->obj_cont == cont;
+	D_DEBUG(DB_TRACE, "object cache hits "DF_U64", misses "DF_U64
+		", evictions "DF_U64"\n", occ->occ_stats.ocs_hits,
+		occ->occ_stats.ocs_misses, occ->occ_stats.ocs_evictions);
+	D_FREE(occ->occ_slots);
+	D_FREE(occ);
 }
 
+/**
+ * Evict cached objects of \a cont, or all objects if \a cont is NULL. Busy
+ * objects are freed on their last release.
+ */
 void
-vos_obj_cache_evict(struct daos_lru_cache *cache, struct vos_container *cont)
+vos_obj_cache_evict(struct vos_obj_cache *occ, struct vos_container *cont)
 {
-	daos_lru_cache_evict(cache, obj_cache_evict_cond, cont);
+	struct vos_object	*obj;
+	uint32_t		 idx = 0;
+
+	while (idx <= occ->occ_mask) {
+		obj = occ->occ_slots[idx];
+		if (obj == NULL || (cont != NULL && obj->obj_cont != cont)) {
+			idx++;
+			continue;
+		}
+
+		if (obj->obj_ref != 0) {
+			/* will be evicted later in vos_obj_release */
+			vos_obj_evict(obj);
+			idx++;
+			continue;
+		}
+		/* the next entry may be shifted to this slot */
+		obj_cache_remove(occ, idx);
+	}
 }
 
 /**
  * Return object cache for the current thread.
  */
-struct daos_lru_cache *
+struct vos_obj_cache *
 vos_obj_cache_current(void)
 {
 	return vos_get_obj_cache();
 }
 
 void
-vos_obj_release(struct daos_lru_cache *occ, struct vos_object *obj)
+vos_obj_release(struct vos_obj_cache *occ, struct vos_object *obj)
 {
 
-	D_ASSERT((occ != NULL) && (obj != NULL));
-	daos_lru_ref_release(occ, &obj->obj_llink);
+	D_ASSERT((occ != NULL) && (obj != NULL) && obj->obj_ref > 0);
+	obj->obj_ref--;
+	if (obj->obj_ref == 0 && obj->obj_evicted) {
+		D_DEBUG(DB_TRACE, "Evict %p from object cache\n", obj);
+		obj_cache_remove(occ, obj_cache_slot(occ, obj));
+	}
 }
 
 
 int
-vos_obj_hold(struct daos_lru_cache *occ, daos_handle_t coh,
+vos_obj_hold(struct vos_obj_cache *occ, daos_handle_t coh,
 	     daos_unit_oid_t oid, daos_epoch_t epoch,
 	     bool no_create, struct vos_object **obj_p)
 {
 
 	struct vos_object	*obj;
 	struct vos_container	*cont;
-	struct obj_lru_key	 lkey;
 	int			 rc;
 
 	cont = vos_hdl2cont(coh);
@@ -210,18 +315,11 @@ vos_obj_hold(struct daos_lru_cache *occ, daos_handle_t coh,
 	D_DEBUG(DB_TRACE, "Try to hold cont="DF_UUID", obj="DF_UOID"\n",
 		DP_UUID(cont->vc_id), DP_UOID(oid));
 
-	/* Create the key for obj cache */
-	lkey.olk_cont = cont;
-	lkey.olk_oid = oid;
-
 	while (1) {
-		struct daos_llink *lret;
-
-		rc = daos_lru_ref_hold(occ, &lkey, sizeof(lkey), cont, &lret);
+		rc = obj_cache_lookup(occ, cont, oid, &obj);
 		if (rc)
 			D_GOTO(failed, rc);
 
-		obj = container_of(lret, struct vos_object, obj_llink);
 		if (obj->obj_epoch == 0) /* new cache element */
 			obj->obj_epoch = epoch;
 
@@ -295,17 +393,17 @@ failed:
 void
 vos_obj_evict(struct vos_object *obj)
 {
-	daos_lru_ref_evict(&obj->obj_llink);
+	obj->obj_evicted = 1;
 }
 
 bool
 vos_obj_evicted(struct vos_object *obj)
 {
-	return daos_lru_ref_evicted(&obj->obj_llink);
+	return obj->obj_evicted;
 }
 
 int
-vos_obj_revalidate(struct daos_lru_cache *occ, daos_epoch_t epoch,
+vos_obj_revalidate(struct vos_obj_cache *occ, daos_epoch_t epoch,
 		   struct vos_object **obj_p)
 {
 	struct vos_object *obj = *obj_p;
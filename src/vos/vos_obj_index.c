@@ -28,6 +28,7 @@
  */
 #define D_LOGFAC	DD_FAC(vos)
 
+#include <endian.h>
 #include <daos/common.h>
 #include <daos/btree.h>
 #include <daos/object.h>
@@ -104,6 +105,19 @@ oi_hkey_cmp(struct btr_instance *tins, struct btr_record *rec, void *hkey)
 	return BTR_CMP_EQ;
 }
 
+/**
+ * The first 8 bytes of the object ID, they are loaded in big-endian so the
+ * prefix is ordered as the memcmp of oi_hkey_cmp.
+ */
+static uint64_t
+oi_hkey_prefix(struct btr_instance *tins, void *hkey)
+{
+	uint64_t	prefix;
+
+	memcpy(&prefix, &((struct oi_hkey *)hkey)->oi_oid, sizeof(prefix));
+	return be64toh(prefix);
+}
+
 static int
 oi_rec_alloc(struct btr_instance *tins, daos_iov_t *key_iov,
 	     daos_iov_t *val_iov, struct btr_record *rec)
@@ -197,6 +211,7 @@ static btr_ops_t oi_btr_ops = {
 	.to_hkey_size	= oi_hkey_size,
 	.to_hkey_gen	= oi_hkey_gen,
 	.to_hkey_cmp	= oi_hkey_cmp,
+	.to_hkey_prefix	= oi_hkey_prefix,
 	.to_rec_alloc	= oi_rec_alloc,
 	.to_rec_free	= oi_rec_free,
 	.to_rec_fetch	= oi_rec_fetch,
@@ -633,7 +648,8 @@ vos_obj_tab_register()
 	D_DEBUG(DB_DF, "Registering class for OI table Class: %d\n",
 		VOS_BTR_OBJ_TABLE);
 
-	rc = dbtree_class_register(VOS_BTR_OBJ_TABLE, 0, &oi_btr_ops);
+	rc = dbtree_class_register(VOS_BTR_OBJ_TABLE, BTR_FEAT_KEY_ARRAY,
+				   &oi_btr_ops);
 	if (rc)
 		D_ERROR("dbtree create failed\n");
 	return rc;
@@ -658,7 +674,9 @@ vos_obj_tab_create(struct vos_pool *pool, struct vos_obj_table_df *otab_df)
 		D_DEBUG(DB_DF, "create OI Tree in-place: %d\n",
 			VOS_BTR_OBJ_TABLE);
 
-		rc = dbtree_create_inplace(VOS_BTR_OBJ_TABLE, 0,
+		rc = dbtree_create_inplace(VOS_BTR_OBJ_TABLE,
+					   pool->vp_key_array ?
+					   BTR_FEAT_KEY_ARRAY : 0,
 					   OT_BTREE_ORDER, &pool->vp_uma,
 					   &otab_df->obt_btr, &btr_hdl);
 		if (rc)
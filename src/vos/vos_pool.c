@@ -42,6 +42,7 @@
 #include <unistd.h>
 #include <string.h>
 #include <fcntl.h>
+#include <time.h>
 
 pthread_mutex_t vos_pmemobj_lock = PTHREAD_MUTEX_INITIALIZER;
 /**
@@ -109,6 +110,7 @@ pool_alloc(uuid_t uuid, struct vos_pool **pool_p)
 
 	d_uhash_ulink_init(&pool->vp_hlink, &pool_uuid_hops);
 	uuid_copy(pool->vp_id, uuid);
+	vos_media_policy_init(&pool->vp_policy);
 
 	memset(&uma, 0, sizeof(uma));
 	uma.uma_id = UMEM_CLASS_VMEM;
@@ -269,11 +271,15 @@ vos_pool_create(const char *path, uuid_t uuid, daos_size_t scm_sz,
 		if (rc != 0)
 			pmemobj_tx_abort(EFAULT);
 
+		pool_df->pd_magic = VOS_POOL_MAGIC;
+		pool_df->pd_version = VOS_POOL_DF_VERSION;
+		pool_df->pd_incompat_flags = VOS_POOL_INCOMPAT_KEY_ARRAY |
+					     VOS_POOL_INCOMPAT_EXT_CSUM;
 		uuid_copy(pool_df->pd_id, uuid);
-		pool_df->pd_pool_info.pif_scm_sz  = scm_sz;
-		pool_df->pd_pool_info.pif_blob_sz = blob_sz;
+		pool_df->pd_pool_info.pi_scm_sz  = scm_sz;
+		pool_df->pd_pool_info.pi_blob_sz = blob_sz;
 		/* XXX we don't really maintain the available size */
-		pool_df->pd_pool_info.pif_avail = scm_sz -
+		pool_df->pd_pool_info.pi_avail = scm_sz -
 				pmemobj_root_size(ph);
 		vea_md = &pool_df->pd_vea_df;
 
@@ -433,6 +439,7 @@ vos_pool_open(const char *path, uuid_t uuid, daos_handle_t *poh)
 	struct vos_pool_df	*pool_df;
 	struct vos_pool		*pool;
 	struct umem_attr	*uma;
+	int			 enabled = 1;
 	struct d_uuid		 ukey;
 	int			 rc;
 
@@ -484,6 +491,26 @@ vos_pool_open(const char *path, uuid_t uuid, daos_handle_t *poh)
 		D_GOTO(failed, rc = -DER_IO);
 	}
 
+	/* Pools created before the magic was set are version 0 */
+	if (pool_df->pd_magic == VOS_POOL_MAGIC &&
+	    (pool_df->pd_version > VOS_POOL_DF_VERSION ||
+	     (pool_df->pd_incompat_flags & ~VOS_POOL_INCOMPAT_SUPPORTED))) {
+		D_ERROR("Unsupported pool "DF_UUID", version %u, incompat "
+			"features "DF_X64"\n", DP_UUID(uuid),
+			pool_df->pd_version, pool_df->pd_incompat_flags);
+		D_GOTO(failed, rc = -DER_PROTO);
+	}
+	pool->vp_key_array = pool_df->pd_magic == VOS_POOL_MAGIC &&
+			     (pool_df->pd_incompat_flags &
+			      VOS_POOL_INCOMPAT_KEY_ARRAY);
+	pool->vp_ext_csum = pool_df->pd_magic == VOS_POOL_MAGIC &&
+			    (pool_df->pd_incompat_flags &
+			     VOS_POOL_INCOMPAT_EXT_CSUM);
+
+	/* Heap statistics tell the SCM usage, see vos_pool_scm_usage() */
+	if (pmemobj_ctl_set(uma->uma_pool, "stats.enabled", &enabled) != 0)
+		D_DEBUG(DB_MGMT, "PMDK heap statistics is unavailable\n");
+
 	/* Cache container table btree hdl */
 	rc = dbtree_open_inplace(&pool_df->pd_ctab_df.ctb_btree,
 				 &pool->vp_uma, &pool->vp_cont_th);
@@ -492,7 +519,7 @@ vos_pool_open(const char *path, uuid_t uuid, daos_handle_t *poh)
 		D_GOTO(failed, rc);
 	}
 
-	xs_ctxt = pool_df->pd_pool_info.pif_blob_sz == 0 ?
+	xs_ctxt = pool_df->pd_pool_info.pi_blob_sz == 0 ?
 			NULL : vos_xsctxt_get();
 
 	D_DEBUG(DB_MGMT, "Opening VOS I/O context for xs:%p pool:"DF_UUID"\n",
@@ -557,6 +584,19 @@ vos_pool_close(daos_handle_t poh)
 	return 0;
 }
 
+/** Space allocated from the SCM heap, 0 if PMDK can't tell */
+static daos_size_t
+pool_scm_used(struct vos_pool *pool)
+{
+	uint64_t	allocated = 0;
+
+	if (pmemobj_ctl_get(vos_pool_ptr2pop(pool),
+			    "stats.heap.curr_allocated", &allocated) != 0)
+		return 0;
+
+	return allocated;
+}
+
 /**
  * Query attributes and statistics of the current pool
  */
@@ -572,6 +612,49 @@ vos_pool_query(daos_handle_t poh, vos_pool_info_t *pinfo)
 		return -DER_NONEXIST;
 
 	pool_df = vos_pool_ptr2df(pool);
-	memcpy(pinfo, &pool_df->pd_pool_info, sizeof(pool_df->pd_pool_info));
+	pinfo->pif_cont_nr = pool_df->pd_pool_info.pi_cont_nr;
+	pinfo->pif_scm_sz = pool_df->pd_pool_info.pi_scm_sz;
+	pinfo->pif_blob_sz = pool_df->pd_pool_info.pi_blob_sz;
+	pinfo->pif_avail = pool_df->pd_pool_info.pi_avail;
+
+	pinfo->pif_scm_used = pool_scm_used(pool);
+	pinfo->pif_nvme_used = 0;
+	if (pool->vp_vea_info != NULL) {
+		struct vea_attr	attr;
+		struct vea_stat	stat;
+		int		rc;
+
+		rc = vea_query(pool->vp_vea_info, &attr, &stat);
+		if (rc != 0)
+			return rc;
+
+		pinfo->pif_nvme_used = (attr.va_tot_blks - stat.vs_free_blks) *
+				       attr.va_blk_sz;
+	}
 	return 0;
 }
+
+/** Interval (in seconds) to refresh the cached SCM usage */
+#define VOS_SCM_USAGE_INTV	1
+
+/**
+ * SCM usage of the pool in percentage, it's refreshed at most once per
+ * second since it's checked on each update.
+ */
+unsigned int
+vos_pool_scm_usage(struct vos_pool *pool)
+{
+	struct vos_pool_df	*pool_df;
+	struct timespec		 now;
+
+	clock_gettime(CLOCK_MONOTONIC_COARSE, &now);
+	if (pool->vp_scm_time != 0 &&
+	    now.tv_sec < pool->vp_scm_time + VOS_SCM_USAGE_INTV)
+		return pool->vp_scm_usage;
+
+	pool_df = vos_pool_ptr2df(pool);
+	pool->vp_scm_time = now.tv_sec;
+	pool->vp_scm_usage = pool_df->pd_pool_info.pi_scm_sz == 0 ? 0 :
+		pool_scm_used(pool) * 100 / pool_df->pd_pool_info.pi_scm_sz;
+	return pool->vp_scm_usage;
+}
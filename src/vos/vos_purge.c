@@ -43,6 +43,8 @@ struct purge_context {
 	vos_iter_type_t		 pc_type;
 	/** cookie to discard */
 	uuid_t			 pc_cookie;
+	/** number of objects skipped by discard because they were leased */
+	unsigned int		 pc_leased;
 	/** recursive iterator parameters */
 	vos_iter_param_t	 pc_param;
 };
@@ -448,6 +450,591 @@ recx_max_iter_probe(int opc, vos_iter_entry_t *ent, vos_iter_entry_t *ent_max,
 	return rc;
 }
 
+/** Max size of an extent created by coalescing the small extents */
+#define VOS_AGG_MERGE_MAX	(1UL << 20)
+/** Max number of extents coalesced into one extent */
+#define VOS_AGG_MERGE_NR	128
+
+/**
+ * An extent can be coalesced if it has data, it's fully visible at the
+ * upper bound of the aggregation range, and it's updated within the range.
+ */
+static bool
+recx_is_mergeable(struct evt_entry *ent, daos_epoch_range_t *epr,
+		  uint32_t inob)
+{
+	if (bio_addr_is_hole(&ent->en_addr))
+		return false;
+
+	if (ent->en_epoch < epr->epr_lo)
+		return false;
+
+	if (ent->en_ext.ex_lo != ent->en_sel_ext.ex_lo ||
+	    ent->en_ext.ex_hi != ent->en_sel_ext.ex_hi)
+		return false;
+
+	return evt_extent_width(&ent->en_ext) * inob < VOS_AGG_MERGE_MAX;
+}
+
+/** Free the data block referenced by a deleted extent */
+int
+recx_data_free(struct vos_object *obj, struct evt_entry *ent, uint32_t inob)
+{
+	struct umem_instance	*umm = vos_obj2umm(obj);
+	struct vea_space_info	*vsi = obj->obj_cont->vc_pool->vp_vea_info;
+	bio_addr_t		*addr = &ent->en_addr;
+	umem_id_t		 mmid;
+	daos_size_t		 size;
+
+	if (addr->ba_type == BIO_ADDR_SCM) {
+		mmid.pool_uuid_lo = umem_get_uuid(umm);
+		mmid.off = addr->ba_off;
+		return umem_free(umm, mmid);
+	}
+
+	D_ASSERT(addr->ba_type == BIO_ADDR_NVME);
+	D_ASSERT(vsi != NULL);
+	size = evt_extent_width(&ent->en_ext) * inob;
+	/* NB: freed blocks are aged by VEA before being reused, so in-flight
+	 * fetches of the old extents are still safe.
+	 */
+	return vos_blk_free(vsi, addr, size);
+}
+
+/**
+ * Copy the data of extents \a run to the newly reserved extent \a dst, the
+ * per-chunk checksums of the new extent are computed if \a csum isn't NULL.
+ */
+static int
+recx_merge_copy(struct vos_object *obj, struct evt_entry **run, int nr,
+		uint32_t inob, bio_addr_t *dst_addr, daos_size_t size,
+		daos_csum_buf_t *csum)
+{
+	struct bio_io_context	*bioc = obj->obj_cont->vc_pool->vp_io_ctxt;
+	struct bio_desc		*src;
+	struct bio_desc		*dst;
+	struct bio_sglist	*bsgl;
+	daos_sg_list_t		 sgl;
+	int			 i;
+	int			 rc;
+
+	src = bio_iod_alloc(bioc, 1, false);
+	if (src == NULL)
+		return -DER_NOMEM;
+
+	dst = bio_iod_alloc(bioc, 1, true);
+	if (dst == NULL)
+		D_GOTO(free_src, rc = -DER_NOMEM);
+
+	bsgl = bio_iod_sgl(src, 0);
+	rc = bio_sgl_init(bsgl, nr);
+	if (rc != 0)
+		D_GOTO(free_dst, rc);
+
+	for (i = 0; i < nr; i++) {
+		bsgl->bs_iovs[i].bi_addr = run[i]->en_addr;
+		bsgl->bs_iovs[i].bi_data_len =
+			evt_extent_width(&run[i]->en_ext) * inob;
+	}
+	bsgl->bs_nr_out = nr;
+
+	bsgl = bio_iod_sgl(dst, 0);
+	rc = bio_sgl_init(bsgl, 1);
+	if (rc != 0)
+		D_GOTO(free_dst, rc);
+
+	bsgl->bs_iovs[0].bi_addr = *dst_addr;
+	bsgl->bs_iovs[0].bi_data_len = size;
+	bsgl->bs_nr_out = 1;
+
+	/* read the small extents */
+	rc = bio_iod_prep(src);
+	if (rc != 0) {
+		D_ERROR("Failed to read extents for merge: %d\n", rc);
+		D_GOTO(free_dst, rc);
+	}
+
+	rc = bio_sgl_convert(bio_iod_sgl(src, 0), &sgl);
+	if (rc != 0)
+		D_GOTO(post_src, rc);
+
+	if (csum != NULL) {
+		rc = vos_csum_compute_chunks(&sgl, size, csum);
+		if (rc != 0)
+			D_GOTO(free_sgl, rc);
+	}
+
+	rc = bio_iod_prep(dst);
+	if (rc != 0) {
+		D_ERROR("Failed to map merged extent: %d\n", rc);
+		D_GOTO(free_sgl, rc);
+	}
+
+	rc = bio_iod_copy(dst, &sgl, 1);
+	if (rc != 0)
+		D_ERROR("Failed to copy extents for merge: %d\n", rc);
+
+	/* write the merged extent */
+	i = bio_iod_post(dst);
+	if (rc == 0)
+		rc = i;
+free_sgl:
+	daos_sgl_fini(&sgl, false);
+post_src:
+	bio_iod_post(src);
+free_dst:
+	bio_iod_free(dst);
+free_src:
+	bio_iod_free(src);
+	return rc;
+}
+
+/**
+ * Fetch at most \a max extents updated within \a epr which are covered at
+ * its upper bound, the fragments of partially covered extents are included
+ * if \a partial is true.
+ *
+ * \return	number of fetched extents, or negative error code
+ */
+static int
+recx_covered_fetch(daos_handle_t toh, daos_epoch_range_t *epr, bool partial,
+		   struct evt_entry *ents, int max, uint32_t *inob)
+{
+	struct evt_filter	filter;
+	daos_handle_t		ih;
+	int			nr = 0;
+	int			rc;
+
+	/* NB: extents out of the range neither are fetched nor cover others */
+	filter.fr_ex.ex_lo = 0;
+	filter.fr_ex.ex_hi = ~(0ULL);
+	filter.fr_epr = *epr;
+	rc = evt_iter_prepare(toh, EVT_ITER_COVERED, &filter, &ih);
+	if (rc != 0)
+		return rc;
+
+	rc = evt_iter_probe(ih, EVT_ITER_FIRST, NULL, NULL);
+	while (rc == 0 && nr < max) {
+		rc = evt_iter_fetch(ih, inob, &ents[nr], NULL);
+		if (rc != 0)
+			break;
+
+		if (partial || ents[nr].en_visibility == EVT_COVERED)
+			nr++;
+		rc = evt_iter_next(ih);
+	}
+	evt_iter_finish(ih);
+
+	if (rc != 0 && rc != -DER_NONEXIST)
+		return rc;
+	return nr;
+}
+
+/**
+ * Check if any of the covered extents \a cov intersects with the extent
+ * \a ex, which then can't be merged.
+ */
+static bool
+recx_covered_intersect(struct evt_entry *cov, int cov_nr,
+		       struct evt_extent *ex)
+{
+	int	i;
+
+	for (i = 0; i < cov_nr; i++) {
+		if (cov[i].en_ext.ex_lo <= ex->ex_hi &&
+		    cov[i].en_ext.ex_hi >= ex->ex_lo)
+			return true;
+	}
+	return false;
+}
+
+/**
+ * Replace the extents \a run with one extent which covers all of them. The
+ * new extent carries the cookie and version of the newest one, and the upper
+ * bound of the aggregation range as epoch, like any result of aggregation,
+ * see vos_epoch_aggregate(). The aggregated epochs can't be fetched anymore,
+ * a fetch within the range sees the data from before the range instead.
+ *
+ * The data is copied to NVMe if the pool has NVMe, otherwise to SCM.
+ */
+static int
+recx_merge_run(struct purge_context *pcx, daos_key_t *akey,
+	       struct evt_entry **run, int nr, uint32_t inob)
+{
+	struct vos_object	*obj = pcx->pc_obj;
+	struct vos_container	*cont = obj->obj_cont;
+	struct vea_space_info	*vsi = cont->vc_pool->vp_vea_info;
+	struct umem_instance	*umm = vos_obj2umm(obj);
+	daos_epoch_range_t	*epr = &pcx->pc_param.ip_epr;
+	struct vea_resrvd_ext	*ext;
+	struct evt_entry_in	 ent_in;
+	struct evt_entry	*cov;
+	daos_csum_buf_t		*csum = NULL;
+	struct evt_rect		 rect;
+	struct pobj_action	 act;
+	umem_id_t		 mmid;
+	daos_handle_t		 dk_toh;
+	daos_handle_t		 ak_toh;
+	daos_epoch_t		 epoch = 0;
+	daos_size_t		 size;
+	d_list_t		 blk_exts;
+	uint32_t		 blk_cnt;
+	uint32_t		 cov_inob;
+	int			 cov_nr;
+	int			 i;
+	int			 rc;
+
+	memset(&ent_in, 0, sizeof(ent_in));
+	ent_in.ei_rect.rc_ex.ex_lo = run[0]->en_ext.ex_lo;
+	ent_in.ei_rect.rc_ex.ex_hi = run[nr - 1]->en_ext.ex_hi;
+	ent_in.ei_rect.rc_epc = epr->epr_hi;
+	ent_in.ei_inob = inob;
+	for (i = 0; i < nr; i++) {
+		D_ASSERT(run[i]->en_epoch >= epr->epr_lo &&
+			 run[i]->en_epoch <= epr->epr_hi);
+		ent_in.ei_ver = max(ent_in.ei_ver, run[i]->en_ver);
+		if (run[i]->en_epoch < epoch)
+			continue;
+		epoch = run[i]->en_epoch;
+		uuid_copy(ent_in.ei_cookie, run[i]->en_cookie);
+	}
+	size = evt_rect_width(&ent_in.ei_rect) * inob;
+
+	/* The chunks of the pieces don't line up with the merged extent, it
+	 * has its own checksums if any piece has.
+	 */
+	for (i = 0; i < nr; i++) {
+		if (run[i]->en_chunk_csum.cs_len != 0 && vos_csum_enabled()) {
+			csum = &ent_in.ei_chunk_csum;
+			ent_in.ei_chunk_size = DAOS_CSUM_CHUNK_SIZE;
+			break;
+		}
+	}
+
+	D_ALLOC_ARRAY(cov, VOS_AGG_MERGE_NR);
+	if (cov == NULL)
+		return -DER_NOMEM;
+
+	D_INIT_LIST_HEAD(&blk_exts);
+	if (vsi != NULL) {
+		blk_cnt = vos_byte2blkcnt(size);
+		rc = vea_reserve(vsi, blk_cnt, cont->vc_hint_ctxt, &blk_exts);
+		if (rc != 0)
+			D_GOTO(free_cov, rc);
+
+		ext = d_list_entry(blk_exts.prev, struct vea_resrvd_ext,
+				   vre_link);
+		D_ASSERT(ext->vre_blk_cnt == blk_cnt);
+		bio_addr_set(&ent_in.ei_addr, BIO_ADDR_NVME,
+			     ext->vre_blk_off << VOS_BLK_SHIFT);
+	} else {
+		mmid = umem_reserve(umm, &act, size);
+		if (UMMID_IS_NULL(mmid))
+			D_GOTO(free_cov, rc = -DER_NOSPACE);
+
+		bio_addr_set(&ent_in.ei_addr, BIO_ADDR_SCM, mmid.off);
+	}
+
+	/* NB: this yields for NVMe I/O */
+	rc = recx_merge_copy(obj, run, nr, inob, &ent_in.ei_addr, size, csum);
+	if (rc != 0)
+		goto cancel;
+
+	/* A fetch may have got the old extents while yielding, keep them */
+	if (vos_obj_leased(cont, obj->obj_id)) {
+		rc = -DER_BUSY;
+		goto cancel;
+	}
+
+	/* The trees might have been changed while yielding, open them again */
+	rc = obj_tree_init(obj);
+	if (rc != 0)
+		goto cancel;
+
+	rc = key_tree_prepare(obj, epr->epr_hi, obj->obj_toh, VOS_BTR_DKEY,
+			      &pcx->pc_param.ip_dkey, 0, NULL, &dk_toh);
+	if (rc != 0)
+		goto cancel;
+
+	rc = key_tree_prepare(obj, epr->epr_hi, dk_toh, VOS_BTR_AKEY, akey,
+			      SUBTR_EVT, NULL, &ak_toh);
+	if (rc != 0)
+		goto release_dkey;
+
+	/* an update within the range may overlap with the run now */
+	cov_nr = recx_covered_fetch(ak_toh, epr, true, cov, VOS_AGG_MERGE_NR,
+				    &cov_inob);
+	if (cov_nr < 0)
+		D_GOTO(release_akey, rc = cov_nr);
+
+	if (cov_nr == VOS_AGG_MERGE_NR ||
+	    recx_covered_intersect(cov, cov_nr, &ent_in.ei_rect.rc_ex))
+		D_GOTO(release_akey, rc = -DER_BUSY);
+
+	rc = umem_tx_begin(umm, vos_txd_get());
+	if (rc != 0)
+		goto release_akey;
+
+	for (i = 0; i < nr; i++) {
+		rect.rc_ex = run[i]->en_ext;
+		rect.rc_epc = run[i]->en_epoch;
+		rc = evt_delete(ak_toh, &rect, NULL);
+		if (rc != 0) {
+			D_ERROR("Failed to delete "DF_RECT": %d\n",
+				DP_RECT(&rect), rc);
+			goto abort;
+		}
+
+		rc = recx_data_free(obj, run[i], inob);
+		if (rc != 0)
+			goto abort;
+	}
+
+	rc = evt_insert(ak_toh, &ent_in);
+	if (rc != 0) {
+		D_ERROR("Failed to insert merged "DF_RECT": %d\n",
+			DP_RECT(&ent_in.ei_rect), rc);
+		goto abort;
+	}
+
+	if (vsi != NULL)
+		rc = vea_tx_publish(vsi, cont->vc_hint_ctxt, &blk_exts);
+	else
+		rc = umem_tx_publish(umm, &act, 1);
+abort:
+	rc = rc ? umem_tx_abort(umm, rc) : umem_tx_commit(umm);
+release_akey:
+	key_tree_release(ak_toh, true);
+release_dkey:
+	key_tree_release(dk_toh, false);
+cancel:
+	if (rc == 0)
+		D_DEBUG(DB_EPC, "Merged %d extents into "DF_RECT"\n",
+			nr, DP_RECT(&ent_in.ei_rect));
+	else if (vsi != NULL)
+		vea_cancel(vsi, cont->vc_hint_ctxt, &blk_exts);
+	else
+		umem_cancel(umm, &act, 1);
+free_cov:
+	D_FREE(cov);
+	D_FREE(ent_in.ei_chunk_csum.cs_csum);
+	return rc;
+}
+
+/**
+ * Remove the extents which are updated within the aggregation range and are
+ * fully covered by the newer extents at its upper bound, no fetch out of the
+ * range can see them. It also works without NVMe, it's what reduces the depth
+ * and overlap of an evtree which has been overwritten many times.
+ *
+ * At most VOS_AGG_MERGE_NR extents are removed per call, credits are used up
+ * if there could be more, so the caller will come back from the anchor.
+ */
+static int
+recx_covered_aggregate(struct purge_context *pcx, daos_key_t *akey,
+		       unsigned int *credits_ret, vos_purge_anchor_t *vp_anchor)
+{
+	struct vos_object	*obj = pcx->pc_obj;
+	struct umem_instance	*umm = vos_obj2umm(obj);
+	struct evt_entry	*ents;
+	struct evt_rect		 rect;
+	daos_handle_t		 dk_toh;
+	daos_handle_t		 ak_toh;
+	daos_size_t		 size = 0;
+	uint32_t		 inob = 0;
+	int			 nr;
+	int			 i;
+	int			 rc;
+
+	/* A fetch may be reading the covered extents, come back later */
+	if (vos_obj_leased(obj->obj_cont, obj->obj_id))
+		return 0;
+
+	rc = obj_tree_init(obj);
+	if (rc != 0)
+		return rc;
+
+	rc = key_tree_prepare(obj, pcx->pc_param.ip_epr.epr_hi, obj->obj_toh,
+			      VOS_BTR_DKEY, &pcx->pc_param.ip_dkey, 0, NULL,
+			      &dk_toh);
+	if (rc != 0)
+		return rc == -DER_NONEXIST ? 0 : rc;
+
+	rc = key_tree_prepare(obj, pcx->pc_param.ip_epr.epr_hi, dk_toh,
+			      VOS_BTR_AKEY, akey, SUBTR_EVT, NULL, &ak_toh);
+	if (rc != 0) {
+		key_tree_release(dk_toh, false);
+		return rc == -DER_NONEXIST ? 0 : rc;
+	}
+
+	D_ALLOC_ARRAY(ents, VOS_AGG_MERGE_NR);
+	if (ents == NULL)
+		D_GOTO(release, rc = -DER_NOMEM);
+
+	nr = recx_covered_fetch(ak_toh, &pcx->pc_param.ip_epr, false, ents,
+				VOS_AGG_MERGE_NR, &inob);
+	if (nr <= 0)
+		D_GOTO(free_ents, rc = nr);
+
+	rc = umem_tx_begin(umm, vos_txd_get());
+	if (rc != 0)
+		D_GOTO(free_ents, rc);
+
+	for (i = 0; i < nr; i++) {
+		rect.rc_ex = ents[i].en_ext;
+		rect.rc_epc = ents[i].en_epoch;
+		rc = evt_delete(ak_toh, &rect, NULL);
+		if (rc != 0) {
+			D_ERROR("Failed to delete covered "DF_RECT": %d\n",
+				DP_RECT(&rect), rc);
+			break;
+		}
+
+		if (bio_addr_is_hole(&ents[i].en_addr))
+			continue;
+
+		rc = recx_data_free(obj, &ents[i], inob);
+		if (rc != 0)
+			break;
+		size += evt_extent_width(&ents[i].en_ext) * inob;
+	}
+	rc = rc ? umem_tx_abort(umm, rc) : umem_tx_commit(umm);
+	if (rc != 0)
+		D_GOTO(free_ents, rc);
+
+	D_DEBUG(DB_EPC, "Removed %d covered extents\n", nr);
+	vp_anchor->pa_nr_removed += nr;
+	vp_anchor->pa_size_removed += size;
+	if (nr == VOS_AGG_MERGE_NR)
+		*credits_ret = 0;
+free_ents:
+	D_FREE(ents);
+release:
+	key_tree_release(ak_toh, true);
+	key_tree_release(dk_toh, false);
+	return rc;
+}
+
+/**
+ * Coalesce the adjacent visible extents of an akey into large extents, so
+ * a fragmented array can be fetched with a few sequential reads.
+ *
+ * An extent which intersects with an extent covered within the range can't
+ * be merged, because the merged extent takes the lower bound of the range as
+ * epoch (see recx_merge_run()), the covered extent would show through it.
+ * Because the trees may change while yielding for the data copy, at most one
+ * group of extents is merged per call, and credits are used up when it's
+ * done, the caller will come back from the anchor.
+ */
+static int
+recx_epoch_aggregate(struct purge_context *pcx, daos_key_t *akey,
+		     unsigned int *credits_ret, vos_purge_anchor_t *vp_anchor)
+{
+	struct vos_object	*obj = pcx->pc_obj;
+	daos_epoch_range_t	*epr = &pcx->pc_param.ip_epr;
+	struct evt_entry	*run[VOS_AGG_MERGE_NR];
+	struct evt_entry_array	 ent_array;
+	struct evt_entry	*ent;
+	struct evt_entry	*cov;
+	struct evt_rect		 rect;
+	daos_handle_t		 dk_toh;
+	daos_handle_t		 ak_toh;
+	daos_size_t		 size = 0;
+	uint32_t		 cov_inob;
+	uint32_t		 inob;
+	int			 cov_nr;
+	int			 nr = 0;
+	int			 rc;
+
+	rc = obj_tree_init(obj);
+	if (rc != 0)
+		return rc;
+
+	rc = key_tree_prepare(obj, epr->epr_hi, obj->obj_toh, VOS_BTR_DKEY,
+			      &pcx->pc_param.ip_dkey, 0, NULL, &dk_toh);
+	if (rc != 0)
+		return rc == -DER_NONEXIST ? 0 : rc;
+
+	rc = key_tree_prepare(obj, epr->epr_hi, dk_toh, VOS_BTR_AKEY, akey,
+			      SUBTR_EVT, NULL, &ak_toh);
+	if (rc != 0) {
+		key_tree_release(dk_toh, false);
+		return rc == -DER_NONEXIST ? 0 : rc;
+	}
+
+	D_ALLOC_ARRAY(cov, VOS_AGG_MERGE_NR);
+	if (cov == NULL) {
+		key_tree_release(ak_toh, true);
+		key_tree_release(dk_toh, false);
+		return -DER_NOMEM;
+	}
+
+	cov_nr = recx_covered_fetch(ak_toh, epr, true, cov, VOS_AGG_MERGE_NR,
+				    &cov_inob);
+
+	rect.rc_ex.ex_lo = 0;
+	rect.rc_ex.ex_hi = ~(0ULL);
+	rect.rc_epc = epr->epr_hi;
+	rc = evt_find(ak_toh, &rect, &ent_array);
+	key_tree_release(ak_toh, true);
+	key_tree_release(dk_toh, false);
+	if (rc != 0)
+		D_GOTO(free_cov, rc);
+
+	/* too many covered extents, they should be removed first */
+	if (cov_nr < 0 || cov_nr == VOS_AGG_MERGE_NR)
+		D_GOTO(out, rc = min(cov_nr, 0));
+
+	inob = ent_array.ea_inob;
+	if (inob == 0)
+		goto out;
+
+	evt_ent_array_for_each(ent, &ent_array) {
+		bool		 mergeable = recx_is_mergeable(ent, epr, inob);
+		daos_size_t	 len = evt_extent_width(&ent->en_ext) * inob;
+
+		if (mergeable &&
+		    recx_covered_intersect(cov, cov_nr, &ent->en_ext))
+			mergeable = false;
+
+		if (nr > 0 && (!mergeable || nr == VOS_AGG_MERGE_NR ||
+		    run[nr - 1]->en_ext.ex_hi + 1 != ent->en_ext.ex_lo ||
+		    size + len > VOS_AGG_MERGE_MAX)) {
+			if (nr > 1 && size >= VOS_BLK_SZ)
+				break;
+			nr = 0;
+			size = 0;
+		}
+
+		if (mergeable) {
+			run[nr++] = ent;
+			size += len;
+		}
+	}
+
+	if (nr < 2 || size < VOS_BLK_SZ)
+		goto out;
+
+	rc = recx_merge_run(pcx, akey, run, nr, inob);
+	if (rc == -DER_BUSY) {
+		/* retry from the anchor when the fetch is done */
+		*credits_ret = 0;
+		rc = 0;
+		goto out;
+	}
+	if (rc != 0)
+		goto out;
+
+	vp_anchor->pa_nr_removed += nr - 1;
+	vp_anchor->pa_nr_merged += nr;
+	*credits_ret = 0;
+out:
+	evt_ent_array_fini(&ent_array);
+free_cov:
+	D_FREE(cov);
+	return rc;
+}
+
 /**
  * core function of aggregation, similar to discard recursively enter
  * different trees and delete the leaf record or retain based on the
@@ -521,6 +1108,7 @@ epoch_aggregate(struct purge_context *pcx, int *empty_ret,
 
 		vos_iter_entry_t	ent;
 		daos_handle_t		*del_hdl;
+		daos_size_t		rsize = 0;
 		char			*opstr;
 		int			empty = 0;
 		bool			max_reset = false;
@@ -622,6 +1210,27 @@ epoch_aggregate(struct purge_context *pcx, int *empty_ret,
 						     ANCHOR_SET);
 				D_GOTO(out, rc);
 			}
+
+			if (pcx->pc_type == VOS_ITER_AKEY && !empty) {
+				rc = recx_covered_aggregate(pcx, &ent.ie_key,
+							    &credits,
+							    vp_anchor);
+				if (rc == 0 && credits != 0)
+					rc = recx_epoch_aggregate(pcx,
+								  &ent.ie_key,
+								  &credits,
+								  vp_anchor);
+				if (rc != 0)
+					D_GOTO(out, rc);
+
+				/* revisit this akey for the other extents */
+				if (!credits) {
+					purge_ctx_anchor_ctl(pcx, vp_anchor,
+							     &anchor,
+							     ANCHOR_SET);
+					D_GOTO(out, rc);
+				}
+			}
 		}
 
 		if (!empty) {
@@ -639,9 +1248,13 @@ epoch_aggregate(struct purge_context *pcx, int *empty_ret,
 		if (max_reset) {
 			del_hdl = &ih_max;
 			opc = ITR_MAX_PROBE_ANCHOR;
+			if (val_tree)
+				rsize = ent_max.ie_rsize;
 		} else {
 			del_hdl = &ih;
 			opc = ITR_PROBE_ANCHOR;
+			if (val_tree)
+				rsize = ent.ie_rsize;
 		}
 
 		TX_BEGIN(pcx->pc_pop) {
@@ -661,6 +1274,9 @@ epoch_aggregate(struct purge_context *pcx, int *empty_ret,
 
 		/* Number of keys aggregated in this tree ctx */
 		aggregated++;
+		if (val_tree)
+			vp_anchor->pa_nr_removed++;
+		vp_anchor->pa_size_removed += rsize;
 	}
 
 	if (rc == 0 && empty_ret != NULL) {
@@ -750,6 +1366,17 @@ epoch_discard(struct purge_context *pcx, int *empty_ret)
 			/* the last level tree */
 			empty = !uuid_compare(ent.ie_cookie, pcx->pc_cookie);
 		} else {
+			/* a fetch may access its extents directly, skip it */
+			if (pcx->pc_type == VOS_ITER_OBJ &&
+			    vos_obj_leased(vos_hdl2cont(pcx->pc_param.ip_hdl),
+					   ent.ie_oid)) {
+				D_DEBUG(DB_EPC, "Object "DF_UOID" is leased by "
+					"fetch\n", DP_UOID(ent.ie_oid));
+				pcx->pc_leased++;
+				opc = ITR_NEXT;
+				continue;
+			}
+
 			/* prepare the context for the subtree */
 			rc = purge_ctx_init(pcx, &ent);
 			if (rc != 0) {
@@ -841,6 +1468,10 @@ vos_epoch_discard(daos_handle_t coh, daos_epoch_range_t *epr, uuid_t cookie)
 
 	rc = epoch_discard(&pcx, NULL);
 	purge_ctx_fini(&pcx, rc);
+	if (rc == 0 && pcx.pc_leased != 0) {
+		D_DEBUG(DB_EPC, "Skipped %u leased object(s)\n", pcx.pc_leased);
+		rc = -DER_BUSY;
+	}
 	return rc;
 }
 
@@ -894,6 +1525,16 @@ vos_epoch_aggregate(daos_handle_t coh, daos_unit_oid_t oid,
 		return 0;
 	}
 
+	/**
+	 * The data of an object being fetched may be read in place, so the
+	 * caller should come back for it when the fetch is done.
+	 */
+	if (vos_obj_leased(vos_hdl2cont(coh), oid)) {
+		D_DEBUG(DB_EPC, "Object "DF_UOID" is leased by fetch\n",
+			DP_UOID(oid));
+		return 0;
+	}
+
 	memset(&pcx, 0, sizeof(pcx));
 	pcx.pc_type		= VOS_ITER_OBJ;
 	pcx.pc_param.ip_hdl	= coh;
@@ -0,0 +1,705 @@
+/**
+ * (C) Copyright 2018 Intel Corporation.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * GOVERNMENT LICENSE RIGHTS-OPEN SOURCE SOFTWARE
+ * The Government's rights to use, modify, reproduce, release, perform, display,
+ * or disclose this software are subject to the terms of the Apache License as
+ * provided in Contract No. B609815.
+ * Any reproduction of computer software, computer software documentation, or
+ * portions thereof marked with this legend must also reproduce the markings.
+ */
+/**
+ * This file is part of VOS
+ *
+ * vos/vos_tier.c
+ * Media selection policy and migration of extents between SCM and NVMe
+ */
+#define D_LOGFAC	DD_FAC(vos)
+
+#include <time.h>
+#include <daos/common.h>
+#include <daos/btree.h>
+#include <daos_srv/vos.h>
+#include <vos_internal.h>
+
+/** Default SCM high watermark in percentage */
+#define VOS_SCM_HWM_DEF		90
+/** Default max size of the extent being migrated to SCM */
+#define VOS_PROMOTE_MAX_DEF	(64UL << 10)
+/** Interval (in seconds) to halve the fetch heat */
+#define VOS_HEAT_DECAY_INTV	60
+/** Max number of extents picked from an akey in one round */
+#define VOS_TIER_EXT_NR		32
+
+/** Parse one "MEDIA:oclass=ID" or "MEDIA:akey=PREFIX" rule */
+static int
+tier_rule_parse(struct vos_media_rule *rule, char *str)
+{
+	unsigned long	 oclass;
+	char		*end;
+
+	memset(rule, 0, sizeof(*rule));
+	if (strncmp(str, "scm:", 4) == 0) {
+		rule->mr_media = BIO_ADDR_SCM;
+		str += 4;
+	} else if (strncmp(str, "nvme:", 5) == 0) {
+		rule->mr_media = BIO_ADDR_NVME;
+		str += 5;
+	} else {
+		return -DER_INVAL;
+	}
+
+	if (strncmp(str, "oclass=", 7) == 0) {
+		oclass = strtoul(str + 7, &end, 0);
+		if (end == str + 7 || *end != '\0' || oclass == 0 ||
+		    oclass > (daos_oclass_id_t)-1)
+			return -DER_INVAL;
+		rule->mr_oclass = oclass;
+		return 0;
+	}
+
+	if (strncmp(str, "akey=", 5) == 0) {
+		str += 5;
+		rule->mr_akey_len = strlen(str);
+		if (rule->mr_akey_len == 0 ||
+		    rule->mr_akey_len > VOS_MEDIA_AKEY_MAX)
+			return -DER_INVAL;
+		memcpy(rule->mr_akey, str, rule->mr_akey_len);
+		return 0;
+	}
+
+	return -DER_INVAL;
+}
+
+/**
+ * Parse the placement rules of \a str into \a policy. \a str is a comma
+ * separated list of "MEDIA:oclass=ID" or "MEDIA:akey=PREFIX", MEDIA is either
+ * "scm" or "nvme", e.g. "scm:akey=meta.,nvme:oclass=40".
+ *
+ * \return	0 on success, -DER_INVAL if \a str is malformed or has too
+ *		many rules, the policy has no rule then.
+ */
+int
+vos_media_rules_parse(struct vos_media_policy *policy, const char *str)
+{
+	char	*buf;
+	char	*tok;
+	char	*sav;
+	int	 rc = 0;
+
+	policy->mp_rule_nr = 0;
+	D_STRNDUP(buf, str, strlen(str));
+	if (buf == NULL)
+		return -DER_NOMEM;
+
+	for (tok = strtok_r(buf, ",", &sav); tok != NULL;
+	     tok = strtok_r(NULL, ",", &sav)) {
+		if (policy->mp_rule_nr == VOS_MEDIA_RULE_MAX)
+			D_GOTO(out, rc = -DER_INVAL);
+
+		rc = tier_rule_parse(&policy->mp_rules[policy->mp_rule_nr],
+				     tok);
+		if (rc != 0)
+			D_GOTO(out, rc);
+		policy->mp_rule_nr++;
+	}
+out:
+	if (rc != 0) {
+		D_ERROR("invalid media rules %s, rule %u: %d\n", str,
+			policy->mp_rule_nr, rc);
+		policy->mp_rule_nr = 0;
+	}
+	D_FREE(buf);
+	return rc;
+}
+
+/** Media of the first rule matching \a hint, or -1 if there is none */
+static int
+tier_rule_match(struct vos_media_policy *policy,
+		const struct vos_media_hint *hint)
+{
+	struct vos_media_rule	*rule;
+	daos_oclass_id_t	 oclass;
+	int			 i;
+
+	oclass = daos_obj_id2class(hint->mh_oid.id_pub);
+	for (i = 0; i < policy->mp_rule_nr; i++) {
+		rule = &policy->mp_rules[i];
+		if (rule->mr_akey_len == 0) {
+			if (rule->mr_oclass == oclass)
+				return rule->mr_media;
+			continue;
+		}
+
+		if (hint->mh_akey != NULL &&
+		    hint->mh_akey->iov_len >= rule->mr_akey_len &&
+		    memcmp(hint->mh_akey->iov_buf, rule->mr_akey,
+			   rule->mr_akey_len) == 0)
+			return rule->mr_media;
+	}
+	return -1;
+}
+
+void
+vos_media_policy_init(struct vos_media_policy *policy)
+{
+	char	*env;
+	int	 hwm;
+
+	memset(policy, 0, sizeof(*policy));
+	policy->mp_size_thresh = VOS_BLK_SZ;
+	policy->mp_scm_hwm = VOS_SCM_HWM_DEF;
+	policy->mp_promote_max = VOS_PROMOTE_MAX_DEF;
+
+	env = getenv("VOS_MEDIA_THRESH");
+	if (env != NULL)
+		policy->mp_size_thresh = strtoull(env, NULL, 0);
+
+	env = getenv("VOS_SCM_HWM");
+	if (env != NULL) {
+		hwm = atoi(env);
+		if (hwm < 0 || hwm > 100)
+			D_WARN("invalid VOS_SCM_HWM %s, use %d\n",
+			       env, VOS_SCM_HWM_DEF);
+		else
+			policy->mp_scm_hwm = hwm;
+	}
+
+	env = getenv("VOS_PROMOTE_MAX");
+	if (env != NULL)
+		policy->mp_promote_max = strtoull(env, NULL, 0);
+
+	env = getenv("VOS_MEDIA_RULES");
+	if (env != NULL)
+		vos_media_rules_parse(policy, env);
+}
+
+/** Halve the fetch heat of the container for each elapsed interval */
+static void
+tier_heat_decay(struct vos_container *cont)
+{
+	struct timespec	now;
+	uint64_t	intvs;
+	int		i;
+
+	clock_gettime(CLOCK_MONOTONIC_COARSE, &now);
+	if (cont->vc_heat_time == 0) {
+		cont->vc_heat_time = now.tv_sec;
+		return;
+	}
+
+	intvs = (now.tv_sec - cont->vc_heat_time) / VOS_HEAT_DECAY_INTV;
+	if (intvs == 0)
+		return;
+
+	for (i = 0; i < VOS_HEAT_BUCKETS; i++)
+		cont->vc_heat[i] = intvs >= 16 ? 0 : cont->vc_heat[i] >> intvs;
+	cont->vc_heat_time += intvs * VOS_HEAT_DECAY_INTV;
+}
+
+/**
+ * Select media for a new record. The placement rules of the policy are
+ * checked first, then the record is stored on NVMe if it's large enough.
+ *
+ * Small array extent is stored on SCM unless SCM is above the high watermark
+ * and the object isn't hot, it's then packed on NVMe by vea_reserve_frag(),
+ * that needs the pool to be formatted with packed block support.
+ *
+ * Small single value is always stored along with its index record on SCM.
+ */
+uint16_t
+vos_media_select(struct vos_container *cont, const struct vos_media_hint *hint)
+{
+	struct vos_pool		*pool = cont->vc_pool;
+	struct vos_media_policy	*policy = &pool->vp_policy;
+	int			 media;
+
+	if (pool->vp_vea_info == NULL)
+		return BIO_ADDR_SCM;
+
+	if (hint->mh_type == DAOS_IOD_SINGLE && hint->mh_size < VOS_BLK_SZ)
+		return BIO_ADDR_SCM;
+
+	media = tier_rule_match(policy, hint);
+	if (media != -1)
+		return media;
+
+	if (hint->mh_size >= policy->mp_size_thresh)
+		return BIO_ADDR_NVME;
+
+	if (hint->mh_type != DAOS_IOD_ARRAY ||
+	    !vea_frag_supported(pool->vp_vea_info) ||
+	    vos_pool_scm_usage(pool) < policy->mp_scm_hwm)
+		return BIO_ADDR_SCM;
+
+	/* Keep the small extents of hot object on SCM, it's read back soon */
+	tier_heat_decay(cont);
+	if (*vos_obj_heat_bucket(cont, hint->mh_oid) >= VOS_TIER_HOT_FETCHES)
+		return BIO_ADDR_SCM;
+
+	return BIO_ADDR_NVME;
+}
+
+/** context of the media migration of one object */
+struct tier_context {
+	struct vos_object	*tc_obj;
+	/** destination media */
+	uint16_t		 tc_media;
+	/** dkey being migrated */
+	daos_key_t		*tc_dkey;
+	/** remaining credits */
+	unsigned int		 tc_credits;
+	vos_tier_stats_t	*tc_stats;
+};
+
+/** Should the extent be moved to the destination media? */
+static bool
+tier_ext_is_movable(struct tier_context *tc, daos_key_t *akey,
+		    struct evt_entry *ent, uint32_t inob)
+{
+	struct vos_object	*obj = tc->tc_obj;
+	struct vos_media_policy	*policy = &obj->obj_cont->vc_pool->vp_policy;
+	struct vos_media_hint	 hint;
+	daos_size_t		 size;
+
+	if (bio_addr_is_hole(&ent->en_addr) ||
+	    ent->en_addr.ba_type == tc->tc_media)
+		return false;
+
+	/* only move the fully visible extents, like the coalescing does */
+	if (ent->en_ext.ex_lo != ent->en_sel_ext.ex_lo ||
+	    ent->en_ext.ex_hi != ent->en_sel_ext.ex_hi)
+		return false;
+
+	size = evt_extent_width(&ent->en_ext) * inob;
+	if (tc->tc_media == BIO_ADDR_SCM && size > policy->mp_promote_max)
+		return false;
+
+	/* small extent can't be demoted without packed block support */
+	if (tc->tc_media == BIO_ADDR_NVME && size < VOS_BLK_SZ &&
+	    !vea_frag_supported(obj->obj_cont->vc_pool->vp_vea_info))
+		return false;
+
+	if (policy->mp_rule_nr == 0)
+		return true;
+
+	/* don't move the extent out of the media pinned by a rule */
+	hint.mh_oid = obj->obj_id;
+	hint.mh_akey = akey;
+	hint.mh_type = DAOS_IOD_ARRAY;
+	hint.mh_size = size;
+	return tier_rule_match(policy, &hint) != ent->en_addr.ba_type;
+}
+
+/** Copy \a size bytes of data from \a src to \a dst */
+static int
+tier_copy(struct vos_object *obj, bio_addr_t src_addr, bio_addr_t dst_addr,
+	  daos_size_t size)
+{
+	struct bio_io_context	*bioc = obj->obj_cont->vc_pool->vp_io_ctxt;
+	struct bio_desc		*src;
+	struct bio_desc		*dst;
+	struct bio_sglist	*bsgl;
+	daos_sg_list_t		 sgl;
+	int			 rc;
+	int			 rc1;
+
+	src = bio_iod_alloc(bioc, 1, false);
+	if (src == NULL)
+		return -DER_NOMEM;
+
+	dst = bio_iod_alloc(bioc, 1, true);
+	if (dst == NULL)
+		D_GOTO(free_src, rc = -DER_NOMEM);
+
+	bsgl = bio_iod_sgl(src, 0);
+	rc = bio_sgl_init(bsgl, 1);
+	if (rc != 0)
+		D_GOTO(free_dst, rc);
+
+	bsgl->bs_iovs[0].bi_addr = src_addr;
+	bsgl->bs_iovs[0].bi_data_len = size;
+	bsgl->bs_nr_out = 1;
+
+	bsgl = bio_iod_sgl(dst, 0);
+	rc = bio_sgl_init(bsgl, 1);
+	if (rc != 0)
+		D_GOTO(free_dst, rc);
+
+	bsgl->bs_iovs[0].bi_addr = dst_addr;
+	bsgl->bs_iovs[0].bi_data_len = size;
+	bsgl->bs_nr_out = 1;
+
+	rc = bio_iod_prep(src);
+	if (rc != 0) {
+		D_ERROR("Failed to read extent for migration: %d\n", rc);
+		D_GOTO(free_dst, rc);
+	}
+
+	rc = bio_sgl_convert(bio_iod_sgl(src, 0), &sgl);
+	if (rc != 0)
+		D_GOTO(post_src, rc);
+
+	rc = bio_iod_prep(dst);
+	if (rc != 0) {
+		D_ERROR("Failed to map extent for migration: %d\n", rc);
+		D_GOTO(free_sgl, rc);
+	}
+
+	rc = bio_iod_copy(dst, &sgl, 1);
+	if (rc != 0)
+		D_ERROR("Failed to copy extent for migration: %d\n", rc);
+
+	rc1 = bio_iod_post(dst);
+	if (rc == 0)
+		rc = rc1;
+free_sgl:
+	daos_sgl_fini(&sgl, false);
+post_src:
+	bio_iod_post(src);
+free_dst:
+	bio_iod_free(dst);
+free_src:
+	bio_iod_free(src);
+	return rc;
+}
+
+/**
+ * Move an extent to the destination media: reserve space on the destination
+ * media, copy the data, then replace the extent in evtree with the same one
+ * pointing to the new location, and free the old location.
+ */
+static int
+tier_ext_move(struct tier_context *tc, daos_key_t *akey,
+	      struct evt_entry *ent, uint32_t inob)
+{
+	struct vos_object	*obj = tc->tc_obj;
+	struct vos_container	*cont = obj->obj_cont;
+	struct vea_space_info	*vsi = cont->vc_pool->vp_vea_info;
+	struct umem_instance	*umm = vos_obj2umm(obj);
+	struct vea_resrvd_ext	*ext;
+	struct pobj_action	 act;
+	struct evt_entry_in	 ent_in;
+	struct evt_entry	 old;
+	daos_handle_t		 dk_toh;
+	daos_handle_t		 ak_toh;
+	daos_size_t		 size;
+	d_list_t		 blk_exts;
+	umem_id_t		 mmid = UMMID_NULL;
+	int			 rc;
+
+	memset(&ent_in, 0, sizeof(ent_in));
+	ent_in.ei_rect.rc_ex = ent->en_ext;
+	ent_in.ei_rect.rc_epc = ent->en_epoch;
+	uuid_copy(ent_in.ei_cookie, ent->en_cookie);
+	ent_in.ei_csum = ent->en_csum;
+	ent_in.ei_ver = ent->en_ver;
+	ent_in.ei_inob = inob;
+	size = evt_extent_width(&ent->en_ext) * inob;
+
+	/* The checksums live in the descriptor which is freed on replacing
+	 * the extent, keep a copy of them for the new one.
+	 */
+	if (ent->en_chunk_csum.cs_len != 0) {
+		ent_in.ei_chunk_csum = ent->en_chunk_csum;
+		ent_in.ei_chunk_size = ent->en_chunk_size;
+		D_ALLOC(ent_in.ei_chunk_csum.cs_csum,
+			ent->en_chunk_csum.cs_len);
+		if (ent_in.ei_chunk_csum.cs_csum == NULL)
+			return -DER_NOMEM;
+		memcpy(ent_in.ei_chunk_csum.cs_csum, ent->en_chunk_csum.cs_csum,
+		       ent->en_chunk_csum.cs_len);
+	}
+
+	D_INIT_LIST_HEAD(&blk_exts);
+	if (tc->tc_media == BIO_ADDR_SCM) {
+		mmid = umem_reserve(umm, &act, size);
+		if (UMMID_IS_NULL(mmid))
+			D_GOTO(free_csum, rc = -DER_NOSPACE);
+		bio_addr_set(&ent_in.ei_addr, BIO_ADDR_SCM, mmid.off);
+	} else if (size < VOS_BLK_SZ) {
+		rc = vea_reserve_frag(vsi, size, cont->vc_hint_ctxt,
+				      &blk_exts);
+		if (rc != 0)
+			goto free_csum;
+		ext = d_list_entry(blk_exts.prev, struct vea_resrvd_ext,
+				   vre_link);
+		bio_addr_set(&ent_in.ei_addr, BIO_ADDR_NVME,
+			     (ext->vre_blk_off << VOS_BLK_SHIFT) +
+			     ext->vre_frag_off);
+		bio_addr_set_frag(&ent_in.ei_addr);
+	} else {
+		rc = vea_reserve(vsi, vos_byte2blkcnt(size),
+				 cont->vc_hint_ctxt, &blk_exts);
+		if (rc != 0)
+			goto free_csum;
+		ext = d_list_entry(blk_exts.prev, struct vea_resrvd_ext,
+				   vre_link);
+		bio_addr_set(&ent_in.ei_addr, BIO_ADDR_NVME,
+			     ext->vre_blk_off << VOS_BLK_SHIFT);
+	}
+
+	/* NB: this yields for NVMe I/O */
+	rc = tier_copy(obj, ent->en_addr, ent_in.ei_addr, size);
+	if (rc != 0)
+		goto cancel;
+
+	/* A fetch may have got the old extent while yielding, keep it */
+	if (vos_obj_leased(cont, obj->obj_id)) {
+		rc = -DER_BUSY;
+		goto cancel;
+	}
+
+	/* The trees might have been changed while yielding, open them again */
+	rc = obj_tree_init(obj);
+	if (rc != 0)
+		goto cancel;
+
+	rc = key_tree_prepare(obj, DAOS_EPOCH_MAX, obj->obj_toh, VOS_BTR_DKEY,
+			      tc->tc_dkey, 0, NULL, &dk_toh);
+	if (rc != 0)
+		goto cancel;
+
+	rc = key_tree_prepare(obj, DAOS_EPOCH_MAX, dk_toh, VOS_BTR_AKEY, akey,
+			      SUBTR_EVT, NULL, &ak_toh);
+	if (rc != 0)
+		goto release_dkey;
+
+	rc = umem_tx_begin(umm, vos_txd_get());
+	if (rc != 0)
+		goto release_akey;
+
+	rc = evt_delete(ak_toh, &ent_in.ei_rect, &old);
+	if (rc != 0)
+		goto abort;
+
+	/* The extent was replaced (e.g. by coalescing) while yielding */
+	if (old.en_addr.ba_type != ent->en_addr.ba_type ||
+	    old.en_addr.ba_off != ent->en_addr.ba_off) {
+		rc = -DER_BUSY;
+		goto abort;
+	}
+
+	rc = recx_data_free(obj, &old, inob);
+	if (rc != 0)
+		goto abort;
+
+	rc = evt_insert(ak_toh, &ent_in);
+	if (rc != 0) {
+		D_ERROR("Failed to insert migrated "DF_RECT": %d\n",
+			DP_RECT(&ent_in.ei_rect), rc);
+		goto abort;
+	}
+
+	if (tc->tc_media == BIO_ADDR_SCM)
+		rc = umem_tx_publish(umm, &act, 1);
+	else
+		rc = vea_tx_publish(vsi, cont->vc_hint_ctxt, &blk_exts);
+abort:
+	rc = rc ? umem_tx_abort(umm, rc) : umem_tx_commit(umm);
+release_akey:
+	key_tree_release(ak_toh, true);
+release_dkey:
+	key_tree_release(dk_toh, false);
+cancel:
+	if (rc != 0) {
+		if (tc->tc_media == BIO_ADDR_SCM)
+			umem_cancel(umm, &act, 1);
+		else
+			vea_cancel(vsi, cont->vc_hint_ctxt, &blk_exts);
+		goto free_csum;
+	}
+
+	D_DEBUG(DB_EPC, "Moved "DF_RECT" to %s\n", DP_RECT(&ent_in.ei_rect),
+		tc->tc_media == BIO_ADDR_SCM ? "SCM" : "NVMe");
+	if (tc->tc_media == BIO_ADDR_SCM)
+		tc->tc_stats->ts_promoted++;
+	else
+		tc->tc_stats->ts_demoted++;
+	tc->tc_stats->ts_bytes += size;
+	tc->tc_credits--;
+free_csum:
+	D_FREE(ent_in.ei_chunk_csum.cs_csum);
+	return rc;
+}
+
+/** Migrate the visible extents of an akey */
+static int
+tier_akey(struct tier_context *tc, daos_key_t *akey)
+{
+	struct vos_object	*obj = tc->tc_obj;
+	struct evt_entry	 exts[VOS_TIER_EXT_NR];
+	struct evt_entry_array	 ent_array;
+	struct evt_entry	*ent;
+	struct vos_krec_df	*krec;
+	struct evt_rect		 rect;
+	daos_handle_t		 dk_toh;
+	daos_handle_t		 ak_toh;
+	uint32_t		 inob;
+	int			 nr = 0;
+	int			 i;
+	int			 rc;
+
+	rc = obj_tree_init(obj);
+	if (rc != 0)
+		return rc;
+
+	rc = key_tree_prepare(obj, DAOS_EPOCH_MAX, obj->obj_toh, VOS_BTR_DKEY,
+			      tc->tc_dkey, 0, NULL, &dk_toh);
+	if (rc != 0)
+		return rc == -DER_NONEXIST ? 0 : rc;
+
+	rc = key_tree_prepare(obj, DAOS_EPOCH_MAX, dk_toh, VOS_BTR_AKEY, akey,
+			      SUBTR_EVT, &krec, &ak_toh);
+	if (rc != 0) {
+		key_tree_release(dk_toh, false);
+		return rc == -DER_NONEXIST ? 0 : rc;
+	}
+
+	/* single value only */
+	if (!(krec->kr_bmap & KREC_BF_EVT)) {
+		key_tree_release(ak_toh, true);
+		key_tree_release(dk_toh, false);
+		return 0;
+	}
+
+	rect.rc_ex.ex_lo = 0;
+	rect.rc_ex.ex_hi = ~(0ULL);
+	rect.rc_epc = DAOS_EPOCH_MAX;
+	rc = evt_find(ak_toh, &rect, &ent_array);
+	key_tree_release(ak_toh, true);
+	key_tree_release(dk_toh, false);
+	if (rc != 0)
+		return rc;
+
+	/* Pick the extents before moving them, the trees may change */
+	inob = ent_array.ea_inob;
+	evt_ent_array_for_each(ent, &ent_array) {
+		if (nr == VOS_TIER_EXT_NR || nr == tc->tc_credits)
+			break;
+		if (inob != 0 && tier_ext_is_movable(tc, akey, ent, inob))
+			exts[nr++] = *ent;
+	}
+	evt_ent_array_fini(&ent_array);
+
+	for (i = 0; i < nr; i++) {
+		rc = tier_ext_move(tc, akey, &exts[i], inob);
+		/* Skip the busy extent, or stop if the media is full */
+		if (rc == -DER_BUSY || rc == -DER_NONEXIST)
+			continue;
+		if (rc == -DER_NOSPACE)
+			return 0;
+		if (rc != 0)
+			return rc;
+	}
+	return 0;
+}
+
+/** Iterate the keys of type \a type (dkey or akey) under the current dkey */
+static int
+tier_keys(struct tier_context *tc, daos_handle_t coh, vos_iter_type_t type)
+{
+	vos_iter_param_t	param;
+	vos_iter_entry_t	ent;
+	daos_handle_t		ih;
+	int			rc;
+
+	memset(&param, 0, sizeof(param));
+	param.ip_hdl = coh;
+	param.ip_oid = tc->tc_obj->obj_id;
+	param.ip_epr.epr_lo = 0;
+	param.ip_epr.epr_hi = DAOS_EPOCH_MAX;
+	if (type == VOS_ITER_AKEY)
+		param.ip_dkey = *tc->tc_dkey;
+
+	rc = vos_iter_prepare(type, &param, &ih);
+	if (rc != 0)
+		return rc == -DER_NONEXIST ? 0 : rc;
+
+	rc = vos_iter_probe(ih, NULL);
+	while (rc == 0 && tc->tc_credits > 0) {
+		rc = vos_iter_fetch(ih, &ent, NULL);
+		if (rc != 0)
+			break;
+
+		if (type == VOS_ITER_DKEY) {
+			tc->tc_dkey = &ent.ie_key;
+			rc = tier_keys(tc, coh, VOS_ITER_AKEY);
+			tc->tc_dkey = NULL;
+		} else {
+			rc = tier_akey(tc, &ent.ie_key);
+		}
+		if (rc != 0)
+			break;
+
+		rc = vos_iter_next(ih);
+	}
+	vos_iter_finish(ih);
+
+	return rc == -DER_NONEXIST ? 0 : rc;
+}
+
+int
+vos_obj_tier(daos_handle_t coh, daos_unit_oid_t oid, unsigned int *credits,
+	     vos_tier_stats_t *stats)
+{
+	struct vos_container	*cont;
+	struct vos_pool		*pool;
+	struct vos_media_policy	*policy;
+	struct tier_context	 tc;
+	unsigned int		 usage;
+	uint16_t		 heat;
+	int			 rc;
+
+	cont = vos_hdl2cont(coh);
+	if (cont == NULL)
+		return -DER_NO_HDL;
+
+	pool = cont->vc_pool;
+	policy = &pool->vp_policy;
+	if (pool->vp_vea_info == NULL || *credits == 0)
+		return 0;
+
+	tier_heat_decay(cont);
+	heat = *vos_obj_heat_bucket(cont, oid);
+	usage = vos_pool_scm_usage(pool);
+
+	memset(&tc, 0, sizeof(tc));
+	if (heat >= VOS_TIER_HOT_FETCHES && usage < policy->mp_scm_hwm &&
+	    policy->mp_promote_max != 0 &&
+	    pool->vp_umm.umm_ops->mo_reserve != NULL)
+		tc.tc_media = BIO_ADDR_SCM;
+	else if (heat == 0 && usage >= policy->mp_scm_hwm)
+		tc.tc_media = BIO_ADDR_NVME;
+	else
+		return 0;
+
+	/* The extents being fetched may be accessed in place */
+	if (vos_obj_leased(cont, oid))
+		return 0;
+
+	rc = vos_obj_hold(vos_obj_cache_current(), coh, oid, DAOS_EPOCH_MAX,
+			  true, &tc.tc_obj);
+	if (rc != 0)
+		return rc == -DER_NONEXIST ? 0 : rc;
+
+	tc.tc_credits = *credits;
+	tc.tc_stats = stats;
+	rc = tier_keys(&tc, coh, VOS_ITER_DKEY);
+
+	vos_obj_release(vos_obj_cache_current(), tc.tc_obj);
+	*credits = tc.tc_credits;
+	return rc;
+}
@@ -211,6 +211,53 @@ ktr_hkey_cmp(struct btr_instance *tins, struct btr_record *rec, void *hkey)
 	return BTR_CMP_EQ;
 }
 
+/** the key array of hashed key tree stores the first hash */
+static uint64_t
+ktr_hkey_prefix(struct btr_instance *tins, void *hkey)
+{
+	return ((struct ktr_hkey *)hkey)->kh_hash[0];
+}
+
+/**
+ * The key array of direct key tree stores the integer key, or the leading 8
+ * bytes of the lexical key loaded as big-endian and zero padded, which is
+ * ordered as ktr_key_cmp_lexical.
+ */
+static uint64_t
+ktr_key_prefix(struct btr_instance *tins, struct btr_record *rec,
+	       daos_iov_t *key_iov)
+{
+	struct vos_krec_df	*krec;
+	unsigned char		*buf;
+	uint64_t		 prefix = 0;
+	int			 len;
+	int			 i;
+
+	if (rec != NULL) {
+		krec = vos_rec2krec(tins, rec);
+		buf = (unsigned char *)vos_krec2key(krec);
+		len = krec->kr_size;
+	} else {
+		key_iov = iov2key_bundle(key_iov)->kb_key;
+		buf = key_iov->iov_buf;
+		len = key_iov->iov_len;
+	}
+
+	if (tins->ti_root->tr_feats & VOS_KEY_CMP_UINT64) {
+		/* invalid key size is reported by ktr_key_cmp_uint64 */
+		if (len == sizeof(uint64_t))
+			memcpy(&prefix, buf, sizeof(prefix));
+		return prefix;
+	}
+
+	for (i = 0; i < sizeof(prefix); i++) {
+		prefix <<= 8;
+		if (i < len)
+			prefix |= buf[i];
+	}
+	return prefix;
+}
+
 static int
 ktr_key_cmp_lexical(struct vos_krec_df *krec, daos_iov_t *kiov)
 {
@@ -392,6 +439,14 @@ ktr_rec_alloc(struct btr_instance *tins, daos_iov_t *key_iov,
 		else if (obj_feats & DAOS_OF_AKEY_LEXICAL)
 			tree_feats |= VOS_KEY_CMP_LEXICAL_SET;
 	}
+	/* akey tree has the key array if its dkey tree has it, the pool
+	 * might not support it.
+	 */
+	if (ta->ta_class == VOS_BTR_AKEY &&
+	    (tins->ti_root->tr_feats & BTR_FEAT_KEY_ARRAY))
+		tree_feats |= BTR_FEAT_KEY_ARRAY;
+	if (ta->ta_class == VOS_BTR_AKEY)
+		tree_feats |= tins->ti_root->tr_feats & VOS_KEY_EXT_CSUM;
 
 	umem_attr_get(&tins->ti_umm, &uma);
 	rc = dbtree_create_inplace(ta->ta_class, tree_feats, ta->ta_order,
@@ -403,10 +458,15 @@ ktr_rec_alloc(struct btr_instance *tins, daos_iov_t *key_iov,
 
 	/* Step-2: create evtree for akey only */
 	if (rbund->rb_tclass == VOS_BTR_AKEY) {
+		uint64_t	evt_feats = EVT_FEAT_DEFAULT;
+
 		D_DEBUG(DB_TRACE, "Create evtree\n");
 
+		if (tins->ti_root->tr_feats & VOS_KEY_EXT_CSUM)
+			evt_feats |= EVT_FEAT_CSUM;
+
 		krec->kr_bmap |= KREC_BF_EVT;
-		rc = evt_create_inplace(EVT_FEAT_DEFAULT, VOS_EVT_ORDER, &uma,
+		rc = evt_create_inplace(evt_feats, VOS_EVT_ORDER, &uma,
 					&krec->kr_evt[0], &evt_oh);
 		if (rc != 0) {
 			D_ERROR("Failed to create evtree: %d\n", rc);
@@ -503,6 +563,8 @@ static btr_ops_t key_btr_ops = {
 	.to_hkey_size		= ktr_hkey_size,
 	.to_hkey_gen		= ktr_hkey_gen,
 	.to_hkey_cmp		= ktr_hkey_cmp,
+	.to_hkey_prefix		= ktr_hkey_prefix,
+	.to_key_prefix		= ktr_key_prefix,
 	.to_key_cmp		= ktr_key_cmp,
 	.to_key_encode		= ktr_key_encode,
 	.to_key_decode		= ktr_key_decode,
@@ -767,14 +829,16 @@ static struct vos_btr_attr vos_btr_attrs[] = {
 	{
 		.ta_class	= VOS_BTR_DKEY,
 		.ta_order	= VOS_KTR_ORDER,
-		.ta_feats	= VOS_OFEAT_BITS | BTR_FEAT_DIRECT_KEY,
+		.ta_feats	= VOS_OFEAT_BITS | BTR_FEAT_DIRECT_KEY |
+				  BTR_FEAT_KEY_ARRAY,
 		.ta_name	= "vos_dkey",
 		.ta_ops		= &key_btr_ops,
 	},
 	{
 		.ta_class	= VOS_BTR_AKEY,
 		.ta_order	= VOS_KTR_ORDER,
-		.ta_feats	= VOS_OFEAT_BITS | BTR_FEAT_DIRECT_KEY,
+		.ta_feats	= VOS_OFEAT_BITS | BTR_FEAT_DIRECT_KEY |
+				  BTR_FEAT_KEY_ARRAY,
 		.ta_name	= "vos_akey",
 		.ta_ops		= &key_btr_ops,
 	},
@@ -1007,6 +1071,10 @@ obj_tree_init(struct vos_object *obj)
 			tree_feats |= VOS_KEY_CMP_UINT64_SET;
 		else if (obj_feats & DAOS_OF_DKEY_LEXICAL)
 			tree_feats |= VOS_KEY_CMP_LEXICAL_SET;
+		if (obj->obj_cont->vc_pool->vp_key_array)
+			tree_feats |= BTR_FEAT_KEY_ARRAY;
+		if (obj->obj_cont->vc_pool->vp_ext_csum)
+			tree_feats |= VOS_KEY_EXT_CSUM;
 
 		rc = dbtree_create_inplace(ta->ta_class, tree_feats,
 					   ta->ta_order, vos_obj2uma(obj),
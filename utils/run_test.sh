@@ -59,8 +59,10 @@ if [ -d "/mnt/daos" ]; then
     source ./.build_vars.sh
     run_test "${SL_PREFIX}/bin/vos_tests" -A 500
     run_test "${SL_PREFIX}/bin/vos_tests" -n -A 500
+    VOS_CHECKSUM=crc64 run_test "${SL_PREFIX}/bin/vos_tests" -i 0
     run_test src/common/tests/btree.sh ukey -s 20000
     run_test src/common/tests/btree.sh direct -s 20000
+    run_test src/common/tests/btree.sh direct keyarray -s 20000
     run_test src/common/tests/btree.sh -s 20000
     run_test src/common/tests/btree.sh perf -s 20000
     run_test src/common/tests/btree.sh perf direct -s 20000